@@ -1,4 +1,6 @@
 #include <hip_test_common.hh>
+#include <abm_common.hh>
+#include <algorithm>
 #include <iostream>
 
 template <typename T> __global__ void add(T* a, T* b, T* c, size_t size) {
@@ -39,3 +41,140 @@ TEMPLATE_TEST_CASE("ABM_AddKernel_MultiTypeMultiSize", "", int, long, float, lon
   HIP_CHECK(hipFree(d_c));
   REQUIRE(a == c);
 }
+
+/*
+Grid-stride elementwise add, the template for elementwise kernels: correct for any size and
+any launch configuration, so the launch can be sized for occupancy instead of for the data.
+*/
+template <typename T>
+__global__ void addGridStride(const T* a, const T* b, T* c, size_t size) {
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < size;
+       i += stride) {
+    c[i] = a[i] + b[i];
+  }
+}
+
+// 16 byte vector type used to load and store T, vector types have no operators on NVIDIA
+template <typename T> struct Vec16;
+template <> struct Vec16<int> { using type = int4; };
+template <> struct Vec16<float> { using type = float4; };
+template <> struct Vec16<long long> { using type = longlong2; };
+template <> struct Vec16<double> { using type = double2; };
+
+__device__ inline int4 vecAdd(const int4& a, const int4& b) {
+  return make_int4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+}
+__device__ inline float4 vecAdd(const float4& a, const float4& b) {
+  return make_float4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+}
+__device__ inline longlong2 vecAdd(const longlong2& a, const longlong2& b) {
+  return make_longlong2(a.x + b.x, a.y + b.y);
+}
+__device__ inline double2 vecAdd(const double2& a, const double2& b) {
+  return make_double2(a.x + b.x, a.y + b.y);
+}
+
+// Grid-stride add with 16 byte loads and stores, the size % width tail is added per element.
+// Pointers have to be 16 byte aligned, as returned by hipMalloc.
+template <typename T>
+__global__ void addVectorized(const T* a, const T* b, T* c, size_t size) {
+  using V = typename Vec16<T>::type;
+  constexpr size_t width = sizeof(V) / sizeof(T);
+  const V* va = reinterpret_cast<const V*>(a);
+  const V* vb = reinterpret_cast<const V*>(b);
+  V* vc = reinterpret_cast<V*>(c);
+
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  size_t first = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  size_t vectors = size / width;
+  for (size_t i = first; i < vectors; i += stride) {
+    vc[i] = vecAdd(va[i], vb[i]);
+  }
+  for (size_t i = vectors * width + first; i < size; i += stride) {
+    c[i] = a[i] + b[i];
+  }
+}
+
+template <typename T> __global__ void fillPattern(T* ptr, size_t size, T scale) {
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < size;
+       i += stride) {
+    ptr[i] = static_cast<T>(i % 1024) * scale;
+  }
+}
+
+// Block size with the best occupancy for kernel, and a grid just large enough to keep every
+// CU busy; the grid-stride loop covers the remaining items
+template <typename K> void launchConfig(K kernel, size_t items, dim3& grid, dim3& block) {
+  int minGridSize = 0, blockSize = 0;
+  HIP_CHECK(hipOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, kernel, 0, 0));
+  block = dim3(blockSize);
+  grid = dim3(std::max(1u, std::min(static_cast<unsigned int>(minGridSize),
+                                    abm::blocksFor(items, blockSize))));
+}
+
+template <typename T> void testAddKernel(const char* name, bool vectorized, size_t size) {
+  // Three buffers of up to 1 GB each, skipped on devices that can not hold them
+  size_t devMemFree = 0, devMemTotal = 0;
+  HIP_CHECK(hipMemGetInfo(&devMemFree, &devMemTotal));
+  if (3 * sizeof(T) * size + (256 << 20) > devMemFree) {
+    std::cout << "Skipping " << name << " of " << size << " elements, not enough device memory"
+              << std::endl;
+    return;
+  }
+
+  T *d_a, *d_b, *d_c;
+  HIP_CHECK(hipMalloc(&d_a, sizeof(T) * size));
+  HIP_CHECK(hipMalloc(&d_b, sizeof(T) * size));
+  HIP_CHECK(hipMalloc(&d_c, sizeof(T) * size));
+
+  dim3 grid, block;
+  launchConfig(fillPattern<T>, size, grid, block);
+  hipLaunchKernelGGL(fillPattern<T>, grid, block, 0, 0, d_a, size, T(1));
+  hipLaunchKernelGGL(fillPattern<T>, grid, block, 0, 0, d_b, size, T(2));
+  HIP_CHECK(hipGetLastError());
+
+  auto kernel = vectorized ? addVectorized<T> : addGridStride<T>;
+  size_t width = vectorized ? sizeof(typename Vec16<T>::type) / sizeof(T) : 1;
+  launchConfig(kernel, (size + width - 1) / width, grid, block);
+  auto launch = [&] { hipLaunchKernelGGL(kernel, grid, block, 0, 0, d_a, d_b, d_c, size); };
+  launch();
+  HIP_CHECK(hipGetLastError());
+
+  std::vector<T> c(size);
+  HIP_CHECK(hipMemcpy(c.data(), d_c, sizeof(T) * size, hipMemcpyDeviceToHost));
+  size_t mismatch = 0;
+  for (size_t i = 0; i < size; i++) {
+    if (c[i] != static_cast<T>(i % 1024) * T(3)) {
+      mismatch = i + 1;
+      break;
+    }
+  }
+  INFO(name << ": first mismatch at " << mismatch - 1 << ", grid " << grid.x << ", block "
+            << block.x);
+  REQUIRE(mismatch == 0);
+
+  float ms = abm::timeRuns(launch);
+  abm::report<T>(name, size, ms, 3.0 * sizeof(T) * size, size);
+
+  HIP_CHECK(hipFree(d_a));
+  HIP_CHECK(hipFree(d_b));
+  HIP_CHECK(hipFree(d_c));
+}
+
+// Sizes are not multiples of the vector width or the block size, so every case has a scalar
+// tail; the largest is just under 1 GB a buffer
+TEMPLATE_TEST_CASE("ABM_AddKernel_GridStride_MultiTypeMultiSize", "", int, float, long long,
+                   double) {
+  auto size =
+      GENERATE(as<size_t>{}, 1001, (1 << 20) + 3, (size_t{1} << 30) / sizeof(TestType) - 1);
+  testAddKernel<TestType>("add_grid_stride", false, size);
+}
+
+TEMPLATE_TEST_CASE("ABM_AddKernel_Vectorized_MultiTypeMultiSize", "", int, float, long long,
+                   double) {
+  auto size =
+      GENERATE(as<size_t>{}, 1001, (1 << 20) + 3, (size_t{1} << 30) / sizeof(TestType) - 1);
+  testAddKernel<TestType>("add_vectorized", true, size);
+}
@@ -0,0 +1,93 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include <abm_common.hh>
+
+#include <vector>
+
+// y = A * x for a row major rows x cols matrix, one block per row
+constexpr unsigned int kGemvBlock = 256;
+
+template <typename T>
+__global__ void gemv(const T* a, const T* x, T* y, size_t rows, size_t cols) {
+  __shared__ T partial[kGemvBlock];
+  size_t row = blockIdx.x;
+  if (row >= rows) return;
+
+  T sum = 0;
+  for (size_t col = threadIdx.x; col < cols; col += blockDim.x) {
+    sum += a[row * cols + col] * x[col];
+  }
+  partial[threadIdx.x] = sum;
+  __syncthreads();
+  for (unsigned int stride = blockDim.x / 2; stride > 0; stride /= 2) {
+    if (threadIdx.x < stride) partial[threadIdx.x] += partial[threadIdx.x + stride];
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) y[row] = partial[0];
+}
+
+// Small integer values keep the sums exact for every type, so results compare equal
+TEMPLATE_TEST_CASE("ABM_Gemv_MultiTypeMultiSize", "", int, float, double) {
+  auto size = GENERATE(as<size_t>{}, 1000, 4096);
+  const size_t rows = size, cols = size;
+
+  std::vector<TestType> a(rows * cols), x(cols), y(rows), expected(rows, 0);
+  for (size_t i = 0; i < rows; i++) {
+    for (size_t j = 0; j < cols; j++) {
+      a[i * cols + j] = static_cast<TestType>(static_cast<int>((i + 2 * j) % 5) - 2);
+    }
+  }
+  for (size_t j = 0; j < cols; j++) {
+    x[j] = static_cast<TestType>(static_cast<int>(j % 3) - 1);
+  }
+  for (size_t i = 0; i < rows; i++) {
+    for (size_t j = 0; j < cols; j++) {
+      expected[i] += a[i * cols + j] * x[j];
+    }
+  }
+
+  TestType *d_a, *d_x, *d_y;
+  HIP_CHECK(hipMalloc(&d_a, sizeof(TestType) * rows * cols));
+  HIP_CHECK(hipMalloc(&d_x, sizeof(TestType) * cols));
+  HIP_CHECK(hipMalloc(&d_y, sizeof(TestType) * rows));
+  HIP_CHECK(hipMemcpy(d_a, a.data(), sizeof(TestType) * rows * cols, hipMemcpyHostToDevice));
+  HIP_CHECK(hipMemcpy(d_x, x.data(), sizeof(TestType) * cols, hipMemcpyHostToDevice));
+
+  auto launch = [&] {
+    hipLaunchKernelGGL(gemv<TestType>, dim3(rows), dim3(kGemvBlock), 0, 0, d_a, d_x, d_y,
+                       rows, cols);
+  };
+  launch();
+  HIP_CHECK(hipGetLastError());
+  HIP_CHECK(hipMemcpy(y.data(), d_y, sizeof(TestType) * rows, hipMemcpyDeviceToHost));
+  REQUIRE(y == expected);
+
+  float ms = abm::timeRuns(launch);
+  double bytes = sizeof(TestType) * (rows * cols + cols + rows);
+  abm::report<TestType>("gemv", size, ms, bytes, 2.0 * rows * cols);
+
+  HIP_CHECK(hipFree(d_a));
+  HIP_CHECK(hipFree(d_x));
+  HIP_CHECK(hipFree(d_y));
+}
@@ -0,0 +1,89 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include <abm_common.hh>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// 256 bin histogram, every block counts into shared memory before adding to the global bins
+constexpr unsigned int kHistogramBins = 256;
+constexpr unsigned int kHistogramBlock = 256;
+constexpr unsigned int kHistogramBlocks = 1024;
+
+template <typename T>
+__global__ void histogram(const T* in, unsigned int* bins, size_t n) {
+  __shared__ unsigned int local[kHistogramBins];
+  for (unsigned int i = threadIdx.x; i < kHistogramBins; i += blockDim.x) local[i] = 0;
+  __syncthreads();
+
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < n;
+       i += stride) {
+    atomicAdd(&local[static_cast<unsigned int>(in[i]) % kHistogramBins], 1u);
+  }
+  __syncthreads();
+
+  for (unsigned int i = threadIdx.x; i < kHistogramBins; i += blockDim.x) {
+    if (local[i] != 0) atomicAdd(&bins[i], local[i]);
+  }
+}
+
+TEMPLATE_TEST_CASE("ABM_Histogram_MultiTypeMultiSize", "", unsigned char, int, unsigned int) {
+  auto size = GENERATE(as<size_t>{}, 1000, 1 << 24);
+
+  std::mt19937 engine(static_cast<unsigned int>(size));
+  // Skewed towards the low bins, so some bins see far more conflicts than others
+  std::geometric_distribution<int> genVal(0.02);
+  std::vector<TestType> in(size);
+  std::vector<unsigned int> bins(kHistogramBins), expected(kHistogramBins, 0);
+  for (auto& value : in) {
+    value = static_cast<TestType>(genVal(engine) % kHistogramBins);
+    expected[static_cast<unsigned int>(value) % kHistogramBins]++;
+  }
+
+  TestType* d_in;
+  unsigned int* d_bins;
+  HIP_CHECK(hipMalloc(&d_in, sizeof(TestType) * size));
+  HIP_CHECK(hipMalloc(&d_bins, sizeof(unsigned int) * kHistogramBins));
+  HIP_CHECK(hipMemcpy(d_in, in.data(), sizeof(TestType) * size, hipMemcpyHostToDevice));
+
+  unsigned int blocks = std::min(abm::blocksFor(size, kHistogramBlock), kHistogramBlocks);
+  auto launch = [&] {
+    HIP_CHECK(hipMemsetAsync(d_bins, 0, sizeof(unsigned int) * kHistogramBins, nullptr));
+    hipLaunchKernelGGL(histogram<TestType>, dim3(blocks), dim3(kHistogramBlock), 0, 0, d_in,
+                       d_bins, size);
+  };
+  launch();
+  HIP_CHECK(hipGetLastError());
+  HIP_CHECK(hipMemcpy(bins.data(), d_bins, sizeof(unsigned int) * kHistogramBins,
+                      hipMemcpyDeviceToHost));
+  REQUIRE(bins == expected);
+
+  float ms = abm::timeRuns(launch);
+  abm::report<TestType>("histogram", size, ms, sizeof(TestType) * size, size, "elements");
+
+  HIP_CHECK(hipFree(d_in));
+  HIP_CHECK(hipFree(d_bins));
+}
@@ -0,0 +1,122 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include <abm_common.hh>
+
+#include <vector>
+
+// Inclusive prefix sum: every block scans its part and writes its total, the totals are
+// scanned the same way one level up and added back to the blocks
+constexpr unsigned int kScanBlock = 256;
+
+template <typename T> __global__ void scanBlocks(const T* in, T* out, T* blockSums, size_t n) {
+  __shared__ T buffer[2][kScanBlock];
+  size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  int current = 0;
+  buffer[current][threadIdx.x] = i < n ? in[i] : T(0);
+  __syncthreads();
+  for (unsigned int offset = 1; offset < blockDim.x; offset *= 2) {
+    T value = buffer[current][threadIdx.x];
+    if (threadIdx.x >= offset) value += buffer[current][threadIdx.x - offset];
+    current = 1 - current;
+    buffer[current][threadIdx.x] = value;
+    __syncthreads();
+  }
+  if (i < n) out[i] = buffer[current][threadIdx.x];
+  if (threadIdx.x == blockDim.x - 1) blockSums[blockIdx.x] = buffer[current][threadIdx.x];
+}
+
+template <typename T> __global__ void addBlockOffsets(T* out, const T* scannedSums, size_t n) {
+  size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (blockIdx.x > 0 && i < n) out[i] += scannedSums[blockIdx.x - 1];
+}
+
+// Device buffers for the block totals of every level, allocated once outside the timed runs
+template <typename T> class ScanPlan {
+ public:
+  explicit ScanPlan(size_t n) {
+    for (size_t level = n; level > 1; level = abm::blocksFor(level, kScanBlock)) {
+      sizes_.push_back(level);
+      T* sums = nullptr;
+      HIP_CHECK(hipMalloc(&sums, sizeof(T) * abm::blocksFor(level, kScanBlock)));
+      sums_.push_back(sums);
+    }
+  }
+
+  ~ScanPlan() {
+    for (auto sums : sums_) static_cast<void>(hipFree(sums));
+  }
+
+  void run(const T* in, T* out, size_t level = 0) {
+    if (level >= sizes_.size()) {
+      // Single element left, a copy is its scan
+      if (in != out) HIP_CHECK(hipMemcpyAsync(out, in, sizeof(T), hipMemcpyDeviceToDevice));
+      return;
+    }
+    size_t n = sizes_[level];
+    unsigned int blocks = abm::blocksFor(n, kScanBlock);
+    hipLaunchKernelGGL(scanBlocks<T>, dim3(blocks), dim3(kScanBlock), 0, 0, in, out,
+                       sums_[level], n);
+    if (blocks > 1) {
+      run(sums_[level], sums_[level], level + 1);
+      hipLaunchKernelGGL(addBlockOffsets<T>, dim3(blocks), dim3(kScanBlock), 0, 0, out,
+                         sums_[level], n);
+    }
+  }
+
+ private:
+  std::vector<size_t> sizes_;
+  std::vector<T*> sums_;
+};
+
+// Values up to 3 keep every prefix sum below 2^24, exact in float
+TEMPLATE_TEST_CASE("ABM_InclusiveScan_MultiTypeMultiSize", "", int, long long, float, double) {
+  auto size = GENERATE(as<size_t>{}, 1000, 1 << 22);
+
+  std::vector<TestType> in(size), out(size), expected(size);
+  TestType sum = 0;
+  for (size_t i = 0; i < size; i++) {
+    in[i] = static_cast<TestType>((i * 5) % 4);
+    sum += in[i];
+    expected[i] = sum;
+  }
+
+  TestType *d_in, *d_out;
+  HIP_CHECK(hipMalloc(&d_in, sizeof(TestType) * size));
+  HIP_CHECK(hipMalloc(&d_out, sizeof(TestType) * size));
+  HIP_CHECK(hipMemcpy(d_in, in.data(), sizeof(TestType) * size, hipMemcpyHostToDevice));
+
+  ScanPlan<TestType> plan(size);
+  auto launch = [&] { plan.run(d_in, d_out); };
+  launch();
+  HIP_CHECK(hipGetLastError());
+  HIP_CHECK(hipMemcpy(out.data(), d_out, sizeof(TestType) * size, hipMemcpyDeviceToHost));
+  REQUIRE(out == expected);
+
+  float ms = abm::timeRuns(launch);
+  abm::report<TestType>("inclusive_scan", size, ms, 2.0 * sizeof(TestType) * size, size,
+                        "elements");
+
+  HIP_CHECK(hipFree(d_in));
+  HIP_CHECK(hipFree(d_out));
+}
@@ -0,0 +1,100 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include <abm_common.hh>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Bitonic sort of a power of two number of keys, one launch per merge step
+constexpr unsigned int kSortBlock = 256;
+
+template <typename T> __global__ void bitonicStep(T* keys, size_t n, size_t size, size_t stride) {
+  size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  size_t partner = i ^ stride;
+  if (i >= n || partner <= i) return;
+
+  bool ascending = (i & size) == 0;
+  T a = keys[i], b = keys[partner];
+  if ((a > b) == ascending) {
+    keys[i] = b;
+    keys[partner] = a;
+  }
+}
+
+template <typename T> void bitonicSort(T* keys, size_t n) {
+  unsigned int blocks = abm::blocksFor(n, kSortBlock);
+  for (size_t size = 2; size <= n; size *= 2) {
+    for (size_t stride = size / 2; stride > 0; stride /= 2) {
+      hipLaunchKernelGGL(bitonicStep<T>, dim3(blocks), dim3(kSortBlock), 0, 0, keys, n, size,
+                         stride);
+    }
+  }
+}
+
+// Sizes that are not a power of two are padded with the largest key
+TEMPLATE_TEST_CASE("ABM_BitonicSort_MultiTypeMultiSize", "", int, unsigned int, float, double) {
+  auto size = GENERATE(as<size_t>{}, 1000, 1 << 20);
+  size_t padded = 1;
+  while (padded < size) padded *= 2;
+
+  std::mt19937 engine(static_cast<unsigned int>(size));
+  std::uniform_int_distribution<int> genKey(-1000000, 1000000);
+  std::vector<TestType> keys(padded, std::numeric_limits<TestType>::max());
+  for (size_t i = 0; i < size; i++) {
+    keys[i] = static_cast<TestType>(genKey(engine));
+  }
+  std::vector<TestType> expected(keys), sorted(padded);
+  std::sort(expected.begin(), expected.end());
+
+  TestType *d_unsorted, *d_keys;
+  HIP_CHECK(hipMalloc(&d_unsorted, sizeof(TestType) * padded));
+  HIP_CHECK(hipMalloc(&d_keys, sizeof(TestType) * padded));
+  HIP_CHECK(hipMemcpy(d_unsorted, keys.data(), sizeof(TestType) * padded,
+                      hipMemcpyHostToDevice));
+
+  // Every run sorts the unsorted keys again
+  auto launch = [&] {
+    HIP_CHECK(hipMemcpyAsync(d_keys, d_unsorted, sizeof(TestType) * padded,
+                             hipMemcpyDeviceToDevice, nullptr));
+    bitonicSort(d_keys, padded);
+  };
+  launch();
+  HIP_CHECK(hipGetLastError());
+  HIP_CHECK(hipMemcpy(sorted.data(), d_keys, sizeof(TestType) * padded, hipMemcpyDeviceToHost));
+  REQUIRE(sorted == expected);
+
+  // Each merge step reads and writes all keys
+  float ms = abm::timeRuns(launch);
+  double steps = 0;
+  for (size_t n = 2; n <= padded; n *= 2) {
+    for (size_t stride = n / 2; stride > 0; stride /= 2) steps++;
+  }
+  abm::report<TestType>("bitonic_sort", size, ms, 2.0 * sizeof(TestType) * padded * steps, size,
+                        "keys");
+
+  HIP_CHECK(hipFree(d_unsorted));
+  HIP_CHECK(hipFree(d_keys));
+}
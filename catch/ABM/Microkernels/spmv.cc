@@ -0,0 +1,121 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include <abm_common.hh>
+
+#include <random>
+#include <vector>
+
+// y = A * x for a CSR matrix, kSpmvLanes threads share a row
+constexpr unsigned int kSpmvBlock = 256;
+constexpr unsigned int kSpmvLanes = 16;
+
+template <typename T>
+__global__ void spmvCsr(const int* rowOffsets, const int* cols, const T* values, const T* x,
+                        T* y, size_t rows) {
+  __shared__ T partial[kSpmvBlock];
+  unsigned int lane = threadIdx.x % kSpmvLanes;
+  size_t row = (static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x) / kSpmvLanes;
+
+  T sum = 0;
+  if (row < rows) {
+    for (int i = rowOffsets[row] + lane; i < rowOffsets[row + 1]; i += kSpmvLanes) {
+      sum += values[i] * x[cols[i]];
+    }
+  }
+  partial[threadIdx.x] = sum;
+  __syncthreads();
+  for (unsigned int stride = kSpmvLanes / 2; stride > 0; stride /= 2) {
+    if (lane < stride) partial[threadIdx.x] += partial[threadIdx.x + stride];
+    __syncthreads();
+  }
+  if (row < rows && lane == 0) y[row] = partial[threadIdx.x];
+}
+
+// Random sparsity with 0 to 32 entries per row, small integer values keep the sums exact
+TEMPLATE_TEST_CASE("ABM_SpmvCsr_MultiTypeMultiSize", "", int, float, double) {
+  auto rows = GENERATE(as<size_t>{}, 1 << 14, 1 << 20);
+  const size_t cols = rows;
+
+  std::mt19937 engine(static_cast<unsigned int>(rows));
+  std::uniform_int_distribution<int> genCount(0, 32);
+  std::uniform_int_distribution<int> genCol(0, static_cast<int>(cols) - 1);
+  std::uniform_int_distribution<int> genVal(1, 4);
+
+  std::vector<int> rowOffsets(1, 0), colIndices;
+  std::vector<TestType> values;
+  for (size_t row = 0; row < rows; row++) {
+    int count = genCount(engine);
+    for (int i = 0; i < count; i++) {
+      colIndices.push_back(genCol(engine));
+      values.push_back(static_cast<TestType>(genVal(engine)));
+    }
+    rowOffsets.push_back(static_cast<int>(colIndices.size()));
+  }
+  const size_t nnz = values.size();
+
+  std::vector<TestType> x(cols), y(rows), expected(rows, 0);
+  for (size_t i = 0; i < cols; i++) {
+    x[i] = static_cast<TestType>(i % 4);
+  }
+  for (size_t row = 0; row < rows; row++) {
+    for (int i = rowOffsets[row]; i < rowOffsets[row + 1]; i++) {
+      expected[row] += values[i] * x[colIndices[i]];
+    }
+  }
+
+  int *d_rowOffsets, *d_cols;
+  TestType *d_values, *d_x, *d_y;
+  HIP_CHECK(hipMalloc(&d_rowOffsets, sizeof(int) * rowOffsets.size()));
+  HIP_CHECK(hipMalloc(&d_cols, sizeof(int) * nnz));
+  HIP_CHECK(hipMalloc(&d_values, sizeof(TestType) * nnz));
+  HIP_CHECK(hipMalloc(&d_x, sizeof(TestType) * cols));
+  HIP_CHECK(hipMalloc(&d_y, sizeof(TestType) * rows));
+  HIP_CHECK(hipMemcpy(d_rowOffsets, rowOffsets.data(), sizeof(int) * rowOffsets.size(),
+                      hipMemcpyHostToDevice));
+  HIP_CHECK(hipMemcpy(d_cols, colIndices.data(), sizeof(int) * nnz, hipMemcpyHostToDevice));
+  HIP_CHECK(hipMemcpy(d_values, values.data(), sizeof(TestType) * nnz, hipMemcpyHostToDevice));
+  HIP_CHECK(hipMemcpy(d_x, x.data(), sizeof(TestType) * cols, hipMemcpyHostToDevice));
+
+  unsigned int blocks = abm::blocksFor(rows * kSpmvLanes, kSpmvBlock);
+  auto launch = [&] {
+    hipLaunchKernelGGL(spmvCsr<TestType>, dim3(blocks), dim3(kSpmvBlock), 0, 0, d_rowOffsets,
+                       d_cols, d_values, d_x, d_y, rows);
+  };
+  launch();
+  HIP_CHECK(hipGetLastError());
+  HIP_CHECK(hipMemcpy(y.data(), d_y, sizeof(TestType) * rows, hipMemcpyDeviceToHost));
+  REQUIRE(y == expected);
+
+  // Matrix, offsets and y once, x gathered once per entry in the worst case
+  float ms = abm::timeRuns(launch);
+  double bytes = (sizeof(TestType) + sizeof(int)) * nnz + sizeof(int) * (rows + 1) +
+                 sizeof(TestType) * (rows + nnz);
+  abm::report<TestType>("spmv_csr", rows, ms, bytes, 2.0 * nnz);
+
+  HIP_CHECK(hipFree(d_rowOffsets));
+  HIP_CHECK(hipFree(d_cols));
+  HIP_CHECK(hipFree(d_values));
+  HIP_CHECK(hipFree(d_x));
+  HIP_CHECK(hipFree(d_y));
+}
@@ -0,0 +1,86 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#include <abm_common.hh>
+
+#include <vector>
+
+// 5 point Laplacian on a width x height grid, boundary points are copied
+constexpr unsigned int kStencilBlock = 16;
+
+template <typename T>
+__global__ void stencil5(const T* in, T* out, size_t width, size_t height) {
+  size_t x = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t y = blockIdx.y * blockDim.y + threadIdx.y;
+  if (x >= width || y >= height) return;
+
+  size_t i = y * width + x;
+  if (x == 0 || y == 0 || x == width - 1 || y == height - 1) {
+    out[i] = in[i];
+  } else {
+    out[i] = 4 * in[i] - in[i - 1] - in[i + 1] - in[i - width] - in[i + width];
+  }
+}
+
+TEMPLATE_TEST_CASE("ABM_Stencil_MultiTypeMultiSize", "", int, float, double) {
+  auto size = GENERATE(as<size_t>{}, 1000, 4096);
+  const size_t width = size, height = size;
+
+  std::vector<TestType> in(width * height), out(width * height), expected(width * height);
+  for (size_t i = 0; i < in.size(); i++) {
+    in[i] = static_cast<TestType>((i * 7) % 11);
+  }
+  for (size_t y = 0; y < height; y++) {
+    for (size_t x = 0; x < width; x++) {
+      size_t i = y * width + x;
+      if (x == 0 || y == 0 || x == width - 1 || y == height - 1) {
+        expected[i] = in[i];
+      } else {
+        expected[i] = 4 * in[i] - in[i - 1] - in[i + 1] - in[i - width] - in[i + width];
+      }
+    }
+  }
+
+  TestType *d_in, *d_out;
+  HIP_CHECK(hipMalloc(&d_in, sizeof(TestType) * in.size()));
+  HIP_CHECK(hipMalloc(&d_out, sizeof(TestType) * in.size()));
+  HIP_CHECK(hipMemcpy(d_in, in.data(), sizeof(TestType) * in.size(), hipMemcpyHostToDevice));
+
+  dim3 block(kStencilBlock, kStencilBlock);
+  dim3 grid(abm::blocksFor(width, kStencilBlock), abm::blocksFor(height, kStencilBlock));
+  auto launch = [&] {
+    hipLaunchKernelGGL(stencil5<TestType>, grid, block, 0, 0, d_in, d_out, width, height);
+  };
+  launch();
+  HIP_CHECK(hipGetLastError());
+  HIP_CHECK(hipMemcpy(out.data(), d_out, sizeof(TestType) * out.size(), hipMemcpyDeviceToHost));
+  REQUIRE(out == expected);
+
+  // Every point is read and written once when the neighbours hit in cache
+  float ms = abm::timeRuns(launch);
+  abm::report<TestType>("stencil5", size, ms, 2.0 * sizeof(TestType) * in.size(),
+                        5.0 * in.size());
+
+  HIP_CHECK(hipFree(d_in));
+  HIP_CHECK(hipFree(d_out));
+}
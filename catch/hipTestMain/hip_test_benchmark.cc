@@ -0,0 +1,148 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#define CATCH_CONFIG_EXTERNAL_INTERFACES
+#include <hip_test_common.hh>
+#include <hip_test_benchmark.hh>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+namespace {
+// Nearest-rank percentile of sorted values, as computed by the perftests
+double percentile(const std::vector<double>& sorted, double p) {
+  size_t rank = static_cast<size_t>(p / 100.0 * sorted.size() + 0.5);
+  rank = std::min(std::max(rank, static_cast<size_t>(1)), sorted.size());
+  return sorted[rank - 1];
+}
+
+std::string jsonEscape(const std::string& str) {
+  std::string out;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out += ' ';
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+/*
+Catch listener keeping hip::BenchmarkResult::last() up to date. With HT_BENCHMARK_JSON set,
+every benchmark is appended to that file as one json object per line with the fields of the
+perftests --format json records: benchmark is the TEST_CASE name, test the index of the
+benchmark within it and desc the benchmark name, values are in us per iteration. With
+sharding every shard writes <HT_BENCHMARK_JSON>.shard<index>.
+*/
+class BenchmarkListener : public Catch::TestEventListenerBase {
+ public:
+  using TestEventListenerBase::TestEventListenerBase;
+
+  void testRunStarting(Catch::TestRunInfo const& testRunInfo) override {
+    TestEventListenerBase::testRunStarting(testRunInfo);
+    path_ = TestContext::getEnvVar("HT_BENCHMARK_JSON");
+    auto& context = TestContext::get();
+    if (!path_.empty() && context.isSharded()) {
+      path_ += ".shard" + std::to_string(context.shardIndex());
+    }
+  }
+
+  void testCaseStarting(Catch::TestCaseInfo const& testInfo) override {
+    TestEventListenerBase::testCaseStarting(testInfo);
+    testName_ = testInfo.name;
+    index_ = 0;
+  }
+
+  void benchmarkEnded(Catch::BenchmarkStats<> const& stats) override {
+    TestEventListenerBase::benchmarkEnded(stats);
+
+    std::vector<double> sorted;
+    for (const auto& sample : stats.samples) {
+      sorted.push_back(sample.count() / 1e3);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    hip::BenchmarkResult result{};
+    result.test = testName_;
+    result.name = stats.info.name;
+    result.samples = static_cast<int>(sorted.size());
+    result.iterations = stats.info.iterations;
+    if (!sorted.empty()) {
+      double sum = 0;
+      for (double v : sorted) sum += v;
+      result.minUs = sorted.front();
+      result.maxUs = sorted.back();
+      result.meanUs = sum / sorted.size();
+      result.medianUs = percentile(sorted, 50);
+      result.p90Us = percentile(sorted, 90);
+      result.p99Us = percentile(sorted, 99);
+      double dev = 0;
+      for (double v : sorted) dev += (v - result.meanUs) * (v - result.meanUs);
+      result.stddevUs = std::sqrt(dev / sorted.size());
+    }
+    hip::BenchmarkResult::last() = result;
+
+    if (!path_.empty()) writeRecord(result, index_);
+    index_++;
+  }
+
+ private:
+  void writeRecord(const hip::BenchmarkResult& result, int index) const {
+    int device = 0;
+    hipDeviceProp_t props{};
+    int driverVersion = 0, runtimeVersion = 0;
+    static_cast<void>(hipGetDevice(&device));
+    static_cast<void>(hipGetDeviceProperties(&props, device));
+    static_cast<void>(hipDriverGetVersion(&driverVersion));
+    static_cast<void>(hipRuntimeGetVersion(&runtimeVersion));
+
+    // Appended, so the single test runs done by ctest accumulate into one file
+    std::ofstream report(path_, std::ios::app);
+    if (!report.is_open()) {
+      std::cerr << "Unable to write benchmark report: " << path_ << std::endl;
+      return;
+    }
+    report << "{\"benchmark\":\"" << jsonEscape(result.test) << "\",\"test\":" << index
+           << ",\"desc\":\"" << jsonEscape(result.name) << "\",\"device\":" << device
+           << ",\"device_name\":\"" << jsonEscape(props.name) << "\",\"arch\":\""
+           << jsonEscape(props.gcnArchName) << "\",\"driver_version\":" << driverVersion
+           << ",\"runtime_version\":" << runtimeVersion << ",\"size\":0"
+           << ",\"iterations\":" << result.iterations << ",\"unit\":\"us\""
+           << ",\"samples\":" << result.samples << ",\"min\":" << result.minUs
+           << ",\"median\":" << result.medianUs << ",\"p90\":" << result.p90Us
+           << ",\"p99\":" << result.p99Us << ",\"max\":" << result.maxUs
+           << ",\"mean\":" << result.meanUs << ",\"stddev\":" << result.stddevUs << "}"
+           << std::endl;
+  }
+
+  std::string path_;
+  std::string testName_;
+  int index_ = 0;
+};
+}  // namespace
+
+CATCH_REGISTER_LISTENER(BenchmarkListener)
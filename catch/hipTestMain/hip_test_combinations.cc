@@ -0,0 +1,119 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <hip_test_combinations.hh>
+#include <iostream>
+
+namespace hip {
+bool PairwiseCoverage() {
+  static const bool pairwise = [] {
+    const std::string mode = TestContext::getEnvVar("HT_COVERAGE");
+    if (mode.empty() || mode == "exhaustive") return false;
+    if (mode == "pairwise") return true;
+    std::cerr << "Unknown HT_COVERAGE=" << mode << ", running all combinations" << std::endl;
+    return false;
+  }();
+  return pairwise;
+}
+
+std::vector<std::vector<size_t>> CombinationIndices(const std::vector<size_t>& sizes,
+                                                    bool pairwise) {
+  std::vector<std::vector<size_t>> combinations;
+  const size_t count = sizes.size();
+  for (size_t size : sizes) {
+    if (size == 0) return combinations;
+  }
+
+  if (!pairwise || count < 3) {
+    // Full product, last parameter varying fastest
+    std::vector<size_t> indices(count, 0);
+    while (true) {
+      combinations.push_back(indices);
+      size_t p = count;
+      while (p > 0 && ++indices[p - 1] == sizes[p - 1]) {
+        indices[--p] = 0;
+      }
+      if (p == 0) return combinations;
+    }
+  }
+
+  // uncovered[i][j][a * sizes[j] + b]: value a of parameter i not yet combined with value b
+  // of parameter j, for i < j
+  std::vector<std::vector<std::vector<bool>>> uncovered(count);
+  size_t remaining = 0;
+  for (size_t i = 0; i < count; i++) {
+    uncovered[i].resize(count);
+    for (size_t j = i + 1; j < count; j++) {
+      uncovered[i][j].assign(sizes[i] * sizes[j], true);
+      remaining += sizes[i] * sizes[j];
+    }
+  }
+  auto isUncovered = [&](size_t i, size_t a, size_t j, size_t b) {
+    return i < j ? uncovered[i][j][a * sizes[j] + b] : uncovered[j][i][b * sizes[i] + a];
+  };
+
+  constexpr size_t unset = static_cast<size_t>(-1);
+  while (remaining > 0) {
+    // Seed with the first uncovered pair, then fill the other parameters one by one with the
+    // value covering the most pairs with the parameters set so far, lowest value on ties
+    std::vector<size_t> indices(count, unset);
+    for (size_t i = 0; i < count && indices[i] == unset; i++) {
+      for (size_t j = i + 1; j < count && indices[i] == unset; j++) {
+        for (size_t pair = 0; pair < uncovered[i][j].size(); pair++) {
+          if (uncovered[i][j][pair]) {
+            indices[i] = pair / sizes[j];
+            indices[j] = pair % sizes[j];
+            break;
+          }
+        }
+      }
+    }
+    for (size_t k = 0; k < count; k++) {
+      if (indices[k] != unset) continue;
+      size_t best = 0, bestGain = 0;
+      for (size_t v = 0; v < sizes[k]; v++) {
+        size_t gain = 0;
+        for (size_t m = 0; m < count; m++) {
+          if (m != k && indices[m] != unset && isUncovered(k, v, m, indices[m])) gain++;
+        }
+        if (gain > bestGain) {
+          best = v;
+          bestGain = gain;
+        }
+      }
+      indices[k] = best;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      for (size_t j = i + 1; j < count; j++) {
+        const size_t pair = indices[i] * sizes[j] + indices[j];
+        if (uncovered[i][j][pair]) {
+          uncovered[i][j][pair] = false;
+          remaining--;
+        }
+      }
+    }
+    combinations.push_back(indices);
+  }
+  return combinations;
+}
+}  // namespace hip
@@ -4,6 +4,9 @@
 #include <fstream>
 #include <sstream>
 #include <regex>
+#include <algorithm>
+#include <chrono>
+#include <thread>
 #include "hip_test_context.hh"
 #include "hip_test_filesystem.hh"
 #include "hip_test_features.hh"
@@ -85,6 +88,7 @@ std::string& TestContext::getCommonJsonFile() {
 
   // get config.json files if config folder.
   if (configFolderFound) {
+    config_dir_ = config_dir.string();
     json_file_ = getMatchingConfigFile(config_dir.string());
   }
   return json_file_;
@@ -122,9 +126,13 @@ TestContext::TestContext(int argc, char** argv) {
   detectOS();
   detectPlatform();
   setExePath(argc, argv);
-  getConfigFiles();
-  parseJsonFiles();
+  if (!loadConfigCache()) {
+    getConfigFiles();
+    if (parseJsonFiles()) storeConfigCache();
+  }
   parseOptions(argc, argv);
+  parseShardOptions();
+  assignShardDevice();
 }
 
 void TestContext::setExePath(int argc, char** argv) {
@@ -146,19 +154,119 @@ void TestContext::parseOptions(int argc, char** argv) {
   current_test = std::string(argv[1]);
 }
 
-bool TestContext::skipTest() const {
+void TestContext::parseShardOptions() {
+  std::string index = TestContext::getEnvVar("HT_SHARD_INDEX");
+  std::string count = TestContext::getEnvVar("HT_SHARD_COUNT");
+  if (count.empty()) return;
+
+  try {
+    shard_count_ = std::stoul(count);
+    shard_index_ = index.empty() ? 0 : std::stoul(index);
+  } catch (const std::exception&) {
+    shard_count_ = 0;
+  }
+  if (shard_count_ == 0 || shard_index_ >= shard_count_) {
+    std::cerr << "Invalid shard HT_SHARD_INDEX=" << index << " HT_SHARD_COUNT=" << count
+              << std::endl;
+    std::abort();
+  }
+  LogPrintf("Running shard %u of %u", shard_index_, shard_count_);
+}
+
+void TestContext::assignShardDevice() {
+  // Must happen before the first HIP call, which is why this is part of the constructor
+  std::string devices = TestContext::getEnvVar("HT_SHARD_DEVICES");
+  if (!isSharded() || devices.empty()) return;
+
+  std::vector<std::string> device_list;
+  std::stringstream ss(devices);
+  for (std::string device; std::getline(ss, device, ',');) {
+    if (!device.empty()) device_list.push_back(device);
+  }
+  if (device_list.empty()) return;
+
+  const std::string& device = device_list[shard_index_ % device_list.size()];
+  const char* visible_devices = nvidia ? "CUDA_VISIBLE_DEVICES" : "HIP_VISIBLE_DEVICES";
+#if (HT_WIN == 1)
+  _putenv_s(visible_devices, device.c_str());
+#else
+  setenv(visible_devices, device.c_str(), 1);
+#endif
+  LogPrintf("Shard %u uses device %s", shard_index_, device.c_str());
+}
+
+std::vector<std::string> TestContext::shardTests(std::vector<std::string> test_names) const {
+  // Sorting makes the split independent of registration order and --order
+  std::sort(test_names.begin(), test_names.end());
+  std::vector<std::string> enabled;
+  for (const auto& name : test_names) {
+    if (!isDisabled(name)) enabled.push_back(name);
+  }
+
+  std::vector<std::string> shard;
+  std::string durations_file = TestContext::getEnvVar("HT_SHARD_DURATIONS");
+  if (durations_file.empty()) {
+    for (size_t i = shard_index_; i < enabled.size(); i += shard_count_) {
+      shard.push_back(enabled[i]);
+    }
+    return shard;
+  }
+
+  // Longest processing time first: hand the most expensive remaining test to the least
+  // loaded shard. Every shard computes the same assignment from the same inputs.
+  auto durations = hip::TestProfiler::readReport(durations_file);
+  double known_total = 0.0;
+  size_t known = 0;
+  for (const auto& name : enabled) {
+    auto it = durations.find(name);
+    if (it != durations.end()) {
+      known_total += it->second.wallMs;
+      known++;
+    }
+  }
+  // Tests without a recorded duration are assumed to take the mean of the known ones
+  double fallback = known > 0 ? known_total / known : 1.0;
+
+  std::vector<std::pair<double, std::string>> costs;
+  for (const auto& name : enabled) {
+    auto it = durations.find(name);
+    costs.emplace_back(it != durations.end() ? it->second.wallMs : fallback, name);
+  }
+  std::stable_sort(costs.begin(), costs.end(),
+                   [](const auto& a, const auto& b) { return a.first > b.first; });
+
+  std::vector<double> load(shard_count_, 0.0);
+  for (const auto& cost : costs) {
+    size_t target = std::min_element(load.begin(), load.end()) - load.begin();
+    load[target] += cost.first;
+    if (target == shard_index_) shard.push_back(cost.second);
+  }
+  LogPrintf("Shard %u: %zu of %zu tests have recorded durations, expected %.0f ms", shard_index_,
+            known, enabled.size(), load[shard_index_]);
+  std::sort(shard.begin(), shard.end());
+  return shard;
+}
+
+bool TestContext::isDisabled(const std::string& test_name) const {
+  std::call_once(skip_regex_once_, [this]() {
+    for (const auto& i : skip_test) {
+      skip_regex_.emplace_back(i, std::regex::ECMAScript | std::regex::optimize);
+    }
+  });
   // Direct Match
-  auto flags = std::regex::ECMAScript;
-  for (const auto& i : skip_test) {
-    auto regex = std::regex(i.c_str(), flags);
-    if (std::regex_match(current_test, regex)) {
+  for (const auto& regex : skip_regex_) {
+    if (std::regex_match(test_name, regex)) {
       return true;
     }
   }
-  // TODO add test case skip as well
   return false;
 }
 
+bool TestContext::skipTest() const {
+  // TODO add test case skip as well
+  return isDisabled(current_test);
+}
+
 std::string TestContext::currentPath() const { return fs::current_path().string(); }
 
 bool TestContext::parseJsonFiles() {
@@ -210,38 +318,183 @@ bool TestContext::parseJsonFiles() {
   return true;
 }
 
+/*
+The config cache in the exe folder stores the resolved config files and their parsed
+DisabledTests, so processes started after the first one skip the config folder search and
+the json parsing. It is only used while HIP_CATCH_EXCLUDE_FILE is unchanged and the config
+folder and every json file still have the recorded modification time.
+
+Format, one entry per line:
+  hip-test-config-cache 1
+  env <HIP_CATCH_EXCLUDE_FILE>
+  path <config folder or json file> <modification time>
+  skip <regex>
+*/
+static const char* kConfigCacheVersion = "hip-test-config-cache 1";
+
+static std::string modificationTime(const std::string& path) {
+  std::error_code error;
+  auto time = fs::last_write_time(path, error);
+  if (error) return "";
+  return std::to_string(time.time_since_epoch().count());
+}
+
+std::string TestContext::configCachePath() const {
+  return (fs::path(exe_path) / "hip_test_config.cache").string();
+}
+
+bool TestContext::loadConfigCache() {
+  std::ifstream cache(configCachePath());
+  std::string line;
+  if (!cache.is_open() || !std::getline(cache, line) || line != kConfigCacheVersion) {
+    return false;
+  }
+
+  std::vector<std::string> json_files;
+  std::set<std::string> skips;
+  bool env_matches = false;
+  while (std::getline(cache, line)) {
+    size_t space = line.find(' ');
+    std::string kind = line.substr(0, space);
+    std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+    if (kind == "env") {
+      env_matches = value == TestContext::getEnvVar("HIP_CATCH_EXCLUDE_FILE");
+    } else if (kind == "path") {
+      size_t separator = value.rfind(' ');
+      if (separator == std::string::npos) return false;
+      std::string path = value.substr(0, separator);
+      if (modificationTime(path) != value.substr(separator + 1)) {
+        LogPrintf("Config cache is stale: %s changed", path.c_str());
+        return false;
+      }
+      if (fs::is_regular_file(path)) json_files.push_back(path);
+    } else if (kind == "skip") {
+      skips.insert(value);
+    }
+  }
+  if (!env_matches) return false;
+
+  config_.platform = (amd ? "amd" : (nvidia ? "nvidia" : "unknown"));
+  config_.os = (p_windows ? "windows" : (p_linux ? "linux" : "unknown"));
+  config_.json_files = json_files;
+  skip_test = skips;
+  LogPrintf("Using config cache: %s", configCachePath().c_str());
+  return true;
+}
+
+void TestContext::storeConfigCache() const {
+  // Without a config folder there is nothing to validate the cache against
+  std::vector<std::string> paths;
+  if (TestContext::getEnvVar("HIP_CATCH_EXCLUDE_FILE").empty()) {
+    if (config_dir_.empty()) return;
+    paths.push_back(config_dir_);
+  }
+  for (const auto& fl : config_.json_files) {
+    paths.push_back(fl);
+  }
+
+  std::stringstream contents;
+  contents << kConfigCacheVersion << '\n';
+  contents << "env " << TestContext::getEnvVar("HIP_CATCH_EXCLUDE_FILE") << '\n';
+  for (const auto& path : paths) {
+    std::string time = modificationTime(path);
+    if (time.empty()) return;
+    contents << "path " << path << ' ' << time << '\n';
+  }
+  for (const auto& skip : skip_test) {
+    contents << "skip " << skip << '\n';
+  }
+
+  // Write and rename, concurrent test processes either see the old or the new cache
+  std::string cache_path = configCachePath();
+  std::string tmp_path = cache_path + ".tmp" + std::to_string(std::hash<std::thread::id>()(
+                                                   std::this_thread::get_id()) ^
+                                               std::chrono::steady_clock::now()
+                                                   .time_since_epoch()
+                                                   .count());
+  {
+    std::ofstream cache(tmp_path);
+    if (!cache.is_open()) return;
+    cache << contents.str();
+    if (!cache) return;
+  }
+  std::error_code error;
+  fs::rename(tmp_path, cache_path, error);
+  if (error) fs::remove(tmp_path, error);
+}
+
 void TestContext::cleanContext() {
+  std::unique_lock<std::mutex> lock(rtcMutex);
   for (auto& pair : compiledKernels) {
-    hipError_t error = hipModuleUnload(pair.second.module);
+    // Entries still compiling belong to a caller that is waiting for them
+    if (pair.second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+    hipError_t error = hipModuleUnload(pair.second.get().module);
     if (error != hipSuccess) {
       throw std::runtime_error("Unable to unload rtc module");
     }
   }
+  compiledKernels.clear();
 }
 
 void TestContext::trackRtcState(std::string kernelNameExpression, hipModule_t loadedModule,
                                 hipFunction_t kernelFunction) {
-  rtcState state{loadedModule, kernelFunction};
-  compiledKernels[kernelNameExpression] = state;
+  std::promise<rtcState> state;
+  state.set_value(rtcState{loadedModule, kernelFunction});
+  std::unique_lock<std::mutex> lock(rtcMutex);
+  compiledKernels[kernelNameExpression] = state.get_future().share();
 }
 
 hipFunction_t TestContext::getFunction(const std::string kernelNameExpression) {
+  std::unique_lock<std::mutex> lock(rtcMutex);
   auto it{compiledKernels.find(kernelNameExpression)};
 
-  if (it != compiledKernels.end()) {
-    return it->second.kernelFunction;
+  if (it != compiledKernels.end() &&
+      it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    return it->second.get().kernelFunction;
   } else {
     return nullptr;
   }
 }
 
+hipFunction_t TestContext::getFunction(
+    const std::string& kernelNameExpression,
+    const std::function<std::pair<hipModule_t, hipFunction_t>()>& compile) {
+  std::promise<rtcState> promise;
+  std::shared_future<rtcState> state;
+  bool compileHere = false;
+  {
+    std::unique_lock<std::mutex> lock(rtcMutex);
+    auto it{compiledKernels.find(kernelNameExpression)};
+    if (it != compiledKernels.end()) {
+      state = it->second;
+    } else {
+      state = promise.get_future().share();
+      compiledKernels.emplace(kernelNameExpression, state);
+      compileHere = true;
+    }
+  }
+
+  // Compile without holding the lock so other kernels are not blocked
+  if (compileHere) {
+    try {
+      auto loaded = compile();
+      promise.set_value(rtcState{loaded.first, loaded.second});
+    } catch (...) {
+      {
+        std::unique_lock<std::mutex> lock(rtcMutex);
+        compiledKernels.erase(kernelNameExpression);
+      }
+      promise.set_exception(std::current_exception());
+    }
+  }
+  return state.get().kernelFunction;
+}
+
 void TestContext::addResults(HCResult r) {
+  if (HCResult::passes(r.result, r.conditionsResult)) return;
   std::unique_lock<std::mutex> lock(resultMutex);
   results.push_back(r);
-  if ((!r.conditionsResult) ||
-      ((r.result != hipSuccess) && (r.result != hipErrorPeerAccessAlreadyEnabled))) {
-    hasErrorOccured_.store(true);
-  }
+  hasErrorOccured_.store(true);
 }
 
 void TestContext::finalizeResults() {
@@ -261,6 +514,41 @@ void TestContext::finalizeResults() {
 
 bool TestContext::hasErrorOccured() { return hasErrorOccured_.load(); }
 
+void TestContext::addDeferredResult(size_t line, const char* file, hipError_t result,
+                                    const char* call) {
+  // Epoch of the last recorded failure, so later failures of this thread only count
+  thread_local unsigned int recordedEpoch = 0;
+  deferredFailures_.fetch_add(1, std::memory_order_relaxed);
+  unsigned int epoch = deferredEpoch_.load();
+  if (recordedEpoch == epoch) return;
+  recordedEpoch = epoch;
+  std::unique_lock<std::mutex> lock(resultMutex);
+  deferredResults.emplace_back(line, file, result, call);
+}
+
+void TestContext::finalizeDeferred() {
+  std::vector<HCResult> failed;
+  size_t failures = 0;
+  {
+    std::unique_lock<std::mutex> lock(resultMutex);
+    failed.swap(deferredResults);
+    failures = deferredFailures_.exchange(0);
+    deferredEpoch_.fetch_add(1);
+  }
+  if (failed.empty()) return;
+
+  std::ostringstream message;
+  message << failures << " deferred HIP API check(s) failed, first failure of " << failed.size()
+          << " thread(s):";
+  for (const auto& i : failed) {
+    message << "\n    File:: " << i.file << "\n    Line:: " << i.line << "\n    API:: " << i.call
+            << "\n    Result:: " << i.result
+            << "\n    Result Str:: " << hipGetErrorString(i.result);
+  }
+  INFO(message.str());
+  REQUIRE(failed.empty());
+}
+
 TestContext::~TestContext() {
   // Show this message when there are unchecked results
   if (results.size() != 0) {
@@ -271,4 +559,10 @@ TestContext::~TestContext() {
     std::abort();  // Crash to bring users attention to this message and avoid accidental passing of
                    // tests without checking for errors
   }
+  if (deferredResults.size() != 0) {
+    std::cerr << "HIP_CHECK_DEFERRED_FINALIZE() has not been called after HIP_CHECK_DEFERRED\n"
+              << "There are " << deferredFailures_.load() << " unchecked failures from "
+              << deferredResults.size() << " thread(s)." << std::endl;
+    std::abort();
+  }
 }
@@ -0,0 +1,207 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#define CATCH_CONFIG_EXTERNAL_INTERFACES
+#include <hip_test_common.hh>
+#include <hip_test_buffer_pool.hh>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr double kMb = 1024.0 * 1024.0;
+
+struct MemorySample {
+  double deviceUsedMb;  // total - free summed over all devices, negative if unavailable
+  double hostRssMb;     // negative if unavailable
+};
+
+double hostRssMb() {
+#if defined(__linux__)
+  long pages = 0, resident = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) return -1;
+  int read = fscanf(statm, "%ld %ld", &pages, &resident);
+  fclose(statm);
+  if (read != 2) return -1;
+  return resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / kMb;
+#else
+  return -1;
+#endif
+}
+
+// Waits for all devices, returns memory held by stream ordered pools and samples the usage.
+// The current device is unchanged afterwards.
+MemorySample sample() {
+  MemorySample result{-1, hostRssMb()};
+  int current = 0, count = 0;
+  if (hipGetDevice(&current) != hipSuccess || hipGetDeviceCount(&count) != hipSuccess) {
+    return result;
+  }
+  double used = 0;
+  for (int i = 0; i < count; i++) {
+    size_t freeMem = 0, totalMem = 0;
+    if (hipSetDevice(i) != hipSuccess || hipDeviceSynchronize() != hipSuccess) return result;
+    hipMemPool_t pool = nullptr;
+    if (hipDeviceGetDefaultMemPool(&pool, i) == hipSuccess) {
+      static_cast<void>(hipMemPoolTrimTo(pool, 0));  // Not supported everywhere
+    }
+    if (hipMemGetInfo(&freeMem, &totalMem) != hipSuccess) return result;
+    used += (totalMem - freeMem) / kMb;
+  }
+  static_cast<void>(hipSetDevice(current));
+  static_cast<void>(hipGetLastError());
+  result.deviceUsedMb = used;
+  result.hostRssMb = hostRssMb();
+  return result;
+}
+
+double envMb(const char* name, double fallback) {
+  auto value = TestContext::getEnvVar(name);
+  return value.empty() ? fallback : atof(value.c_str());
+}
+
+/*
+Catch listener behind HT_LEAK_CHECK. Device memory in use (over all devices) and host RSS
+are sampled before and after every TEST_CASE, once the devices are idle and the buffer,
+pinned and default memory pools are trimmed. Every test appends its deltas to the csv report
+<HT_LEAK_CHECK> (<HT_LEAK_CHECK>.shard<index> when sharded), so a crash keeps the rows of the
+tests that ran and consecutive ctest runs accumulate. Growth above HT_LEAK_THRESHOLD_MB
+(device, 2 MB by default) or HT_LEAK_HOST_THRESHOLD_MB (host, 16 MB by default) is flagged
+on stderr and listed again at the end of the run, with the growth over the whole run.
+*/
+class LeakCheckListener : public Catch::TestEventListenerBase {
+ public:
+  using TestEventListenerBase::TestEventListenerBase;
+
+  void testRunStarting(Catch::TestRunInfo const& testRunInfo) override {
+    TestEventListenerBase::testRunStarting(testRunInfo);
+    path_ = TestContext::getEnvVar("HT_LEAK_CHECK");
+    if (path_.empty()) return;
+    auto& context = TestContext::get();
+    if (context.isSharded()) {
+      path_ += ".shard" + std::to_string(context.shardIndex());
+    }
+    deviceThreshold_ = envMb("HT_LEAK_THRESHOLD_MB", 2.0);
+    hostThreshold_ = envMb("HT_LEAK_HOST_THRESHOLD_MB", 16.0);
+  }
+
+  void testCaseStarting(Catch::TestCaseInfo const& testInfo) override {
+    TestEventListenerBase::testCaseStarting(testInfo);
+    if (path_.empty()) return;
+    before_ = sample();
+    if (!sampled_) {
+      first_ = before_;
+      sampled_ = true;
+    }
+  }
+
+  void testCaseEnded(Catch::TestCaseStats const& testCaseStats) override {
+    TestEventListenerBase::testCaseEnded(testCaseStats);
+    if (path_.empty()) return;
+
+    // Cached blocks are not a leak, drop them before the pool listener gets to it
+    hip::BufferPool::get().trim();
+    hip::PinnedPool::get().trim();
+    last_ = sample();
+    bool haveDevice = before_.deviceUsedMb >= 0 && last_.deviceUsedMb >= 0;
+    bool haveHost = before_.hostRssMb >= 0 && last_.hostRssMb >= 0;
+    double deviceDelta = haveDevice ? last_.deviceUsedMb - before_.deviceUsedMb : 0;
+    double hostDelta = haveHost ? last_.hostRssMb - before_.hostRssMb : 0;
+    bool flagged = deviceDelta > deviceThreshold_ || hostDelta > hostThreshold_;
+
+    const auto& name = testCaseStats.testInfo.name;
+    if (flagged) {
+      fprintf(stderr, "Memory growth in %s: device %+.1f MB, host rss %+.1f MB\n", name.c_str(),
+              deviceDelta, hostDelta);
+      flagged_.emplace_back(name, deviceDelta, hostDelta);
+    }
+    writeRow(name, deviceDelta, hostDelta, flagged);
+  }
+
+  void testRunEnded(Catch::TestRunStats const& testRunStats) override {
+    TestEventListenerBase::testRunEnded(testRunStats);
+    if (path_.empty() || !sampled_) return;
+
+    // Small per test leaks stay below the threshold but still add up over a run
+    fprintf(stderr, "Memory growth over the run: device %+.1f MB, host rss %+.1f MB\n",
+            last_.deviceUsedMb - first_.deviceUsedMb, last_.hostRssMb - first_.hostRssMb);
+    if (flagged_.empty()) return;
+    std::sort(flagged_.begin(), flagged_.end(),
+              [](const Flagged& a, const Flagged& b) { return a.device > b.device; });
+    fprintf(stderr, "%zu tests grew memory above the threshold:\n", flagged_.size());
+    for (const auto& entry : flagged_) {
+      fprintf(stderr, "  %s: device %+.1f MB, host rss %+.1f MB\n", entry.name.c_str(),
+              entry.device, entry.host);
+    }
+  }
+
+ private:
+  struct Flagged {
+    Flagged(std::string name_, double device_, double host_)
+        : name(std::move(name_)), device(device_), host(host_) {}
+    std::string name;
+    double device;
+    double host;
+  };
+
+  void writeRow(const std::string& name, double deviceDelta, double hostDelta, bool flagged) {
+    bool header = !std::ifstream(path_).good();
+    std::ofstream report(path_, std::ios::app);
+    if (!report.is_open()) {
+      std::cerr << "Unable to write leak check report: " << path_ << std::endl;
+      return;
+    }
+    if (header) {
+      report << "test,device_before_mb,device_after_mb,device_delta_mb,host_rss_before_mb,"
+                "host_rss_after_mb,host_rss_delta_mb,flagged\n";
+    }
+    std::string quoted = "\"";
+    for (char c : name) {
+      if (c == '"') quoted += '"';
+      quoted += c;
+    }
+    report.setf(std::ios::fixed);
+    report.precision(3);
+    report << quoted << "\"," << before_.deviceUsedMb << ',' << last_.deviceUsedMb << ','
+           << deviceDelta << ',' << before_.hostRssMb << ',' << last_.hostRssMb << ','
+           << hostDelta << ',' << (flagged ? 1 : 0) << '\n';
+  }
+
+  std::string path_;
+  double deviceThreshold_ = 0;
+  double hostThreshold_ = 0;
+  bool sampled_ = false;
+  MemorySample first_{};
+  MemorySample before_{};
+  MemorySample last_{};
+  std::vector<Flagged> flagged_;
+};
+}  // namespace
+
+CATCH_REGISTER_LISTENER(LeakCheckListener)
@@ -0,0 +1,226 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#define CATCH_CONFIG_EXTERNAL_INTERFACES
+#include <hip_test_common.hh>
+#include <hip_test_profiler.hh>
+#include <hip_test_tracer.hh>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "hip_test_filesystem.hh"
+
+namespace hip {
+std::map<std::string, ProfileEntry> TestProfiler::readReport(const std::string& path) {
+  std::map<std::string, ProfileEntry> entries;
+  std::ifstream report(path);
+  std::string line;
+  std::getline(report, line);  // header
+  while (std::getline(report, line)) {
+    // name,wall_ms,hip_api_ms,gpu_ms,passed with the name quoted if it needs to be
+    std::string name;
+    size_t pos = 0;
+    if (!line.empty() && line[0] == '"') {
+      for (pos = 1; pos < line.size(); pos++) {
+        if (line[pos] == '"') {
+          if (pos + 1 < line.size() && line[pos + 1] == '"') {
+            pos++;  // Unescape ""
+          } else {
+            pos++;
+            break;
+          }
+        }
+        name += line[pos];
+      }
+    } else {
+      pos = line.find(',');
+      if (pos == std::string::npos) continue;
+      name = line.substr(0, pos);
+    }
+    ProfileEntry entry;
+    int passed = 0;
+    char comma;
+    std::istringstream values(line.substr(pos));
+    if (values >> comma >> entry.wallMs >> comma >> entry.apiMs >> comma >> entry.gpuMs >>
+        comma >> passed) {
+      entry.passed = passed != 0;
+      entries[name] = entry;
+    }
+  }
+  return entries;
+}
+}  // namespace hip
+
+namespace {
+using hip::ProfileEntry;
+
+/*
+Catch listener behind HT_PROFILE. Results are merged with the entries already in the report
+file, so runs of single tests (as done by ctest) accumulate into one report. With sharding
+every shard writes <HT_PROFILE>.shard<index>.
+*/
+class ProfileListener : public Catch::TestEventListenerBase {
+ public:
+  using TestEventListenerBase::TestEventListenerBase;
+
+  void testCaseStarting(Catch::TestCaseInfo const& testInfo) override {
+    TestEventListenerBase::testCaseStarting(testInfo);
+    if (!hip::TestProfiler::enabled()) return;
+
+    // Events are created per test, a test can reset the device and invalidate them
+    eventsRecorded_ = hipEventCreate(&start_) == hipSuccess &&
+                      hipEventCreate(&stop_) == hipSuccess &&
+                      hipEventRecord(start_, nullptr) == hipSuccess;
+    hip::TestProfiler::apiTime() = 0;
+    wallStart_ = std::chrono::steady_clock::now();
+  }
+
+  void testCaseEnded(Catch::TestCaseStats const& testCaseStats) override {
+    TestEventListenerBase::testCaseEnded(testCaseStats);
+    if (!hip::TestProfiler::enabled()) return;
+
+    ProfileEntry entry;
+    entry.gpuMs = -1.0;
+    if (eventsRecorded_ && hipEventRecord(stop_, nullptr) == hipSuccess &&
+        hipEventSynchronize(stop_) == hipSuccess) {
+      float ms = 0;
+      if (hipEventElapsedTime(&ms, start_, stop_) == hipSuccess) entry.gpuMs = ms;
+    }
+    // Wall time includes waiting for the device work the test left behind
+    entry.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                             wallStart_)
+                       .count();
+    entry.apiMs = hip::TestProfiler::apiTime().load() / 1e6;
+    entry.passed = testCaseStats.totals.assertions.allOk();
+    static_cast<void>(hipEventDestroy(start_));
+    static_cast<void>(hipEventDestroy(stop_));
+    start_ = stop_ = nullptr;
+
+    entries_[testCaseStats.testInfo.name] = entry;
+  }
+
+  void testRunEnded(Catch::TestRunStats const& testRunStats) override {
+    TestEventListenerBase::testRunEnded(testRunStats);
+    if (!hip::TestProfiler::enabled() || entries_.empty()) return;
+
+    std::string path = TestContext::getEnvVar("HT_PROFILE");
+    auto& context = TestContext::get();
+    if (context.isSharded()) {
+      path += ".shard" + std::to_string(context.shardIndex());
+    }
+    auto entries = hip::TestProfiler::readReport(path);
+    for (auto& entry : entries_) {
+      entries[entry.first] = entry.second;
+    }
+    writeReport(path, entries);
+  }
+
+ private:
+  static std::string quote(const std::string& name) {
+    std::string quoted = "\"";
+    for (char c : name) {
+      if (c == '"') quoted += '"';
+      quoted += c;
+    }
+    return quoted + "\"";
+  }
+
+  static void writeReport(const std::string& path,
+                          const std::map<std::string, ProfileEntry>& entries) {
+    std::vector<std::pair<std::string, ProfileEntry>> sorted(entries.begin(), entries.end());
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+      return a.second.wallMs > b.second.wallMs;
+    });
+
+    // Write next to the report and rename, so a crash never leaves a truncated report
+    std::string tmpPath = path + ".tmp";
+    {
+      std::ofstream report(tmpPath);
+      if (!report.is_open()) {
+        std::cerr << "Unable to write profile report: " << path << std::endl;
+        return;
+      }
+      report << "test,wall_ms,hip_api_ms,gpu_ms,passed\n";
+      report.setf(std::ios::fixed);
+      report.precision(3);
+      for (const auto& entry : sorted) {
+        report << quote(entry.first) << ',' << entry.second.wallMs << ',' << entry.second.apiMs
+               << ',' << entry.second.gpuMs << ',' << (entry.second.passed ? 1 : 0) << '\n';
+      }
+    }
+    std::error_code error;
+    fs::rename(tmpPath, path, error);
+    if (error) {
+      std::cerr << "Unable to write profile report: " << path << std::endl;
+    }
+  }
+
+  hipEvent_t start_ = nullptr;
+  hipEvent_t stop_ = nullptr;
+  bool eventsRecorded_ = false;
+  std::chrono::steady_clock::time_point wallStart_;
+  std::map<std::string, ProfileEntry> entries_;
+};
+
+/*
+Catch listener behind HT_TRACE, see hip_test_tracer.hh. Every test case becomes a range in the
+trace. With sharding every shard writes <HT_TRACE>.shard<index>.
+*/
+class TraceListener : public Catch::TestEventListenerBase {
+ public:
+  using TestEventListenerBase::TestEventListenerBase;
+
+  void testRunStarting(Catch::TestRunInfo const& testRunInfo) override {
+    TestEventListenerBase::testRunStarting(testRunInfo);
+    path_ = TestContext::getEnvVar("HT_TRACE");
+    if (path_.empty()) return;
+    auto& context = TestContext::get();
+    if (context.isSharded()) {
+      path_ += ".shard" + std::to_string(context.shardIndex());
+    }
+    hip::ApiTracer::start();
+  }
+
+  void testCaseStarting(Catch::TestCaseInfo const& testInfo) override {
+    TestEventListenerBase::testCaseStarting(testInfo);
+    if (!path_.empty()) hip::ApiTracer::beginRange(testInfo.name);
+  }
+
+  void testCaseEnded(Catch::TestCaseStats const& testCaseStats) override {
+    TestEventListenerBase::testCaseEnded(testCaseStats);
+    if (!path_.empty()) hip::ApiTracer::endRange();
+  }
+
+  void testRunEnded(Catch::TestRunStats const& testRunStats) override {
+    TestEventListenerBase::testRunEnded(testRunStats);
+    // Written even when the callback was unavailable, so the test ranges are still there
+    if (!path_.empty()) hip::ApiTracer::stop(path_);
+  }
+
+ private:
+  std::string path_;
+};
+}  // namespace
+
+CATCH_REGISTER_LISTENER(ProfileListener)
+CATCH_REGISTER_LISTENER(TraceListener)
@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include <hip/hip_runtime.h>
+#include <hip_test_tracer.hh>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#if defined(__HIP_PLATFORM_AMD__) && defined(__linux__)
+#include <dlfcn.h>
+#include <unistd.h>
+#define HT_API_TRACING 1
+#endif
+
+namespace {
+struct TracedCall {
+  uint32_t cid;
+  uint64_t beginNs;
+  uint64_t endNs;
+};
+
+struct TracedRange {
+  std::string name;
+  uint32_t tid;
+  uint64_t beginNs;
+  uint64_t endNs;
+};
+
+constexpr uint32_t kMaxDepth = 16;  // Calls nested deeper are not recorded
+
+// Written only by its own thread. 'written' is published with release so stop() can read the
+// ring from another thread. Never freed, the calls of exited threads are written at stop().
+struct ThreadTrace {
+  uint32_t tid;
+  std::vector<TracedCall> calls;
+  std::atomic<uint64_t> written{0};
+  uint32_t depth = 0;
+  uint32_t openCid[kMaxDepth];
+  uint64_t openNs[kMaxDepth];
+  uint64_t rangeBeginNs = 0;
+  std::string rangeName;
+};
+
+std::mutex& traceMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<ThreadTrace*>& threadTraces() {
+  static std::vector<ThreadTrace*> traces;
+  return traces;
+}
+
+std::vector<TracedRange>& tracedRanges() {
+  static std::vector<TracedRange> ranges;
+  return ranges;
+}
+
+const std::chrono::steady_clock::time_point& traceStart() {
+  static const auto start = std::chrono::steady_clock::now();
+  return start;
+}
+
+uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                              traceStart())
+      .count();
+}
+
+size_t bufferSize() {
+  static const size_t size = [] {
+    const char* env = std::getenv("HT_TRACE_BUFFER");
+    long long value = env != nullptr ? std::atoll(env) : 0;
+    return value > 0 ? static_cast<size_t>(value) : size_t{65536};
+  }();
+  return size;
+}
+
+ThreadTrace& threadTrace() {
+  thread_local ThreadTrace* trace = nullptr;
+  if (trace == nullptr) {
+    trace = new ThreadTrace;
+    trace->calls.resize(bufferSize());
+    std::lock_guard<std::mutex> lock(traceMutex());
+    trace->tid = static_cast<uint32_t>(threadTraces().size());
+    threadTraces().push_back(trace);
+  }
+  return *trace;
+}
+
+#ifdef HT_API_TRACING
+// From roctracer's roctracer.h and roctracer_hip.h
+constexpr uint32_t kDomainHipApi = 3;  // ACTIVITY_DOMAIN_HIP_API
+constexpr uint32_t kPhaseEnter = 0;    // ACTIVITY_API_PHASE_ENTER
+typedef void (*ApiCallback)(uint32_t domain, uint32_t cid, const void* data, void* arg);
+
+// Leading members of hip_api_data_t, the arguments that follow depend on the API
+struct ApiDataHeader {
+  uint64_t correlationId;
+  uint32_t phase;
+};
+
+struct Roctracer {
+  int (*enableCallback)(uint32_t domain, ApiCallback callback, void* arg);
+  int (*disableCallback)(uint32_t domain);
+};
+
+const Roctracer* roctracer() {
+  static const Roctracer* loaded = []() -> const Roctracer* {
+    static Roctracer tracer;
+    for (const char* name : {"libroctracer64.so", "libroctracer64.so.4", "libroctracer64.so.1",
+                             "/opt/rocm/lib/libroctracer64.so"}) {
+      void* handle = dlopen(name, RTLD_NOW | RTLD_LOCAL);
+      if (handle == nullptr) continue;
+      tracer.enableCallback = reinterpret_cast<decltype(tracer.enableCallback)>(
+          dlsym(handle, "roctracer_enable_domain_callback"));
+      tracer.disableCallback = reinterpret_cast<decltype(tracer.disableCallback)>(
+          dlsym(handle, "roctracer_disable_domain_callback"));
+      if (tracer.enableCallback != nullptr && tracer.disableCallback != nullptr) {
+        return &tracer;
+      }
+    }
+    return nullptr;
+  }();
+  return loaded;
+}
+
+void apiCallback(uint32_t, uint32_t cid, const void* data, void*) {
+  uint64_t now = nowNs();
+  ThreadTrace& trace = threadTrace();
+  if (static_cast<const ApiDataHeader*>(data)->phase == kPhaseEnter) {
+    if (trace.depth < kMaxDepth) {
+      trace.openCid[trace.depth] = cid;
+      trace.openNs[trace.depth] = now;
+    }
+    trace.depth++;
+    return;
+  }
+  if (trace.depth == 0) return;  // Entered before tracing started
+  trace.depth--;
+  if (trace.depth >= kMaxDepth) return;
+
+  uint64_t index = trace.written.load(std::memory_order_relaxed);
+  trace.calls[index % trace.calls.size()] = {trace.openCid[trace.depth],
+                                             trace.openNs[trace.depth], now};
+  trace.written.store(index + 1, std::memory_order_release);
+}
+#endif
+
+const char* apiName(uint32_t cid) {
+#ifdef HT_API_TRACING
+  return hipApiName(cid);
+#else
+  return "unknown";
+#endif
+}
+
+std::string jsonEscape(const std::string& str) {
+  std::string out;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out += ' ';
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+}  // namespace
+
+namespace hip {
+bool ApiTracer::start() {
+#ifdef HT_API_TRACING
+  const Roctracer* tracer = roctracer();
+  if (tracer == nullptr) {
+    std::cerr << "HT_TRACE: libroctracer64 not found, HIP API calls are not traced" << std::endl;
+    return false;
+  }
+  traceStart();
+  if (tracer->enableCallback(kDomainHipApi, apiCallback, nullptr) != 0) {
+    std::cerr << "HT_TRACE: enabling the HIP API callback failed" << std::endl;
+    return false;
+  }
+  return true;
+#else
+  std::cerr << "HT_TRACE: HIP API tracing needs roctracer, AMD on Linux only" << std::endl;
+  return false;
+#endif
+}
+
+bool ApiTracer::stop(const std::string& path) {
+#ifdef HT_API_TRACING
+  if (roctracer() != nullptr) {
+    roctracer()->disableCallback(kDomainHipApi);
+  }
+  const long pid = getpid();
+#else
+  const long pid = 0;
+#endif
+
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    std::cerr << "Unable to write trace: " << path << std::endl;
+    return false;
+  }
+  out.setf(std::ios::fixed);
+  out.precision(3);
+
+  std::lock_guard<std::mutex> lock(traceMutex());
+  uint64_t dropped = 0;
+  const char* separator = "";
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  for (const ThreadTrace* trace : threadTraces()) {
+    uint64_t written = trace->written.load(std::memory_order_acquire);
+    uint64_t size = trace->calls.size();
+    uint64_t first = written > size ? written - size : 0;
+    dropped += first;
+    for (uint64_t i = first; i < written; i++) {
+      const TracedCall& call = trace->calls[i % size];
+      out << separator << "\n{\"name\":\"" << apiName(call.cid)
+          << "\",\"cat\":\"hip_api\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << trace->tid
+          << ",\"ts\":" << call.beginNs / 1e3 << ",\"dur\":" << (call.endNs - call.beginNs) / 1e3
+          << "}";
+      separator = ",";
+    }
+  }
+  for (const TracedRange& range : tracedRanges()) {
+    out << separator << "\n{\"name\":\"" << jsonEscape(range.name)
+        << "\",\"cat\":\"range\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << range.tid
+        << ",\"ts\":" << range.beginNs / 1e3 << ",\"dur\":" << (range.endNs - range.beginNs) / 1e3
+        << "}";
+    separator = ",";
+  }
+  out << "\n],\"otherData\":{\"dropped_calls\":" << dropped << "}}\n";
+  if (dropped != 0) {
+    std::cerr << "HT_TRACE: " << dropped
+              << " oldest calls were overwritten, raise HT_TRACE_BUFFER to keep them" << std::endl;
+  }
+  return out.good();
+}
+
+void ApiTracer::beginRange(const std::string& name) {
+  ThreadTrace& trace = threadTrace();
+  trace.rangeName = name;
+  trace.rangeBeginNs = nowNs();
+}
+
+void ApiTracer::endRange() {
+  ThreadTrace& trace = threadTrace();
+  TracedRange range{trace.rangeName, trace.tid, trace.rangeBeginNs, nowNs()};
+  std::lock_guard<std::mutex> lock(traceMutex());
+  tracedRanges().push_back(range);
+}
+}  // namespace hip
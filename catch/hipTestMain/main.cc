@@ -2,6 +2,74 @@
 #include <hip_test_common.hh>
 #include <iostream>
 
+// Escapes the characters Catch2's test spec parser would interpret in a test name
+static std::string escapeTestName(const std::string& name) {
+  std::string escaped;
+  for (const auto& c : name) {
+    if (c == '\\' || c == ',' || c == '[' || c == ']' || c == '"' || c == '~') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+// Restricts the session to this shard's part of the tests selected on the command line.
+// Returns false when the shard has nothing to run.
+static bool selectShard(Catch::Session& session, const TestContext& context) {
+  auto& config = session.config();
+  std::vector<std::string> names;
+  for (const auto& test :
+       Catch::filterTests(Catch::getAllTestCasesSorted(config), config.testSpec(), config)) {
+    names.push_back(test.name);
+  }
+
+  auto shard = context.shardTests(names);
+  std::cerr << "Shard " << context.shardIndex() << "/" << context.shardCount() << ": running "
+            << shard.size() << " of " << names.size() << " tests" << std::endl;
+  if (shard.empty()) return false;
+
+  // Separate test specs are ANDed by Catch, comma separated names within one spec are ORed
+  std::string spec;
+  for (const auto& name : shard) {
+    if (!spec.empty()) spec += ',';
+    spec += escapeTestName(name);
+  }
+  Catch::ConfigData data = session.configData();
+  data.testsOrTags = {spec};
+  session.useConfigData(data);
+  return true;
+}
+
+/*
+Test server mode, enabled by HT_TEST_SERVER. The process keeps the HIP runtime initialized and
+runs tests on request: every line read from stdin is a test spec, optionally preceded by a
+report file and a tab, and is run with the options given on the command line. Once the run is
+done "HT_SERVER_DONE <failed>" is printed on its own line. Ends on end of input or "quit".
+*/
+static int serveTests(Catch::Session& session) {
+  const Catch::ConfigData base = session.configData();
+  std::cout << "HT_SERVER_READY" << std::endl;
+  std::string request;
+  while (std::getline(std::cin, request)) {
+    if (request.empty()) continue;
+    if (request == "quit") break;
+    Catch::ConfigData data = base;
+    auto tab = request.find('\t');
+    if (tab != std::string::npos) {
+      data.outputFilename = request.substr(0, tab);
+      request = request.substr(tab + 1);
+    }
+    data.testsOrTags = {request};
+    session.useConfigData(data);
+    int failed = session.run();
+    std::cout << std::flush;
+    std::cerr << std::flush;
+    std::cout << "HT_SERVER_DONE " << failed << std::endl;
+  }
+  return 0;
+}
+
 int main(int argc, char** argv) {
   auto& context = TestContext::get(argc, argv);
   if (context.skipTest()) {
@@ -9,8 +77,21 @@ int main(int argc, char** argv) {
     std::cout << "HIP_SKIP_THIS_TEST" << std::endl;
     return 0;
   }
-  int out = Catch::Session().run(argc, argv);
+  Catch::Session session;
+  int out = session.applyCommandLine(argc, argv);
+  if (out != 0) return out;
+
+  // A test server picks its tests on request, shards of a server run share one queue
+  bool server = !TestContext::getEnvVar("HT_TEST_SERVER").empty();
+  if (!server && context.isSharded() && !selectShard(session, context)) {
+    return 0;
+  }
+#ifdef RTC_TESTING
+  if (!TestContext::getEnvVar("HT_RTC_PRECOMPILE").empty()) {
+    HipTest::precompileRTCKernels(rtcPrecompileExpressions);
+  }
+#endif
+  out = server ? serveTests(session) : session.run();
   TestContext::get().cleanContext();
   return out;
-  
 }
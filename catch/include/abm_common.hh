@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#pragma once
+#include <hip_test_common.hh>
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/*
+Shared helpers of the ABM microkernel tests, which model the compute kernels of common
+applications (GEMV, stencil, SpMV, scan, histogram, sort). Every test first checks its
+kernel against a host reference, then times it and prints one line with the time per run and
+the achieved throughput, so the same binary doubles as a small application benchmark:
+
+  ABM gemv<float> 4096: 1.234 ms, 54.4 GB/s, 27.2 GFLOP/s
+*/
+namespace abm {
+constexpr int kTimedRuns = 10;
+
+template <typename T> const char* typeName() { return "unknown"; }
+template <> inline const char* typeName<unsigned char>() { return "uchar"; }
+template <> inline const char* typeName<int>() { return "int"; }
+template <> inline const char* typeName<unsigned int>() { return "uint"; }
+template <> inline const char* typeName<long>() { return "long"; }
+template <> inline const char* typeName<long long>() { return "long long"; }
+template <> inline const char* typeName<float>() { return "float"; }
+template <> inline const char* typeName<double>() { return "double"; }
+
+// Milliseconds per call of launch, which enqueues one run on the null stream. The first
+// call is a warm up and not timed.
+template <typename F> float timeRuns(F&& launch, int runs = kTimedRuns) {
+  launch();
+  HIP_CHECK(hipGetLastError());
+  HIP_CHECK(hipDeviceSynchronize());
+
+  hipEvent_t start, stop;
+  HIP_CHECK(hipEventCreate(&start));
+  HIP_CHECK(hipEventCreate(&stop));
+  HIP_CHECK(hipEventRecord(start, nullptr));
+  for (int i = 0; i < runs; i++) {
+    launch();
+  }
+  HIP_CHECK(hipGetLastError());
+  HIP_CHECK(hipEventRecord(stop, nullptr));
+  HIP_CHECK(hipEventSynchronize(stop));
+  float ms = 0;
+  HIP_CHECK(hipEventElapsedTime(&ms, start, stop));
+  HIP_CHECK(hipEventDestroy(start));
+  HIP_CHECK(hipEventDestroy(stop));
+  return ms / runs;
+}
+
+/**
+ * @brief Prints the throughput of one run
+ * @param kernel kernel name
+ * @param size problem size shown in the report
+ * @param ms time per run
+ * @param bytes minimum number of bytes a run has to move to and from device memory
+ * @param ops work done by a run, counted in opUnit
+ */
+template <typename T>
+void report(const std::string& kernel, size_t size, float ms, double bytes, double ops,
+            const char* opUnit = "FLOP") {
+  double seconds = ms / 1e3;
+  std::ios state(nullptr);
+  state.copyfmt(std::cout);
+  std::cout << std::fixed << std::setprecision(3) << "ABM " << kernel << '<' << typeName<T>()
+            << "> " << size << ": " << ms << " ms, " << std::setprecision(1)
+            << bytes / seconds / 1e9 << " GB/s, " << ops / seconds / 1e9 << " G" << opUnit
+            << "/s" << std::endl;
+  std::cout.copyfmt(state);
+}
+
+inline unsigned int blocksFor(size_t size, unsigned int blockSize) {
+  return static_cast<unsigned int>((size + blockSize - 1) / blockSize);
+}
+}  // namespace abm
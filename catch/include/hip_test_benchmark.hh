@@ -0,0 +1,96 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+#include "hip_test_common.hh"
+
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace hip {
+/*
+Catch2 benchmarks with device time included. Catch times every sample on the host clock, so
+HIP_BENCHMARK synchronizes the given stream after every run of the body:
+
+  HIP_BENCHMARK("hipGraphLaunch", stream) {
+    HIP_CHECK(hipGraphLaunch(graphExec, stream));
+  };
+  REQUIRE(hip::BenchmarkResult::last().medianUs < 100);
+
+The listener in hipTestMain/hip_test_benchmark.cc keeps the statistics of the last benchmark
+for such assertions and, with HT_BENCHMARK_JSON set to a file, appends one record per
+benchmark in the perftests json format. Benchmarks are skipped with --skip-benchmarks.
+*/
+struct BenchmarkResult {
+  std::string test;  // TEST_CASE the benchmark ran in
+  std::string name;
+  int samples;
+  int iterations;  // per sample
+  double minUs, medianUs, p90Us, p99Us, maxUs, meanUs, stddevUs;  // per iteration
+
+  // Statistics of the benchmark that finished last, all zero before the first one
+  static BenchmarkResult& last() {
+    static BenchmarkResult last_{};
+    return last_;
+  }
+};
+
+namespace detail {
+template <typename F> class StreamSyncedBenchmark {
+ public:
+  StreamSyncedBenchmark(hipStream_t stream, F body) : stream_(stream), body_(std::move(body)) {}
+
+  // Taking the run index keeps Catch from treating the body as an advanced benchmark
+  auto operator()(int index) const {
+    if constexpr (std::is_void_v<decltype(body_(index))>) {
+      body_(index);
+      HIP_CHECK(hipStreamSynchronize(stream_));
+    } else {
+      auto result = body_(index);
+      HIP_CHECK(hipStreamSynchronize(stream_));
+      return result;
+    }
+  }
+
+ private:
+  hipStream_t stream_;
+  F body_;
+};
+
+struct StreamSync {
+  hipStream_t stream;
+
+  template <typename F> StreamSyncedBenchmark<F> operator<<(F body) const {
+    return StreamSyncedBenchmark<F>(stream, std::move(body));
+  }
+};
+}  // namespace detail
+}  // namespace hip
+
+#define HIP_BENCHMARK_IMPL(BenchmarkName, name, stream)                                            \
+  if (Catch::Benchmark::Benchmark BenchmarkName{name})                                             \
+  BenchmarkName = hip::detail::StreamSync{stream} << [&](int)
+
+// Catch2 BENCHMARK whose samples wait for the work the body queued on stream
+#define HIP_BENCHMARK(name, stream)                                                                \
+  HIP_BENCHMARK_IMPL(INTERNAL_CATCH_UNIQUE_NAME(hipBenchmark), name, stream)
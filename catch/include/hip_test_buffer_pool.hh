@@ -0,0 +1,188 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#pragma once
+#include <hip_test_common.hh>
+#include <hip_test_pinned_pool.hh>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace hip {
+/*
+Size class cache of hipMalloc/hipHostMalloc/hipMallocManaged blocks for LinearAllocGuard.
+
+Tests that allocate the same buffers for every GENERATE permutation or SECTION, but do not
+test allocation itself, can create a PooledAllocations object at the top of the TEST_CASE.
+While one is alive, LinearAllocGuard takes its hipMalloc, hipHostMalloc and
+hipMallocManaged blocks from the pool and returns them on destruction instead of freeing
+them. Blocks are keyed by allocation kind, flags, device and size class and are poisoned
+with kPoisonByte on every hand out, so a test can not depend on what a previous permutation
+left behind. The listener in hipTestMain/hip_test_buffer_pool.cc frees all cached blocks at
+the end of every test case; pinned host blocks go back to hip::PinnedPool instead, so they
+stay pinned for the next test case.
+
+Tests that reset the device between sections must not use the pool. Setting
+HT_BUFFER_POOL_DISABLE makes PooledAllocations a no-op, to compare against plain allocations.
+*/
+enum class PoolMemory { device, pinnedHost, managed };
+
+class BufferPool {
+ public:
+  static constexpr unsigned char kPoisonByte = 0xA5;
+
+  static BufferPool& get() {
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+  }
+
+  // True while a PooledAllocations object is alive
+  static bool active() { return users().load() > 0; }
+
+  static std::atomic<int>& users() {
+    static std::atomic<int> users_{0};
+    return users_;
+  }
+
+  /**
+   * @brief Returns a poisoned block of at least size bytes, allocated on the current device
+   * @param kind allocation API the block has to come from
+   * @param size requested size in bytes
+   * @param flags flags passed to hipHostMalloc/hipMallocManaged, part of the cache key
+   */
+  void* acquire(PoolMemory kind, size_t size, unsigned int flags = 0u) {
+    int device = 0;
+    HIP_CHECK(hipGetDevice(&device));
+    Key key{kind, flags, device, sizeClass(size)};
+
+    void* ptr = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& blocks = free_[key];
+      if (!blocks.empty()) {
+        ptr = blocks.back();
+        blocks.pop_back();
+      }
+    }
+    if (ptr == nullptr) {
+      ptr = allocate(key);
+    }
+    // Stream ordered on the null stream, so it runs after work still using the block
+    HIP_CHECK(hipMemset(ptr, kPoisonByte, std::get<3>(key)));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    used_.emplace(ptr, key);
+    return ptr;
+  }
+
+  // Returns a block obtained from acquire() to the cache
+  void release(void* ptr) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = used_.find(ptr);
+    if (it == used_.end()) return;
+    free_[it->second].push_back(ptr);
+    used_.erase(it);
+  }
+
+  // Frees all cached blocks, blocks still in use stay owned by their guards
+  void trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : free_) {
+      for (auto ptr : entry.second) {
+        // No Catch macros, trim also runs from the test case listener
+        if (std::get<0>(entry.first) == PoolMemory::pinnedHost) {
+          PinnedPool::get().release(ptr);
+        } else {
+          static_cast<void>(hipFree(ptr));
+        }
+      }
+    }
+    free_.clear();
+  }
+
+ private:
+  // kind, flags, device, size class in bytes
+  using Key = std::tuple<PoolMemory, unsigned int, int, size_t>;
+
+  // Never destroyed, the runtime may already be torn down when statics are
+  BufferPool() = default;
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  // Powers of two up to 1 MiB, multiples of 1 MiB above
+  static size_t sizeClass(size_t size) {
+    constexpr size_t kMiB = 1024 * 1024;
+    if (size > kMiB) return (size + kMiB - 1) / kMiB * kMiB;
+    size_t cls = 256;
+    while (cls < size) cls <<= 1;
+    return cls;
+  }
+
+  hipError_t allocateRaw(const Key& key, void** ptr) {
+    switch (std::get<0>(key)) {
+      case PoolMemory::pinnedHost:
+        return PinnedPool::get().acquire(ptr, std::get<3>(key), std::get<1>(key));
+      case PoolMemory::managed:
+        return hipMallocManaged(ptr, std::get<3>(key), std::get<1>(key) ? std::get<1>(key) : 1u);
+      case PoolMemory::device:
+      default:
+        return hipMalloc(ptr, std::get<3>(key));
+    }
+  }
+
+  void* allocate(const Key& key) {
+    void* ptr = nullptr;
+    if (allocateRaw(key, &ptr) == hipSuccess) return ptr;
+    // Cached blocks of other size classes may be what is missing, retry once without them
+    static_cast<void>(hipGetLastError());
+    trim();
+    HIP_CHECK(allocateRaw(key, &ptr));
+    return ptr;
+  }
+
+  std::mutex mutex_;
+  std::map<Key, std::vector<void*>> free_;
+  std::unordered_map<void*, Key> used_;
+};
+
+// Routes LinearAllocGuard allocations through BufferPool for its lifetime
+class PooledAllocations {
+ public:
+  PooledAllocations() : enabled_{TestContext::getEnvVar("HT_BUFFER_POOL_DISABLE").empty()} {
+    if (enabled_) ++BufferPool::users();
+  }
+  ~PooledAllocations() {
+    if (enabled_) --BufferPool::users();
+  }
+
+  PooledAllocations(const PooledAllocations&) = delete;
+  PooledAllocations(PooledAllocations&&) = delete;
+
+ private:
+  const bool enabled_;
+};
+}  // namespace hip
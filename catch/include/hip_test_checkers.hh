@@ -26,6 +26,7 @@ THE SOFTWARE.
 #include <fstream>
 #include <regex>
 #include <type_traits>
+#include <vector>
 #define TOL 0.001
 #define guarantee(cond, str)                                                                       \
   {                                                                                                \
@@ -119,26 +120,127 @@ void checkTest(T* expected_H, T* result_H, size_t N, bool expectMatch = true) {
 
 // Setters and Memory Management
 
+// Buffers from this many elements on are initialized by several host threads
+inline constexpr size_t kParallelInitElements = 1 << 20;
+
+// Calls f(i) for i in [0, n), split over up to 16 host threads for large n. f must not use
+// Catch assertions, they are not thread safe.
+template <typename F> void parallelFor(size_t n, F f) {
+  const size_t threads = std::min<size_t>(16, std::thread::hardware_concurrency());
+  if (n < kParallelInitElements || threads < 2) {
+    for (size_t i = 0; i < n; i++) f(i);
+    return;
+  }
+  const size_t chunk = (n + threads - 1) / threads;
+  auto run = [&f, n, chunk](size_t begin) {
+    for (size_t i = begin; i < std::min(n, begin + chunk); i++) f(i);
+  };
+  std::vector<std::thread> workers;
+  for (size_t begin = chunk; begin < n; begin += chunk) {
+    workers.emplace_back(run, begin);
+  }
+  run(0);
+  for (auto& worker : workers) worker.join();
+}
+
+// Value setDefaultData stores at index i of A (array 0), B (1) or C (2)
+template <typename T> __host__ __device__ inline T defaultDataValue(int array, size_t i) {
+  if constexpr (std::is_same<T, int>::value || std::is_same<T, unsigned int>::value) {
+    return static_cast<T>(3 + array);
+  } else if constexpr (std::is_same<T, char>::value || std::is_same<T, unsigned char>::value) {
+    return static_cast<T>('a' + array);
+  } else {
+    return array == 0 ? 3.146f + i : array == 1 ? 1.618f + i : 1.4f + i;
+  }
+}
+
 template <typename T> void setDefaultData(size_t numElements, T* A_h, T* B_h, T* C_h) {
   // Initialize the host data:
+  parallelFor(numElements, [=](size_t i) {
+    if (A_h) A_h[i] = defaultDataValue<T>(0, i);
+    if (B_h) B_h[i] = defaultDataValue<T>(1, i);
+    if (C_h) C_h[i] = defaultDataValue<T>(2, i);
+  });
+}
 
-  for (size_t i = 0; i < numElements; i++) {
-    if (std::is_same<T, int>::value || std::is_same<T, unsigned int>::value) {
-      if (A_h) A_h[i] = 3;
-      if (B_h) B_h[i] = 4;
-      if (C_h) C_h[i] = 5;
-    } else if (std::is_same<T, char>::value || std::is_same<T, unsigned char>::value) {
-      if (A_h) A_h[i] = 'a';
-      if (B_h) B_h[i] = 'b';
-      if (C_h) C_h[i] = 'c';
-    } else {
-      if (A_h) A_h[i] = 3.146f + i;
-      if (B_h) B_h[i] = 1.618f + i;
-      if (C_h) C_h[i] = 1.4f + i;
-    }
+template <typename T>
+__global__ void setDefaultDataKernel(T* A_d, T* B_d, T* C_d, size_t numElements) {
+  size_t offset = (blockIdx.x * blockDim.x + threadIdx.x);
+  size_t stride = blockDim.x * gridDim.x;
+
+  for (size_t i = offset; i < numElements; i += stride) {
+    if (A_d) A_d[i] = defaultDataValue<T>(0, i);
+    if (B_d) B_d[i] = defaultDataValue<T>(1, i);
+    if (C_d) C_d[i] = defaultDataValue<T>(2, i);
   }
 }
 
+// Grid for the initialization kernels, enough blocks to fill the device
+inline unsigned int initBlockCount(size_t numElements, unsigned int threadsPerBlock) {
+  return static_cast<unsigned int>(std::max<size_t>(
+      1, std::min<size_t>((numElements + threadsPerBlock - 1) / threadsPerBlock, 4096)));
+}
+
+// setDefaultData for device accessible memory, written by a kernel queued on stream instead
+// of being filled on the host and copied
+template <typename T>
+void setDefaultDataDevice(size_t numElements, T* A_d, T* B_d, T* C_d,
+                          hipStream_t stream = nullptr) {
+  constexpr unsigned int threadsPerBlock = 256;
+  setDefaultDataKernel<<<initBlockCount(numElements, threadsPerBlock), threadsPerBlock, 0,
+                         stream>>>(A_d, B_d, C_d, numElements);
+  HIP_CHECK(hipGetLastError());
+}
+
+// Counter based random numbers (SplitMix64 of seed and index): element index of a buffer
+// filled with seed gets the same value on the host and on the device, in any order, so
+// large buffers can be filled in parallel and expected values recomputed for any element.
+__host__ __device__ inline uint64_t counterRandom(uint64_t seed, uint64_t index) {
+  uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ull;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+// counterRandom mapped to [low, high), high > low
+template <typename T>
+__host__ __device__ inline T counterRandomValue(uint64_t seed, uint64_t index, T low, T high) {
+  const uint64_t bits = counterRandom(seed, index);
+  if constexpr (std::is_integral<T>::value) {
+    return static_cast<T>(low + static_cast<T>(bits % static_cast<uint64_t>(high - low)));
+  } else {
+    const double unit = (bits >> 11) * (1.0 / 9007199254740992.0);  // 53 bits in [0, 1)
+    return static_cast<T>(low + (high - low) * unit);
+  }
+}
+
+// Fills host memory with counterRandomValue(seed, i, low, high), in parallel for large buffers
+template <typename T>
+void fillRandomHost(T* ptr, size_t numElements, T low, T high, uint64_t seed) {
+  parallelFor(numElements,
+              [=](size_t i) { ptr[i] = counterRandomValue<T>(seed, i, low, high); });
+}
+
+template <typename T>
+__global__ void fillRandomKernel(T* ptr, size_t numElements, T low, T high, uint64_t seed) {
+  size_t offset = (blockIdx.x * blockDim.x + threadIdx.x);
+  size_t stride = blockDim.x * gridDim.x;
+
+  for (size_t i = offset; i < numElements; i += stride) {
+    ptr[i] = counterRandomValue<T>(seed, i, low, high);
+  }
+}
+
+// fillRandomHost for device accessible memory, the same values written by a kernel on stream
+template <typename T>
+void fillRandomDevice(T* ptr, size_t numElements, T low, T high, uint64_t seed,
+                      hipStream_t stream = nullptr) {
+  constexpr unsigned int threadsPerBlock = 256;
+  fillRandomKernel<<<initBlockCount(numElements, threadsPerBlock), threadsPerBlock, 0, stream>>>(
+      ptr, numElements, low, high, seed);
+  HIP_CHECK(hipGetLastError());
+}
+
 template <typename T>
 bool initArraysForHost(T** A_h, T** B_h, T** C_h, size_t N, bool usePinnedHost = false) {
   size_t Nbytes = N * sizeof(T);
@@ -195,22 +297,11 @@ bool initArrays(T** A_d, T** B_d, T** C_d, T** A_h, T** B_h, T** C_h, size_t N,
 // Threaded version of setDefaultData to be called from multi thread tests
 // Call HIP_CHECK_THREAD_FINALIZE after joining
 template <typename T> void setDefaultDataT(size_t numElements, T* A_h, T* B_h, T* C_h) {
-  // Initialize the host data:
-
+  // Initialize the host data, on the calling thread only
   for (size_t i = 0; i < numElements; i++) {
-    if (std::is_same<T, int>::value || std::is_same<T, unsigned int>::value) {
-      if (A_h) A_h[i] = 3;
-      if (B_h) B_h[i] = 4;
-      if (C_h) C_h[i] = 5;
-    } else if (std::is_same<T, char>::value || std::is_same<T, unsigned char>::value) {
-      if (A_h) A_h[i] = 'a';
-      if (B_h) B_h[i] = 'b';
-      if (C_h) C_h[i] = 'c';
-    } else {
-      if (A_h) A_h[i] = 3.146f + i;
-      if (B_h) B_h[i] = 1.618f + i;
-      if (C_h) C_h[i] = 1.4f + i;
-    }
+    if (A_h) A_h[i] = defaultDataValue<T>(0, i);
+    if (B_h) B_h[i] = defaultDataValue<T>(1, i);
+    if (C_h) C_h[i] = defaultDataValue<T>(2, i);
   }
 }
 
@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+#include <hip_test_common.hh>
+
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace hip {
+/*
+Parameter combinations for a single GENERATE, so the coverage mode decides how many of them
+run instead of nested GENERATEs always running the full Cartesian product:
+
+  const auto [size, src_device, dst_device] = GENERATE_COPY(from_range(
+      hip::Combinations(sizes, hip::Range(0, device_count), hip::Range(0, device_count))));
+
+By default every combination is returned, first parameter varying slowest as with nested
+GENERATEs. With HT_COVERAGE=pairwise only a covering subset is returned: every pair of values
+of any two parameters appears in at least one combination. The subset is built greedily and
+deterministically, so every run and every shard sees the same combinations.
+*/
+
+// True when HT_COVERAGE selects pairwise coverage
+bool PairwiseCoverage();
+
+/**
+ * @brief Selects combinations of parameter value indices
+ * @param sizes number of values of every parameter
+ * @param pairwise return a pairwise covering subset instead of the full product
+ * @return one index per parameter for every selected combination
+ */
+std::vector<std::vector<size_t>> CombinationIndices(const std::vector<size_t>& sizes,
+                                                    bool pairwise);
+
+namespace detail {
+template <typename... Ts, size_t... Is>
+std::tuple<Ts...> PickCombination(const std::vector<size_t>& indices, std::index_sequence<Is...>,
+                                  const std::vector<Ts>&... values) {
+  return std::tuple<Ts...>(values[indices[Is]]...);
+}
+}  // namespace detail
+
+// Values begin to end - 1, the parameter counterpart of Catch's range generator
+inline std::vector<int> Range(const int begin, const int end) {
+  std::vector<int> values(end > begin ? end - begin : 0);
+  std::iota(values.begin(), values.end(), begin);
+  return values;
+}
+
+// Combinations of the given parameter values selected by the current coverage mode
+template <typename... Ts>
+std::vector<std::tuple<Ts...>> Combinations(const std::vector<Ts>&... values) {
+  std::vector<std::tuple<Ts...>> combinations;
+  for (const auto& indices : CombinationIndices({values.size()...}, PairwiseCoverage())) {
+    combinations.push_back(
+        detail::PickCombination(indices, std::index_sequence_for<Ts...>{}, values...));
+  }
+  return combinations;
+}
+}  // namespace hip
@@ -22,6 +22,7 @@ THE SOFTWARE.
 
 #pragma once
 #include "hip_test_context.hh"
+#include "hip_test_profiler.hh"
 
 #include <catch.hpp>
 #include <atomic>
@@ -33,12 +34,18 @@ THE SOFTWARE.
 #include <cstdlib>
 #include <thread>
 
+#ifdef RTC_TESTING
+#include "hip_test_rtc.hh"
+#endif
+
 #define HIP_PRINT_STATUS(status) INFO(hipGetErrorName(status) << " at line: " << __LINE__);
 
 // Not thread-safe
 #define HIP_CHECK(error)                                                                           \
   {                                                                                                \
-    hipError_t localError = error;                                                                 \
+    hip::ApiTimer apiTimer;                                                                        \
+    hipError_t localError = (error);                                                               \
+    apiTimer.stop();                                                                               \
     if ((localError != hipSuccess) && (localError != hipErrorPeerAccessAlreadyEnabled)) {          \
       INFO("Error: " << hipGetErrorString(localError) << "\n    Code: " << localError              \
                      << "\n    Str: " << #error << "\n    In File: " << __FILE__                   \
@@ -54,9 +61,14 @@ THE SOFTWARE.
     if (TestContext::get().hasErrorOccured() == true) {                                            \
       return; /*This will only work with std::thread and not with std::async*/                     \
     }                                                                                              \
-    auto localError = error;                                                                       \
-    HCResult result(__LINE__, __FILE__, localError, #error);                                       \
-    TestContext::get().addResults(result);                                                         \
+    hip::ApiTimer apiTimer;                                                                        \
+    auto localError = (error);                                                                     \
+    apiTimer.stop();                                                                               \
+    /*Only failures take the results lock, passing checks cost nothing beyond the call*/           \
+    if (!HCResult::passes(localError)) {                                                           \
+      HCResult result(__LINE__, __FILE__, localError, #error);                                     \
+      TestContext::get().addResults(result);                                                       \
+    }                                                                                              \
   }
 
 #define REQUIRE_THREAD(condition)                                                                  \
@@ -65,20 +77,44 @@ THE SOFTWARE.
     if (TestContext::get().hasErrorOccured() == true) {                                            \
       return; /*This will only work with std::thread and not with std::async*/                     \
     }                                                                                              \
-    auto localResult = (condition);                                                                \
-    HCResult result(__LINE__, __FILE__, hipSuccess, #condition, localResult);                      \
-    TestContext::get().addResults(result);                                                         \
+    bool localResult = static_cast<bool>(condition);                                               \
+    if (!localResult) {                                                                            \
+      HCResult result(__LINE__, __FILE__, hipSuccess, #condition, localResult);                    \
+      TestContext::get().addResults(result);                                                       \
+    }                                                                                              \
   }
 
 // Do not call before all threads have joined
 #define HIP_CHECK_THREAD_FINALIZE()                                                                \
   { TestContext::get().finalizeResults(); }
 
+// Deferred HIP_CHECKs for hot loops, from any thread. A passing check costs a compare, failures
+// bump a counter and only the first one of each thread is recorded, unlike HIP_CHECK_THREAD
+// there is no early return. Report them with HIP_CHECK_DEFERRED_FINALIZE once threads joined.
+#define HIP_CHECK_DEFERRED(error)                                                                  \
+  {                                                                                                \
+    hip::ApiTimer apiTimer;                                                                        \
+    hipError_t localError = (error);                                                               \
+    apiTimer.stop();                                                                               \
+    if (!HCResult::passes(localError)) {                                                           \
+      TestContext::get().addDeferredResult(__LINE__, __FILE__, localError, #error);                \
+    }                                                                                              \
+  }
+
+// True once a deferred check failed, lets loops stop early
+#define HIP_CHECK_DEFERRED_FAILED() (TestContext::get().deferredFailed())
+
+// Do not call before all threads have joined
+#define HIP_CHECK_DEFERRED_FINALIZE()                                                              \
+  { TestContext::get().finalizeDeferred(); }
+
 
 // Check that an expression, errorExpr, evaluates to the expected error_t, expectedError.
 #define HIP_CHECK_ERROR(errorExpr, expectedError)                                                  \
   {                                                                                                \
-    hipError_t localError = errorExpr;                                                             \
+    hip::ApiTimer apiTimer;                                                                        \
+    hipError_t localError = (errorExpr);                                                           \
+    apiTimer.stop();                                                                               \
     INFO("Matching Errors: "                                                                       \
          << "\n    Expected Error: " << hipGetErrorString(expectedError)                           \
          << "\n    Expected Code: " << expectedError << '\n'                                       \
@@ -25,7 +25,10 @@ THE SOFTWARE.
 #include <hip/hiprtc.h>
 
 #include <atomic>
+#include <functional>
+#include <future>
 #include <mutex>
+#include <regex>
 #include <vector>
 #include <iostream>
 #include <string>
@@ -69,6 +72,11 @@ struct HCResult {
   bool conditionsResult;  // If bool condition, result of call. For HIP Calls its true
   HCResult(size_t l, std::string f, hipError_t r, std::string c, bool b = true)
       : line(l), file(f), result(r), call(c), conditionsResult(b) {}
+
+  // Same acceptance as HIP_CHECK. Checks that pass are never recorded.
+  static bool passes(hipError_t r, bool b = true) {
+    return b && ((r == hipSuccess) || (r == hipErrorPeerAccessAlreadyEnabled));
+  }
 };
 
 
@@ -78,17 +86,28 @@ class TestContext {
   std::string exe_path;
   std::string current_test;
   std::set<std::string> skip_test;
+  // skip_test compiled on first use, building std::regex is expensive
+  mutable std::vector<std::regex> skip_regex_;
+  mutable std::once_flag skip_regex_once_;
   std::string json_file_;
+  std::string config_dir_;
   std::vector<std::string> platform_list_ = {"amd", "nvidia"};
   std::vector<std::string> os_list_ = {"windows", "linux", "all"};
   std::vector<std::string> amd_arch_list_ = {};
 
+  // Sharding: HT_SHARD_INDEX/HT_SHARD_COUNT select this process' part of the tests,
+  // HT_SHARD_DEVICES lists the devices that shards are distributed over
+  unsigned int shard_index_ = 0;
+  unsigned int shard_count_ = 1;
+
   struct rtcState {
     hipModule_t module;
     hipFunction_t kernelFunction;
   };
 
-  std::unordered_map<std::string, rtcState> compiledKernels{};
+  // One shared future per name expression, so each kernel is compiled once
+  std::mutex rtcMutex;
+  std::unordered_map<std::string, std::shared_future<rtcState>> compiledKernels{};
 
   Config config_;
   std::string& getCommonJsonFile();
@@ -98,7 +117,12 @@ class TestContext {
   void getConfigFiles();
   void setExePath(int, char**);
   void parseOptions(int, char**);
+  void parseShardOptions();
+  void assignShardDevice();
   bool parseJsonFiles();
+  std::string configCachePath() const;
+  bool loadConfigCache();
+  void storeConfigCache() const;
   std::string getMatchingConfigFile(std::string config_dir);
   const Config& getConfig() const { return config_; }
 
@@ -107,9 +131,14 @@ class TestContext {
 
   // Multi threaded checks helpers
   std::mutex resultMutex;
-  std::vector<HCResult> results;  // Multi threaded test results buffer
+  std::vector<HCResult> results;  // Failed multi threaded checks, passing ones are not kept
   std::atomic<bool> hasErrorOccured_{false};
 
+  // Deferred checks helpers, deferredResults is guarded by resultMutex
+  std::vector<HCResult> deferredResults;  // First failed deferred check of every thread
+  std::atomic<size_t> deferredFailures_{0};  // All failed deferred checks, recorded or not
+  std::atomic<unsigned int> deferredEpoch_{1};  // Bumped by finalizeDeferred
+
  public:
   static TestContext& get(int argc = 0, char** argv = nullptr) {
     static TestContext instance(argc, argv);
@@ -141,15 +170,36 @@ class TestContext {
   bool isNvidia() const;
   bool isAmd() const;
   bool skipTest() const;
+  bool isDisabled(const std::string& test_name) const;  // Matches the config's DisabledTests
+
+  bool isSharded() const { return shard_count_ > 1; }
+  unsigned int shardIndex() const { return shard_index_; }
+  unsigned int shardCount() const { return shard_count_; }
+  /**
+   * @brief Selects the tests this shard runs.
+   *
+   * @param test_names All tests matching the command line.
+   * @return The enabled tests of this shard: every shard_count'th test by name, or with
+   * HT_SHARD_DURATIONS set, a longest-first bin packing on the durations in that report.
+   */
+  std::vector<std::string> shardTests(std::vector<std::string> test_names) const;
 
   const std::string& getCurrentTest() const { return current_test; }
   std::string currentPath() const;
 
   // Multi threaded results helpers
-  void addResults(HCResult r);  // Add multi threaded results
+  void addResults(HCResult r);  // Add a multi threaded result, only failures are kept
   void finalizeResults();       // Validate on all results
   bool hasErrorOccured();       // Query if error has occured
 
+  // Deferred results helpers, see HIP_CHECK_DEFERRED
+  // Counts a failure, the calling thread's first one since the last finalize is recorded
+  void addDeferredResult(size_t line, const char* file, hipError_t result, const char* call);
+  void finalizeDeferred();  // Fails the test on the recorded failures, then resets them
+  bool deferredFailed() const {  // Query if a deferred check failed since the last finalize
+    return deferredFailures_.load(std::memory_order_relaxed) != 0;
+  }
+
   /**
    * @brief Unload all loaded modules.
    * Note: This function needs to be called at the end of each test that uses RTC.
@@ -178,6 +228,21 @@ class TestContext {
    */
   hipFunction_t getFunction(const std::string kernelNameExpression);
 
+  /**
+   * @brief Get the compiled hip rtc kernel function, compiling it on first use.
+   *
+   * The first caller for a name expression runs compile, concurrent callers for the same
+   * expression wait for its result and different expressions compile in parallel. If compile
+   * throws, all waiters get the exception and the next call compiles again.
+   *
+   * @param kernelNameExpression The name expression (e.g. hipTest::vectorADD<float>).
+   * @param compile Builds and loads the kernel, returning its module and function.
+   * @return the hipFunction.
+   */
+  hipFunction_t getFunction(
+      const std::string& kernelNameExpression,
+      const std::function<std::pair<hipModule_t, hipFunction_t>()>& compile);
+
   TestContext(const TestContext&) = delete;
   void operator=(const TestContext&) = delete;
 
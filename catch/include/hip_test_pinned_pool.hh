@@ -0,0 +1,235 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <hip/hip_runtime.h>
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+Size class cache of hipHostMalloc blocks shared by the tests and the perftests, so it only
+depends on the HIP runtime. Pinning and unpinning takes far longer than the copies most
+users time, so blocks are kept pinned between uses:
+
+  hip::PinnedBuffer staging(size);  // or PinnedBuffer(size, flags, numaNode)
+  HIP_CHECK(staging.error());
+  HIP_CHECK(hipMemcpyAsync(staging.get(), src, size, hipMemcpyDeviceToHost, stream));
+
+Blocks are keyed by hipHostMalloc flags, NUMA node and size class, with the same classes as
+hip::BufferPool. Every thread keeps up to kThreadCacheBlocks released blocks per key so
+alternating acquire/release takes no lock; the rest go back to the shared lists, and a
+thread's cache is returned to them when the thread exits. Contents of a block handed out
+are whatever its last user left.
+
+A NUMA node other than kAnyNode binds the pages of new blocks to that node (Linux only, by
+setting the thread's memory policy around a hipHostMallocNumaUser allocation); elsewhere
+the node is only part of the key. trim() frees the shared lists and the calling thread's
+cache, blocks cached by other live threads stay pinned.
+*/
+
+namespace hip {
+
+class PinnedPool {
+ public:
+  static constexpr int kAnyNode = -1;
+  static constexpr size_t kThreadCacheBlocks = 4;
+
+  static PinnedPool& get() {
+    static PinnedPool* pool = new PinnedPool();
+    return *pool;
+  }
+
+  /**
+   * @brief Hands out a pinned block of at least size bytes
+   * @param ptr receives the block, nullptr on failure
+   * @param flags hipHostMalloc flags, part of the cache key
+   * @param numaNode node the pages are bound to, kAnyNode for the default placement
+   * @return the hipHostMalloc error if a new block could not be allocated
+   */
+  hipError_t acquire(void** ptr, size_t size, unsigned int flags = 0u, int numaNode = kAnyNode) {
+    Key key{flags, numaNode, sizeClass(size)};
+    *ptr = nullptr;
+    auto& cached = cache().blocks[key];
+    if (!cached.empty()) {
+      *ptr = cached.back();
+      cached.pop_back();
+    } else {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& blocks = free_[key];
+      if (!blocks.empty()) {
+        *ptr = blocks.back();
+        blocks.pop_back();
+      }
+    }
+    if (*ptr == nullptr) {
+      hipError_t err = allocate(key, ptr);
+      if (err != hipSuccess) {
+        // Cached blocks of other size classes may be what is missing, retry once without them
+        static_cast<void>(hipGetLastError());
+        trim();
+        err = allocate(key, ptr);
+        if (err != hipSuccess) {
+          *ptr = nullptr;
+          return err;
+        }
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    used_.emplace(*ptr, key);
+    return hipSuccess;
+  }
+
+  // Returns a block obtained from acquire(), ignores other pointers
+  void release(void* ptr) {
+    Key key;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = used_.find(ptr);
+      if (it == used_.end()) return;
+      key = it->second;
+      used_.erase(it);
+    }
+    auto& cached = cache().blocks[key];
+    if (cached.size() < kThreadCacheBlocks) {
+      cached.push_back(ptr);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_[key].push_back(ptr);
+  }
+
+  // Frees the shared lists and the calling thread's cache
+  void trim() {
+    flush(cache());
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : free_) {
+      for (auto ptr : entry.second) {
+        static_cast<void>(hipHostFree(ptr));
+      }
+    }
+    free_.clear();
+  }
+
+ private:
+  // flags, NUMA node, size class in bytes
+  using Key = std::tuple<unsigned int, int, size_t>;
+
+  struct ThreadCache {
+    std::map<Key, std::vector<void*>> blocks;
+    ~ThreadCache() { PinnedPool::get().flush(*this); }
+  };
+
+  // Never destroyed, the runtime may already be torn down when statics are
+  PinnedPool() = default;
+  PinnedPool(const PinnedPool&) = delete;
+  PinnedPool& operator=(const PinnedPool&) = delete;
+
+  static ThreadCache& cache() {
+    thread_local ThreadCache threadCache;
+    return threadCache;
+  }
+
+  // Powers of two up to 1 MiB, multiples of 1 MiB above, as hip::BufferPool
+  static size_t sizeClass(size_t size) {
+    constexpr size_t kMiB = 1024 * 1024;
+    if (size > kMiB) return (size + kMiB - 1) / kMiB * kMiB;
+    size_t cls = 256;
+    while (cls < size) cls <<= 1;
+    return cls;
+  }
+
+  void flush(ThreadCache& threadCache) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : threadCache.blocks) {
+      auto& blocks = free_[entry.first];
+      blocks.insert(blocks.end(), entry.second.begin(), entry.second.end());
+    }
+    threadCache.blocks.clear();
+  }
+
+  static hipError_t allocate(const Key& key, void** ptr) {
+    unsigned int flags = std::get<0>(key);
+    int node = std::get<1>(key);
+    size_t size = std::get<2>(key);
+#ifdef __linux__
+    if (node != kAnyNode && node < 64) {
+      // MPOL_BIND for the allocation, then back to what the thread had
+      constexpr int kMpolBind = 2;
+      int oldMode = 0;
+      unsigned long oldMask[16] = {};
+      bool saved = syscall(SYS_get_mempolicy, &oldMode, oldMask, 1024ul, nullptr, 0ul) == 0;
+      unsigned long mask = 1ul << node;
+      if (saved && syscall(SYS_set_mempolicy, kMpolBind, &mask, 64ul) == 0) {
+#ifdef __HIP_PLATFORM_AMD__
+        flags |= hipHostMallocNumaUser;
+#endif
+        hipError_t err = hipHostMalloc(ptr, size, flags);
+        static_cast<void>(syscall(SYS_set_mempolicy, oldMode, oldMask, 1024ul));
+        return err;
+      }
+    }
+#endif
+    static_cast<void>(node);
+    return hipHostMalloc(ptr, size, flags);
+  }
+
+  std::mutex mutex_;
+  std::map<Key, std::vector<void*>> free_;
+  std::unordered_map<void*, Key> used_;
+};
+
+// A block from hip::PinnedPool for the lifetime of the object
+class PinnedBuffer {
+ public:
+  explicit PinnedBuffer(size_t size, unsigned int flags = 0u, int numaNode = PinnedPool::kAnyNode)
+      : size_{size}, error_{PinnedPool::get().acquire(&ptr_, size, flags, numaNode)} {}
+  ~PinnedBuffer() {
+    if (ptr_ != nullptr) PinnedPool::get().release(ptr_);
+  }
+
+  PinnedBuffer(const PinnedBuffer&) = delete;
+  PinnedBuffer& operator=(const PinnedBuffer&) = delete;
+
+  void* get() const { return ptr_; }
+  template <typename T> T* as() const { return static_cast<T*>(ptr_); }
+  size_t size() const { return size_; }
+  // hipSuccess, or why the block could not be allocated
+  hipError_t error() const { return error_; }
+
+ private:
+  void* ptr_ = nullptr;
+  size_t size_;
+  hipError_t error_;
+};
+
+}  // namespace hip
@@ -26,14 +26,24 @@ THE SOFTWARE.
 #include "hip_test_filesystem.hh"
 
 #include <string>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cerrno>
 #include <cstdlib>
-#include <random>
-#include <fstream>
-#include <streambuf>
+#include <vector>
 #include <thread>
 #include <future>
 
+#if HT_LINUX
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#else
+#include <windows.h>
+#endif
+
 namespace hip {
 /*
 Class to spawn a process in isolation and test its standard output and return status
@@ -43,25 +53,149 @@ How to use:
 Have the stand alone exe in the same folder
 Init a class using hip::SpawnProc proc("ExeName", yes_or_no_to_capture_output);
 proc.run("Optional command line args");
+
+The child is started directly (posix_spawn on Linux, CreateProcess on Windows), without a
+shell. Command line args are split on whitespace, single and double quotes group words.
+When capturing, the child's stdout is read from a pipe as it is written; stderr is inherited.
+run() does not use Catch macros, so several procs can run on different threads at once, see
+hip::runConcurrently.
 */
 class SpawnProc {
   std::string exeName;
   std::string resultStr;
-  std::string tmpFileName;
   std::future<int> ret_from_run;
   bool captureOutput;
 
-  std::string getRandomString(size_t len = 6) {
-    std::random_device dev;
-    std::mt19937 rng(dev());
-    std::uniform_int_distribution<std::mt19937::result_type> dist(0, 25);
+  static std::vector<std::string> splitArgs(const std::string& commandLineArgs) {
+    std::vector<std::string> args;
+    std::string current;
+    bool inWord = false;
+    char quote = 0;
+    for (char c : commandLineArgs) {
+      if (quote != 0) {
+        if (c == quote) {
+          quote = 0;
+        } else {
+          current += c;
+        }
+      } else if (c == '"' || c == '\'') {
+        quote = c;
+        inWord = true;
+      } else if (c == ' ' || c == '\t' || c == '\n') {
+        if (inWord) {
+          args.push_back(current);
+          current.clear();
+          inWord = false;
+        }
+      } else {
+        current += c;
+        inWord = true;
+      }
+    }
+    if (inWord) {
+      args.push_back(current);
+    }
+    return args;
+  }
+
+#if HT_LINUX
+  int spawn(const std::vector<std::string>& args) {
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(exeName.c_str()));
+    for (auto& arg : args) {
+      argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    int pipeFds[2] = {-1, -1};
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (captureOutput) {
+      if (pipe(pipeFds) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return 127;
+      }
+      posix_spawn_file_actions_addclose(&actions, pipeFds[0]);
+      posix_spawn_file_actions_adddup2(&actions, pipeFds[1], STDOUT_FILENO);
+      posix_spawn_file_actions_addclose(&actions, pipeFds[1]);
+    }
+
+    pid_t pid;
+    int spawnError = posix_spawn(&pid, exeName.c_str(), &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (captureOutput) {
+      close(pipeFds[1]);
+      if (spawnError == 0) {
+        std::array<char, 4096> buffer;
+        ssize_t count;
+        while ((count = read(pipeFds[0], buffer.data(), buffer.size())) != 0) {
+          if (count < 0) {
+            if (errno == EINTR) continue;
+            break;
+          }
+          resultStr.append(buffer.data(), count);
+        }
+      }
+      close(pipeFds[0]);
+    }
+    // Same as a shell would report: 127 if the exe could not be started
+    if (spawnError != 0) return 127;
 
-    std::string res;
-    for (size_t i = 0; i < len; i++) {
-      res += 'a' + dist(rng);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+      if (errno != EINTR) return 127;
     }
-    return res;
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return status;
   }
+#else
+  int spawn(const std::vector<std::string>& args) {
+    std::string commandLine = "\"" + exeName + "\"";
+    for (auto& arg : args) {
+      commandLine += " \"" + arg + "\"";
+    }
+
+    SECURITY_ATTRIBUTES attributes{sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+    HANDLE readPipe = nullptr, writePipe = nullptr;
+    STARTUPINFOA startupInfo{};
+    startupInfo.cb = sizeof(startupInfo);
+    if (captureOutput) {
+      if (!CreatePipe(&readPipe, &writePipe, &attributes, 0)) return 127;
+      // Only the write end goes to the child
+      SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+      startupInfo.dwFlags = STARTF_USESTDHANDLES;
+      startupInfo.hStdOutput = writePipe;
+      startupInfo.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+      startupInfo.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+    }
+
+    PROCESS_INFORMATION processInfo{};
+    BOOL created = CreateProcessA(exeName.c_str(), &commandLine[0], nullptr, nullptr, TRUE, 0,
+                                  nullptr, nullptr, &startupInfo, &processInfo);
+    if (captureOutput) {
+      CloseHandle(writePipe);
+      if (created) {
+        std::array<char, 4096> buffer;
+        DWORD count;
+        while (ReadFile(readPipe, buffer.data(), static_cast<DWORD>(buffer.size()), &count,
+                        nullptr) && count != 0) {
+          resultStr.append(buffer.data(), count);
+        }
+      }
+      CloseHandle(readPipe);
+    }
+    if (!created) return 127;
+
+    WaitForSingleObject(processInfo.hProcess, INFINITE);
+    DWORD exitCode = 0;
+    GetExitCodeProcess(processInfo.hProcess, &exitCode);
+    CloseHandle(processInfo.hThread);
+    CloseHandle(processInfo.hProcess);
+    return static_cast<int>(exitCode);
+  }
+#endif
 
  public:
   SpawnProc(std::string exeName_, bool captureOutput_ = false)
@@ -77,42 +211,11 @@ class SpawnProc {
     }
     INFO("Testing that exe exists: " << exeName);
     REQUIRE(fs::exists(exeName));
-
-    if (captureOutput) {
-      auto path = fs::temp_directory_path();
-      path /= getRandomString();
-      tmpFileName = path.string();
-      INFO("Testing that capture file does not exist already: " << tmpFileName);
-      REQUIRE(!fs::exists(tmpFileName));
-    }
   }
 
   int run(std::string commandLineArgs = "") {
-    std::string execCmd = exeName;
-
-    // Append command line args
-    if (commandLineArgs.size() > 0) {
-      execCmd += " ";  // Add space for command line args
-      execCmd += commandLineArgs;
-    }
-
-    if (captureOutput) {
-      execCmd += " > ";
-      execCmd += tmpFileName;
-    }
-    auto res = std::system(execCmd.c_str());
-
-    if (captureOutput) {
-      std::ifstream t(tmpFileName.c_str());
-      resultStr =
-          std::string((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
-      t.close();
-    }
-#if HT_LINUX
-    return WEXITSTATUS(res);
-#else
-    return res;
-#endif
+    resultStr.clear();
+    return spawn(splitArgs(commandLineArgs));
   }
 
   void run_async(std::string commandLineArgs = "") {
@@ -126,4 +229,33 @@ class SpawnProc {
 
   std::string getOutput() { return resultStr; }
 };
+
+/*
+Runs procs[i].run(args[i]) for every proc, at most maxParallel at a time (0 uses the number of
+hardware threads). Missing args are treated as empty. Returns the exit codes in proc order,
+the captured output stays available through each proc's getOutput().
+*/
+inline std::vector<int> runConcurrently(std::vector<SpawnProc>& procs,
+                                        const std::vector<std::string>& args = {},
+                                        unsigned int maxParallel = 0) {
+  if (maxParallel == 0) {
+    maxParallel = std::max(1u, std::thread::hardware_concurrency());
+  }
+  std::vector<int> results(procs.size(), 0);
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < procs.size(); i = next++) {
+      results[i] = procs[i].run(i < args.size() ? args[i] : "");
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < std::min<size_t>(maxParallel, procs.size()); i++) {
+    workers.emplace_back(worker);
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+  return results;
+}
 }  // namespace hip
@@ -0,0 +1,87 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+#include "hip_test_context.hh"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+
+namespace hip {
+/*
+Per test case profiling, enabled by setting HT_PROFILE to the report file.
+
+The listener in hipTestMain/hip_test_profiler.cc records for every TEST_CASE its wall time,
+the time spent in HIP calls made through HIP_CHECK/HIP_CHECK_ERROR/HIP_CHECK_THREAD and the
+device time between events recorded on the null stream before and after the test. The
+report is merged into HT_PROFILE at exit, sorted by wall time.
+*/
+struct ProfileEntry {
+  double wallMs;
+  double apiMs;
+  double gpuMs;  // negative when the events could not be recorded
+  bool passed;
+};
+
+class TestProfiler {
+ public:
+  // Entries of an HT_PROFILE report by test name, empty if the file does not exist
+  static std::map<std::string, ProfileEntry> readReport(const std::string& path);
+
+  static bool enabled() {
+    static const bool enabled_ = !TestContext::getEnvVar("HT_PROFILE").empty();
+    return enabled_;
+  }
+
+  // Nanoseconds spent in HIP API calls since the current test started, from all threads
+  static std::atomic<long long>& apiTime() {
+    static std::atomic<long long> apiTime_{0};
+    return apiTime_;
+  }
+};
+
+// Adds the time from construction to stop() or destruction to the current test's HIP API time,
+// when profiling is enabled
+class ApiTimer {
+ public:
+  ApiTimer() : running_(TestProfiler::enabled()) {
+    if (running_) start_ = std::chrono::steady_clock::now();
+  }
+  ~ApiTimer() { stop(); }
+  ApiTimer(const ApiTimer&) = delete;
+  ApiTimer& operator=(const ApiTimer&) = delete;
+
+  void stop() {
+    if (!running_) return;
+    running_ = false;
+    TestProfiler::apiTime() += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start_)
+                                   .count();
+  }
+
+ private:
+  bool running_;
+  std::chrono::steady_clock::time_point start_;
+};
+}  // namespace hip
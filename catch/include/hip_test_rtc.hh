@@ -32,8 +32,13 @@ THE SOFTWARE.
 #include <sstream>
 #include <set>
 #include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <stdexcept>
 #include "hip/hip_runtime_api.h"
 #include "hip_test_context.hh"
+#include "hip_test_filesystem.hh"
 
 namespace HipTest {
 
@@ -87,31 +92,42 @@ inline std::vector<char> alignArguments(std::vector<KernelArgument>& args) {
   return alignedArguments;
 }
 
+/**
+ * @brief Throws std::runtime_error if a step of building an RTC kernel failed.
+ *
+ * The RTC helpers throw instead of using REQUIRE, so they also work outside of a test case
+ * (precompileRTCKernels) and on threads other than the one running the test.
+ */
+inline void rtcCheck(bool condition, const std::string& message) {
+  if (!condition) {
+    throw std::runtime_error(message);
+  }
+}
+
 inline std::vector<char> getKernelCode(hiprtcProgram& rtcProgram) {
   size_t codeSize;
-  REQUIRE(HIPRTC_SUCCESS == hiprtcGetCodeSize(rtcProgram, &codeSize));
+  rtcCheck(HIPRTC_SUCCESS == hiprtcGetCodeSize(rtcProgram, &codeSize), "hiprtcGetCodeSize failed");
 
   std::vector<char> code(codeSize);
-  REQUIRE(HIPRTC_SUCCESS == hiprtcGetCode(rtcProgram, code.data()));
+  rtcCheck(HIPRTC_SUCCESS == hiprtcGetCode(rtcProgram, code.data()), "hiprtcGetCode failed");
 
   return code;
 }
 
 /**
- * @brief Compiles a kernel using HIP RTC
+ * @brief Reads the source of a kernel from its file in KERNELS_PATH.
  *
- * @param rtcKernel the name of the kernel to compile.
- * @param kernelNameExpression the name expression to be added to the RTC program (e.g.
- * HipTest::VectorADD<float>)
- * @return hiprtcProgram the compiled rtc program.
+ * @param rtcKernel the name of the kernel.
+ * @return std::string the kernel code without include directives.
  */
-inline hiprtcProgram compileRTC(std::string& rtcKernel, std::string& kernelNameExpression) {
-  std::string fileName = mapKernelToFileName.at(rtcKernel);
+inline std::string readKernelSource(std::string& rtcKernel) {
+  auto file = mapKernelToFileName.find(rtcKernel);
+  rtcCheck(file != mapKernelToFileName.end(), "No kernel file mapped for " + rtcKernel);
+  std::string fileName = file->second;
   std::string filePath{KERNELS_PATH + fileName};
 
-  INFO("Opening Kernel File: " << filePath);
   std::ifstream kernelFile{filePath};
-  REQUIRE(kernelFile.is_open());
+  rtcCheck(kernelFile.is_open(), "Unable to open kernel file: " + filePath);
 
   std::stringstream stringStream;
   std::string line;
@@ -124,39 +140,304 @@ inline hiprtcProgram compileRTC(std::string& rtcKernel, std::string& kernelNameE
   }
   kernelFile.close();
 
-  std::string kernelCode{stringStream.str()};
-  INFO("RTC Kernel Code:\n" << kernelCode)
-
-  hiprtcProgram rtcProgram;
-  hiprtcCreateProgram(&rtcProgram, kernelCode.c_str(), (fileName + ".cu").c_str(), 0, nullptr,
-                      nullptr);
+  return stringStream.str();
+}
 
-  std::vector<const char*> options{};
+/**
+ * @brief Gets the HIP RTC compile options, the architectures of all devices on AMD.
+ *
+ */
+inline std::vector<std::string> getCompileOptions() {
+  std::vector<std::string> options{};
 #ifdef __HIP_PLATFORM_AMD__
 
   int deviceCount;
-  REQUIRE(hipSuccess == hipGetDeviceCount(&deviceCount));
+  rtcCheck(hipSuccess == hipGetDeviceCount(&deviceCount), "hipGetDeviceCount failed");
 
   std::set<std::string> architectures{};
   for (int i = 0; i < deviceCount; ++i) {
     hipDeviceProp_t props;
-    REQUIRE(hipSuccess == hipGetDeviceProperties(&props, i));
+    rtcCheck(hipSuccess == hipGetDeviceProperties(&props, i), "hipGetDeviceProperties failed");
     architectures.insert(std::string{"--gpu-architecture="} + props.gcnArchName);
   }
 
-  for (auto& architecture : architectures) {
-    options.push_back(architecture.c_str());
-  }
+  options.insert(std::end(options), std::begin(architectures), std::end(architectures));
 #else
   options.push_back("--fmad=false");
 #endif
+  return options;
+}
+
+/**
+ * @brief Compiles a kernel using HIP RTC
+ *
+ * @param rtcKernel the name of the kernel to compile.
+ * @param kernelCode the source of the kernel, as returned by readKernelSource.
+ * @param kernelNameExpression the name expression to be added to the RTC program (e.g.
+ * HipTest::VectorADD<float>)
+ * @param compileOptions the options passed to hiprtcCompileProgram.
+ * @return hiprtcProgram the compiled rtc program.
+ */
+inline hiprtcProgram compileRTC(std::string& rtcKernel, const std::string& kernelCode,
+                                std::string& kernelNameExpression,
+                                const std::vector<std::string>& compileOptions) {
+  std::string fileName = mapKernelToFileName.at(rtcKernel);
 
-  REQUIRE(HIPRTC_SUCCESS == hiprtcAddNameExpression(rtcProgram, kernelNameExpression.c_str()));
-  REQUIRE(HIPRTC_SUCCESS == hiprtcCompileProgram(rtcProgram, 1, options.data()));
+  hiprtcProgram rtcProgram;
+  rtcCheck(HIPRTC_SUCCESS == hiprtcCreateProgram(&rtcProgram, kernelCode.c_str(),
+                                                 (fileName + ".cu").c_str(), 0, nullptr, nullptr),
+           "hiprtcCreateProgram failed for " + kernelNameExpression);
+
+  std::vector<const char*> options{};
+  for (auto& option : compileOptions) {
+    options.push_back(option.c_str());
+  }
+
+  rtcCheck(HIPRTC_SUCCESS == hiprtcAddNameExpression(rtcProgram, kernelNameExpression.c_str()),
+           "hiprtcAddNameExpression failed for " + kernelNameExpression);
+  if (HIPRTC_SUCCESS != hiprtcCompileProgram(rtcProgram, options.size(), options.data())) {
+    size_t logSize = 0;
+    hiprtcGetProgramLogSize(rtcProgram, &logSize);
+    std::string log(logSize, '\0');
+    if (logSize > 0) hiprtcGetProgramLog(rtcProgram, &log[0]);
+    hiprtcDestroyProgram(&rtcProgram);
+    throw std::runtime_error("Compiling " + kernelNameExpression + " failed:\n" + log +
+                             "\nRTC Kernel Code:\n" + kernelCode);
+  }
 
   return rtcProgram;
 }
 
+/**
+ * @brief Compiles a kernel using HIP RTC
+ *
+ * @param rtcKernel the name of the kernel to compile.
+ * @param kernelNameExpression the name expression to be added to the RTC program (e.g.
+ * HipTest::VectorADD<float>)
+ * @return hiprtcProgram the compiled rtc program.
+ */
+inline hiprtcProgram compileRTC(std::string& rtcKernel, std::string& kernelNameExpression) {
+  return compileRTC(rtcKernel, readKernelSource(rtcKernel), kernelNameExpression,
+                    getCompileOptions());
+}
+
+/**
+ * @brief Directory of the on-disk RTC code object cache.
+ *
+ * @return std::string HT_RTC_CACHE_DIR if set, otherwise hip_test_rtc_cache in the temp
+ * directory. Empty if HT_RTC_CACHE_DISABLE is set.
+ */
+inline std::string rtcCacheDir() {
+  if (!TestContext::getEnvVar("HT_RTC_CACHE_DISABLE").empty()) {
+    return "";
+  }
+  std::string dir = TestContext::getEnvVar("HT_RTC_CACHE_DIR");
+  if (dir.empty()) {
+    std::error_code error;
+    fs::path tempDir = fs::temp_directory_path(error);
+    if (error) return "";
+    dir = (tempDir / "hip_test_rtc_cache").string();
+  }
+  return dir;
+}
+
+/**
+ * @brief Builds the cache key of a compiled kernel.
+ *
+ * The key covers everything the code object depends on: kernel source, name expression,
+ * compile options (which carry the gfx architectures on AMD), the device architecture and
+ * the hiprtc version.
+ *
+ * @return std::string 64 bit FNV-1a hash of the inputs in hex.
+ */
+inline std::string rtcCacheKey(const std::string& kernelCode,
+                               const std::string& kernelNameExpression,
+                               const std::vector<std::string>& compileOptions) {
+  int major = 0, minor = 0;
+  hiprtcVersion(&major, &minor);
+
+  std::string arch;
+  hipDeviceProp_t props;
+  if (hipGetDeviceProperties(&props, 0) == hipSuccess) {
+#ifdef __HIP_PLATFORM_AMD__
+    arch = props.gcnArchName;
+#else
+    arch = "sm_" + std::to_string(props.major) + std::to_string(props.minor);
+#endif
+  }
+
+  std::string keySource = kernelCode + '\0' + kernelNameExpression + '\0' + arch + '\0' +
+                          std::to_string(major) + "." + std::to_string(minor);
+  for (auto& option : compileOptions) {
+    keySource += '\0' + option;
+  }
+
+  std::uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : keySource) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  std::stringstream key;
+  key << std::hex << hash;
+  return key.str();
+}
+
+/**
+ * @brief Loads a code object from the on-disk cache.
+ *
+ * A cache file holds the lowered kernel name on the first line followed by the code object.
+ *
+ * @return true if the key was found, code and loweredName are filled in.
+ */
+inline bool loadCachedKernel(const std::string& cacheKey, std::vector<char>& code,
+                             std::string& loweredName) {
+  std::string dir = rtcCacheDir();
+  if (dir.empty()) return false;
+
+  std::ifstream cacheFile{(fs::path(dir) / (cacheKey + ".co")).string(), std::ios::binary};
+  if (!cacheFile.is_open() || !std::getline(cacheFile, loweredName) || loweredName.empty()) {
+    return false;
+  }
+  code.assign(std::istreambuf_iterator<char>(cacheFile), std::istreambuf_iterator<char>());
+  return !code.empty();
+}
+
+/**
+ * @brief Stores a code object in the on-disk cache, failures only cost a recompile.
+ *
+ * The file is written under a unique temporary name and renamed into place, so concurrent
+ * test processes never read a partially written entry.
+ */
+inline void storeCachedKernel(const std::string& cacheKey, const std::vector<char>& code,
+                              const std::string& loweredName) {
+  std::string dir = rtcCacheDir();
+  if (dir.empty()) return;
+
+  std::error_code error;
+  fs::create_directories(dir, error);
+  fs::path target = fs::path(dir) / (cacheKey + ".co");
+  fs::path temp = fs::path(dir) / (cacheKey + ".tmp" +
+      std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+  {
+    std::ofstream cacheFile{temp.string(), std::ios::binary};
+    if (!cacheFile.is_open()) return;
+    cacheFile << loweredName << '\n';
+    cacheFile.write(code.data(), code.size());
+    if (!cacheFile) {
+      cacheFile.close();
+      fs::remove(temp, error);
+      return;
+    }
+  }
+  fs::rename(temp, target, error);
+  if (error) fs::remove(temp, error);
+}
+
+/**
+ * @brief Removes a cache entry, e.g. one that no longer loads.
+ */
+inline void removeCachedKernel(const std::string& cacheKey) {
+  std::string dir = rtcCacheDir();
+  if (dir.empty()) return;
+
+  std::error_code error;
+  fs::remove(fs::path(dir) / (cacheKey + ".co"), error);
+}
+
+/**
+ * @brief Loads a code object and looks the kernel up in it.
+ *
+ * @return nullptr when module and kernelFunction are set, otherwise the name of the failed API.
+ */
+inline const char* loadKernelFunction(const std::vector<char>& code,
+                                      const std::string& loweredName, hipModule_t& module,
+                                      hipFunction_t& kernelFunction) {
+  if (hipSuccess != hipModuleLoadData(&module, code.data())) {
+    return "hipModuleLoadData";
+  }
+  if (hipSuccess != hipModuleGetFunction(&kernelFunction, module, loweredName.c_str())) {
+    hipModuleUnload(module);
+    return "hipModuleGetFunction";
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Builds an RTC kernel, from the on-disk cache if possible, and loads it.
+ *
+ * A cached entry that does not load (truncated, corrupt or built for another runtime) is
+ * removed and the kernel compiled again, so it does not fail every later run.
+ *
+ * @param kernelName the name of the kernel (e.g. "HipTest::vectorADD").
+ * @param kernelExpression the name expression (e.g. "HipTest::vectorADD<float>").
+ * @return the loaded module and the kernel function in it.
+ */
+inline std::pair<hipModule_t, hipFunction_t> loadRTCKernel(std::string kernelName,
+                                                           std::string kernelExpression) {
+  std::string kernelCode{readKernelSource(kernelName)};
+  std::vector<std::string> options{getCompileOptions()};
+  std::string cacheKey{rtcCacheKey(kernelCode, kernelExpression, options)};
+
+  std::vector<char> compiledCode;
+  std::string loweredName;
+  hipModule_t module;
+  hipFunction_t kernelFunction;
+  if (loadCachedKernel(cacheKey, compiledCode, loweredName)) {
+    if (loadKernelFunction(compiledCode, loweredName, module, kernelFunction) == nullptr) {
+      return {module, kernelFunction};
+    }
+    /* Do not leave the failed load as the last error of the test */
+    static_cast<void>(hipGetLastError());
+    removeCachedKernel(cacheKey);
+  }
+
+  hiprtcProgram rtcProgram{compileRTC(kernelName, kernelCode, kernelExpression, options)};
+  compiledCode = getKernelCode(rtcProgram);
+
+  const char* rtcLoweredName;
+  rtcCheck(HIPRTC_SUCCESS ==
+               hiprtcGetLoweredName(rtcProgram, kernelExpression.c_str(), &rtcLoweredName),
+           "hiprtcGetLoweredName failed for " + kernelExpression);
+  loweredName = rtcLoweredName;
+
+  /* The lowered name and code are all that is needed later, so the program can be destroyed */
+  rtcCheck(HIPRTC_SUCCESS == hiprtcDestroyProgram(&rtcProgram), "hiprtcDestroyProgram failed");
+
+  const char* failedApi = loadKernelFunction(compiledCode, loweredName, module, kernelFunction);
+  if (failedApi != nullptr) {
+    throw std::runtime_error(std::string(failedApi) + " failed for " + kernelExpression);
+  }
+  /* Only code objects that loaded are cached */
+  storeCachedKernel(cacheKey, compiledCode, loweredName);
+  return {module, kernelFunction};
+}
+
+/**
+ * @brief Compiles and loads the given kernels in parallel, ahead of the tests using them.
+ *
+ * Failures are only reported, a test launching a kernel that failed here compiles it again
+ * and fails on its own.
+ *
+ * @param kernelExpressions name expressions (e.g. "HipTest::vectorADD<float>").
+ */
+inline void precompileRTCKernels(const std::vector<std::string>& kernelExpressions) {
+  TestContext& testContext = TestContext::get();
+  std::vector<std::future<void>> compiles;
+  for (const auto& expression : kernelExpressions) {
+    compiles.push_back(std::async(std::launch::async, [&testContext, expression]() {
+      std::string kernelName = expression.substr(0, expression.find('<'));
+      testContext.getFunction(expression, [&]() { return loadRTCKernel(kernelName, expression); });
+    }));
+  }
+  for (auto& compile : compiles) {
+    try {
+      compile.get();
+    } catch (const std::exception& e) {
+      std::cerr << "RTC precompile: " << e.what() << std::endl;
+    }
+  }
+}
+
 /**
  * @brief Get a typename as a string
  *
@@ -222,33 +503,16 @@ void launchRTCKernel(std::string (*getKernelName)(), dim3 numBlocks, dim3 numThr
   std::vector<std::string> kernelTypenames{std::string(HipTest::getTypeName<Typenames>())...};
   std::string kernelExpression = reconstructExpression(kernelName, kernelTypenames);
 
-  static std::mutex mutex{};
-  {
-    std::lock_guard<std::mutex> lockGuard(mutex);
-    if (testContext.getFunction(kernelExpression) == nullptr) {
-      hiprtcProgram rtcProgram{compileRTC(kernelName, kernelExpression)};
-      std::vector<char> compiledCode{getKernelCode(rtcProgram)};
-
-      hipModule_t module;
-
-      REQUIRE(hipSuccess == hipModuleLoadData(&module, compiledCode.data()));
-
-      hipFunction_t kernelFunction;
-
-      const char* loweredName;
-      REQUIRE(HIPRTC_SUCCESS ==
-              hiprtcGetLoweredName(rtcProgram, kernelExpression.c_str(), &loweredName));
-      REQUIRE(hipSuccess == hipModuleGetFunction(&kernelFunction, module, loweredName));
-
-      /* After obtaining the kernelFunction, the program is no longer needed. So it can be destroyed */
-      REQUIRE(HIPRTC_SUCCESS == hiprtcDestroyProgram(&rtcProgram));
-
-      testContext.trackRtcState(kernelExpression, module, kernelFunction);
-    }
+  hipFunction_t kernelFunction{nullptr};
+  try {
+    /* Concurrent launches of the same kernel wait for a single compile */
+    kernelFunction = testContext.getFunction(
+        kernelExpression, [&]() { return loadRTCKernel(kernelName, kernelExpression); });
+  } catch (const std::exception& e) {
+    INFO(e.what());
+    REQUIRE(false);
   }
 
-  hipFunction_t kernelFunction = testContext.getFunction(kernelExpression);
-
   std::vector<KernelArgument> args = {
       {reinterpret_cast<const void*>(&packedArgs), sizeof(Args), alignof(Args)}...};
 
@@ -22,6 +22,8 @@ THE SOFTWARE.
 
 #pragma once
 
+#include <stdint.h>
+
 /**
  * @brief Error codes retured by rocm_smi_lib functions
  */
@@ -86,3 +88,63 @@ typedef enum {
 
   RSMI_MEM_TYPE_LAST = RSMI_MEM_TYPE_GTT
 } rsmi_memory_type_t;
+
+/**
+ * @brief Clock types
+ */
+typedef enum {
+  RSMI_CLK_TYPE_SYS = 0x0,                //!< System clock
+  RSMI_CLK_TYPE_FIRST = RSMI_CLK_TYPE_SYS,
+  RSMI_CLK_TYPE_DF,                       //!< Data Fabric clock (for ASICs
+                                          //!< running on a separate clock)
+  RSMI_CLK_TYPE_DCEF,                     //!< Display Controller Engine clock
+  RSMI_CLK_TYPE_SOC,                      //!< SOC clock
+  RSMI_CLK_TYPE_MEM,                      //!< Memory clock
+
+  RSMI_CLK_TYPE_LAST = RSMI_CLK_TYPE_MEM,
+  RSMI_CLK_INVALID = 0xFFFFFFFF
+} rsmi_clk_type_t;
+
+/**
+ * @brief Temperature sensor types
+ */
+typedef enum {
+  RSMI_TEMP_TYPE_FIRST = 0,
+
+  RSMI_TEMP_TYPE_EDGE = RSMI_TEMP_TYPE_FIRST,  //!< Edge GPU temperature
+  RSMI_TEMP_TYPE_JUNCTION,                     //!< Junction/hotspot
+                                               //!< temperature
+  RSMI_TEMP_TYPE_MEMORY,                       //!< VRAM temperature
+
+  RSMI_TEMP_TYPE_LAST = RSMI_TEMP_TYPE_MEMORY,
+  RSMI_TEMP_TYPE_INVALID = 0xFFFFFFFF
+} rsmi_temperature_type_t;
+
+/**
+ * @brief Temperature metrics
+ */
+typedef enum {
+  RSMI_TEMP_CURRENT = 0x0,  //!< Temperature current value, in millidegrees
+                            //!< Celsius
+  RSMI_TEMP_FIRST = RSMI_TEMP_CURRENT,
+  RSMI_TEMP_MAX,            //!< Temperature max value
+  RSMI_TEMP_MIN,            //!< Temperature min value
+
+  RSMI_TEMP_LAST = RSMI_TEMP_MIN
+} rsmi_temperature_metric_t;
+
+/**
+ * @brief Maximum number of frequency levels reported for a clock domain
+ */
+#define RSMI_MAX_NUM_FREQUENCIES 33
+
+/**
+ * @brief Frequency levels of a clock domain, as filled in by
+ * rsmi_dev_gpu_clk_freq_get()
+ */
+typedef struct {
+  bool has_deep_sleep;      //!< Deep sleep frequency is reported as level 0
+  uint32_t num_supported;   //!< Number of valid entries in frequency
+  uint32_t current;         //!< Index of the current frequency level
+  uint64_t frequency[RSMI_MAX_NUM_FREQUENCIES];  //!< Frequencies in Hz
+} rsmi_frequencies_t;
@@ -0,0 +1,198 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#pragma once
+#include <hip_test_common.hh>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace hip {
+/*
+Time bounded soak mode for stress tests, enabled by setting HT_SOAK_DURATION.
+
+A stress test wraps one pass of its workload in a Soak loop and reports the work it did with
+add(). Without HT_SOAK_DURATION the loop runs exactly once, so the test behaves as before.
+With it the pass is repeated until the duration has elapsed, and every HT_SOAK_INTERVAL the
+throughput of the last interval is printed together with free device memory and host RSS,
+so slow degradation and leaks show up as a trend instead of a single pass/fail:
+
+  hip::Soak soak("Stress_hipStreamCreate_SyncTest", "launches");
+  do {
+    runPass();
+    soak.add(launchesInPass);
+  } while (soak.next());
+
+Durations are seconds, or a number followed by s, m, h or d. HT_SOAK_REPORT appends the
+interval lines to a csv file, HT_SOAK_MAX_DEGRADATION fails the test when the last interval
+is slower than the first by more than the given percentage.
+*/
+class Soak {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  Soak(std::string name, std::string unit)
+      : name_(std::move(name)), unit_(std::move(unit)), start_(Clock::now()),
+        intervalStart_(start_.time_since_epoch().count()) {
+    if (enabled()) {
+      printf("soak: %s for %.0f s, reporting every %.0f s\n", name_.c_str(), duration(),
+             interval());
+    }
+  }
+
+  // Seconds to keep repeating the workload, 0 when soak mode is off
+  static double duration() {
+    static const double duration_ = parseDuration(TestContext::getEnvVar("HT_SOAK_DURATION"));
+    return duration_;
+  }
+
+  static bool enabled() { return duration() > 0; }
+
+  static double interval() {
+    static const double interval_ = [] {
+      double value = parseDuration(TestContext::getEnvVar("HT_SOAK_INTERVAL"));
+      return value > 0 ? value : 60.0;
+    }();
+    return interval_;
+  }
+
+  // Number followed by an optional s, m, h or d suffix, 0 if empty or malformed
+  static double parseDuration(const std::string& text) {
+    if (text.empty()) return 0;
+    char* end = nullptr;
+    double value = strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0) return 0;
+    std::string suffix(end);
+    if (suffix.empty() || suffix == "s") return value;
+    if (suffix == "m") return value * 60;
+    if (suffix == "h") return value * 3600;
+    if (suffix == "d") return value * 86400;
+    return 0;
+  }
+
+  // Counts ops units of completed work, may be called from any thread
+  void add(unsigned long long ops) {
+    ops_ += ops;
+    if (enabled() && elapsed(intervalStart()) >= interval()) {
+      std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+      if (lock.owns_lock() && elapsed(intervalStart()) >= interval()) report();
+    }
+  }
+
+  // Returns true while the soak duration has not elapsed. Call once per pass, from the
+  // thread running the test; at the end prints the summary and checks the degradation limit.
+  bool next() {
+    if (enabled() && elapsed(start_) < duration()) return true;
+    if (!enabled()) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ops_ > 0 && elapsed(intervalStart()) > 0) report();
+    if (rates_.empty()) return false;
+    double first = rates_.front(), last = rates_.back();
+    double change = first > 0 ? (last / first - 1) * 100 : 0;
+    printf("soak: %s done after %zu intervals, first %.1f %s/s, last %.1f %s/s (%+.1f%%)\n",
+           name_.c_str(), rates_.size(), first, unit_.c_str(), last, unit_.c_str(), change);
+
+    auto limit = TestContext::getEnvVar("HT_SOAK_MAX_DEGRADATION");
+    if (!limit.empty()) {
+      INFO("Throughput of " << name_ << " dropped by " << -change << "%");
+      REQUIRE(-change <= atof(limit.c_str()));
+    }
+    return false;
+  }
+
+ private:
+  static double elapsed(Clock::time_point since) {
+    return std::chrono::duration<double>(Clock::now() - since).count();
+  }
+
+  Clock::time_point intervalStart() const {
+    return Clock::time_point(Clock::duration(intervalStart_.load()));
+  }
+
+  static double hostRssMb() {
+#if defined(__linux__)
+    long pages = 0, resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == nullptr) return -1;
+    int read = fscanf(statm, "%ld %ld", &pages, &resident);
+    fclose(statm);
+    if (read != 2) return -1;
+    return resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+#else
+    return -1;
+#endif
+  }
+
+  // Prints and records the throughput since the last report, called with mutex_ held
+  void report() {
+    auto now = Clock::now();
+    double seconds = std::chrono::duration<double>(now - intervalStart()).count();
+    unsigned long long ops = ops_.exchange(0);
+    intervalStart_ = now.time_since_epoch().count();
+
+    double rate = ops / seconds;
+    rates_.push_back(rate);
+    double relative = rates_.front() > 0 ? rate / rates_.front() : 0;
+
+    size_t freeMem = 0, totalMem = 0;
+    double freeMb = hipMemGetInfo(&freeMem, &totalMem) == hipSuccess
+                        ? freeMem / (1024.0 * 1024.0)
+                        : -1;
+    double rssMb = hostRssMb();
+    double total = elapsed(start_);
+
+    printf("soak: %s %8.0f s %12.1f %s/s %6.3f x, device free %.0f MB, host rss %.0f MB\n",
+           name_.c_str(), total, rate, unit_.c_str(), relative, freeMb, rssMb);
+    fflush(stdout);
+
+    static const std::string path = TestContext::getEnvVar("HT_SOAK_REPORT");
+    if (path.empty()) return;
+    bool header = !std::ifstream(path).good();
+    std::ofstream csv(path, std::ios::app);
+    if (header) {
+      csv << "test,unit,elapsed_s,interval_s,ops,ops_per_s,relative,device_free_mb,host_rss_mb\n";
+    }
+    csv << name_ << ',' << unit_ << ',' << total << ',' << seconds << ',' << ops << ',' << rate
+        << ',' << relative << ',' << freeMb << ',' << rssMb << '\n';
+  }
+
+  std::string name_;
+  std::string unit_;
+  Clock::time_point start_;
+  std::atomic<Clock::rep> intervalStart_;  // read by add() without holding mutex_
+  std::atomic<unsigned long long> ops_{0};
+  std::mutex mutex_;
+  std::vector<double> rates_;
+};
+}  // namespace hip
@@ -0,0 +1,215 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <hip/hip_runtime.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/*
+Device topology shared by the multi-GPU tests and the perftests, so it only depends on the HIP
+runtime. Every ordered device pair is queried once for peer access, link type, hop count and
+P2P performance rank, after which pairs can be picked by how they are connected:
+
+  const auto& topology = hip::DeviceTopology::get();
+  for (const auto& [src, dst] : topology.pairs(hip::PeerPairSelection())) { ... }
+
+Attributes the platform cannot report are kUnknown and sort after every known value.
+*/
+
+namespace hip {
+
+struct DeviceLink {
+  int src = -1;
+  int dst = -1;
+  bool peerAccess = false;
+  uint32_t linkType = UINT32_MAX;
+  uint32_t hopCount = UINT32_MAX;
+  uint32_t performanceRank = UINT32_MAX;
+};
+
+// Which peer pairs a test or benchmark covers
+enum class PeerPairs { All, Best, Worst, Xgmi };
+
+// HT_PEER_PAIRS=all|best|worst|xgmi, all when unset or unrecognized
+inline PeerPairs PeerPairSelection() {
+  const char* value = std::getenv("HT_PEER_PAIRS");
+  if (value == nullptr) return PeerPairs::All;
+  if (std::strcmp(value, "best") == 0) return PeerPairs::Best;
+  if (std::strcmp(value, "worst") == 0) return PeerPairs::Worst;
+  if (std::strcmp(value, "xgmi") == 0) return PeerPairs::Xgmi;
+  return PeerPairs::All;
+}
+
+class DeviceTopology {
+ public:
+  static constexpr uint32_t kUnknown = UINT32_MAX;
+  // HSA_AMD_LINK_INFO_TYPE_XGMI as returned by hipExtGetLinkTypeAndHopCount
+  static constexpr uint32_t kLinkTypeXgmi = 4;
+
+  DeviceTopology() {
+    if (hipGetDeviceCount(&deviceCount_) != hipSuccess) deviceCount_ = 0;
+    links_.resize(deviceCount_ * deviceCount_);
+    for (int src = 0; src < deviceCount_; src++) {
+      for (int dst = 0; dst < deviceCount_; dst++) {
+        auto& link = links_[src * deviceCount_ + dst];
+        link.src = src;
+        link.dst = dst;
+        if (src == dst) continue;
+        int value = 0;
+        link.peerAccess = hipDeviceCanAccessPeer(&value, src, dst) == hipSuccess && value;
+#ifdef __HIP_PLATFORM_AMD__
+        uint32_t type = 0, hops = 0;
+        if (hipExtGetLinkTypeAndHopCount(src, dst, &type, &hops) == hipSuccess) {
+          link.linkType = type;
+          link.hopCount = hops;
+        }
+#endif
+        if (hipDeviceGetP2PAttribute(&value, hipDevP2PAttrPerformanceRank, src, dst) ==
+                hipSuccess &&
+            value >= 0) {
+          link.performanceRank = value;
+        }
+      }
+    }
+  }
+
+  // Topology of the devices visible to this process, queried on first use
+  static const DeviceTopology& get() {
+    static const DeviceTopology topology;
+    return topology;
+  }
+
+  int deviceCount() const { return deviceCount_; }
+
+  const DeviceLink& link(int src, int dst) const { return links_[src * deviceCount_ + dst]; }
+
+  bool isXgmi(int src, int dst) const {
+    return src != dst && link(src, dst).linkType == kLinkTypeXgmi;
+  }
+
+  /**
+   * @brief Ordered pairs of distinct devices, best connected first
+   * @return peer accessible pairs before the others, then xGMI before other links, then fewer
+   *         hops, then lower performance rank, ties in device order
+   */
+  std::vector<DeviceLink> rankedLinks() const {
+    std::vector<DeviceLink> ranked;
+    for (const auto& link : links_) {
+      if (link.src != link.dst) ranked.push_back(link);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(), [](const DeviceLink& a, const DeviceLink& b) {
+      return key(a) < key(b);
+    });
+    return ranked;
+  }
+
+  // Best and worst connected pair, {-1, -1} with fewer than two devices
+  std::pair<int, int> bestPair() const {
+    auto ranked = rankedLinks();
+    return ranked.empty() ? std::make_pair(-1, -1)
+                          : std::make_pair(ranked.front().src, ranked.front().dst);
+  }
+
+  std::pair<int, int> worstPair() const {
+    auto ranked = rankedLinks();
+    return ranked.empty() ? std::make_pair(-1, -1)
+                          : std::make_pair(ranked.back().src, ranked.back().dst);
+  }
+
+  // Best connected other device, -1 when device is the only one
+  int bestPeer(int device) const {
+    int best = -1;
+    for (int peer = 0; peer < deviceCount_; peer++) {
+      if (peer != device && (best < 0 || key(link(device, peer)) < key(link(device, best)))) {
+        best = peer;
+      }
+    }
+    return best;
+  }
+
+  // Devices reachable from device over xGMI links, including device itself, in device order
+  std::vector<int> xgmiConnected(int device) const {
+    std::vector<bool> reached(deviceCount_, false);
+    std::vector<int> pending = {device};
+    reached[device] = true;
+    while (!pending.empty()) {
+      int current = pending.back();
+      pending.pop_back();
+      for (int peer = 0; peer < deviceCount_; peer++) {
+        if (!reached[peer] && isXgmi(current, peer)) {
+          reached[peer] = true;
+          pending.push_back(peer);
+        }
+      }
+    }
+    std::vector<int> connected;
+    for (int i = 0; i < deviceCount_; i++) {
+      if (reached[i]) connected.push_back(i);
+    }
+    return connected;
+  }
+
+  /**
+   * @brief Ordered pairs of distinct devices covered by a selection
+   * @param selection All: every pair, Best/Worst: the best/worst pair in both directions,
+   *        Xgmi: every pair directly linked by xGMI
+   */
+  std::vector<std::pair<int, int>> pairs(PeerPairs selection) const {
+    std::vector<std::pair<int, int>> selected;
+    if (selection == PeerPairs::Best || selection == PeerPairs::Worst) {
+      auto [a, b] = selection == PeerPairs::Best ? bestPair() : worstPair();
+      if (a >= 0) selected = {{a, b}, {b, a}};
+      return selected;
+    }
+    for (int src = 0; src < deviceCount_; src++) {
+      for (int dst = 0; dst < deviceCount_; dst++) {
+        if (src == dst || (selection == PeerPairs::Xgmi && !isXgmi(src, dst))) continue;
+        selected.emplace_back(src, dst);
+      }
+    }
+    return selected;
+  }
+
+  bool isSelected(int src, int dst, PeerPairs selection) const {
+    auto selected = pairs(selection);
+    return std::find(selected.begin(), selected.end(), std::make_pair(src, dst)) != selected.end();
+  }
+
+ private:
+  static std::tuple<bool, bool, uint32_t, uint32_t> key(const DeviceLink& link) {
+    return {!link.peerAccess, link.linkType != kLinkTypeXgmi, link.hopCount,
+            link.performanceRank};
+  }
+
+  int deviceCount_ = 0;
+  std::vector<DeviceLink> links_;
+};
+
+}  // namespace hip
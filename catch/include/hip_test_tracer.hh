@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+
+namespace hip {
+/*
+HIP API tracing, enabled by setting HT_TRACE to the output file.
+
+Begin and end of every HIP API call are taken from the roctracer HIP API callback (roctracer
+is loaded at runtime, AMD on Linux only) and kept in a fixed size ring buffer per thread, so
+recording takes no lock. stop() writes the calls as Chrome trace / Perfetto JSON, with the
+test cases as ranges on the thread that ran them. HT_TRACE_BUFFER sets the number of calls
+kept per thread (65536 by default), the oldest are overwritten.
+
+hipTestMain/hip_test_tracer.cc does not depend on Catch2, other applications can compile it
+in and call start()/stop() themselves.
+*/
+class ApiTracer {
+ public:
+  // Enables recording, false when the runtime offers no API callback
+  static bool start();
+  // Stops recording and writes everything recorded so far to path
+  static bool stop(const std::string& path);
+
+  // Named range on the calling thread, e.g. one test case. Ranges must not overlap.
+  static void beginRange(const std::string& name);
+  static void endRange();
+};
+}  // namespace hip
@@ -20,8 +20,18 @@ THE SOFTWARE.
 #pragma once
 
 #include <map>
+#include <string>
+#include <vector>
 
 const std::map<std::string, std::string> mapKernelToFileName{
   {"Set", "Set.cpp"},
   {"HipTest::vectorADD", "vectorADD.inl"},
-};
\ No newline at end of file
+};
+
+// Name expressions compiled up front when HT_RTC_PRECOMPILE is set
+const std::vector<std::string> rtcPrecompileExpressions{
+  "Set",
+  "HipTest::vectorADD<int>",
+  "HipTest::vectorADD<float>",
+  "HipTest::vectorADD<double>",
+};
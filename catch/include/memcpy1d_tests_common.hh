@@ -25,6 +25,8 @@ THE SOFTWARE.
 #include <functional>
 
 #include <hip_test_common.hh>
+#include <hip_test_combinations.hh>
+#include <hip_test_topology.hh>
 #include <hip/hip_runtime_api.h>
 #include <utils.hh>
 #include <resource_guards.hh>
@@ -46,8 +48,27 @@ static inline unsigned int GenerateLinearAllocationFlagCombinations(
   }
 }
 
+struct HostAllocationVariant {
+  LinearAllocs type;
+  unsigned int flags;
+};
+
+// The host allocations GenerateLinearAllocationFlagCombinations yields, as one parameter
+static inline std::vector<HostAllocationVariant> HostAllocationVariants() {
+  return {{LinearAllocs::malloc, 0u},
+          {LinearAllocs::hipHostMalloc, hipHostMallocDefault},
+          {LinearAllocs::hipHostMalloc, hipHostMallocPortable},
+          {LinearAllocs::hipHostMalloc, hipHostMallocMapped},
+          {LinearAllocs::hipHostMalloc, hipHostMallocWriteCombined}};
+}
+
+static inline std::vector<size_t> ShellAllocationSizes() {
+  return {kPageSize / 2, kPageSize, kPageSize * 2};
+}
+
 template <bool should_synchronize, typename F>
 void MemcpyDeviceToHostShell(F memcpy_func, const hipStream_t kernel_stream = nullptr) {
+  hip::PooledAllocations pooled_allocations;
   using LA = LinearAllocs;
   const auto allocation_size = GENERATE(kPageSize / 2, kPageSize, kPageSize * 2);
   const auto host_allocation_type = GENERATE(LA::malloc, LA::hipHostMalloc);
@@ -75,6 +96,7 @@ void MemcpyDeviceToHostShell(F memcpy_func, const hipStream_t kernel_stream = nu
 
 template <bool should_synchronize, typename F>
 void MemcpyHostToDeviceShell(F memcpy_func, const hipStream_t kernel_stream = nullptr) {
+  hip::PooledAllocations pooled_allocations;
   using LA = LinearAllocs;
   const auto allocation_size = GENERATE(kPageSize / 2, kPageSize, kPageSize * 2);
   const auto host_allocation_type = GENERATE(LA::malloc, LA::hipHostMalloc);
@@ -103,15 +125,12 @@ void MemcpyHostToDeviceShell(F memcpy_func, const hipStream_t kernel_stream = nu
 
 template <bool should_synchronize, typename F>
 void MemcpyHostToHostShell(F memcpy_func, const hipStream_t kernel_stream = nullptr) {
-  using LA = LinearAllocs;
-  const auto allocation_size = GENERATE(kPageSize / 2, kPageSize, kPageSize * 2);
-  const auto src_allocation_type = GENERATE(LA::malloc, LA::hipHostMalloc);
-  const auto dst_allocation_type = GENERATE(LA::malloc, LA::hipHostMalloc);
-  const auto src_allocation_flags = GenerateLinearAllocationFlagCombinations(src_allocation_type);
-  const auto dst_allocation_flags = GenerateLinearAllocationFlagCombinations(dst_allocation_type);
+  hip::PooledAllocations pooled_allocations;
+  const auto [allocation_size, src_host, dst_host] = GENERATE(from_range(hip::Combinations(
+      ShellAllocationSizes(), HostAllocationVariants(), HostAllocationVariants())));
 
-  LinearAllocGuard<int> src_allocation(src_allocation_type, allocation_size, src_allocation_flags);
-  LinearAllocGuard<int> dst_allocation(dst_allocation_type, allocation_size, dst_allocation_flags);
+  LinearAllocGuard<int> src_allocation(src_host.type, allocation_size, src_host.flags);
+  LinearAllocGuard<int> dst_allocation(dst_host.type, allocation_size, dst_host.flags);
 
   const auto element_count = allocation_size / sizeof(*src_allocation.host_ptr());
   constexpr auto expected_value = 42;
@@ -127,10 +146,11 @@ void MemcpyHostToHostShell(F memcpy_func, const hipStream_t kernel_stream = null
 
 template <bool should_synchronize, bool enable_peer_access, typename F>
 void MemcpyDeviceToDeviceShell(F memcpy_func, const hipStream_t kernel_stream = nullptr) {
-  const auto allocation_size = GENERATE(kPageSize / 2, kPageSize, kPageSize * 2);
+  hip::PooledAllocations pooled_allocations;
   const auto device_count = HipTest::getDeviceCount();
-  const auto src_device = GENERATE_COPY(range(0, device_count));
-  const auto dst_device = GENERATE_COPY(range(0, device_count));
+  const auto [allocation_size, src_device, dst_device] =
+      GENERATE_COPY(from_range(hip::Combinations(
+          ShellAllocationSizes(), hip::Range(0, device_count), hip::Range(0, device_count))));
   INFO("Src device: " << src_device << ", Dst device: " << dst_device);
 
   HIP_CHECK(hipSetDevice(src_device));
@@ -138,6 +158,10 @@ void MemcpyDeviceToDeviceShell(F memcpy_func, const hipStream_t kernel_stream =
     if (src_device == dst_device) {
       return;
     }
+    // HT_PEER_PAIRS narrows the peer pairs down to the best, worst or xGMI connected ones
+    if (!hip::DeviceTopology::get().isSelected(src_device, dst_device, hip::PeerPairSelection())) {
+      return;
+    }
     int can_access_peer = 0;
     HIP_CHECK(hipDeviceCanAccessPeer(&can_access_peer, src_device, dst_device));
     if (!can_access_peer) {
@@ -25,6 +25,7 @@ THE SOFTWARE.
 #include <variant>
 
 #include <hip_test_common.hh>
+#include <hip_test_combinations.hh>
 #include <hip/hip_runtime_api.h>
 #include <utils.hh>
 #include <resource_guards.hh>
@@ -161,14 +162,14 @@ void Memcpy3DDeviceToHostShell(F memcpy_func, const hipStream_t kernel_stream =
 
 template <bool should_synchronize, bool enable_peer_access, typename F>
 void Memcpy3DDeviceToDeviceShell(F memcpy_func, const hipStream_t kernel_stream = nullptr) {
-  const auto kind = GENERATE(hipMemcpyDeviceToDevice, hipMemcpyDefault);
-
   constexpr hipExtent extent{127 * sizeof(int), 128, 8};
 
   const auto device_count = HipTest::getDeviceCount();
-  const auto src_device = GENERATE_COPY(range(0, device_count));
-  const auto dst_device = GENERATE_COPY(range(0, device_count));
-  const size_t src_cols_mult = GENERATE(1, 2);
+  const auto [kind, src_device, dst_device, src_cols_mult] = GENERATE_COPY(
+      from_range(hip::Combinations(std::vector<hipMemcpyKind>{hipMemcpyDeviceToDevice,
+                                                              hipMemcpyDefault},
+                                   hip::Range(0, device_count), hip::Range(0, device_count),
+                                   std::vector<size_t>{1, 2})));
 
   INFO("Src device: " << src_device << ", Dst device: " << dst_device);
 
@@ -20,6 +20,7 @@ THE SOFTWARE.
 #pragma once
 
 #include <hip_array_common.hh>
+#include <hip_test_buffer_pool.hh>
 #include <hip_test_common.hh>
 #include <hip/hip_runtime_api.h>
 
@@ -36,6 +37,9 @@ template <typename T> class LinearAllocGuard {
   LinearAllocGuard(const LinearAllocs allocation_type, const size_t size,
                    const unsigned int flags = 0u)
       : allocation_type_{allocation_type} {
+    if (hip::BufferPool::active() && acquirePooled(size, flags)) {
+      return;
+    }
     switch (allocation_type_) {
       case LinearAllocs::malloc:
         ptr_ = host_ptr_ = reinterpret_cast<T*>(malloc(size));
@@ -62,6 +66,10 @@ template <typename T> class LinearAllocGuard {
   LinearAllocGuard(LinearAllocGuard&&) = delete;
 
   ~LinearAllocGuard() {
+    if (pooled_) {
+      hip::BufferPool::get().release(ptr_);
+      return;
+    }
     // No Catch macros, don't want to possibly throw in the destructor
     switch (allocation_type_) {
       case LinearAllocs::malloc:
@@ -85,9 +93,32 @@ template <typename T> class LinearAllocGuard {
   T* host_ptr() const { return host_ptr_; }
 
  private:
+  // Takes the block from hip::BufferPool for the allocation types it caches
+  bool acquirePooled(const size_t size, const unsigned int flags) {
+    hip::PoolMemory kind;
+    switch (allocation_type_) {
+      case LinearAllocs::hipHostMalloc:
+        kind = hip::PoolMemory::pinnedHost;
+        break;
+      case LinearAllocs::hipMalloc:
+        kind = hip::PoolMemory::device;
+        break;
+      case LinearAllocs::hipMallocManaged:
+        kind = hip::PoolMemory::managed;
+        break;
+      default:
+        return false;
+    }
+    ptr_ = reinterpret_cast<T*>(hip::BufferPool::get().acquire(kind, size, flags));
+    if (allocation_type_ != LinearAllocs::hipMalloc) host_ptr_ = ptr_;
+    pooled_ = true;
+    return true;
+  }
+
   const LinearAllocs allocation_type_;
   T* ptr_ = nullptr;
   T* host_ptr_ = nullptr;
+  bool pooled_ = false;
 };
 
 template <typename T> class LinearAllocGuardMultiDim {
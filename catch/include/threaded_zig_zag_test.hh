@@ -21,10 +21,54 @@ THE SOFTWARE.
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <thread>
 
+/*
+Handoff policies: waitFor(turn) blocks until another thread called pass(turn). CondVarHandoff
+sleeps on a condition variable, SpinHandoff busy waits on an atomic and trades a core for a
+lower wake up latency, yielding only when the other thread takes long.
+*/
+class CondVarHandoff {
+ public:
+  void waitFor(int turn) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this, turn] { return turn_ == turn; });
+  }
+
+  void pass(int turn) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      turn_ = turn;
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  int turn_ = -1;
+};
+
+class SpinHandoff {
+ public:
+  void waitFor(int turn) {
+    // Yields after a while, spinning on a core the other thread needs would never end
+    for (unsigned int spins = 0; turn_.load(std::memory_order_acquire) != turn; spins++) {
+      if (spins >= kSpinsBeforeYield) std::this_thread::yield();
+    }
+  }
+
+  void pass(int turn) { turn_.store(turn, std::memory_order_release); }
+
+ private:
+  static constexpr unsigned int kSpinsBeforeYield = 4096;
+  std::atomic<int> turn_{-1};
+};
+
 /*
 Guarantees total ordering between parent and child thread
 PARENT      CHILD
@@ -51,10 +95,11 @@ class DerivedTestClass : public ThreadedZigZagTest<DerivedTestClass> {
   void TestPart3() {...}
   void TestPart4() {...}
 };
-The derived class can contain state that the test requires.
+The derived class can contain state that the test requires. The second template argument
+selects how the threads hand over, CondVarHandoff by default.
 */
 
-template <typename T> class ThreadedZigZagTest {
+template <typename T, typename Handoff = CondVarHandoff> class ThreadedZigZagTest {
  public:
   void run() {
     // 1.
@@ -64,34 +109,19 @@ template <typename T> class ThreadedZigZagTest {
       // 2.
       static_cast<T*>(this)->TestPart2();
 
-      {
-        std::lock_guard<std::mutex> lock(mtx_);
-        ready_ = true;
-      }
-      cv_.notify_one();
-
-      {
-        std::unique_lock<std::mutex> lock(mtx_);
-        cv_.wait(lock, [this] { return !ready_; });
-      }
+      handoff_.pass(kParent);
+      handoff_.waitFor(kChild);
 
       // 4.
       static_cast<T*>(this)->TestPart4();
     });
 
-    {
-      std::unique_lock<std::mutex> lock(mtx_);
-      cv_.wait(lock, [this] { return ready_; });
-    }
+    handoff_.waitFor(kParent);
 
     // 3.
     static_cast<T*>(this)->TestPart3();
 
-    {
-      std::lock_guard<std::mutex> lock(mtx_);
-      ready_ = false;
-    }
-    cv_.notify_one();
+    handoff_.pass(kChild);
 
     // Finalize
     t.join();
@@ -104,7 +134,53 @@ template <typename T> class ThreadedZigZagTest {
   void TestPart4() const {}
 
  private:
-  std::mutex mtx_;
-  std::condition_variable cv_;
-  bool ready_ = false;
-};
\ No newline at end of file
+  static constexpr int kParent = 0;
+  static constexpr int kChild = 1;
+  Handoff handoff_;
+};
+
+/*
+The zig-zag with a persistent second thread, for measuring handoffs without thread creation:
+every roundTrip() hands over to the partner thread, which runs work and hands back.
+
+ThreadHandoffPartner<SpinHandoff> partner([&] { HIP_CHECK_THREAD(hipEventSynchronize(event)); });
+BENCHMARK("handoff") { partner.roundTrip(); };
+
+work must report errors with the _THREAD macros; call HIP_CHECK_THREAD_FINALIZE after the
+partner is destroyed.
+*/
+template <typename Handoff = CondVarHandoff> class ThreadHandoffPartner {
+ public:
+  explicit ThreadHandoffPartner(std::function<void()> work)
+      : work_(std::move(work)), thread_([this] {
+          while (true) {
+            handoff_.waitFor(kPartner);
+            if (stop_.load()) return;
+            work_();
+            handoff_.pass(kCaller);
+          }
+        }) {}
+
+  ~ThreadHandoffPartner() {
+    stop_.store(true);
+    handoff_.pass(kPartner);
+    thread_.join();
+  }
+
+  ThreadHandoffPartner(const ThreadHandoffPartner&) = delete;
+  ThreadHandoffPartner& operator=(const ThreadHandoffPartner&) = delete;
+
+  // Hands over to the partner and blocks until its work has run
+  void roundTrip() {
+    handoff_.pass(kPartner);
+    handoff_.waitFor(kCaller);
+  }
+
+ private:
+  static constexpr int kCaller = 0;
+  static constexpr int kPartner = 1;
+  Handoff handoff_;
+  std::atomic<bool> stop_{false};
+  std::function<void()> work_;
+  std::thread thread_;  // Last, starts once everything it uses is constructed
+};
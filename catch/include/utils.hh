@@ -20,12 +20,16 @@ THE SOFTWARE.
 #pragma once
 
 #include <chrono>
+#include <climits>
+#include <vector>
 
 #include <hip_test_common.hh>
 #include <hip/hip_runtime_api.h>
 
 namespace {
 inline constexpr size_t kPageSize = 4096;
+// Buffers from this size on are verified on the device instead of being copied back
+inline constexpr size_t kDeviceVerifyThreshold = 64 * 1024 * 1024;
 }  // anonymous namespace
 
 template <typename T>
@@ -54,6 +58,119 @@ void ArrayFindIfNot(T* const array, const T expected_value, const size_t num_ele
   ArrayFindIfNot(array, array + num_elements, expected_value);
 }
 
+// Mismatch count and lowest mismatching index of a device side compare, first is ULLONG_MAX
+// when nothing mismatched
+struct DeviceMismatch {
+  unsigned long long count;
+  unsigned long long first;
+};
+
+template <typename T>
+__global__ void CountMismatches(const T* const vec, const T expected_value, size_t N,
+                                DeviceMismatch* const result) {
+  size_t offset = (blockIdx.x * blockDim.x + threadIdx.x);
+  size_t stride = blockDim.x * gridDim.x;
+
+  unsigned long long count = 0;
+  unsigned long long first = ULLONG_MAX;
+  for (size_t i = offset; i < N; i += stride) {
+    if (!(vec[i] == expected_value)) {
+      if (count++ == 0) first = i;
+    }
+  }
+  // Only threads that saw a mismatch touch the result
+  if (count) {
+    atomicAdd(&result->count, count);
+    atomicMin(&result->first, first);
+  }
+}
+
+template <typename T>
+__global__ void CountMismatches(const T* const expected, const T* const actual, size_t N,
+                                DeviceMismatch* const result) {
+  size_t offset = (blockIdx.x * blockDim.x + threadIdx.x);
+  size_t stride = blockDim.x * gridDim.x;
+
+  unsigned long long count = 0;
+  unsigned long long first = ULLONG_MAX;
+  for (size_t i = offset; i < N; i += stride) {
+    if (!(expected[i] == actual[i])) {
+      if (count++ == 0) first = i;
+    }
+  }
+  if (count) {
+    atomicAdd(&result->count, count);
+    atomicMin(&result->first, first);
+  }
+}
+
+// Launches CountMismatches with args on stream and returns its result
+template <typename... Args>
+DeviceMismatch LaunchCountMismatches(const size_t N, const hipStream_t stream, Args... args) {
+  DeviceMismatch result{0, ULLONG_MAX};
+  DeviceMismatch* result_d = nullptr;
+  HIP_CHECK(hipMalloc(&result_d, sizeof(result)));
+  HIP_CHECK(hipMemcpyAsync(result_d, &result, sizeof(result), hipMemcpyHostToDevice, stream));
+
+  constexpr size_t thread_count = 256;
+  const size_t block_count =
+      std::max<size_t>(1, std::min<size_t>((N + thread_count - 1) / thread_count, 4096));
+  CountMismatches<<<block_count, thread_count, 0, stream>>>(args..., N, result_d);
+  HIP_CHECK(hipGetLastError());
+
+  HIP_CHECK(hipMemcpyAsync(&result, result_d, sizeof(result), hipMemcpyDeviceToHost, stream));
+  HIP_CHECK(hipStreamSynchronize(stream));
+  HIP_CHECK(hipFree(result_d));
+  return result;
+}
+
+// ArrayFindIfNot for device accessible memory (device, pinned host or managed). Buffers below
+// kDeviceVerifyThreshold are copied back and checked on the host, larger ones are compared
+// on the device and only the mismatch count and first index are copied back.
+template <typename T>
+void DeviceArrayFindIfNot(const T* const ptr, const T expected_value, const size_t num_elements,
+                          const hipStream_t stream = nullptr) {
+  if (num_elements * sizeof(T) < kDeviceVerifyThreshold) {
+    std::vector<T> host(num_elements);
+    HIP_CHECK(hipStreamSynchronize(stream));
+    HIP_CHECK(hipMemcpy(host.data(), ptr, num_elements * sizeof(T), hipMemcpyDefault));
+    ArrayFindIfNot(host.data(), expected_value, num_elements);
+    return;
+  }
+
+  const auto mismatch = LaunchCountMismatches(num_elements, stream, ptr, expected_value);
+  if (mismatch.count) {
+    T actual;
+    HIP_CHECK(hipMemcpy(&actual, ptr + mismatch.first, sizeof(T), hipMemcpyDefault));
+    INFO(mismatch.count << " mismatches, first at index " << mismatch.first);
+    REQUIRE(expected_value == actual);
+  }
+}
+
+// ArrayMismatch for device accessible memory, split between host and device as
+// DeviceArrayFindIfNot
+template <typename T>
+void DeviceArrayMismatch(const T* const expected, const T* const actual,
+                         const size_t num_elements, const hipStream_t stream = nullptr) {
+  if (num_elements * sizeof(T) < kDeviceVerifyThreshold) {
+    std::vector<T> expected_h(num_elements), actual_h(num_elements);
+    HIP_CHECK(hipStreamSynchronize(stream));
+    HIP_CHECK(hipMemcpy(expected_h.data(), expected, num_elements * sizeof(T), hipMemcpyDefault));
+    HIP_CHECK(hipMemcpy(actual_h.data(), actual, num_elements * sizeof(T), hipMemcpyDefault));
+    ArrayMismatch(expected_h.data(), actual_h.data(), num_elements);
+    return;
+  }
+
+  const auto mismatch = LaunchCountMismatches(num_elements, stream, expected, actual);
+  if (mismatch.count) {
+    T expected_value, actual_value;
+    HIP_CHECK(hipMemcpy(&expected_value, expected + mismatch.first, sizeof(T), hipMemcpyDefault));
+    HIP_CHECK(hipMemcpy(&actual_value, actual + mismatch.first, sizeof(T), hipMemcpyDefault));
+    INFO(mismatch.count << " mismatches, first at index " << mismatch.first);
+    REQUIRE(expected_value == actual_value);
+  }
+}
+
 template <typename T, typename F>
 void PitchedMemoryVerify(T* const ptr, const size_t pitch, const size_t width, const size_t height,
                          const size_t depth, F expected_value_generator) {
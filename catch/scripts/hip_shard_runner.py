@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+# Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+"""Runs a catch test executable as parallel shards, one per GPU.
+
+Every shard is a separate process with HT_SHARD_INDEX, HT_SHARD_COUNT and
+HT_SHARD_DEVICES set; TestContext uses them to pick its part of the tests and
+to restrict the process to one device. Each shard writes a JUnit report, the
+reports are merged into one file at the end.
+
+With --profile every shard records per test timings (HT_PROFILE), merged into
+one report afterwards. Passing that report to --durations on the next run
+balances the shards by recorded wall time instead of by test count.
+
+With --server every shard is a long lived test server (HT_TEST_SERVER) that
+keeps the HIP runtime initialized, and the shards take tests one at a time
+from a shared queue, longest recorded duration first with --durations. Every
+test gets its own report; a test that crashes its server is reported as an
+error and the server is restarted for the remaining tests.
+
+Usage:
+  hip_shard_runner.py [--shards N] [--devices 0,1,..] [--output merged.xml]
+                      [--profile times.csv] [--durations times.csv] [--server]
+                      <test executable> [catch arguments...]
+"""
+
+import argparse
+import csv
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+import xml.etree.ElementTree as ET
+
+
+def run_tool(tool, args):
+    path = shutil.which(tool) or shutil.which(tool, path="/opt/rocm/bin")
+    if not path:
+        return ""
+    try:
+        return subprocess.run([path] + args, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                              universal_newlines=True).stdout
+    except OSError:
+        return ""
+
+
+def detect_devices():
+    """Returns the device indices visible on this node, at least one."""
+    agents = run_tool("rocm_agent_enumerator", []).split()
+    count = len([a for a in agents if a.startswith("gfx") and a != "gfx000"])
+    if count == 0:
+        gpus = run_tool("nvidia-smi", ["-L"]).splitlines()
+        count = len([g for g in gpus if g.startswith("GPU ")])
+    return [str(i) for i in range(max(count, 1))]
+
+
+def merge_junit(reports, output):
+    """Merges the testsuite elements of every shard report into one testsuites root."""
+    merged = ET.Element("testsuites")
+    totals = {"tests": 0, "failures": 0, "errors": 0, "skipped": 0}
+    time = 0.0
+    for report in reports:
+        try:
+            root = ET.parse(report).getroot()
+        except (ET.ParseError, OSError):
+            # A crashed shard leaves no or a truncated report, count it as an error
+            totals["errors"] += 1
+            continue
+        suites = [root] if root.tag == "testsuite" else root.findall("testsuite")
+        for suite in suites:
+            for key in totals:
+                totals[key] += int(suite.get(key, 0))
+            time += float(suite.get("time", 0))
+            merged.append(suite)
+    for key, value in totals.items():
+        merged.set(key, str(value))
+    merged.set("time", "%.3f" % time)
+    ET.ElementTree(merged).write(output, encoding="UTF-8", xml_declaration=True)
+    return totals
+
+
+def merge_profiles(shard_profiles, output):
+    """Merges the HT_PROFILE reports of all shards into output, newest entry per test wins."""
+    header = ["test", "wall_ms", "hip_api_ms", "gpu_ms", "passed"]
+    entries = {}
+    for path in [output] + shard_profiles:
+        if not os.path.exists(path):
+            continue
+        with open(path, newline="") as report:
+            for row in csv.DictReader(report):
+                entries[row["test"]] = row
+    rows = sorted(entries.values(), key=lambda row: float(row["wall_ms"]), reverse=True)
+    with open(output + ".tmp", "w", newline="") as report:
+        writer = csv.DictWriter(report, fieldnames=header, quoting=csv.QUOTE_MINIMAL,
+                                extrasaction="ignore")
+        writer.writeheader()
+        writer.writerows(rows)
+    os.replace(output + ".tmp", output)
+    for path in shard_profiles:
+        if os.path.exists(path):
+            os.remove(path)
+
+
+def escape_test_name(name):
+    """Escapes the characters Catch2's test spec parser would interpret, as main.cc does."""
+    return "".join("\\" + c if c in "\\,[]\"~" else c for c in name)
+
+
+def list_tests(executable, catch_args):
+    """Returns the names of the tests the catch arguments select, in listing order."""
+    out = subprocess.run([executable] + catch_args + ["--list-test-names-only"],
+                         stdout=subprocess.PIPE, stderr=subprocess.DEVNULL,
+                         universal_newlines=True).stdout
+    return [line.strip() for line in out.splitlines()
+            if line.strip() and line.strip() != "HIP_SKIP_THIS_TEST"]
+
+
+def read_durations(path):
+    """Recorded wall time in ms by test name from an HT_PROFILE report."""
+    if not path or not os.path.exists(path):
+        return {}
+    with open(path, newline="") as report:
+        return {row["test"]: float(row["wall_ms"]) for row in csv.DictReader(report)}
+
+
+def write_crash_report(path, suite, test, code):
+    """Writes the JUnit report of a test whose server exited before finishing it."""
+    root = ET.Element("testsuite", name=suite, tests="1", failures="0", errors="1",
+                      skipped="0", time="0")
+    case = ET.SubElement(root, "testcase", classname=suite, name=test, time="0")
+    ET.SubElement(case, "error", message="test server exited with %s while running the test" %
+                  code)
+    ET.ElementTree(root).write(path, encoding="UTF-8", xml_declaration=True)
+
+
+class TestServer:
+    """One HT_TEST_SERVER process, restarted when a test takes it down."""
+
+    def __init__(self, cmd, env, log):
+        self.cmd = cmd
+        self.env = env
+        self.log = log
+        self.proc = None
+
+    def _read_until(self, marker):
+        for line in self.proc.stdout:
+            if line.startswith(marker):
+                return line
+            self.log.write(line)
+        return None
+
+    def start(self):
+        self.proc = subprocess.Popen(self.cmd, env=self.env, stdin=subprocess.PIPE,
+                                     stdout=subprocess.PIPE, stderr=self.log,
+                                     universal_newlines=True, bufsize=1)
+        return self._read_until("HT_SERVER_READY") is not None
+
+    def run(self, test, report):
+        """Runs one test, returns the number of failed tests or None if the server died."""
+        if self.proc is None or self.proc.poll() is not None:
+            if not self.start():
+                return None
+        self.log.write("=== %s\n" % test)
+        try:
+            self.proc.stdin.write("%s\t%s\n" % (report, escape_test_name(test)))
+            self.proc.stdin.flush()
+        except OSError:
+            return None
+        done = self._read_until("HT_SERVER_DONE")
+        if done is None:
+            return None
+        return int(done.split()[1])
+
+    def exit_code(self):
+        self.proc.wait()
+        code = self.proc.returncode
+        self.proc = None
+        return code
+
+    def stop(self):
+        if self.proc is None:
+            return
+        try:
+            self.proc.stdin.write("quit\n")
+            self.proc.stdin.close()
+        except OSError:
+            pass
+        self.proc.wait()
+        self.proc = None
+
+
+def run_shards(args, devices, shards, log_dir, base_env):
+    """Runs one process per shard, each on its part of the tests, returns (status, reports)."""
+    procs = []
+    reports = []
+    for index in range(shards):
+        env = dict(base_env)
+        env["HT_SHARD_INDEX"] = str(index)
+        if args.durations:
+            env["HT_SHARD_DURATIONS"] = os.path.abspath(args.durations)
+        report = os.path.join(log_dir, "shard_%d.xml" % index)
+        log = open(os.path.join(log_dir, "shard_%d.log" % index), "w")
+        cmd = [args.executable] + args.catch_args + ["--reporter", "junit", "--out", report]
+        procs.append((subprocess.Popen(cmd, env=env, stdout=log, stderr=subprocess.STDOUT), log))
+        reports.append(report)
+
+    status = 0
+    for index, (proc, log) in enumerate(procs):
+        code = proc.wait()
+        log.close()
+        print("shard %d on device %s exited with %d" %
+              (index, devices[index % len(devices)], code))
+        if code != 0:
+            status = 1
+        elif not os.path.exists(reports[index]):
+            reports[index] = None  # Shard without tests, nothing to merge
+
+    return status, [r for r in reports if r is not None]
+
+
+def run_servers(args, devices, shards, log_dir, base_env):
+    """Runs the selected tests on one test server per shard, returns (status, reports)."""
+    tests = list_tests(args.executable, args.catch_args)
+    durations = read_durations(args.durations)
+    if durations:
+        tests.sort(key=lambda test: durations.get(test, 0.0), reverse=True)
+    suite = os.path.basename(args.executable)
+    lock = threading.Lock()
+    queue = list(enumerate(tests))
+    reports = []
+    status = [0]
+
+    def serve(index):
+        env = dict(base_env)
+        env["HT_SHARD_INDEX"] = str(index)
+        env["HT_TEST_SERVER"] = "1"
+        cmd = [args.executable] + args.catch_args + ["--reporter", "junit"]
+        with open(os.path.join(log_dir, "shard_%d.log" % index), "w") as log:
+            server = TestServer(cmd, env, log)
+            ran = 0
+            while True:
+                with lock:
+                    if not queue:
+                        break
+                    number, test = queue.pop(0)
+                report = os.path.join(log_dir, "test_%d.xml" % number)
+                failed = server.run(test, report)
+                if failed is None:
+                    code = server.exit_code() if server.proc is not None else "an error"
+                    write_crash_report(report, suite, test, code)
+                    print("shard %d: %s took down the test server (%s), restarting" %
+                          (index, test, code))
+                ran += 1
+                with lock:
+                    reports.append(report)
+                    if failed != 0:
+                        status[0] = 1
+            server.stop()
+        print("shard %d on device %s ran %d tests" % (index, devices[index % len(devices)], ran))
+
+    threads = [threading.Thread(target=serve, args=(index,)) for index in range(shards)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    return status[0], sorted(reports)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--shards", type=int, default=0,
+                        help="number of shards, defaults to one per device")
+    parser.add_argument("--devices", default="",
+                        help="comma separated device indices, defaults to all detected")
+    parser.add_argument("--output", default="junit.xml", help="merged JUnit report")
+    parser.add_argument("--log-dir", default="",
+                        help="directory for per shard logs and reports, temporary if not set")
+    parser.add_argument("--profile", default="",
+                        help="merge per test timings of all shards into this csv report")
+    parser.add_argument("--durations", default="",
+                        help="csv report of a previous --profile run used to balance shards")
+    parser.add_argument("--server", action="store_true",
+                        help="run the tests on persistent test servers fed from one queue")
+    parser.add_argument("executable")
+    parser.add_argument("catch_args", nargs=argparse.REMAINDER)
+    args = parser.parse_args()
+
+    devices = [d for d in args.devices.split(",") if d] or detect_devices()
+    shards = args.shards if args.shards > 0 else len(devices)
+    log_dir = args.log_dir or tempfile.mkdtemp(prefix="hip_shards_")
+    os.makedirs(log_dir, exist_ok=True)
+
+    base_env = dict(os.environ)
+    base_env["HT_SHARD_COUNT"] = str(shards)
+    base_env["HT_SHARD_DEVICES"] = ",".join(devices)
+    if args.profile:
+        base_env["HT_PROFILE"] = args.profile
+
+    if args.server:
+        status, reports = run_servers(args, devices, shards, log_dir, base_env)
+    else:
+        status, reports = run_shards(args, devices, shards, log_dir, base_env)
+
+    if args.profile:
+        merge_profiles(["%s.shard%d" % (args.profile, i) for i in range(shards)], args.profile)
+
+    totals = merge_junit(reports, args.output)
+    print("%d tests, %d failures, %d errors; report: %s, logs: %s" %
+          (totals["tests"], totals["failures"], totals["errors"], args.output, log_dir))
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
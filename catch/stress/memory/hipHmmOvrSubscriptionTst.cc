@@ -26,6 +26,7 @@ THE SOFTWARE.
 #include <hip_test_common.hh>
 #include <hip_test_helper.hh>
 #include <hip_test_process.hh>
+#include <hip_test_soak.hh>
 
 __global__ void floatx2(float* ptr, size_t size) {
   auto i = blockIdx.x * blockDim.x + threadIdx.x;
@@ -96,17 +97,22 @@ TEST_CASE("Stress_HMM_OverSubscriptionTst") {
       HIP_CHECK_THREAD(hipStreamDestroy(stream));
     };
 
-    std::vector<std::thread> thread_pool;
-    thread_pool.reserve(max_mem_used);
+    // hold_memory keeps its allocation for the whole HT_SOAK_DURATION as well
+    hip::Soak soak("Stress_HMM_OverSubscriptionTst", "GB");
+    do {
+      std::vector<std::thread> thread_pool;
+      thread_pool.reserve(max_mem_used);
 
-    for (size_t i = 0; i < max_mem_used; i++) {
-      thread_pool.emplace_back(std::thread(OneGBTest));
-    }
+      for (size_t i = 0; i < max_mem_used; i++) {
+        thread_pool.emplace_back(std::thread(OneGBTest));
+      }
 
-    std::for_each(thread_pool.begin(), thread_pool.end(),
-                  [](std::thread& thread) { thread.join(); });
+      std::for_each(thread_pool.begin(), thread_pool.end(),
+                    [](std::thread& thread) { thread.join(); });
 
-    HIP_CHECK_THREAD_FINALIZE();
+      HIP_CHECK_THREAD_FINALIZE();
+      soak.add(max_mem_used);
+    } while (soak.next());
     REQUIRE(proc.wait() == 0);
   } else {
     HipTest::HIP_SKIP_TEST("Tests only supposed to run on xnack+ devices");
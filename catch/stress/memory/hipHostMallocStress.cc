@@ -19,6 +19,7 @@ THE SOFTWARE.
 
 #include "hip_test_common.hh"
 #include "hip_test_helper.hh"
+#include "hip_test_soak.hh"
 
 // Stress allocation tests
 // Try to allocate as much memory as possible
@@ -32,21 +33,27 @@ TEST_CASE("Stress_hipHostMalloc_MaxAllocation") {
   REQUIRE(devMemAvail > 0);
   REQUIRE(hostMemFree > 0);
 
-  size_t memFree = std::min(devMemFree, hostMemFree);  // which is the limiter cpu or gpu
-  char* d_ptr{nullptr};
-  size_t counter{0};
+  hip::Soak soak("Stress_hipHostMalloc_MaxAllocation", "allocations");
+  // Every soak pass starts from the full size again, so fragmentation shows as more retries
+  do {
+    size_t memFree = std::min(devMemFree, hostMemFree);  // which is the limiter cpu or gpu
+    char* d_ptr{nullptr};
+    size_t counter{0};
 
-  INFO("Max Allocation of " << memFree << " bytes!");
-  while (hipHostMalloc(&d_ptr, memFree) != hipSuccess && memFree > 1) {
-    counter++;
-    INFO("Attempt to allocate " << memFree << " bytes out of " << devMemFree << "bytes Failed!");
-    memFree >>= 1;          // reduce the memory to be allocated by half
-    REQUIRE(counter <= 2);  // Make sure that we are atleast able to allocate 1/4th of max memory
-  }
+    INFO("Max Allocation of " << memFree << " bytes!");
+    while (hipHostMalloc(&d_ptr, memFree) != hipSuccess && memFree > 1) {
+      counter++;
+      INFO("Attempt to allocate " << memFree << " bytes out of " << devMemFree
+                                  << "bytes Failed!");
+      memFree >>= 1;          // reduce the memory to be allocated by half
+      REQUIRE(counter <= 2);  // Make sure that we are atleast able to allocate 1/4th of max memory
+    }
 
-  HIP_CHECK(hipMemset(d_ptr, 1, memFree));
-  HIP_CHECK(hipDeviceSynchronize());  // Flush caches
-  REQUIRE(std::all_of(d_ptr, d_ptr + memFree, [](unsigned char n) { return n == 1; }));
-  HIP_CHECK(hipHostFree(d_ptr));
+    HIP_CHECK(hipMemset(d_ptr, 1, memFree));
+    HIP_CHECK(hipDeviceSynchronize());  // Flush caches
+    REQUIRE(std::all_of(d_ptr, d_ptr + memFree, [](unsigned char n) { return n == 1; }));
+    HIP_CHECK(hipHostFree(d_ptr));
+    soak.add(1);
+  } while (soak.next());
 }
 
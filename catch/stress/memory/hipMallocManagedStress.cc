@@ -31,6 +31,7 @@
 
 #include <hip_test_common.hh>
 #include <hip_test_checkers.hh>
+#include <utils.hh>
 
 #define INCRMNT 10
 // Kernel function
@@ -69,58 +70,37 @@ __global__ void KernelMul_MngdMem(int *Hmm, int *Dptr, size_t n) {
 }
 
 static void LaunchKrnl4(size_t NumElms, int InitVal) {
-  int *Hmm = NULL, *Dptr = NULL, blockSize = 64, DataMismatch = 0;
+  int *Hmm = NULL, *Dptr = NULL, blockSize = 64;
   hipStream_t strm;
   HIP_CHECK(hipStreamCreate(&strm));
   HIP_CHECK(hipMallocManaged(&Hmm, (sizeof(int) * NumElms)));
   HIP_CHECK(hipMalloc(&Dptr, (sizeof(int) * NumElms)));
-  int *Hstptr = reinterpret_cast<int*>(new int[NumElms]);
-  for (size_t i = 0; i < NumElms; ++i) {
-    Hstptr[i] = InitVal;
-  }
-  HIP_CHECK(hipMemcpy(Dptr, Hstptr, (NumElms * sizeof(int)),
-                      hipMemcpyHostToDevice));
   dim3 dimBlock(blockSize, 1, 1);
   dim3 dimGrid((NumElms + blockSize -1)/blockSize, 1, 1);
+  // Filled on the device, a host buffer of the same size would take longer than the test
+  VectorSet<<<HipTest::initBlockCount(NumElms, 256), 256, 0, strm>>>(Dptr, InitVal, NumElms);
+  HIP_CHECK(hipGetLastError());
   KrnlWth2MemTypes<<<dimGrid, dimBlock, 0, strm>>>(Hmm, Dptr, NumElms);
   HIP_CHECK(hipStreamSynchronize(strm));
-  for (size_t i = 0; i < NumElms; ++i) {
-    if (Hmm[i] != (InitVal + 10)) {
-      DataMismatch++;
-    }
-  }
-  if (DataMismatch != 0) {
+  // Verified on the device, scanning GBs of managed memory on the host migrates it back
+  {
     INFO("Data Mismatch observed after the Kernel: KrnlWth2MemTypes!!\n");
-    REQUIRE(false);
+    DeviceArrayFindIfNot(Hmm, InitVal + 10, NumElms, strm);
   }
-  DataMismatch = 0;
   KernelMul_MngdMem<<<dimGrid, dimBlock, 0, strm>>>(Hmm, Dptr, NumElms);
   HIP_CHECK(hipStreamSynchronize(strm));
   // Verifying the result
-  for (size_t i = 0; i < NumElms; ++i) {
-    if (Hmm[i] != (InitVal * 10)) {
-      DataMismatch++;
-    }
-  }
-  if (DataMismatch != 0) {
+  {
     INFO("Data Mismatch observedafter the Kernel: KernelMul_MngdMem!!\n");
-    REQUIRE(false);
+    DeviceArrayFindIfNot(Hmm, InitVal * 10, NumElms, strm);
   }
-  DataMismatch = 0;
   KernelMulAdd_MngdMem<<<dimGrid, dimBlock, 0, strm>>>(Hmm, NumElms);
   HIP_CHECK(hipStreamSynchronize(strm));
   // Verifying the result
-
-  for (size_t i = 0; i < NumElms; ++i) {
-    if (Hmm[i] != (InitVal * 10 * 2 + 10)) {
-      DataMismatch++;
-    }
-  }
-  if (DataMismatch != 0) {
-    INFO("Data Mismatch observedafter the Kernel: KernelMul_MngdMem!!\n");
-    REQUIRE(false);
+  {
+    INFO("Data Mismatch observedafter the Kernel: KernelMulAdd_MngdMem!!\n");
+    DeviceArrayFindIfNot(Hmm, InitVal * 10 * 2 + 10, NumElms, strm);
   }
-  delete[] Hstptr;
 }
 
 static int HmmAttrPrint() {
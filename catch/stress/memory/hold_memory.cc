@@ -20,6 +20,8 @@
 #include <hip/hip_runtime.h>
 #include <iostream>
 #include <chrono>
+#include <cstdlib>
+#include <string>
 #include <thread>
 
 #define HIP_CHECK(call)                                                                            \
@@ -31,6 +33,21 @@
     }                                                                                              \
   }
 
+// Seconds in an HT_SOAK_DURATION/HT_SOAK_INTERVAL value (number with optional s, m, h or d)
+static double soakSeconds(const char* name) {
+  const char* text = std::getenv(name);
+  if (text == nullptr) return 0;
+  char* end = nullptr;
+  double value = std::strtod(text, &end);
+  std::string suffix(end);
+  if (end == text || value < 0) return 0;
+  if (suffix.empty() || suffix == "s") return value;
+  if (suffix == "m") return value * 60;
+  if (suffix == "h") return value * 3600;
+  if (suffix == "d") return value * 86400;
+  return 0;
+}
+
 int main() {
   size_t freeMem = 0, totalMem = 0;
   HIP_CHECK(hipMemGetInfo(&freeMem, &totalMem));
@@ -38,8 +55,21 @@ int main() {
   void* ptr;
   HIP_CHECK(hipMalloc(&ptr, 0.4 * totalMem));  // hold 40% of total gpu memory
   std::cout << "Sleeping..." << std::endl;
-  std::this_thread::sleep_for(
-      std::chrono::seconds(4));  //  sleep for few seconds till test complete
+  double soak = soakSeconds("HT_SOAK_DURATION");
+  if (soak > 0) {
+    // Hold the memory for as long as the soaking test repeats, reporting what is left free
+    double interval = soakSeconds("HT_SOAK_INTERVAL");
+    auto step = std::chrono::duration<double>(interval > 0 ? interval : 60.0);
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(soak);
+    while (std::chrono::steady_clock::now() < end) {
+      std::this_thread::sleep_for(step);
+      HIP_CHECK(hipMemGetInfo(&freeMem, &totalMem));
+      std::cout << "Holding, device free " << freeMem / (1024 * 1024) << " MB" << std::endl;
+    }
+  } else {
+    std::this_thread::sleep_for(
+        std::chrono::seconds(4));  //  sleep for few seconds till test complete
+  }
   std::cout << "Waking up..." << std::endl;
   HIP_CHECK(hipFree(ptr));
 }
\ No newline at end of file
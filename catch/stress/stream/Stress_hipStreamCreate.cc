@@ -18,6 +18,7 @@ THE SOFTWARE.
 */
 
 #include <hip_test_common.hh>
+#include <hip_test_soak.hh>
 #include <cstdio>
 #include <cassert>
 
@@ -56,7 +57,7 @@ int stream_seq[TOTALSEQ][4] = {
  * in SWDEV-237846.
 */
 
-void testhipStreamCreate(int *stream_sequence) {
+size_t testhipStreamCreate(int *stream_sequence) {
   printf("%s: Testing sequence %d->%d->%d->sync(%d) \n", __func__,
          stream_sequence[0], stream_sequence[1], stream_sequence[2],
          stream_sequence[3]);
@@ -85,14 +86,15 @@ void testhipStreamCreate(int *stream_sequence) {
   // Clean up
   HIP_CHECK(hipStreamDestroy(stream[1]));
   HIP_CHECK(hipStreamDestroy(stream[2]));
+  return 3 * NUM_ITER;  // Kernels launched
 }
 /**
  * Scenario: This test extends the above test by using 2 streams
  * (of highest and lowest priority) created using hipStreamCreateWithPriority
  * along with the default stream.
 */
-void testhipStreamCreatePriority(int *stream_sequence,
-                                 unsigned int flag) {
+size_t testhipStreamCreatePriority(int *stream_sequence,
+                                   unsigned int flag) {
   printf("%s: Testing sequence %d->%d->%d->sync(%d) \n", __func__,
          stream_sequence[0], stream_sequence[1], stream_sequence[2],
          stream_sequence[3]);
@@ -104,7 +106,7 @@ void testhipStreamCreatePriority(int *stream_sequence,
   HIP_CHECK(hipDeviceGetStreamPriorityRange(&priority_low, &priority_high));
   if (priority_low == priority_high) {
     printf("Exiting test since priorities are not supported \n");
-    return;
+    return 0;
   }
   HIP_CHECK(hipStreamCreateWithPriority(&stream[1],
           flag, priority_high));
@@ -130,13 +132,14 @@ void testhipStreamCreatePriority(int *stream_sequence,
   // Clean up
   HIP_CHECK(hipStreamDestroy(stream[1]));
   HIP_CHECK(hipStreamDestroy(stream[2]));
+  return 3 * NUM_ITER;  // Kernels launched
 }
 /**
  * Scenario: This test extends the above test by using 2 streams
  * created using hipStreamCreateWithFlags along with the default stream.
 */
-void testhipStreamCreateFlags(int *stream_sequence,
-                              unsigned int flag) {
+size_t testhipStreamCreateFlags(int *stream_sequence,
+                                unsigned int flag) {
   printf("%s: Testing sequence %d->%d->%d->sync(%d) \n", __func__,
          stream_sequence[0], stream_sequence[1], stream_sequence[2],
          stream_sequence[3]);
@@ -165,39 +168,49 @@ void testhipStreamCreateFlags(int *stream_sequence,
   // Clean up
   HIP_CHECK(hipStreamDestroy(stream[1]));
   HIP_CHECK(hipStreamDestroy(stream[2]));
+  return 3 * NUM_ITER;  // Kernels launched
 }
 }  // namespace hipStreamCreateStressTest
 
 TEST_CASE("Stress_hipStreamCreate_SyncTest") {
-  printf("hipStreamCreate stress test:\n");
-  for (int i = 0; i < TOTALSEQ; i++) {
-    hipStreamCreateStressTest::testhipStreamCreate(
-            hipStreamCreateStressTest::stream_seq[i]);
-  }
+  hip::Soak soak("Stress_hipStreamCreate_SyncTest", "launches");
+  do {
+    printf("hipStreamCreate stress test:\n");
+    for (int i = 0; i < TOTALSEQ; i++) {
+      soak.add(hipStreamCreateStressTest::testhipStreamCreate(
+              hipStreamCreateStressTest::stream_seq[i]));
+    }
+  } while (soak.next());
 }
 
 TEST_CASE("Stress_hipStreamCreatePriority_SyncTest") {
-  printf("hipStreamCreateWithPriority(hipStreamDefault) stress test:\n");
-  for (int i = 0; i < TOTALSEQ; i++) {
-    hipStreamCreateStressTest::testhipStreamCreatePriority(
-            hipStreamCreateStressTest::stream_seq[i], hipStreamDefault);
-  }
-  printf("hipStreamCreateWithPriority(hipStreamNonBlocking) stress test:\n");
-  for (int i = 0; i < TOTALSEQ; i++) {
-    hipStreamCreateStressTest::testhipStreamCreatePriority(
-            hipStreamCreateStressTest::stream_seq[i], hipStreamNonBlocking);
-  }
+  hip::Soak soak("Stress_hipStreamCreatePriority_SyncTest", "launches");
+  do {
+    printf("hipStreamCreateWithPriority(hipStreamDefault) stress test:\n");
+    for (int i = 0; i < TOTALSEQ; i++) {
+      soak.add(hipStreamCreateStressTest::testhipStreamCreatePriority(
+              hipStreamCreateStressTest::stream_seq[i], hipStreamDefault));
+    }
+    printf("hipStreamCreateWithPriority(hipStreamNonBlocking) stress test:\n");
+    for (int i = 0; i < TOTALSEQ; i++) {
+      soak.add(hipStreamCreateStressTest::testhipStreamCreatePriority(
+              hipStreamCreateStressTest::stream_seq[i], hipStreamNonBlocking));
+    }
+  } while (soak.next());
 }
 
 TEST_CASE("Stress_hipStreamCreateWithFlags_SyncTest") {
-  printf("hipStreamCreateWithFlags(hipStreamDefault) stress test:\n");
-  for (int i = 0; i < TOTALSEQ; i++) {
-    hipStreamCreateStressTest::testhipStreamCreateFlags(
-            hipStreamCreateStressTest::stream_seq[i], hipStreamDefault);
-  }
-  printf("hipStreamCreateWithFlags(hipStreamNonBlocking) stress test:\n");
-  for (int i = 0; i < TOTALSEQ; i++) {
-    hipStreamCreateStressTest::testhipStreamCreateFlags(
-            hipStreamCreateStressTest::stream_seq[i], hipStreamNonBlocking);
-  }
+  hip::Soak soak("Stress_hipStreamCreateWithFlags_SyncTest", "launches");
+  do {
+    printf("hipStreamCreateWithFlags(hipStreamDefault) stress test:\n");
+    for (int i = 0; i < TOTALSEQ; i++) {
+      soak.add(hipStreamCreateStressTest::testhipStreamCreateFlags(
+              hipStreamCreateStressTest::stream_seq[i], hipStreamDefault));
+    }
+    printf("hipStreamCreateWithFlags(hipStreamNonBlocking) stress test:\n");
+    for (int i = 0; i < TOTALSEQ; i++) {
+      soak.add(hipStreamCreateStressTest::testhipStreamCreateFlags(
+              hipStreamCreateStressTest::stream_seq[i], hipStreamNonBlocking));
+    }
+  } while (soak.next());
 }
@@ -18,6 +18,7 @@ THE SOFTWARE.
 */
 
 #include <hip_test_common.hh>
+#include <hip_test_soak.hh>
 
 #include <algorithm>
 #include <atomic>
@@ -75,6 +76,8 @@ TEST_CASE("Stress_StreamEnqueue_DifferentThreads") {
   std::uniform_int_distribution<std::mt19937::result_type> genWork(0, maxWork);
   std::uniform_int_distribution<std::mt19937::result_type> genVal(0, maxVal);
 
+  hip::Soak soak("Stress_StreamEnqueue_DifferentThreads", "launches");
+
   auto enqueueKernelThread = [&](hipStream_t stream) {
     auto iter = genWork(engine);  // Generate work to be done via thread
     for (unsigned long i = 0; i < iter; i++) {
@@ -83,7 +86,10 @@ TEST_CASE("Stress_StreamEnqueue_DifferentThreads") {
       hostData[index].data += val;    // Replicate it on host
       addVal<<<1, 1, 0, stream>>>(dPtr, static_cast<size_t>(index),
             static_cast<unsigned long long>(val));  // And on device
+      // Checked on every launch, so kept deferred to not throttle the enqueue rate
+      HIP_CHECK_DEFERRED(hipGetLastError());
     }
+    soak.add(iter);
   };
 
   hipStream_t stream{};
@@ -91,15 +97,21 @@ TEST_CASE("Stress_StreamEnqueue_DifferentThreads") {
   std::vector<std::thread> threadPool{};
   threadPool.reserve(hwThreads);
 
-  // Launch work
-  for (size_t i = 0; i < hwThreads; i++) {
-    threadPool.emplace_back(std::thread(enqueueKernelThread, stream));
-  }
+  // Results accumulate over soak passes on both sides and are validated once at the end
+  do {
+    // Launch work
+    for (size_t i = 0; i < hwThreads; i++) {
+      threadPool.emplace_back(std::thread(enqueueKernelThread, stream));
+    }
 
-  // Wait for work to finish
-  for (auto& i : threadPool) {
-    i.join();
-  }
+    // Wait for work to finish
+    for (auto& i : threadPool) {
+      i.join();
+    }
+    threadPool.clear();
+    HIP_CHECK_DEFERRED_FINALIZE();
+    HIP_CHECK(hipStreamSynchronize(stream));
+  } while (soak.next());
 
   HIP_CHECK(hipStreamDestroy(stream));
 
@@ -184,6 +196,8 @@ TEST_CASE("Stress_StreamEnqueue_DifferentThreads_MultiGPU") {
   std::mutex ness;  // On nvidia, current device needs to match stream's device
 #endif
 
+  hip::Soak soak("Stress_StreamEnqueue_DifferentThreads_MultiGPU", "launches");
+
   auto enqueueKernelThread = [&]() {
     for (size_t i = 0; i < maxWorkPerThread; i++) {
 #if HT_NVIDIA
@@ -192,8 +206,8 @@ TEST_CASE("Stress_StreamEnqueue_DifferentThreads_MultiGPU") {
       // Get a random stream
       hipStream_t stream = streamPool[genStream(engine)];
 
-      // TODO use HIP_CHECK_THREAD when PR#2664 is merged
-      if (hipSuccess != hipSetDevice(streamToDeviceIndex[stream])) {
+      HIP_CHECK_DEFERRED(hipSetDevice(streamToDeviceIndex[stream]));
+      if (HIP_CHECK_DEFERRED_FAILED()) {
         return;
       }
 
@@ -202,7 +216,9 @@ TEST_CASE("Stress_StreamEnqueue_DifferentThreads_MultiGPU") {
       streamToHostMemory[stream].data.fetch_add(val);
       auto dPtr = streamToDeviceMemory[stream];
       doOperation<<<1, 1024, 0, stream>>>(dPtr, val);  // On GPU
+      HIP_CHECK_DEFERRED(hipGetLastError());
     }
+    soak.add(maxWorkPerThread);
   };
 
   auto maxThreads = std::thread::hardware_concurrency();
@@ -211,15 +227,23 @@ TEST_CASE("Stress_StreamEnqueue_DifferentThreads_MultiGPU") {
   std::vector<std::thread> threadPool{};
   threadPool.reserve(maxThreads);
 
-  // Launch Threads
-  for (size_t i = 0; i < maxThreads; i++) {
-    threadPool.emplace_back(std::thread(enqueueKernelThread));
-  }
+  // Results accumulate over soak passes on both sides and are validated once at the end
+  do {
+    // Launch Threads
+    for (size_t i = 0; i < maxThreads; i++) {
+      threadPool.emplace_back(std::thread(enqueueKernelThread));
+    }
 
-  // Wait for them to stop
-  for (auto& i : threadPool) {
-    i.join();
-  }
+    // Wait for them to stop
+    for (auto& i : threadPool) {
+      i.join();
+    }
+    threadPool.clear();
+    HIP_CHECK_DEFERRED_FINALIZE();
+    for (auto& i : streamPool) {
+      HIP_CHECK(hipStreamSynchronize(i));
+    }
+  } while (soak.next());
 
   // Sync and check results
   for (auto& i : streamPool) {
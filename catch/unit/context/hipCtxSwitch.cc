@@ -0,0 +1,138 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/*
+Testcase Scenarios :
+Unit_hipCtx_SwitchCost - Benchmark context switching from one thread, as libraries that manage
+their own contexts do around every call. Primary contexts of up to four devices are pushed
+with DriverContext, then measured:
+  - hipCtxGetCurrent, and hipCtxSetCurrent to the context that is already current
+  - hipCtxPushCurrent followed by hipCtxPopCurrent of the same context
+  - hipCtxSetCurrent alternating between the contexts of two devices
+  - A small hipMemsetD8Async wrapped in push/pop, against the plain call
+  - Memsets interleaved over all devices, setting the context before each, against the same
+    number of memsets on one device
+Afterwards every context has to still reach its own device. The multi-device cases are skipped on
+single GPU systems.
+*/
+
+#include <hip_test_common.hh>
+#include <hip_test_benchmark.hh>
+#include <utils.hh>
+#include "../memory/DriverContext.hh"
+
+#include <memory>
+#include <vector>
+
+TEST_CASE("Unit_hipCtx_SwitchCost") {
+  constexpr size_t kBytes = 4096;
+  constexpr int kMaxDevices = 4;
+  const int device_count = std::min(HipTest::getDeviceCount(), kMaxDevices);
+
+  std::vector<std::unique_ptr<DriverContext>> contexts;
+  std::vector<hipDeviceptr_t> buffers;
+  for (int device = 0; device < device_count; device++) {
+    contexts.push_back(std::make_unique<DriverContext>(device));
+    hipDeviceptr_t buffer;
+    HIP_CHECK(hipMalloc(reinterpret_cast<void**>(&buffer), kBytes));
+    buffers.push_back(buffer);
+  }
+  const hipCtx_t first = contexts.front()->get();
+  HIP_CHECK(hipCtxSetCurrent(first));
+
+  SECTION("Current context") {
+    BENCHMARK("hipCtxGetCurrent") {
+      hipCtx_t current = nullptr;
+      HIP_CHECK(hipCtxGetCurrent(&current));
+      return current;
+    };
+    BENCHMARK("hipCtxSetCurrent, unchanged") { HIP_CHECK(hipCtxSetCurrent(first)); };
+    BENCHMARK("hipCtxPushCurrent + hipCtxPopCurrent") {
+      hipCtx_t popped = nullptr;
+      HIP_CHECK(hipCtxPushCurrent(first));
+      HIP_CHECK(hipCtxPopCurrent(&popped));
+      return popped;
+    };
+  }
+
+  SECTION("Library call") {
+    HIP_BENCHMARK("hipMemsetD8Async", nullptr) {
+      HIP_CHECK(hipMemsetD8Async(buffers[0], 0, kBytes, nullptr));
+    };
+    HIP_BENCHMARK("hipMemsetD8Async inside push/pop", nullptr) {
+      hipCtx_t popped = nullptr;
+      HIP_CHECK(hipCtxPushCurrent(first));
+      HIP_CHECK(hipMemsetD8Async(buffers[0], 0, kBytes, nullptr));
+      HIP_CHECK(hipCtxPopCurrent(&popped));
+    };
+  }
+
+  SECTION("Multiple devices") {
+    if (device_count < 2) {
+      HipTest::HIP_SKIP_TEST("Context switching across devices needs 2 GPUs");
+    } else {
+      const hipCtx_t second = contexts[1]->get();
+      bool flip = false;
+      BENCHMARK("hipCtxSetCurrent, alternating devices") {
+        flip = !flip;
+        HIP_CHECK(hipCtxSetCurrent(flip ? second : first));
+      };
+      HIP_CHECK(hipCtxSetCurrent(first));
+
+      BENCHMARK("hipMemsetD8Async x devices, one device") {
+        for (int i = 0; i < device_count; i++) {
+          HIP_CHECK(hipMemsetD8Async(buffers[0], 0, kBytes, nullptr));
+        }
+        HIP_CHECK(hipCtxSynchronize());
+      };
+      BENCHMARK("hipMemsetD8Async x devices, interleaved") {
+        for (int device = 0; device < device_count; device++) {
+          HIP_CHECK(hipCtxSetCurrent(contexts[device]->get()));
+          HIP_CHECK(hipMemsetD8Async(buffers[device], 0, kBytes, nullptr));
+        }
+        for (int device = 0; device < device_count; device++) {
+          HIP_CHECK(hipCtxSetCurrent(contexts[device]->get()));
+          HIP_CHECK(hipCtxSynchronize());
+        }
+      };
+      HIP_CHECK(hipCtxSetCurrent(first));
+    }
+  }
+
+  // Every context still reaches its own device after the churn
+  hipCtx_t current = nullptr;
+  HIP_CHECK(hipCtxGetCurrent(&current));
+  REQUIRE(current == first);
+  std::vector<unsigned char> host(kBytes);
+  for (int device = 0; device < device_count; device++) {
+    HIP_CHECK(hipCtxSetCurrent(contexts[device]->get()));
+    const unsigned char value = static_cast<unsigned char>(device + 1);
+    HIP_CHECK(hipMemsetD8(buffers[device], value, kBytes));
+    HIP_CHECK(hipMemcpy(host.data(), reinterpret_cast<void*>(buffers[device]), kBytes,
+                        hipMemcpyDeviceToHost));
+    ArrayFindIfNot(host.data(), value, kBytes);
+    HIP_CHECK(hipFree(reinterpret_cast<void*>(buffers[device])));
+  }
+  HIP_CHECK(hipCtxSetCurrent(first));
+
+  // Pop in reverse push order
+  while (!contexts.empty()) contexts.pop_back();
+}
@@ -20,6 +20,7 @@ THE SOFTWARE.
 #include <hip_test_common.hh>
 #include <hip_test_checkers.hh>
 #include <hip_test_kernels.hh>
+#include <hip_test_benchmark.hh>
 /* Test verifies hipGraphLaunch API
 Negative scenarios -
 1) Pass graphExec as nullptr and verify api returns error code.
@@ -37,6 +38,8 @@ Functional Scenario -
    Wait for stream. Validate the output. No issues should be observed
 4) Create a graph with multiple nodes. Create an executable graph.
    Verify if an executable graph be launched on null stream.
+5) Benchmark launching the executable graph and waiting for it, then validate the output
+   of the last launch.
 */
 
 #define SIZE 1024
@@ -402,6 +405,18 @@ TEST_CASE("Unit_hipGraphLaunch_Functional_MultipleLaunch") {
       validateOutData(A_h, C_h, SIZE);
     }
   }
+  SECTION("Graph launch benchmark") {
+    fillRandInpData(A_h, C_h, SIZE);
+    HIP_BENCHMARK("hipGraphLaunch", streamForGraph) {
+      HIP_CHECK(hipGraphLaunch(graphExec, streamForGraph));
+    };
+    validateOutData(A_h, C_h, SIZE);
+    const auto& result = hip::BenchmarkResult::last();
+    if (result.name == "hipGraphLaunch") {  // Not set with --skip-benchmarks
+      REQUIRE(result.samples > 0);
+      REQUIRE(result.medianUs > 0);
+    }
+  }
 
   HIP_CHECK(hipGraphDestroy(graph));
   HIP_CHECK(hipGraphExecDestroy(graphExec));
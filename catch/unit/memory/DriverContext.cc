@@ -23,9 +23,9 @@ THE SOFTWARE.
 #include "DriverContext.hh"
 #include <hip_test_common.hh>
 
-DriverContext::DriverContext() {
+DriverContext::DriverContext(int device_ordinal) {
   HIP_CHECK(hipInit(0));
-  HIP_CHECK(hipDeviceGet(&device, 0));
+  HIP_CHECK(hipDeviceGet(&device, device_ordinal));
   HIP_CHECK(hipDevicePrimaryCtxRetain(&ctx, device));
   HIP_CHECK(hipCtxPushCurrent(ctx));
 }
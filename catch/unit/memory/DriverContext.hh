@@ -32,9 +32,12 @@ class DriverContext {
   hipDevice_t device;
 
  public:
-  DriverContext();
+  // Retains the primary context of device and pushes it on the calling thread's stack
+  explicit DriverContext(int device_ordinal = 0);
   ~DriverContext();
 
+  hipCtx_t get() const { return ctx; }
+
   // Rule of three
   DriverContext(const DriverContext& other) = delete;
   DriverContext(DriverContext&& other) noexcept = delete;
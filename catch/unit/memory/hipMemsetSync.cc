@@ -21,6 +21,7 @@ THE SOFTWARE.
 */
 
 #include <hip_test_common.hh>
+#include <hip_test_combinations.hh>
 /*
  * These testcases verify that synchronous memset functions are asynchronous with respect to the
  * host except when the target is pinned host memory or a Unified Memory region
@@ -438,6 +439,12 @@ static void doMemsetTest(allocType mallocType, memSetType memset_type, MultiDDat
   if (streamType == CREATEDSTR) HIP_CHECK(hipStreamDestroy(stream));
 }
 
+// Allocation types the multi-dimensional tests combine with their extents
+static std::vector<allocType> memsetAllocTypes() {
+  return {allocType::deviceMalloc, allocType::hostMalloc, allocType::hostRegisted,
+          allocType::devRegistered};
+}
+
 TEST_CASE("Unit_hipMemsetSync") {
 #if HT_NVIDIA
   HipTest::HIP_SKIP_TEST("EXSWCPHIPT-86");
@@ -478,12 +485,13 @@ TEST_CASE("Unit_hipMemset2DSync") {
   HipTest::HIP_SKIP_TEST("EXSWCPHIPT-86");
   return;
 #endif
-  allocType mallocType = GENERATE(allocType::deviceMalloc, allocType::hostMalloc,
-                                  allocType::hostRegisted, allocType::devRegistered);
+  const auto [mallocType, width, height] = GENERATE(from_range(
+      hip::Combinations(memsetAllocTypes(), std::vector<size_t>{1, 1024},
+                        std::vector<size_t>{1, 1024})));
   memSetType memset_type = memSetType::hipMemset2D;
   MultiDData data;
-  data.width = GENERATE(1, 1024);
-  data.height = GENERATE(1, 1024);
+  data.width = width;
+  data.height = height;
 
   doMemsetTest<char>(mallocType, memset_type, data);
 }
@@ -493,13 +501,14 @@ TEST_CASE("Unit_hipMemset3DSync") {
   HipTest::HIP_SKIP_TEST("EXSWCPHIPT-86");
   return;
 #endif
-  allocType mallocType = GENERATE(allocType::deviceMalloc, allocType::hostMalloc,
-                                  allocType::hostRegisted, allocType::devRegistered);
+  const auto [mallocType, width, height, depth] = GENERATE(from_range(
+      hip::Combinations(memsetAllocTypes(), std::vector<size_t>{1, 256},
+                        std::vector<size_t>{1, 256}, std::vector<size_t>{1, 256})));
   memSetType memset_type = memSetType::hipMemset3D;
   MultiDData data;
-  data.width = GENERATE(1, 256);
-  data.height = GENERATE(1, 256);
-  data.depth = GENERATE(1, 256);
+  data.width = width;
+  data.height = height;
+  data.depth = depth;
 
   doMemsetTest<char>(mallocType, memset_type, data);
 }
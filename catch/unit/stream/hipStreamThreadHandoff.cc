@@ -0,0 +1,103 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/*
+Testcase Scenarios :
+Unit_hipStream_ThreadHandoff - Benchmark handing stream work from one thread to another, as a
+pipeline passing requests between an I/O and a compute thread does. The caller thread queues a
+kernel and records an event, then hands over to a persistent partner thread which waits for
+the work and hands back. Measured for a condition variable and a spin handoff:
+  - Host only: the bare round trip between the threads, the floor for the cases below
+  - hipEventSynchronize: the partner blocks on the recorded event
+  - hipStreamWaitEvent: the partner makes its own stream wait for the event, queues a kernel
+    behind it and synchronizes that stream
+Each sample is one round trip; the partner's kernel count is checked afterwards.
+*/
+
+#include <hip_test_common.hh>
+#include <threaded_zig_zag_test.hh>
+
+static __global__ void handoffKernel(unsigned int* counter) {
+  if (threadIdx.x == 0 && blockIdx.x == 0) atomicAdd(counter, 1u);
+}
+
+TEMPLATE_TEST_CASE("Unit_hipStream_ThreadHandoff", "", CondVarHandoff, SpinHandoff) {
+  hipStream_t producer = nullptr;
+  hipStream_t consumer = nullptr;
+  hipEvent_t event = nullptr;
+  unsigned int* counter = nullptr;
+  HIP_CHECK(hipStreamCreate(&producer));
+  HIP_CHECK(hipStreamCreate(&consumer));
+  HIP_CHECK(hipEventCreateWithFlags(&event, hipEventDisableTiming));
+  HIP_CHECK(hipMalloc(&counter, sizeof(*counter)));
+  HIP_CHECK(hipMemset(counter, 0, sizeof(*counter)));
+  unsigned int producerLaunches = 0;
+  unsigned int consumerLaunches = 0;
+
+  SECTION("Host only") {
+    ThreadHandoffPartner<TestType> partner([] {});
+    BENCHMARK("round trip") { partner.roundTrip(); };
+  }
+
+  SECTION("hipEventSynchronize") {
+    {
+      ThreadHandoffPartner<TestType> partner(
+          [&] { HIP_CHECK_THREAD(hipEventSynchronize(event)); });
+      BENCHMARK("enqueue, hand off, hipEventSynchronize") {
+        handoffKernel<<<1, 1, 0, producer>>>(counter);
+        HIP_CHECK(hipEventRecord(event, producer));
+        producerLaunches++;
+        partner.roundTrip();
+      };
+    }
+    HIP_CHECK_THREAD_FINALIZE();
+  }
+
+  SECTION("hipStreamWaitEvent") {
+    {
+      ThreadHandoffPartner<TestType> partner([&] {
+        HIP_CHECK_THREAD(hipStreamWaitEvent(consumer, event, 0));
+        handoffKernel<<<1, 1, 0, consumer>>>(counter);
+        HIP_CHECK_THREAD(hipStreamSynchronize(consumer));
+        consumerLaunches++;
+      });
+      BENCHMARK("enqueue, hand off, hipStreamWaitEvent") {
+        handoffKernel<<<1, 1, 0, producer>>>(counter);
+        HIP_CHECK(hipEventRecord(event, producer));
+        producerLaunches++;
+        partner.roundTrip();
+      };
+    }
+    HIP_CHECK_THREAD_FINALIZE();
+  }
+
+  // Every kernel queued on either side has run, none was lost in a handoff
+  HIP_CHECK(hipGetLastError());
+  HIP_CHECK(hipDeviceSynchronize());
+  unsigned int launches = 0;
+  HIP_CHECK(hipMemcpy(&launches, counter, sizeof(launches), hipMemcpyDeviceToHost));
+  REQUIRE(launches == producerLaunches + consumerLaunches);
+
+  HIP_CHECK(hipFree(counter));
+  HIP_CHECK(hipEventDestroy(event));
+  HIP_CHECK(hipStreamDestroy(consumer));
+  HIP_CHECK(hipStreamDestroy(producer));
+}
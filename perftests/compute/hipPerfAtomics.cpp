@@ -0,0 +1,224 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// atomicAdd and unsafeAtomicAdd throughput for int, float and double on
+// coarse-grained and fine-grained device memory and on coherent (fine-grained)
+// and non-coherent (coarse-grained) host memory, at three contention levels:
+// every lane of the grid on one address, one address per wave and one address
+// per thread. Reports atomics per second. unsafeAtomicAdd is AMD only and not
+// defined for int; on fine-grained memory the hardware FP atomics it may emit
+// are not guaranteed to update the value, so only the int sums are verified.
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+
+enum AtomicType { typeInt = 0, typeFloat, typeDouble, numAtomicTypes };
+enum AtomicOp { opSafe = 0, opUnsafe, numAtomicOps };
+enum AtomicMemory {
+  memDevice = 0,
+  memDeviceFineGrained,
+  memHostCoherent,
+  memHostNonCoherent,
+  numAtomicMemories
+};
+enum Contention { contentionSingle = 0, contentionWave, contentionNone, numContentions };
+
+static const char* atomicTypeStr[numAtomicTypes] = {"int", "float", "double"};
+static const char* atomicOpStr[numAtomicOps] = {"atomicAdd", "unsafeAtomicAdd"};
+static const char* atomicMemoryStr[numAtomicMemories] = {
+    "device", "device fine-grained", "host coherent", "host non-coherent"};
+static const char* contentionStr[numContentions] = {"one address", "address per wave",
+                                                    "address per thread"};
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 4;
+// Atomics per thread and launch, host memory goes over the link
+static const unsigned int deviceOpsPerThread = 64;
+static const unsigned int hostOpsPerThread = 4;
+
+template <Contention C> __device__ inline size_t counterOf(size_t thread) {
+  return C == contentionSingle ? 0 : C == contentionWave ? thread / warpSize : thread;
+}
+
+template <typename T, AtomicOp O, Contention C>
+__global__ void atomicKernel(T* counters, unsigned int ops) {
+  T* counter = counters + counterOf<C>(blockIdx.x * blockDim.x + threadIdx.x);
+  for (unsigned int i = 0; i < ops; i++) {
+#ifdef __HIP_PLATFORM_AMD__
+    if (O == opUnsafe) {
+      unsafeAtomicAdd(counter, static_cast<T>(1));
+      continue;
+    }
+#endif
+    atomicAdd(counter, static_cast<T>(1));
+  }
+}
+
+typedef void (*AtomicLaunch)(void* counters, unsigned int ops, dim3 grid, hipStream_t stream);
+
+template <typename T, AtomicOp O, Contention C>
+static void launchAtomics(void* counters, unsigned int ops, dim3 grid, hipStream_t stream) {
+  hipLaunchKernelGGL((atomicKernel<T, O, C>), grid, dim3(blockSize), 0, stream,
+                     static_cast<T*>(counters), ops);
+}
+
+template <typename T, AtomicOp O> static AtomicLaunch launchFor(Contention contention) {
+  switch (contention) {
+    case contentionSingle: return launchAtomics<T, O, contentionSingle>;
+    case contentionWave: return launchAtomics<T, O, contentionWave>;
+    default: return launchAtomics<T, O, contentionNone>;
+  }
+}
+
+template <typename T> static AtomicLaunch launchFor(AtomicOp op, Contention contention) {
+  return op == opSafe ? launchFor<T, opSafe>(contention) : launchFor<T, opUnsafe>(contention);
+}
+
+// unsafeAtomicAdd has no int overload, int always takes the safe kernels
+static AtomicLaunch launchFor(AtomicType type, AtomicOp op, Contention contention) {
+  switch (type) {
+    case typeInt: return launchFor<int, opSafe>(contention);
+    case typeFloat: return launchFor<float>(op, contention);
+    default: return launchFor<double>(op, contention);
+  }
+}
+
+class hipPerfAtomics : public HipPerf::Benchmark {
+ public:
+  hipPerfAtomics() : HipPerf::Benchmark("hipPerfAtomics"), passes_(HipPerf::iterationCount(10)),
+      stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override { HIPCHECK(hipStreamDestroy(stream_)); }
+
+  unsigned int numTests() override {
+    return numAtomicTypes * numAtomicOps * numAtomicMemories * numContentions;
+  }
+
+  void run(unsigned int test) override {
+    unsigned int index = test;
+    Contention contention = static_cast<Contention>(index % numContentions);
+    index /= numContentions;
+    AtomicMemory memory = static_cast<AtomicMemory>(index % numAtomicMemories);
+    index /= numAtomicMemories;
+    AtomicOp op = static_cast<AtomicOp>(index % numAtomicOps);
+    AtomicType type = static_cast<AtomicType>(index / numAtomicOps);
+
+#ifdef __HIP_PLATFORM_AMD__
+    if (op == opUnsafe && type == typeInt) {
+      return;
+    }
+#else
+    if (op == opUnsafe || memory == memDeviceFineGrained) {
+      return;
+    }
+#endif
+    if ((memory == memHostCoherent || memory == memHostNonCoherent) && !props_.canMapHostMemory) {
+      printf("info: device can not map host memory, skipping\n");
+      return;
+    }
+
+    dim3 grid(props_.multiProcessorCount * blocksPerCu);
+    size_t threads = static_cast<size_t>(grid.x) * blockSize;
+    // Large enough for one counter per thread of the widest type
+    size_t bytes = threads * sizeof(double);
+    unsigned int ops = memory == memHostCoherent || memory == memHostNonCoherent
+        ? hostOpsPerThread : deviceOpsPerThread;
+    void* host = nullptr;
+    void* counters = allocate(memory, bytes, &host);
+    HIPCHECK(hipMemset(counters, 0, bytes));
+
+    AtomicLaunch launch = launchFor(type, op, contention);
+    auto sec = measure([&]() {
+      for (unsigned int p = 0; p < passes_; p++) {
+        launch(counters, ops, grid, stream_);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    if (type == typeInt) {
+      // Warm-up and timed passes all added
+      checkSum(counters, threads, static_cast<unsigned long long>(threads) * ops * passes_ *
+                                      (p_warmup + p_repetitions));
+    }
+    HIPCHECK(host != nullptr ? hipHostFree(host) : hipFree(counters));
+
+    std::vector<double> rates;
+    for (double s : sec) {
+      rates.push_back(static_cast<double>(threads) * ops * passes_ / s / 1e9);
+    }
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%-15s %-6s %-19s %s", atomicOpStr[op], atomicTypeStr[type],
+             atomicMemoryStr[memory], contentionStr[contention]);
+    report(test, desc, 0, passes_, "Gatomics/s", rates);
+  }
+
+ private:
+  // Returns the device address of the counters, host is set for host memory.
+  void* allocate(AtomicMemory memory, size_t bytes, void** host) {
+    void* ptr = nullptr;
+    switch (memory) {
+      case memDevice:
+        HIPCHECK(hipMalloc(&ptr, bytes));
+        break;
+      case memDeviceFineGrained:
+#ifdef __HIP_PLATFORM_AMD__
+        HIPCHECK(hipExtMallocWithFlags(&ptr, bytes, hipDeviceMallocFinegrained));
+#endif
+        break;
+      default:
+        HIPCHECK(hipHostMalloc(host, bytes,
+                               hipHostMallocMapped | (memory == memHostCoherent
+                                                          ? hipHostMallocCoherent
+                                                          : hipHostMallocNonCoherent)));
+        HIPCHECK(hipHostGetDevicePointer(&ptr, *host, 0));
+        break;
+    }
+    return ptr;
+  }
+
+  // int counters wrap on long runs, compared modulo 2^32
+  void checkSum(const void* counters, size_t threads, unsigned long long expected) {
+    std::vector<unsigned int> host(threads);
+    HIPCHECK(hipMemcpy(host.data(), counters, threads * sizeof(int), hipMemcpyDefault));
+    unsigned int sum = 0;
+    for (unsigned int v : host) {
+      sum += v;
+    }
+    if (sum != static_cast<unsigned int>(expected)) {
+      failed("Atomic sum is %u, expected %u", sum, static_cast<unsigned int>(expected));
+    }
+  }
+
+  unsigned int passes_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfAtomics)
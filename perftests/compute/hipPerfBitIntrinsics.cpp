@@ -0,0 +1,317 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Throughput of the integer bit manipulation intrinsics (__popc, __clz,
+// __ffs, __brev, __funnelshift_l/r and, on AMD, __bitextract/__bitinsert) at
+// 32 and 64 bit against the portable shift and mask code they replace. Per
+// pair it reports operations per cycle per CU (at the clockRate of the
+// device properties) for both implementations, the speedup of the intrinsic
+// and how many of 1M random inputs the two disagree on, which should be
+// none. Every thread evaluates four independent inputs per iteration, so the
+// result is issue throughput rather than latency; the input increment and
+// the accumulation add the same two integer adds per operation to both sides.
+
+#include <stdio.h>
+
+#include <cstdint>
+#include <random>
+
+#include "perf_harness.h"
+
+template <typename T> __device__ inline T naivePopc(T x) {
+  x = x - ((x >> 1) & static_cast<T>(0x5555555555555555ull));
+  x = (x & static_cast<T>(0x3333333333333333ull)) +
+      ((x >> 2) & static_cast<T>(0x3333333333333333ull));
+  x = (x + (x >> 4)) & static_cast<T>(0x0f0f0f0f0f0f0f0full);
+  return static_cast<T>(x * static_cast<T>(0x0101010101010101ull)) >> (sizeof(T) * 8 - 8);
+}
+
+// Binary search for the highest set bit
+template <typename T> __device__ inline T naiveClz(T x) {
+  const unsigned int bits = sizeof(T) * 8;
+  if (x == 0) return bits;
+  T n = 0;
+  for (unsigned int s = bits / 2; s > 0; s >>= 1) {
+    if ((x >> (bits - s)) == 0) {
+      n += s;
+      x <<= s;
+    }
+  }
+  return n;
+}
+
+template <typename T> __device__ inline T naiveFfs(T x) {
+  return x == 0 ? 0 : sizeof(T) * 8 - naiveClz<T>(x & (~x + 1));
+}
+
+// Swaps ever larger neighbouring bit groups, the masks fold to constants
+template <typename T> __device__ inline T naiveBrev(T x) {
+  for (unsigned int s = 1; s < sizeof(T) * 8; s <<= 1) {
+    T mask = static_cast<T>(~static_cast<T>(0)) / ((static_cast<T>(1) << s) + 1);
+    x = ((x >> s) & mask) | ((x & mask) << s);
+  }
+  return x;
+}
+
+__device__ inline uint32_t naiveFunnelShiftL(uint32_t lo, uint32_t hi, uint32_t shift) {
+  uint64_t joined = (static_cast<uint64_t>(hi) << 32) | lo;
+  return static_cast<uint32_t>((joined << (shift & 31)) >> 32);
+}
+
+__device__ inline uint32_t naiveFunnelShiftR(uint32_t lo, uint32_t hi, uint32_t shift) {
+  uint64_t joined = (static_cast<uint64_t>(hi) << 32) | lo;
+  return static_cast<uint32_t>(joined >> (shift & 31));
+}
+
+// Offset and width derived from x keep offset + width within the type
+template <typename T> __device__ inline unsigned int fieldOffset(T x) {
+  return static_cast<unsigned int>(x) & (sizeof(T) * 4 - 1);
+}
+
+template <typename T> __device__ inline unsigned int fieldWidth(T x) {
+  return 1 + (static_cast<unsigned int>(x >> 8) & (sizeof(T) * 4 - 1));
+}
+
+template <typename T> __device__ inline T naiveBitExtract(T x, unsigned int offset,
+                                                          unsigned int width) {
+  const unsigned int bits = sizeof(T) * 8;
+  return static_cast<T>(x << (bits - width - offset)) >> (bits - width);
+}
+
+template <typename T> __device__ inline T naiveBitInsert(T x, T y, unsigned int offset,
+                                                         unsigned int width) {
+  T mask = (static_cast<T>(1) << width) - 1;
+  return (x & ~(mask << offset)) | ((y & mask) << offset);
+}
+
+/*
+BIT_PAIR(Name, T, intrinsic, naive) declares functor Name with the intrinsic and the shift
+and mask implementation of the same operation on x.
+*/
+#define BIT_PAIR(NAME, TYPE, INTRINSIC, NAIVE)                                                     \
+  struct NAME {                                                                                   \
+    typedef TYPE T;                                                                               \
+    __device__ static T intrinsic(T x) { return static_cast<T>(INTRINSIC); }                      \
+    __device__ static T naive(T x) { return static_cast<T>(NAIVE); }                              \
+  };
+
+BIT_PAIR(BitPopc, uint32_t, __popc(x), naivePopc(x))
+BIT_PAIR(BitClz, uint32_t, __clz(static_cast<int>(x)), naiveClz(x))
+BIT_PAIR(BitFfs, uint32_t, __ffs(static_cast<int>(x)), naiveFfs(x))
+BIT_PAIR(BitBrev, uint32_t, __brev(x), naiveBrev(x))
+BIT_PAIR(BitFunnelL, uint32_t, __funnelshift_l(x, ~x, x >> 27), naiveFunnelShiftL(x, ~x, x >> 27))
+BIT_PAIR(BitFunnelR, uint32_t, __funnelshift_r(x, ~x, x >> 27), naiveFunnelShiftR(x, ~x, x >> 27))
+BIT_PAIR(BitPopc64, uint64_t, __popcll(x), naivePopc(x))
+BIT_PAIR(BitClz64, uint64_t, __clzll(static_cast<long long>(x)), naiveClz(x))
+BIT_PAIR(BitFfs64, uint64_t, __ffsll(static_cast<long long>(x)), naiveFfs(x))
+BIT_PAIR(BitBrev64, uint64_t, __brevll(x), naiveBrev(x))
+#ifdef __HIP_PLATFORM_AMD__
+BIT_PAIR(BitExtract, uint32_t, __bitextract_u32(x, fieldOffset(x), fieldWidth(x)),
+         naiveBitExtract(x, fieldOffset(x), fieldWidth(x)))
+BIT_PAIR(BitInsert, uint32_t, __bitinsert_u32(x, ~x, fieldOffset(x), fieldWidth(x)),
+         naiveBitInsert<uint32_t>(x, ~x, fieldOffset(x), fieldWidth(x)))
+BIT_PAIR(BitExtract64, uint64_t, __bitextract_u64(x, fieldOffset(x), fieldWidth(x)),
+         naiveBitExtract(x, fieldOffset(x), fieldWidth(x)))
+BIT_PAIR(BitInsert64, uint64_t, __bitinsert_u64(x, ~x, fieldOffset(x), fieldWidth(x)),
+         naiveBitInsert<uint64_t>(x, ~x, fieldOffset(x), fieldWidth(x)))
+#endif
+
+#undef BIT_PAIR
+
+template <typename F, bool Intrinsic> __device__ inline typename F::T evaluate(typename F::T x) {
+  return Intrinsic ? F::intrinsic(x) : F::naive(x);
+}
+
+template <typename F, bool Intrinsic>
+__global__ void bitThroughput(unsigned int iterations, typename F::T* out) {
+  typedef typename F::T T;
+  size_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  // Odd golden ratio increment walks all bit patterns of the low bits
+  const T step = static_cast<T>(0x9e3779b97f4a7c15ull);
+  T x0 = static_cast<T>(tid * 4 + 0) * step;
+  T x1 = static_cast<T>(tid * 4 + 1) * step;
+  T x2 = static_cast<T>(tid * 4 + 2) * step;
+  T x3 = static_cast<T>(tid * 4 + 3) * step;
+  T sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  for (unsigned int i = 0; i < iterations; i++) {
+    sum0 += evaluate<F, Intrinsic>(x0);
+    sum1 += evaluate<F, Intrinsic>(x1);
+    sum2 += evaluate<F, Intrinsic>(x2);
+    sum3 += evaluate<F, Intrinsic>(x3);
+    x0 += step;
+    x1 += step;
+    x2 += step;
+    x3 += step;
+  }
+  out[tid] = sum0 + sum1 + sum2 + sum3;
+}
+
+template <typename F>
+__global__ void bitEvaluate(const typename F::T* in, typename F::T* intrinsic,
+                            typename F::T* naive, size_t n) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    intrinsic[i] = F::intrinsic(in[i]);
+    naive[i] = F::naive(in[i]);
+  }
+}
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const size_t checkInputs = 1 << 20;
+
+// Both implementations of one pair: seconds per launch series and disagreeing inputs.
+struct PairResult {
+  std::vector<double> sec[2];
+  size_t mismatches;
+};
+
+typedef PairResult (*PairRun)(const hipDeviceProp_t& props, unsigned int iterations,
+                              const std::function<std::vector<double>(
+                                  const std::function<void()>&)>& measure);
+
+template <typename F>
+static PairResult runPair(const hipDeviceProp_t& props, unsigned int iterations,
+                          const std::function<std::vector<double>(
+                              const std::function<void()>&)>& measure) {
+  typedef typename F::T T;
+  dim3 grid(props.multiProcessorCount * blocksPerCu);
+  size_t threads = static_cast<size_t>(grid.x) * blockSize;
+
+  std::vector<T> in(checkInputs);
+  std::mt19937_64 gen(1);
+  for (auto& x : in) {
+    x = static_cast<T>(gen());
+  }
+  // Edge cases for the counting and searching operations
+  in[0] = 0;
+  in[1] = 1;
+  in[2] = static_cast<T>(~static_cast<T>(0));
+  in[3] = static_cast<T>(1) << (sizeof(T) * 8 - 1);
+
+  T* in_d = nullptr;
+  T* out_d = nullptr;
+  T* naive_d = nullptr;
+  HIPCHECK(hipMalloc(&in_d, checkInputs * sizeof(T)));
+  HIPCHECK(hipMalloc(&out_d, std::max(threads, checkInputs) * sizeof(T)));
+  HIPCHECK(hipMalloc(&naive_d, checkInputs * sizeof(T)));
+  HIPCHECK(hipMemcpy(in_d, in.data(), checkInputs * sizeof(T), hipMemcpyHostToDevice));
+
+  PairResult result;
+  for (int intrinsic = 0; intrinsic < 2; intrinsic++) {
+    result.sec[intrinsic] = measure([&]() {
+      if (intrinsic) {
+        hipLaunchKernelGGL((bitThroughput<F, true>), grid, dim3(blockSize), 0, 0, iterations,
+                           out_d);
+      } else {
+        hipLaunchKernelGGL((bitThroughput<F, false>), grid, dim3(blockSize), 0, 0, iterations,
+                           out_d);
+      }
+      HIPCHECK(hipDeviceSynchronize());
+    });
+  }
+
+  hipLaunchKernelGGL(bitEvaluate<F>, grid, dim3(blockSize), 0, 0, in_d, out_d, naive_d,
+                     checkInputs);
+  std::vector<T> out(checkInputs), naive(checkInputs);
+  HIPCHECK(hipMemcpy(out.data(), out_d, checkInputs * sizeof(T), hipMemcpyDeviceToHost));
+  HIPCHECK(hipMemcpy(naive.data(), naive_d, checkInputs * sizeof(T), hipMemcpyDeviceToHost));
+  result.mismatches = 0;
+  for (size_t i = 0; i < checkInputs; i++) {
+    result.mismatches += out[i] != naive[i];
+  }
+
+  HIPCHECK(hipFree(in_d));
+  HIPCHECK(hipFree(out_d));
+  HIPCHECK(hipFree(naive_d));
+  return result;
+}
+
+struct BitPair {
+  const char* intrinsic;
+  const char* naive;
+  PairRun run;
+};
+
+static const BitPair bitPairs[] = {
+    {"__popc", "SWAR popcount", runPair<BitPopc>},
+    {"__clz", "shift search clz", runPair<BitClz>},
+    {"__ffs", "shift search ffs", runPair<BitFfs>},
+    {"__brev", "mask swap brev", runPair<BitBrev>},
+    {"__funnelshift_l", "64-bit shift left", runPair<BitFunnelL>},
+    {"__funnelshift_r", "64-bit shift right", runPair<BitFunnelR>},
+    {"__popcll", "SWAR popcount 64", runPair<BitPopc64>},
+    {"__clzll", "shift search clz 64", runPair<BitClz64>},
+    {"__ffsll", "shift search ffs 64", runPair<BitFfs64>},
+    {"__brevll", "mask swap brev 64", runPair<BitBrev64>},
+#ifdef __HIP_PLATFORM_AMD__
+    {"__bitextract_u32", "shift extract", runPair<BitExtract>},
+    {"__bitinsert_u32", "mask insert", runPair<BitInsert>},
+    {"__bitextract_u64", "shift extract 64", runPair<BitExtract64>},
+    {"__bitinsert_u64", "mask insert 64", runPair<BitInsert64>},
+#endif
+};
+
+static const unsigned int numBitPairs = sizeof(bitPairs) / sizeof(bitPairs[0]);
+
+class hipPerfBitIntrinsics : public HipPerf::Benchmark {
+ public:
+  hipPerfBitIntrinsics() : HipPerf::Benchmark("hipPerfBitIntrinsics"),
+      iterations_(HipPerf::iterationCount(4096)) {}
+
+  unsigned int numTests() override { return numBitPairs; }
+
+  void run(unsigned int test) override {
+    const BitPair& pair = bitPairs[test];
+    PairResult result = pair.run(props_, iterations_, [this](const std::function<void()>& op) {
+      return measure(op);
+    });
+
+    dim3 grid(props_.multiProcessorCount * blocksPerCu);
+    double ops = static_cast<double>(grid.x) * blockSize * iterations_ * 4;
+    // clockRate is in kHz
+    double cyclesPerSec = props_.clockRate * 1e3 * props_.multiProcessorCount;
+    const char* names[2] = {pair.naive, pair.intrinsic};
+    for (int intrinsic = 0; intrinsic < 2; intrinsic++) {
+      std::vector<double> opsPerCycle;
+      for (double s : result.sec[intrinsic]) {
+        opsPerCycle.push_back(ops / s / cyclesPerSec);
+      }
+      char desc[96];
+      snprintf(desc, sizeof(desc), "%-20s %zu mismatches", names[intrinsic], result.mismatches);
+      report(test, desc, 0, iterations_, "ops/cycle/CU", opsPerCycle);
+    }
+
+    std::vector<double> speedup;
+    for (size_t r = 0; r < result.sec[0].size(); r++) {
+      speedup.push_back(result.sec[0][r] / result.sec[1][r]);
+    }
+    report(test, std::string(pair.intrinsic) + " speedup over " + pair.naive, 0, iterations_,
+           "x", speedup);
+  }
+
+ private:
+  unsigned int iterations_;  // per thread, four operations each
+};
+
+HIP_PERF_BENCHMARK(hipPerfBitIntrinsics)
@@ -0,0 +1,170 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of the block level barriers and memory fences: __syncthreads,
+// __syncthreads_count/and/or and __threadfence_block, __threadfence and
+// __threadfence_system, for block sizes of 64 to 1024 threads (--sizes or
+// --sweep replace them). Each thread runs a dependent chain of the
+// primitive; the fences follow a global store to have something to order,
+// so the store alone is timed as well for reference. A single block gives
+// the latency of one primitive, one block per CU times two shows the cost
+// with every CU doing the same. Both are reported in cycles per operation
+// at the clockRate of the device properties.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "perf_harness.h"
+
+enum SyncOp {
+  opSyncthreads = 0,
+  opSyncthreadsCount,
+  opSyncthreadsAnd,
+  opSyncthreadsOr,
+  opStore,
+  opFenceBlock,
+  opFence,
+  opFenceSystem,
+  numSyncOps
+};
+
+static const char* syncOpStr[numSyncOps] = {
+    "__syncthreads",         "__syncthreads_count",  "__syncthreads_and",
+    "__syncthreads_or",      "global store",         "store + __threadfence_block",
+    "store + __threadfence", "store + __threadfence_system"};
+
+enum SyncMode { modeSingleBlock = 0, modeAllCus, numSyncModes };
+
+static const size_t defaultBlockSizes[] = {64, 128, 256, 512, 1024};
+static const unsigned int blocksPerCu = 2;
+
+template <SyncOp O> __global__ void syncKernel(unsigned int iterations, int* data) {
+  unsigned int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  int v = threadIdx.x;
+  for (unsigned int i = 0; i < iterations; i++) {
+    switch (O) {
+      case opSyncthreads:
+        __syncthreads();
+        v++;
+        break;
+      case opSyncthreadsCount:
+        v += __syncthreads_count(v & 1);
+        break;
+      case opSyncthreadsAnd:
+        v += __syncthreads_and(v & 1);
+        break;
+      case opSyncthreadsOr:
+        v += __syncthreads_or(v & 1);
+        break;
+      case opStore:
+        data[tid] = v++;
+        break;
+      case opFenceBlock:
+        data[tid] = v++;
+        __threadfence_block();
+        break;
+      case opFence:
+        data[tid] = v++;
+        __threadfence();
+        break;
+      default:
+        data[tid] = v++;
+        __threadfence_system();
+        break;
+    }
+  }
+  data[tid] = v;
+}
+
+typedef void (*SyncLaunch)(unsigned int iterations, int* data, dim3 grid, unsigned int block);
+
+template <SyncOp O>
+static void launchSync(unsigned int iterations, int* data, dim3 grid, unsigned int block) {
+  hipLaunchKernelGGL(syncKernel<O>, grid, dim3(block), 0, 0, iterations, data);
+}
+
+static const SyncLaunch syncLaunches[numSyncOps] = {
+    launchSync<opSyncthreads>, launchSync<opSyncthreadsCount>, launchSync<opSyncthreadsAnd>,
+    launchSync<opSyncthreadsOr>, launchSync<opStore>, launchSync<opFenceBlock>,
+    launchSync<opFence>, launchSync<opFenceSystem>};
+
+class hipPerfBlockSync : public HipPerf::Benchmark {
+ public:
+  hipPerfBlockSync() : HipPerf::Benchmark("hipPerfBlockSync"),
+      blockSizes_(HipPerf::sweepSizes(std::vector<size_t>(
+          defaultBlockSizes, defaultBlockSizes + sizeof(defaultBlockSizes) /
+                                                     sizeof(defaultBlockSizes[0])))),
+      iterations_(HipPerf::iterationCount(10000)), data_(nullptr), maxBlock_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    maxBlock_ = static_cast<unsigned int>(props_.maxThreadsPerBlock);
+    HIPCHECK(hipMalloc(&data_, sizeof(int) * maxBlock_ * blocksPerCu *
+                                   props_.multiProcessorCount));
+  }
+
+  void close() override { HIPCHECK(hipFree(data_)); }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(blockSizes_.size()) * numSyncOps * numSyncModes;
+  }
+
+  void run(unsigned int test) override {
+    SyncOp op = static_cast<SyncOp>(test % numSyncOps);
+    SyncMode mode = static_cast<SyncMode>(test / numSyncOps % numSyncModes);
+    size_t block = blockSizes_[test / (numSyncOps * numSyncModes)];
+    if (block == 0 || block > maxBlock_) {
+      printf("info: block size %zu not supported, skipping\n", block);
+      return;
+    }
+    dim3 grid(mode == modeSingleBlock ? 1 : props_.multiProcessorCount * blocksPerCu);
+
+    auto sec = measure([&]() {
+      syncLaunches[op](iterations_, data_, grid, static_cast<unsigned int>(block));
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    // clockRate is in kHz
+    double hz = props_.clockRate * 1e3;
+    std::vector<double> cycles;
+    for (double s : sec) {
+      cycles.push_back(s * hz / iterations_);
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-28s block %4zu %s", syncOpStr[op], block,
+             mode == modeSingleBlock ? "single block" : "all CUs");
+    report(test, desc, 0, iterations_, "cycles/op", cycles);
+  }
+
+ private:
+  std::vector<size_t> blockSizes_;
+  unsigned int iterations_;
+  int* data_;
+  unsigned int maxBlock_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfBlockSync)
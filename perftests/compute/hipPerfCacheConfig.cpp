@@ -0,0 +1,232 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Whether the cache and shared memory configuration calls carried over from
+// CUDA change anything. Three kernels, each filling the device with 8 blocks
+// per CU: reads of a 16 KB float array and of a 16 KB double array in shared
+// memory at a stride that spreads over the banks, and repeated reads of a
+// 16 KB global window per block that fits in L1. Each runs under every
+// hipFuncCache_t set with hipDeviceSetCacheConfig, under every hipFuncCache_t
+// set for the kernel alone with hipFuncSetCacheConfig, and under every bank
+// size set with hipDeviceSetSharedMemConfig. Reported are the bandwidth and
+// its ratio to the first (default) setting of the same call; a call that does
+// nothing stays within noise of 1.0. The error a call returns is part of the
+// description, defaults are restored after every test.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum ConfigCall { callDeviceCache = 0, callFuncCache, callBankSize, numConfigCalls };
+static const char* configCallStr[numConfigCalls] = {
+    "hipDeviceSetCacheConfig", "hipFuncSetCacheConfig", "hipDeviceSetSharedMemConfig"};
+
+static const hipFuncCache_t cacheConfigs[] = {hipFuncCachePreferNone, hipFuncCachePreferShared,
+                                              hipFuncCachePreferL1, hipFuncCachePreferEqual};
+static const char* cacheConfigStr[] = {"PreferNone", "PreferShared", "PreferL1", "PreferEqual"};
+static const unsigned int numCacheConfigs = sizeof(cacheConfigs) / sizeof(cacheConfigs[0]);
+
+static const hipSharedMemConfig bankConfigs[] = {
+    hipSharedMemBankSizeDefault, hipSharedMemBankSizeFourByte, hipSharedMemBankSizeEightByte};
+static const char* bankConfigStr[] = {"BankSizeDefault", "BankSizeFourByte", "BankSizeEightByte"};
+static const unsigned int numBankConfigs = sizeof(bankConfigs) / sizeof(bankConfigs[0]);
+
+enum CacheKernel { kernelLdsFloat = 0, kernelLdsDouble, kernelL1, numCacheKernels };
+static const char* cacheKernelStr[numCacheKernels] = {"LDS float", "LDS double", "L1 reads"};
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const unsigned int windowBytes = 16384;
+static const unsigned int readRounds = 1024;
+
+// Count of elements is a power of two, the odd stride touches every bank
+template <typename T> __global__ void ldsRead(T* out, unsigned int rounds) {
+  const unsigned int count = windowBytes / sizeof(T);
+  __shared__ T lds[windowBytes / sizeof(T)];
+  for (unsigned int i = threadIdx.x; i < count; i += blockDim.x) {
+    lds[i] = static_cast<T>(i);
+  }
+  __syncthreads();
+  T sum = 0;
+  unsigned int index = threadIdx.x;
+  for (unsigned int r = 0; r < rounds; r++) {
+    sum += lds[index & (count - 1)];
+    index += 33;
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = sum;
+}
+
+// Every block reads one of a few windows, which stay resident in L1 after the first pass
+__global__ void l1Read(const float* in, float* out, unsigned int rounds) {
+  const unsigned int count = windowBytes / sizeof(float);
+  const float* window = in + (blockIdx.x % 4) * count;
+  float sum = 0;
+  unsigned int index = threadIdx.x;
+  for (unsigned int r = 0; r < rounds; r++) {
+    sum += window[index & (count - 1)];
+    index += blockDim.x + 1;
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = sum;
+}
+
+class hipPerfCacheConfig : public HipPerf::Benchmark {
+ public:
+  hipPerfCacheConfig() : HipPerf::Benchmark("hipPerfCacheConfig"), in_(nullptr), out_(nullptr) {
+    for (unsigned int c = 0; c < numCacheConfigs; c++) {
+      configs_.push_back(Config{callDeviceCache, c});
+    }
+    for (unsigned int c = 0; c < numCacheConfigs; c++) {
+      configs_.push_back(Config{callFuncCache, c});
+    }
+    for (unsigned int c = 0; c < numBankConfigs; c++) {
+      configs_.push_back(Config{callBankSize, c});
+    }
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    HIPCHECK(hipMalloc(&in_, 4 * windowBytes));
+    HIPCHECK(hipMemset(in_, 0, 4 * windowBytes));
+    HIPCHECK(hipMalloc(&out_, static_cast<size_t>(grid_.x) * blockSize * sizeof(double)));
+    defaultGBps_.assign(numConfigCalls * numCacheKernels, 0);
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(in_));
+    HIPCHECK(hipFree(out_));
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(configs_.size()) * numCacheKernels;
+  }
+
+  void run(unsigned int test) override {
+    CacheKernel kernel = static_cast<CacheKernel>(test % numCacheKernels);
+    const Config& config = configs_[test / numCacheKernels];
+
+    hipError_t setResult = applyConfig(config, kernel);
+    auto sec = measure([&]() {
+      launch(kernel);
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+    resetConfig(config, kernel);
+
+    std::string desc = std::string(cacheKernelStr[kernel]) + ", " + configCallStr[config.call] +
+                       "(" + settingStr(config) + ")";
+    if (setResult != hipSuccess) {
+      desc += " returns " + std::string(hipGetErrorName(setResult));
+    }
+    double elemBytes = kernel == kernelLdsDouble ? sizeof(double) : sizeof(float);
+    double readBytes = static_cast<double>(grid_.x) * blockSize * readRounds * elemBytes;
+    auto gbps = HipPerf::toBandwidth(sec, readBytes);
+    report(test, desc, windowBytes, readRounds, "GB/s", gbps);
+
+    // The first setting of every call is the default the others are compared to
+    double& reference = defaultGBps_[config.call * numCacheKernels + kernel];
+    std::vector<double> sorted(gbps);
+    std::sort(sorted.begin(), sorted.end());
+    if (config.setting == 0) {
+      reference = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    } else if (reference > 0) {
+      std::vector<double> ratio;
+      for (double g : gbps) {
+        ratio.push_back(g / reference);
+      }
+      report(test, desc + " vs default", windowBytes, readRounds, "x", ratio);
+    }
+  }
+
+ private:
+  struct Config {
+    ConfigCall call;
+    unsigned int setting;
+  };
+
+  static const void* kernelFunction(CacheKernel kernel) {
+    switch (kernel) {
+      case kernelLdsFloat: return reinterpret_cast<const void*>(ldsRead<float>);
+      case kernelLdsDouble: return reinterpret_cast<const void*>(ldsRead<double>);
+      default: return reinterpret_cast<const void*>(l1Read);
+    }
+  }
+
+  static const char* settingStr(const Config& config) {
+    return config.call == callBankSize ? bankConfigStr[config.setting]
+                                       : cacheConfigStr[config.setting];
+  }
+
+  static hipError_t applyConfig(const Config& config, CacheKernel kernel) {
+    hipError_t result;
+    switch (config.call) {
+      case callDeviceCache:
+        result = hipDeviceSetCacheConfig(cacheConfigs[config.setting]);
+        break;
+      case callFuncCache:
+        result = hipFuncSetCacheConfig(kernelFunction(kernel), cacheConfigs[config.setting]);
+        break;
+      default:
+        result = hipDeviceSetSharedMemConfig(bankConfigs[config.setting]);
+        break;
+    }
+    static_cast<void>(hipGetLastError());
+    return result;
+  }
+
+  static void resetConfig(const Config& config, CacheKernel kernel) {
+    Config reset = config;
+    reset.setting = 0;
+    applyConfig(reset, kernel);
+  }
+
+  void launch(CacheKernel kernel) {
+    switch (kernel) {
+      case kernelLdsFloat:
+        hipLaunchKernelGGL(ldsRead<float>, grid_, dim3(blockSize), 0, 0,
+                           reinterpret_cast<float*>(out_), readRounds);
+        break;
+      case kernelLdsDouble:
+        hipLaunchKernelGGL(ldsRead<double>, grid_, dim3(blockSize), 0, 0,
+                           reinterpret_cast<double*>(out_), readRounds);
+        break;
+      default:
+        hipLaunchKernelGGL(l1Read, grid_, dim3(blockSize), 0, 0, in_,
+                           reinterpret_cast<float*>(out_), readRounds);
+        break;
+    }
+  }
+
+  std::vector<Config> configs_;
+  dim3 grid_;
+  float* in_;
+  void* out_;
+  std::vector<double> defaultGBps_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfCacheConfig)
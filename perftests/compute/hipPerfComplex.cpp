@@ -0,0 +1,231 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Complex multiply, divide, exp and abs throughput in float and double for
+// three implementations: hand written float2 / double2 math (textbook
+// formulas, no overflow scaling), hipFloatComplex / hipDoubleComplex from
+// hip_complex.h and std::complex. hip_complex.h has no exp, so that pair is
+// skipped. As in hipPerfMathIntrinsics every thread evaluates four
+// independent inputs per iteration that drift slowly, so the result is issue
+// throughput. Reports Gops/s and the speed relative to the hand written math.
+
+#include <stdio.h>
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include <hip/hip_complex.h>
+
+#include "perf_harness.h"
+
+enum ComplexOp { opMul = 0, opDiv, opExp, opAbs, numComplexOps };
+static const char* complexOpStr[numComplexOps] = {"mul", "div", "exp", "abs"};
+
+// Textbook formulas on the vector types
+template <typename T, typename V> struct HandComplex {
+  typedef V C;
+  static constexpr bool hasExp = true;
+  __device__ static C make(T re, T im) { return C{re, im}; }
+  __device__ static C add(C a, C b) { return C{a.x + b.x, a.y + b.y}; }
+  __device__ static C mul(C a, C b) { return C{a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x}; }
+  __device__ static C div(C a, C b) {
+    T scale = T(1) / (b.x * b.x + b.y * b.y);
+    return C{(a.x * b.x + a.y * b.y) * scale, (a.y * b.x - a.x * b.y) * scale};
+  }
+  __device__ static C exp(C a) {
+    T e = std::exp(a.x);
+    return C{e * std::cos(a.y), e * std::sin(a.y)};
+  }
+  __device__ static T abs(C a) { return std::sqrt(a.x * a.x + a.y * a.y); }
+};
+
+struct HipComplexF {
+  typedef hipFloatComplex C;
+  static constexpr bool hasExp = false;
+  __device__ static C make(float re, float im) { return make_hipFloatComplex(re, im); }
+  __device__ static C add(C a, C b) { return hipCaddf(a, b); }
+  __device__ static C mul(C a, C b) { return hipCmulf(a, b); }
+  __device__ static C div(C a, C b) { return hipCdivf(a, b); }
+  __device__ static C exp(C a) { return a; }
+  __device__ static float abs(C a) { return hipCabsf(a); }
+};
+
+struct HipComplexD {
+  typedef hipDoubleComplex C;
+  static constexpr bool hasExp = false;
+  __device__ static C make(double re, double im) { return make_hipDoubleComplex(re, im); }
+  __device__ static C add(C a, C b) { return hipCadd(a, b); }
+  __device__ static C mul(C a, C b) { return hipCmul(a, b); }
+  __device__ static C div(C a, C b) { return hipCdiv(a, b); }
+  __device__ static C exp(C a) { return a; }
+  __device__ static double abs(C a) { return hipCabs(a); }
+};
+
+template <typename T> struct StdComplex {
+  typedef std::complex<T> C;
+  static constexpr bool hasExp = true;
+  __device__ static C make(T re, T im) { return C(re, im); }
+  __device__ static C add(C a, C b) { return a + b; }
+  __device__ static C mul(C a, C b) { return a * b; }
+  __device__ static C div(C a, C b) { return a / b; }
+  __device__ static C exp(C a) { return std::exp(a); }
+  __device__ static T abs(C a) { return std::abs(a); }
+};
+
+template <typename I, typename T, ComplexOp OP>
+__device__ inline typename I::C evaluate(typename I::C z, typename I::C w) {
+  switch (OP) {
+    case opMul:
+      return I::mul(z, w);
+    case opDiv:
+      return I::div(z, w);
+    case opExp:
+      return I::exp(z);
+    default:
+      return I::make(I::abs(z), T(0));
+  }
+}
+
+template <typename I, typename T, ComplexOp OP>
+__global__ void complexThroughput(unsigned int iterations, typename I::C* out) {
+  typedef typename I::C C;
+  size_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  // Inputs on the unit square, w on the unit circle so nothing over- or underflows
+  const T step = static_cast<T>(1e-6);
+  C z0 = I::make(static_cast<T>((tid * 4 + 0) % 1021) / 1024, T(0.25));
+  C z1 = I::make(static_cast<T>((tid * 4 + 1) % 1021) / 1024, T(-0.5));
+  C z2 = I::make(static_cast<T>((tid * 4 + 2) % 1021) / 1024, T(0.75));
+  C z3 = I::make(static_cast<T>((tid * 4 + 3) % 1021) / 1024, T(-1.0));
+  const C w = I::make(T(0.6), T(0.8));
+  const C drift = I::make(step, step);
+  C sum0 = I::make(T(0), T(0)), sum1 = sum0, sum2 = sum0, sum3 = sum0;
+  for (unsigned int i = 0; i < iterations; i++) {
+    sum0 = I::add(sum0, evaluate<I, T, OP>(z0, w));
+    sum1 = I::add(sum1, evaluate<I, T, OP>(z1, w));
+    sum2 = I::add(sum2, evaluate<I, T, OP>(z2, w));
+    sum3 = I::add(sum3, evaluate<I, T, OP>(z3, w));
+    z0 = I::add(z0, drift);
+    z1 = I::add(z1, drift);
+    z2 = I::add(z2, drift);
+    z3 = I::add(z3, drift);
+  }
+  out[tid] = I::add(I::add(sum0, sum1), I::add(sum2, sum3));
+}
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+
+typedef void (*ComplexLaunch)(dim3 grid, unsigned int iterations, void* out);
+
+template <typename I, typename T, ComplexOp OP>
+static void launchComplex(dim3 grid, unsigned int iterations, void* out) {
+  hipLaunchKernelGGL((complexThroughput<I, T, OP>), grid, dim3(blockSize), 0, 0, iterations,
+                     static_cast<typename I::C*>(out));
+}
+
+enum ComplexImpl { implHand = 0, implHip, implStd, numComplexImpls };
+static const char* complexImplStr[numComplexImpls] = {"float2", "hipFloatComplex",
+                                                      "std::complex<float>"};
+static const char* complexImplStrD[numComplexImpls] = {"double2", "hipDoubleComplex",
+                                                       "std::complex<double>"};
+
+struct ComplexVariant {
+  ComplexLaunch launch[numComplexOps];
+  bool hasExp;
+};
+
+template <typename I, typename T> static ComplexVariant variant() {
+  return {{launchComplex<I, T, opMul>, launchComplex<I, T, opDiv>, launchComplex<I, T, opExp>,
+           launchComplex<I, T, opAbs>},
+          I::hasExp};
+}
+
+class hipPerfComplex : public HipPerf::Benchmark {
+ public:
+  hipPerfComplex() : HipPerf::Benchmark("hipPerfComplex"),
+      iterations_(HipPerf::iterationCount(4096)), out_(nullptr) {
+    variants_[0][implHand] = variant<HandComplex<float, float2>, float>();
+    variants_[0][implHip] = variant<HipComplexF, float>();
+    variants_[0][implStd] = variant<StdComplex<float>, float>();
+    variants_[1][implHand] = variant<HandComplex<double, double2>, double>();
+    variants_[1][implHip] = variant<HipComplexD, double>();
+    variants_[1][implStd] = variant<StdComplex<double>, double>();
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    HIPCHECK(hipMalloc(&out_, static_cast<size_t>(grid_.x) * blockSize * sizeof(double2)));
+  }
+
+  void close() override { HIPCHECK(hipFree(out_)); }
+
+  unsigned int numTests() override { return 2 * numComplexOps * numComplexImpls; }
+
+  void run(unsigned int test) override {
+    ComplexImpl impl = static_cast<ComplexImpl>(test % numComplexImpls);
+    ComplexOp op = static_cast<ComplexOp>((test / numComplexImpls) % numComplexOps);
+    int precision = test / (numComplexImpls * numComplexOps);
+    const ComplexVariant& v = variants_[precision][impl];
+    const char* implName = precision ? complexImplStrD[impl] : complexImplStr[impl];
+    if (op == opExp && !v.hasExp) {
+      printf("info: %s has no exp, skipping\n", implName);
+      return;
+    }
+
+    auto sec = measure([&]() {
+      v.launch[op](grid_, iterations_, out_);
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    double ops = static_cast<double>(grid_.x) * blockSize * iterations_ * 4;
+    std::vector<double> rate;
+    for (double s : sec) {
+      rate.push_back(ops / s / 1e9);
+    }
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%s %-20s", complexOpStr[op], implName);
+    report(test, desc, 0, iterations_, "Gops/s", rate);
+
+    // The hand written math runs first for every op
+    double median = ComputePerfStats(rate).median;
+    if (impl == implHand) {
+      reference_ = median;
+    } else if (reference_ > 0) {
+      report(test, std::string(desc) + " vs hand written", 0, iterations_, "x",
+             {median / reference_});
+    }
+  }
+
+ private:
+  unsigned int iterations_;
+  dim3 grid_;
+  void* out_;
+  double reference_ = 0;
+  ComplexVariant variants_[2][numComplexImpls];
+};
+
+HIP_PERF_BENCHMARK(hipPerfComplex)
@@ -0,0 +1,254 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of the cooperative groups synchronization points against the grid
+// size: thread_block::sync(), a shfl_down reduction over the coalesced group
+// of the odd lanes, grid_group::sync() in a hipLaunchCooperativeKernel launch
+// and multi_grid_group::sync() over every GPU that supports
+// hipLaunchCooperativeKernelMultiDevice, next to the kernel boundary they
+// would replace (back to back launches of an empty kernel on one stream).
+// Grids are 1 block, 1 block per CU and the maximum co-resident blocks of
+// 256 threads. Reports us per synchronization.
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include <hip/hip_cooperative_groups.h>
+
+#include "perf_harness.h"
+
+namespace cg = cooperative_groups;
+
+enum SyncOp {
+  opBlockSync = 0,
+  opCoalescedReduce,
+  opGridSync,
+  opMultiGridSync,
+  opKernelBoundary,
+  numSyncOps
+};
+
+static const char* syncOpStr[numSyncOps] = {"thread_block sync", "coalesced_group reduce",
+                                            "grid_group sync", "multi_grid_group sync",
+                                            "kernel boundary"};
+
+static const unsigned int blockSize = 256;
+static const int maxGpus = 8;
+
+__global__ void blockSyncKernel(unsigned int iterations, int* out) {
+  cg::thread_block block = cg::this_thread_block();
+  int v = threadIdx.x;
+  for (unsigned int i = 0; i < iterations; i++) {
+    block.sync();
+    v += i;
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = v;
+}
+
+__global__ void coalescedReduceKernel(unsigned int iterations, int* out) {
+  int v = threadIdx.x;
+  if (threadIdx.x % 2) {
+    for (unsigned int i = 0; i < iterations; i++) {
+      cg::coalesced_group g = cg::coalesced_threads();
+      for (int offset = g.size() / 2; offset > 0; offset /= 2) {
+        v += g.shfl_down(v, offset);
+      }
+    }
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = v;
+}
+
+__global__ void gridSyncKernel(unsigned int iterations, int* out) {
+  cg::grid_group grid = cg::this_grid();
+  int v = threadIdx.x;
+  for (unsigned int i = 0; i < iterations; i++) {
+    grid.sync();
+    v += i;
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = v;
+}
+
+__global__ void multiGridSyncKernel(unsigned int iterations, int* out) {
+  cg::multi_grid_group grids = cg::this_multi_grid();
+  int v = threadIdx.x;
+  for (unsigned int i = 0; i < iterations; i++) {
+    grids.sync();
+    v += i;
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = v;
+}
+
+__global__ void emptyKernel() {}
+
+class hipPerfCooperativeGroups : public HipPerf::Benchmark {
+ public:
+  hipPerfCooperativeGroups() : HipPerf::Benchmark("hipPerfCooperativeGroups"),
+      iterations_(HipPerf::iterationCount(1000)), cooperative_(0), numGpus_(0), multiGpus_(0) {
+    for (int g = 0; g < maxGpus; g++) {
+      out_[g] = nullptr;
+      streams_[g] = nullptr;
+    }
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&cooperative_, hipDeviceAttributeCooperativeLaunch,
+                                   deviceId));
+    int blocksPerCu = 0;
+    HIPCHECK(hipOccupancyMaxActiveBlocksPerMultiprocessor(
+        &blocksPerCu, reinterpret_cast<const void*>(multiGridSyncKernel), blockSize, 0));
+    unsigned int cus = props_.multiProcessorCount;
+    unsigned int maxBlocks = std::max(1, blocksPerCu) * cus;
+    gridSizes_ = {1, cus};
+    if (maxBlocks > cus) {
+      gridSizes_.push_back(maxBlocks);
+    }
+
+    // The opened device first, then the others when all of them can join a multi-grid launch
+    gpus_[0] = deviceId;
+    numGpus_ = 1;
+    int multi = 0;
+    HIPCHECK(hipDeviceGetAttribute(&multi, hipDeviceAttributeCooperativeMultiDeviceLaunch,
+                                   deviceId));
+    if (multi) {
+      int count = 0;
+      HIPCHECK(hipGetDeviceCount(&count));
+      for (int d = 1; d < count && numGpus_ < maxGpus; d++) {
+        int device = (deviceId + d) % count;
+        HIPCHECK(hipDeviceGetAttribute(&multi, hipDeviceAttributeCooperativeMultiDeviceLaunch,
+                                       device));
+        if (multi) {
+          gpus_[numGpus_++] = device;
+        }
+      }
+      multiGpus_ = numGpus_;
+    }
+    for (int g = 0; g < numGpus_; g++) {
+      HIPCHECK(hipSetDevice(gpus_[g]));
+      HIPCHECK(hipMalloc(&out_[g], sizeof(int) * maxBlocks * blockSize));
+      HIPCHECK(hipStreamCreateWithFlags(&streams_[g], hipStreamNonBlocking));
+    }
+    HIPCHECK(hipSetDevice(deviceId));
+  }
+
+  void close() override {
+    for (int g = 0; g < numGpus_; g++) {
+      HIPCHECK(hipSetDevice(gpus_[g]));
+      HIPCHECK(hipFree(out_[g]));
+      HIPCHECK(hipStreamDestroy(streams_[g]));
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+  }
+
+  unsigned int numTests() override { return numSyncOps * gridSizes_.size(); }
+
+  void run(unsigned int test) override {
+    SyncOp op = static_cast<SyncOp>(test / gridSizes_.size());
+    unsigned int blocks = gridSizes_[test % gridSizes_.size()];
+    if (op == opGridSync && !cooperative_) {
+      printf("info: device does not support cooperative launches, skipping\n");
+      return;
+    }
+    if (op == opMultiGridSync && multiGpus_ == 0) {
+      printf("info: no device supports cooperative multi-device launches, skipping\n");
+      return;
+    }
+
+    std::vector<double> sec;
+    switch (op) {
+      case opBlockSync:
+      case opCoalescedReduce:
+        sec = measure([&]() {
+          hipLaunchKernelGGL(op == opBlockSync ? blockSyncKernel : coalescedReduceKernel,
+                             dim3(blocks), dim3(blockSize), 0, streams_[0], iterations_,
+                             out_[0]);
+          HIPCHECK(hipStreamSynchronize(streams_[0]));
+        });
+        break;
+      case opGridSync: {
+        void* args[] = {&iterations_, &out_[0]};
+        sec = measure([&]() {
+          HIPCHECK(hipLaunchCooperativeKernel(reinterpret_cast<void*>(gridSyncKernel),
+                                              dim3(blocks), dim3(blockSize), args, 0,
+                                              streams_[0]));
+          HIPCHECK(hipStreamSynchronize(streams_[0]));
+        });
+        break;
+      }
+      case opMultiGridSync:
+        sec = measure([&]() { launchMultiGrid(blocks); });
+        break;
+      default:
+        sec = measure([&]() {
+          for (unsigned int i = 0; i < iterations_; i++) {
+            hipLaunchKernelGGL(emptyKernel, dim3(blocks), dim3(blockSize), 0, streams_[0]);
+          }
+          HIPCHECK(hipStreamSynchronize(streams_[0]));
+        });
+        break;
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-22s %5u blocks", syncOpStr[op], blocks);
+    if (op == opMultiGridSync) {
+      snprintf(desc, sizeof(desc), "%-22s %5u blocks x %d GPUs", syncOpStr[op], blocks,
+               multiGpus_);
+    }
+    report(test, desc, 0, iterations_, "us", HipPerf::toMicroseconds(sec, iterations_));
+  }
+
+ private:
+  // One grid of 'blocks' blocks on each of the first multiGpus_ devices.
+  void launchMultiGrid(unsigned int blocks) {
+    hipLaunchParams params[maxGpus];
+    void* args[maxGpus][2];
+    for (int g = 0; g < multiGpus_; g++) {
+      args[g][0] = &iterations_;
+      args[g][1] = &out_[g];
+      params[g].func = reinterpret_cast<void*>(multiGridSyncKernel);
+      params[g].gridDim = dim3(blocks);
+      params[g].blockDim = dim3(blockSize);
+      params[g].sharedMem = 0;
+      params[g].stream = streams_[g];
+      params[g].args = args[g];
+    }
+    HIPCHECK(hipLaunchCooperativeKernelMultiDevice(params, multiGpus_, 0));
+    for (int g = 0; g < multiGpus_; g++) {
+      HIPCHECK(hipStreamSynchronize(streams_[g]));
+    }
+  }
+
+  unsigned int iterations_;
+  int cooperative_;
+  std::vector<unsigned int> gridSizes_;
+  int numGpus_;    // devices with buffers and streams, gpus_[0] is the opened one
+  int multiGpus_;  // devices joining the multi-grid launches, 0 when unsupported
+  int gpus_[maxGpus];
+  int* out_[maxGpus];
+  hipStream_t streams_[maxGpus];
+};
+
+HIP_PERF_BENCHMARK(hipPerfCooperativeGroups)
@@ -0,0 +1,257 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// clock64() against wall_clock64(): cost of one read, smallest step between
+// two consecutive reads and the spread of the timestamps taken by one block
+// per CU released at the same moment. The spread is an upper bound of the
+// skew between CUs, it includes the time the release flag takes to reach
+// every CU. The rate test times a busy kernel with both counters and the host
+// and compares the rates with hipDeviceAttributeWallClockRate and the
+// reported shader clock. Ticks of clock64() are converted to ns with the
+// reported shader clock, which is only nominal under power management.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+#include "perf_harness.h"
+
+enum ClockKind { clockShader = 0, clockWall, numClockKinds };
+enum ClockTest { testOverhead = 0, testResolution, testSkew, numClockTests };
+
+static const char* clockKindStr[numClockKinds] = {"clock64", "wall_clock64"};
+static const char* clockTestStr[numClockTests] = {"read overhead", "resolution", "cross-CU spread"};
+
+static const unsigned int readsPerThread = 4096;
+static const unsigned int skewBlockSize = 64;
+static const unsigned int busyLoops = 1 << 22;
+
+template <ClockKind C> __device__ inline unsigned long long readClock() {
+  return static_cast<unsigned long long>(C == clockShader ? clock64() : wall_clock64());
+}
+
+// out[0] ticks for all reads, out[1] smallest step between two reads that differ
+template <ClockKind C> __global__ void sampleKernel(unsigned long long* out) {
+  unsigned long long first = readClock<C>();
+  unsigned long long last = first;
+  unsigned long long smallest = ~0ull;
+  for (unsigned int i = 0; i < readsPerThread; i++) {
+    unsigned long long now = readClock<C>();
+    if (now != last && now - last < smallest) {
+      smallest = now - last;
+    }
+    last = now;
+  }
+  out[0] = last - first;
+  out[1] = smallest;
+}
+
+// Every block stamps the moment it sees the release flag set by block 0 once
+// all blocks arrived. The grid must be resident at once.
+template <ClockKind C>
+__global__ void skewKernel(unsigned long long* stamps, unsigned int* cus, unsigned int* arrived,
+                           volatile unsigned int* release) {
+  if (threadIdx.x != 0) {
+    return;
+  }
+  if (blockIdx.x == 0) {
+    while (atomicAdd(arrived, 0u) < gridDim.x - 1) {
+    }
+    *release = 1;
+  } else {
+    atomicAdd(arrived, 1u);
+    while (*release == 0) {
+    }
+  }
+  stamps[blockIdx.x] = readClock<C>();
+#ifdef __HIP_PLATFORM_AMD__
+  cus[blockIdx.x] = __smid();
+#else
+  cus[blockIdx.x] = blockIdx.x;
+#endif
+}
+
+// out[0] clock64 ticks and out[1] wall_clock64 ticks over the busy loop
+__global__ void busyKernel(unsigned long long* out, unsigned int loops) {
+  unsigned long long shader = clock64();
+  unsigned long long wall = wall_clock64();
+  float v = threadIdx.x;
+  for (unsigned int i = 0; i < loops; i++) {
+    v = fmaf(v, 0.999f, 0.001f);
+  }
+  out[0] = clock64() - shader;
+  out[1] = wall_clock64() - wall;
+  out[2] = v == 0.5f;
+}
+
+class hipPerfDeviceClock : public HipPerf::Benchmark {
+ public:
+  hipPerfDeviceClock() : HipPerf::Benchmark("hipPerfDeviceClock"), wallRateKHz_(0),
+      out_(nullptr), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&wallRateKHz_, hipDeviceAttributeWallClockRate, deviceId));
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&out_, (props_.multiProcessorCount + 4) * sizeof(unsigned long long)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  // One extra test index for the rate comparison
+  unsigned int numTests() override { return numClockKinds * numClockTests + 1; }
+
+  void run(unsigned int test) override {
+    if (test == numClockKinds * numClockTests) {
+      runRate(test);
+      return;
+    }
+    ClockKind clock = static_cast<ClockKind>(test / numClockTests);
+    ClockTest clockTest = static_cast<ClockTest>(test % numClockTests);
+    double kHz = clock == clockShader ? props_.clockRate : wallRateKHz_;
+    if (kHz <= 0) {
+      printf("info: %s rate not reported, skipping\n", clockKindStr[clock]);
+      return;
+    }
+
+    std::vector<double> ticks = clockTest == testSkew ? sampleSkew(clock) : sample(clock,
+                                                                                 clockTest);
+    std::vector<double> ns;
+    for (double t : ticks) {
+      ns.push_back(t * 1e6 / kHz);
+    }
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-12s %s", clockKindStr[clock], clockTestStr[clockTest]);
+    unsigned int iterations = clockTest == testSkew ? 1 : readsPerThread;
+    report(test, desc, 0, iterations, "ticks", ticks);
+    report(test, desc, 0, iterations, "ns", ns);
+  }
+
+ private:
+  std::vector<double> sample(ClockKind clock, ClockTest clockTest) {
+    std::vector<double> ticks;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      if (clock == clockShader) {
+        hipLaunchKernelGGL(sampleKernel<clockShader>, dim3(1), dim3(1), 0, stream_, out_);
+      } else {
+        hipLaunchKernelGGL(sampleKernel<clockWall>, dim3(1), dim3(1), 0, stream_, out_);
+      }
+      unsigned long long out[2];
+      HIPCHECK(hipMemcpyAsync(out, out_, sizeof(out), hipMemcpyDeviceToHost, stream_));
+      HIPCHECK(hipStreamSynchronize(stream_));
+      if (r < p_warmup) {
+        continue;
+      }
+      ticks.push_back(clockTest == testOverhead
+                          ? static_cast<double>(out[0]) / readsPerThread
+                          : static_cast<double>(out[1]));
+    }
+    return ticks;
+  }
+
+  std::vector<double> sampleSkew(ClockKind clock) {
+    unsigned int blocks = props_.multiProcessorCount;
+    unsigned long long* stamps = nullptr;
+    unsigned int* cus = nullptr;
+    unsigned int* flags = nullptr;
+    HIPCHECK(hipMalloc(&stamps, blocks * sizeof(*stamps)));
+    HIPCHECK(hipMalloc(&cus, blocks * sizeof(*cus)));
+    HIPCHECK(hipMalloc(&flags, 2 * sizeof(*flags)));
+    std::vector<unsigned long long> hostStamps(blocks);
+    std::vector<unsigned int> hostCus(blocks);
+
+    std::vector<double> spread;
+    size_t distinct = 0;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      HIPCHECK(hipMemsetAsync(flags, 0, 2 * sizeof(*flags), stream_));
+      if (clock == clockShader) {
+        hipLaunchKernelGGL(skewKernel<clockShader>, dim3(blocks), dim3(skewBlockSize), 0, stream_,
+                           stamps, cus, flags, flags + 1);
+      } else {
+        hipLaunchKernelGGL(skewKernel<clockWall>, dim3(blocks), dim3(skewBlockSize), 0, stream_,
+                           stamps, cus, flags, flags + 1);
+      }
+      HIPCHECK(hipMemcpyAsync(hostStamps.data(), stamps, blocks * sizeof(*stamps),
+                              hipMemcpyDeviceToHost, stream_));
+      HIPCHECK(hipMemcpyAsync(hostCus.data(), cus, blocks * sizeof(*cus), hipMemcpyDeviceToHost,
+                              stream_));
+      HIPCHECK(hipStreamSynchronize(stream_));
+      if (r < p_warmup) {
+        continue;
+      }
+      auto range = std::minmax_element(hostStamps.begin(), hostStamps.end());
+      spread.push_back(static_cast<double>(*range.second - *range.first));
+      distinct = std::max(distinct, std::set<unsigned int>(hostCus.begin(), hostCus.end()).size());
+    }
+    printf("info: %s stamps taken on %zu distinct CUs of %u\n", clockKindStr[clock], distinct,
+           blocks);
+
+    HIPCHECK(hipFree(stamps));
+    HIPCHECK(hipFree(cus));
+    HIPCHECK(hipFree(flags));
+    return spread;
+  }
+
+  void runRate(unsigned int test) {
+    std::vector<double> wallMHz;
+    std::vector<double> shaderMHz;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      auto start = std::chrono::steady_clock::now();
+      hipLaunchKernelGGL(busyKernel, dim3(1), dim3(1), 0, stream_, out_, busyLoops);
+      HIPCHECK(hipStreamSynchronize(stream_));
+      std::chrono::duration<double> host = std::chrono::steady_clock::now() - start;
+      unsigned long long out[2];
+      HIPCHECK(hipMemcpy(out, out_, sizeof(out), hipMemcpyDeviceToHost));
+      if (r < p_warmup) {
+        continue;
+      }
+      // The host time includes the launch, the busy loop is long enough to hide it
+      wallMHz.push_back(out[1] / host.count() / 1e6);
+      if (wallRateKHz_ > 0 && out[1] > 0) {
+        shaderMHz.push_back(out[0] / (out[1] * 1e3 / wallRateKHz_) / 1e6);
+      }
+    }
+    char desc[96];
+    snprintf(desc, sizeof(desc), "wall_clock64 rate vs host, attribute %.3f MHz",
+             wallRateKHz_ / 1e3);
+    report(test, desc, 0, busyLoops, "MHz", wallMHz);
+    if (!shaderMHz.empty()) {
+      snprintf(desc, sizeof(desc), "clock64 rate vs wall_clock64, reported clock %.0f MHz",
+               props_.clockRate / 1e3);
+      report(test, desc, 0, busyLoops, "MHz", shaderMHz);
+    }
+  }
+
+  int wallRateKHz_;
+  unsigned long long* out_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfDeviceClock)
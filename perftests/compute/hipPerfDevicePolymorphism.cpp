@@ -0,0 +1,257 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of device side polymorphism. 16M elements each pick one of three
+// materials and apply its shading function 64 times. The function is
+// reached through a non-virtual member that switches on the material kind,
+// through virtual functions of objects constructed on the device, through a
+// table of device function pointers, or, when every element uses the same
+// material, as a template policy resolved at compile time. Materials are
+// either uniform across the grid or change from element to element, which
+// makes lanes of one wave take different paths. Reported are billion
+// evaluations per second and the ratio to the switch for the same layout.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum MaterialKind { kindDiffuse = 0, kindMetal, kindGlass, numMaterialKinds };
+
+struct DiffusePolicy {
+  __device__ static float shade(float x) { return fmaf(x, 0.5f, 0.25f); }
+};
+struct MetalPolicy {
+  __device__ static float shade(float x) { return x * x * 0.5f + 0.125f; }
+};
+struct GlassPolicy {
+  __device__ static float shade(float x) { return fmaf(x, 0.75f, 0.1f); }
+};
+
+// Non-virtual member dispatching on a tag
+struct TaggedMaterial {
+  int kind;
+  __device__ float shade(float x) const {
+    switch (kind) {
+      case kindDiffuse: return DiffusePolicy::shade(x);
+      case kindMetal: return MetalPolicy::shade(x);
+      default: return GlassPolicy::shade(x);
+    }
+  }
+};
+
+class Material {
+ public:
+  __device__ virtual ~Material() {}
+  __device__ virtual float shade(float x) const = 0;
+};
+
+template <typename P> class PolicyMaterial : public Material {
+ public:
+  __device__ float shade(float x) const override { return P::shade(x); }
+};
+
+typedef float (*ShadeFn)(float);
+
+template <typename P> __device__ float shadeFn(float x) { return P::shade(x); }
+
+// Objects need device side construction so their vtables point to device code
+__global__ void buildMaterials(Material** objects, void* storage, size_t slot, ShadeFn* fns) {
+  char* base = static_cast<char*>(storage);
+  objects[kindDiffuse] = new (base) PolicyMaterial<DiffusePolicy>();
+  objects[kindMetal] = new (base + slot) PolicyMaterial<MetalPolicy>();
+  objects[kindGlass] = new (base + 2 * slot) PolicyMaterial<GlassPolicy>();
+  fns[kindDiffuse] = shadeFn<DiffusePolicy>;
+  fns[kindMetal] = shadeFn<MetalPolicy>;
+  fns[kindGlass] = shadeFn<GlassPolicy>;
+}
+
+__global__ void destroyMaterials(Material** objects) {
+  for (int k = 0; k < numMaterialKinds; k++) {
+    objects[k]->~Material();
+  }
+}
+
+enum Dispatch { dispatchSwitch = 0, dispatchVirtual, dispatchPointer, dispatchPolicy,
+                numDispatches };
+static const char* dispatchStr[numDispatches] = {"non-virtual member switch", "virtual function",
+                                                 "function pointer", "template policy"};
+
+enum MaterialLayout { layoutUniform = 0, layoutDivergent, numMaterialLayouts };
+static const char* layoutStr[numMaterialLayouts] = {"uniform material", "per element material"};
+
+static const size_t numElements = 16 * 1024 * 1024;
+static const unsigned int shadeRounds = 64;
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+
+template <Dispatch D>
+__global__ void shadeElements(const int* kinds, Material* const* objects, const ShadeFn* fns,
+                              float* out, size_t n, unsigned int rounds) {
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < n;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    int kind = kinds[i];
+    float x = static_cast<float>(i & 1023) / 1024;
+    for (unsigned int r = 0; r < rounds; r++) {
+      switch (D) {
+        case dispatchSwitch:
+          x = TaggedMaterial{kind}.shade(x);
+          break;
+        case dispatchVirtual:
+          x = objects[kind]->shade(x);
+          break;
+        default:
+          x = fns[kind](x);
+          break;
+      }
+    }
+    out[i] = x;
+  }
+}
+
+template <typename P> __global__ void shadePolicy(float* out, size_t n, unsigned int rounds) {
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < n;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    float x = static_cast<float>(i & 1023) / 1024;
+    for (unsigned int r = 0; r < rounds; r++) {
+      x = P::shade(x);
+    }
+    out[i] = x;
+  }
+}
+
+class hipPerfDevicePolymorphism : public HipPerf::Benchmark {
+ public:
+  hipPerfDevicePolymorphism() : HipPerf::Benchmark("hipPerfDevicePolymorphism"),
+      objects_(nullptr), storage_(nullptr), fns_(nullptr), out_(nullptr), switchMedian_(0) {
+    for (auto& kinds : kinds_) {
+      kinds = nullptr;
+    }
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    std::vector<int> kinds(numElements);
+    for (int layout = 0; layout < numMaterialLayouts; layout++) {
+      for (size_t i = 0; i < numElements; i++) {
+        // Metal is the most expensive one, uniform grids use it throughout
+        kinds[i] = layout == layoutUniform ? kindMetal : static_cast<int>(i % numMaterialKinds);
+      }
+      HIPCHECK(hipMalloc(&kinds_[layout], numElements * sizeof(int)));
+      HIPCHECK(hipMemcpy(kinds_[layout], kinds.data(), numElements * sizeof(int),
+                         hipMemcpyHostToDevice));
+    }
+    HIPCHECK(hipMalloc(&out_, numElements * sizeof(float)));
+
+    size_t slot = std::max(sizeof(PolicyMaterial<DiffusePolicy>), size_t(16));
+    HIPCHECK(hipMalloc(&storage_, numMaterialKinds * slot));
+    HIPCHECK(hipMalloc(&objects_, numMaterialKinds * sizeof(Material*)));
+    HIPCHECK(hipMalloc(&fns_, numMaterialKinds * sizeof(ShadeFn)));
+    hipLaunchKernelGGL(buildMaterials, dim3(1), dim3(1), 0, 0, objects_, storage_, slot, fns_);
+    HIPCHECK(hipGetLastError());
+    HIPCHECK(hipDeviceSynchronize());
+  }
+
+  void close() override {
+    hipLaunchKernelGGL(destroyMaterials, dim3(1), dim3(1), 0, 0, objects_);
+    HIPCHECK(hipDeviceSynchronize());
+    HIPCHECK(hipFree(objects_));
+    HIPCHECK(hipFree(storage_));
+    HIPCHECK(hipFree(fns_));
+    HIPCHECK(hipFree(out_));
+    for (auto& kinds : kinds_) {
+      HIPCHECK(hipFree(kinds));
+    }
+  }
+
+  unsigned int numTests() override { return numMaterialLayouts * numDispatches; }
+
+  void run(unsigned int test) override {
+    Dispatch dispatch = static_cast<Dispatch>(test % numDispatches);
+    MaterialLayout layout = static_cast<MaterialLayout>(test / numDispatches);
+    // A template policy needs the material at compile time
+    if (dispatch == dispatchPolicy && layout != layoutUniform) {
+      return;
+    }
+
+    const int* kinds = kinds_[layout];
+    auto sec = measure([&]() {
+      switch (dispatch) {
+        case dispatchSwitch:
+          hipLaunchKernelGGL(shadeElements<dispatchSwitch>, grid_, dim3(blockSize), 0, 0, kinds,
+                             objects_, fns_, out_, numElements, shadeRounds);
+          break;
+        case dispatchVirtual:
+          hipLaunchKernelGGL(shadeElements<dispatchVirtual>, grid_, dim3(blockSize), 0, 0, kinds,
+                             objects_, fns_, out_, numElements, shadeRounds);
+          break;
+        case dispatchPointer:
+          hipLaunchKernelGGL(shadeElements<dispatchPointer>, grid_, dim3(blockSize), 0, 0, kinds,
+                             objects_, fns_, out_, numElements, shadeRounds);
+          break;
+        default:
+          hipLaunchKernelGGL(shadePolicy<MetalPolicy>, grid_, dim3(blockSize), 0, 0, out_,
+                             numElements, shadeRounds);
+          break;
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    std::vector<double> rate;
+    for (double s : sec) {
+      rate.push_back(static_cast<double>(numElements) * shadeRounds / s * 1e-9);
+    }
+    std::string desc = std::string(layoutStr[layout]) + " " + dispatchStr[dispatch];
+    report(test, desc, numElements * sizeof(float), shadeRounds, "Gevals/s", rate);
+
+    if (dispatch == dispatchSwitch) {
+      std::vector<double> sorted(rate);
+      std::sort(sorted.begin(), sorted.end());
+      switchMedian_ = sorted[sorted.size() / 2];
+    } else if (switchMedian_ > 0) {
+      std::vector<double> ratio;
+      for (double r : rate) {
+        ratio.push_back(r / switchMedian_);
+      }
+      report(test, desc + " vs switch", numElements * sizeof(float), shadeRounds, "x", ratio);
+    }
+  }
+
+ private:
+  int* kinds_[numMaterialLayouts];
+  Material** objects_;
+  void* storage_;
+  ShadeFn* fns_;
+  float* out_;
+  dim3 grid_;
+  double switchMedian_;  // switch dispatch of the layout being run
+};
+
+HIP_PERF_BENCHMARK(hipPerfDevicePolymorphism)
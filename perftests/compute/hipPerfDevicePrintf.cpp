@@ -0,0 +1,252 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Device printf throughput and its cost in a hot kernel. The throughput tests
+// launch 1 to 256K threads that each print one line in one of three formats
+// and report lines/s and MB/s from launch to synchronize, which includes the
+// host side formatting and writing. stdout is redirected to a temporary file
+// while a test runs; the lines found in the file against the lines printed
+// show whether any output was dropped when the printf buffer overflows. The
+// hot kernel tests run a grid-stride FMA kernel built without printf, with a
+// printf behind a runtime flag that stays off (dormant), and with the flag on
+// for 1 or 256 lines per launch, each next to its time relative to the build
+// without printf.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "perf_harness.h"
+
+enum PrintfFormat { fmtPlain, fmtInts, fmtMixed, numPrintfFormats };
+static const char* printfFormatStr[] = {"plain", "3 ints", "mixed"};
+
+static const unsigned int printThreads[] = {1, 256, 4096, 65536, 262144};
+static const unsigned int numPrintThreads = sizeof(printThreads) / sizeof(printThreads[0]);
+
+enum HotMode { hotNone, hotDormant, hotOneLine, hotManyLines, numHotModes };
+static const char* hotModeStr[] = {"no printf", "printf dormant", "printf 1 line",
+                                   "printf 256 lines"};
+
+static const unsigned int blockSize = 256;
+
+template <PrintfFormat FORMAT> __global__ void printKernel(unsigned int threads) {
+  unsigned int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  if (tid >= threads) {
+    return;
+  }
+  if (FORMAT == fmtPlain) {
+    printf("device printf throughput line\n");
+  } else if (FORMAT == fmtInts) {
+    printf("tid %u block %u value %u\n", tid, blockIdx.x, tid * 7);
+  } else {
+    printf("tid %u x %f y %e mask 0x%08x %s\n", tid, tid * 0.5f, tid * 1.25, tid, "label");
+  }
+}
+
+// Prints for the last element of every debugStride elements, never when debugStride is 0
+template <bool PRINTF>
+__global__ void hotKernel(float* data, size_t n, size_t debugStride) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    float v = data[i];
+#pragma unroll
+    for (int k = 0; k < 16; k++) {
+      v = v * 0.999f + 0.5f;
+    }
+    if (PRINTF && debugStride != 0 && i % debugStride == debugStride - 1) {
+      printf("debug i %zu v %f\n", i, v);
+    }
+    data[i] = v;
+  }
+}
+
+// Bytes the host writes for one launch of printKernel
+static size_t printBytes(PrintfFormat format, unsigned int threads) {
+  size_t bytes = 0;
+  for (unsigned int tid = 0; tid < threads; tid++) {
+    if (format == fmtPlain) {
+      bytes += snprintf(nullptr, 0, "device printf throughput line\n");
+    } else if (format == fmtInts) {
+      bytes += snprintf(nullptr, 0, "tid %u block %u value %u\n", tid, tid / blockSize, tid * 7);
+    } else {
+      bytes += snprintf(nullptr, 0, "tid %u x %f y %e mask 0x%08x %s\n", tid, tid * 0.5f,
+                        tid * 1.25, tid, "label");
+    }
+  }
+  return bytes;
+}
+
+class hipPerfDevicePrintf : public HipPerf::Benchmark {
+ public:
+  hipPerfDevicePrintf() : HipPerf::Benchmark("hipPerfDevicePrintf"),
+      launches_(HipPerf::iterationCount(10)), data_(nullptr), sink_(nullptr), savedStdout_(-1) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipMalloc(&data_, hotElements * sizeof(float)));
+    HIPCHECK(hipMemset(data_, 0, hotElements * sizeof(float)));
+  }
+
+  void close() override { HIPCHECK(hipFree(data_)); }
+
+  unsigned int numTests() override { return numPrintfFormats * numPrintThreads + numHotModes; }
+
+  void run(unsigned int test) override {
+    if (test < numPrintfFormats * numPrintThreads) {
+      runThroughput(test);
+    } else {
+      runHot(test);
+    }
+  }
+
+ private:
+  static const size_t hotElements = 16 * 1024 * 1024;
+
+  void runThroughput(unsigned int test) {
+    PrintfFormat format = static_cast<PrintfFormat>(test % numPrintfFormats);
+    unsigned int threads = printThreads[test / numPrintfFormats];
+    unsigned int blocks = (threads + blockSize - 1) / blockSize;
+
+    size_t launched = 0;
+    redirectStdout();
+    auto sec = measure([&]() {
+      for (unsigned int l = 0; l < launches_; l++) {
+        switch (format) {
+          case fmtPlain:
+            hipLaunchKernelGGL(printKernel<fmtPlain>, dim3(blocks), dim3(blockSize), 0, 0,
+                               threads);
+            break;
+          case fmtInts:
+            hipLaunchKernelGGL(printKernel<fmtInts>, dim3(blocks), dim3(blockSize), 0, 0,
+                               threads);
+            break;
+          default:
+            hipLaunchKernelGGL(printKernel<fmtMixed>, dim3(blocks), dim3(blockSize), 0, 0,
+                               threads);
+            break;
+        }
+        HIPCHECK(hipGetLastError());
+      }
+      HIPCHECK(hipDeviceSynchronize());
+      launched += launches_;
+    });
+    size_t delivered = restoreStdout();
+
+    size_t bytes = printBytes(format, threads);
+    std::vector<double> lineRate;
+    std::vector<double> byteRate;
+    for (double s : sec) {
+      lineRate.push_back(static_cast<double>(threads) * launches_ / s);
+      byteRate.push_back(static_cast<double>(bytes) * launches_ / s / 1e6);
+    }
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-6s %6u threads", printfFormatStr[format], threads);
+    report(test, desc, bytes, launches_, "lines/s", lineRate);
+    report(test, desc, bytes, launches_, "MB/s", byteRate);
+    std::vector<double> deliveredPercent = {100.0 * delivered / (launched * threads)};
+    snprintf(desc, sizeof(desc), "%-6s %6u threads lines delivered", printfFormatStr[format],
+             threads);
+    report(test, desc, bytes, launches_, "%", deliveredPercent);
+  }
+
+  void runHot(unsigned int test) {
+    HotMode mode = static_cast<HotMode>(test - numPrintfFormats * numPrintThreads);
+    size_t debugStride = mode == hotOneLine ? hotElements
+        : mode == hotManyLines ? hotElements / 256 : 0;
+    unsigned int blocks = props_.multiProcessorCount * 8;
+
+    auto baseSec = measure([&]() {
+      for (unsigned int l = 0; l < launches_; l++) {
+        hipLaunchKernelGGL(hotKernel<false>, dim3(blocks), dim3(blockSize), 0, 0, data_,
+                           hotElements, static_cast<size_t>(0));
+      }
+      HIPCHECK(hipDeviceSynchronize());
+    });
+    std::vector<double> sec = baseSec;
+    if (mode != hotNone) {
+      redirectStdout();
+      sec = measure([&]() {
+        for (unsigned int l = 0; l < launches_; l++) {
+          hipLaunchKernelGGL(hotKernel<true>, dim3(blocks), dim3(blockSize), 0, 0, data_,
+                             hotElements, debugStride);
+        }
+        HIPCHECK(hipDeviceSynchronize());
+      });
+      restoreStdout();
+    }
+
+    size_t bytes = hotElements * sizeof(float);
+    report(test, hotModeStr[mode], bytes, launches_, "us",
+           HipPerf::toMicroseconds(sec, launches_));
+    if (mode != hotNone) {
+      std::vector<double> ratio;
+      for (size_t i = 0; i < sec.size() && i < baseSec.size(); i++) {
+        ratio.push_back(sec[i] / baseSec[i]);
+      }
+      char desc[64];
+      snprintf(desc, sizeof(desc), "%s vs no printf", hotModeStr[mode]);
+      report(test, desc, bytes, launches_, "x", ratio, HipPerf::betterLower);
+    }
+  }
+
+  // Sends stdout, where the runtime writes device printf output, to a temporary file
+  void redirectStdout() {
+    fflush(stdout);
+    sink_ = tmpfile();
+    if (sink_ == nullptr) {
+      failed("cannot create a temporary file for printf output\n");
+    }
+    savedStdout_ = dup(fileno(stdout));
+    dup2(fileno(sink_), fileno(stdout));
+  }
+
+  // Restores stdout and returns the number of lines written to the temporary file
+  size_t restoreStdout() {
+    fflush(stdout);
+    dup2(savedStdout_, fileno(stdout));
+    ::close(savedStdout_);
+    savedStdout_ = -1;
+
+    size_t lines = 0;
+    char buffer[65536];
+    rewind(sink_);
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), sink_)) > 0) {
+      for (size_t i = 0; i < read; i++) {
+        lines += buffer[i] == '\n';
+      }
+    }
+    fclose(sink_);
+    sink_ = nullptr;
+    return lines;
+  }
+
+  unsigned int launches_;
+  float* data_;
+  FILE* sink_;
+  int savedStdout_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfDevicePrintf)
@@ -18,14 +18,28 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
  * TEST: %t
  * HIT_END
  */
 
+// ddot <x,y> and <x,x> with five reduction strategies: the original two-pass
+// reduction (DOT_DIM partial sums, then one block), two-pass with double2
+// loads over 4 blocks per CU, a single pass where every block atomically adds
+// its sum, a single pass where the last block to finish reduces the partial
+// sums, and a cooperative kernel that reduces them after a grid sync. The
+// single pass strategies also use double2 loads. Sizes are bytes per vector
+// (--sizes), up to 2 GB; every result is copied back to the host as a loss
+// function would, and reported in GB/s, GFLOP/s and percent of the
+// theoretical peak from memoryClockRate and memoryBusWidth.
+
 #include <iostream>
 #include <chrono>
-#include "test_common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <hip/hip_cooperative_groups.h>
+#include "perf_harness.h"
 #include <vector>
 
 #define DOT_DIM 256
@@ -232,151 +246,336 @@ void computeDotProduct(int n, const double* x, const double* y, double& result,
   return;
 }
 
-int main(int argc, char* argv[]) {
-
-  int nGpu = 0;
-  HIPCHECK(hipGetDeviceCount(&nGpu));
-
-  if (nGpu < 1) {
-    failed("No GPU!");
+// Block wide tree reduction through LDS, the sum is valid in every thread.
+template <unsigned int BLOCKSIZE> __device__ double blockSum(double value) {
+  __shared__ double sdata[BLOCKSIZE];
+  sdata[threadIdx.x] = value;
+  __syncthreads();
+  for (unsigned int s = BLOCKSIZE / 2; s > 0; s >>= 1) {
+    if (threadIdx.x < s) {
+      sdata[threadIdx.x] += sdata[threadIdx.x + s];
+    }
+    __syncthreads();
   }
-  hipDeviceProp_t props = {0};
-  props = {0};
-  HIPCHECK(hipSetDevice(p_gpuDevice));
-  HIPCHECK(hipGetDeviceProperties(&props, p_gpuDevice));
-  std::cout << "info: running on bus " << "0x" << props.pciBusID << " " << props.name
-    << " with " << props.multiProcessorCount << " CUs" << " and device id: " << p_gpuDevice
-    << std::endl;
-
-  int nx, ny, nz;
-
-  for (unsigned int testCase = 0; testCase < 3; testCase++) {
-
-  vector<int> vectorSize = {200, 300, 50};
-  switch(testCase) {
-
-  case 0:
-  nx = vectorSize[0];
-  ny = vectorSize[0];
-  nz = vectorSize[0];
-  break;
-
-  case 1:
-  nx = vectorSize[1];
-  ny = vectorSize[1];
-  nz = vectorSize[1];
-  break;
-
-  case 2:
-  nx = vectorSize[0];
-  ny = vectorSize[1];
-  nz = vectorSize[2];
-  break;
-
-  default:
-    break;
+  double sum = sdata[0];
+  __syncthreads();
+  return sum;
+}
 
+// This thread's share of <x,y> with double2 loads; SAME skips loading y for <x,x>.
+template <bool SAME>
+__device__ double threadDot(size_t n, const double* __restrict__ x,
+                            const double* __restrict__ y) {
+  size_t gid = blockIdx.x * blockDim.x + threadIdx.x;
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  const double2* x2 = reinterpret_cast<const double2*>(x);
+  const double2* y2 = reinterpret_cast<const double2*>(y);
+  double sum = 0.0;
+  for (size_t i = gid; i < n / 2; i += stride) {
+    double2 a = x2[i];
+    double2 b = SAME ? a : y2[i];
+    sum = fma(a.x, b.x, sum);
+    sum = fma(a.y, b.y, sum);
   }
-
-  int trials = 200;
-
-  int size = nx * ny * nz;
-
-  vector<double> hx(size);
-  vector<double> hy(size);
-  double hresult_xy = 0.0;
-  double hresult_xx = 0.0;
-
-  srand(time(NULL));
-
-  for(int i = 0; i < size; ++i) {
-    hx[i] = 2.0 * (double)rand() / (double)RAND_MAX - 1.0;
-    hy[i] = 2.0 * (double)rand() / (double)RAND_MAX - 1.0;
-
-    hresult_xy += hx[i] * hy[i];
-    hresult_xx += hx[i] * hx[i];
+  if (gid == 0 && n % 2) {
+    sum = fma(x[n - 1], y[n - 1], sum);
   }
+  return sum;
+}
 
-  double* dx;
-  double* dy;
-  double* workspace;
-  double  dresult;
-
-  HIPCHECK(hipMalloc((void**)&dx, sizeof(double) * size));
-  HIPCHECK(hipMalloc((void**)&dy, sizeof(double) * size));
-  HIPCHECK(hipMalloc((void**)&workspace, sizeof(double) * DOT_DIM));
-
-  HIPCHECK(hipMemcpy(dx, hx.data(), sizeof(double) * size, hipMemcpyHostToDevice));
-  HIPCHECK(hipMemcpy(dy, hy.data(), sizeof(double) * size, hipMemcpyHostToDevice));
-
-  // Warm up
-  computeDotProduct(size, dx, dy, dresult, workspace);
-  computeDotProduct(size, dx, dy, dresult, workspace);
-  computeDotProduct(size, dx, dy, dresult, workspace);
-
-  // Timed run for <x,y>
-  HIPCHECK(hipDeviceSynchronize());
-  auto all_start = std::chrono::steady_clock::now();
-
-  for(int i = 0; i < trials; ++i) {
-    computeDotProduct(size, dx, dy, dresult, workspace);
+template <unsigned int BLOCKSIZE, bool SAME>
+__launch_bounds__(BLOCKSIZE)
+__global__ void dot_partials(size_t n, const double* __restrict__ x,
+                             const double* __restrict__ y, double* __restrict__ partials) {
+  double sum = blockSum<BLOCKSIZE>(threadDot<SAME>(n, x, y));
+  if (threadIdx.x == 0) {
+    partials[blockIdx.x] = sum;
   }
+}
 
-  float time = 0;
-  auto all_end = std::chrono::steady_clock::now();
-  std::chrono::duration<double> all_kernel_time = all_end - all_start;
-  time = all_kernel_time.count();
-
-  time /= trials;
+// One block reducing count partial sums into *result.
+template <unsigned int BLOCKSIZE>
+__device__ void reducePartials(const double* partials, unsigned int count, double* result) {
+  double sum = 0.0;
+  for (unsigned int i = threadIdx.x; i < count; i += BLOCKSIZE) {
+    sum += partials[i];
+  }
+  sum = blockSum<BLOCKSIZE>(sum);
+  if (threadIdx.x == 0) {
+    *result = sum;
+  }
+}
 
-  double bw = sizeof(double) * size * 2.0 / 1e9;
-  double gf = 2.0 * size / 1e9;
+template <unsigned int BLOCKSIZE>
+__launch_bounds__(BLOCKSIZE)
+__global__ void dot_final(const double* __restrict__ partials, unsigned int count,
+                          double* __restrict__ result) {
+  reducePartials<BLOCKSIZE>(partials, count, result);
+}
 
-  cout << "\nVector Size: " << size << "\n[ddot] <x,y> " << time << "msec ;" << bw/ (time / 1e3) << " GByte/s ;"
-       << gf/(time / 1e3) << " GFlop/s" << endl;
+// *result must be zero before the launch
+template <unsigned int BLOCKSIZE, bool SAME>
+__launch_bounds__(BLOCKSIZE)
+__global__ void dot_atomic(size_t n, const double* __restrict__ x,
+                           const double* __restrict__ y, double* __restrict__ result) {
+  double sum = blockSum<BLOCKSIZE>(threadDot<SAME>(n, x, y));
+  if (threadIdx.x == 0) {
+    atomicAdd(result, sum);
+  }
+}
 
-  // Verify the device kernel results comparing it with the host results
-  if(std::abs(dresult - hresult_xy) > std::max(dresult * 1e-10, 1e-8)) {
-    cerr << " Device results inconsistent with host results. "
-         << " Host result: " << hresult_xy
-         << " Device result: " << dresult;
+// The last block to retire reduces the partials and resets *retired for the next launch.
+template <unsigned int BLOCKSIZE, bool SAME>
+__launch_bounds__(BLOCKSIZE)
+__global__ void dot_last_block(size_t n, const double* __restrict__ x,
+                               const double* __restrict__ y, double* partials,
+                               unsigned int* retired, double* result) {
+  __shared__ bool isLast;
+  double sum = blockSum<BLOCKSIZE>(threadDot<SAME>(n, x, y));
+  if (threadIdx.x == 0) {
+    partials[blockIdx.x] = sum;
+    __threadfence();
+    isLast = atomicAdd(retired, 1u) == gridDim.x - 1;
   }
+  __syncthreads();
+  if (isLast) {
+    __threadfence();
+    reducePartials<BLOCKSIZE>(partials, gridDim.x, result);
+    if (threadIdx.x == 0) {
+      *retired = 0;
+    }
+  }
+}
 
-  // Warm up
-  computeDotProduct(size, dx, dx, dresult, workspace);
-  computeDotProduct(size, dx, dx, dresult, workspace);
-  computeDotProduct(size, dx, dx, dresult, workspace);
+template <unsigned int BLOCKSIZE, bool SAME>
+__launch_bounds__(BLOCKSIZE)
+__global__ void dot_grid_sync(size_t n, const double* __restrict__ x,
+                              const double* __restrict__ y, double* partials, double* result) {
+  double sum = blockSum<BLOCKSIZE>(threadDot<SAME>(n, x, y));
+  if (threadIdx.x == 0) {
+    partials[blockIdx.x] = sum;
+  }
+  cooperative_groups::this_grid().sync();
+  if (blockIdx.x == 0) {
+    reducePartials<BLOCKSIZE>(partials, gridDim.x, result);
+  }
+}
 
-  // Timed run for <x,x>
-  HIPCHECK(hipDeviceSynchronize());
-  all_start = std::chrono::steady_clock::now();
+// Deterministic input in [-1, 1), generated on the device and recomputed on the host
+__host__ __device__ inline double inputAt(size_t i, unsigned int seed) {
+  unsigned long long h = (i + 1) * 0x9E3779B97F4A7C15ull ^ seed;
+  h ^= h >> 29;
+  h *= 0xBF58476D1CE4E5B9ull;
+  h ^= h >> 32;
+  return static_cast<double>(h >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
 
-  for(int i = 0; i < trials; ++i) {
-    computeDotProduct(size, dx, dx, dresult, workspace);
+__global__ void fill_input(size_t n, double* x, unsigned int seed) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    x[i] = inputAt(i, seed);
   }
+}
 
-  all_end = std::chrono::steady_clock::now();
-  all_kernel_time = all_end - all_start;
-  time = all_kernel_time.count();
-
-  time /= trials;
-  bw = sizeof(double) * size / 1e9;
+enum DotStrategy {
+  dotTwoPass = 0,
+  dotTwoPassVector,
+  dotAtomic,
+  dotLastBlock,
+  dotGridSync,
+  numDotStrategies
+};
+
+static const char* dotStrategyStr[numDotStrategies] = {
+    "two-pass", "two-pass double2", "single-pass atomic", "last-block-done", "grid-sync"};
+
+// 200^3, 300^3, 200*300*50 doubles as in the original test, plus 2 GB
+static const std::vector<size_t> Sizes = {64000000, 216000000, 24000000, 2147483648};
+static const unsigned int blocksPerCu = 4;
+
+class hipPerfDotProduct : public HipPerf::Benchmark {
+ public:
+  hipPerfDotProduct() : HipPerf::Benchmark("hipPerfDotProduct"),
+      sizes_(HipPerf::sweepSizes(Sizes)), trials_(HipPerf::iterationCount(20)), n_(0),
+      dx_(nullptr), dy_(nullptr), hostXY_(0), hostXX_(0), workspace_(nullptr), retired_(nullptr),
+      result_(nullptr), blocks_(0), cooperative_(0), gridSyncBlocks_(0), peakGBps_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    blocks_ = props_.multiProcessorCount * blocksPerCu;
+    HIPCHECK(hipDeviceGetAttribute(&cooperative_, hipDeviceAttributeCooperativeLaunch,
+                                   deviceId));
+    int resident = 0;
+    HIPCHECK(hipOccupancyMaxActiveBlocksPerMultiprocessor(
+        &resident, reinterpret_cast<const void*>(dot_grid_sync<DOT_DIM, false>), DOT_DIM, 0));
+    gridSyncBlocks_ = std::min(blocks_, static_cast<unsigned int>(resident) *
+                                            props_.multiProcessorCount);
+    HIPCHECK(hipMalloc(&workspace_, sizeof(double) * std::max<unsigned int>(blocks_, DOT_DIM)));
+    HIPCHECK(hipMalloc(&retired_, sizeof(unsigned int)));
+    HIPCHECK(hipMemset(retired_, 0, sizeof(unsigned int)));
+    HIPCHECK(hipMalloc(&result_, sizeof(double)));
+    // kHz, two transfers per clock
+    peakGBps_ = 2.0 * props_.memoryClockRate * 1e3 * (props_.memoryBusWidth / 8) * 1e-9;
+  }
+
+  void close() override {
+    freeInputs();
+    HIPCHECK(hipFree(workspace_));
+    HIPCHECK(hipFree(retired_));
+    HIPCHECK(hipFree(result_));
+  }
+
+  unsigned int numTests() override { return sizes_.size() * 2 * numDotStrategies; }
+
+  void run(unsigned int test) override {
+    DotStrategy strategy = static_cast<DotStrategy>(test % numDotStrategies);
+    bool same = (test / numDotStrategies) % 2 == 1;
+    size_t n = sizes_[test / (numDotStrategies * 2)] / sizeof(double);
+    if (strategy == dotGridSync && (!cooperative_ || gridSyncBlocks_ == 0)) {
+      printf("info: device does not support cooperative launches, skipping\n");
+      return;
+    }
+    if (strategy == dotTwoPass && n > static_cast<size_t>(INT32_MAX)) {
+      return;  // The original kernels index with int
+    }
+    if (!prepareInputs(n)) {
+      return;
+    }
 
-  cout << "[ddot] <x,y> " << time << "msec ;" << bw/ (time / 1e3) << " GByte/s ;"
-       << gf/(time / 1e3) << " GFlop/s" << endl;
+    const double* x = dx_;
+    const double* y = same ? dx_ : dy_;
+    double dresult = 0.0;
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < trials_; i++) {
+        dresult = dot(strategy, same, n, x, y);
+      }
+    });
+
+    double expected = same ? hostXX_ : hostXY_;
+    if (std::abs(dresult - expected) > std::max(std::abs(expected) * 1e-9, 1e-8)) {
+      failed("%s <x,%c> is %.17g, host result %.17g", dotStrategyStr[strategy], same ? 'x' : 'y',
+             dresult, expected);
+    }
 
-  // Verify the device kernel results comparing it with the host results
-  if(abs(dresult - hresult_xx) > max(dresult * 1e-10, 1e-8)) {
-    cerr << " Device results inconsistent with host results"
-         << " Host result: " << hresult_xy
-         << " Device result: " << dresult;
+    std::string desc = std::string(same ? "ddot <x,x> " : "ddot <x,y> ") +
+                       dotStrategyStr[strategy];
+    size_t bytes = sizeof(double) * n * (same ? 1 : 2);
+    auto gbps = HipPerf::toBandwidth(sec, static_cast<double>(bytes) * trials_);
+    report(test, desc, bytes, trials_, "GB/s", gbps);
+    std::vector<double> gflops;
+    for (double s : sec) {
+      gflops.push_back(2.0 * n * trials_ / s / 1e9);
+    }
+    report(test, desc, bytes, trials_, "GFLOP/s", gflops);
+    if (peakGBps_ > 0) {
+      std::vector<double> percent;
+      for (double g : gbps) {
+        percent.push_back(100.0 * g / peakGBps_);
+      }
+      report(test, desc + " of peak", bytes, trials_, "%", percent);
+    }
   }
 
-  HIPCHECK(hipFree(dx));
-  HIPCHECK(hipFree(dy));
-  HIPCHECK(hipFree(workspace));
+ private:
+  // One dot product including the copy of the result to the host.
+  double dot(DotStrategy strategy, bool same, size_t n, const double* x, const double* y) {
+    double result = 0.0;
+    switch (strategy) {
+      case dotTwoPass:
+        computeDotProduct(static_cast<int>(n), x, y, result, workspace_);
+        return result;
+      case dotTwoPassVector:
+        if (same) {
+          hipLaunchKernelGGL((dot_partials<DOT_DIM, true>), dim3(blocks_), dim3(DOT_DIM), 0, 0,
+                             n, x, y, workspace_);
+        } else {
+          hipLaunchKernelGGL((dot_partials<DOT_DIM, false>), dim3(blocks_), dim3(DOT_DIM), 0, 0,
+                             n, x, y, workspace_);
+        }
+        hipLaunchKernelGGL(dot_final<DOT_DIM>, dim3(1), dim3(DOT_DIM), 0, 0, workspace_, blocks_,
+                           result_);
+        break;
+      case dotAtomic:
+        HIPCHECK(hipMemsetAsync(result_, 0, sizeof(double), 0));
+        if (same) {
+          hipLaunchKernelGGL((dot_atomic<DOT_DIM, true>), dim3(blocks_), dim3(DOT_DIM), 0, 0, n,
+                             x, y, result_);
+        } else {
+          hipLaunchKernelGGL((dot_atomic<DOT_DIM, false>), dim3(blocks_), dim3(DOT_DIM), 0, 0,
+                             n, x, y, result_);
+        }
+        break;
+      case dotLastBlock:
+        if (same) {
+          hipLaunchKernelGGL((dot_last_block<DOT_DIM, true>), dim3(blocks_), dim3(DOT_DIM), 0, 0,
+                             n, x, y, workspace_, retired_, result_);
+        } else {
+          hipLaunchKernelGGL((dot_last_block<DOT_DIM, false>), dim3(blocks_), dim3(DOT_DIM), 0,
+                             0, n, x, y, workspace_, retired_, result_);
+        }
+        break;
+      default: {
+        void* args[] = {&n, &x, &y, &workspace_, &result_};
+        void* kernel = same ? reinterpret_cast<void*>(dot_grid_sync<DOT_DIM, true>)
+                            : reinterpret_cast<void*>(dot_grid_sync<DOT_DIM, false>);
+        HIPCHECK(hipLaunchCooperativeKernel(kernel, dim3(gridSyncBlocks_), dim3(DOT_DIM), args,
+                                            0, 0));
+        break;
+      }
+    }
+    HIPCHECK(hipMemcpy(&result, result_, sizeof(double), hipMemcpyDeviceToHost));
+    return result;
+  }
 
+  // Keeps the inputs of the last size, returns false when n doubles do not fit twice.
+  bool prepareInputs(size_t n) {
+    if (n == n_) {
+      return true;
+    }
+    freeInputs();
+    size_t free = 0, total = 0;
+    HIPCHECK(hipMemGetInfo(&free, &total));
+    if (2 * n * sizeof(double) > free * 9 / 10) {
+      printf("info: two vectors of %zu doubles do not fit into device memory, skipping\n", n);
+      return false;
+    }
+    HIPCHECK(hipMalloc(&dx_, sizeof(double) * n));
+    HIPCHECK(hipMalloc(&dy_, sizeof(double) * n));
+    hipLaunchKernelGGL(fill_input, dim3(blocks_), dim3(DOT_DIM), 0, 0, n, dx_, 1u);
+    hipLaunchKernelGGL(fill_input, dim3(blocks_), dim3(DOT_DIM), 0, 0, n, dy_, 2u);
+    HIPCHECK(hipDeviceSynchronize());
+    n_ = n;
+    hostXY_ = hostXX_ = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      double xi = inputAt(i, 1u);
+      hostXY_ += xi * inputAt(i, 2u);
+      hostXX_ += xi * xi;
+    }
+    return true;
   }
-  passed();
-  return 0;
-}
+
+  void freeInputs() {
+    if (dx_ != nullptr) {
+      HIPCHECK(hipFree(dx_));
+      HIPCHECK(hipFree(dy_));
+    }
+    dx_ = dy_ = nullptr;
+    n_ = 0;
+  }
+
+  std::vector<size_t> sizes_;
+  unsigned int trials_;
+  size_t n_;  // elements of dx_ and dy_
+  double* dx_;
+  double* dy_;
+  double hostXY_;  // host references of the current inputs
+  double hostXX_;
+  double* workspace_;       // partial sums, one per block
+  unsigned int* retired_;   // blocks done in dot_last_block
+  double* result_;
+  unsigned int blocks_;
+  int cooperative_;
+  unsigned int gridSyncBlocks_;
+  double peakGBps_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfDotProduct)
@@ -0,0 +1,181 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Static against dynamic shared memory of the same size, 1 KB to 32 KB per
+// block. Both kernels run the same code: every block fills its shared array,
+// then each thread reads it back at a stride that wraps with a mask of the
+// array size, a compile time constant for the static array and a kernel
+// argument for the extern one. Reported are the shared memory read bandwidth
+// of a launch of 16 blocks per CU, the active blocks per CU
+// hipOccupancyMaxActiveBlocksPerMultiprocessor predicts for the kernel (with
+// the dynamic size passed in for the extern array) and the ratio of the
+// dynamic to the static bandwidth.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int sharedSizes[] = {1024, 4096, 8192, 16384, 32768};
+static const unsigned int numSharedSizes = sizeof(sharedSizes) / sizeof(sharedSizes[0]);
+
+enum SharedKind { sharedStatic = 0, sharedDynamic, numSharedKinds };
+static const char* sharedKindStr[numSharedKinds] = {"static", "dynamic"};
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 16;
+static const unsigned int readRounds = 256;
+
+// count is a power of two
+__device__ inline void sharedWork(float* shared, unsigned int count, float* out) {
+  for (unsigned int i = threadIdx.x; i < count; i += blockDim.x) {
+    shared[i] = i;
+  }
+  __syncthreads();
+  float sum = 0;
+  unsigned int index = threadIdx.x;
+  for (unsigned int r = 0; r < readRounds; r++) {
+    sum += shared[index & (count - 1)];
+    index += 33;
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = sum;
+}
+
+template <unsigned int Bytes> __global__ void staticShared(float* out) {
+  __shared__ float shared[Bytes / sizeof(float)];
+  sharedWork(shared, Bytes / sizeof(float), out);
+}
+
+__global__ void dynamicShared(float* out, unsigned int count) {
+  extern __shared__ float shared[];
+  sharedWork(shared, count, out);
+}
+
+class hipPerfDynamicShared : public HipPerf::Benchmark {
+ public:
+  hipPerfDynamicShared() : HipPerf::Benchmark("hipPerfDynamicShared"), out_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    HIPCHECK(hipMalloc(&out_, static_cast<size_t>(grid_.x) * blockSize * sizeof(float)));
+    staticGBps_.assign(numSharedSizes, 0);
+  }
+
+  void close() override { HIPCHECK(hipFree(out_)); }
+
+  unsigned int numTests() override { return numSharedSizes * numSharedKinds; }
+
+  void run(unsigned int test) override {
+    SharedKind kind = static_cast<SharedKind>(test % numSharedKinds);
+    unsigned int sizeIndex = test / numSharedKinds;
+    unsigned int bytes = sharedSizes[sizeIndex];
+    if (bytes > props_.sharedMemPerBlock) {
+      printf("info: %u bytes exceed sharedMemPerBlock, skipping\n", bytes);
+      return;
+    }
+
+    int activeBlocks = 0;
+    if (kind == sharedStatic) {
+      HIPCHECK(hipOccupancyMaxActiveBlocksPerMultiprocessor(&activeBlocks,
+                                                            staticKernel(bytes),
+                                                            blockSize, 0));
+    } else {
+      HIPCHECK(hipOccupancyMaxActiveBlocksPerMultiprocessor(
+          &activeBlocks, reinterpret_cast<const void*>(dynamicShared), blockSize, bytes));
+    }
+
+    auto sec = measure([&]() {
+      if (kind == sharedStatic) {
+        launchStatic(bytes);
+      } else {
+        hipLaunchKernelGGL(dynamicShared, grid_, dim3(blockSize), bytes, 0, out_,
+                           static_cast<unsigned int>(bytes / sizeof(float)));
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%5u bytes %s", bytes, sharedKindStr[kind]);
+    double readBytes = static_cast<double>(grid_.x) * blockSize * readRounds * sizeof(float);
+    auto gbps = HipPerf::toBandwidth(sec, readBytes);
+    report(test, std::string(desc) + " shared read", bytes, readRounds, "GB/s", gbps);
+    report(test, std::string(desc) + " occupancy", bytes, 1, "blocks/CU",
+           {static_cast<double>(activeBlocks)});
+
+    std::vector<double> sorted(gbps);
+    std::sort(sorted.begin(), sorted.end());
+    double median = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    if (kind == sharedStatic) {
+      staticGBps_[sizeIndex] = median;
+    } else if (staticGBps_[sizeIndex] > 0) {
+      std::vector<double> ratio;
+      for (double g : gbps) {
+        ratio.push_back(g / staticGBps_[sizeIndex]);
+      }
+      report(test, std::string(desc) + " vs static", bytes, readRounds, "x", ratio);
+    }
+  }
+
+ private:
+  static const void* staticKernel(unsigned int bytes) {
+    switch (bytes) {
+      case 1024: return reinterpret_cast<const void*>(staticShared<1024>);
+      case 4096: return reinterpret_cast<const void*>(staticShared<4096>);
+      case 8192: return reinterpret_cast<const void*>(staticShared<8192>);
+      case 16384: return reinterpret_cast<const void*>(staticShared<16384>);
+      default: return reinterpret_cast<const void*>(staticShared<32768>);
+    }
+  }
+
+  void launchStatic(unsigned int bytes) {
+    switch (bytes) {
+      case 1024:
+        hipLaunchKernelGGL(staticShared<1024>, grid_, dim3(blockSize), 0, 0, out_);
+        break;
+      case 4096:
+        hipLaunchKernelGGL(staticShared<4096>, grid_, dim3(blockSize), 0, 0, out_);
+        break;
+      case 8192:
+        hipLaunchKernelGGL(staticShared<8192>, grid_, dim3(blockSize), 0, 0, out_);
+        break;
+      case 16384:
+        hipLaunchKernelGGL(staticShared<16384>, grid_, dim3(blockSize), 0, 0, out_);
+        break;
+      default:
+        hipLaunchKernelGGL(staticShared<32768>, grid_, dim3(blockSize), 0, 0, out_);
+        break;
+    }
+  }
+
+  dim3 grid_;
+  float* out_;
+  std::vector<double> staticGBps_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfDynamicShared)
@@ -0,0 +1,507 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Dense C = A * B with row major A (M x K) and B (K x N) in float, half or
+// bfloat16 and a float C, accumulated in float. Four kernels per type: one
+// thread per element straight from global memory, 16x16 tiles staged in LDS,
+// 64x64 block tiles with 4x4 elements per thread in registers, and matrix
+// core instructions (v_mfma 16x16x4 f32, 16x16x16 f16 and bf16_1k), one
+// 16x64 strip of C per wave. Shapes include square sizes and skinny M, N and
+// K; all dimensions are multiples of 64. Inputs are small multiples of 0.25,
+// exact in every type, so sampled elements of C must match the host result
+// exactly. Reports TFLOPS (2 M N K per GEMM) and percent of peak: the vector
+// kernels convert to float and are held against one FMA per lane per clock
+// on 64 lanes per CU (as hipPerfMandelbrot), the MFMA kernels against the
+// dense matrix rate per CU and clock of the architecture. The MFMA kernels
+// run on gfx908 (no bf16), gfx90a and gfx94x only; bfloat16 runs on AMD only.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <hip/hip_fp16.h>
+#ifdef __HIP_PLATFORM_AMD__
+#include <hip/hip_bf16.h>
+#endif
+
+#include "perf_harness.h"
+
+#if defined(__gfx908__) || defined(__gfx90a__) || defined(__gfx940__) || defined(__gfx941__) || \
+    defined(__gfx942__)
+#define GEMM_MFMA 1
+#endif
+#if defined(__gfx90a__) || defined(__gfx940__) || defined(__gfx941__) || defined(__gfx942__)
+#define GEMM_MFMA_BF16 1
+#endif
+
+struct GemmShape {
+  int m, n, k;
+};
+
+static const GemmShape gemmShapes[] = {
+    {256, 256, 256},   {1024, 1024, 1024}, {4096, 4096, 4096}, {64, 4096, 4096},
+    {4096, 64, 4096},  {4096, 4096, 64},   {128, 128, 16384},
+};
+static const unsigned int numGemmShapes = sizeof(gemmShapes) / sizeof(gemmShapes[0]);
+
+enum GemmType {
+  typeFloat = 0,
+  typeHalf,
+#ifdef __HIP_PLATFORM_AMD__
+  typeBf16,
+#endif
+  numGemmTypes
+};
+static const char* gemmTypeStr[] = {"fp32", "fp16", "bf16"};
+static const size_t gemmTypeSize[] = {sizeof(float), sizeof(__half), 2};
+
+enum GemmKernel { kernelNaive = 0, kernelTiled, kernelRegister, kernelMfma, numGemmKernels };
+static const char* gemmKernelStr[numGemmKernels] = {"naive", "LDS tiled", "register blocked",
+                                                    "MFMA"};
+
+// Floating point operations per GEMM for which one repetition launches once
+static const double flopsPerRepetition = 2e10;
+// Elements of C compared with the host result after each test
+static const unsigned int checkedElements = 256;
+
+__device__ inline float toFloat(float x) { return x; }
+__device__ inline float toFloat(__half x) { return __half2float(x); }
+#ifdef __HIP_PLATFORM_AMD__
+__device__ inline float toFloat(__hip_bfloat16 x) { return __bfloat162float(x); }
+#endif
+
+// 16x16 threads, one element each
+template <typename T>
+__global__ void gemmNaive(const T* a, const T* b, float* c, int m, int n, int k) {
+  int row = blockIdx.y * blockDim.y + threadIdx.y;
+  int col = blockIdx.x * blockDim.x + threadIdx.x;
+  float acc = 0;
+  for (int i = 0; i < k; i++) {
+    acc += toFloat(a[row * k + i]) * toFloat(b[i * n + col]);
+  }
+  c[row * n + col] = acc;
+}
+
+// 16x16 threads, one element each, A and B staged through LDS 16 columns of K at a time
+template <typename T>
+__global__ void gemmTiled(const T* a, const T* b, float* c, int m, int n, int k) {
+  __shared__ float as[16][16];
+  __shared__ float bs[16][16];
+  int tx = threadIdx.x;
+  int ty = threadIdx.y;
+  int row = blockIdx.y * 16 + ty;
+  int col = blockIdx.x * 16 + tx;
+  float acc = 0;
+  for (int k0 = 0; k0 < k; k0 += 16) {
+    as[ty][tx] = toFloat(a[row * k + k0 + tx]);
+    bs[ty][tx] = toFloat(b[(k0 + ty) * n + col]);
+    __syncthreads();
+    for (int i = 0; i < 16; i++) {
+      acc += as[ty][i] * bs[i][tx];
+    }
+    __syncthreads();
+  }
+  c[row * n + col] = acc;
+}
+
+// 256 threads per 64x64 tile of C, each accumulating 4x4 elements 16 apart in registers
+template <typename T>
+__global__ void __launch_bounds__(256)
+    gemmRegisterBlocked(const T* a, const T* b, float* c, int m, int n, int k) {
+  __shared__ float as[64][17];  // padded, the loads walk rows
+  __shared__ float bs[16][64];
+  int tx = threadIdx.x % 16;
+  int ty = threadIdx.x / 16;
+  int row0 = blockIdx.y * 64;
+  int col0 = blockIdx.x * 64;
+  float acc[4][4] = {};
+  for (int k0 = 0; k0 < k; k0 += 16) {
+    for (int i = threadIdx.x; i < 64 * 16; i += 256) {
+      as[i / 16][i % 16] = toFloat(a[(row0 + i / 16) * k + k0 + i % 16]);
+      bs[i / 64][i % 64] = toFloat(b[(k0 + i / 64) * n + col0 + i % 64]);
+    }
+    __syncthreads();
+    for (int kk = 0; kk < 16; kk++) {
+      float av[4], bv[4];
+      for (int i = 0; i < 4; i++) {
+        av[i] = as[ty + 16 * i][kk];
+        bv[i] = bs[kk][tx + 16 * i];
+      }
+      for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+          acc[i][j] += av[i] * bv[j];
+        }
+      }
+    }
+    __syncthreads();
+  }
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) {
+      c[(row0 + ty + 16 * i) * n + col0 + tx + 16 * j] = acc[i][j];
+    }
+  }
+}
+
+/*
+MFMA kernels: 4 waves of 64 lanes per 64x64 tile of C, wave w owns rows 16w to 16w + 15 and
+keeps four 16x16 accumulators, so its A fragment is reused for four instructions. In the
+16x16 layouts lane l holds row (A) or column (B) l % 16 at K offset l / 16 (x4 for the 16
+deep f16 and bf16 forms, four consecutive K each), and accumulator element i of lane l is
+C row 4 * (l / 16) + i, column l % 16. The bodies only exist for architectures with these
+instructions, the host skips the others.
+*/
+#ifdef GEMM_MFMA
+typedef float floatx4 __attribute__((ext_vector_type(4)));
+typedef _Float16 halfx4 __attribute__((ext_vector_type(4)));
+typedef short shortx4 __attribute__((ext_vector_type(4)));
+
+__device__ inline void storeMfmaStrip(float* c, int n, int row0, int col0, unsigned int lane,
+                                      const floatx4* acc) {
+  for (int j = 0; j < 4; j++) {
+    for (int i = 0; i < 4; i++) {
+      c[(row0 + 4 * (lane / 16) + i) * n + col0 + 16 * j + lane % 16] = acc[j][i];
+    }
+  }
+}
+#endif
+
+__global__ void __launch_bounds__(256)
+    gemmMfmaFloat(const float* a, const float* b, float* c, int m, int n, int k) {
+#ifdef GEMM_MFMA
+  unsigned int lane = threadIdx.x % 64;
+  int row0 = blockIdx.y * 64 + (threadIdx.x / 64) * 16;
+  int col0 = blockIdx.x * 64;
+  int r = lane % 16;
+  int q = lane / 16;
+  floatx4 acc[4] = {};
+  for (int k0 = 0; k0 < k; k0 += 4) {
+    float av = a[(row0 + r) * k + k0 + q];
+    for (int j = 0; j < 4; j++) {
+      float bv = b[(k0 + q) * n + col0 + 16 * j + r];
+      acc[j] = __builtin_amdgcn_mfma_f32_16x16x4f32(av, bv, acc[j], 0, 0, 0);
+    }
+  }
+  storeMfmaStrip(c, n, row0, col0, lane, acc);
+#endif
+}
+
+__global__ void __launch_bounds__(256)
+    gemmMfmaHalf(const __half* a, const __half* b, float* c, int m, int n, int k) {
+#ifdef GEMM_MFMA
+  const _Float16* a16 = reinterpret_cast<const _Float16*>(a);
+  const _Float16* b16 = reinterpret_cast<const _Float16*>(b);
+  unsigned int lane = threadIdx.x % 64;
+  int row0 = blockIdx.y * 64 + (threadIdx.x / 64) * 16;
+  int col0 = blockIdx.x * 64;
+  int r = lane % 16;
+  int q = lane / 16;
+  floatx4 acc[4] = {};
+  for (int k0 = 0; k0 < k; k0 += 16) {
+    halfx4 av;
+    for (int i = 0; i < 4; i++) {
+      av[i] = a16[(row0 + r) * k + k0 + 4 * q + i];
+    }
+    for (int j = 0; j < 4; j++) {
+      halfx4 bv;
+      for (int i = 0; i < 4; i++) {
+        bv[i] = b16[(k0 + 4 * q + i) * n + col0 + 16 * j + r];
+      }
+      acc[j] = __builtin_amdgcn_mfma_f32_16x16x16f16(av, bv, acc[j], 0, 0, 0);
+    }
+  }
+  storeMfmaStrip(c, n, row0, col0, lane, acc);
+#endif
+}
+
+#ifdef __HIP_PLATFORM_AMD__
+__global__ void __launch_bounds__(256)
+    gemmMfmaBf16(const __hip_bfloat16* a, const __hip_bfloat16* b, float* c, int m, int n, int k) {
+#ifdef GEMM_MFMA_BF16
+  const short* a16 = reinterpret_cast<const short*>(a);
+  const short* b16 = reinterpret_cast<const short*>(b);
+  unsigned int lane = threadIdx.x % 64;
+  int row0 = blockIdx.y * 64 + (threadIdx.x / 64) * 16;
+  int col0 = blockIdx.x * 64;
+  int r = lane % 16;
+  int q = lane / 16;
+  floatx4 acc[4] = {};
+  for (int k0 = 0; k0 < k; k0 += 16) {
+    shortx4 av;
+    for (int i = 0; i < 4; i++) {
+      av[i] = a16[(row0 + r) * k + k0 + 4 * q + i];
+    }
+    for (int j = 0; j < 4; j++) {
+      shortx4 bv;
+      for (int i = 0; i < 4; i++) {
+        bv[i] = b16[(k0 + 4 * q + i) * n + col0 + 16 * j + r];
+      }
+      acc[j] = __builtin_amdgcn_mfma_f32_16x16x16bf16_1k(av, bv, acc[j], 0, 0, 0);
+    }
+  }
+  storeMfmaStrip(c, n, row0, col0, lane, acc);
+#endif
+}
+#endif
+
+static void launchMfma(const float* a, const float* b, float* c, const GemmShape& s,
+                       hipStream_t stream) {
+  hipLaunchKernelGGL(gemmMfmaFloat, dim3(s.n / 64, s.m / 64), dim3(256), 0, stream, a, b, c, s.m,
+                     s.n, s.k);
+}
+
+static void launchMfma(const __half* a, const __half* b, float* c, const GemmShape& s,
+                       hipStream_t stream) {
+  hipLaunchKernelGGL(gemmMfmaHalf, dim3(s.n / 64, s.m / 64), dim3(256), 0, stream, a, b, c, s.m,
+                     s.n, s.k);
+}
+
+#ifdef __HIP_PLATFORM_AMD__
+static void launchMfma(const __hip_bfloat16* a, const __hip_bfloat16* b, float* c,
+                       const GemmShape& s, hipStream_t stream) {
+  hipLaunchKernelGGL(gemmMfmaBf16, dim3(s.n / 64, s.m / 64), dim3(256), 0, stream, a, b, c, s.m,
+                     s.n, s.k);
+}
+#endif
+
+template <typename T>
+static void launchGemm(GemmKernel kernel, const void* a, const void* b, float* c,
+                       const GemmShape& s, hipStream_t stream) {
+  const T* ta = static_cast<const T*>(a);
+  const T* tb = static_cast<const T*>(b);
+  switch (kernel) {
+    case kernelNaive:
+      hipLaunchKernelGGL(gemmNaive<T>, dim3(s.n / 16, s.m / 16), dim3(16, 16), 0, stream, ta, tb,
+                         c, s.m, s.n, s.k);
+      break;
+    case kernelTiled:
+      hipLaunchKernelGGL(gemmTiled<T>, dim3(s.n / 16, s.m / 16), dim3(16, 16), 0, stream, ta, tb,
+                         c, s.m, s.n, s.k);
+      break;
+    case kernelRegister:
+      hipLaunchKernelGGL(gemmRegisterBlocked<T>, dim3(s.n / 64, s.m / 64), dim3(256), 0, stream,
+                         ta, tb, c, s.m, s.n, s.k);
+      break;
+    default:
+#ifdef __HIP_PLATFORM_AMD__
+      launchMfma(ta, tb, c, s, stream);
+#endif
+      break;
+  }
+}
+
+// Exact in float, half and bfloat16; products and sums of up to 64k of them stay exact
+static float inputValue(size_t i, unsigned int salt) {
+  return static_cast<float>(static_cast<int>((i * 2654435761u + salt) % 7) - 3) * 0.25f;
+}
+
+// Dense matrix FLOPs per CU and clock, 0 without matrix cores for the type
+static double matrixFlopsPerClock(const char* arch, GemmType type) {
+  bool gfx908 = strncmp(arch, "gfx908", 6) == 0;
+  bool gfx90a = strncmp(arch, "gfx90a", 6) == 0;
+  bool gfx94x = strncmp(arch, "gfx94", 5) == 0;
+  switch (type) {
+    case typeFloat:
+      return gfx908 || gfx90a || gfx94x ? 256 : 0;
+    case typeHalf:
+      return gfx94x ? 2048 : gfx908 || gfx90a ? 1024 : 0;
+    default:
+      return gfx94x ? 2048 : gfx90a ? 1024 : 0;
+  }
+}
+
+class hipPerfGemm : public HipPerf::Benchmark {
+ public:
+  hipPerfGemm() : HipPerf::Benchmark("hipPerfGemm"), stream_(nullptr), a_(nullptr), b_(nullptr),
+      c_(nullptr), preparedShape_(numGemmShapes), preparedType_(numGemmTypes),
+      vectorTflops_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    // One FMA per lane per clock on 64 lanes per CU
+    vectorTflops_ = static_cast<double>(props_.multiProcessorCount) * props_.clockRate * 1e3 *
+                    128 * 1e-12;
+  }
+
+  void close() override {
+    release();
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numGemmShapes * numGemmTypes * numGemmKernels; }
+
+  void run(unsigned int test) override {
+    GemmKernel kernel = static_cast<GemmKernel>(test % numGemmKernels);
+    GemmType type = static_cast<GemmType>((test / numGemmKernels) % numGemmTypes);
+    unsigned int shapeIndex = test / (numGemmKernels * numGemmTypes);
+    const GemmShape& shape = gemmShapes[shapeIndex];
+
+    double peakTflops = vectorTflops_;
+    if (kernel == kernelMfma) {
+#ifdef __HIP_PLATFORM_AMD__
+      double perClock = matrixFlopsPerClock(props_.gcnArchName, type);
+      if (perClock == 0) {
+        printf("info: %s has no %s MFMA instructions, skipping\n", props_.gcnArchName,
+               gemmTypeStr[type]);
+        return;
+      }
+      peakTflops = static_cast<double>(props_.multiProcessorCount) * props_.clockRate * 1e3 *
+                   perClock * 1e-12;
+#else
+      printf("info: MFMA kernels need AMD matrix cores, skipping\n");
+      return;
+#endif
+    }
+
+    prepare(shapeIndex, type);
+    HIPCHECK(hipMemset(c_, 0, sizeof(float) * shape.m * shape.n));
+    double flops = 2.0 * shape.m * shape.n * shape.k;
+    unsigned int launches = std::max(1u, static_cast<unsigned int>(flopsPerRepetition / flops));
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < launches; i++) {
+        switch (type) {
+          case typeFloat:
+            launchGemm<float>(kernel, a_, b_, c_, shape, stream_);
+            break;
+          case typeHalf:
+            launchGemm<__half>(kernel, a_, b_, c_, shape, stream_);
+            break;
+#ifdef __HIP_PLATFORM_AMD__
+          default:
+            launchGemm<__hip_bfloat16>(kernel, a_, b_, c_, shape, stream_);
+            break;
+#endif
+        }
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    verify(shape, type, kernel);
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %-16s M %5d N %5d K %5d", gemmTypeStr[type],
+             gemmKernelStr[kernel], shape.m, shape.n, shape.k);
+    size_t bytes = gemmTypeSize[type] * (static_cast<size_t>(shape.m) * shape.k +
+                                         static_cast<size_t>(shape.k) * shape.n) +
+                   sizeof(float) * shape.m * shape.n;
+    std::vector<double> tflops;
+    for (double s : sec) {
+      tflops.push_back(flops * launches / s * 1e-12);
+    }
+    report(test, desc, bytes, launches, "TFLOPS", tflops);
+    if (peakTflops > 0) {
+      std::vector<double> percent;
+      for (double t : tflops) {
+        percent.push_back(100.0 * t / peakTflops);
+      }
+      report(test, std::string(desc) + " of peak", bytes, launches, "%", percent);
+    }
+  }
+
+ private:
+  // Inputs stay allocated for the kernels of one shape and type
+  void prepare(unsigned int shapeIndex, GemmType type) {
+    if (shapeIndex == preparedShape_ && type == preparedType_) {
+      return;
+    }
+    release();
+    const GemmShape& shape = gemmShapes[shapeIndex];
+    size_t aCount = static_cast<size_t>(shape.m) * shape.k;
+    size_t bCount = static_cast<size_t>(shape.k) * shape.n;
+    HIPCHECK(hipMalloc(&a_, gemmTypeSize[type] * aCount));
+    HIPCHECK(hipMalloc(&b_, gemmTypeSize[type] * bCount));
+    HIPCHECK(hipMalloc(&c_, sizeof(float) * shape.m * shape.n));
+    upload(a_, aCount, 1, type);
+    upload(b_, bCount, 2, type);
+    preparedShape_ = shapeIndex;
+    preparedType_ = type;
+  }
+
+  void release() {
+    if (a_ != nullptr) {
+      HIPCHECK(hipFree(a_));
+      HIPCHECK(hipFree(b_));
+      HIPCHECK(hipFree(c_));
+    }
+    a_ = b_ = nullptr;
+    c_ = nullptr;
+    preparedShape_ = numGemmShapes;
+    preparedType_ = numGemmTypes;
+  }
+
+  void upload(void* dst, size_t count, unsigned int salt, GemmType type) {
+    std::vector<char> host(gemmTypeSize[type] * count);
+    for (size_t i = 0; i < count; i++) {
+      float v = inputValue(i, salt);
+      switch (type) {
+        case typeFloat:
+          reinterpret_cast<float*>(host.data())[i] = v;
+          break;
+        case typeHalf:
+          reinterpret_cast<__half*>(host.data())[i] = __float2half(v);
+          break;
+#ifdef __HIP_PLATFORM_AMD__
+        default:
+          reinterpret_cast<__hip_bfloat16*>(host.data())[i] = __float2bfloat16(v);
+          break;
+#endif
+      }
+    }
+    HIPCHECK(hipMemcpy(dst, host.data(), host.size(), hipMemcpyHostToDevice));
+  }
+
+  // Compares a spread of elements of C, the inputs make every result exact
+  void verify(const GemmShape& shape, GemmType type, GemmKernel kernel) {
+    std::vector<float> c(static_cast<size_t>(shape.m) * shape.n);
+    HIPCHECK(hipMemcpy(c.data(), c_, sizeof(float) * c.size(), hipMemcpyDeviceToHost));
+    for (unsigned int e = 0; e < checkedElements; e++) {
+      size_t index = (static_cast<size_t>(e) * 2654435761u) % c.size();
+      int row = static_cast<int>(index / shape.n);
+      int col = static_cast<int>(index % shape.n);
+      double expected = 0;
+      for (int i = 0; i < shape.k; i++) {
+        expected += static_cast<double>(inputValue(static_cast<size_t>(row) * shape.k + i, 1)) *
+                    inputValue(static_cast<size_t>(i) * shape.n + col, 2);
+      }
+      if (c[index] != expected) {
+        failed("%s %s GEMM: C[%d][%d] is %f, expected %f", gemmTypeStr[type],
+               gemmKernelStr[kernel], row, col, c[index], expected);
+      }
+    }
+  }
+
+  hipStream_t stream_;
+  void* a_;
+  void* b_;
+  float* c_;
+  unsigned int preparedShape_;  // numGemmShapes while nothing is allocated
+  unsigned int preparedType_;
+  double vectorTflops_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfGemm)
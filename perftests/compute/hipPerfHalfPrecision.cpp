@@ -0,0 +1,396 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost and benefit of 16 bit floating point types. The first group times
+// float -> half -> float and float -> bfloat16 -> float round trips, scalar
+// and packed two at a time, in conversions per cycle per CU (at the
+// clockRate of the device properties); a float add per round trip keeps the
+// chain from folding. The second group times dependent FMA chains in float,
+// half, half2, bfloat16 and bfloat162 in FMAs per cycle per CU (a packed FMA
+// counts as two) and their speedup over float. The last group scales a 64M
+// element tensor stored as float, half and bfloat16 with 16 byte loads and
+// stores and float arithmetic in between, reported in GB/s and as speedup
+// in elements per second over float storage. bfloat16 runs on AMD only.
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include <hip/hip_fp16.h>
+#ifdef __HIP_PLATFORM_AMD__
+#include <hip/hip_bf16.h>
+#endif
+
+#include "perf_harness.h"
+
+/*
+Every chain functor has the per thread state type V, the number of values 'lanes' one step
+processes, init() for the state of input i, a dependent step() and result() to fold the
+state into a float.
+*/
+struct HalfConvert {
+  typedef float V;
+  static const unsigned int lanes = 1;
+  __device__ static V init(unsigned int i) { return static_cast<float>(i % 1021) / 1024; }
+  __device__ static V step(V x) { return __half2float(__float2half(x)) + 0.5f; }
+  __device__ static float result(V x) { return x; }
+};
+
+struct Half2Convert {
+  typedef float2 V;
+  static const unsigned int lanes = 2;
+  __device__ static V init(unsigned int i) {
+    return make_float2(static_cast<float>(i % 1021) / 1024, static_cast<float>(i % 1013) / 1024);
+  }
+  __device__ static V step(V x) {
+    float2 r = __half22float2(__float22half2_rn(x));
+    return make_float2(r.x + 0.5f, r.y + 0.5f);
+  }
+  __device__ static float result(V x) { return x.x + x.y; }
+};
+
+struct FloatFma {
+  typedef float V;
+  static const unsigned int lanes = 1;
+  __device__ static V init(unsigned int i) { return static_cast<float>(i % 1021) / 1024; }
+  __device__ static V step(V x) { return fmaf(x, 0.999f, 0.001f); }
+  __device__ static float result(V x) { return x; }
+};
+
+struct HalfFma {
+  typedef __half V;
+  static const unsigned int lanes = 1;
+  __device__ static V init(unsigned int i) {
+    return __float2half(static_cast<float>(i % 1021) / 1024);
+  }
+  __device__ static V step(V x) { return __hfma(x, __float2half(0.999f), __float2half(0.001f)); }
+  __device__ static float result(V x) { return __half2float(x); }
+};
+
+struct Half2Fma {
+  typedef __half2 V;
+  static const unsigned int lanes = 2;
+  __device__ static V init(unsigned int i) {
+    return __floats2half2_rn(static_cast<float>(i % 1021) / 1024,
+                             static_cast<float>(i % 1013) / 1024);
+  }
+  __device__ static V step(V x) {
+    return __hfma2(x, __float2half2_rn(0.999f), __float2half2_rn(0.001f));
+  }
+  __device__ static float result(V x) {
+    float2 r = __half22float2(x);
+    return r.x + r.y;
+  }
+};
+
+#ifdef __HIP_PLATFORM_AMD__
+struct Bf16Convert {
+  typedef float V;
+  static const unsigned int lanes = 1;
+  __device__ static V init(unsigned int i) { return static_cast<float>(i % 1021) / 1024; }
+  __device__ static V step(V x) { return __bfloat162float(__float2bfloat16(x)) + 0.5f; }
+  __device__ static float result(V x) { return x; }
+};
+
+struct Bf162Convert {
+  typedef float2 V;
+  static const unsigned int lanes = 2;
+  __device__ static V init(unsigned int i) {
+    return make_float2(static_cast<float>(i % 1021) / 1024, static_cast<float>(i % 1013) / 1024);
+  }
+  __device__ static V step(V x) {
+    float2 r = __bfloat1622float2(__float22bfloat162_rn(x));
+    return make_float2(r.x + 0.5f, r.y + 0.5f);
+  }
+  __device__ static float result(V x) { return x.x + x.y; }
+};
+
+struct Bf16Fma {
+  typedef __hip_bfloat16 V;
+  static const unsigned int lanes = 1;
+  __device__ static V init(unsigned int i) {
+    return __float2bfloat16(static_cast<float>(i % 1021) / 1024);
+  }
+  __device__ static V step(V x) {
+    return __hfma(x, __float2bfloat16(0.999f), __float2bfloat16(0.001f));
+  }
+  __device__ static float result(V x) { return __bfloat162float(x); }
+};
+
+struct Bf162Fma {
+  typedef __hip_bfloat162 V;
+  static const unsigned int lanes = 2;
+  __device__ static V init(unsigned int i) {
+    return __float22bfloat162_rn(make_float2(static_cast<float>(i % 1021) / 1024,
+                                             static_cast<float>(i % 1013) / 1024));
+  }
+  __device__ static V step(V x) {
+    return __hfma2(x, __float22bfloat162_rn(make_float2(0.999f, 0.999f)),
+                   __float22bfloat162_rn(make_float2(0.001f, 0.001f)));
+  }
+  __device__ static float result(V x) {
+    float2 r = __bfloat1622float2(x);
+    return r.x + r.y;
+  }
+};
+#endif
+
+template <typename Op> __global__ void chainThroughput(unsigned int iterations, float* out) {
+  typedef typename Op::V V;
+  unsigned int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  V v0 = Op::init(tid * 4 + 0);
+  V v1 = Op::init(tid * 4 + 1);
+  V v2 = Op::init(tid * 4 + 2);
+  V v3 = Op::init(tid * 4 + 3);
+  for (unsigned int i = 0; i < iterations; i++) {
+    v0 = Op::step(v0);
+    v1 = Op::step(v1);
+    v2 = Op::step(v2);
+    v3 = Op::step(v3);
+  }
+  out[tid] = Op::result(v0) + Op::result(v1) + Op::result(v2) + Op::result(v3);
+}
+
+/*
+Storage types for the tensor scale, each moves one 16 byte vector of 'elems' values and
+scales it in float.
+*/
+struct FloatStorage {
+  typedef float4 Vec;
+  static const unsigned int elems = 4;
+  __device__ static Vec scale(Vec v, float a) {
+    return make_float4(v.x * a, v.y * a, v.z * a, v.w * a);
+  }
+};
+
+struct HalfVec {
+  __half2 h[4];
+};
+
+struct HalfStorage {
+  typedef HalfVec Vec;
+  static const unsigned int elems = 8;
+  __device__ static Vec scale(Vec v, float a) {
+    for (int i = 0; i < 4; i++) {
+      float2 f = __half22float2(v.h[i]);
+      v.h[i] = __float22half2_rn(make_float2(f.x * a, f.y * a));
+    }
+    return v;
+  }
+};
+
+#ifdef __HIP_PLATFORM_AMD__
+struct Bf16Vec {
+  __hip_bfloat162 h[4];
+};
+
+struct Bf16Storage {
+  typedef Bf16Vec Vec;
+  static const unsigned int elems = 8;
+  __device__ static Vec scale(Vec v, float a) {
+    for (int i = 0; i < 4; i++) {
+      float2 f = __bfloat1622float2(v.h[i]);
+      v.h[i] = __float22bfloat162_rn(make_float2(f.x * a, f.y * a));
+    }
+    return v;
+  }
+};
+#endif
+
+template <typename S>
+__global__ void tensorScale(const typename S::Vec* in, typename S::Vec* out, size_t count,
+                            float a) {
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < count;
+       i += stride) {
+    out[i] = S::scale(in[i], a);
+  }
+}
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const size_t tensorElems = 64 * 1024 * 1024;
+
+enum ChainGroup { groupConvert = 0, groupFma };
+
+typedef void (*ChainLaunch)(dim3 grid, unsigned int iterations, float* out);
+
+template <typename Op> static void launchChain(dim3 grid, unsigned int iterations, float* out) {
+  hipLaunchKernelGGL(chainThroughput<Op>, grid, dim3(blockSize), 0, 0, iterations, out);
+}
+
+struct ChainTest {
+  const char* name;
+  ChainGroup group;
+  unsigned int lanes;
+  ChainLaunch launch;
+};
+
+// The float FMA chain is the reference of the FMA group and runs first in it
+static const ChainTest chainTests[] = {
+    {"float <-> half round trip", groupConvert, HalfConvert::lanes, launchChain<HalfConvert>},
+    {"float2 <-> half2 round trip", groupConvert, Half2Convert::lanes, launchChain<Half2Convert>},
+#ifdef __HIP_PLATFORM_AMD__
+    {"float <-> bfloat16 round trip", groupConvert, Bf16Convert::lanes, launchChain<Bf16Convert>},
+    {"float2 <-> bfloat162 round trip", groupConvert, Bf162Convert::lanes,
+     launchChain<Bf162Convert>},
+#endif
+    {"fmaf float", groupFma, FloatFma::lanes, launchChain<FloatFma>},
+    {"__hfma half", groupFma, HalfFma::lanes, launchChain<HalfFma>},
+    {"__hfma2 half2", groupFma, Half2Fma::lanes, launchChain<Half2Fma>},
+#ifdef __HIP_PLATFORM_AMD__
+    {"__hfma bfloat16", groupFma, Bf16Fma::lanes, launchChain<Bf16Fma>},
+    {"__hfma2 bfloat162", groupFma, Bf162Fma::lanes, launchChain<Bf162Fma>},
+#endif
+};
+
+static const unsigned int numChainTests = sizeof(chainTests) / sizeof(chainTests[0]);
+
+typedef void (*ScaleLaunch)(dim3 grid, const void* in, void* out, size_t bytes);
+
+template <typename S> static void launchScale(dim3 grid, const void* in, void* out,
+                                              size_t bytes) {
+  typedef typename S::Vec Vec;
+  hipLaunchKernelGGL(tensorScale<S>, grid, dim3(blockSize), 0, 0, static_cast<const Vec*>(in),
+                     static_cast<Vec*>(out), bytes / sizeof(Vec), 0.5f);
+}
+
+struct StorageTest {
+  const char* name;
+  size_t elemBytes;
+  ScaleLaunch launch;
+};
+
+// float storage is the reference and runs first
+static const StorageTest storageTests[] = {
+    {"float", sizeof(float), launchScale<FloatStorage>},
+    {"half", sizeof(__half), launchScale<HalfStorage>},
+#ifdef __HIP_PLATFORM_AMD__
+    {"bfloat16", sizeof(__hip_bfloat16), launchScale<Bf16Storage>},
+#endif
+};
+
+static const unsigned int numStorageTests = sizeof(storageTests) / sizeof(storageTests[0]);
+
+class hipPerfHalfPrecision : public HipPerf::Benchmark {
+ public:
+  hipPerfHalfPrecision() : HipPerf::Benchmark("hipPerfHalfPrecision"),
+      iterations_(HipPerf::iterationCount(4096)), out_(nullptr), in_(nullptr), result_(nullptr),
+      floatFma_(0), floatStorage_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    HIPCHECK(hipMalloc(&out_, static_cast<size_t>(grid_.x) * blockSize * sizeof(float)));
+    HIPCHECK(hipMalloc(&in_, tensorElems * sizeof(float)));
+    HIPCHECK(hipMalloc(&result_, tensorElems * sizeof(float)));
+    HIPCHECK(hipMemset(in_, 0, tensorElems * sizeof(float)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipFree(in_));
+    HIPCHECK(hipFree(result_));
+  }
+
+  unsigned int numTests() override { return numChainTests + numStorageTests; }
+
+  void run(unsigned int test) override {
+    if (test < numChainTests) {
+      runChain(test, chainTests[test]);
+    } else {
+      runStorage(test, storageTests[test - numChainTests]);
+    }
+  }
+
+ private:
+  void runChain(unsigned int test, const ChainTest& chain) {
+    auto sec = measure([&]() {
+      chain.launch(grid_, iterations_, out_);
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    double ops = static_cast<double>(grid_.x) * blockSize * iterations_ * 4 * chain.lanes;
+    // clockRate is in kHz
+    double cyclesPerSec = props_.clockRate * 1e3 * props_.multiProcessorCount;
+    std::vector<double> opsPerCycle;
+    for (double s : sec) {
+      opsPerCycle.push_back(ops / s / cyclesPerSec);
+    }
+    bool convert = chain.group == groupConvert;
+    report(test, chain.name, 0, iterations_, convert ? "conversions/cycle/CU" : "FMA/cycle/CU",
+           opsPerCycle);
+    if (convert) {
+      return;
+    }
+    if (chain.launch == launchChain<FloatFma>) {
+      floatFma_ = ComputePerfStats(opsPerCycle).median;
+    } else if (floatFma_ > 0) {
+      std::vector<double> speedup;
+      for (double o : opsPerCycle) {
+        speedup.push_back(o / floatFma_);
+      }
+      report(test, std::string(chain.name) + " speedup over float", 0, iterations_, "x",
+             speedup);
+    }
+  }
+
+  void runStorage(unsigned int test, const StorageTest& storage) {
+    // Same element count for every type, in and out buffers are sized for float
+    size_t bytes = tensorElems * storage.elemBytes;
+    auto sec = measure([&]() {
+      storage.launch(grid_, in_, result_, bytes);
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    std::string desc = std::string("64M element scale stored as ") + storage.name;
+    report(test, desc, bytes, 1, "GB/s", HipPerf::toBandwidth(sec, 2.0 * bytes));
+    std::vector<double> elemsPerSec;
+    for (double s : sec) {
+      elemsPerSec.push_back(tensorElems / s);
+    }
+    if (storage.elemBytes == sizeof(float)) {
+      floatStorage_ = ComputePerfStats(elemsPerSec).median;
+    } else if (floatStorage_ > 0) {
+      std::vector<double> speedup;
+      for (double e : elemsPerSec) {
+        speedup.push_back(e / floatStorage_);
+      }
+      report(test, desc + " speedup over float", bytes, 1, "x", speedup);
+    }
+  }
+
+  unsigned int iterations_;  // per thread, four chains each
+  dim3 grid_;
+  float* out_;
+  void* in_;
+  void* result_;
+  double floatFma_;      // median FMA/cycle/CU of the float chain
+  double floatStorage_;  // median elements/s of the float tensor
+};
+
+HIP_PERF_BENCHMARK(hipPerfHalfPrecision)
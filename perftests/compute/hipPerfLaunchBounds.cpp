@@ -0,0 +1,179 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lhiprtc
+ * TEST: %t
+ * HIT_END
+ */
+
+// Register pressure against occupancy under __launch_bounds__. The same FMA
+// kernel, keeping a configurable number of values live per thread, is built
+// with hiprtc once per launch-bounds setting and pressure level. Every build
+// reports its register count and scratch (spill) size from
+// hipFuncGetAttribute, the active blocks per CU for 256 thread blocks from
+// hipModuleOccupancyMaxActiveBlocksPerMultiprocessor, and the runtime of one
+// launch. The HIP API exposes no SGPR count, HIP_FUNC_ATTRIBUTE_NUM_REGS is
+// the VGPR count on AMD.
+
+#include <stdio.h>
+
+#include <string>
+
+#include <hip/hiprtc.h>
+
+#include "perf_harness.h"
+
+static const char* kernelSource = R"(
+#if MAX_THREADS > 0
+#define BOUNDS __launch_bounds__(MAX_THREADS, MIN_BLOCKS)
+#else
+#define BOUNDS
+#endif
+
+extern "C" __global__ void BOUNDS pressure(float* out, const float* in, size_t n,
+                                           unsigned int loops) {
+  size_t i = blockIdx.x * (size_t)blockDim.x + threadIdx.x;
+  if (i >= n) return;
+  float v[LIVE];
+#pragma unroll
+  for (int k = 0; k < LIVE; k++) v[k] = in[(i + k) % n];
+  for (unsigned int l = 0; l < loops; l++) {
+#pragma unroll
+    for (int k = 0; k < LIVE; k++) v[k] = fmaf(v[k], v[(k + 1) % LIVE], 0.5f);
+  }
+  float sum = 0.0f;
+#pragma unroll
+  for (int k = 0; k < LIVE; k++) sum += v[k];
+  out[i] = sum;
+}
+)";
+
+struct LaunchBounds {
+  int maxThreads;  // 0 builds without __launch_bounds__
+  int minBlocks;
+};
+
+static const LaunchBounds boundsTable[] = {{0, 0},   {1024, 1}, {256, 1},
+                                           {256, 2}, {256, 4},  {256, 8}};
+static const unsigned int numBounds = sizeof(boundsTable) / sizeof(boundsTable[0]);
+
+// Values kept live per thread
+static const int pressureTable[] = {16, 64, 128};
+static const unsigned int numPressures = sizeof(pressureTable) / sizeof(pressureTable[0]);
+
+static const unsigned int blockSize = 256;
+static const size_t elements = 4 * 1024 * 1024;
+static const unsigned int loops = 32;
+
+class hipPerfLaunchBounds : public HipPerf::Benchmark {
+ public:
+  hipPerfLaunchBounds() : HipPerf::Benchmark("hipPerfLaunchBounds"),
+      launches_(HipPerf::iterationCount(10)), in_(nullptr), out_(nullptr), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&in_, elements * sizeof(float)));
+    HIPCHECK(hipMalloc(&out_, elements * sizeof(float)));
+    HIPCHECK(hipMemset(in_, 0, elements * sizeof(float)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(in_));
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numBounds * numPressures; }
+
+  void run(unsigned int test) override {
+    const LaunchBounds& bounds = boundsTable[test / numPressures];
+    int live = pressureTable[test % numPressures];
+
+    hipModule_t module = buildModule(bounds, live);
+    hipFunction_t function;
+    HIPCHECK(hipModuleGetFunction(&function, module, "pressure"));
+
+    int regs = 0;
+    int scratch = 0;
+    HIPCHECK(hipFuncGetAttribute(&regs, HIP_FUNC_ATTRIBUTE_NUM_REGS, function));
+    HIPCHECK(hipFuncGetAttribute(&scratch, HIP_FUNC_ATTRIBUTE_LOCAL_SIZE_BYTES, function));
+    int active = 0;
+    HIPCHECK(hipModuleOccupancyMaxActiveBlocksPerMultiprocessor(&active, function, blockSize, 0));
+    double occupancy = 100.0 * active * blockSize / props_.maxThreadsPerMultiProcessor;
+
+    float* out = out_;
+    const float* in = in_;
+    size_t n = elements;
+    unsigned int l = loops;
+    void* params[] = {&out, &in, &n, &l};
+    unsigned int grid = (elements + blockSize - 1) / blockSize;
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < launches_; i++) {
+        HIPCHECK(hipModuleLaunchKernel(function, grid, 1, 1, blockSize, 1, 1, 0, stream_, params,
+                                       nullptr));
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    HIPCHECK(hipModuleUnload(module));
+
+    char desc[128];
+    if (bounds.maxThreads > 0) {
+      snprintf(desc, sizeof(desc), "live %3d bounds(%4d, %d)", live, bounds.maxThreads,
+               bounds.minBlocks);
+    } else {
+      snprintf(desc, sizeof(desc), "live %3d no bounds      ", live);
+    }
+    std::string prefix = desc;
+    snprintf(desc, sizeof(desc), " %3d regs %5d B scratch %2d blocks/CU %5.1f%% occupancy", regs,
+             scratch, active, occupancy);
+    report(test, prefix + desc, 0, launches_, "us", HipPerf::toMicroseconds(sec, launches_));
+    report(test, prefix + " registers", 0, 1, "regs", {static_cast<double>(regs)});
+    report(test, prefix + " scratch", 0, 1, "B", {static_cast<double>(scratch)});
+    report(test, prefix + " occupancy", 0, 1, "%", {occupancy});
+  }
+
+ private:
+  hipModule_t buildModule(const LaunchBounds& bounds, int live) {
+    std::string maxThreads = "-DMAX_THREADS=" + std::to_string(bounds.maxThreads);
+    std::string minBlocks = "-DMIN_BLOCKS=" + std::to_string(bounds.minBlocks);
+    std::string liveValues = "-DLIVE=" + std::to_string(live);
+    const char* options[] = {maxThreads.c_str(), minBlocks.c_str(), liveValues.c_str(), "-O3"};
+
+    hiprtcProgram prog;
+    HIPRTCCHECK(hiprtcCreateProgram(&prog, kernelSource, "pressure.cu", 0, nullptr, nullptr));
+    HipTest::compileRtcProgram(prog, 4, options);
+    size_t codeSize = 0;
+    HIPRTCCHECK(hiprtcGetCodeSize(prog, &codeSize));
+    std::vector<char> code(codeSize);
+    HIPRTCCHECK(hiprtcGetCode(prog, code.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+    hipModule_t module;
+    HIPCHECK(hipModuleLoadData(&module, code.data()));
+    return module;
+  }
+
+  unsigned int launches_;
+  float* in_;
+  float* out_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfLaunchBounds)
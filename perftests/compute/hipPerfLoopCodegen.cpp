@@ -0,0 +1,257 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Microbenchmarks for loop and arithmetic code generation, meant to be
+// compared across compiler releases. The unroll set runs two loops with a
+// runtime trip count at #pragma unroll factors 1 to 16 given as a template
+// parameter: four independent FMA chains per thread (reported in GFLOP/s and
+// FMAs per cycle per CU at the clockRate of the device properties) and a row
+// sum over an unsigned int matrix stored column by column so that neighbouring
+// threads read neighbouring words (reported in GB/s). The inline asm set
+// compares 1 and 4 FMA chains written as fmaf() with the same chains as
+// hand-written v_fma_f32 (AMD) or fma.rn.f32 (NVIDIA) instructions; a gap
+// between the two points at code the compiler wraps around the FMAs.
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int unrollFactors[] = {1, 2, 4, 8, 16};
+static const unsigned int numUnrollFactors = sizeof(unrollFactors) / sizeof(unrollFactors[0]);
+
+enum UnrollLoop { loopFma = 0, loopRowSum, numUnrollLoops };
+static const char* unrollLoopStr[numUnrollLoops] = {"4 chain fma loop", "row sum loop"};
+
+enum FmaCode { codeCompiler = 0, codeInlineAsm, numFmaCodes };
+static const char* fmaCodeStr[numFmaCodes] = {"fmaf()", "inline asm"};
+
+static const unsigned int asmChains[] = {1, 4};
+static const unsigned int numAsmChains = sizeof(asmChains) / sizeof(asmChains[0]);
+
+static const unsigned int fmaIterations = 4096;
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const unsigned int rowSumRows = 256 * 1024;
+static const unsigned int rowSumCols = 256;
+
+template <unsigned int U>
+__global__ void unrolledFma(float* out, unsigned int iterations, float a, float b) {
+  float x0 = threadIdx.x, x1 = x0 + 1.0f, x2 = x0 + 2.0f, x3 = x0 + 3.0f;
+#pragma unroll U
+  for (unsigned int i = 0; i < iterations; i++) {
+    x0 = fmaf(x0, a, b);
+    x1 = fmaf(x1, a, b);
+    x2 = fmaf(x2, a, b);
+    x3 = fmaf(x3, a, b);
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = x0 + x1 + x2 + x3;
+}
+
+// Element (row, col) is at col * rows + row
+template <unsigned int U>
+__global__ void unrolledRowSum(const unsigned int* in, unsigned int* out, unsigned int rows, unsigned int cols) {
+  unsigned int row = blockIdx.x * blockDim.x + threadIdx.x;
+  if (row >= rows) return;
+  unsigned int sum = 0;
+#pragma unroll U
+  for (unsigned int i = 0; i < cols; i++) {
+    sum += in[static_cast<size_t>(i) * rows + row];
+  }
+  out[row] = sum;
+}
+
+__device__ inline void fmaStep(float& x, float a, float b, FmaCode code) {
+  if (code == codeCompiler) {
+    x = fmaf(x, a, b);
+  } else {
+#if defined(__HIP_PLATFORM_AMD__)
+    asm("v_fma_f32 %0, %0, %1, %2" : "+v"(x) : "v"(a), "v"(b));
+#else
+    asm("fma.rn.f32 %0, %0, %1, %2;" : "+f"(x) : "f"(a), "f"(b));
+#endif
+  }
+}
+
+template <FmaCode Code, unsigned int Chains>
+__global__ void fmaChains(float* out, unsigned int iterations, float a, float b) {
+  float x[Chains];
+  for (unsigned int c = 0; c < Chains; c++) {
+    x[c] = threadIdx.x + c;
+  }
+  for (unsigned int i = 0; i < iterations; i++) {
+#pragma unroll
+    for (unsigned int c = 0; c < Chains; c++) {
+      fmaStep(x[c], a, b, Code);
+    }
+  }
+  float sum = 0;
+  for (unsigned int c = 0; c < Chains; c++) {
+    sum += x[c];
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = sum;
+}
+
+class hipPerfLoopCodegen : public HipPerf::Benchmark {
+ public:
+  hipPerfLoopCodegen() : HipPerf::Benchmark("hipPerfLoopCodegen"),
+      iterations_(HipPerf::iterationCount(fmaIterations)), out_(nullptr), matrix_(nullptr),
+      sums_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    HIPCHECK(hipMalloc(&out_, static_cast<size_t>(grid_.x) * blockSize * sizeof(float)));
+    HIPCHECK(hipMalloc(&matrix_, static_cast<size_t>(rowSumRows) * rowSumCols * sizeof(unsigned int)));
+    HIPCHECK(hipMemset(matrix_, 1, static_cast<size_t>(rowSumRows) * rowSumCols * sizeof(unsigned int)));
+    HIPCHECK(hipMalloc(&sums_, rowSumRows * sizeof(unsigned int)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipFree(matrix_));
+    HIPCHECK(hipFree(sums_));
+  }
+
+  unsigned int numTests() override {
+    return numUnrollFactors * numUnrollLoops + numAsmChains * numFmaCodes;
+  }
+
+  void run(unsigned int test) override {
+    if (test < numUnrollFactors * numUnrollLoops) {
+      runUnroll(test, static_cast<UnrollLoop>(test % numUnrollLoops),
+                unrollFactors[test / numUnrollLoops]);
+    } else {
+      unsigned int index = test - numUnrollFactors * numUnrollLoops;
+      runAsm(test, static_cast<FmaCode>(index % numFmaCodes), asmChains[index / numFmaCodes]);
+    }
+  }
+
+ private:
+  template <unsigned int U> void launchUnrolled(UnrollLoop loop) {
+    if (loop == loopFma) {
+      hipLaunchKernelGGL(unrolledFma<U>, grid_, dim3(blockSize), 0, 0, out_, iterations_,
+                         0.999f, 0.5f);
+    } else {
+      hipLaunchKernelGGL(unrolledRowSum<U>, dim3(rowSumRows / blockSize), dim3(blockSize), 0, 0,
+                         matrix_, sums_, rowSumRows, rowSumCols);
+    }
+  }
+
+  void launchUnrolled(UnrollLoop loop, unsigned int factor) {
+    switch (factor) {
+      case 1: launchUnrolled<1>(loop); break;
+      case 2: launchUnrolled<2>(loop); break;
+      case 4: launchUnrolled<4>(loop); break;
+      case 8: launchUnrolled<8>(loop); break;
+      default: launchUnrolled<16>(loop); break;
+    }
+  }
+
+  void runUnroll(unsigned int test, UnrollLoop loop, unsigned int factor) {
+    auto sec = measure([&]() {
+      launchUnrolled(loop, factor);
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%s unroll %2u", unrollLoopStr[loop], factor);
+    if (loop == loopFma) {
+      reportFma(test, desc, sec, 4);
+    } else {
+      checkRowSums();
+      double bytes = static_cast<double>(rowSumRows) * rowSumCols * sizeof(unsigned int);
+      report(test, desc, bytes, 1, "GB/s", HipPerf::toBandwidth(sec, bytes));
+    }
+  }
+
+  void runAsm(unsigned int test, FmaCode code, unsigned int chains) {
+    auto sec = measure([&]() {
+      if (code == codeCompiler) {
+        if (chains == 1) {
+          hipLaunchKernelGGL((fmaChains<codeCompiler, 1>), grid_, dim3(blockSize), 0, 0, out_,
+                             iterations_, 0.999f, 0.5f);
+        } else {
+          hipLaunchKernelGGL((fmaChains<codeCompiler, 4>), grid_, dim3(blockSize), 0, 0, out_,
+                             iterations_, 0.999f, 0.5f);
+        }
+      } else {
+        if (chains == 1) {
+          hipLaunchKernelGGL((fmaChains<codeInlineAsm, 1>), grid_, dim3(blockSize), 0, 0, out_,
+                             iterations_, 0.999f, 0.5f);
+        } else {
+          hipLaunchKernelGGL((fmaChains<codeInlineAsm, 4>), grid_, dim3(blockSize), 0, 0, out_,
+                             iterations_, 0.999f, 0.5f);
+        }
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%u chain fma %s", chains, fmaCodeStr[code]);
+    reportFma(test, desc, sec, chains);
+  }
+
+  void reportFma(unsigned int test, const std::string& desc, const std::vector<double>& sec,
+                 unsigned int chains) {
+    double fmas = static_cast<double>(grid_.x) * blockSize * iterations_ * chains;
+    std::vector<double> gflops, perCycle;
+    // clockRate is in kHz
+    double cyclesPerSec = props_.clockRate * 1e3 * props_.multiProcessorCount;
+    for (double s : sec) {
+      gflops.push_back(2.0 * fmas / s * 1e-9);
+      perCycle.push_back(fmas / s / cyclesPerSec);
+    }
+    report(test, desc, 0, iterations_, "GFLOP/s", gflops);
+    if (cyclesPerSec > 0) {
+      report(test, desc + " per CU", 0, iterations_, "FMA/clk", perCycle);
+    }
+  }
+
+  // Every element of the matrix is 0x01010101, the sums wrap around
+  void checkRowSums() {
+    std::vector<unsigned int> sums(rowSumRows);
+    HIPCHECK(hipMemcpy(sums.data(), sums_, rowSumRows * sizeof(unsigned int),
+                       hipMemcpyDeviceToHost));
+    unsigned int expected = 0x01010101u * rowSumCols;
+    for (unsigned int r = 0; r < rowSumRows; r++) {
+      if (sums[r] != expected) {
+        failed("Row %u sums to %u, expected %u", r, sums[r], expected);
+      }
+    }
+  }
+
+  unsigned int iterations_;
+  dim3 grid_;
+  float* out_;
+  unsigned int* matrix_;
+  unsigned int* sums_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfLoopCodegen)
@@ -18,16 +18,18 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
  * TEST: %t
  * HIT_END
  */
 
 #include <iostream>
 #include <chrono>
-#include "test_common.h"
+#include "perf_harness.h"
+#include "mandelbrot_kernels.h"
 #include <hip/hip_vector_types.h>
 #include <hip/math_functions.h>
+#include <hip/hip_fp16.h>
 #include <vector>
 #include <string>
 #include <map>
@@ -46,32 +48,8 @@ coordRec coords[] = {
 
 static unsigned int numCoords = sizeof(coords) / sizeof(coordRec);
 
-template <typename T>
-__global__ void float_mad_kernel(uint *out, uint width, T xPos,  T yPos, T xStep, T yStep,
-                                  uint maxIter) {
-
-#pragma FP_CONTRACT ON
-  int tid = (blockIdx.x * blockDim.x + threadIdx.x);
-  int i = tid % width;
-  int j = tid / width;
-  float x0 = (float)(xPos + xStep*i);
-  float y0 = (float)(yPos + yStep*j);
-
-  float x = x0;
-  float y = y0;
-
-  uint iter = 0;
-  float tmp;
-  for (iter = 0; (x*x + y*y <= 4.0f) && (iter < maxIter); iter++) {
-    tmp = x;
-    x = fma(-y,y,fma(x,x,x0));
-    y = fma(2.0f*tmp,y,y0);
-  }
-
-  out[tid] = iter;
-};
-
-template <typename T>
+// UNROLL iterations, an even number, between two escape tests
+template <typename T, unsigned int UNROLL = 16>
 __global__ void float_mandel_unroll_kernel(uint *out, uint width, T xPos,
     T yPos, T xStep, T yStep, uint maxIter) {
 
@@ -94,65 +72,26 @@ __global__ void float_mandel_unroll_kernel(uint *out, uint width, T xPos,
   float savx = x;
   float savy = y;
 #ifdef FAST
-  for (iter = 0; (iter < maxIter); iter+=16) {
+  for (iter = 0; (iter < maxIter); iter+=UNROLL) {
 #else
-  for (iter = 0; stay && (iter < maxIter); iter+=16) {
+  for (iter = 0; stay && (iter < maxIter); iter+=UNROLL) {
 #endif
     x = savx;
     y = savy;
 
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =  fma(2.0f*x,y,y0);
-    x =  fma(-y,y, fma(tmp,tmp,x0));
-    y =  fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =  fma(2.0f*x,y,y0);
-    x =  fma(-y,y, fma(tmp,tmp,x0));
-    y =  fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =  fma(2.0f*x,y,y0);
-    x =  fma(-y,y, fma(tmp,tmp,x0));
-    y =  fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =  fma(2.0f*x,y,y0);
-    x =  fma(-y,y, fma(tmp,tmp,x0));
-    y =  fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =  fma(2.0f*x,y,y0);
-    x =  fma(-y,y, fma(tmp,tmp,x0));
-    y =  fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =  fma(2.0f*x,y,y0);
-    x =  fma(-y,y, fma(tmp,tmp,x0));
-    y =  fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =  fma(2.0f*x,y,y0);
-    x =  fma(-y,y, fma(tmp,tmp,x0));
-    y =  fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =  fma(2.0f*x,y,y0);
-    x =  fma(-y,y, fma(tmp,tmp,x0));
-    y =  fma(2.0f*tmp,y,y0);
+#pragma unroll
+    for (unsigned int u = 0; u < UNROLL / 2; u++) {
+      // Two iterations
+      tmp = fma(-y,y, fma(x,x,x0));
+      y = fma(2.0f*x,y,y0);
+      x = fma(-y,y, fma(tmp,tmp,x0));
+      y = fma(2.0f*tmp,y,y0);
+    }
 
     stay = (x*x+y*y) <= 4.0;
     savx = (stay ? x : savx);
     savy = (stay ? y : savy);
-    ccount += stay*16;
+    ccount += stay*UNROLL;
 #ifdef FAST
     if (!stay)
       break;
@@ -160,7 +99,7 @@ __global__ void float_mandel_unroll_kernel(uint *out, uint width, T xPos,
   }
   // Handle remainder
   if (!stay) {
-    iter = 16;
+    iter = UNROLL;
     do {
       x = savx;
       y = savy;
@@ -206,7 +145,8 @@ __global__ void double_mad_kernel(uint *out, uint width, T xPos,  T yPos, T xSte
 };
 
 
-template <typename T>
+// UNROLL iterations, an even number, between two escape tests
+template <typename T, unsigned int UNROLL = 16>
 __global__ void double_mandel_unroll_kernel(uint *out, uint width, T xPos,
                   T yPos, T xStep, T yStep, uint maxIter) {
 
@@ -230,66 +170,27 @@ __global__ void double_mandel_unroll_kernel(uint *out, uint width, T xPos,
   double savx = x;
   double savy = y;
 #ifdef FAST
-  for (iter = 0; (iter < maxIter); iter+=16)
+  for (iter = 0; (iter < maxIter); iter+=UNROLL)
 #else
-  for (iter = 0; stay && (iter < maxIter); iter+=16)
+  for (iter = 0; stay && (iter < maxIter); iter+=UNROLL)
 #endif
   {
     x = savx;
     y = savy;
 
-    // Two iterations
-    tmp = fma(-y,y, fma(x,x,x0));
-    y =   fma(2.0f*x,y,y0);
-    x =   fma(-y,y, fma(tmp,tmp,x0));
-    y =   fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp = fma(-y,y, fma(x,x,x0));
-    y =   fma(2.0f*x,y,y0);
-    x =   fma(-y,y, fma(tmp,tmp,x0));
-    y =   fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp = fma(-y,y, fma(x,x,x0));
-    y =   fma(2.0f*x,y,y0);
-    x =   fma(-y,y, fma(tmp,tmp,x0));
-    y =   fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =    fma(2.0f*x,y,y0);
-    x =    fma(-y,y, fma(tmp,tmp,x0));
-    y =    fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =    fma(2.0f*x,y,y0);
-    x =    fma(-y,y, fma(tmp,tmp,x0));
-    y =    fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =    fma(2.0f*x,y,y0);
-    x =    fma(-y,y, fma(tmp,tmp,x0));
-    y =    fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =    fma(2.0f*x,y,y0);
-    x =    fma(-y,y, fma(tmp,tmp,x0));
-    y =    fma(2.0f*tmp,y,y0);
-
-    // Two iterations
-    tmp =  fma(-y,y, fma(x,x,x0));
-    y =    fma(2.0f*x,y,y0);
-    x =    fma(-y,y, fma(tmp,tmp,x0));
-    y =    fma(2.0f*tmp,y,y0);
+#pragma unroll
+    for (unsigned int u = 0; u < UNROLL / 2; u++) {
+      // Two iterations
+      tmp = fma(-y,y, fma(x,x,x0));
+      y = fma(2.0f*x,y,y0);
+      x = fma(-y,y, fma(tmp,tmp,x0));
+      y = fma(2.0f*tmp,y,y0);
+    }
 
     stay = (x*x+y*y) <= 4.0;
     savx = (stay ? x : savx);
     savy = (stay ? y : savy);
-    ccount += stay*16;
+    ccount += stay*UNROLL;
 #ifdef FAST
     if (!stay)
       break;
@@ -297,7 +198,7 @@ __global__ void double_mandel_unroll_kernel(uint *out, uint width, T xPos,
     }
   // Handle remainder
     if (!stay) {
-      iter = 16;
+      iter = UNROLL;
       do {
         x = savx;
         y = savy;
@@ -316,6 +217,78 @@ __global__ void double_mandel_unroll_kernel(uint *out, uint width, T xPos,
     out[tid] = (uint)ccount;
 };
 
+// Peak rate kernels: 8 independent FMA chains per thread keep the ALUs busy
+// without memory traffic, 16 FLOPs per thread per loop iteration.
+template <typename T>
+__global__ void fma_only_kernel(T *out, T a, T b, uint loops) {
+  uint tid = blockIdx.x * blockDim.x + threadIdx.x;
+  T v0 = (T)tid, v1 = v0 + (T)1, v2 = v0 + (T)2, v3 = v0 + (T)3;
+  T v4 = v0 + (T)4, v5 = v0 + (T)5, v6 = v0 + (T)6, v7 = v0 + (T)7;
+  for (uint k = 0; k < loops; k++) {
+    v0 = fma(v0, a, b);
+    v1 = fma(v1, a, b);
+    v2 = fma(v2, a, b);
+    v3 = fma(v3, a, b);
+    v4 = fma(v4, a, b);
+    v5 = fma(v5, a, b);
+    v6 = fma(v6, a, b);
+    v7 = fma(v7, a, b);
+  }
+  out[tid] = v0 + v1 + v2 + v3 + v4 + v5 + v6 + v7;
+};
+
+// Packed FP16 version, every __hfma2 is 4 FLOPs: 32 FLOPs per thread per loop iteration
+__global__ void half2_fma_only_kernel(__half2 *out, __half2 a, __half2 b, uint loops) {
+  uint tid = blockIdx.x * blockDim.x + threadIdx.x;
+  __half2 v0 = __float2half2_rn((float)(tid & 7) * 0.125f);
+  __half2 v1 = __hadd2(v0, b), v2 = __hadd2(v1, b), v3 = __hadd2(v2, b);
+  __half2 v4 = __hadd2(v3, b), v5 = __hadd2(v4, b), v6 = __hadd2(v5, b);
+  __half2 v7 = __hadd2(v6, b);
+  for (uint k = 0; k < loops; k++) {
+    v0 = __hfma2(v0, a, b);
+    v1 = __hfma2(v1, a, b);
+    v2 = __hfma2(v2, a, b);
+    v3 = __hfma2(v3, a, b);
+    v4 = __hfma2(v4, a, b);
+    v5 = __hfma2(v5, a, b);
+    v6 = __hfma2(v6, a, b);
+    v7 = __hfma2(v7, a, b);
+  }
+  out[tid] = __hadd2(__hadd2(__hadd2(v0, v1), __hadd2(v2, v3)),
+                     __hadd2(__hadd2(v4, v5), __hadd2(v6, v7)));
+};
+
+// Mandelbrot on packed FP16, each thread iterates two neighbouring pixels.
+// FP16 cannot resolve the zoomed coordinates, iteration counts are not checked.
+__global__ void half2_mandel_kernel(uint *out, uint width, float xPos, float yPos,
+                                    float xStep, float yStep, uint maxIter) {
+  int tid = (blockIdx.x * blockDim.x + threadIdx.x);
+  int i = (2 * tid) % width;
+  int j = (2 * tid) / width;
+  __half2 x0 = __floats2half2_rn(xPos + xStep*i, xPos + xStep*(i + 1));
+  __half2 y0 = __float2half2_rn(yPos + yStep*j);
+  __half2 two = __float2half2_rn(2.0f);
+
+  __half2 x = x0;
+  __half2 y = y0;
+  __half2 tmp;
+  uint lo = 0, hi = 0;
+  bool stayLo = true, stayHi = true;
+  for (uint iter = 0; (stayLo || stayHi) && (iter < maxIter); iter++) {
+    tmp = x;
+    x = __hfma2(__hneg2(y), y, __hfma2(x, x, x0));
+    y = __hfma2(__hmul2(two, tmp), y, y0);
+    __half2 r = __hfma2(x, x, __hmul2(y, y));
+    lo += stayLo;
+    hi += stayHi;
+    stayLo = stayLo && (__low2float(r) <= 4.0f);
+    stayHi = stayHi && (__high2float(r) <= 4.0f);
+  }
+
+  out[2 * tid] = lo;
+  out[2 * tid + 1] = hi;
+};
+
 static const unsigned int FMA_EXPECTEDVALUES_INDEX = 15;
 
 // Expected results for each kernel run at each coord
@@ -350,6 +323,8 @@ class hipPerfMandelBrot {
   void open(int deviceID);
   void run(unsigned int testCase, unsigned int deviceId);
   void printResults(void);
+  // FMA-only, packed FP16 and unroll variants reported against the theoretical peak
+  void runPeak(void);
 
   // array of funtion pointers
   typedef void (hipPerfMandelBrot::*funPtr)(uint *out, uint width, float xPos,  float yPos,
@@ -389,6 +364,7 @@ class hipPerfMandelBrot {
   unsigned int coordIdx;
   volatile unsigned long long totalIters = 0;
   int numCUs;
+  int clockRateKHz;
   static const unsigned int numLoops = 10;
 };
 
@@ -415,6 +391,7 @@ void hipPerfMandelBrot::open(int deviceId) {
     << std::endl;
 
   numCUs = props.multiProcessorCount;
+  clockRateKHz = props.clockRate;
 }
 
 
@@ -423,19 +400,18 @@ void hipPerfMandelBrot::printResults() {
   int numkernels = getNumKernels();
   int numStreams = getNumStreams();
 
-  std::cout << "\n" <<"Measured perf for kernels in GFLOPS on "
-            << numStreams << " streams (s)" <<  std::endl;
-
+  // One result per kernel and coordinate set, in the order the tests ran
   std::map<std::string, std::vector<double>>:: iterator itr;
   for (itr = results.begin(); itr != results.end(); itr++) {
-          std::cout << "\n" << std::setw(20) << itr->first << " ";
-          for(auto i : results[itr->first]) {
-            std::cout << std::setw(10) << i << " ";
-            }
-     }
+    unsigned int coord = 0;
+    for (auto perf : itr->second) {
+      HipPerf::writeResult("hipPerfMandelbrot", coord, itr->first + " on " +
+                           std::to_string(numStreams) + " streams, coordinates " +
+                           std::to_string(coord), 0, numkernels, "GFLOPS", perf);
+      coord++;
+    }
+  }
   results.clear();
-
-  std::cout << std::endl;
 }
 
 
@@ -659,6 +635,125 @@ void hipPerfMandelBrot::run(unsigned int testCase,unsigned int deviceId) {
 }
 
 
+// Times numLoops launches after one warmup launch and returns the average seconds per launch
+template <typename Launch>
+static double timeLaunches(Launch launch, unsigned int loops) {
+  launch();
+  HIPCHECK(hipDeviceSynchronize());
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int k = 0; k < loops; k++) {
+    launch();
+  }
+  HIPCHECK(hipDeviceSynchronize());
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / loops;
+}
+
+
+void hipPerfMandelBrot::runPeak() {
+  // Theoretical peak assumes one FMA (2 FLOPs) per lane per clock on 64 lanes per CU, twice
+  // that for packed FP16. Architectures that dual issue or pack FP32 can exceed 100%, FP64
+  // is reported against the same FP32 rate so its ratio to FP32 shows directly.
+  double peakGflops = (double)numCUs * clockRateKHz * 1e-6 * 128;
+  if (peakGflops <= 0) {
+    std::cout << "info: device reports no clock rate, skipping peak comparison" << std::endl;
+    return;
+  }
+
+  const int threadsPerBlock = 256;
+  const int blocks = numCUs * 16;
+  const uint threads = blocks * threadsPerBlock;
+  const uint loops = 8192;
+  void *dOut = nullptr;
+  HIPCHECK(hipMalloc(&dOut, threads * sizeof(double)));
+
+  struct PeakResult {
+    std::string name;
+    double gflops;
+    double peak;
+  };
+  std::vector<PeakResult> peaks;
+
+  double secs = timeLaunches([&]() {
+    hipLaunchKernelGGL(fma_only_kernel<float>, dim3(blocks), dim3(threadsPerBlock), 0, 0,
+                       (float *)dOut, 0.999f, 0.001f, loops);
+  }, numLoops);
+  peaks.push_back({"fma_only float", (double)threads * loops * 16 * 1e-9 / secs, peakGflops});
+
+  secs = timeLaunches([&]() {
+    hipLaunchKernelGGL(fma_only_kernel<double>, dim3(blocks), dim3(threadsPerBlock), 0, 0,
+                       (double *)dOut, 0.999, 0.001, loops);
+  }, numLoops);
+  peaks.push_back({"fma_only double", (double)threads * loops * 16 * 1e-9 / secs, peakGflops});
+
+  secs = timeLaunches([&]() {
+    hipLaunchKernelGGL(half2_fma_only_kernel, dim3(blocks), dim3(threadsPerBlock), 0, 0,
+                       (__half2 *)dOut, __float2half2_rn(0.999f), __float2half2_rn(0.001f),
+                       loops);
+  }, numLoops);
+  peaks.push_back({"fma_only half2", (double)threads * loops * 32 * 1e-9 / secs,
+                   peakGflops * 2});
+
+  // Mandelbrot variants over all coordinates, 7 FLOPs per iteration as in run()
+  width_ = 256;
+  maxIter = 32768;
+  bufSize = width_ * width_ * sizeof(uint);
+  uint *hPtr = nullptr;
+  uint *dPtr = nullptr;
+  HIPCHECK(hipHostMalloc((void **)&hPtr, bufSize, hipHostMallocDefault));
+  HIPCHECK(hipMalloc((void **)&dPtr, bufSize));
+
+  typedef void (*mandelKernel)(uint *, uint, float, float, float, float, uint);
+  struct MandelVariant {
+    const char *name;
+    mandelKernel kernel;
+    unsigned int pixelsPerThread;
+    double peak;
+  };
+  MandelVariant variants[] = {
+      {"mandel half2", half2_mandel_kernel, 2, peakGflops * 2},
+      {"mandel float_unroll 4", float_mandel_unroll_kernel<float, 4>, 1, peakGflops},
+      {"mandel float_unroll 8", float_mandel_unroll_kernel<float, 8>, 1, peakGflops},
+      {"mandel float_unroll 16", float_mandel_unroll_kernel<float, 16>, 1, peakGflops},
+      {"mandel float_unroll 32", float_mandel_unroll_kernel<float, 32>, 1, peakGflops}};
+
+  for (const auto &variant : variants) {
+    int mandelThreads = width_ * width_ / variant.pixelsPerThread;
+    int mandelBlocks = (mandelThreads + 63) / 64;
+    double iters = 0;
+    double totalTime = 0;
+    for (unsigned int c = 0; c < numCoords; c++) {
+      float xStep = (float)(coords[c].width / (double)width_);
+      float yStep = (float)(-coords[c].width / (double)width_);
+      float xPos = (float)(coords[c].x - 0.5 * coords[c].width);
+      float yPos = (float)(coords[c].y + 0.5 * coords[c].width);
+      totalTime += timeLaunches([&]() {
+        hipLaunchKernelGGL(variant.kernel, dim3(mandelBlocks), dim3(64), 0, 0, dPtr, width_,
+                           xPos, yPos, xStep, yStep, maxIter);
+      }, numLoops);
+      HIPCHECK(hipMemcpy(hPtr, dPtr, bufSize, hipMemcpyDeviceToHost));
+      checkData(hPtr);
+      iters += (double)totalIters;
+    }
+    peaks.push_back({variant.name, iters * 7 * 1e-9 / totalTime, variant.peak});
+  }
+
+  unsigned int test = 0;
+  for (const auto &result : peaks) {
+    HipPerf::writeResult("hipPerfMandelbrotPeak", test, result.name, 0, numLoops, "GFLOPS",
+                         result.gflops);
+    HipPerf::writeResult("hipPerfMandelbrotPeak", test, result.name + " of " +
+                         std::to_string((int)result.peak) + " GFLOPS peak", 0, numLoops,
+                         "% of peak", 100.0 * result.gflops / result.peak);
+    test++;
+  }
+
+  HIPCHECK(hipHostFree(hPtr));
+  HIPCHECK(hipFree(dPtr));
+  HIPCHECK(hipFree(dOut));
+}
+
+
 void hipPerfMandelBrot::setData(void *ptr, unsigned int value) {
   unsigned int *ptr2 = (unsigned int *)ptr;
   for (unsigned int i = 0; i < width_ * width_; i++) {
@@ -676,12 +771,13 @@ void hipPerfMandelBrot::checkData(uint *ptr) {
 
 
 int main(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
   hipPerfMandelBrot mandelbrotCompute;
-  int deviceId = 0;
+  int deviceId = p_gpuDevice;
 
   mandelbrotCompute.open(deviceId);
 
-  for (unsigned int testCase = 0; testCase < 3; testCase++) {
+  for (unsigned int testCase = 0; testCase < 4; testCase++) {
 
 
   switch (testCase) {
@@ -727,6 +823,13 @@ int main(int argc, char* argv[]) {
   }
 
 
+  case 3: {
+    // FMA-only, packed FP16 and unroll variants against the theoretical peak
+    mandelbrotCompute.runPeak();
+    break;
+  }
+
+
   default: {
     break;
   }
@@ -0,0 +1,270 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Throughput of the device math intrinsics against their precise
+// counterparts, each with its maximum error against a long double host
+// reference. Per pair it reports operations per cycle per CU (at the
+// clockRate of the device properties) for both functions, their max ULP
+// error over 1M inputs spread across the function's range, and the speedup
+// of the intrinsic. Every thread evaluates four independent inputs per
+// iteration, so the result is issue throughput rather than latency; the
+// input increment and the accumulation add the same two FP adds per
+// operation to both sides.
+
+#include <math.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+#include "perf_harness.h"
+
+/*
+MATH_PAIR(Name, T, precise, fast, reference, lo, hi) declares functor Name with the
+precise and fast device function of x, the host reference in long double and the input
+range [lo, hi].
+*/
+#define MATH_PAIR(NAME, TYPE, PRECISE, FAST, REFERENCE, LO, HI)                                   \
+  struct NAME {                                                                                   \
+    typedef TYPE T;                                                                               \
+    __device__ static T precise(T x) { return PRECISE; }                                          \
+    __device__ static T fast(T x) { return FAST; }                                                \
+    static long double reference(long double x) { return REFERENCE; }                             \
+    static constexpr T lo = LO;                                                                   \
+    static constexpr T hi = HI;                                                                   \
+  };
+
+MATH_PAIR(MathExp, float, expf(x), __expf(x), expl(x), -10.0f, 10.0f)
+MATH_PAIR(MathExp10, float, exp10f(x), __exp10f(x), powl(10.0L, x), -5.0f, 5.0f)
+MATH_PAIR(MathLog, float, logf(x), __logf(x), logl(x), 1e-3f, 1e3f)
+MATH_PAIR(MathLog2, float, log2f(x), __log2f(x), log2l(x), 1e-3f, 1e3f)
+MATH_PAIR(MathLog10, float, log10f(x), __log10f(x), log10l(x), 1e-3f, 1e3f)
+MATH_PAIR(MathSin, float, sinf(x), __sinf(x), sinl(x), -3.14159265f, 3.14159265f)
+MATH_PAIR(MathCos, float, cosf(x), __cosf(x), cosl(x), -3.14159265f, 3.14159265f)
+MATH_PAIR(MathTan, float, tanf(x), __tanf(x), tanl(x), -1.5f, 1.5f)
+MATH_PAIR(MathPow, float, powf(x, 2.5f), __powf(x, 2.5f), powl(x, 2.5L), 0.1f, 10.0f)
+MATH_PAIR(MathSqrt, float, sqrtf(x), __fsqrt_rn(x), sqrtl(x), 0.0f, 1e4f)
+MATH_PAIR(MathRsqrt, float, rsqrtf(x), __frsqrt_rn(x), 1.0L / sqrtl(x), 1e-3f, 1e4f)
+MATH_PAIR(MathRcp, float, 1.0f / x, __frcp_rn(x), 1.0L / x, 0.1f, 100.0f)
+MATH_PAIR(MathDiv, float, x / 3.7f, __fdividef(x, 3.7f), x / 3.7L, -100.0f, 100.0f)
+MATH_PAIR(MathSqrtD, double, sqrt(x), __dsqrt_rn(x), sqrtl(x), 0.0, 1e4)
+MATH_PAIR(MathRcpD, double, 1.0 / x, __drcp_rn(x), 1.0L / x, 0.1, 100.0)
+MATH_PAIR(MathDivD, double, x / 3.7, __ddiv_rn(x, 3.7), x / 3.7L, -100.0, 100.0)
+
+#undef MATH_PAIR
+
+template <typename F, bool Fast> __device__ inline typename F::T evaluate(typename F::T x) {
+  return Fast ? F::fast(x) : F::precise(x);
+}
+
+template <typename F, bool Fast>
+__global__ void mathThroughput(unsigned int iterations, typename F::T* out) {
+  typedef typename F::T T;
+  size_t tid = blockIdx.x * blockDim.x + threadIdx.x;
+  // Four inputs spread over the range, drifting by 1e-6 of the range per iteration
+  const T range = F::hi - F::lo;
+  const T step = range * static_cast<T>(1e-6);
+  T x0 = F::lo + range * static_cast<T>((tid * 4 + 0) % 1021) / 1024;
+  T x1 = F::lo + range * static_cast<T>((tid * 4 + 1) % 1021) / 1024;
+  T x2 = F::lo + range * static_cast<T>((tid * 4 + 2) % 1021) / 1024;
+  T x3 = F::lo + range * static_cast<T>((tid * 4 + 3) % 1021) / 1024;
+  T sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+  for (unsigned int i = 0; i < iterations; i++) {
+    sum0 += evaluate<F, Fast>(x0);
+    sum1 += evaluate<F, Fast>(x1);
+    sum2 += evaluate<F, Fast>(x2);
+    sum3 += evaluate<F, Fast>(x3);
+    x0 += step;
+    x1 += step;
+    x2 += step;
+    x3 += step;
+  }
+  out[tid] = sum0 + sum1 + sum2 + sum3;
+}
+
+template <typename F, bool Fast>
+__global__ void mathEvaluate(const typename F::T* in, typename F::T* out, size_t n) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    out[i] = evaluate<F, Fast>(in[i]);
+  }
+}
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const size_t accuracyInputs = 1 << 20;
+
+// Distance of value from the correctly rounded reference in units of the last place.
+template <typename T> static double ulpError(T value, long double reference) {
+  if (isnan(value) || isnan(reference)) {
+    return isnan(value) == isnan(static_cast<double>(reference))
+        ? 0 : std::numeric_limits<double>::infinity();
+  }
+  T rounded = static_cast<T>(reference);
+  if (isinf(rounded)) {
+    return value == rounded ? 0 : std::numeric_limits<double>::infinity();
+  }
+  T magnitude = fabs(rounded);
+  long double ulp = static_cast<long double>(
+                        nextafter(magnitude, std::numeric_limits<T>::infinity())) -
+                    magnitude;
+  if (ulp == 0) {
+    ulp = std::numeric_limits<T>::denorm_min();
+  }
+  return static_cast<double>(fabsl(static_cast<long double>(value) - reference) / ulp);
+}
+
+// Both functions of one pair: seconds per launch series and max ULP error.
+struct PairResult {
+  std::vector<double> sec[2];
+  double maxUlp[2];
+};
+
+typedef PairResult (*PairRun)(const hipDeviceProp_t& props, unsigned int iterations,
+                              const std::function<std::vector<double>(
+                                  const std::function<void()>&)>& measure);
+
+template <typename F>
+static PairResult runPair(const hipDeviceProp_t& props, unsigned int iterations,
+                          const std::function<std::vector<double>(
+                              const std::function<void()>&)>& measure) {
+  typedef typename F::T T;
+  dim3 grid(props.multiProcessorCount * blocksPerCu);
+  size_t threads = static_cast<size_t>(grid.x) * blockSize;
+  size_t count = std::max(threads, accuracyInputs);
+
+  std::vector<T> in(accuracyInputs);
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<T> dist(F::lo, F::hi);
+  for (auto& x : in) {
+    x = dist(gen);
+  }
+
+  T* in_d = nullptr;
+  T* out_d = nullptr;
+  HIPCHECK(hipMalloc(&in_d, accuracyInputs * sizeof(T)));
+  HIPCHECK(hipMalloc(&out_d, count * sizeof(T)));
+  HIPCHECK(hipMemcpy(in_d, in.data(), accuracyInputs * sizeof(T), hipMemcpyHostToDevice));
+
+  PairResult result;
+  std::vector<T> out(accuracyInputs);
+  for (int fast = 0; fast < 2; fast++) {
+    result.sec[fast] = measure([&]() {
+      if (fast) {
+        hipLaunchKernelGGL((mathThroughput<F, true>), grid, dim3(blockSize), 0, 0, iterations,
+                           out_d);
+      } else {
+        hipLaunchKernelGGL((mathThroughput<F, false>), grid, dim3(blockSize), 0, 0, iterations,
+                           out_d);
+      }
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    if (fast) {
+      hipLaunchKernelGGL((mathEvaluate<F, true>), grid, dim3(blockSize), 0, 0, in_d, out_d,
+                         accuracyInputs);
+    } else {
+      hipLaunchKernelGGL((mathEvaluate<F, false>), grid, dim3(blockSize), 0, 0, in_d, out_d,
+                         accuracyInputs);
+    }
+    HIPCHECK(hipMemcpy(out.data(), out_d, accuracyInputs * sizeof(T), hipMemcpyDeviceToHost));
+    result.maxUlp[fast] = 0;
+    for (size_t i = 0; i < accuracyInputs; i++) {
+      result.maxUlp[fast] = std::max(result.maxUlp[fast], ulpError(out[i], F::reference(in[i])));
+    }
+  }
+
+  HIPCHECK(hipFree(in_d));
+  HIPCHECK(hipFree(out_d));
+  return result;
+}
+
+struct MathPair {
+  const char* precise;
+  const char* fast;
+  PairRun run;
+};
+
+static const MathPair mathPairs[] = {
+    {"expf", "__expf", runPair<MathExp>},
+    {"exp10f", "__exp10f", runPair<MathExp10>},
+    {"logf", "__logf", runPair<MathLog>},
+    {"log2f", "__log2f", runPair<MathLog2>},
+    {"log10f", "__log10f", runPair<MathLog10>},
+    {"sinf", "__sinf", runPair<MathSin>},
+    {"cosf", "__cosf", runPair<MathCos>},
+    {"tanf", "__tanf", runPair<MathTan>},
+    {"powf", "__powf", runPair<MathPow>},
+    {"sqrtf", "__fsqrt_rn", runPair<MathSqrt>},
+    {"rsqrtf", "__frsqrt_rn", runPair<MathRsqrt>},
+    {"1.0f / x", "__frcp_rn", runPair<MathRcp>},
+    {"x / y", "__fdividef", runPair<MathDiv>},
+    {"sqrt", "__dsqrt_rn", runPair<MathSqrtD>},
+    {"1.0 / x", "__drcp_rn", runPair<MathRcpD>},
+    {"x / y double", "__ddiv_rn", runPair<MathDivD>}};
+
+static const unsigned int numMathPairs = sizeof(mathPairs) / sizeof(mathPairs[0]);
+
+class hipPerfMathIntrinsics : public HipPerf::Benchmark {
+ public:
+  hipPerfMathIntrinsics() : HipPerf::Benchmark("hipPerfMathIntrinsics"),
+      iterations_(HipPerf::iterationCount(4096)) {}
+
+  unsigned int numTests() override { return numMathPairs; }
+
+  void run(unsigned int test) override {
+    const MathPair& pair = mathPairs[test];
+    PairResult result = pair.run(props_, iterations_, [this](const std::function<void()>& op) {
+      return measure(op);
+    });
+
+    dim3 grid(props_.multiProcessorCount * blocksPerCu);
+    double ops = static_cast<double>(grid.x) * blockSize * iterations_ * 4;
+    // clockRate is in kHz
+    double cyclesPerSec = props_.clockRate * 1e3 * props_.multiProcessorCount;
+    const char* names[2] = {pair.precise, pair.fast};
+    for (int fast = 0; fast < 2; fast++) {
+      std::vector<double> opsPerCycle;
+      for (double s : result.sec[fast]) {
+        opsPerCycle.push_back(ops / s / cyclesPerSec);
+      }
+      char desc[96];
+      snprintf(desc, sizeof(desc), "%-12s max %.1f ulp", names[fast], result.maxUlp[fast]);
+      report(test, desc, 0, iterations_, "ops/cycle/CU", opsPerCycle);
+    }
+
+    std::vector<double> speedup;
+    for (size_t r = 0; r < result.sec[0].size(); r++) {
+      speedup.push_back(result.sec[0][r] / result.sec[1][r]);
+    }
+    report(test, std::string(pair.fast) + " speedup over " + pair.precise, 0, iterations_, "x",
+           speedup);
+  }
+
+ private:
+  unsigned int iterations_;  // per thread, four operations each
+};
+
+HIP_PERF_BENCHMARK(hipPerfMathIntrinsics)
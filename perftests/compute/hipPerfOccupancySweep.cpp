@@ -0,0 +1,220 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Measured runtime against predicted occupancy over block size and dynamic
+// shared memory. For every kernel of the table and every dynamic shared memory
+// size the test sweeps the block size in steps of 64, launches one resident
+// wave of blocks (active blocks per CU from
+// hipOccupancyMaxActiveBlocksPerMultiprocessor times CU count) over a fixed
+// amount of grid-stride work and reports the occupancy of each configuration
+// next to its runtime. A summary line puts the fastest block size next to the
+// one hipOccupancyMaxPotentialBlockSize suggests, tagged with the gfx target,
+// so the results can seed launch configurations per target. To tune another
+// kernel add it to kernelTable with the same signature.
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "perf_harness.h"
+
+typedef void (*SweepKernel)(float* out, const float* in, size_t n, unsigned int loops);
+
+// Bandwidth bound, one read and one write per element
+__global__ void streamKernel(float* out, const float* in, size_t n, unsigned int loops) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    out[i] = in[i] * 2.0f;
+  }
+}
+
+// ALU bound with a high register count, eight dependent FMA chains per element
+__global__ void computeKernel(float* out, const float* in, size_t n, unsigned int loops) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    float v[8];
+    for (int k = 0; k < 8; k++) {
+      v[k] = in[i] + k;
+    }
+    for (unsigned int l = 0; l < loops; l++) {
+#pragma unroll
+      for (int k = 0; k < 8; k++) {
+        v[k] = fmaf(v[k], 0.999f, 0.001f);
+      }
+    }
+    float sum = 0.0f;
+    for (int k = 0; k < 8; k++) {
+      sum += v[k];
+    }
+    out[i] = sum;
+  }
+}
+
+// Shared memory bound, every element is staged in a static tile and read back
+// by a neighbouring lane
+__global__ void ldsKernel(float* out, const float* in, size_t n, unsigned int loops) {
+  __shared__ float tile[1024];
+  size_t stride = gridDim.x * blockDim.x;
+  size_t end = (n + stride - 1) / stride * stride;
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < end; i += stride) {
+    tile[threadIdx.x] = i < n ? in[i] : 0.0f;
+    __syncthreads();
+    float v = 0.0f;
+    for (unsigned int l = 0; l < loops; l++) {
+      v += tile[(threadIdx.x + l) % blockDim.x];
+    }
+    __syncthreads();
+    if (i < n) {
+      out[i] = v;
+    }
+  }
+}
+
+struct KernelEntry {
+  const char* name;
+  SweepKernel kernel;
+  unsigned int loops;
+};
+
+static const KernelEntry kernelTable[] = {
+    {"stream", streamKernel, 1},
+    {"compute", computeKernel, 64},
+    {"lds", ldsKernel, 16},
+};
+static const unsigned int numKernels = sizeof(kernelTable) / sizeof(kernelTable[0]);
+
+// Extra dynamic shared memory per block on top of what the kernel declares
+static const size_t dynamicShared[] = {0, 8 * 1024, 16 * 1024, 32 * 1024};
+static const unsigned int numDynamicShared = sizeof(dynamicShared) / sizeof(dynamicShared[0]);
+
+static const unsigned int blockStep = 64;
+static const size_t elements = 16 * 1024 * 1024;
+
+class hipPerfOccupancySweep : public HipPerf::Benchmark {
+ public:
+  hipPerfOccupancySweep() : HipPerf::Benchmark("hipPerfOccupancySweep"),
+      launches_(HipPerf::iterationCount(10)), in_(nullptr), out_(nullptr), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&in_, elements * sizeof(float)));
+    HIPCHECK(hipMalloc(&out_, elements * sizeof(float)));
+    HIPCHECK(hipMemset(in_, 0, elements * sizeof(float)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(in_));
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numKernels * numDynamicShared; }
+
+  void run(unsigned int test) override {
+    const KernelEntry& entry = kernelTable[test / numDynamicShared];
+    size_t shared = dynamicShared[test % numDynamicShared];
+
+    hipFuncAttributes attr;
+    HIPCHECK(hipFuncGetAttributes(&attr, reinterpret_cast<const void*>(entry.kernel)));
+    if (attr.sharedSizeBytes + shared > props_.sharedMemPerBlock) {
+      printf("info: %zu bytes of dynamic shared memory exceed the per block limit, skipping\n",
+             shared);
+      return;
+    }
+
+    int minGrid = 0;
+    int suggested = 0;
+    HIPCHECK(hipOccupancyMaxPotentialBlockSize(&minGrid, &suggested,
+                                               reinterpret_cast<const void*>(entry.kernel),
+                                               shared, 0));
+
+    int maxBlock = std::min(props_.maxThreadsPerBlock, attr.maxThreadsPerBlock);
+    char desc[160];
+    double bestTime = 0;
+    int best = 0;
+    double suggestedTime = 0;
+    for (int block = blockStep; block <= maxBlock; block += blockStep) {
+      double sec = sweepPoint(test, entry, shared, block);
+      if (sec <= 0) {
+        continue;
+      }
+      if (best == 0 || sec < bestTime) {
+        best = block;
+        bestTime = sec;
+      }
+      if (block == suggested) {
+        suggestedTime = sec;
+      }
+    }
+    // The suggestion need not be a multiple of the sweep step
+    if (best != 0 && suggested > 0 && suggestedTime == 0) {
+      suggestedTime = sweepPoint(test, entry, shared, suggested);
+    }
+    if (best == 0 || suggestedTime <= 0) {
+      printf("info: no launchable configuration for %s, skipping\n", entry.name);
+      return;
+    }
+
+    snprintf(desc, sizeof(desc), "%s %s dyn %6zu B best %4d suggested %4d, suggested slower by",
+             props_.gcnArchName, entry.name, shared, best, suggested);
+    report(test, desc, 0, launches_, "%", {100.0 * (suggestedTime - bestTime) / bestTime},
+           HipPerf::betterLower);
+  }
+
+ private:
+  // Measures one block size, reports it and returns the median seconds per
+  // launch, or 0 when no block fits on a CU.
+  double sweepPoint(unsigned int test, const KernelEntry& entry, size_t shared, int block) {
+    int active = 0;
+    HIPCHECK(hipOccupancyMaxActiveBlocksPerMultiprocessor(
+        &active, reinterpret_cast<const void*>(entry.kernel), block, shared));
+    if (active == 0) {
+      return 0;
+    }
+    double occupancy = 100.0 * active * block / props_.maxThreadsPerMultiProcessor;
+    dim3 grid(active * props_.multiProcessorCount);
+
+    auto sec = measure([&]() {
+      for (unsigned int l = 0; l < launches_; l++) {
+        hipLaunchKernelGGL(entry.kernel, grid, dim3(block), shared, stream_, out_, in_,
+                           elements, entry.loops);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    char desc[160];
+    snprintf(desc, sizeof(desc), "%s dyn %6zu B block %4d blocks/CU %2d occupancy %5.1f%%",
+             entry.name, shared, block, active, occupancy);
+    auto us = HipPerf::toMicroseconds(sec, launches_);
+    report(test, desc, elements * sizeof(float) * 2, launches_, "us", us);
+    return ComputePerfStats(sec).median / launches_;
+  }
+
+  unsigned int launches_;
+  float* in_;
+  float* out_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfOccupancySweep)
@@ -0,0 +1,477 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Scan and sort primitives on 32 bit unsigned keys, written here so there is
+// a baseline that does not depend on a vendor library:
+//   - block scan: every block scans its 2048 element tile in LDS on its own
+//   - device scan: single pass inclusive scan with decoupled look-back, tiles
+//     taken in order from an atomic counter publish their aggregate and then
+//     their inclusive prefix, predecessors are read back until a prefix shows
+//   - radix sort: LSD, 8 bits per pass; a per tile digit histogram, an
+//     exclusive device scan of the histograms and a stable scatter that ranks
+//     keys within a wave by ballot, keys only and with 32 bit values
+// Sizes are bytes of keys (--sizes), up to 1 GB; sizes needing more than
+// three quarters of device memory are skipped. Every primitive is run once
+// and checked on the host before it is timed. Reports Gkeys/s and, for the
+// scans, GB/s of the read and write traffic.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const std::vector<size_t> Sizes = {1048576, 16777216, 268435456, 1073741824};
+
+enum ScanSortPrim { primBlockScan = 0, primDeviceScan, primSortKeys, primSortPairs,
+                    numScanSortPrims };
+static const char* scanSortPrimStr[numScanSortPrims] = {"block scan", "look-back scan",
+                                                        "radix sort keys", "radix sort pairs"};
+
+static const unsigned int blockSize = 256;
+static const unsigned int scanItems = 8;
+static const unsigned int scanTile = blockSize * scanItems;
+static const unsigned int radixBits = 8;
+static const unsigned int radixDigits = 1 << radixBits;  // one per thread
+static const unsigned int sortItems = 16;
+static const unsigned int sortTile = blockSize * sortItems;
+static const unsigned int maxWaves = blockSize / 32;
+static const unsigned int valueXor = 0x9e3779b9;
+
+// Look-back status of a tile, the flag in the upper half
+enum TileStatus { statusInvalid = 0, statusAggregate, statusPrefix };
+
+// Coalesced load into LDS, then scanItems consecutive elements per thread
+__device__ inline void loadTile(const unsigned int* in, size_t n, size_t base, unsigned int* tile,
+                                unsigned int (&items)[scanItems]) {
+  for (unsigned int i = 0; i < scanItems; i++) {
+    size_t idx = base + i * blockSize + threadIdx.x;
+    tile[i * blockSize + threadIdx.x] = idx < n ? in[idx] : 0;
+  }
+  __syncthreads();
+  for (unsigned int i = 0; i < scanItems; i++) {
+    items[i] = tile[threadIdx.x * scanItems + i];
+  }
+  __syncthreads();
+}
+
+__device__ inline void storeTile(unsigned int* out, size_t n, size_t base, unsigned int* tile,
+                                 const unsigned int (&items)[scanItems]) {
+  for (unsigned int i = 0; i < scanItems; i++) {
+    tile[threadIdx.x * scanItems + i] = items[i];
+  }
+  __syncthreads();
+  for (unsigned int i = 0; i < scanItems; i++) {
+    size_t idx = base + i * blockSize + threadIdx.x;
+    if (idx < n) out[idx] = tile[i * blockSize + threadIdx.x];
+  }
+}
+
+// Inclusive scan of the tile held in items, returns the tile aggregate
+__device__ inline unsigned int tileScan(unsigned int (&items)[scanItems], unsigned int* lds) {
+  unsigned int sum = 0;
+  for (unsigned int i = 0; i < scanItems; i++) {
+    sum += items[i];
+    items[i] = sum;
+  }
+  lds[threadIdx.x] = sum;
+  __syncthreads();
+  for (unsigned int offset = 1; offset < blockSize; offset *= 2) {
+    unsigned int add = threadIdx.x >= offset ? lds[threadIdx.x - offset] : 0;
+    __syncthreads();
+    lds[threadIdx.x] += add;
+    __syncthreads();
+  }
+  unsigned int prefix = lds[threadIdx.x] - sum;
+  unsigned int total = lds[blockSize - 1];
+  __syncthreads();
+  for (unsigned int i = 0; i < scanItems; i++) {
+    items[i] += prefix;
+  }
+  return total;
+}
+
+__global__ void blockScan(const unsigned int* in, unsigned int* out, size_t n) {
+  __shared__ unsigned int tile[scanTile];
+  __shared__ unsigned int lds[blockSize];
+  size_t base = static_cast<size_t>(blockIdx.x) * scanTile;
+  unsigned int items[scanItems];
+  loadTile(in, n, base, tile, items);
+  tileScan(items, lds);
+  storeTile(out, n, base, tile, items);
+}
+
+__device__ inline void publishStatus(unsigned long long* status, TileStatus flag,
+                                     unsigned int value) {
+  __threadfence();
+  atomicExch(status, (static_cast<unsigned long long>(flag) << 32) | value);
+}
+
+// status holds one word per tile plus the tile counter, all zero at launch; in may be out
+template <bool EXCLUSIVE>
+__global__ void lookbackScan(const unsigned int* in, unsigned int* out, size_t n,
+                             unsigned long long* status, unsigned int* tileCounter) {
+  __shared__ unsigned int tile[scanTile];
+  __shared__ unsigned int lds[blockSize];
+  __shared__ unsigned int tileId;
+  __shared__ unsigned int tilePrefix;
+  // Tiles start in counter order, so every predecessor is running or done
+  if (threadIdx.x == 0) tileId = atomicAdd(tileCounter, 1u);
+  __syncthreads();
+  unsigned int t = tileId;
+  size_t base = static_cast<size_t>(t) * scanTile;
+  unsigned int items[scanItems];
+  unsigned int inputs[scanItems];
+  loadTile(in, n, base, tile, items);
+  for (unsigned int i = 0; i < scanItems; i++) {
+    inputs[i] = items[i];
+  }
+  unsigned int aggregate = tileScan(items, lds);
+
+  if (threadIdx.x == 0) {
+    unsigned int prefix = 0;
+    if (t == 0) {
+      publishStatus(&status[0], statusPrefix, aggregate);
+    } else {
+      publishStatus(&status[t], statusAggregate, aggregate);
+      for (unsigned int pred = t - 1;; pred--) {
+        unsigned long long word;
+        do {
+          word = *static_cast<volatile unsigned long long*>(&status[pred]);
+        } while ((word >> 32) == statusInvalid);
+        prefix += static_cast<unsigned int>(word);
+        if ((word >> 32) == statusPrefix) break;
+      }
+      publishStatus(&status[t], statusPrefix, prefix + aggregate);
+    }
+    tilePrefix = prefix;
+  }
+  __syncthreads();
+  for (unsigned int i = 0; i < scanItems; i++) {
+    items[i] = (EXCLUSIVE ? items[i] - inputs[i] : items[i]) + tilePrefix;
+  }
+  storeTile(out, n, base, tile, items);
+}
+
+// Digit counts of every tile, digit major so one exclusive scan gives the scatter offsets
+__global__ void radixHistogram(const unsigned int* keys, size_t n, unsigned int shift,
+                               unsigned int* counts, unsigned int numTiles) {
+  __shared__ unsigned int histogram[radixDigits];
+  histogram[threadIdx.x] = 0;
+  __syncthreads();
+  size_t base = static_cast<size_t>(blockIdx.x) * sortTile;
+  for (unsigned int i = 0; i < sortItems; i++) {
+    size_t idx = base + i * blockSize + threadIdx.x;
+    if (idx < n) atomicAdd(&histogram[(keys[idx] >> shift) & (radixDigits - 1)], 1u);
+  }
+  __syncthreads();
+  counts[threadIdx.x * numTiles + blockIdx.x] = histogram[threadIdx.x];
+}
+
+// Stable scatter: the tile goes in blockSize chunks, within a chunk keys are ranked among the
+// lanes of their wave with the same digit, and waves in order
+template <bool VALUES>
+__global__ void radixScatter(const unsigned int* keysIn, unsigned int* keysOut,
+                             const unsigned int* valuesIn, unsigned int* valuesOut, size_t n,
+                             unsigned int shift, const unsigned int* offsets,
+                             unsigned int numTiles) {
+  __shared__ unsigned int running[radixDigits];
+  __shared__ unsigned int waveCounts[maxWaves * radixDigits];
+  unsigned int waves = blockSize / warpSize;
+  unsigned int wave = threadIdx.x / warpSize;
+  unsigned int lane = threadIdx.x % warpSize;
+  unsigned long long below = (1ull << lane) - 1;
+  running[threadIdx.x] = offsets[threadIdx.x * numTiles + blockIdx.x];
+  size_t base = static_cast<size_t>(blockIdx.x) * sortTile;
+
+  for (unsigned int c = 0; c < sortItems; c++) {
+    size_t idx = base + c * blockSize + threadIdx.x;
+    bool valid = idx < n;
+    unsigned int key = valid ? keysIn[idx] : 0;
+    unsigned int digit = (key >> shift) & (radixDigits - 1);
+    for (unsigned int i = threadIdx.x; i < waves * radixDigits; i += blockSize) {
+      waveCounts[i] = 0;
+    }
+    __syncthreads();
+
+    unsigned long long peers = __ballot(valid);
+    for (unsigned int b = 0; b < radixBits; b++) {
+      bool bit = (digit >> b) & 1;
+      unsigned long long mask = __ballot(bit);
+      peers &= bit ? mask : ~mask;
+    }
+    unsigned int rank = __popcll(peers & below);
+    if (valid && rank == 0) waveCounts[wave * radixDigits + digit] = __popcll(peers);
+    __syncthreads();
+
+    // Thread d turns the wave counts of digit d into offsets
+    unsigned int sum = running[threadIdx.x];
+    for (unsigned int w = 0; w < waves; w++) {
+      unsigned int count = waveCounts[w * radixDigits + threadIdx.x];
+      waveCounts[w * radixDigits + threadIdx.x] = sum;
+      sum += count;
+    }
+    running[threadIdx.x] = sum;
+    __syncthreads();
+
+    if (valid) {
+      unsigned int pos = waveCounts[wave * radixDigits + digit] + rank;
+      keysOut[pos] = key;
+      if (VALUES) valuesOut[pos] = valuesIn[idx];
+    }
+    __syncthreads();
+  }
+}
+
+class hipPerfScanSort : public HipPerf::Benchmark {
+ public:
+  hipPerfScanSort() : HipPerf::Benchmark("hipPerfScanSort"), sizes_(HipPerf::sweepSizes(Sizes)),
+      stream_(nullptr), n_(0), keys_(nullptr), keysAlt_(nullptr), source_(nullptr),
+      values_(nullptr), valuesAlt_(nullptr), counts_(nullptr), status_(nullptr), statusBytes_(0),
+      countStatus_(nullptr), countStatusBytes_(0), numSortTiles_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override { HIPCHECK(hipStreamDestroy(stream_)); }
+
+  unsigned int numTests() override { return sizes_.size() * numScanSortPrims; }
+
+  void run(unsigned int test) override {
+    size_t size = sizes_[test / numScanSortPrims];
+    ScanSortPrim prim = static_cast<ScanSortPrim>(test % numScanSortPrims);
+    if (size % sizeof(unsigned int) != 0 || size / sizeof(unsigned int) >= (1ull << 32)) {
+      printf("info: %zu bytes is not a multiple of 4 bytes below 16 GB, skipping\n", size);
+      return;
+    }
+    size_t n = size / sizeof(unsigned int);
+    // Sorts keep a copy of the unsorted keys
+    size_t buffers = prim == primSortPairs ? 5 : prim == primSortKeys ? 3 : 2;
+    if (buffers * size + size / 4 > props_.totalGlobalMem / 4 * 3) {
+      printf("info: %s of %zu bytes needs more than 3/4 of device memory, skipping\n",
+             scanSortPrimStr[prim], size);
+      return;
+    }
+    if (input_.size() != n) {
+      // Fixed seed, so every device sorts the same keys
+      std::mt19937 rng(0x5cab);
+      input_.resize(n);
+      for (auto& key : input_) {
+        key = rng();
+      }
+    }
+    allocate(n, prim >= primSortKeys, prim == primSortPairs);
+
+    execute(prim);
+    HIPCHECK(hipStreamSynchronize(stream_));
+    check(prim);
+
+    std::vector<double> sec;
+    if (prim <= primDeviceScan) {
+      sec = measure([&]() {
+        execute(prim);
+        HIPCHECK(hipStreamSynchronize(stream_));
+      });
+    } else {
+      // Every sample sorts the unsorted keys again, restoring them is not timed
+      for (unsigned int i = 0; i < p_warmup + p_repetitions; i++) {
+        HIPCHECK(hipMemcpyAsync(keys_, source_, size, hipMemcpyDeviceToDevice, stream_));
+        HIPCHECK(hipStreamSynchronize(stream_));
+        auto start = std::chrono::steady_clock::now();
+        execute(prim);
+        HIPCHECK(hipStreamSynchronize(stream_));
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (i >= p_warmup) {
+          sec.push_back(elapsed.count());
+        }
+      }
+    }
+    release();
+
+    report(test, scanSortPrimStr[prim], size, 1, "Gkeys/s", HipPerf::toBandwidth(sec, n));
+    if (prim <= primDeviceScan) {
+      report(test, scanSortPrimStr[prim], size, 1, "GB/s", HipPerf::toBandwidth(sec, 2.0 * size));
+    }
+  }
+
+ private:
+  void allocate(size_t n, bool sort, bool values) {
+    size_t size = n * sizeof(unsigned int);
+    n_ = n;
+    HIPCHECK(hipMalloc(&keys_, size));
+    HIPCHECK(hipMalloc(&keysAlt_, size));
+    HIPCHECK(hipMemcpy(keys_, input_.data(), size, hipMemcpyHostToDevice));
+    if (sort) {
+      HIPCHECK(hipMalloc(&source_, size));
+      HIPCHECK(hipMemcpy(source_, keys_, size, hipMemcpyDeviceToDevice));
+    }
+    if (values) {
+      std::vector<unsigned int> input(n);
+      for (size_t i = 0; i < n; i++) {
+        input[i] = input_[i] ^ valueXor;
+      }
+      HIPCHECK(hipMalloc(&values_, size));
+      HIPCHECK(hipMalloc(&valuesAlt_, size));
+      HIPCHECK(hipMemcpy(values_, input.data(), size, hipMemcpyHostToDevice));
+    }
+    // A word per tile and the tile counter
+    statusBytes_ = ((n + scanTile - 1) / scanTile + 1) * sizeof(unsigned long long);
+    HIPCHECK(hipMalloc(&status_, statusBytes_));
+    numSortTiles_ = static_cast<unsigned int>((n + sortTile - 1) / sortTile);
+    size_t numCounts = static_cast<size_t>(numSortTiles_) * radixDigits;
+    HIPCHECK(hipMalloc(&counts_, numCounts * sizeof(unsigned int)));
+    countStatusBytes_ = ((numCounts + scanTile - 1) / scanTile + 1) * sizeof(unsigned long long);
+    HIPCHECK(hipMalloc(&countStatus_, countStatusBytes_));
+  }
+
+  void release() {
+    HIPCHECK(hipFree(keys_));
+    HIPCHECK(hipFree(keysAlt_));
+    HIPCHECK(hipFree(source_));
+    HIPCHECK(hipFree(values_));
+    HIPCHECK(hipFree(valuesAlt_));
+    HIPCHECK(hipFree(counts_));
+    HIPCHECK(hipFree(status_));
+    HIPCHECK(hipFree(countStatus_));
+    keys_ = keysAlt_ = source_ = values_ = valuesAlt_ = counts_ = nullptr;
+    status_ = countStatus_ = nullptr;
+  }
+
+  template <bool EXCLUSIVE>
+  void deviceScan(const unsigned int* in, unsigned int* out, size_t n,
+                  unsigned long long* status, size_t statusBytes) {
+    unsigned int tiles = static_cast<unsigned int>((n + scanTile - 1) / scanTile);
+    HIPCHECK(hipMemsetAsync(status, 0, statusBytes, stream_));
+    hipLaunchKernelGGL(lookbackScan<EXCLUSIVE>, dim3(tiles), dim3(blockSize), 0, stream_, in,
+                       out, n, status, reinterpret_cast<unsigned int*>(&status[tiles]));
+  }
+
+  // Scans read keys_ and write keysAlt_, sorts sort keys_ (and values_) in place
+  void execute(ScanSortPrim prim) {
+    switch (prim) {
+      case primBlockScan:
+        hipLaunchKernelGGL(blockScan, dim3((n_ + scanTile - 1) / scanTile), dim3(blockSize), 0,
+                           stream_, keys_, keysAlt_, n_);
+        break;
+      case primDeviceScan:
+        deviceScan<false>(keys_, keysAlt_, n_, status_, statusBytes_);
+        break;
+      default:
+        radixSort(prim == primSortPairs);
+        break;
+    }
+  }
+
+  void radixSort(bool values) {
+    size_t numCounts = static_cast<size_t>(numSortTiles_) * radixDigits;
+    unsigned int* keysIn = keys_;
+    unsigned int* keysOut = keysAlt_;
+    unsigned int* valuesIn = values_;
+    unsigned int* valuesOut = valuesAlt_;
+    // 32 / radixBits passes is even, so the sorted keys end up in keys_
+    for (unsigned int shift = 0; shift < 32; shift += radixBits) {
+      hipLaunchKernelGGL(radixHistogram, dim3(numSortTiles_), dim3(blockSize), 0, stream_,
+                         keysIn, n_, shift, counts_, numSortTiles_);
+      deviceScan<true>(counts_, counts_, numCounts, countStatus_, countStatusBytes_);
+      if (values) {
+        hipLaunchKernelGGL(radixScatter<true>, dim3(numSortTiles_), dim3(blockSize), 0, stream_,
+                           keysIn, keysOut, valuesIn, valuesOut, n_, shift, counts_,
+                           numSortTiles_);
+      } else {
+        hipLaunchKernelGGL(radixScatter<false>, dim3(numSortTiles_), dim3(blockSize), 0,
+                           stream_, keysIn, keysOut, valuesIn, valuesOut, n_, shift, counts_,
+                           numSortTiles_);
+      }
+      std::swap(keysIn, keysOut);
+      std::swap(valuesIn, valuesOut);
+    }
+  }
+
+  void check(ScanSortPrim prim) {
+    size_t size = n_ * sizeof(unsigned int);
+    std::vector<unsigned int> result(n_);
+    if (prim <= primDeviceScan) {
+      HIPCHECK(hipMemcpy(result.data(), keysAlt_, size, hipMemcpyDeviceToHost));
+      unsigned int sum = 0;
+      for (size_t i = 0; i < n_; i++) {
+        if (prim == primBlockScan && i % scanTile == 0) sum = 0;
+        sum += input_[i];
+        if (result[i] != sum) {
+          failed("%s: element %zu is %u, expected %u", scanSortPrimStr[prim], i, result[i], sum);
+        }
+      }
+      return;
+    }
+
+    HIPCHECK(hipMemcpy(result.data(), keys_, size, hipMemcpyDeviceToHost));
+    if (!std::is_sorted(result.begin(), result.end())) {
+      failed("%s: keys are not sorted", scanSortPrimStr[prim]);
+    }
+    // The same keys, not just sorted ones
+    unsigned int sum = 0, sumExpected = 0, bits = 0, bitsExpected = 0;
+    for (size_t i = 0; i < n_; i++) {
+      sum += result[i];
+      bits ^= result[i] * 2654435761u;
+      sumExpected += input_[i];
+      bitsExpected ^= input_[i] * 2654435761u;
+    }
+    if (sum != sumExpected || bits != bitsExpected) {
+      failed("%s: sorted keys differ from the input", scanSortPrimStr[prim]);
+    }
+    if (prim == primSortPairs) {
+      std::vector<unsigned int> values(n_);
+      HIPCHECK(hipMemcpy(values.data(), values_, size, hipMemcpyDeviceToHost));
+      for (size_t i = 0; i < n_; i++) {
+        if (values[i] != (result[i] ^ valueXor)) {
+          failed("%s: value %zu does not belong to its key", scanSortPrimStr[prim], i);
+        }
+      }
+    }
+  }
+
+  std::vector<size_t> sizes_;
+  std::vector<unsigned int> input_;  // keys of the current size
+  hipStream_t stream_;
+  size_t n_;
+  unsigned int* keys_;
+  unsigned int* keysAlt_;
+  unsigned int* source_;  // unsorted keys, sorts only
+  unsigned int* values_;
+  unsigned int* valuesAlt_;
+  unsigned int* counts_;  // radix digit counts, digit major
+  unsigned long long* status_;
+  size_t statusBytes_;
+  unsigned long long* countStatus_;  // for the scan of counts_
+  size_t countStatusBytes_;
+  unsigned int numSortTiles_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfScanSort)
@@ -0,0 +1,188 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of private (scratch) memory as hipLimitStackSize grows. Per stack size
+// (1 KB to 128 KB per thread, --sizes or --sweep replace them) three kernels
+// run: one without private memory, one with a 1 KB local array indexed at
+// run time and one recursing 8 levels with a 16 float frame per level. For
+// each the latency of a single small launch plus synchronize, the time per
+// launch of back to back full device grids, and the device memory in use
+// after the launch above what was in use when the test started are reported.
+// hipDeviceSetLimit can only grow scratch the runtime already reserved for an
+// earlier, larger setting, so sizes run in ascending order; run one size with
+// -t for its memory cost alone. Sizes the device rejects are skipped.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "perf_harness.h"
+
+static const size_t defaultStackSizes[] = {1024, 4096, 16384, 65536, 131072};
+
+enum StackKernel { kernelNoScratch = 0, kernelLocalArray, kernelRecursive, numStackKernels };
+static const char* stackKernelStr[numStackKernels] = {"no scratch", "1 KB local array",
+                                                      "recursion depth 8"};
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const unsigned int launchesPerRep = 100;
+static const unsigned int latencyLaunches = 100;
+static const unsigned int localFloats = 256;
+static const unsigned int frameFloats = 16;
+static const int recursionDepth = 8;
+
+__global__ void noScratch(float* out, unsigned int seed) {
+  unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+  out[i] = static_cast<float>(seed + i);
+}
+
+// Indices only known at run time keep the array out of registers
+__global__ void localArray(float* out, unsigned int seed) {
+  float local[localFloats];
+  for (unsigned int i = 0; i < localFloats; i++) {
+    local[i] = static_cast<float>(seed + i);
+  }
+  unsigned int index = threadIdx.x * 7 + seed;
+  float sum = 0;
+  for (unsigned int r = 0; r < 64; r++) {
+    sum += local[index % localFloats];
+    index = index * 1664525u + 1013904223u;
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = sum;
+}
+
+__device__ __noinline__ float recurse(float value, int depth) {
+  float frame[frameFloats];
+  for (unsigned int i = 0; i < frameFloats; i++) {
+    frame[i] = value + i;
+  }
+  if (depth == 0) {
+    return frame[static_cast<unsigned int>(value) % frameFloats];
+  }
+  return recurse(frame[depth % frameFloats], depth - 1) + frame[0];
+}
+
+__global__ void recursive(float* out, unsigned int seed) {
+  unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+  out[i] = recurse(static_cast<float>(seed + threadIdx.x), recursionDepth);
+}
+
+class hipPerfStackSize : public HipPerf::Benchmark {
+ public:
+  hipPerfStackSize() : HipPerf::Benchmark("hipPerfStackSize"),
+      stackSizes_(HipPerf::sweepSizes(std::vector<size_t>(
+          defaultStackSizes, defaultStackSizes + sizeof(defaultStackSizes) /
+                                                     sizeof(defaultStackSizes[0])))),
+      defaultStack_(0), baselineUsed_(0), out_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetLimit(&defaultStack_, hipLimitStackSize));
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    HIPCHECK(hipMalloc(&out_, static_cast<size_t>(grid_.x) * blockSize * sizeof(float)));
+    HIPCHECK(hipDeviceSynchronize());
+    baselineUsed_ = usedMemory();
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipDeviceSetLimit(hipLimitStackSize, defaultStack_));
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(stackSizes_.size()) * numStackKernels;
+  }
+
+  void run(unsigned int test) override {
+    StackKernel kernel = static_cast<StackKernel>(test % numStackKernels);
+    size_t stack = stackSizes_[test / numStackKernels];
+
+    if (hipDeviceSetLimit(hipLimitStackSize, stack) != hipSuccess) {
+      static_cast<void>(hipGetLastError());
+      printf("info: stack size %zu rejected, skipping\n", stack);
+      return;
+    }
+    size_t applied = 0;
+    HIPCHECK(hipDeviceGetLimit(&applied, hipLimitStackSize));
+
+    auto launch = [&](dim3 grid, unsigned int seed) {
+      switch (kernel) {
+        case kernelNoScratch:
+          hipLaunchKernelGGL(noScratch, grid, dim3(blockSize), 0, 0, out_, seed);
+          break;
+        case kernelLocalArray:
+          hipLaunchKernelGGL(localArray, grid, dim3(blockSize), 0, 0, out_, seed);
+          break;
+        default:
+          hipLaunchKernelGGL(recursive, grid, dim3(blockSize), 0, 0, out_, seed);
+          break;
+      }
+    };
+
+    // The first launch after a new limit is where the runtime grows scratch
+    launch(grid_, 0);
+    HIPCHECK(hipGetLastError());
+    HIPCHECK(hipDeviceSynchronize());
+    double usedMb =
+        (static_cast<double>(usedMemory()) - static_cast<double>(baselineUsed_)) / (1024 * 1024);
+
+    auto latency = measureEach([&]() {
+      launch(dim3(1), 1);
+      HIPCHECK(hipDeviceSynchronize());
+    }, latencyLaunches);
+
+    auto sec = measure([&]() {
+      for (unsigned int l = 0; l < launchesPerRep; l++) {
+        launch(grid_, l);
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "stack %6zu B (%6zu applied) %s", stack, applied,
+             stackKernelStr[kernel]);
+    report(test, std::string(desc) + " launch + sync", stack, 1, "us",
+           HipPerf::toMicroseconds(latency, 1));
+    report(test, std::string(desc) + " full grid", stack, launchesPerRep, "us",
+           HipPerf::toMicroseconds(sec, launchesPerRep));
+    report(test, std::string(desc) + " device memory", stack, 1, "MB", {usedMb});
+  }
+
+ private:
+  static size_t usedMemory() {
+    size_t freeMem = 0, totalMem = 0;
+    HIPCHECK(hipMemGetInfo(&freeMem, &totalMem));
+    return totalMem - freeMem;
+  }
+
+  std::vector<size_t> stackSizes_;
+  size_t defaultStack_;
+  size_t baselineUsed_;
+  dim3 grid_;
+  float* out_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfStackSize)
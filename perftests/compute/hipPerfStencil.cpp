@@ -0,0 +1,399 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Jacobi stencil sweeps on float grids in pitched allocations: a 5 point
+// stencil on a 4096 x 4096 grid (hipMallocPitch) and a 7 point stencil on a
+// 256^3 grid (hipMalloc3D), each once reading all neighbours from global
+// memory and once through an LDS tile with a one point halo (for 3D a 2.5D
+// tile that marches along z keeping the planes below and above in registers).
+// The LDS versions are checked against the global ones before they are timed.
+// The multi-GPU tests split a 256 x 256 x (256 * devices) grid into z slabs,
+// one per device with a halo plane on either side, and exchange the halo
+// planes with hipMemcpyPeerAsync after every sweep: either after the whole
+// slab is computed, or with the two boundary planes computed and sent on one
+// stream while the interior is computed on another. Reports Gpoints/s, us
+// per sweep for the multi-GPU tests and the speedup overlapping gives.
+
+#include <stdio.h>
+
+#include <cmath>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum StencilTest { test2D = 0, test2DLds, test3D, test3DLds, testMultiSerial, testMultiOverlap,
+                   numStencilTests };
+static const char* stencilTestStr[numStencilTests] = {
+    "2D 5 point global", "2D 5 point LDS tile", "3D 7 point global", "3D 7 point LDS tile",
+    "multi-GPU compute then exchange", "multi-GPU exchange overlapped"};
+
+static const unsigned int edge2D = 4096;
+static const unsigned int edge3D = 256;
+static const int tileX = 32;
+static const int tileY = 8;
+
+__device__ inline float stencil5(float c, float w, float e, float s, float n) {
+  return 0.5f * c + 0.125f * ((w + e) + (s + n));
+}
+
+__device__ inline float stencil7(float c, float w, float e, float s, float n, float b, float t) {
+  return 0.4f * c + 0.1f * ((w + e) + (s + n) + (b + t));
+}
+
+// Any smooth, nonzero pattern; pitch and slice are in elements
+__global__ void initGrid(float* grid, size_t pitch, size_t slice, int nx, int ny, int nz,
+                         int zOffset) {
+  int x = blockIdx.x * blockDim.x + threadIdx.x;
+  int y = blockIdx.y * blockDim.y + threadIdx.y;
+  if (x >= nx || y >= ny) return;
+  for (int z = 0; z < nz; z++) {
+    grid[z * slice + y * pitch + x] = sinf(0.01f * x) + cosf(0.02f * y) + 0.001f * (z + zOffset);
+  }
+}
+
+// Interior points only, the outermost ring keeps its values
+__global__ void stencil2D(float* out, const float* in, size_t pitch, int nx, int ny) {
+  int x = blockIdx.x * tileX + threadIdx.x + 1;
+  int y = blockIdx.y * tileY + threadIdx.y + 1;
+  if (x >= nx - 1 || y >= ny - 1) return;
+  const float* c = &in[y * pitch + x];
+  out[y * pitch + x] = stencil5(c[0], c[-1], c[1], c[-static_cast<ptrdiff_t>(pitch)], c[pitch]);
+}
+
+__global__ void stencil2DLds(float* out, const float* in, size_t pitch, int nx, int ny) {
+  __shared__ float tile[tileY + 2][tileX + 2];
+  int tx = threadIdx.x + 1;
+  int ty = threadIdx.y + 1;
+  int x = blockIdx.x * tileX + tx;
+  int y = blockIdx.y * tileY + ty;
+  if (x < nx && y < ny) {
+    tile[ty][tx] = in[y * pitch + x];
+    if (threadIdx.x == 0) tile[ty][0] = in[y * pitch + x - 1];
+    if (threadIdx.x == tileX - 1 && x + 1 < nx) tile[ty][tx + 1] = in[y * pitch + x + 1];
+    if (threadIdx.y == 0) tile[0][tx] = in[(y - 1) * pitch + x];
+    if (threadIdx.y == tileY - 1 && y + 1 < ny) tile[ty + 1][tx] = in[(y + 1) * pitch + x];
+  }
+  __syncthreads();
+  if (x >= nx - 1 || y >= ny - 1) return;
+  out[y * pitch + x] = stencil5(tile[ty][tx], tile[ty][tx - 1], tile[ty][tx + 1], tile[ty - 1][tx],
+                                tile[ty + 1][tx]);
+}
+
+// Planes [z0, z1), one per grid z
+__global__ void stencil3D(float* out, const float* in, size_t pitch, size_t slice, int nx, int ny,
+                          int z0) {
+  int x = blockIdx.x * tileX + threadIdx.x + 1;
+  int y = blockIdx.y * tileY + threadIdx.y + 1;
+  int z = z0 + blockIdx.z;
+  if (x >= nx - 1 || y >= ny - 1) return;
+  const float* c = &in[z * slice + y * pitch + x];
+  out[z * slice + y * pitch + x] =
+      stencil7(c[0], c[-1], c[1], c[-static_cast<ptrdiff_t>(pitch)], c[pitch],
+               c[-static_cast<ptrdiff_t>(slice)], c[slice]);
+}
+
+// Planes [z0, z1) marching along z, the xy neighbours from LDS
+__global__ void stencil3DLds(float* out, const float* in, size_t pitch, size_t slice, int nx,
+                             int ny, int z0, int z1) {
+  __shared__ float tile[tileY + 2][tileX + 2];
+  int tx = threadIdx.x + 1;
+  int ty = threadIdx.y + 1;
+  int x = blockIdx.x * tileX + tx;
+  int y = blockIdx.y * tileY + ty;
+  bool load = x < nx && y < ny;
+  bool store = x < nx - 1 && y < ny - 1;
+  size_t idx = load ? z0 * slice + y * pitch + x : 0;
+  float below = load ? in[idx - slice] : 0.0f;
+  float current = load ? in[idx] : 0.0f;
+  for (int z = z0; z < z1; z++) {
+    float above = load ? in[idx + slice] : 0.0f;
+    if (load) {
+      tile[ty][tx] = current;
+      if (threadIdx.x == 0) tile[ty][0] = in[idx - 1];
+      if (threadIdx.x == tileX - 1 && x + 1 < nx) tile[ty][tx + 1] = in[idx + 1];
+      if (threadIdx.y == 0) tile[0][tx] = in[idx - pitch];
+      if (threadIdx.y == tileY - 1 && y + 1 < ny) tile[ty + 1][tx] = in[idx + pitch];
+    }
+    __syncthreads();
+    if (store) {
+      out[idx] = stencil7(current, tile[ty][tx - 1], tile[ty][tx + 1], tile[ty - 1][tx],
+                          tile[ty + 1][tx], below, above);
+    }
+    __syncthreads();
+    below = current;
+    current = above;
+    idx += slice;
+  }
+}
+
+static dim3 interiorGrid(int nx, int ny, int nz) {
+  return dim3((nx - 2 + tileX - 1) / tileX, (ny - 2 + tileY - 1) / tileY, nz);
+}
+
+class hipPerfStencil : public HipPerf::Benchmark {
+ public:
+  hipPerfStencil() : HipPerf::Benchmark("hipPerfStencil"), sweeps_(HipPerf::iterationCount(20)),
+      numGpus_(0), stream_(nullptr), serial_(0) {
+    HIPCHECK(hipGetDeviceCount(&numGpus_));
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override { HIPCHECK(hipStreamDestroy(stream_)); }
+
+  unsigned int numTests() override { return numStencilTests; }
+
+  void run(unsigned int test) override {
+    StencilTest kind = static_cast<StencilTest>(test);
+    if (kind >= testMultiSerial) {
+      runMulti(test, kind == testMultiOverlap);
+      return;
+    }
+    bool is3D = kind >= test3D;
+    bool lds = kind == test2DLds || kind == test3DLds;
+    int nx = is3D ? edge3D : edge2D;
+    int ny = nx;
+    int nz = is3D ? edge3D : 1;
+
+    // Element pitches; the 2D grid is a single slice
+    float* grid[3];
+    size_t pitch = 0, slice;
+    if (is3D) {
+      for (auto& g : grid) {
+        hipPitchedPtr p;
+        HIPCHECK(hipMalloc3D(&p, make_hipExtent(nx * sizeof(float), ny, nz)));
+        g = static_cast<float*>(p.ptr);
+        pitch = p.pitch / sizeof(float);
+      }
+    } else {
+      for (auto& g : grid) {
+        size_t bytes;
+        HIPCHECK(hipMallocPitch(reinterpret_cast<void**>(&g), &bytes, nx * sizeof(float), ny));
+        pitch = bytes / sizeof(float);
+      }
+    }
+    slice = pitch * ny;
+    for (auto g : grid) {
+      hipLaunchKernelGGL(initGrid, dim3((nx + 31) / 32, (ny + 7) / 8), dim3(32, 8), 0, stream_, g,
+                         pitch, slice, nx, ny, nz, 0);
+    }
+
+    auto sweep = [&](bool useLds, float* out, const float* in) {
+      if (!is3D && !useLds) {
+        hipLaunchKernelGGL(stencil2D, interiorGrid(nx, ny, 1), dim3(tileX, tileY), 0, stream_,
+                           out, in, pitch, nx, ny);
+      } else if (!is3D) {
+        hipLaunchKernelGGL(stencil2DLds, interiorGrid(nx, ny, 1), dim3(tileX, tileY), 0, stream_,
+                           out, in, pitch, nx, ny);
+      } else if (!useLds) {
+        hipLaunchKernelGGL(stencil3D, interiorGrid(nx, ny, nz - 2), dim3(tileX, tileY), 0,
+                           stream_, out, in, pitch, slice, nx, ny, 1);
+      } else {
+        hipLaunchKernelGGL(stencil3DLds, interiorGrid(nx, ny, 1), dim3(tileX, tileY), 0, stream_,
+                           out, in, pitch, slice, nx, ny, 1, nz - 1);
+      }
+    };
+
+    if (lds) {
+      // Same sums in the same order, so the results match exactly
+      sweep(false, grid[1], grid[0]);
+      sweep(true, grid[2], grid[0]);
+      HIPCHECK(hipStreamSynchronize(stream_));
+      std::vector<float> expected(slice * nz), actual(slice * nz);
+      HIPCHECK(hipMemcpy(expected.data(), grid[1], slice * nz * sizeof(float),
+                         hipMemcpyDeviceToHost));
+      HIPCHECK(hipMemcpy(actual.data(), grid[2], slice * nz * sizeof(float),
+                         hipMemcpyDeviceToHost));
+      for (int z = 0; z < nz; z++) {
+        for (int y = 0; y < ny; y++) {
+          for (int x = 0; x < nx; x++) {
+            size_t i = z * slice + y * pitch + x;
+            if (actual[i] != expected[i]) {
+              failed("%s: point (%d, %d, %d) is %f, expected %f", stencilTestStr[kind], x, y, z,
+                     actual[i], expected[i]);
+            }
+          }
+        }
+      }
+    }
+
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < sweeps_; i++) {
+        sweep(lds, grid[(i + 1) % 2], grid[i % 2]);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    for (auto g : grid) {
+      HIPCHECK(hipFree(g));
+    }
+
+    double points = static_cast<double>(nx - 2) * (ny - 2) * (is3D ? nz - 2 : 1);
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%-36s %ux%ux%u", stencilTestStr[kind], nx, ny, nz);
+    report(test, desc, slice * nz * sizeof(float), sweeps_, "Gpoints/s",
+           HipPerf::toBandwidth(sec, points * sweeps_));
+  }
+
+ private:
+  // Slab of device d: planes 1..edge3D are its own, 0 and edge3D + 1 the halos
+  void runMulti(unsigned int test, bool overlap) {
+    if (numGpus_ < 2) {
+      printf("info: halo exchange needs at least 2 devices, skipping\n");
+      return;
+    }
+    const int nx = edge3D, ny = edge3D, nz = edge3D + 2;
+    std::vector<float*> grid[2];
+    std::vector<hipStream_t> boundary(numGpus_), interior(numGpus_);
+    std::vector<hipEvent_t> interiorDone(numGpus_), sweepDone(numGpus_);
+    size_t pitch = 0;
+    for (int d = 0; d < numGpus_; d++) {
+      HIPCHECK(hipSetDevice(d));
+      for (int b = 0; b < 2; b++) {
+        hipPitchedPtr p;
+        HIPCHECK(hipMalloc3D(&p, make_hipExtent(nx * sizeof(float), ny, nz)));
+        grid[b].push_back(static_cast<float*>(p.ptr));
+        pitch = p.pitch / sizeof(float);
+      }
+      HIPCHECK(hipStreamCreateWithFlags(&boundary[d], hipStreamNonBlocking));
+      HIPCHECK(hipStreamCreateWithFlags(&interior[d], hipStreamNonBlocking));
+      HIPCHECK(hipEventCreateWithFlags(&interiorDone[d], hipEventDisableTiming));
+      HIPCHECK(hipEventCreateWithFlags(&sweepDone[d], hipEventDisableTiming));
+      // Copies take the direct path where there is one
+      for (int peer = d - 1; peer <= d + 1; peer += 2) {
+        int canAccess = 0;
+        if (peer >= 0 && peer < numGpus_) {
+          HIPCHECK(hipDeviceCanAccessPeer(&canAccess, d, peer));
+        }
+        if (canAccess) {
+          // Enabled by the test before
+          hipError_t err = hipDeviceEnablePeerAccess(peer, 0);
+          if (err == hipErrorPeerAccessAlreadyEnabled) {
+            (void)hipGetLastError();
+          } else {
+            HIPCHECK(err);
+          }
+        }
+      }
+    }
+    size_t slice = pitch * ny;
+    size_t plane = slice * sizeof(float);
+    for (int d = 0; d < numGpus_; d++) {
+      HIPCHECK(hipSetDevice(d));
+      for (int b = 0; b < 2; b++) {
+        hipLaunchKernelGGL(initGrid, dim3((nx + 31) / 32, (ny + 7) / 8), dim3(32, 8), 0,
+                           boundary[d], grid[b][d], pitch, slice, nx, ny, nz, d * edge3D);
+      }
+      HIPCHECK(hipEventRecord(sweepDone[d], boundary[d]));
+    }
+
+    auto planes = [&](int d, hipStream_t stream, float* out, const float* in, int z0, int z1) {
+      hipLaunchKernelGGL(stencil3DLds, interiorGrid(nx, ny, 1), dim3(tileX, tileY), 0, stream,
+                         out, in, pitch, slice, nx, ny, z0, z1);
+    };
+    auto sweep = [&](unsigned int i) {
+      float** out = grid[(i + 1) % 2].data();
+      float** in = grid[i % 2].data();
+      // All waits on the previous sweep are enqueued before any device records this one
+      for (int d = 0; d < numGpus_; d++) {
+        HIPCHECK(hipSetDevice(d));
+        for (int peer = d - 1; peer <= d + 1; peer++) {
+          if (peer >= 0 && peer < numGpus_) {
+            HIPCHECK(hipStreamWaitEvent(boundary[d], sweepDone[peer], 0));
+          }
+        }
+        HIPCHECK(hipStreamWaitEvent(interior[d], sweepDone[d], 0));
+      }
+      for (int d = 0; d < numGpus_; d++) {
+        HIPCHECK(hipSetDevice(d));
+        if (overlap) {
+          planes(d, boundary[d], out[d], in[d], 1, 2);
+          planes(d, boundary[d], out[d], in[d], edge3D, edge3D + 1);
+          planes(d, interior[d], out[d], in[d], 2, edge3D);
+        } else {
+          planes(d, boundary[d], out[d], in[d], 1, edge3D + 1);
+        }
+        // First own plane into the lower neighbour's upper halo and the other way round
+        if (d > 0) {
+          HIPCHECK(hipMemcpyPeerAsync(out[d - 1] + (edge3D + 1) * slice, d - 1, out[d] + slice, d,
+                                      plane, boundary[d]));
+        }
+        if (d < numGpus_ - 1) {
+          HIPCHECK(hipMemcpyPeerAsync(out[d + 1], d + 1, out[d] + edge3D * slice, d, plane,
+                                      boundary[d]));
+        }
+        if (overlap) {
+          HIPCHECK(hipEventRecord(interiorDone[d], interior[d]));
+          HIPCHECK(hipStreamWaitEvent(boundary[d], interiorDone[d], 0));
+        }
+        HIPCHECK(hipEventRecord(sweepDone[d], boundary[d]));
+      }
+    };
+
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < sweeps_; i++) {
+        sweep(i);
+      }
+      for (int d = 0; d < numGpus_; d++) {
+        HIPCHECK(hipStreamSynchronize(boundary[d]));
+      }
+    });
+
+    for (int d = 0; d < numGpus_; d++) {
+      HIPCHECK(hipSetDevice(d));
+      HIPCHECK(hipFree(grid[0][d]));
+      HIPCHECK(hipFree(grid[1][d]));
+      HIPCHECK(hipEventDestroy(sweepDone[d]));
+      HIPCHECK(hipEventDestroy(interiorDone[d]));
+      HIPCHECK(hipStreamDestroy(interior[d]));
+      HIPCHECK(hipStreamDestroy(boundary[d]));
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+
+    double points = static_cast<double>(nx - 2) * (ny - 2) * edge3D * numGpus_;
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%-36s %d devices", stencilTestStr[test], numGpus_);
+    size_t bytes = plane * nz * numGpus_;
+    report(test, desc, bytes, sweeps_, "Gpoints/s", HipPerf::toBandwidth(sec, points * sweeps_));
+    report(test, desc, bytes, sweeps_, "us", HipPerf::toMicroseconds(sec, sweeps_));
+
+    // The serial test runs first
+    double median = ComputePerfStats(sec).median;
+    if (!overlap) {
+      serial_ = median;
+    } else if (serial_ > 0) {
+      report(test, std::string(desc) + " vs serial", bytes, sweeps_, "x", {serial_ / median});
+    }
+  }
+
+  unsigned int sweeps_;  // per repetition
+  int numGpus_;
+  hipStream_t stream_;
+  double serial_;  // median seconds of the serial multi-GPU test
+};
+
+HIP_PERF_BENCHMARK(hipPerfStencil)
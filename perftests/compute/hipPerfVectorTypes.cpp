@@ -0,0 +1,261 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Whether HIP vector types generate wider loads and packed arithmetic than
+// plain aggregates of the same size. float4, float2 and double2 are compared
+// against structs of scalar members and structs wrapping an array, and for
+// 16 bytes also a struct of four floats declared alignas(16). The memory
+// test is a grid-stride out[i] = in[i] * a + b over 256 MB per buffer in
+// GB/s; the ALU test runs four independent multiply-add chains per thread
+// in registers in GFLOP/s. Both report the ratio to the HIP vector type of
+// the same size, which runs first in its group.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+struct Float4Struct {
+  float x, y, z, w;
+};
+struct alignas(16) Float4Aligned {
+  float x, y, z, w;
+};
+struct Float4Array {
+  float v[4];
+};
+struct Float2Struct {
+  float x, y;
+};
+struct Float2Array {
+  float v[2];
+};
+struct Double2Struct {
+  double x, y;
+};
+struct Double2Array {
+  double v[2];
+};
+
+// v * s + b per component, through vector operators for the HIP types
+__device__ inline float4 madd(float4 v, float s, float b) {
+  return v * make_float4(s, s, s, s) + make_float4(b, b, b, b);
+}
+__device__ inline float2 madd(float2 v, float s, float b) {
+  return v * make_float2(s, s) + make_float2(b, b);
+}
+__device__ inline double2 madd(double2 v, double s, double b) {
+  return v * make_double2(s, s) + make_double2(b, b);
+}
+template <typename T> __device__ inline T maddMembers(T v, decltype(v.x) s, decltype(v.x) b) {
+  v.x = v.x * s + b;
+  v.y = v.y * s + b;
+  return v;
+}
+__device__ inline Float4Struct madd(Float4Struct v, float s, float b) {
+  v = maddMembers(v, s, b);
+  v.z = v.z * s + b;
+  v.w = v.w * s + b;
+  return v;
+}
+__device__ inline Float4Aligned madd(Float4Aligned v, float s, float b) {
+  v = maddMembers(v, s, b);
+  v.z = v.z * s + b;
+  v.w = v.w * s + b;
+  return v;
+}
+__device__ inline Float2Struct madd(Float2Struct v, float s, float b) {
+  return maddMembers(v, s, b);
+}
+__device__ inline Double2Struct madd(Double2Struct v, double s, double b) {
+  return maddMembers(v, s, b);
+}
+template <typename T> __device__ inline T maddArray(T v, decltype(+v.v[0]) s,
+                                                    decltype(+v.v[0]) b) {
+  for (unsigned int k = 0; k < sizeof(v.v) / sizeof(v.v[0]); k++) {
+    v.v[k] = v.v[k] * s + b;
+  }
+  return v;
+}
+__device__ inline Float4Array madd(Float4Array v, float s, float b) {
+  return maddArray(v, s, b);
+}
+__device__ inline Float2Array madd(Float2Array v, float s, float b) {
+  return maddArray(v, s, b);
+}
+__device__ inline Double2Array madd(Double2Array v, double s, double b) {
+  return maddArray(v, s, b);
+}
+
+// Every component of a T set to x
+template <typename T> __device__ inline T splat(float x) { return madd(T{}, 0.0f, x); }
+
+template <typename T> __global__ void streamMadd(const T* in, T* out, size_t n) {
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < n;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    out[i] = madd(in[i], 0.5f, 1.0f);
+  }
+}
+
+template <typename T> __global__ void chainMadd(unsigned int iterations, T* out) {
+  size_t tid = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  T v0 = splat<T>(static_cast<float>(tid % 1021) / 1024);
+  T v1 = splat<T>(static_cast<float>(tid % 1019) / 1024);
+  T v2 = splat<T>(static_cast<float>(tid % 1013) / 1024);
+  T v3 = splat<T>(static_cast<float>(tid % 1009) / 1024);
+  for (unsigned int i = 0; i < iterations; i++) {
+    v0 = madd(v0, 0.999f, 0.001f);
+    v1 = madd(v1, 0.999f, 0.001f);
+    v2 = madd(v2, 0.999f, 0.001f);
+    v3 = madd(v3, 0.999f, 0.001f);
+  }
+  out[4 * tid + 0] = v0;
+  out[4 * tid + 1] = v1;
+  out[4 * tid + 2] = v2;
+  out[4 * tid + 3] = v3;
+}
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const size_t bufferBytes = 256 * 1024 * 1024;
+
+typedef void (*StreamLaunch)(dim3 grid, const void* in, void* out);
+typedef void (*ChainLaunch)(dim3 grid, unsigned int iterations, void* out);
+
+template <typename T> static void launchStream(dim3 grid, const void* in, void* out) {
+  hipLaunchKernelGGL(streamMadd<T>, grid, dim3(blockSize), 0, 0, static_cast<const T*>(in),
+                     static_cast<T*>(out), bufferBytes / sizeof(T));
+}
+
+template <typename T> static void launchChain(dim3 grid, unsigned int iterations, void* out) {
+  hipLaunchKernelGGL(chainMadd<T>, grid, dim3(blockSize), 0, 0, iterations,
+                     static_cast<T*>(out));
+}
+
+struct VectorType {
+  const char* name;
+  size_t bytes;
+  unsigned int components;
+  bool reference;  // HIP vector type, first of its size
+  StreamLaunch stream;
+  ChainLaunch chain;
+};
+
+#define VECTOR_TYPE(T, COMPONENTS, REFERENCE) \
+  {#T, sizeof(T), COMPONENTS, REFERENCE, launchStream<T>, launchChain<T>}
+
+static const VectorType vectorTypes[] = {
+    VECTOR_TYPE(float4, 4, true),        VECTOR_TYPE(Float4Struct, 4, false),
+    VECTOR_TYPE(Float4Aligned, 4, false), VECTOR_TYPE(Float4Array, 4, false),
+    VECTOR_TYPE(float2, 2, true),        VECTOR_TYPE(Float2Struct, 2, false),
+    VECTOR_TYPE(Float2Array, 2, false),  VECTOR_TYPE(double2, 2, true),
+    VECTOR_TYPE(Double2Struct, 2, false), VECTOR_TYPE(Double2Array, 2, false)};
+
+#undef VECTOR_TYPE
+
+static const unsigned int numVectorTypes = sizeof(vectorTypes) / sizeof(vectorTypes[0]);
+
+enum VectorTest { testMemory = 0, testAlu, numVectorTests };
+
+class hipPerfVectorTypes : public HipPerf::Benchmark {
+ public:
+  hipPerfVectorTypes() : HipPerf::Benchmark("hipPerfVectorTypes"),
+      iterations_(HipPerf::iterationCount(4096)), in_(nullptr), out_(nullptr) {
+    reference_[testMemory] = reference_[testAlu] = 0;
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    size_t chainBytes = static_cast<size_t>(grid_.x) * blockSize * 4 * 16;
+    HIPCHECK(hipMalloc(&in_, bufferBytes));
+    HIPCHECK(hipMalloc(&out_, std::max(bufferBytes, chainBytes)));
+    HIPCHECK(hipMemset(in_, 0, bufferBytes));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(in_));
+    HIPCHECK(hipFree(out_));
+  }
+
+  unsigned int numTests() override { return numVectorTypes * numVectorTests; }
+
+  void run(unsigned int test) override {
+    const VectorType& type = vectorTypes[test % numVectorTypes];
+    VectorTest kind = static_cast<VectorTest>(test / numVectorTypes);
+
+    auto sec = measure([&]() {
+      if (kind == testMemory) {
+        type.stream(grid_, in_, out_);
+      } else {
+        type.chain(grid_, iterations_, out_);
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    std::vector<double> values;
+    const char* unit = "GB/s";
+    if (kind == testMemory) {
+      values = HipPerf::toBandwidth(sec, 2.0 * bufferBytes);
+    } else {
+      // Multiply and add per component of four chains
+      double flops = static_cast<double>(grid_.x) * blockSize * iterations_ * 4 *
+          type.components * 2;
+      for (double s : sec) {
+        values.push_back(flops / s * 1e-9);
+      }
+      unit = "GFLOP/s";
+    }
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%-14s %2zu B %s", type.name, type.bytes,
+             kind == testMemory ? "load/store" : "multiply-add");
+    report(test, desc, type.bytes, kind == testMemory ? 1 : iterations_, unit, values);
+
+    std::vector<double> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    if (type.reference) {
+      reference_[kind] = sorted[sorted.size() / 2];
+    } else if (reference_[kind] > 0) {
+      std::vector<double> ratio;
+      for (double v : values) {
+        ratio.push_back(v / reference_[kind]);
+      }
+      report(test, std::string(desc) + " vs vector type", type.bytes,
+             kind == testMemory ? 1 : iterations_, "x", ratio);
+    }
+  }
+
+ private:
+  unsigned int iterations_;  // per thread, four chains each
+  void* in_;
+  void* out_;
+  dim3 grid_;
+  double reference_[numVectorTests];  // median of the last HIP vector type
+};
+
+HIP_PERF_BENCHMARK(hipPerfVectorTypes)
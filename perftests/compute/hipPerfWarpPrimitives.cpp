@@ -0,0 +1,192 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Latency and throughput of the wave level primitives: __shfl, __shfl_up,
+// __shfl_down, __shfl_xor, __ballot, __any, __all and mbcnt, next to the same
+// neighbour exchange through LDS with barriers. Latency is a single wave
+// running one dependent chain, reported in cycles per operation at the
+// clockRate of the device properties; throughput is many single wave blocks
+// running four independent chains each, reported in wave operations per
+// cycle per CU. Results are for the wave size the binary was compiled for;
+// on targets supporting both, build with -mwavefrontsize64 or
+// -mno-wavefrontsize64 to measure the other one.
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+
+enum WarpOp {
+  opShfl = 0,
+  opShflUp,
+  opShflDown,
+  opShflXor,
+  opBallot,
+  opAny,
+  opAll,
+  opMbcnt,
+  opLdsExchange,
+  numWarpOps
+};
+
+static const char* warpOpStr[numWarpOps] = {"__shfl",   "__shfl_up", "__shfl_down",
+                                            "__shfl_xor", "__ballot", "__any",
+                                            "__all",    "mbcnt",     "LDS exchange"};
+
+enum WarpMode { modeLatency = 0, modeThroughput, numWarpModes };
+
+static const unsigned int maxWarpSize = 64;
+static const unsigned int blocksPerCu = 32;
+
+// Number of set bits of mask in the lanes below this one
+__device__ inline int maskedBitCount(unsigned long long mask) {
+#ifdef __HIP_PLATFORM_AMD__
+  unsigned int low = __builtin_amdgcn_mbcnt_lo(static_cast<unsigned int>(mask), 0);
+  return warpSize == 64 ? __builtin_amdgcn_mbcnt_hi(static_cast<unsigned int>(mask >> 32), low)
+                        : low;
+#else
+  return __popc(static_cast<unsigned int>(mask) & ((1u << (threadIdx.x % warpSize)) - 1));
+#endif
+}
+
+// Blocks are a single wave. Every op depends on the previous one of its chain.
+template <WarpOp O, int Chains>
+__global__ void warpKernel(unsigned int iterations, int* out) {
+  __shared__ int lds[Chains][maxWarpSize];
+  const int lane = threadIdx.x;
+  const int src = (lane + 1) % warpSize;
+  int v[Chains];
+#pragma unroll
+  for (int c = 0; c < Chains; c++) {
+    v[c] = lane + c;
+  }
+  for (unsigned int i = 0; i < iterations; i++) {
+    if (O == opLdsExchange) {
+#pragma unroll
+      for (int c = 0; c < Chains; c++) {
+        lds[c][lane] = v[c];
+      }
+      __syncthreads();
+#pragma unroll
+      for (int c = 0; c < Chains; c++) {
+        v[c] = lds[c][src];
+      }
+      __syncthreads();
+      continue;
+    }
+#pragma unroll
+    for (int c = 0; c < Chains; c++) {
+      switch (O) {
+        case opShfl: v[c] = __shfl(v[c], src); break;
+        case opShflUp: v[c] = __shfl_up(v[c], 1); break;
+        case opShflDown: v[c] = __shfl_down(v[c], 1); break;
+        case opShflXor: v[c] = __shfl_xor(v[c], 1); break;
+        case opBallot: v[c] += static_cast<int>(__ballot(v[c] & 1)); break;
+        case opAny: v[c] += __any(v[c] & 1); break;
+        case opAll: v[c] += __all(v[c] & 1); break;
+        default: v[c] += maskedBitCount(static_cast<unsigned int>(v[c]) * 0x9E3779B97F4A7C15ull);
+      }
+    }
+  }
+  int sum = 0;
+#pragma unroll
+  for (int c = 0; c < Chains; c++) {
+    sum += v[c];
+  }
+  out[blockIdx.x * blockDim.x + lane] = sum;
+}
+
+typedef void (*WarpLaunch)(unsigned int iterations, int* out, dim3 grid, unsigned int waveSize);
+
+template <WarpOp O, int Chains>
+static void launchWarp(unsigned int iterations, int* out, dim3 grid, unsigned int waveSize) {
+  hipLaunchKernelGGL((warpKernel<O, Chains>), grid, dim3(waveSize), 0, 0, iterations, out);
+}
+
+template <int Chains> static WarpLaunch launchFor(WarpOp op) {
+  switch (op) {
+    case opShfl: return launchWarp<opShfl, Chains>;
+    case opShflUp: return launchWarp<opShflUp, Chains>;
+    case opShflDown: return launchWarp<opShflDown, Chains>;
+    case opShflXor: return launchWarp<opShflXor, Chains>;
+    case opBallot: return launchWarp<opBallot, Chains>;
+    case opAny: return launchWarp<opAny, Chains>;
+    case opAll: return launchWarp<opAll, Chains>;
+    case opMbcnt: return launchWarp<opMbcnt, Chains>;
+    default: return launchWarp<opLdsExchange, Chains>;
+  }
+}
+
+class hipPerfWarpPrimitives : public HipPerf::Benchmark {
+ public:
+  hipPerfWarpPrimitives() : HipPerf::Benchmark("hipPerfWarpPrimitives"),
+      iterations_(HipPerf::iterationCount(100000)), out_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipMalloc(&out_, sizeof(int) * maxWarpSize * blocksPerCu *
+                                  props_.multiProcessorCount));
+  }
+
+  void close() override { HIPCHECK(hipFree(out_)); }
+
+  unsigned int numTests() override { return numWarpOps * numWarpModes; }
+
+  void run(unsigned int test) override {
+    WarpOp op = static_cast<WarpOp>(test % numWarpOps);
+    WarpMode mode = static_cast<WarpMode>(test / numWarpOps);
+    unsigned int waveSize = props_.warpSize;
+    dim3 grid(mode == modeLatency ? 1 : props_.multiProcessorCount * blocksPerCu);
+    WarpLaunch launch = mode == modeLatency ? launchFor<1>(op) : launchFor<4>(op);
+
+    auto sec = measure([&]() {
+      launch(iterations_, out_, grid, waveSize);
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    // clockRate is in kHz
+    double hz = props_.clockRate * 1e3;
+    std::vector<double> values;
+    for (double s : sec) {
+      if (mode == modeLatency) {
+        values.push_back(s * hz / iterations_);
+      } else {
+        double waveOps = static_cast<double>(grid.x) * iterations_ * 4;
+        values.push_back(waveOps / (s * hz) / props_.multiProcessorCount);
+      }
+    }
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%-12s wave%u %s", warpOpStr[op], waveSize,
+             mode == modeLatency ? "latency" : "throughput");
+    report(test, desc, 0, iterations_, mode == modeLatency ? "cycles/op" : "wave ops/cycle/CU",
+           values);
+  }
+
+ private:
+  unsigned int iterations_;
+  int* out_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfWarpPrimitives)
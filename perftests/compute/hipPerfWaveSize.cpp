@@ -0,0 +1,235 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Wave64 against wave32 for the same kernels, built with hiprtc with
+// -mwavefrontsize64 and -mno-wavefrontsize64: a shuffle and LDS block
+// reduction, a shuffle heavy warp inclusive scan and a kernel whose lanes
+// branch eight ways with different trip counts. The kernels use warpSize, so
+// both builds do the same work. Wave32 only runs on architectures that
+// support both modes (gfx10 and later); a build whose warpSize does not match
+// the requested mode is skipped. Reports Gelements/s and, for wave32, the
+// ratio to the wave64 build of the same kernel.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <hip/hiprtc.h>
+
+#include "perf_harness.h"
+
+static const char* kernelSource = R"(
+extern "C" __global__ void waveSize(int* out) {
+  if (threadIdx.x == 0 && blockIdx.x == 0) *out = warpSize;
+}
+
+// Block sum through warp shuffles, one partial per warp in LDS
+extern "C" __global__ void reduction(float* out, const float* in, size_t n) {
+  __shared__ float partial[32];
+  size_t i = blockIdx.x * (size_t)blockDim.x + threadIdx.x;
+  float v = i < n ? in[i] : 0.0f;
+  for (int offset = warpSize / 2; offset > 0; offset /= 2) v += __shfl_down(v, offset);
+  int lane = threadIdx.x % warpSize;
+  int warp = threadIdx.x / warpSize;
+  if (lane == 0) partial[warp] = v;
+  __syncthreads();
+  int warps = blockDim.x / warpSize;
+  if (warp == 0) {
+    v = lane < warps ? partial[lane] : 0.0f;
+    for (int offset = warpSize / 2; offset > 0; offset /= 2) v += __shfl_down(v, offset);
+    if (lane == 0) out[blockIdx.x] = v;
+  }
+}
+
+// Inclusive warp scan repeated over ROUNDS values per thread
+extern "C" __global__ void scan(float* out, const float* in, size_t n) {
+  size_t i = blockIdx.x * (size_t)blockDim.x + threadIdx.x;
+  if (i >= n) return;
+  int lane = threadIdx.x % warpSize;
+  float carry = 0.0f;
+  float v = in[i];
+  for (int r = 0; r < ROUNDS; r++) {
+    for (int offset = 1; offset < warpSize; offset *= 2) {
+      float up = __shfl_up(v, offset);
+      if (lane >= offset) v += up;
+    }
+    carry += __shfl(v, warpSize - 1);
+    v = v * 0.5f + carry;
+  }
+  out[i] = v;
+}
+
+// Lanes take one of eight paths with different trip counts
+extern "C" __global__ void divergent(float* out, const float* in, size_t n) {
+  size_t i = blockIdx.x * (size_t)blockDim.x + threadIdx.x;
+  if (i >= n) return;
+  float v = in[i];
+  int path = threadIdx.x % 8;
+  switch (path) {
+    case 0: for (int k = 0; k < ROUNDS; k++) v = v * 1.0001f + 0.5f; break;
+    case 1: for (int k = 0; k < 2 * ROUNDS; k++) v = v * 0.9999f - 0.5f; break;
+    case 2: for (int k = 0; k < 3 * ROUNDS; k++) v = sqrtf(v * v + 1.0f); break;
+    case 3: for (int k = 0; k < ROUNDS; k++) v = v * v * 0.5f; break;
+    case 4: for (int k = 0; k < 4 * ROUNDS; k++) v += 1.0f; break;
+    case 5: for (int k = 0; k < ROUNDS / 2; k++) v = fmaf(v, 0.5f, 1.0f); break;
+    case 6: v = -v; break;
+    default: for (int k = 0; k < 2 * ROUNDS; k++) v = v * 0.5f + 0.25f; break;
+  }
+  out[i] = v;
+}
+)";
+
+enum WaveKernel { kernelReduction = 0, kernelScan, kernelDivergent, numWaveKernels };
+static const char* waveKernelStr[numWaveKernels] = {"reduction", "scan", "divergent"};
+
+enum WaveMode { wave64 = 0, wave32, numWaveModes };
+static const char* waveModeStr[numWaveModes] = {"wave64", "wave32"};
+static const int waveModeSize[numWaveModes] = {64, 32};
+static const char* waveModeOption[numWaveModes] = {"-mwavefrontsize64", "-mno-wavefrontsize64"};
+
+static const unsigned int blockSize = 256;
+static const size_t elements = 16 * 1024 * 1024;
+static const int rounds = 16;
+
+class hipPerfWaveSize : public HipPerf::Benchmark {
+ public:
+  hipPerfWaveSize() : HipPerf::Benchmark("hipPerfWaveSize"),
+      launches_(HipPerf::iterationCount(20)), bothModes_(false), in_(nullptr), out_(nullptr),
+      stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    // RDNA (gfx1030, gfx1100, ...) runs either wave size, GCN and CDNA (gfx908, gfx90a,
+    // gfx942, ...) only wave64. Feature flags follow a ':'
+    size_t nameLength = strcspn(props_.gcnArchName, ":");
+    bothModes_ = strncmp(props_.gcnArchName, "gfx", 3) == 0 && nameLength >= 7;
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&in_, elements * sizeof(float)));
+    HIPCHECK(hipMalloc(&out_, elements * sizeof(float)));
+    HIPCHECK(hipMemset(in_, 0, elements * sizeof(float)));
+    baseline_.assign(numWaveKernels, 0.0);
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(in_));
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numWaveKernels * numWaveModes; }
+
+  void run(unsigned int test) override {
+    WaveKernel kernel = static_cast<WaveKernel>(test / numWaveModes);
+    WaveMode mode = static_cast<WaveMode>(test % numWaveModes);
+    if (mode == wave32 && !bothModes_) {
+      printf("info: %s has no wave32 mode, skipping %s\n", props_.gcnArchName,
+             waveKernelStr[kernel]);
+      return;
+    }
+
+    hipModule_t module = buildModule(mode);
+    int size = moduleWaveSize(module);
+    if (size != waveModeSize[mode]) {
+      printf("info: %s build runs with warpSize %d, skipping %s\n", waveModeStr[mode], size,
+             waveKernelStr[kernel]);
+      HIPCHECK(hipModuleUnload(module));
+      return;
+    }
+    hipFunction_t function;
+    HIPCHECK(hipModuleGetFunction(&function, module, waveKernelStr[kernel]));
+
+    float* out = out_;
+    const float* in = in_;
+    size_t n = elements;
+    void* params[] = {&out, &in, &n};
+    unsigned int grid = (elements + blockSize - 1) / blockSize;
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < launches_; i++) {
+        HIPCHECK(hipModuleLaunchKernel(function, grid, 1, 1, blockSize, 1, 1, 0, stream_, params,
+                                       nullptr));
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    HIPCHECK(hipModuleUnload(module));
+
+    std::vector<double> rate;
+    for (double s : sec) {
+      rate.push_back(static_cast<double>(elements) * launches_ / s / 1e9);
+    }
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%-9s %s", waveKernelStr[kernel], waveModeStr[mode]);
+    report(test, desc, elements * sizeof(float), launches_, "Gelements/s", rate);
+
+    double median = ComputePerfStats(rate).median;
+    if (mode == wave64) {
+      baseline_[kernel] = median;
+    } else if (baseline_[kernel] > 0) {
+      report(test, std::string(desc) + " vs wave64", elements * sizeof(float), launches_, "x",
+             {median / baseline_[kernel]});
+    }
+  }
+
+ private:
+  hipModule_t buildModule(WaveMode mode) {
+    std::string roundsOption = "-DROUNDS=" + std::to_string(rounds);
+    const char* options[] = {waveModeOption[mode], roundsOption.c_str(), "-O3"};
+
+    hiprtcProgram prog;
+    HIPRTCCHECK(hiprtcCreateProgram(&prog, kernelSource, "wavesize.cu", 0, nullptr, nullptr));
+    HipTest::compileRtcProgram(prog, 3, options);
+    size_t codeSize = 0;
+    HIPRTCCHECK(hiprtcGetCodeSize(prog, &codeSize));
+    std::vector<char> code(codeSize);
+    HIPRTCCHECK(hiprtcGetCode(prog, code.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+    hipModule_t module;
+    HIPCHECK(hipModuleLoadData(&module, code.data()));
+    return module;
+  }
+
+  // warpSize the module's kernels run with
+  int moduleWaveSize(hipModule_t module) {
+    hipFunction_t function;
+    HIPCHECK(hipModuleGetFunction(&function, module, "waveSize"));
+    int* size = reinterpret_cast<int*>(out_);
+    void* params[] = {&size};
+    HIPCHECK(hipModuleLaunchKernel(function, 1, 1, 1, 64, 1, 1, 0, stream_, params, nullptr));
+    int result = 0;
+    HIPCHECK(hipMemcpyAsync(&result, size, sizeof(int), hipMemcpyDeviceToHost, stream_));
+    HIPCHECK(hipStreamSynchronize(stream_));
+    return result;
+  }
+
+  unsigned int launches_;
+  bool bothModes_;
+  std::vector<double> baseline_;  // median wave64 Gelements/s per kernel
+  float* in_;
+  float* out_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfWaveSize)
@@ -0,0 +1,295 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Host cost in ns per call of the device, error, stream and pointer query
+// APIs that applications call on their hot paths, from one thread and from
+// 2..hardware_concurrency threads calling the same API at once. A per call
+// time that grows with the thread count points at a lock in the runtime.
+// hipPointerGetAttributes is measured for device, pinned host, managed,
+// registered host and pageable memory, and for an address inside a large
+// device allocation.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "perf_harness.h"
+
+enum ApiOp {
+  opGetDevice = 0,
+  opSetDevice,
+  opGetDeviceCount,
+  opDeviceGetAttribute,
+  opGetDeviceProperties,
+  opDeviceGetLimit,
+  opDeviceGetCacheConfig,
+  opDeviceGetStreamPriorityRange,
+  opDeviceTotalMem,
+  opDriverGetVersion,
+  opRuntimeGetVersion,
+  opGetLastError,
+  opPeekAtLastError,
+  opStreamQuery,
+  opStreamGetFlags,
+  opStreamGetPriority,
+  opEventQuery,
+  opMemGetInfo,
+  opPointerDevice,
+  opPointerDeviceOffset,
+  opPointerPinned,
+  opPointerManaged,
+  opPointerRegistered,
+  opPointerPageable,
+  numApiOps
+};
+
+static const char* apiOpStr[numApiOps] = {
+    "hipGetDevice",
+    "hipSetDevice",
+    "hipGetDeviceCount",
+    "hipDeviceGetAttribute",
+    "hipGetDeviceProperties",
+    "hipDeviceGetLimit",
+    "hipDeviceGetCacheConfig",
+    "hipDeviceGetStreamPriorityRange",
+    "hipDeviceTotalMem",
+    "hipDriverGetVersion",
+    "hipRuntimeGetVersion",
+    "hipGetLastError",
+    "hipPeekAtLastError",
+    "hipStreamQuery",
+    "hipStreamGetFlags",
+    "hipStreamGetPriority",
+    "hipEventQuery",
+    "hipMemGetInfo",
+    "hipPointerGetAttributes device",
+    "hipPointerGetAttributes device+offset",
+    "hipPointerGetAttributes pinned host",
+    "hipPointerGetAttributes managed",
+    "hipPointerGetAttributes registered host",
+    "hipPointerGetAttributes pageable"};
+
+// Attributes cycled through by opDeviceGetAttribute
+static const hipDeviceAttribute_t queriedAttributes[] = {
+    hipDeviceAttributeMaxThreadsPerBlock, hipDeviceAttributeMultiprocessorCount,
+    hipDeviceAttributeClockRate, hipDeviceAttributeWarpSize};
+
+static const size_t bufferSize = 64 * 1024 * 1024;
+
+class hipPerfApiOverhead : public HipPerf::Benchmark {
+ public:
+  hipPerfApiOverhead() : HipPerf::Benchmark("hipPerfApiOverhead"),
+      calls_(HipPerf::iterationCount(100000)), stream_(nullptr), event_(nullptr) {
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int t = 1; t < maxThreads; t *= 2) {
+      threadCounts_.push_back(t);
+    }
+    threadCounts_.push_back(maxThreads);
+    for (auto& ptr : ptrs_) {
+      ptr = nullptr;
+    }
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipEventCreateWithFlags(&event_, hipEventDisableTiming));
+    HIPCHECK(hipEventRecord(event_, stream_));
+    HIPCHECK(hipStreamSynchronize(stream_));
+
+    HIPCHECK(hipMalloc(&ptrs_[opPointerDevice], bufferSize));
+    ptrs_[opPointerDeviceOffset] = static_cast<char*>(ptrs_[opPointerDevice]) + bufferSize / 2;
+    HIPCHECK(hipHostMalloc(&ptrs_[opPointerPinned], bufferSize));
+    HIPCHECK(hipMallocManaged(&ptrs_[opPointerManaged], bufferSize));
+    ptrs_[opPointerRegistered] = malloc(bufferSize);
+    HIPCHECK(hipHostRegister(ptrs_[opPointerRegistered], bufferSize, hipHostRegisterDefault));
+    ptrs_[opPointerPageable] = malloc(bufferSize);
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(ptrs_[opPointerDevice]));
+    HIPCHECK(hipHostFree(ptrs_[opPointerPinned]));
+    HIPCHECK(hipFree(ptrs_[opPointerManaged]));
+    HIPCHECK(hipHostUnregister(ptrs_[opPointerRegistered]));
+    free(ptrs_[opPointerRegistered]);
+    free(ptrs_[opPointerPageable]);
+    HIPCHECK(hipEventDestroy(event_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numApiOps * threadCounts_.size(); }
+
+  void run(unsigned int test) override {
+    ApiOp op = static_cast<ApiOp>(test % numApiOps);
+    unsigned int numThreads = threadCounts_[test / numApiOps];
+
+    // Pageable memory is unknown to the runtime, some versions report that as an error
+    hipError_t result = call(op, 0);
+    if (op != opPointerPageable) {
+      HIPCHECK(result);
+    }
+    (void)hipGetLastError();
+
+    std::vector<double> ns;
+    if (numThreads == 1) {
+      auto sec = measure([&]() {
+        for (unsigned int i = 0; i < calls_; i++) {
+          (void)call(op, i);
+        }
+      });
+      for (double s : sec) {
+        ns.push_back(s * 1e9 / calls_);
+      }
+    } else {
+      ns = contendedNsPerCall(op, numThreads);
+    }
+    (void)hipGetLastError();
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-40s %3u threads", apiOpStr[op], numThreads);
+    report(test, desc, 0, calls_, "ns", ns);
+  }
+
+ private:
+  // One call of op: its result is returned, not checked, to keep the loop minimal.
+  hipError_t call(ApiOp op, unsigned int i) {
+    switch (op) {
+      case opGetDevice: {
+        int device;
+        return hipGetDevice(&device);
+      }
+      case opSetDevice:
+        return hipSetDevice(deviceId_);
+      case opGetDeviceCount: {
+        int count;
+        return hipGetDeviceCount(&count);
+      }
+      case opDeviceGetAttribute: {
+        int value;
+        const size_t numAttributes = sizeof(queriedAttributes) / sizeof(queriedAttributes[0]);
+        return hipDeviceGetAttribute(&value, queriedAttributes[i % numAttributes], deviceId_);
+      }
+      case opGetDeviceProperties: {
+        hipDeviceProp_t props;
+        return hipGetDeviceProperties(&props, deviceId_);
+      }
+      case opDeviceGetLimit: {
+        size_t value;
+        return hipDeviceGetLimit(&value, hipLimitStackSize);
+      }
+      case opDeviceGetCacheConfig: {
+        hipFuncCache_t config;
+        return hipDeviceGetCacheConfig(&config);
+      }
+      case opDeviceGetStreamPriorityRange: {
+        int least, greatest;
+        return hipDeviceGetStreamPriorityRange(&least, &greatest);
+      }
+      case opDeviceTotalMem: {
+        size_t bytes;
+        return hipDeviceTotalMem(&bytes, deviceId_);
+      }
+      case opDriverGetVersion: {
+        int version;
+        return hipDriverGetVersion(&version);
+      }
+      case opRuntimeGetVersion: {
+        int version;
+        return hipRuntimeGetVersion(&version);
+      }
+      case opGetLastError:
+        return hipGetLastError();
+      case opPeekAtLastError:
+        return hipPeekAtLastError();
+      case opStreamQuery:
+        return hipStreamQuery(stream_);
+      case opStreamGetFlags: {
+        unsigned int flags;
+        return hipStreamGetFlags(stream_, &flags);
+      }
+      case opStreamGetPriority: {
+        int priority;
+        return hipStreamGetPriority(stream_, &priority);
+      }
+      case opEventQuery:
+        return hipEventQuery(event_);
+      case opMemGetInfo: {
+        size_t free, total;
+        return hipMemGetInfo(&free, &total);
+      }
+      default: {
+        hipPointerAttribute_t attributes;
+        return hipPointerGetAttributes(&attributes, ptrs_[op]);
+      }
+    }
+  }
+
+  // Per call time seen by each of numThreads threads calling op at the same
+  // time, one sample per repetition.
+  std::vector<double> contendedNsPerCall(ApiOp op, unsigned int numThreads) {
+    std::vector<double> ns;
+    measure([&]() {
+      std::atomic<unsigned int> ready(0);
+      std::atomic<bool> go(false);
+      std::vector<std::thread> threads;
+      for (unsigned int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&]() {
+          HIPCHECK(hipSetDevice(deviceId_));
+          ready++;
+          while (!go.load(std::memory_order_acquire)) {
+          }
+          for (unsigned int i = 0; i < calls_; i++) {
+            (void)call(op, i);
+          }
+        });
+      }
+      // Thread creation is not part of the call time
+      while (ready.load() != numThreads) {
+      }
+      auto start = std::chrono::steady_clock::now();
+      go.store(true, std::memory_order_release);
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+      if (!HipPerf::Counters::collecting()) {
+        ns.push_back(sec.count() * 1e9 / calls_);
+      }
+    });
+    return HipPerf::measuredSamples(ns);
+  }
+
+  unsigned int calls_;  // per thread
+  std::vector<unsigned int> threadCounts_;
+  hipStream_t stream_;
+  hipEvent_t event_;      // completed
+  void* ptrs_[numApiOps];  // queried pointer of the opPointer* ops
+};
+
+HIP_PERF_BENCHMARK(hipPerfApiOverhead)
@@ -0,0 +1,746 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Replays a recording of HIP API calls, made by preloading libhipApiTrace.so
+// with HIP_API_RECORD set (utils/coverage), against the current runtime.
+// --input <file> selects the recording; without it a built-in one runs: two
+// streams with 1000 steps of an upload, 16 + 4 kernels joined by an event, a
+// download and a synchronize, spaced like a 5 kHz service loop.
+//
+// Calls run in one thread in the order they returned in the recording, so
+// stream order, event waits and synchronizations are the recorded ones.
+// Allocations, streams and events are created by the replay and recorded
+// addresses and handles mapped to them, interior pointers included; pointers
+// the recording did not allocate (pageable host memory) go to scratch
+// buffers, one for each side of a copy. Kernels are replaced by an empty
+// kernel with the recorded grid, block and dynamic shared memory, so the
+// replay measures launch and copy throughput and the API dependencies, not
+// the work of the kernels. Queries, modules, graphs and failed calls are not
+// replayed; they are counted.
+//
+// The unpaced test issues every call as soon as the previous one returned
+// and breaks the time down over the most used APIs, the paced test holds
+// every call until its offset in the recording. Both report the replay time
+// against the recorded one ("x recorded", below 1 is faster). Objects left
+// over at the end of the recording are released after the timed region.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "perf_harness.h"
+#include "../utils/coverage/runtime/hipApiRecord.h"
+
+#define REPLAYED_APIS(X)                                                                           \
+  X(hipMalloc) X(hipMallocManaged) X(hipHostMalloc) X(hipExtMallocWithFlags) X(hipMallocPitch)     \
+  X(hipMalloc3D) X(hipMallocAsync) X(hipHostRegister) X(hipHostUnregister) X(hipFree)              \
+  X(hipHostFree) X(hipFreeAsync) X(hipMemcpy) X(hipMemcpyAsync) X(hipMemcpyWithStream)             \
+  X(hipMemcpyHtoD) X(hipMemcpyDtoH) X(hipMemcpyDtoD) X(hipMemcpyHtoDAsync) X(hipMemcpyDtoHAsync)   \
+  X(hipMemcpyDtoDAsync) X(hipMemcpyPeer) X(hipMemcpyPeerAsync) X(hipMemcpy2D)                      \
+  X(hipMemcpy2DAsync) X(hipMemset) X(hipMemsetAsync) X(hipMemsetD8) X(hipMemsetD16)                \
+  X(hipMemsetD32) X(hipMemsetD8Async) X(hipMemsetD16Async) X(hipMemsetD32Async) X(hipMemset2D)     \
+  X(hipMemset2DAsync) X(hipMemPrefetchAsync) X(hipMemAdvise) X(hipStreamCreate)                    \
+  X(hipStreamCreateWithFlags) X(hipStreamCreateWithPriority) X(hipStreamDestroy)                   \
+  X(hipStreamSynchronize) X(hipStreamQuery) X(hipStreamWaitEvent) X(hipEventCreate)                \
+  X(hipEventCreateWithFlags) X(hipEventRecord) X(hipEventSynchronize) X(hipEventQuery)             \
+  X(hipEventDestroy) X(hipSetDevice) X(hipDeviceSynchronize) X(hipDeviceEnablePeerAccess)          \
+  X(hipLaunchKernel) X(hipModuleLaunchKernel)
+
+#define REPLAY_ID(name) replay_##name,
+enum ReplayApi { REPLAYED_APIS(REPLAY_ID) numReplayApis };
+#undef REPLAY_ID
+
+#define REPLAY_NAME(name) #name,
+static const char* replayApiStr[numReplayApis] = {REPLAYED_APIS(REPLAY_NAME)};
+#undef REPLAY_NAME
+
+enum ReplayMode { replayUnpaced = 0, replayPaced, numReplayModes };
+static const char* replayModeStr[numReplayModes] = {"unpaced", "paced"};
+
+// Scratch buffer of each side of a copy, for addresses the recording did not allocate
+enum ScratchSlot { scratchDst = 0, scratchSrc, numScratchSlots };
+
+// APIs in the unpaced breakdown, by number of calls
+static const size_t breakdownApis = 8;
+
+__global__ void _replayKernel() {}
+
+struct ReplayCall {
+  ReplayApi api;
+  uint64_t offsetNs;  // Start relative to the first call of the recording
+  size_t arg;         // First argument word in Recording::words
+  unsigned int argCount;
+};
+
+struct Recording {
+  std::string name;
+  std::vector<ReplayCall> calls;
+  std::vector<uint64_t> words;
+  uint64_t spanNs = 0;                        // First start to last end
+  std::map<std::string, size_t> notReplayed;  // Calls by API that are not replayed
+  size_t failedCalls = 0;                     // Failed in the recording, not replayed
+
+  void add(ReplayApi api, uint64_t offsetNs, std::initializer_list<uint64_t> args) {
+    calls.push_back({api, offsetNs, words.size(), static_cast<unsigned int>(args.size())});
+    words.insert(words.end(), args);
+  }
+};
+
+// Reads a HIP_API_RECORD file, false if it is not one
+static bool loadRecording(const char* path, Recording& rec) {
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) {
+    printf("error: can not open %s\n", path);
+    return false;
+  }
+  hipApiRecord::FileHeader header;
+  if (fread(&header, sizeof(header), 1, f) != 1 ||
+      memcmp(header.magic, hipApiRecord::kMagic, sizeof(header.magic)) != 0 ||
+      header.version != hipApiRecord::kVersion) {
+    printf("error: %s is not a version %u HIP API recording\n", path, hipApiRecord::kVersion);
+    fclose(f);
+    return false;
+  }
+
+  // Recorded API index -> replayed API, numReplayApis for the others
+  std::vector<std::string> names(header.apiCount);
+  std::vector<ReplayApi> apis(header.apiCount, numReplayApis);
+  for (auto& name : names) {
+    uint8_t length = 0;
+    char text[256];
+    if (fread(&length, 1, 1, f) != 1 || fread(text, 1, length, f) != length) {
+      printf("error: %s: truncated API table\n", path);
+      fclose(f);
+      return false;
+    }
+    name.assign(text, length);
+  }
+  for (size_t i = 0; i < names.size(); i++) {
+    for (int api = 0; api < numReplayApis; api++) {
+      if (names[i] == replayApiStr[api]) apis[i] = static_cast<ReplayApi>(api);
+    }
+  }
+
+  const char* base = strrchr(path, '/');
+  rec.name = base != nullptr ? base + 1 : path;
+  bool first = true;
+  uint64_t startNs = 0, endNs = 0;
+  hipApiRecord::RecordHeader record;
+  uint64_t args[hipApiRecord::kMaxArgs];
+  while (fread(&record, sizeof(record), 1, f) == 1) {
+    if (record.argCount > hipApiRecord::kMaxArgs || record.api >= names.size() ||
+        fread(args, sizeof(uint64_t), record.argCount, f) != record.argCount) {
+      printf("error: %s: corrupt record %zu\n", path, rec.calls.size());
+      fclose(f);
+      return false;
+    }
+    if (first) {
+      startNs = record.startNs;
+      first = false;
+    }
+    endNs = std::max(endNs, record.endNs);
+    if (record.failed) {
+      rec.failedCalls++;
+    } else if (apis[record.api] == numReplayApis) {
+      rec.notReplayed[names[record.api]]++;
+    } else {
+      uint64_t offset = record.startNs > startNs ? record.startNs - startNs : 0;
+      rec.calls.push_back({apis[record.api], offset, rec.words.size(), record.argCount});
+      rec.words.insert(rec.words.end(), args, args + record.argCount);
+    }
+  }
+  fclose(f);
+  rec.spanNs = endNs - startNs;
+  return true;
+}
+
+// Two streams, an event and 1000 steps of a service loop, 200 us apart
+static void buildRecording(Recording& rec) {
+  const uint64_t s0 = 0x10, s1 = 0x11, event = 0x20, pageable = 0x7f0000000000ull;
+  const uint64_t weights = 0x100000000ull, input = 0x140000000ull, output = 0x180000000ull;
+  const uint64_t hostIn = 0x200000000ull, hostOut = 0x240000000ull;
+  const uint64_t inBytes = 4 << 20, outBytes = 1 << 20, weightBytes = 64 << 20;
+  const uint64_t grid = 1024 | 1ull << 32, block = 256 | 1ull << 32;
+  const unsigned int steps = 1000;
+  const uint64_t stepNs = 200000, callNs = 2000;
+
+  rec.name = "built-in service loop";
+  rec.add(replay_hipStreamCreate, 0, {s0});
+  rec.add(replay_hipStreamCreate, 0, {s1});
+  rec.add(replay_hipEventCreateWithFlags, 0, {event, hipEventDisableTiming});
+  rec.add(replay_hipMalloc, 0, {weights, weightBytes});
+  rec.add(replay_hipMalloc, 0, {input, inBytes});
+  rec.add(replay_hipMalloc, 0, {output, outBytes});
+  rec.add(replay_hipHostMalloc, 0, {hostIn, inBytes, 0});
+  rec.add(replay_hipHostMalloc, 0, {hostOut, outBytes, 0});
+  rec.add(replay_hipMemcpy, 0, {weights, pageable, weightBytes, hipMemcpyHostToDevice});
+  uint64_t at = stepNs;
+  for (unsigned int step = 0; step < steps; step++, at += stepNs) {
+    uint64_t t = at;
+    rec.add(replay_hipMemcpyAsync, t, {input, hostIn, inBytes, hipMemcpyHostToDevice, s0});
+    for (int k = 0; k < 16; k++) {
+      rec.add(replay_hipLaunchKernel, t += callNs, {0, grid, 1, block, 1, 0, 0, s0});
+    }
+    rec.add(replay_hipEventRecord, t += callNs, {event, s0});
+    rec.add(replay_hipStreamWaitEvent, t += callNs, {s1, event, 0});
+    for (int k = 0; k < 4; k++) {
+      rec.add(replay_hipLaunchKernel, t += callNs, {0, grid, 1, block, 1, 0, 0, s1});
+    }
+    rec.add(replay_hipMemcpyAsync, t += callNs, {hostOut, output + (step % 4) * 4096,
+                                                 outBytes / 2, hipMemcpyDeviceToHost, s1});
+    rec.add(replay_hipStreamSynchronize, t += callNs, {s1});
+  }
+  for (uint64_t ptr : {weights, input, output}) {
+    rec.add(replay_hipFree, at, {ptr});
+  }
+  rec.add(replay_hipHostFree, at, {hostIn});
+  rec.add(replay_hipHostFree, at, {hostOut});
+  rec.add(replay_hipEventDestroy, at, {event});
+  rec.add(replay_hipStreamDestroy, at, {s0});
+  rec.add(replay_hipStreamDestroy, at, {s1});
+  rec.spanNs = at;
+}
+
+class hipPerfApiReplay : public HipPerf::Benchmark {
+ public:
+  hipPerfApiReplay() : HipPerf::Benchmark("hipPerfApiReplay"), loaded_(false), deviceCount_(1),
+      timeApis_(false), errors_(0), firstErrorApi_(numReplayApis), firstError_(hipSuccess) {
+    for (int s = 0; s < numScratchSlots; s++) {
+      hostScratchSize_[s] = 0;
+      deviceScratch_[s] = nullptr;
+      deviceScratchSize_[s] = 0;
+    }
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipGetDeviceCount(&deviceCount_));
+  }
+
+  void close() override {
+    HIPCHECK(hipSetDevice(deviceId_));
+    for (int s = 0; s < numScratchSlots; s++) {
+      HIPCHECK(hipFree(deviceScratch_[s]));
+      deviceScratch_[s] = nullptr;
+      deviceScratchSize_[s] = 0;
+    }
+  }
+
+  unsigned int numTests() override { return numReplayModes; }
+
+  void run(unsigned int test) override {
+    ReplayMode mode = static_cast<ReplayMode>(test);
+    if (!loaded_) {
+      if (p_input != nullptr) {
+        if (!loadRecording(p_input, rec_)) {
+          failed("can not replay %s", p_input);
+          return;
+        }
+      } else {
+        buildRecording(rec_);
+      }
+      loaded_ = true;
+      printf("info: %s: %zu calls replayed over %.1f ms recorded\n", rec_.name.c_str(),
+             rec_.calls.size(), rec_.spanNs * 1e-6);
+      if (rec_.failedCalls != 0 || !rec_.notReplayed.empty()) {
+        printf("info: not replayed: %zu failed calls", rec_.failedCalls);
+        for (const auto& entry : rec_.notReplayed) {
+          printf(", %s %zu", entry.first.c_str(), entry.second);
+        }
+        printf("\n");
+      }
+    }
+    if (rec_.calls.empty()) {
+      printf("info: %s has no calls to replay, skipping\n", rec_.name.c_str());
+      return;
+    }
+
+    timeApis_ = mode == replayUnpaced;
+    apiNs_.assign(numReplayApis, 0);
+    apiCalls_.assign(numReplayApis, 0);
+    errors_ = 0;
+    std::vector<double> sec;
+    for (unsigned int i = 0; i < p_warmup + p_repetitions; i++) {
+      if (i == p_warmup) {
+        apiNs_.assign(numReplayApis, 0);
+        apiCalls_.assign(numReplayApis, 0);
+      }
+      auto start = std::chrono::steady_clock::now();
+      replay(mode == replayPaced);
+      HIPCHECK(hipDeviceSynchronize());
+      auto stop = std::chrono::steady_clock::now();
+      release();
+      if (i >= p_warmup) sec.push_back(std::chrono::duration<double>(stop - start).count());
+    }
+    if (errors_ != 0) {
+      failed("%zu replayed calls failed, first %s returned %s", errors_,
+             replayApiStr[firstErrorApi_], hipGetErrorString(firstError_));
+    }
+
+    size_t calls = rec_.calls.size();
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%-28s %-8s", rec_.name.c_str(), replayModeStr[mode]);
+    report(test, desc, 0, 1, "us", HipPerf::toMicroseconds(sec, 1));
+    report(test, desc, 0, 1, "Mcalls/s", HipPerf::toBandwidth(sec, calls * 1e3));
+    std::vector<double> ratio;
+    for (double s : sec) {
+      ratio.push_back(s * 1e9 / std::max<uint64_t>(rec_.spanNs, 1));
+    }
+    report(test, desc, 0, 1, "x recorded", ratio, HipPerf::betterLower);
+    if (mode != replayUnpaced) return;
+
+    std::vector<int> order;
+    for (int api = 0; api < numReplayApis; api++) {
+      if (apiCalls_[api] != 0) order.push_back(api);
+    }
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return apiCalls_[a] > apiCalls_[b]; });
+    order.resize(std::min(order.size(), breakdownApis));
+    for (int api : order) {
+      snprintf(desc, sizeof(desc), "%-28s %-8s %s", rec_.name.c_str(), replayModeStr[mode],
+               replayApiStr[api]);
+      report(test, desc, 0, static_cast<unsigned int>(apiCalls_[api] / p_repetitions),
+             "us/call", {apiNs_[api] * 1e-3 / apiCalls_[api]});
+    }
+  }
+
+ private:
+  enum AllocKind { allocDevice, allocHost, allocRegistered };
+
+  struct Allocation {
+    void* ptr;
+    uint64_t size;
+    AllocKind kind;
+  };
+
+  void replay(bool paced) {
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& call : rec_.calls) {
+      if (paced) {
+        auto target = start + std::chrono::nanoseconds(call.offsetNs);
+        auto now = std::chrono::steady_clock::now();
+        // Sleeping overshoots by tens of microseconds, spin for the rest
+        if (target - now > std::chrono::microseconds(200)) {
+          std::this_thread::sleep_for(target - now - std::chrono::microseconds(100));
+        }
+        while (std::chrono::steady_clock::now() < target) {
+        }
+      }
+      if (timeApis_) {
+        auto begin = std::chrono::steady_clock::now();
+        issue(call, &rec_.words[call.arg]);
+        apiNs_[call.api] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - begin).count();
+        apiCalls_[call.api]++;
+      } else {
+        issue(call, &rec_.words[call.arg]);
+      }
+    }
+  }
+
+  void check(hipError_t err, ReplayApi api) {
+    if (err == hipSuccess || err == hipErrorPeerAccessAlreadyEnabled || err == hipErrorNotReady) {
+      return;
+    }
+    if (errors_++ == 0) {
+      firstErrorApi_ = api;
+      firstError_ = err;
+    }
+  }
+
+  void track(uint64_t recorded, void* ptr, uint64_t size, AllocKind kind) {
+    if (ptr != nullptr) allocs_[recorded] = {ptr, size, kind};
+  }
+
+  // Live address of a recorded one, scratch memory for addresses the recording did not allocate.
+  // The source and destination of a copy get separate scratch buffers, so translating one
+  // never reallocates the buffer just returned for the other.
+  void* translate(uint64_t addr, bool device, uint64_t size, ScratchSlot slot = scratchDst) {
+    auto it = allocs_.upper_bound(addr);
+    if (it != allocs_.begin()) {
+      --it;
+      if (addr < it->first + it->second.size) {
+        return static_cast<char*>(it->second.ptr) + (addr - it->first);
+      }
+    }
+    if (!device) {
+      if (size > hostScratchSize_[slot]) {
+        hostScratch_[slot].reset(new char[size]);
+        hostScratchSize_[slot] = size;
+      }
+      return hostScratch_[slot].get();
+    }
+    if (size > deviceScratchSize_[slot]) {
+      HIPCHECK(hipFree(deviceScratch_[slot]));
+      HIPCHECK(hipMalloc(&deviceScratch_[slot], size));
+      deviceScratchSize_[slot] = size;
+    }
+    return deviceScratch_[slot];
+  }
+
+  static bool deviceDst(uint64_t kind) {
+    return kind == hipMemcpyHostToDevice || kind == hipMemcpyDeviceToDevice;
+  }
+  static bool deviceSrc(uint64_t kind) {
+    return kind == hipMemcpyDeviceToHost || kind == hipMemcpyDeviceToDevice;
+  }
+
+  hipStream_t stream(uint64_t handle) const {
+    auto it = streams_.find(handle);
+    if (it != streams_.end()) return it->second;
+    // The null stream, the per thread stream or one created by an API that is not replayed
+    return handle == reinterpret_cast<uintptr_t>(hipStreamPerThread) ? hipStreamPerThread
+                                                                      : nullptr;
+  }
+
+  hipEvent_t event(uint64_t handle) const {
+    auto it = events_.find(handle);
+    return it != events_.end() ? it->second : nullptr;
+  }
+
+  int device(uint64_t recorded) const { return static_cast<int>(recorded % deviceCount_); }
+
+  void freeAlloc(uint64_t recorded, ReplayApi api, hipStream_t freeStream = nullptr) {
+    auto it = allocs_.find(recorded);
+    if (it == allocs_.end()) return;
+    switch (it->second.kind) {
+      case allocHost:
+        check(hipHostFree(it->second.ptr), api);
+        break;
+      case allocRegistered:
+        check(hipHostUnregister(it->second.ptr), api);
+        delete[] static_cast<char*>(it->second.ptr);
+        break;
+      default:
+        check(api == replay_hipFreeAsync ? hipFreeAsync(it->second.ptr, freeStream)
+                                         : hipFree(it->second.ptr), api);
+        break;
+    }
+    allocs_.erase(it);
+  }
+
+  void launch(ReplayApi api, dim3 grid, dim3 block, uint64_t shared, uint64_t stream_) {
+    hipLaunchKernelGGL(_replayKernel, grid, block, static_cast<unsigned int>(shared),
+                       stream(stream_));
+    check(hipGetLastError(), api);
+  }
+
+  static dim3 dims(uint64_t xy, uint64_t z) {
+    return dim3(static_cast<uint32_t>(xy), static_cast<uint32_t>(xy >> 32),
+                static_cast<uint32_t>(z));
+  }
+
+  void issue(const ReplayCall& call, const uint64_t* a) {
+    ReplayApi api = call.api;
+    void* ptr = nullptr;
+    switch (api) {
+      case replay_hipMalloc:
+        check(hipMalloc(&ptr, a[1]), api);
+        track(a[0], ptr, a[1], allocDevice);
+        break;
+      case replay_hipMallocManaged:
+        check(hipMallocManaged(&ptr, a[1], static_cast<unsigned int>(a[2])), api);
+        track(a[0], ptr, a[1], allocDevice);
+        break;
+      case replay_hipHostMalloc:
+        check(hipHostMalloc(&ptr, a[1], static_cast<unsigned int>(a[2])), api);
+        track(a[0], ptr, a[1], allocHost);
+        break;
+      case replay_hipExtMallocWithFlags:
+        check(hipExtMallocWithFlags(&ptr, a[1], static_cast<unsigned int>(a[2])), api);
+        track(a[0], ptr, a[1], allocDevice);
+        break;
+      case replay_hipMallocPitch: {
+        size_t pitch = 0;
+        check(hipMallocPitch(&ptr, &pitch, a[2], a[3]), api);
+        track(a[0], ptr, a[1] * a[3], allocDevice);
+        break;
+      }
+      case replay_hipMalloc3D: {
+        hipPitchedPtr pitched{};
+        check(hipMalloc3D(&pitched, make_hipExtent(a[2], a[3], a[4])), api);
+        track(a[0], pitched.ptr, a[1] * a[3] * a[4], allocDevice);
+        break;
+      }
+      case replay_hipMallocAsync:
+        check(hipMallocAsync(&ptr, a[1], stream(a[2])), api);
+        track(a[0], ptr, a[1], allocDevice);
+        break;
+      case replay_hipHostRegister:
+        ptr = new char[a[1]];
+        check(hipHostRegister(ptr, a[1], static_cast<unsigned int>(a[2])), api);
+        track(a[0], ptr, a[1], allocRegistered);
+        break;
+      case replay_hipHostUnregister:
+      case replay_hipFree:
+      case replay_hipHostFree:
+        freeAlloc(a[0], api);
+        break;
+      case replay_hipFreeAsync:
+        freeAlloc(a[0], api, stream(a[1]));
+        break;
+      case replay_hipMemcpy:
+        check(hipMemcpy(translate(a[0], deviceDst(a[3]), a[2]),
+                        translate(a[1], deviceSrc(a[3]), a[2], scratchSrc), a[2],
+                        static_cast<hipMemcpyKind>(a[3])), api);
+        break;
+      case replay_hipMemcpyAsync:
+      case replay_hipMemcpyWithStream: {
+        void* dst = translate(a[0], deviceDst(a[3]), a[2]);
+        const void* src = translate(a[1], deviceSrc(a[3]), a[2], scratchSrc);
+        auto kind = static_cast<hipMemcpyKind>(a[3]);
+        check(api == replay_hipMemcpyAsync ? hipMemcpyAsync(dst, src, a[2], kind, stream(a[4]))
+                                           : hipMemcpyWithStream(dst, src, a[2], kind,
+                                                                 stream(a[4])), api);
+        break;
+      }
+      case replay_hipMemcpyHtoD:
+        check(hipMemcpyHtoD(translate(a[0], true, a[2]),
+                            translate(a[1], false, a[2], scratchSrc), a[2]),
+              api);
+        break;
+      case replay_hipMemcpyDtoH:
+        check(hipMemcpyDtoH(translate(a[0], false, a[2]),
+                            translate(a[1], true, a[2], scratchSrc), a[2]),
+              api);
+        break;
+      case replay_hipMemcpyDtoD:
+        check(hipMemcpyDtoD(translate(a[0], true, a[2]),
+                            translate(a[1], true, a[2], scratchSrc), a[2]),
+              api);
+        break;
+      case replay_hipMemcpyHtoDAsync:
+        check(hipMemcpyHtoDAsync(translate(a[0], true, a[2]),
+                                 translate(a[1], false, a[2], scratchSrc), a[2], stream(a[3])),
+              api);
+        break;
+      case replay_hipMemcpyDtoHAsync:
+        check(hipMemcpyDtoHAsync(translate(a[0], false, a[2]),
+                                 translate(a[1], true, a[2], scratchSrc), a[2], stream(a[3])),
+              api);
+        break;
+      case replay_hipMemcpyDtoDAsync:
+        check(hipMemcpyDtoDAsync(translate(a[0], true, a[2]),
+                                 translate(a[1], true, a[2], scratchSrc), a[2], stream(a[3])),
+              api);
+        break;
+      case replay_hipMemcpyPeer:
+        check(hipMemcpyPeer(translate(a[0], true, a[4]), device(a[1]),
+                            translate(a[2], true, a[4], scratchSrc), device(a[3]), a[4]), api);
+        break;
+      case replay_hipMemcpyPeerAsync:
+        check(hipMemcpyPeerAsync(translate(a[0], true, a[4]), device(a[1]),
+                                 translate(a[2], true, a[4], scratchSrc), device(a[3]), a[4],
+                                 stream(a[5])),
+              api);
+        break;
+      case replay_hipMemcpy2D:
+      case replay_hipMemcpy2DAsync: {
+        void* dst = translate(a[0], deviceDst(a[6]), a[1] * a[5]);
+        const void* src = translate(a[2], deviceSrc(a[6]), a[3] * a[5], scratchSrc);
+        auto kind = static_cast<hipMemcpyKind>(a[6]);
+        check(api == replay_hipMemcpy2D
+                  ? hipMemcpy2D(dst, a[1], src, a[3], a[4], a[5], kind)
+                  : hipMemcpy2DAsync(dst, a[1], src, a[3], a[4], a[5], kind, stream(a[7])),
+              api);
+        break;
+      }
+      case replay_hipMemset:
+        check(hipMemset(translate(a[0], true, a[2]), static_cast<int>(a[1]), a[2]), api);
+        break;
+      case replay_hipMemsetAsync:
+        check(hipMemsetAsync(translate(a[0], true, a[2]), static_cast<int>(a[1]), a[2],
+                             stream(a[3])), api);
+        break;
+      case replay_hipMemsetD8:
+        check(hipMemsetD8(translate(a[0], true, a[2]), static_cast<unsigned char>(a[1]), a[2]),
+              api);
+        break;
+      case replay_hipMemsetD16:
+        check(hipMemsetD16(translate(a[0], true, a[2] * 2), static_cast<unsigned short>(a[1]),
+                           a[2]), api);
+        break;
+      case replay_hipMemsetD32:
+        check(hipMemsetD32(translate(a[0], true, a[2] * 4), static_cast<int>(a[1]), a[2]), api);
+        break;
+      case replay_hipMemsetD8Async:
+        check(hipMemsetD8Async(translate(a[0], true, a[2]), static_cast<unsigned char>(a[1]),
+                               a[2], stream(a[3])), api);
+        break;
+      case replay_hipMemsetD16Async:
+        check(hipMemsetD16Async(translate(a[0], true, a[2] * 2),
+                                static_cast<unsigned short>(a[1]), a[2], stream(a[3])), api);
+        break;
+      case replay_hipMemsetD32Async:
+        check(hipMemsetD32Async(translate(a[0], true, a[2] * 4), static_cast<int>(a[1]), a[2],
+                                stream(a[3])), api);
+        break;
+      case replay_hipMemset2D:
+        check(hipMemset2D(translate(a[0], true, a[1] * a[4]), a[1], static_cast<int>(a[2]), a[3],
+                          a[4]), api);
+        break;
+      case replay_hipMemset2DAsync:
+        check(hipMemset2DAsync(translate(a[0], true, a[1] * a[4]), a[1], static_cast<int>(a[2]),
+                               a[3], a[4], stream(a[5])), api);
+        break;
+      case replay_hipMemPrefetchAsync:
+        check(hipMemPrefetchAsync(translate(a[0], true, a[1]), a[1], device(a[2]), stream(a[3])),
+              api);
+        break;
+      case replay_hipMemAdvise:
+        check(hipMemAdvise(translate(a[0], true, a[1]), a[1], static_cast<hipMemoryAdvise>(a[2]),
+                           device(a[3])), api);
+        break;
+      case replay_hipStreamCreate:
+      case replay_hipStreamCreateWithFlags:
+      case replay_hipStreamCreateWithPriority: {
+        hipStream_t created = nullptr;
+        if (api == replay_hipStreamCreate) {
+          check(hipStreamCreate(&created), api);
+        } else if (api == replay_hipStreamCreateWithFlags) {
+          check(hipStreamCreateWithFlags(&created, static_cast<unsigned int>(a[1])), api);
+        } else {
+          check(hipStreamCreateWithPriority(&created, static_cast<unsigned int>(a[1]),
+                                            static_cast<int>(a[2])), api);
+        }
+        if (created != nullptr) streams_[a[0]] = created;
+        break;
+      }
+      case replay_hipStreamDestroy: {
+        auto it = streams_.find(a[0]);
+        if (it == streams_.end()) break;
+        check(hipStreamDestroy(it->second), api);
+        streams_.erase(it);
+        break;
+      }
+      case replay_hipStreamSynchronize:
+        check(hipStreamSynchronize(stream(a[0])), api);
+        break;
+      case replay_hipStreamQuery:
+        check(hipStreamQuery(stream(a[0])), api);
+        break;
+      case replay_hipStreamWaitEvent:
+        if (event(a[1]) != nullptr) {
+          check(hipStreamWaitEvent(stream(a[0]), event(a[1]), static_cast<unsigned int>(a[2])),
+                api);
+        }
+        break;
+      case replay_hipEventCreate:
+      case replay_hipEventCreateWithFlags: {
+        hipEvent_t created = nullptr;
+        check(api == replay_hipEventCreate
+                  ? hipEventCreate(&created)
+                  : hipEventCreateWithFlags(&created, static_cast<unsigned int>(a[1])), api);
+        if (created != nullptr) events_[a[0]] = created;
+        break;
+      }
+      case replay_hipEventRecord:
+        if (event(a[0]) != nullptr) check(hipEventRecord(event(a[0]), stream(a[1])), api);
+        break;
+      case replay_hipEventSynchronize:
+        if (event(a[0]) != nullptr) check(hipEventSynchronize(event(a[0])), api);
+        break;
+      case replay_hipEventQuery:
+        if (event(a[0]) != nullptr) check(hipEventQuery(event(a[0])), api);
+        break;
+      case replay_hipEventDestroy: {
+        auto it = events_.find(a[0]);
+        if (it == events_.end()) break;
+        check(hipEventDestroy(it->second), api);
+        events_.erase(it);
+        break;
+      }
+      case replay_hipSetDevice:
+        check(hipSetDevice(device(a[0])), api);
+        break;
+      case replay_hipDeviceSynchronize:
+        check(hipDeviceSynchronize(), api);
+        break;
+      case replay_hipDeviceEnablePeerAccess: {
+        int current = 0;
+        HIPCHECK(hipGetDevice(&current));
+        // A recording from more devices than this system has may map the peer onto itself
+        if (device(a[0]) != current) {
+          check(hipDeviceEnablePeerAccess(device(a[0]), static_cast<unsigned int>(a[1])), api);
+        }
+        break;
+      }
+      case replay_hipLaunchKernel:
+        launch(api, dims(a[1], a[2]), dims(a[3], a[4]), a[6], a[7]);
+        break;
+      case replay_hipModuleLaunchKernel:
+        launch(api, dim3(a[1], a[2], a[3]), dim3(a[4], a[5], a[6]), a[7], a[8]);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Releases what the recording left allocated and restores the opened device
+  void release() {
+    for (auto& entry : streams_) {
+      HIPCHECK(hipStreamSynchronize(entry.second));
+      HIPCHECK(hipStreamDestroy(entry.second));
+    }
+    streams_.clear();
+    for (auto& entry : events_) {
+      HIPCHECK(hipEventDestroy(entry.second));
+    }
+    events_.clear();
+    while (!allocs_.empty()) {
+      freeAlloc(allocs_.begin()->first, replay_hipFree);
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+  }
+
+  Recording rec_;
+  bool loaded_;
+  int deviceCount_;
+  std::map<uint64_t, Allocation> allocs_;  // Recorded base address -> live allocation
+  std::unordered_map<uint64_t, hipStream_t> streams_;
+  std::unordered_map<uint64_t, hipEvent_t> events_;
+  std::unique_ptr<char[]> hostScratch_[numScratchSlots];
+  uint64_t hostScratchSize_[numScratchSlots];
+  void* deviceScratch_[numScratchSlots];
+  uint64_t deviceScratchSize_[numScratchSlots];
+  bool timeApis_;
+  std::vector<uint64_t> apiNs_;     // Host time per API over the timed repetitions
+  std::vector<uint64_t> apiCalls_;
+  size_t errors_;
+  ReplayApi firstErrorApi_;
+  hipError_t firstError_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfApiReplay)
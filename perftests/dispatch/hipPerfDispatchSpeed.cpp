@@ -18,34 +18,15 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
  * TEST: %t
  * HIT_END
  */
 
 #include <stdio.h>
-#include <assert.h>
 #include <string.h>
-#include <complex>
 
-#include "timer.h"
-#include "test_common.h"
-
-// Quiet pesky warnings
-#ifdef WIN_OS
-#define SNPRINTF sprintf_s
-#else
-#define SNPRINTF snprintf
-#endif
-
-#define CHAR_BUF_SIZE 512
-
-#define CHECK_RESULT(test, msg)         \
-    if ((test))                         \
-    {                                   \
-        printf("\n%s\n", msg);          \
-        abort();                        \
-    }
+#include "perf_harness.h"
 
 typedef struct {
     unsigned int iterations;
@@ -80,150 +61,102 @@ testStruct testList[] =
 
 unsigned int mapTestList[] = {1, 1, 10, 100, 1000, 10000, 100000};
 
-__global__ void _dispatchSpeed(float *outBuf)
+__global__ void _dispatchSpeed(float *outBuf, HipPerf::KernelStamps* stamps)
 {
+   HipPerf::stampKernelBegin(stamps);
    int i = (blockIdx.x * blockDim.x + threadIdx.x);
    if (i < 0)
        outBuf[i] = 0.0f;
+   HipPerf::stampKernelEnd(stamps);
 };
 
 
-int main(int argc, char* argv[]) {
-    HipTest::parseStandardArguments(argc, argv, true);
-
-    hipError_t err = hipSuccess;
-    hipDeviceProp_t props = {0};
-    hipGetDeviceProperties(&props, p_gpuDevice);
-    CHECK_RESULT(err != hipSuccess, "hipGetDeviceProperties failed" );
-    printf("Set device to %d : %s\n", p_gpuDevice, props.name);
-
-    unsigned int testListSize = sizeof(testList) / sizeof(testStruct);
-    int numTests = (p_tests == -1) ? (2*2*testListSize - 1) : p_tests;
-    int test = (p_tests == -1) ? 0 : p_tests;
+class hipPerfDispatchSpeed : public HipPerf::Benchmark {
+ public:
+  hipPerfDispatchSpeed() : HipPerf::Benchmark("hipPerfDispatchSpeed"), srcBuffer_(NULL) {}
 
-    float* srcBuffer = NULL;
-    unsigned int bufSize_ = 64*sizeof(float);
-    err = hipMalloc(&srcBuffer, bufSize_);
-    CHECK_RESULT(err != hipSuccess, "hipMalloc failed");
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipMalloc(&srcBuffer_, bufSize_));
+  }
 
-    for(;test <= numTests; test++)
-    {
-        int openTest = test % testListSize;
-        bool sleep = false;
-        bool doWarmup = false;
+  void close() override {
+    HIPCHECK(hipFree(srcBuffer_));
+  }
 
-        if ((test / testListSize) % 2)
-        {
-            doWarmup = true;
-        }
-        if (test >= (testListSize * 2))
-        {
-            sleep = true;
-        }
-
-        int threads = (bufSize_ / sizeof(float));
-        int threads_per_block  = 64;
-        int blocks = (threads/threads_per_block) + (threads % threads_per_block);
-        hipEvent_t start, stop;
+  unsigned int numTests() override { return 2 * 2 * testListSize_; }
 
-        // NULL stream check:
-        err = hipEventCreate(&start);
-        err = hipEventCreate(&stop);
+  void run(unsigned int test) override {
+    int openTest = test % testListSize_;
+    bool sleep = ((test / testListSize_) >= 2);
+    bool doWarmup = ((test / testListSize_) % 2) != 0;
 
-        CHECK_RESULT(err != hipSuccess, "hipEventCreate failed");
+    int threads = (bufSize_ / sizeof(float));
+    int threads_per_block  = 64;
+    int blocks = (threads/threads_per_block) + (threads % threads_per_block);
+    hipEvent_t start, stop;
 
-        if (doWarmup)
-        {
-            hipLaunchKernelGGL(_dispatchSpeed, dim3(blocks), dim3(threads_per_block), 0, hipStream_t(0), srcBuffer);
-            err = hipDeviceSynchronize();
-            CHECK_RESULT(err != hipSuccess, "hipDeviceSynchronize failed");
-        }
-
-        CPerfCounter timer;
-
-        timer.Reset();
-        timer.Start();
-        for (unsigned int i = 0; i < testList[openTest].iterations; i++)
-        {
-            hipEventRecord(start, NULL);
-            hipLaunchKernelGGL(_dispatchSpeed, dim3(blocks), dim3(threads_per_block), 0, hipStream_t(0), srcBuffer);
-            hipEventRecord(stop, NULL);
-
-            if ((testList[openTest].flushEvery > 0) &&
-                (((i + 1) % testList[openTest].flushEvery) == 0))
-            {
-                if (sleep)
-                {
-                    err = hipDeviceSynchronize();
-                    CHECK_RESULT(err != hipSuccess, "hipDeviceSynchronize failed");
-                }
-                else
-                {
-                    do {
-                        err = hipEventQuery(stop);
-                    } while (err == hipErrorNotReady);
-                }
-            }
-        }
-        if (sleep)
-        {
-            err = hipDeviceSynchronize();
-            CHECK_RESULT(err != hipSuccess, "hipDeviceSynchronize failed");
-        }
-        else
-        {
-            do {
-                err = hipEventQuery(stop);
-            } while (err == hipErrorNotReady);
-        }
-        timer.Stop();
-
-        hipEventDestroy(start);
-        hipEventDestroy(stop);
-        double sec = timer.GetElapsedTime();
-
-        // microseconds per launch
-        double perf = (1000000.f*sec/testList[openTest].iterations);
-        const char *waitType;
-        const char *extraChar;
-        const char *n;
-        const char *warmup;
-        if (sleep)
-        {
-            waitType = "sleep";
-            extraChar = "";
-            n = "";
-        }
-        else
-        {
-            waitType = "spin";
-            n = "n";
-            extraChar = " ";
-        }
-        if (doWarmup)
-        {
-            warmup = "warmup";
-        }
-        else
-        {
-            warmup = "";
-        }
+    // NULL stream check:
+    HIPCHECK(hipEventCreate(&start));
+    HIPCHECK(hipEventCreate(&stop));
 
+    if (doWarmup) {
+      hipLaunchKernelGGL(_dispatchSpeed, dim3(blocks), dim3(threads_per_block), 0, hipStream_t(0),
+                         srcBuffer_, nullptr);
+      HIPCHECK(hipDeviceSynchronize());
+    }
 
-        char buf[256];
-        if (testList[openTest].flushEvery > 0)
-        {
-            SNPRINTF(buf, sizeof(buf), "HIPPerfDispatchSpeed[%3d] %7d dispatches %s%sing every %5d %6s (us/disp) %3f", test, testList[openTest].iterations,
-                    waitType, n, testList[openTest].flushEvery, warmup, (float)perf);
-        }
-        else
-        {
-            SNPRINTF(buf, sizeof(buf), "HIPPerfDispatchSpeed[%3d] %7d dispatches (%s%s)              %6s (us/disp) %3f", test, testList[openTest].iterations,
-                    waitType, extraChar, warmup, (float)perf);
+    const testStruct& t = testList[openTest];
+    HipPerf::KernelStamps* stamps = kernelStamps();
+    // The warmup variants are part of the test matrix, so the harness must not add its own
+    auto timing = measureSplit([&]() {
+      for (unsigned int i = 0; i < t.iterations; i++) {
+        hipEventRecord(start, NULL);
+        hipLaunchKernelGGL(_dispatchSpeed, dim3(blocks), dim3(threads_per_block), 0,
+                           hipStream_t(0), srcBuffer_, stamps);
+        hipEventRecord(stop, NULL);
+
+        if ((t.flushEvery > 0) && (((i + 1) % t.flushEvery) == 0)) {
+          wait(stop, sleep);
         }
-        printf("%s\n", buf);
+      }
+      // The final wait is the harness synchronizing the stream
+    }, hipStream_t(0), 0);
+
+    HIPCHECK(hipEventDestroy(start));
+    HIPCHECK(hipEventDestroy(stop));
+
+    char desc[64];
+    if (t.flushEvery > 0) {
+      snprintf(desc, sizeof(desc), "%sing every %5d %s", sleep ? "sleep" : "spinn",
+               t.flushEvery, doWarmup ? "warmup" : "");
+    } else {
+      snprintf(desc, sizeof(desc), "(%s) %s", sleep ? "sleep" : "spin",
+               doWarmup ? "warmup" : "");
+    }
+    // microseconds per launch, device time from the --timer backend
+    report(test, std::string(desc) + " " + HipPerf::timerBackendName(), 0, t.iterations,
+           "us/disp", HipPerf::toMicroseconds(timing.device, t.iterations));
+    report(test, std::string(desc) + " submit", 0, t.iterations, "us/disp",
+           HipPerf::toMicroseconds(timing.submit, t.iterations));
+  }
+
+ private:
+  static void wait(hipEvent_t stop, bool sleep) {
+    if (sleep) {
+      HIPCHECK(hipDeviceSynchronize());
+    } else {
+      hipError_t err;
+      do {
+        err = hipEventQuery(stop);
+      } while (err == hipErrorNotReady);
+      HIPCHECK(err);
     }
+  }
+
+  const unsigned int testListSize_ = sizeof(testList) / sizeof(testStruct);
+  const unsigned int bufSize_ = 64 * sizeof(float);
+  float* srcBuffer_;
+};
 
-    hipFree(srcBuffer);
-    passed();
-}
+HIP_PERF_BENCHMARK(hipPerfDispatchSpeed)
@@ -0,0 +1,138 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Aggregate hipLaunchKernelGGL enqueue rate of 1..hardware_concurrency
+// submitter threads, each with its own stream or all sharing one stream.
+// Scaling efficiency is the rate relative to thread count times the single
+// thread rate of the same mode; a runtime lock shows up as a plateau.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "perf_harness.h"
+
+enum StreamMode { streamPerThread = 0, streamShared, numStreamModes };
+
+static const char* streamModeStr[numStreamModes] = {"stream per thread", "shared stream"};
+
+__global__ void _enqueueKernel() {}
+
+class hipPerfEnqueueRateMT : public HipPerf::Benchmark {
+ public:
+  hipPerfEnqueueRateMT() : HipPerf::Benchmark("hipPerfEnqueueRateMT"),
+      launches_(HipPerf::iterationCount(10000)) {
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int t = 1; t < maxThreads; t *= 2) {
+      threadCounts_.push_back(t);
+    }
+    threadCounts_.push_back(maxThreads);
+    singleRate_[streamPerThread] = singleRate_[streamShared] = 0;
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    streams_.resize(threadCounts_.back());
+    for (auto& stream : streams_) {
+      HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+    }
+  }
+
+  void close() override {
+    for (auto& stream : streams_) {
+      HIPCHECK(hipStreamDestroy(stream));
+    }
+  }
+
+  unsigned int numTests() override { return threadCounts_.size() * numStreamModes; }
+
+  void run(unsigned int test) override {
+    unsigned int numThreads = threadCounts_[test % threadCounts_.size()];
+    StreamMode mode = static_cast<StreamMode>(test / threadCounts_.size());
+
+    std::vector<double> rates = launchesPerSecond(numThreads, mode);
+    if (singleRate_[mode] == 0) {
+      // Baseline for the efficiency, also when -t selects a single test
+      singleRate_[mode] = numThreads == 1 ? ComputePerfStats(rates).median
+                                          : ComputePerfStats(launchesPerSecond(1, mode)).median;
+    }
+    std::vector<double> efficiency;
+    for (double rate : rates) {
+      efficiency.push_back(100.0 * rate / (numThreads * singleRate_[mode]));
+    }
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%3u threads %s", numThreads, streamModeStr[mode]);
+    report(test, desc, 0, launches_, "launches/s", rates);
+    report(test, std::string(desc) + " efficiency", 0, launches_, "%", efficiency);
+  }
+
+ private:
+  // Aggregate launches per second of numThreads threads, one sample per repetition.
+  std::vector<double> launchesPerSecond(unsigned int numThreads, StreamMode mode) {
+    std::vector<double> rates;
+    measure([&]() {
+      std::atomic<unsigned int> ready(0);
+      std::atomic<bool> go(false);
+      std::vector<std::thread> threads;
+      for (unsigned int t = 0; t < numThreads; t++) {
+        hipStream_t stream = streams_[mode == streamShared ? 0 : t];
+        threads.emplace_back([&, stream]() {
+          HIPCHECK(hipSetDevice(deviceId_));
+          ready++;
+          while (!go.load(std::memory_order_acquire)) {
+          }
+          for (unsigned int i = 0; i < launches_; i++) {
+            hipLaunchKernelGGL(_enqueueKernel, dim3(1), dim3(1), 0, stream);
+          }
+        });
+      }
+      // Thread creation is not part of the enqueue rate
+      while (ready.load() != numThreads) {
+      }
+      auto start = std::chrono::steady_clock::now();
+      go.store(true, std::memory_order_release);
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+      if (!HipPerf::Counters::collecting()) {
+        rates.push_back(static_cast<double>(launches_) * numThreads / sec.count());
+      }
+      HIPCHECK(hipDeviceSynchronize());
+    });
+    return HipPerf::measuredSamples(rates);
+  }
+
+  unsigned int launches_;  // per thread
+  std::vector<unsigned int> threadCounts_;
+  std::vector<hipStream_t> streams_;
+  double singleRate_[numStreamModes];
+};
+
+HIP_PERF_BENCHMARK(hipPerfEnqueueRateMT)
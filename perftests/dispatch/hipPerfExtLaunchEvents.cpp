@@ -0,0 +1,241 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD_CMD: hipPerfExtLaunchEvents %hc -I%S/../../src %S/%s %S/../../src/test_common.cpp %S/../../src/timer.cpp %S/../../src/perf_harness.cpp %S/../../src/perf_main.cpp -o %T/%t EXCLUDE_HIP_PLATFORM nvidia
+ * TEST: %t
+ * HIT_END
+ */
+
+// Per launch timing with events passed to hipExtLaunchKernelGGL against
+// bracketing hipLaunchKernelGGL with two hipEventRecord calls, as
+// hipPerfDispatchSpeed does. The first group reports host submit and device
+// time per launch of an empty kernel without events, with hipEventRecord
+// pairs and with hipExtLaunchKernelGGL events, every launch having its own
+// event pair. The second group checks timing accuracy: kernels spinning for
+// 0, 10 and 100 us stamp their own start and end with wall_clock64(), and
+// per launch the event elapsed time and its excess over the kernel's own
+// duration are reported for both ways of recording. The last group submits
+// batches of one launch per device through hipExtLaunchMultiKernelMultiDevice
+// and through a hipSetDevice/hipLaunchKernelGGL loop, in us per batch.
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+__global__ void eventKernel(unsigned long long spinTicks, unsigned long long* ticks) {
+  if (blockIdx.x == 0 && threadIdx.x == 0) {
+    unsigned long long start = wall_clock64();
+    unsigned long long end = start;
+    while (end - start < spinTicks) {
+      end = wall_clock64();
+    }
+    ticks[0] = start;
+    ticks[1] = end;
+  }
+}
+
+enum EventMode { eventNone = 0, eventRecord, eventExtLaunch, numEventModes };
+static const char* eventModeStr[numEventModes] = {"hipLaunchKernelGGL, no events",
+                                                  "hipEventRecord + launch + hipEventRecord",
+                                                  "hipExtLaunchKernelGGL with events"};
+
+static const unsigned int spinMicroseconds[] = {0, 10, 100};
+static const unsigned int numSpins = sizeof(spinMicroseconds) / sizeof(spinMicroseconds[0]);
+
+enum MultiMode { multiLoop = 0, multiExt, numMultiModes };
+static const char* multiModeStr[numMultiModes] = {"hipSetDevice + hipLaunchKernelGGL loop",
+                                                  "hipExtLaunchMultiKernelMultiDevice"};
+
+static const unsigned int launchesPerRep = 1000;
+static const unsigned int accuracyLaunches = 100;
+static const unsigned int batchesPerRep = 100;
+static const unsigned int blockSize = 64;
+
+class hipPerfExtLaunchEvents : public HipPerf::Benchmark {
+ public:
+  hipPerfExtLaunchEvents() : HipPerf::Benchmark("hipPerfExtLaunchEvents"), stream_(nullptr),
+      ticks_(nullptr), wallRateKHz_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&wallRateKHz_, hipDeviceAttributeWallClockRate, deviceId));
+    HIPCHECK(hipStreamCreate(&stream_));
+    HIPCHECK(hipHostMalloc(&ticks_, 2 * sizeof(unsigned long long) * launchesPerRep));
+    starts_.resize(launchesPerRep);
+    stops_.resize(launchesPerRep);
+    for (unsigned int i = 0; i < launchesPerRep; i++) {
+      HIPCHECK(hipEventCreate(&starts_[i]));
+      HIPCHECK(hipEventCreate(&stops_[i]));
+    }
+
+    int devices = 0;
+    HIPCHECK(hipGetDeviceCount(&devices));
+    deviceStreams_.resize(devices);
+    deviceTicks_.resize(devices);
+    for (int d = 0; d < devices; d++) {
+      HIPCHECK(hipSetDevice(d));
+      HIPCHECK(hipStreamCreate(&deviceStreams_[d]));
+      HIPCHECK(hipMalloc(&deviceTicks_[d], 2 * sizeof(unsigned long long)));
+    }
+    HIPCHECK(hipSetDevice(deviceId));
+  }
+
+  void close() override {
+    for (size_t d = 0; d < deviceStreams_.size(); d++) {
+      HIPCHECK(hipSetDevice(static_cast<int>(d)));
+      HIPCHECK(hipStreamDestroy(deviceStreams_[d]));
+      HIPCHECK(hipFree(deviceTicks_[d]));
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+    for (unsigned int i = 0; i < launchesPerRep; i++) {
+      HIPCHECK(hipEventDestroy(starts_[i]));
+      HIPCHECK(hipEventDestroy(stops_[i]));
+    }
+    HIPCHECK(hipHostFree(ticks_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override {
+    return numEventModes + (numEventModes - 1) * numSpins + numMultiModes;
+  }
+
+  void run(unsigned int test) override {
+    if (test < numEventModes) {
+      runOverhead(test, static_cast<EventMode>(test));
+    } else if (test < numEventModes + (numEventModes - 1) * numSpins) {
+      unsigned int index = test - numEventModes;
+      runAccuracy(test, static_cast<EventMode>(eventRecord + index / numSpins),
+                  spinMicroseconds[index % numSpins]);
+    } else {
+      runMultiDevice(test,
+                     static_cast<MultiMode>(test - numEventModes - (numEventModes - 1) * numSpins));
+    }
+  }
+
+ private:
+  void launch(EventMode mode, unsigned int i, unsigned long long spinTicks) {
+    unsigned long long* ticks = ticks_ + 2 * i;
+    switch (mode) {
+      case eventNone:
+        hipLaunchKernelGGL(eventKernel, dim3(1), dim3(blockSize), 0, stream_, spinTicks, ticks);
+        break;
+      case eventRecord:
+        HIPCHECK(hipEventRecord(starts_[i], stream_));
+        hipLaunchKernelGGL(eventKernel, dim3(1), dim3(blockSize), 0, stream_, spinTicks, ticks);
+        HIPCHECK(hipEventRecord(stops_[i], stream_));
+        break;
+      default:
+        hipExtLaunchKernelGGL(eventKernel, dim3(1), dim3(blockSize), 0, stream_, starts_[i],
+                              stops_[i], 0, spinTicks, ticks);
+        break;
+    }
+  }
+
+  void runOverhead(unsigned int test, EventMode mode) {
+    auto timing = measureSplit([&]() {
+      for (unsigned int i = 0; i < launchesPerRep; i++) {
+        launch(mode, i, 0);
+      }
+    }, stream_);
+
+    report(test, std::string(eventModeStr[mode]) + " " + HipPerf::timerBackendName(), 0,
+           launchesPerRep, "us/disp", HipPerf::toMicroseconds(timing.device, launchesPerRep));
+    report(test, std::string(eventModeStr[mode]) + " submit", 0, launchesPerRep, "us/disp",
+           HipPerf::toMicroseconds(timing.submit, launchesPerRep));
+  }
+
+  void runAccuracy(unsigned int test, EventMode mode, unsigned int spinUs) {
+    // wallRateKHz_ is ticks per millisecond
+    unsigned long long spinTicks = static_cast<unsigned long long>(wallRateKHz_) * spinUs / 1000;
+    for (unsigned int i = 0; i < accuracyLaunches; i++) {
+      launch(mode, i, spinTicks);
+    }
+    HIPCHECK(hipGetLastError());
+    HIPCHECK(hipStreamSynchronize(stream_));
+
+    std::vector<double> elapsedUs, excessUs;
+    for (unsigned int i = 0; i < accuracyLaunches; i++) {
+      float ms = 0;
+      HIPCHECK(hipEventElapsedTime(&ms, starts_[i], stops_[i]));
+      double kernelUs = static_cast<double>(ticks_[2 * i + 1] - ticks_[2 * i]) * 1000 /
+          wallRateKHz_;
+      elapsedUs.push_back(ms * 1000.0);
+      excessUs.push_back(ms * 1000.0 - kernelUs);
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %3u us kernel", eventModeStr[mode], spinUs);
+    report(test, std::string(desc) + " elapsed", 0, 1, "us", elapsedUs);
+    report(test, std::string(desc) + " excess over kernel", 0, 1, "us", excessUs);
+  }
+
+  void runMultiDevice(unsigned int test, MultiMode mode) {
+    int devices = static_cast<int>(deviceStreams_.size());
+    std::vector<hipLaunchParams> params(devices);
+    std::vector<void*> args(2 * devices);
+    unsigned long long spinTicks = 0;
+    for (int d = 0; d < devices; d++) {
+      args[2 * d] = &spinTicks;
+      args[2 * d + 1] = &deviceTicks_[d];
+      params[d].func = reinterpret_cast<void*>(eventKernel);
+      params[d].gridDim = dim3(1);
+      params[d].blockDim = dim3(blockSize);
+      params[d].sharedMem = 0;
+      params[d].stream = deviceStreams_[d];
+      params[d].args = &args[2 * d];
+    }
+
+    auto sec = measure([&]() {
+      for (unsigned int b = 0; b < batchesPerRep; b++) {
+        if (mode == multiExt) {
+          HIPCHECK(hipExtLaunchMultiKernelMultiDevice(params.data(), devices, 0));
+          continue;
+        }
+        for (int d = 0; d < devices; d++) {
+          HIPCHECK(hipSetDevice(d));
+          hipLaunchKernelGGL(eventKernel, dim3(1), dim3(blockSize), 0, deviceStreams_[d],
+                             spinTicks, deviceTicks_[d]);
+        }
+      }
+      HIPCHECK(hipGetLastError());
+      for (int d = 0; d < devices; d++) {
+        HIPCHECK(hipStreamSynchronize(deviceStreams_[d]));
+      }
+      HIPCHECK(hipSetDevice(deviceId_));
+    });
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s, %d devices", multiModeStr[mode], devices);
+    report(test, desc, 0, batchesPerRep, "us/batch",
+           HipPerf::toMicroseconds(sec, batchesPerRep));
+  }
+
+  hipStream_t stream_;
+  unsigned long long* ticks_;  // start and end stamp per launch
+  int wallRateKHz_;
+  std::vector<hipEvent_t> starts_;
+  std::vector<hipEvent_t> stops_;
+  std::vector<hipStream_t> deviceStreams_;
+  std::vector<unsigned long long*> deviceTicks_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfExtLaunchEvents)
@@ -0,0 +1,127 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Per-kernel cost of a chain of empty kernels launched one by one on a stream
+// versus the same chain captured once into a hipGraphExec and launched with
+// hipGraphLaunch. Capture and instantiation are reported separately, they are
+// paid once per graph rather than per launch.
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+
+static const unsigned int chainLengths[] = {1, 10, 100, 1000, 10000, 100000};
+static const unsigned int numChains = sizeof(chainLengths) / sizeof(chainLengths[0]);
+
+enum LaunchMode { launchStream = 0, launchGraph, numLaunchModes };
+
+static const char* launchModeStr[numLaunchModes] = {"stream", "graph"};
+
+__global__ void _emptyKernel(float* outBuf, HipPerf::KernelStamps* stamps) {
+  HipPerf::stampKernelBegin(stamps);
+  int i = (blockIdx.x * blockDim.x + threadIdx.x);
+  if (i < 0) outBuf[i] = 0.0f;
+  HipPerf::stampKernelEnd(stamps);
+}
+
+class hipPerfGraphDispatchSpeed : public HipPerf::Benchmark {
+ public:
+  hipPerfGraphDispatchSpeed()
+      : HipPerf::Benchmark("hipPerfGraphDispatchSpeed"), buffer_(NULL), stream_(NULL) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipMalloc(&buffer_, 64 * sizeof(float)));
+    // Capture needs a stream other than the null stream
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override {
+    HIPCHECK(hipStreamDestroy(stream_));
+    HIPCHECK(hipFree(buffer_));
+  }
+
+  unsigned int numTests() override { return numChains * numLaunchModes; }
+
+  void run(unsigned int test) override {
+    unsigned int length = chainLengths[test % numChains];
+    LaunchMode mode = static_cast<LaunchMode>(test / numChains);
+    HipPerf::KernelStamps* stamps = kernelStamps();
+
+    auto enqueueChain = [&]() {
+      for (unsigned int i = 0; i < length; i++) {
+        hipLaunchKernelGGL(_emptyKernel, dim3(1), dim3(64), 0, stream_, buffer_, stamps);
+      }
+    };
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%6u kernels %s", length, launchModeStr[mode]);
+
+    if (mode == launchStream) {
+      auto timing = measureSplit(enqueueChain, stream_);
+      report(test, std::string(desc) + " " + HipPerf::timerBackendName(), 0, length,
+             "us/kernel", HipPerf::toMicroseconds(timing.device, length));
+      report(test, std::string(desc) + " submit", 0, length, "us/kernel",
+             HipPerf::toMicroseconds(timing.submit, length));
+      return;
+    }
+
+    hipGraph_t graph;
+    hipGraphExec_t graphExec;
+    CPerfCounter timer;
+    timer.Reset();
+    timer.Start();
+    HIPCHECK(hipStreamBeginCapture(stream_, hipStreamCaptureModeGlobal));
+    enqueueChain();
+    HIPCHECK(hipStreamEndCapture(stream_, &graph));
+    timer.Stop();
+    double captureSec = timer.GetElapsedTime();
+
+    timer.Reset();
+    timer.Start();
+    HIPCHECK(hipGraphInstantiate(&graphExec, graph, nullptr, nullptr, 0));
+    timer.Stop();
+    double instantiateSec = timer.GetElapsedTime();
+
+    auto timing = measureSplit([&]() { HIPCHECK(hipGraphLaunch(graphExec, stream_)); }, stream_);
+    report(test, std::string(desc) + " " + HipPerf::timerBackendName(), 0, length, "us/kernel",
+           HipPerf::toMicroseconds(timing.device, length));
+    report(test, std::string(desc) + " submit", 0, length, "us/kernel",
+           HipPerf::toMicroseconds(timing.submit, length));
+    report(test, std::string(desc) + " capture", 0, length, "us/kernel",
+           HipPerf::toMicroseconds({captureSec}, length));
+    report(test, std::string(desc) + " instantiate", 0, length, "us/kernel",
+           HipPerf::toMicroseconds({instantiateSec}, length));
+
+    HIPCHECK(hipGraphExecDestroy(graphExec));
+    HIPCHECK(hipGraphDestroy(graph));
+  }
+
+ private:
+  float* buffer_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfGraphDispatchSpeed)
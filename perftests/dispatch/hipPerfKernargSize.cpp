@@ -0,0 +1,152 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lhiprtc
+ * TEST: %t
+ * HIT_END
+ */
+
+// Dispatch cost of an empty kernel as its argument block grows from 8 bytes
+// to the 4KB limit. Each size is launched through hipLaunchKernelGGL, and
+// through hipModuleLaunchKernel with kernelParams and with the
+// HIP_LAUNCH_PARAM_BUFFER_POINTER extra buffer. The module kernels are built
+// with hiprtc so the benchmark needs no code object on disk.
+
+#include <stdio.h>
+
+#include <string>
+
+#include <hip/hiprtc.h>
+
+#include "perf_harness.h"
+
+static const size_t argSizes[] = {8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+static const unsigned int numArgSizes = sizeof(argSizes) / sizeof(argSizes[0]);
+
+enum LaunchPath { pathGGL = 0, pathModuleParams, pathModuleExtra, numLaunchPaths };
+
+static const char* launchPathStr[numLaunchPaths] = {"hipLaunchKernelGGL",
+                                                     "hipModuleLaunchKernel params",
+                                                     "hipModuleLaunchKernel extra"};
+
+template <size_t N> struct KernArgs {
+  char data[N];
+};
+
+template <size_t N> __global__ void _kernargKernel(KernArgs<N> args) {}
+
+template <size_t N> static void launchGGL(const void* args, hipStream_t stream) {
+  hipLaunchKernelGGL(_kernargKernel<N>, dim3(1), dim3(1), 0, stream,
+                     *static_cast<const KernArgs<N>*>(args));
+}
+
+typedef void (*LaunchFunc)(const void*, hipStream_t);
+static const LaunchFunc launchFuncs[numArgSizes] = {
+    launchGGL<8>,   launchGGL<16>,  launchGGL<32>,   launchGGL<64>,   launchGGL<128>,
+    launchGGL<256>, launchGGL<512>, launchGGL<1024>, launchGGL<2048>, launchGGL<4096>};
+
+class hipPerfKernargSize : public HipPerf::Benchmark {
+ public:
+  hipPerfKernargSize() : HipPerf::Benchmark("hipPerfKernargSize"),
+      launches_(HipPerf::iterationCount(10000)), module_(nullptr), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    buildModule();
+    for (unsigned int i = 0; i < numArgSizes; i++) {
+      HIPCHECK(hipModuleGetFunction(&functions_[i], module_, kernelName(argSizes[i]).c_str()));
+    }
+  }
+
+  void close() override {
+    HIPCHECK(hipModuleUnload(module_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numArgSizes * numLaunchPaths; }
+
+  void run(unsigned int test) override {
+    unsigned int sizeIdx = test % numArgSizes;
+    LaunchPath path = static_cast<LaunchPath>(test / numArgSizes);
+    size_t argSize = argSizes[sizeIdx];
+    std::vector<char> args(argSize, 1);
+    hipFunction_t function = functions_[sizeIdx];
+
+    void* params[] = {args.data()};
+    void* extra[] = {HIP_LAUNCH_PARAM_BUFFER_POINTER, args.data(), HIP_LAUNCH_PARAM_BUFFER_SIZE,
+                     &argSize, HIP_LAUNCH_PARAM_END};
+
+    auto timing = measureSplit([&]() {
+      for (unsigned int i = 0; i < launches_; i++) {
+        switch (path) {
+          case pathGGL:
+            launchFuncs[sizeIdx](args.data(), stream_);
+            break;
+          case pathModuleParams:
+            HIPCHECK(hipModuleLaunchKernel(function, 1, 1, 1, 1, 1, 1, 0, stream_, params,
+                                           nullptr));
+            break;
+          default:
+            HIPCHECK(hipModuleLaunchKernel(function, 1, 1, 1, 1, 1, 1, 0, stream_, nullptr,
+                                           extra));
+            break;
+        }
+      }
+    }, stream_);
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%4zu B args %s", argSize, launchPathStr[path]);
+    report(test, std::string(desc) + " " + HipPerf::timerBackendName(), argSize, launches_,
+           "us/disp", HipPerf::toMicroseconds(timing.device, launches_));
+    report(test, std::string(desc) + " submit", argSize, launches_, "us/disp",
+           HipPerf::toMicroseconds(timing.submit, launches_));
+  }
+
+ private:
+  static std::string kernelName(size_t size) { return "kernarg_" + std::to_string(size); }
+
+  // One extern "C" kernel per argument size, taking a struct of that size by value.
+  void buildModule() {
+    std::string source;
+    for (size_t size : argSizes) {
+      std::string type = "KernArgs" + std::to_string(size);
+      source += "struct " + type + " { char data[" + std::to_string(size) + "]; };\n";
+      source += "extern \"C\" __global__ void " + kernelName(size) + "(" + type + " args) {}\n";
+    }
+
+    hiprtcProgram prog;
+    HIPRTCCHECK(hiprtcCreateProgram(&prog, source.c_str(), "kernarg.cu", 0, nullptr, nullptr));
+    HipTest::compileRtcProgram(prog, 0, nullptr);
+    size_t codeSize = 0;
+    HIPRTCCHECK(hiprtcGetCodeSize(prog, &codeSize));
+    std::vector<char> code(codeSize);
+    HIPRTCCHECK(hiprtcGetCode(prog, code.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+    HIPCHECK(hipModuleLoadData(&module_, code.data()));
+  }
+
+  unsigned int launches_;
+  hipModule_t module_;
+  hipFunction_t functions_[numArgSizes];
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfKernargSize)
@@ -0,0 +1,202 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// A persistent kernel consuming work items from a ring buffer in host-mapped
+// memory, compared with launching one kernel per item. The ring is published
+// and drained with volatile accesses and __threadfence_system(), the same
+// protocol as the threadfence_system unit test.
+//
+// Throughput pushes --iterations items as fast as the ring allows and reports
+// items/s. Latency pushes one item at a time and times until the host sees it
+// completed.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "perf_harness.h"
+
+#define RING_SIZE 1024
+#define WORK_THREADS 64
+
+struct WorkQueue {
+  unsigned int head;  // items published by the host
+  unsigned int tail;  // items completed by the device
+  unsigned int stop;
+  unsigned int items[RING_SIZE];
+};
+
+enum QueueMode { modePersistent = 0, modeLaunch, numQueueModes };
+enum QueueMetric { metricThroughput = 0, metricLatency, numQueueMetrics };
+
+static const char* queueModeStr[numQueueModes] = {"persistent kernel", "launch per item"};
+static const char* queueMetricStr[numQueueMetrics] = {"throughput", "latency"};
+
+__device__ inline void processItem(unsigned int item, unsigned int* out) {
+  out[threadIdx.x] += item;
+}
+
+__global__ void _persistentKernel(volatile WorkQueue* queue, unsigned int* out) {
+  __shared__ unsigned int next;
+  __shared__ bool done;
+  unsigned int consumed = 0;
+  while (true) {
+    if (threadIdx.x == 0) {
+      unsigned int head;
+      while ((head = queue->head) == consumed && !queue->stop) {
+        __threadfence_system();
+      }
+      done = head == consumed;
+      next = queue->items[consumed % RING_SIZE];
+    }
+    __syncthreads();
+    if (done) {
+      return;
+    }
+    processItem(next, out);
+    __syncthreads();
+    if (threadIdx.x == 0) {
+      __threadfence_system();  // results are visible before the item is retired
+      queue->tail = ++consumed;
+      __threadfence_system();
+    }
+  }
+}
+
+__global__ void _itemKernel(unsigned int item, unsigned int* out) {
+  processItem(item, out);
+}
+
+class hipPerfPersistentKernel : public HipPerf::Benchmark {
+ public:
+  hipPerfPersistentKernel() : HipPerf::Benchmark("hipPerfPersistentKernel"),
+      items_(HipPerf::iterationCount(100000)), queue_(nullptr), out_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipHostMalloc(&queue_, sizeof(WorkQueue),
+                           hipHostMallocMapped | hipHostMallocCoherent));
+    HIPCHECK(hipHostGetDevicePointer(reinterpret_cast<void**>(&deviceQueue_), queue_, 0));
+    HIPCHECK(hipMalloc(&out_, WORK_THREADS * sizeof(unsigned int)));
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override {
+    HIPCHECK(hipStreamDestroy(stream_));
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipHostFree(queue_));
+  }
+
+  unsigned int numTests() override { return numQueueModes * numQueueMetrics; }
+
+  void run(unsigned int test) override {
+    QueueMode mode = static_cast<QueueMode>(test % numQueueModes);
+    QueueMetric metric = static_cast<QueueMetric>(test / numQueueModes);
+
+    if (mode == modePersistent) {
+      memset(queue_, 0, sizeof(WorkQueue));
+      published_ = 0;
+      hipLaunchKernelGGL(_persistentKernel, dim3(1), dim3(WORK_THREADS), 0, stream_,
+                         deviceQueue_, out_);
+    }
+
+    std::vector<double> sec;
+    if (metric == metricThroughput) {
+      sec = measure([&]() {
+        if (mode == modePersistent) {
+          for (unsigned int i = 0; i < items_; i++) {
+            push(i);
+          }
+          drain();
+        } else {
+          for (unsigned int i = 0; i < items_; i++) {
+            hipLaunchKernelGGL(_itemKernel, dim3(1), dim3(WORK_THREADS), 0, stream_, i, out_);
+          }
+          HIPCHECK(hipStreamSynchronize(stream_));
+        }
+      });
+    } else {
+      sec = measureEach([&]() {
+        if (mode == modePersistent) {
+          push(1);
+          drain();
+        } else {
+          hipLaunchKernelGGL(_itemKernel, dim3(1), dim3(WORK_THREADS), 0, stream_, 1u, out_);
+          HIPCHECK(hipStreamSynchronize(stream_));
+        }
+      }, items_ / 100);
+    }
+
+    if (mode == modePersistent) {
+      volatile WorkQueue* q = queue_;
+      q->stop = 1;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      HIPCHECK(hipStreamSynchronize(stream_));
+    }
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%s %s", queueModeStr[mode], queueMetricStr[metric]);
+    if (metric == metricThroughput) {
+      std::vector<double> rate;
+      for (double s : sec) {
+        rate.push_back(items_ / s);
+      }
+      report(test, desc, 0, items_, "items/s", rate);
+    } else {
+      report(test, desc, 0, items_ / 100, "us", HipPerf::toMicroseconds(sec, 1));
+    }
+  }
+
+ private:
+  // Waits for a free slot, then publishes item.
+  void push(unsigned int item) {
+    volatile WorkQueue* q = queue_;
+    while (published_ - q->tail >= RING_SIZE) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+    q->items[published_ % RING_SIZE] = item;
+    std::atomic_thread_fence(std::memory_order_seq_cst);  // item before head
+    q->head = ++published_;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  // Waits until the device retired every published item.
+  void drain() {
+    volatile WorkQueue* q = queue_;
+    while (q->tail != published_) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  unsigned int items_;
+  unsigned int published_;
+  WorkQueue* queue_;
+  WorkQueue* deviceQueue_;
+  unsigned int* out_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfPersistentKernel)
@@ -0,0 +1,137 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Round-trip latency from launching an empty kernel until the host observes
+// its completion, for every hipDeviceSchedule* flag and three ways to wait:
+// hipStreamSynchronize, hipEventSynchronize on a default event and on a
+// hipEventBlockingSync event. The CPU time the process burns while waiting is
+// reported next to the latency; text mode also prints a log2 histogram.
+//
+// hipSetDeviceFlags() is applied per test. Runtimes that only honour the flags
+// before the context is created report the same numbers for every flag; run a
+// single test with -t to measure one flag in a fresh process.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <ctime>
+
+#include "perf_harness.h"
+
+static const unsigned int scheduleFlags[] = {hipDeviceScheduleAuto, hipDeviceScheduleSpin,
+                                             hipDeviceScheduleYield, hipDeviceScheduleBlockingSync};
+static const char* scheduleStr[] = {"auto", "spin", "yield", "blockingSync"};
+static const unsigned int numSchedules = sizeof(scheduleFlags) / sizeof(scheduleFlags[0]);
+
+enum WaitMode { waitStream = 0, waitEvent, waitBlockingEvent, numWaitModes };
+
+static const char* waitModeStr[numWaitModes] = {"hipStreamSynchronize", "hipEventSynchronize",
+                                                "hipEventSynchronize(blocking)"};
+
+__global__ void _latencyKernel() {}
+
+class hipPerfSyncLatency : public HipPerf::Benchmark {
+ public:
+  hipPerfSyncLatency() : HipPerf::Benchmark("hipPerfSyncLatency"),
+      count_(HipPerf::iterationCount(10000)), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override {
+    HIPCHECK(hipStreamDestroy(stream_));
+    HIPCHECK(hipSetDeviceFlags(hipDeviceScheduleAuto));
+  }
+
+  unsigned int numTests() override { return numSchedules * numWaitModes; }
+
+  void run(unsigned int test) override {
+    unsigned int schedule = test % numSchedules;
+    WaitMode mode = static_cast<WaitMode>(test / numSchedules);
+    HIPCHECK(hipSetDeviceFlags(scheduleFlags[schedule]));
+
+    hipEvent_t event;
+    HIPCHECK(hipEventCreateWithFlags(&event, mode == waitBlockingEvent
+                                                 ? hipEventBlockingSync | hipEventDisableTiming
+                                                 : hipEventDisableTiming));
+
+    std::clock_t cpuStart = std::clock();
+    auto wallStart = std::chrono::steady_clock::now();
+    auto sec = measureEach([&]() {
+      hipLaunchKernelGGL(_latencyKernel, dim3(1), dim3(1), 0, stream_);
+      if (mode == waitStream) {
+        HIPCHECK(hipStreamSynchronize(stream_));
+      } else {
+        HIPCHECK(hipEventRecord(event, stream_));
+        HIPCHECK(hipEventSynchronize(event));
+      }
+    }, count_);
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - wallStart;
+    double cpu = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    HIPCHECK(hipEventDestroy(event));
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %s", scheduleStr[schedule], waitModeStr[mode]);
+    auto us = HipPerf::toMicroseconds(sec, 1);
+    report(test, desc, 0, count_, "us", us);
+    // Includes the warm-up runs, which wait the same way
+    report(test, std::string(desc) + " cpu", 0, count_, "%", {100.0 * cpu / wall.count()},
+           HipPerf::betterLower);
+
+    if (strcmp(p_format, "text") == 0) {
+      printHistogram(us);
+    }
+  }
+
+ private:
+  // Bucket k holds [2^k, 2^(k+1)) us, bucket 0 everything below 2 us. Empty
+  // buckets at either end are not printed.
+  static void printHistogram(const std::vector<double>& us) {
+    const int numBuckets = 24;
+    unsigned int buckets[numBuckets] = {0};
+    for (double v : us) {
+      int b = 0;
+      while (b < numBuckets - 1 && v >= (2 << b)) {
+        b++;
+      }
+      buckets[b]++;
+    }
+    int first = 0, last = numBuckets - 1;
+    while (first < last && buckets[first] == 0) first++;
+    while (last > first && buckets[last] == 0) last--;
+    for (int b = first; b <= last; b++) {
+      unsigned int bar = us.empty() ? 0 : (60 * buckets[b] + us.size() - 1) / us.size();
+      printf("  %8u us %8u |%s\n", b == 0 ? 0 : 1u << b, buckets[b], std::string(bar, '#').c_str());
+    }
+  }
+
+  unsigned int count_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfSyncLatency)
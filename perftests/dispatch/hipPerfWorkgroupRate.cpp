@@ -0,0 +1,160 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Workgroup dispatch rate against grid size. An empty kernel and one where
+// the first thread of every workgroup stores one value are launched back to
+// back with 1 to 4M workgroups (--sizes or --sweep replace them) of 64, 256
+// and 1024 threads. Per launch it reports the time and the workgroups
+// dispatched per second. After the largest grid of a kernel and block size a
+// least squares fit of time against workgroup count splits the launch into
+// its fixed cost and the cost per workgroup; the ratio of the two is the
+// grid size below which launch overhead dominates the dispatcher.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "perf_harness.h"
+
+__global__ void emptyKernel(int* out) {}
+
+__global__ void storeKernel(int* out) {
+  if (threadIdx.x == 0) {
+    out[blockIdx.x & 1023] = blockIdx.x;
+  }
+}
+
+enum RateKernel { kernelEmpty = 0, kernelStore, numRateKernels };
+static const char* rateKernelStr[numRateKernels] = {"empty", "one store per workgroup"};
+
+static const size_t defaultGridSizes[] = {1, 16, 256, 4096, 65536, 1048576, 4194304};
+static const unsigned int blockSizes[] = {64, 256, 1024};
+static const unsigned int numBlockSizes = sizeof(blockSizes) / sizeof(blockSizes[0]);
+static const size_t maxLaunchesPerRep = 100;
+static const size_t workgroupsPerRep = 1 << 22;
+
+class hipPerfWorkgroupRate : public HipPerf::Benchmark {
+ public:
+  hipPerfWorkgroupRate() : HipPerf::Benchmark("hipPerfWorkgroupRate"),
+      gridSizes_(HipPerf::sweepSizes(std::vector<size_t>(
+          defaultGridSizes, defaultGridSizes + sizeof(defaultGridSizes) /
+                                                   sizeof(defaultGridSizes[0])))),
+      out_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipMalloc(&out_, 1024 * sizeof(int)));
+  }
+
+  void close() override { HIPCHECK(hipFree(out_)); }
+
+  unsigned int numTests() override {
+    return numRateKernels * numBlockSizes * static_cast<unsigned int>(gridSizes_.size());
+  }
+
+  void run(unsigned int test) override {
+    unsigned int grids = static_cast<unsigned int>(gridSizes_.size());
+    size_t grid = gridSizes_[test % grids];
+    unsigned int block = blockSizes[test / grids % numBlockSizes];
+    RateKernel kernel = static_cast<RateKernel>(test / grids / numBlockSizes);
+    if (test % grids == 0) {
+      points_.clear();
+    }
+    if (grid == 0 || block > static_cast<unsigned int>(props_.maxThreadsPerBlock)) {
+      printf("info: %zu workgroups of %u threads not supported, skipping\n", grid, block);
+      return;
+    }
+
+    // Fewer launches for large grids keep every repetition near the same length
+    size_t launches = std::max<size_t>(1, std::min(maxLaunchesPerRep, workgroupsPerRep / grid));
+    auto sec = measure([&]() {
+      for (size_t l = 0; l < launches; l++) {
+        if (kernel == kernelEmpty) {
+          hipLaunchKernelGGL(emptyKernel, dim3(grid), dim3(block), 0, 0, out_);
+        } else {
+          hipLaunchKernelGGL(storeKernel, dim3(grid), dim3(block), 0, 0, out_);
+        }
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-23s %7zu x %4u threads", rateKernelStr[kernel], grid, block);
+    auto us = HipPerf::toMicroseconds(sec, static_cast<double>(launches));
+    report(test, std::string(desc) + " launch", 0, static_cast<unsigned int>(launches), "us",
+           us);
+    std::vector<double> rate;
+    for (double u : us) {
+      rate.push_back(grid / u);  // workgroups per us are millions per second
+    }
+    report(test, std::string(desc) + " dispatch rate", 0, static_cast<unsigned int>(launches),
+           "Mworkgroups/s", rate);
+
+    std::sort(us.begin(), us.end());
+    points_.push_back(std::make_pair(static_cast<double>(grid), us[us.size() / 2]));
+    if (test % grids == grids - 1) {
+      reportFit(test, kernel, block);
+    }
+  }
+
+ private:
+  // Least squares fit of median launch time against workgroup count
+  void reportFit(unsigned int test, RateKernel kernel, unsigned int block) {
+    if (points_.size() < 2) {
+      return;
+    }
+    double n = static_cast<double>(points_.size());
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (const auto& p : points_) {
+      sx += p.first;
+      sy += p.second;
+      sxx += p.first * p.first;
+      sxy += p.first * p.second;
+    }
+    double denom = n * sxx - sx * sx;
+    if (denom == 0) {
+      return;
+    }
+    double perWorkgroup = (n * sxy - sx * sy) / denom;
+    double fixed = (sy - perWorkgroup * sx) / n;
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-23s %4u threads", rateKernelStr[kernel], block);
+    report(test, std::string(desc) + " fixed cost", 0, 1, "us", {fixed});
+    report(test, std::string(desc) + " per workgroup", 0, 1, "ns", {perWorkgroup * 1e3});
+    if (perWorkgroup > 0) {
+      report(test, std::string(desc) + " break even grid", 0, 1, "workgroups",
+             {fixed / perWorkgroup});
+    }
+  }
+
+  std::vector<size_t> gridSizes_;
+  int* out_;
+  std::vector<std::pair<double, double>> points_;  // workgroups, median us per launch
+};
+
+HIP_PERF_BENCHMARK(hipPerfWorkgroupRate)
@@ -0,0 +1,177 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Throughput of one model graph serving concurrent requests. The graph is a
+// chain of 10 kernel nodes of 4 blocks each, too small to fill the device on
+// its own. Every repetition launches it 64 times: all on one stream from one
+// hipGraphExec (the baseline), round robin on 2 to 16 streams from the same
+// hipGraphExec, or round robin on 2 to 16 streams from as many instantiations
+// of the graph, each pointed at its own buffer with
+// hipGraphExecKernelNodeSetParams as a serving layer would. Reports graphs
+// per second, us per graph and the throughput against the baseline ("x one
+// stream"). Launches of one hipGraphExec that serialize stay near 1 on
+// several streams; the instance count where the last column stops growing
+// is the number of instances needed to saturate the device.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int streamCounts[] = {2, 4, 8, 16};
+static const unsigned int numStreamCounts = sizeof(streamCounts) / sizeof(streamCounts[0]);
+static const unsigned int maxStreams = 16;
+
+enum LaunchMode { modeSameExec = 0, modeInstances, numLaunchModes };
+static const char* launchModeStr[numLaunchModes] = {"one hipGraphExec",
+                                                    "one hipGraphExec per stream"};
+
+static const unsigned int graphNodes = 10;
+static const unsigned int nodeBlocks = 4;
+static const unsigned int nodeThreads = 256;
+static const int nodeIterations = 4096;
+static const unsigned int launchesPerRepetition = 64;
+
+__global__ void _requestKernel(float* data, int iterations) {
+  float x = threadIdx.x;
+  for (int i = 0; i < iterations; i++) {
+    x = x * 0.999f + 0.5f;
+  }
+  data[blockIdx.x * blockDim.x + threadIdx.x] = x;
+}
+
+class hipPerfGraphConcurrentLaunch : public HipPerf::Benchmark {
+ public:
+  hipPerfGraphConcurrentLaunch() : HipPerf::Benchmark("hipPerfGraphConcurrentLaunch"),
+      graph_(nullptr), iterations_(nodeIterations), baselineRate_(0) {
+    for (unsigned int s = 0; s < maxStreams; s++) {
+      streams_[s] = nullptr;
+      buffers_[s] = nullptr;
+      execs_[s] = nullptr;
+    }
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    for (unsigned int s = 0; s < maxStreams; s++) {
+      HIPCHECK(hipStreamCreateWithFlags(&streams_[s], hipStreamNonBlocking));
+      HIPCHECK(hipMalloc(&buffers_[s], sizeof(float) * nodeBlocks * nodeThreads));
+    }
+    buildChain();
+    // Instantiation is not timed; instance s writes buffers_[s]
+    for (unsigned int s = 0; s < maxStreams; s++) {
+      HIPCHECK(hipGraphInstantiate(&execs_[s], graph_, nullptr, nullptr, 0));
+      hipKernelNodeParams params = nodeParams(s);
+      for (auto node : nodes_) {
+        HIPCHECK(hipGraphExecKernelNodeSetParams(execs_[s], node, &params));
+      }
+      HIPCHECK(hipGraphUpload(execs_[s], streams_[s]));
+    }
+    HIPCHECK(hipDeviceSynchronize());
+  }
+
+  void close() override {
+    for (unsigned int s = 0; s < maxStreams; s++) {
+      HIPCHECK(hipGraphExecDestroy(execs_[s]));
+    }
+    HIPCHECK(hipGraphDestroy(graph_));
+    for (unsigned int s = 0; s < maxStreams; s++) {
+      HIPCHECK(hipFree(buffers_[s]));
+      HIPCHECK(hipStreamDestroy(streams_[s]));
+    }
+  }
+
+  // Test 0 is the single stream baseline
+  unsigned int numTests() override { return 1 + numStreamCounts * numLaunchModes; }
+
+  void run(unsigned int test) override {
+    unsigned int streams = 1;
+    LaunchMode mode = modeSameExec;
+    if (test > 0) {
+      mode = static_cast<LaunchMode>((test - 1) % numLaunchModes);
+      streams = streamCounts[(test - 1) / numLaunchModes];
+    }
+
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < launchesPerRepetition; i++) {
+        unsigned int s = i % streams;
+        HIPCHECK(hipGraphLaunch(execs_[mode == modeInstances ? s : 0], streams_[s]));
+      }
+      for (unsigned int s = 0; s < streams; s++) {
+        HIPCHECK(hipStreamSynchronize(streams_[s]));
+      }
+    });
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%2u streams %s", streams, launchModeStr[mode]);
+    // 1e6 per launch turns GB/s into Kgraphs/s
+    auto rate = HipPerf::toBandwidth(sec, 1e6 * launchesPerRepetition);
+    report(test, desc, 0, launchesPerRepetition, "Kgraphs/s", rate);
+    report(test, desc, 0, launchesPerRepetition, "us",
+           HipPerf::toMicroseconds(sec, launchesPerRepetition));
+    double median = ComputePerfStats(rate).median;
+    if (test == 0) {
+      baselineRate_ = median;
+    } else if (baselineRate_ > 0) {
+      report(test, desc, 0, launchesPerRepetition, "x one stream", {median / baselineRate_});
+    }
+  }
+
+ private:
+  hipKernelNodeParams nodeParams(unsigned int buffer) {
+    kernelArgs_[0] = &buffers_[buffer];
+    kernelArgs_[1] = &iterations_;
+    hipKernelNodeParams params = {};
+    params.func = reinterpret_cast<void*>(_requestKernel);
+    params.gridDim = dim3(nodeBlocks);
+    params.blockDim = dim3(nodeThreads);
+    params.sharedMemBytes = 0;
+    params.kernelParams = kernelArgs_;
+    params.extra = nullptr;
+    return params;
+  }
+
+  void buildChain() {
+    hipKernelNodeParams params = nodeParams(0);
+    HIPCHECK(hipGraphCreate(&graph_, 0));
+    nodes_.resize(graphNodes);
+    for (unsigned int i = 0; i < graphNodes; i++) {
+      HIPCHECK(hipGraphAddKernelNode(&nodes_[i], graph_, i > 0 ? &nodes_[i - 1] : nullptr,
+                                     i > 0 ? 1 : 0, &params));
+    }
+  }
+
+  hipStream_t streams_[maxStreams];
+  float* buffers_[maxStreams];
+  hipGraphExec_t execs_[maxStreams];
+  hipGraph_t graph_;
+  std::vector<hipGraphNode_t> nodes_;
+  int iterations_;
+  void* kernelArgs_[2];
+  double baselineRate_;  // median Kgraphs/s of test 0
+};
+
+HIP_PERF_BENCHMARK(hipPerfGraphConcurrentLaunch)
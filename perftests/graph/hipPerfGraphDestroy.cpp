@@ -0,0 +1,208 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Teardown cost of short lived graphs: hipGraphDestroy of a graph of 10 to
+// 10k chained kernel nodes, hipGraphExecDestroy of its executable graph after
+// one launch, and the latency from the last release of the user objects
+// attached to the graph until their destructor callback ran. 0, 1 or 64 user
+// objects are moved into every graph with hipGraphRetainUserObject; the
+// executable graph holds its own reference, so for the latency the graph is
+// destroyed first and hipGraphExecDestroy drops the last one. The latency is
+// taken to the last of the callbacks, which the runtime may run on another
+// thread. Every repetition builds, instantiates and launches a new graph,
+// only the destroy call (or the release to callback interval) is timed.
+
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int graphSizes[] = {10, 100, 1000, 10000};
+static const unsigned int numGraphSizes = sizeof(graphSizes) / sizeof(graphSizes[0]);
+
+static const unsigned int userObjectCounts[] = {0, 1, 64};
+static const unsigned int numUserObjectCounts =
+    sizeof(userObjectCounts) / sizeof(userObjectCounts[0]);
+
+enum DestroyOp { opGraphDestroy = 0, opExecDestroy, opCallbackLatency, numDestroyOps };
+static const char* destroyOpStr[numDestroyOps] = {"hipGraphDestroy", "hipGraphExecDestroy",
+                                                  "release to destructor callback"};
+
+// Callbacks that did not arrive after this long fail the test
+static const double callbackTimeoutSec = 10.0;
+
+__global__ void _destroyKernel(int* out, int value) {
+  if (threadIdx.x == 0) out[blockIdx.x] = value;
+}
+
+static int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Shared by the user objects of one graph
+struct DestructorState {
+  std::atomic<unsigned int> pending{0};
+  std::atomic<int64_t> lastNs{0};
+};
+
+static void userObjectDestructor(void* data) {
+  auto state = static_cast<DestructorState*>(data);
+  int64_t now = nowNs();
+  int64_t last = state->lastNs.load();
+  while (last < now && !state->lastNs.compare_exchange_weak(last, now)) {
+  }
+  state->pending--;
+}
+
+class hipPerfGraphDestroy : public HipPerf::Benchmark {
+ public:
+  hipPerfGraphDestroy() : HipPerf::Benchmark("hipPerfGraphDestroy"), stream_(nullptr),
+      buffer_(nullptr), value_(1) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&buffer_, sizeof(int)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(buffer_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numGraphSizes * numUserObjectCounts * numDestroyOps; }
+
+  void run(unsigned int test) override {
+    DestroyOp op = static_cast<DestroyOp>(test % numDestroyOps);
+    unsigned int objects = userObjectCounts[(test / numDestroyOps) % numUserObjectCounts];
+    unsigned int size = graphSizes[test / (numDestroyOps * numUserObjectCounts)];
+    if (op == opCallbackLatency && objects == 0) {
+      return;
+    }
+
+    std::vector<double> sec;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      DestructorState state;
+      hipGraph_t graph = buildChain(size, objects, &state);
+      hipGraphExec_t exec = nullptr;
+      if (op != opGraphDestroy) {
+        HIPCHECK(hipGraphInstantiate(&exec, graph, nullptr, nullptr, 0));
+        HIPCHECK(hipGraphLaunch(exec, stream_));
+        HIPCHECK(hipStreamSynchronize(stream_));
+      }
+
+      double elapsed = 0;
+      int64_t releaseNs = 0;
+      auto start = std::chrono::steady_clock::now();
+      switch (op) {
+        case opGraphDestroy:
+          HIPCHECK(hipGraphDestroy(graph));
+          elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+          break;
+        case opExecDestroy:
+          HIPCHECK(hipGraphExecDestroy(exec));
+          elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+          HIPCHECK(hipGraphDestroy(graph));
+          break;
+        default: {
+          HIPCHECK(hipGraphDestroy(graph));
+          if (state.pending.load() != objects) {
+            failed("%u of %u user objects destroyed while the executable graph holds them",
+                   objects - state.pending.load(), objects);
+          }
+          releaseNs = nowNs();
+          HIPCHECK(hipGraphExecDestroy(exec));
+          break;
+        }
+      }
+      waitForCallbacks(state);
+      if (op == opCallbackLatency) {
+        elapsed = (state.lastNs.load() - releaseNs) * 1e-9;
+      }
+      if (r >= p_warmup) {
+        sec.push_back(elapsed);
+      }
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%5u nodes %2u user objects %s", size, objects,
+             destroyOpStr[op]);
+    report(test, desc, 0, size, "us", HipPerf::toMicroseconds(sec, 1));
+  }
+
+ private:
+  hipGraph_t buildChain(unsigned int size, unsigned int objects, DestructorState* state) {
+    kernelArgs_[0] = &buffer_;
+    kernelArgs_[1] = &value_;
+    hipKernelNodeParams params = {};
+    params.func = reinterpret_cast<void*>(_destroyKernel);
+    params.gridDim = dim3(1);
+    params.blockDim = dim3(1);
+    params.sharedMemBytes = 0;
+    params.kernelParams = kernelArgs_;
+    params.extra = nullptr;
+
+    hipGraph_t graph;
+    HIPCHECK(hipGraphCreate(&graph, 0));
+    std::vector<hipGraphNode_t> nodes(size);
+    for (unsigned int i = 0; i < size; i++) {
+      HIPCHECK(hipGraphAddKernelNode(&nodes[i], graph, i > 0 ? &nodes[i - 1] : nullptr,
+                                     i > 0 ? 1 : 0, &params));
+    }
+    state->pending.store(objects);
+    for (unsigned int i = 0; i < objects; i++) {
+      hipUserObject_t object;
+      HIPCHECK(hipUserObjectCreate(&object, state, userObjectDestructor, 1,
+                                   hipUserObjectNoDestructorSync));
+      HIPCHECK(hipGraphRetainUserObject(graph, object, 1, hipGraphUserObjectMove));
+    }
+    return graph;
+  }
+
+  // The destructors may run asynchronously, the state must outlive them
+  void waitForCallbacks(const DestructorState& state) {
+    auto start = std::chrono::steady_clock::now();
+    while (state.pending.load() != 0) {
+      if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >
+          callbackTimeoutSec) {
+        failed("%u user object destructors did not run", state.pending.load());
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  hipStream_t stream_;
+  int* buffer_;
+  int value_;
+  void* kernelArgs_[2];
+};
+
+HIP_PERF_BENCHMARK(hipPerfGraphDestroy)
@@ -0,0 +1,235 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// End-to-end cost of a matrix multiply pipeline (copy A and B in, four
+// dependent multiplies with the matmulK kernel of the hipMatMul graph test,
+// copy the result out) submitted three ways: directly on a stream, as a graph
+// captured from that stream, and as a graph built node by node. Reports time
+// and process CPU time per pipeline run.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <ctime>
+
+#include "perf_harness.h"
+
+static const unsigned int matrixDims[] = {64, 256, 512};
+static const unsigned int numMatrixDims = sizeof(matrixDims) / sizeof(matrixDims[0]);
+
+enum SubmitMode { submitStream = 0, submitCapture, submitExplicit, numSubmitModes };
+
+static const char* submitModeStr[numSubmitModes] = {"stream", "stream capture",
+                                                    "explicit graph"};
+
+#define PIPELINE_STEPS 4
+#define TILE 16
+
+__global__ void matmulK(int* A, int* B, int* C, int N) {
+  int ROW = blockIdx.y*blockDim.y+threadIdx.y;
+  int COL = blockIdx.x*blockDim.x+threadIdx.x;
+  int tmpSum = 0;
+  if ((ROW < N) && (COL < N)) {
+    // each thread computes one element of the block sub-matrix
+    for (int i = 0; i < N; i++) {
+      tmpSum += A[ROW * N + i] * B[i * N + COL];
+    }
+    C[ROW * N + COL] = tmpSum;
+  }
+}
+
+class hipPerfGraphMatMul : public HipPerf::Benchmark {
+ public:
+  hipPerfGraphMatMul() : HipPerf::Benchmark("hipPerfGraphMatMul"),
+      runs_(HipPerf::iterationCount(100)) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override { HIPCHECK(hipStreamDestroy(stream_)); }
+
+  unsigned int numTests() override { return numMatrixDims * numSubmitModes; }
+
+  void run(unsigned int test) override {
+    SubmitMode mode = static_cast<SubmitMode>(test % numSubmitModes);
+    int n = matrixDims[test / numSubmitModes];
+    size_t bytes = static_cast<size_t>(n) * n * sizeof(int);
+
+    HIPCHECK(hipHostMalloc(&hostA_, bytes, hipHostMallocDefault));
+    HIPCHECK(hipHostMalloc(&hostB_, bytes, hipHostMallocDefault));
+    HIPCHECK(hipHostMalloc(&hostOut_, bytes, hipHostMallocDefault));
+    for (int i = 0; i < n * n; i++) {
+      hostA_[i] = i % 3;
+      hostB_[i] = (i % 5) - 2;
+    }
+    HIPCHECK(hipMalloc(&devA_, bytes));
+    HIPCHECK(hipMalloc(&devB_, bytes));
+    for (int i = 0; i < 2; i++) {
+      HIPCHECK(hipMalloc(&devC_[i], bytes));
+    }
+    n_ = n;
+    bytes_ = bytes;
+
+    hipGraph_t graph = nullptr;
+    hipGraphExec_t exec = nullptr;
+    if (mode == submitCapture) {
+      HIPCHECK(hipStreamBeginCapture(stream_, hipStreamCaptureModeGlobal));
+      enqueuePipeline();
+      HIPCHECK(hipStreamEndCapture(stream_, &graph));
+    } else if (mode == submitExplicit) {
+      graph = buildGraph();
+    }
+    if (graph != nullptr) {
+      HIPCHECK(hipGraphInstantiate(&exec, graph, nullptr, nullptr, 0));
+    }
+
+    std::clock_t cpuStart = std::clock();
+    auto sec = measure([&]() {
+      for (unsigned int r = 0; r < runs_; r++) {
+        if (exec != nullptr) {
+          HIPCHECK(hipGraphLaunch(exec, stream_));
+        } else {
+          enqueuePipeline();
+        }
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    double cpu = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    unsigned int totalRuns = runs_ * (p_warmup + p_repetitions);
+    checkResult();
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%3dx%-3d %s", n, n, submitModeStr[mode]);
+    report(test, desc, bytes, runs_, "us/run", HipPerf::toMicroseconds(sec, runs_));
+    report(test, std::string(desc) + " cpu", bytes, runs_, "us/run",
+           {cpu * 1e6 / totalRuns});
+
+    if (exec != nullptr) {
+      HIPCHECK(hipGraphExecDestroy(exec));
+      HIPCHECK(hipGraphDestroy(graph));
+    }
+    HIPCHECK(hipHostFree(hostA_));
+    HIPCHECK(hipHostFree(hostB_));
+    HIPCHECK(hipHostFree(hostOut_));
+    HIPCHECK(hipFree(devA_));
+    HIPCHECK(hipFree(devB_));
+    for (int i = 0; i < 2; i++) {
+      HIPCHECK(hipFree(devC_[i]));
+    }
+  }
+
+ private:
+  dim3 grid() const { return dim3((n_ + TILE - 1) / TILE, (n_ + TILE - 1) / TILE); }
+
+  // Step 0 computes A*B, every further step multiplies the previous result by B.
+  int* stepInput(int step) const { return step == 0 ? devA_ : devC_[(step - 1) % 2]; }
+  int* stepOutput(int step) const { return devC_[step % 2]; }
+
+  void enqueuePipeline() {
+    HIPCHECK(hipMemcpyAsync(devA_, hostA_, bytes_, hipMemcpyHostToDevice, stream_));
+    HIPCHECK(hipMemcpyAsync(devB_, hostB_, bytes_, hipMemcpyHostToDevice, stream_));
+    for (int s = 0; s < PIPELINE_STEPS; s++) {
+      hipLaunchKernelGGL(matmulK, grid(), dim3(TILE, TILE), 0, stream_, stepInput(s), devB_,
+                         stepOutput(s), n_);
+    }
+    HIPCHECK(hipMemcpyAsync(hostOut_, stepOutput(PIPELINE_STEPS - 1), bytes_,
+                            hipMemcpyDeviceToHost, stream_));
+  }
+
+  hipGraph_t buildGraph() {
+    hipGraph_t graph;
+    HIPCHECK(hipGraphCreate(&graph, 0));
+    hipGraphNode_t copyIn[2];
+    HIPCHECK(hipGraphAddMemcpyNode1D(&copyIn[0], graph, nullptr, 0, devA_, hostA_, bytes_,
+                                     hipMemcpyHostToDevice));
+    HIPCHECK(hipGraphAddMemcpyNode1D(&copyIn[1], graph, nullptr, 0, devB_, hostB_, bytes_,
+                                     hipMemcpyHostToDevice));
+
+    hipGraphNode_t prev = nullptr;
+    for (int s = 0; s < PIPELINE_STEPS; s++) {
+      int* in = stepInput(s);
+      int* out = stepOutput(s);
+      void* args[] = {&in, &devB_, &out, &n_};
+      hipKernelNodeParams params = {};
+      params.func = reinterpret_cast<void*>(matmulK);
+      params.gridDim = grid();
+      params.blockDim = dim3(TILE, TILE);
+      params.sharedMemBytes = 0;
+      params.kernelParams = args;
+      params.extra = nullptr;
+      hipGraphNode_t node;
+      if (s == 0) {
+        HIPCHECK(hipGraphAddKernelNode(&node, graph, copyIn, 2, &params));
+      } else {
+        HIPCHECK(hipGraphAddKernelNode(&node, graph, &prev, 1, &params));
+      }
+      prev = node;
+    }
+
+    hipGraphNode_t copyOut;
+    HIPCHECK(hipGraphAddMemcpyNode1D(&copyOut, graph, &prev, 1, hostOut_,
+                                     stepOutput(PIPELINE_STEPS - 1), bytes_,
+                                     hipMemcpyDeviceToHost));
+    return graph;
+  }
+
+  // Recomputes the pipeline on the host and compares the diagonal
+  void checkResult() {
+    std::vector<long long> ref(hostA_, hostA_ + n_ * n_), tmp(n_ * n_);
+    for (int s = 0; s < PIPELINE_STEPS; s++) {
+      for (int r = 0; r < n_; r++) {
+        for (int c = 0; c < n_; c++) {
+          long long sum = 0;
+          for (int i = 0; i < n_; i++) {
+            sum += ref[r * n_ + i] * hostB_[i * n_ + c];
+          }
+          tmp[r * n_ + c] = static_cast<int>(sum);
+        }
+      }
+      ref.swap(tmp);
+    }
+    for (int i = 0; i < n_ * n_; i += n_ + 1) {
+      if (hostOut_[i] != static_cast<int>(ref[i])) {
+        failed("Result mismatch at %d: got %d, expected %d", i, hostOut_[i],
+               static_cast<int>(ref[i]));
+      }
+    }
+  }
+
+  unsigned int runs_;  // pipeline runs per repetition
+  int n_;
+  size_t bytes_;
+  hipStream_t stream_;
+  int* hostA_;
+  int* hostB_;
+  int* hostOut_;
+  int* devA_;
+  int* devB_;
+  int* devC_[2];
+};
+
+HIP_PERF_BENCHMARK(hipPerfGraphMatMul)
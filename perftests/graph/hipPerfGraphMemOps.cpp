@@ -0,0 +1,216 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// The same device memset (32 bit elements) or device to device memcpy done
+// four ways: as stream operations (hipMemsetD32Async / hipMemcpyAsync), as
+// graph memset / memcpy nodes, as graph kernel nodes running a fill / copy
+// kernel, and as the kernel launched on the stream. 1 or 16 operations are
+// timed until the stream is synchronized, in a single graph launch for the
+// graph paths; sizes from 4 bytes to 64 MB (--sizes replaces them). Reports
+// us per operation and GB/s, so small sizes show the submission overhead of
+// each path and large ones the copy engine or kernel throughput behind it.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const std::vector<size_t> Sizes = {4, 4096, 1048576, 67108864};
+static const unsigned int opCounts[] = {1, 16};
+static const unsigned int numOpCounts = sizeof(opCounts) / sizeof(opCounts[0]);
+
+enum MemOp { opMemset = 0, opMemcpy, numMemOps };
+static const char* memOpStr[numMemOps] = {"memset", "memcpy"};
+
+enum OpPath { pathStream = 0, pathGraphNode, pathKernelNode, pathStreamKernel, numOpPaths };
+static const char* opPathStr[numOpPaths] = {"stream op", "graph node", "graph kernel node",
+                                            "stream kernel"};
+
+static const unsigned int threadsPerBlockMemOps = 256;
+static const unsigned int maxBlocksMemOps = 1024;
+
+__global__ void _fillKernel(uint32_t* dst, uint32_t value, size_t count) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < count;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    dst[i] = value;
+  }
+}
+
+__global__ void _copyKernel(uint32_t* dst, const uint32_t* src, size_t count) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < count;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    dst[i] = src[i];
+  }
+}
+
+class hipPerfGraphMemOps : public HipPerf::Benchmark {
+ public:
+  hipPerfGraphMemOps() : HipPerf::Benchmark("hipPerfGraphMemOps"),
+      sizes_(HipPerf::sweepSizes(Sizes)), stream_(nullptr), src_(nullptr), dst_(nullptr),
+      value_(0x5a5a5a5a), count_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    size_t maxSize = *std::max_element(sizes_.begin(), sizes_.end());
+    HIPCHECK(hipMalloc(&src_, maxSize));
+    HIPCHECK(hipMalloc(&dst_, maxSize));
+    HIPCHECK(hipMemset(src_, 1, maxSize));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(src_));
+    HIPCHECK(hipFree(dst_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override {
+    return sizes_.size() * numOpPaths * numMemOps * numOpCounts;
+  }
+
+  void run(unsigned int test) override {
+    size_t size = sizes_[test % sizes_.size()];
+    OpPath path = static_cast<OpPath>((test / sizes_.size()) % numOpPaths);
+    MemOp op = static_cast<MemOp>((test / (sizes_.size() * numOpPaths)) % numMemOps);
+    unsigned int ops = opCounts[test / (sizes_.size() * numOpPaths * numMemOps)];
+    if (size % sizeof(uint32_t) != 0) {
+      printf("info: size %zu is not a multiple of 4 bytes, skipping\n", size);
+      return;
+    }
+    count_ = size / sizeof(uint32_t);
+    unsigned int blocks = static_cast<unsigned int>(std::min<size_t>(
+        (count_ + threadsPerBlockMemOps - 1) / threadsPerBlockMemOps, maxBlocksMemOps));
+
+    hipGraph_t graph = nullptr;
+    hipGraphExec_t exec = nullptr;
+    if (path == pathGraphNode || path == pathKernelNode) {
+      // A chain, like the stream paths execute them
+      HIPCHECK(hipGraphCreate(&graph, 0));
+      hipGraphNode_t prev = nullptr;
+      for (unsigned int i = 0; i < ops; i++) {
+        hipGraphNode_t node;
+        addNode(op, path, blocks, graph, &node, prev);
+        prev = node;
+      }
+      HIPCHECK(hipGraphInstantiate(&exec, graph, nullptr, nullptr, 0));
+      HIPCHECK(hipGraphUpload(exec, stream_));
+      HIPCHECK(hipStreamSynchronize(stream_));
+    }
+
+    auto sec = measure([&]() {
+      if (exec != nullptr) {
+        HIPCHECK(hipGraphLaunch(exec, stream_));
+      } else {
+        for (unsigned int i = 0; i < ops; i++) {
+          enqueue(op, path, blocks, size);
+        }
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    if (exec != nullptr) {
+      HIPCHECK(hipGraphExecDestroy(exec));
+      HIPCHECK(hipGraphDestroy(graph));
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %-17s x%-2u", memOpStr[op], opPathStr[path], ops);
+    report(test, desc, size, ops, "us", HipPerf::toMicroseconds(sec, ops));
+    // A memcpy reads and writes every byte
+    report(test, desc, size, ops, "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(size) * ops * (op == opMemcpy ? 2 : 1)));
+  }
+
+ private:
+  void enqueue(MemOp op, OpPath path, unsigned int blocks, size_t size) {
+    if (path == pathStream) {
+      if (op == opMemset) {
+        HIPCHECK(hipMemsetD32Async(reinterpret_cast<hipDeviceptr_t>(dst_), value_, count_,
+                                   stream_));
+      } else {
+        HIPCHECK(hipMemcpyAsync(dst_, src_, size, hipMemcpyDeviceToDevice, stream_));
+      }
+    } else if (op == opMemset) {
+      hipLaunchKernelGGL(_fillKernel, dim3(blocks), dim3(threadsPerBlockMemOps), 0, stream_,
+                         dst_, value_, count_);
+    } else {
+      hipLaunchKernelGGL(_copyKernel, dim3(blocks), dim3(threadsPerBlockMemOps), 0, stream_,
+                         dst_, static_cast<const uint32_t*>(src_), count_);
+    }
+  }
+
+  void addNode(MemOp op, OpPath path, unsigned int blocks, hipGraph_t graph,
+               hipGraphNode_t* node, hipGraphNode_t prev) {
+    const hipGraphNode_t* deps = prev != nullptr ? &prev : nullptr;
+    size_t numDeps = prev != nullptr ? 1 : 0;
+    if (path == pathGraphNode) {
+      if (op == opMemset) {
+        hipMemsetParams params = {};
+        params.dst = dst_;
+        params.elementSize = sizeof(uint32_t);
+        params.width = count_;
+        params.height = 1;
+        params.value = value_;
+        HIPCHECK(hipGraphAddMemsetNode(node, graph, deps, numDeps, &params));
+      } else {
+        HIPCHECK(hipGraphAddMemcpyNode1D(node, graph, deps, numDeps, dst_, src_,
+                                         count_ * sizeof(uint32_t), hipMemcpyDeviceToDevice));
+      }
+      return;
+    }
+    // The arguments are copied when the node is added
+    void* args[3];
+    hipKernelNodeParams params = {};
+    params.gridDim = dim3(blocks);
+    params.blockDim = dim3(threadsPerBlockMemOps);
+    params.sharedMemBytes = 0;
+    params.extra = nullptr;
+    if (op == opMemset) {
+      args[0] = &dst_;
+      args[1] = &value_;
+      args[2] = &count_;
+      params.func = reinterpret_cast<void*>(_fillKernel);
+    } else {
+      args[0] = &dst_;
+      args[1] = &src_;
+      args[2] = &count_;
+      params.func = reinterpret_cast<void*>(_copyKernel);
+    }
+    params.kernelParams = args;
+    HIPCHECK(hipGraphAddKernelNode(node, graph, deps, numDeps, &params));
+  }
+
+  std::vector<size_t> sizes_;
+  hipStream_t stream_;
+  uint32_t* src_;
+  uint32_t* dst_;
+  uint32_t value_;
+  size_t count_;  // elements of the test being run
+};
+
+HIP_PERF_BENCHMARK(hipPerfGraphMemOps)
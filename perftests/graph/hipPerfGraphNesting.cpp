@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Instantiate time and launch latency of hierarchical graphs against the
+// flattened graph doing the same work. A nested graph of depth d and breadth
+// b has b child graph nodes per level, d levels deep, with one kernel node in
+// every innermost graph, b^d kernels in total; the siblings of a level are
+// either a chain or independent. The flat graph holds the same b^d kernel
+// nodes directly, as one chain or all independent. Whether flattening before
+// instantiate pays off shows in the nested/flat pairs of every shape.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int nestingDepths[] = {1, 2, 3, 4};
+static const unsigned int numNestingDepths = sizeof(nestingDepths) / sizeof(nestingDepths[0]);
+static const unsigned int nestingBreadths[] = {2, 4, 8};
+static const unsigned int numNestingBreadths =
+    sizeof(nestingBreadths) / sizeof(nestingBreadths[0]);
+
+enum Topology { topoChain = 0, topoParallel, numTopologies };
+enum GraphForm { formNested = 0, formFlat, numGraphForms };
+
+static const char* topologyStr[numTopologies] = {"chain", "parallel"};
+static const char* graphFormStr[numGraphForms] = {"nested", "flat"};
+
+__global__ void _nestingKernel(int* out, int value) {
+  if (threadIdx.x == 0) out[blockIdx.x] = value;
+}
+
+class hipPerfGraphNesting : public HipPerf::Benchmark {
+ public:
+  hipPerfGraphNesting() : HipPerf::Benchmark("hipPerfGraphNesting"), stream_(nullptr),
+      buffer_(nullptr), value_(1) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&buffer_, sizeof(int)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(buffer_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override {
+    return numNestingDepths * numNestingBreadths * numTopologies * numGraphForms;
+  }
+
+  void run(unsigned int test) override {
+    GraphForm form = static_cast<GraphForm>(test % numGraphForms);
+    Topology topology = static_cast<Topology>((test / numGraphForms) % numTopologies);
+    unsigned int breadth = nestingBreadths[(test / (numGraphForms * numTopologies)) %
+                                           numNestingBreadths];
+    unsigned int depth = nestingDepths[test / (numGraphForms * numTopologies *
+                                               numNestingBreadths)];
+    unsigned int kernels = 1;
+    for (unsigned int d = 0; d < depth; d++) {
+      kernels *= breadth;
+    }
+
+    hipGraph_t graph = form == formNested ? buildNested(depth, breadth, topology)
+                                          : buildLevel(kernels, topology, nullptr);
+
+    std::vector<hipGraphExec_t> execs;
+    std::vector<double> sec = measure([&]() {
+      hipGraphExec_t e;
+      HIPCHECK(hipGraphInstantiate(&e, graph, nullptr, nullptr, 0));
+      execs.push_back(e);
+    });
+    for (size_t i = 1; i < execs.size(); i++) {
+      HIPCHECK(hipGraphExecDestroy(execs[i]));
+    }
+    hipGraphExec_t exec = execs[0];
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "depth %u breadth %u %s %s (%u kernels)", depth, breadth,
+             topologyStr[topology], graphFormStr[form], kernels);
+    std::string prefix(desc);
+    report(test, prefix + " hipGraphInstantiate", 0, kernels, "us",
+           HipPerf::toMicroseconds(sec, 1));
+
+    HIPCHECK(hipGraphUpload(exec, stream_));
+    HIPCHECK(hipStreamSynchronize(stream_));
+    sec = measure([&]() {
+      HIPCHECK(hipGraphLaunch(exec, stream_));
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    report(test, prefix + " launch", 0, kernels, "us", HipPerf::toMicroseconds(sec, 1));
+    report(test, prefix + " launch per kernel", 0, kernels, "us",
+           HipPerf::toMicroseconds(sec, kernels));
+
+    HIPCHECK(hipGraphExecDestroy(exec));
+    HIPCHECK(hipGraphDestroy(graph));
+  }
+
+ private:
+  // A graph of 'count' nodes, kernels when child is null and otherwise child graph nodes
+  hipGraph_t buildLevel(unsigned int count, Topology topology, hipGraph_t child) {
+    kernelArgs_[0] = &buffer_;
+    kernelArgs_[1] = &value_;
+    hipKernelNodeParams params = {};
+    params.func = reinterpret_cast<void*>(_nestingKernel);
+    params.gridDim = dim3(1);
+    params.blockDim = dim3(1);
+    params.sharedMemBytes = 0;
+    params.kernelParams = kernelArgs_;
+    params.extra = nullptr;
+
+    hipGraph_t graph;
+    HIPCHECK(hipGraphCreate(&graph, 0));
+    std::vector<hipGraphNode_t> nodes(count);
+    for (unsigned int i = 0; i < count; i++) {
+      const hipGraphNode_t* deps = topology == topoChain && i > 0 ? &nodes[i - 1] : nullptr;
+      size_t numDeps = deps != nullptr ? 1 : 0;
+      if (child == nullptr) {
+        HIPCHECK(hipGraphAddKernelNode(&nodes[i], graph, deps, numDeps, &params));
+      } else {
+        HIPCHECK(hipGraphAddChildGraphNode(&nodes[i], graph, deps, numDeps, child));
+      }
+    }
+    return graph;
+  }
+
+  // Child graph nodes hold a copy of their graph, so one inner graph serves every sibling
+  hipGraph_t buildNested(unsigned int depth, unsigned int breadth, Topology topology) {
+    hipGraph_t inner = buildLevel(1, topology, nullptr);
+    for (unsigned int d = 0; d < depth; d++) {
+      hipGraph_t outer = buildLevel(breadth, topology, inner);
+      HIPCHECK(hipGraphDestroy(inner));
+      inner = outer;
+    }
+    return inner;
+  }
+
+  hipStream_t stream_;
+  int* buffer_;
+  int value_;
+  void* kernelArgs_[2];
+};
+
+HIP_PERF_BENCHMARK(hipPerfGraphNesting)
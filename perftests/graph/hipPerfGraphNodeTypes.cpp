@@ -0,0 +1,215 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Execution cost per node of graphs made of a single node type: kernel,
+// device to device memcpy, memset, host, event record, event wait, empty and
+// child graph (one kernel). Graphs of 100 and 1000 nodes are a chain or a
+// fan-out from the first node; their fan-out time against the chain shows
+// whether a node type serializes the graph. Every graph is instantiated and
+// uploaded once, then hipGraphLaunch plus hipStreamSynchronize is timed. For
+// the node types that can be disabled (kernel, memcpy, memset) the host cost
+// of hipGraphNodeSetEnabled and the launch of the graph with every node
+// disabled are reported as well.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int graphSizes[] = {100, 1000};
+static const unsigned int numGraphSizes = sizeof(graphSizes) / sizeof(graphSizes[0]);
+
+enum Topology { topoChain = 0, topoFanOut, numTopologies };
+static const char* topologyStr[numTopologies] = {"chain", "fan-out"};
+
+enum NodeType { nodeKernel = 0, nodeMemcpy, nodeMemset, nodeHost, nodeEventRecord,
+                nodeEventWait, nodeEmpty, nodeChildGraph, numNodeTypes };
+static const char* nodeTypeStr[numNodeTypes] = {"kernel", "memcpy", "memset", "host",
+                                                "event record", "event wait", "empty",
+                                                "child graph"};
+
+__global__ void _nodeTypeKernel(int* out, int value) {
+  if (threadIdx.x == 0) out[blockIdx.x] = value;
+}
+
+static void _nodeTypeHostFunc(void*) {}
+
+class hipPerfGraphNodeTypes : public HipPerf::Benchmark {
+ public:
+  hipPerfGraphNodeTypes() : HipPerf::Benchmark("hipPerfGraphNodeTypes"), stream_(nullptr),
+      event_(nullptr), src_(nullptr), dst_(nullptr), child_(nullptr), value_(1) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipEventCreateWithFlags(&event_, hipEventDisableTiming));
+    // Event wait nodes wait on an event that has already completed
+    HIPCHECK(hipEventRecord(event_, stream_));
+    HIPCHECK(hipStreamSynchronize(stream_));
+    HIPCHECK(hipMalloc(&src_, sizeof(int)));
+    HIPCHECK(hipMalloc(&dst_, sizeof(int)));
+
+    hipKernelNodeParams params = kernelParams();
+    hipGraphNode_t node;
+    HIPCHECK(hipGraphCreate(&child_, 0));
+    HIPCHECK(hipGraphAddKernelNode(&node, child_, nullptr, 0, &params));
+  }
+
+  void close() override {
+    HIPCHECK(hipGraphDestroy(child_));
+    HIPCHECK(hipFree(src_));
+    HIPCHECK(hipFree(dst_));
+    HIPCHECK(hipEventDestroy(event_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numGraphSizes * numTopologies * numNodeTypes; }
+
+  void run(unsigned int test) override {
+    NodeType type = static_cast<NodeType>(test % numNodeTypes);
+    Topology topology = static_cast<Topology>((test / numNodeTypes) % numTopologies);
+    unsigned int size = graphSizes[test / (numNodeTypes * numTopologies)];
+
+    hipGraph_t graph;
+    std::vector<hipGraphNode_t> nodes(size);
+    HIPCHECK(hipGraphCreate(&graph, 0));
+    for (unsigned int i = 0; i < size; i++) {
+      const hipGraphNode_t* deps = nullptr;
+      size_t numDeps = 0;
+      if (i > 0) {
+        deps = topology == topoChain ? &nodes[i - 1] : &nodes[0];
+        numDeps = 1;
+      }
+      addNode(type, &nodes[i], graph, deps, numDeps);
+    }
+    hipGraphExec_t exec;
+    HIPCHECK(hipGraphInstantiate(&exec, graph, nullptr, nullptr, 0));
+    HIPCHECK(hipGraphUpload(exec, stream_));
+    HIPCHECK(hipStreamSynchronize(stream_));
+
+    auto launch = [&]() {
+      HIPCHECK(hipGraphLaunch(exec, stream_));
+      HIPCHECK(hipStreamSynchronize(stream_));
+    };
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%4u %s %s nodes", size, topologyStr[topology],
+             nodeTypeStr[type]);
+    std::string prefix(desc);
+    std::vector<double> sec = measure(launch);
+    report(test, prefix + " launch", 0, size, "us", HipPerf::toMicroseconds(sec, 1));
+    report(test, prefix + " per node", 0, size, "us", HipPerf::toMicroseconds(sec, size));
+
+    if (type == nodeKernel || type == nodeMemcpy || type == nodeMemset) {
+      // A disable and an enable call for every node
+      sec = measure([&]() {
+        for (hipGraphNode_t node : nodes) {
+          HIPCHECK(hipGraphNodeSetEnabled(exec, node, 0));
+        }
+        for (hipGraphNode_t node : nodes) {
+          HIPCHECK(hipGraphNodeSetEnabled(exec, node, 1));
+        }
+      });
+      report(test, prefix + " hipGraphNodeSetEnabled", 0, 2 * size, "us",
+             HipPerf::toMicroseconds(sec, 2 * size));
+
+      for (hipGraphNode_t node : nodes) {
+        HIPCHECK(hipGraphNodeSetEnabled(exec, node, 0));
+      }
+      sec = measure(launch);
+      report(test, prefix + " launch all disabled", 0, size, "us",
+             HipPerf::toMicroseconds(sec, 1));
+    }
+
+    HIPCHECK(hipGraphExecDestroy(exec));
+    HIPCHECK(hipGraphDestroy(graph));
+  }
+
+ private:
+  hipKernelNodeParams kernelParams() {
+    kernelArgs_[0] = &dst_;
+    kernelArgs_[1] = &value_;
+    hipKernelNodeParams params = {};
+    params.func = reinterpret_cast<void*>(_nodeTypeKernel);
+    params.gridDim = dim3(1);
+    params.blockDim = dim3(1);
+    params.sharedMemBytes = 0;
+    params.kernelParams = kernelArgs_;
+    params.extra = nullptr;
+    return params;
+  }
+
+  void addNode(NodeType type, hipGraphNode_t* node, hipGraph_t graph,
+               const hipGraphNode_t* deps, size_t numDeps) {
+    switch (type) {
+      case nodeKernel: {
+        hipKernelNodeParams params = kernelParams();
+        HIPCHECK(hipGraphAddKernelNode(node, graph, deps, numDeps, &params));
+        break;
+      }
+      case nodeMemcpy:
+        HIPCHECK(hipGraphAddMemcpyNode1D(node, graph, deps, numDeps, dst_, src_, sizeof(int),
+                                         hipMemcpyDeviceToDevice));
+        break;
+      case nodeMemset: {
+        hipMemsetParams params = {};
+        params.dst = dst_;
+        params.elementSize = sizeof(int);
+        params.width = 1;
+        params.height = 1;
+        params.value = 0;
+        HIPCHECK(hipGraphAddMemsetNode(node, graph, deps, numDeps, &params));
+        break;
+      }
+      case nodeHost: {
+        hipHostNodeParams params = {_nodeTypeHostFunc, nullptr};
+        HIPCHECK(hipGraphAddHostNode(node, graph, deps, numDeps, &params));
+        break;
+      }
+      case nodeEventRecord:
+        HIPCHECK(hipGraphAddEventRecordNode(node, graph, deps, numDeps, event_));
+        break;
+      case nodeEventWait:
+        HIPCHECK(hipGraphAddEventWaitNode(node, graph, deps, numDeps, event_));
+        break;
+      case nodeEmpty:
+        HIPCHECK(hipGraphAddEmptyNode(node, graph, deps, numDeps));
+        break;
+      default:
+        HIPCHECK(hipGraphAddChildGraphNode(node, graph, deps, numDeps, child_));
+        break;
+    }
+  }
+
+  hipStream_t stream_;
+  hipEvent_t event_;
+  int* src_;
+  int* dst_;
+  hipGraph_t child_;
+  int value_;
+  void* kernelArgs_[2];
+};
+
+HIP_PERF_BENCHMARK(hipPerfGraphNodeTypes)
@@ -0,0 +1,199 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Host cost of rebuilding versus updating a graph as it grows from 10 to 100k
+// kernel nodes: hipGraphInstantiate, hipGraphExecUpdate from a graph of the
+// same topology with new arguments, hipGraphExecKernelNodeSetParams on every
+// node, and hipGraphClone. Topologies are a chain, a fan-out from one root and
+// a diamond (root, parallel middle, one sink).
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+
+static const unsigned int graphSizes[] = {10, 100, 1000, 10000, 100000};
+static const unsigned int numGraphSizes = sizeof(graphSizes) / sizeof(graphSizes[0]);
+
+enum Topology { topoChain = 0, topoFanOut, topoDiamond, numTopologies };
+enum GraphOp { opInstantiate = 0, opExecUpdate, opNodeSetParams, opClone, numGraphOps };
+
+static const char* topologyStr[numTopologies] = {"chain", "fan-out", "diamond"};
+static const char* graphOpStr[numGraphOps] = {"hipGraphInstantiate", "hipGraphExecUpdate",
+                                              "hipGraphExecKernelNodeSetParams", "hipGraphClone"};
+
+__global__ void _graphNodeKernel(int* out, int value) {
+  if (threadIdx.x == 0) out[blockIdx.x] = value;
+}
+
+// A graph and its kernel nodes in insertion order.
+struct KernelGraph {
+  hipGraph_t graph = nullptr;
+  std::vector<hipGraphNode_t> nodes;
+};
+
+class hipPerfGraphUpdate : public HipPerf::Benchmark {
+ public:
+  hipPerfGraphUpdate() : HipPerf::Benchmark("hipPerfGraphUpdate"), buffer_(nullptr),
+      builtSize_(0), builtTopology_(numTopologies) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipMalloc(&buffer_, sizeof(int)));
+  }
+
+  void close() override {
+    release();
+    HIPCHECK(hipFree(buffer_));
+  }
+
+  unsigned int numTests() override { return numGraphSizes * numTopologies * numGraphOps; }
+
+  void run(unsigned int test) override {
+    GraphOp op = static_cast<GraphOp>(test % numGraphOps);
+    Topology topology = static_cast<Topology>((test / numGraphOps) % numTopologies);
+    unsigned int size = graphSizes[test / (numGraphOps * numTopologies)];
+
+    // Graphs are shared by the ops of one size and topology
+    if (size != builtSize_ || topology != builtTopology_) {
+      release();
+      build(&graph_, size, topology, 1);
+      build(&updated_, size, topology, 2);
+      builtSize_ = size;
+      builtTopology_ = topology;
+    }
+
+    std::vector<hipGraphExec_t> execs;
+    std::vector<hipGraph_t> clones;
+    hipGraphExec_t exec = nullptr;
+    if (op == opExecUpdate || op == opNodeSetParams) {
+      HIPCHECK(hipGraphInstantiate(&exec, graph_.graph, nullptr, nullptr, 0));
+    }
+    int value = 3;
+    hipKernelNodeParams params = nodeParams(&value);
+
+    std::vector<double> sec = measure([&]() {
+      switch (op) {
+        case opInstantiate: {
+          hipGraphExec_t e;
+          HIPCHECK(hipGraphInstantiate(&e, graph_.graph, nullptr, nullptr, 0));
+          execs.push_back(e);
+          break;
+        }
+        case opExecUpdate: {
+          hipGraphNode_t errorNode;
+          hipGraphExecUpdateResult result;
+          HIPCHECK(hipGraphExecUpdate(exec, updated_.graph, &errorNode, &result));
+          if (result != hipGraphExecUpdateSuccess) {
+            failed("hipGraphExecUpdate of a %s graph failed with %d", topologyStr[topology],
+                   result);
+          }
+          break;
+        }
+        case opNodeSetParams:
+          for (hipGraphNode_t node : graph_.nodes) {
+            HIPCHECK(hipGraphExecKernelNodeSetParams(exec, node, &params));
+          }
+          break;
+        default: {
+          hipGraph_t clone;
+          HIPCHECK(hipGraphClone(&clone, graph_.graph));
+          clones.push_back(clone);
+          break;
+        }
+      }
+    });
+
+    for (hipGraphExec_t e : execs) {
+      HIPCHECK(hipGraphExecDestroy(e));
+    }
+    for (hipGraph_t g : clones) {
+      HIPCHECK(hipGraphDestroy(g));
+    }
+    if (exec != nullptr) {
+      HIPCHECK(hipGraphExecDestroy(exec));
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%6u nodes %s %s", size, topologyStr[topology], graphOpStr[op]);
+    report(test, desc, 0, size, "us", HipPerf::toMicroseconds(sec, 1));
+    report(test, std::string(desc) + " per node", 0, size, "us",
+           HipPerf::toMicroseconds(sec, size));
+  }
+
+ private:
+  hipKernelNodeParams nodeParams(int* value) {
+    kernelArgs_[0] = &buffer_;
+    kernelArgs_[1] = value;
+    hipKernelNodeParams params = {};
+    params.func = reinterpret_cast<void*>(_graphNodeKernel);
+    params.gridDim = dim3(1);
+    params.blockDim = dim3(1);
+    params.sharedMemBytes = 0;
+    params.kernelParams = kernelArgs_;
+    params.extra = nullptr;
+    return params;
+  }
+
+  void build(KernelGraph* g, unsigned int size, Topology topology, int value) {
+    hipKernelNodeParams params = nodeParams(&value);
+    HIPCHECK(hipGraphCreate(&g->graph, 0));
+    g->nodes.resize(size);
+    for (unsigned int i = 0; i < size; i++) {
+      const hipGraphNode_t* deps = nullptr;
+      size_t numDeps = 0;
+      if (i > 0) {
+        if (topology == topoChain) {
+          deps = &g->nodes[i - 1];
+          numDeps = 1;
+        } else if (topology == topoDiamond && i == size - 1 && size > 2) {
+          deps = &g->nodes[1];
+          numDeps = size - 2;
+        } else {
+          deps = &g->nodes[0];
+          numDeps = 1;
+        }
+      }
+      HIPCHECK(hipGraphAddKernelNode(&g->nodes[i], g->graph, deps, numDeps, &params));
+    }
+  }
+
+  void release() {
+    if (graph_.graph != nullptr) {
+      HIPCHECK(hipGraphDestroy(graph_.graph));
+      HIPCHECK(hipGraphDestroy(updated_.graph));
+      graph_ = KernelGraph();
+      updated_ = KernelGraph();
+    }
+  }
+
+  int* buffer_;
+  void* kernelArgs_[2];
+  KernelGraph graph_;
+  KernelGraph updated_;  // same topology as graph_, different kernel argument
+  unsigned int builtSize_;
+  Topology builtTopology_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfGraphUpdate)
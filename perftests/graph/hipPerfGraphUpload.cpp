@@ -0,0 +1,155 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// First launch against subsequent launch latency of a freshly instantiated
+// graph of 10 to 10k chained kernel nodes, without hipGraphUpload, with the
+// upload on the launch stream, or with the upload on a separate stream that
+// is synchronized before the launch. Every repetition instantiates a new
+// executable graph (not timed), uploads it when asked (timed on its own),
+// then times the first hipGraphLaunch with its synchronize and the mean of
+// the following launches. The gap between first and subsequent launches is
+// the latency pre-staging can hide.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int graphSizes[] = {10, 100, 1000, 10000};
+static const unsigned int numGraphSizes = sizeof(graphSizes) / sizeof(graphSizes[0]);
+
+enum UploadMode { uploadNone = 0, uploadLaunchStream, uploadSeparateStream, numUploadModes };
+static const char* uploadModeStr[numUploadModes] = {"no upload", "upload on launch stream",
+                                                    "upload on separate stream"};
+
+static const unsigned int subsequentLaunches = 10;
+
+__global__ void _uploadKernel(int* out, int value) {
+  if (threadIdx.x == 0) out[blockIdx.x] = value;
+}
+
+class hipPerfGraphUpload : public HipPerf::Benchmark {
+ public:
+  hipPerfGraphUpload() : HipPerf::Benchmark("hipPerfGraphUpload"), launchStream_(nullptr),
+      uploadStream_(nullptr), buffer_(nullptr), value_(1) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&launchStream_, hipStreamNonBlocking));
+    HIPCHECK(hipStreamCreateWithFlags(&uploadStream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&buffer_, sizeof(int)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(buffer_));
+    HIPCHECK(hipStreamDestroy(uploadStream_));
+    HIPCHECK(hipStreamDestroy(launchStream_));
+  }
+
+  unsigned int numTests() override { return numGraphSizes * numUploadModes; }
+
+  void run(unsigned int test) override {
+    UploadMode mode = static_cast<UploadMode>(test % numUploadModes);
+    unsigned int size = graphSizes[test / numUploadModes];
+    hipGraph_t graph = buildChain(size);
+
+    std::vector<double> uploadSec, firstSec, subsequentSec;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      hipGraphExec_t exec;
+      HIPCHECK(hipGraphInstantiate(&exec, graph, nullptr, nullptr, 0));
+
+      auto start = std::chrono::steady_clock::now();
+      if (mode != uploadNone) {
+        hipStream_t stream = mode == uploadLaunchStream ? launchStream_ : uploadStream_;
+        HIPCHECK(hipGraphUpload(exec, stream));
+        HIPCHECK(hipStreamSynchronize(stream));
+      }
+      double upload = HipTest::secondsSince(start);
+
+      start = std::chrono::steady_clock::now();
+      HIPCHECK(hipGraphLaunch(exec, launchStream_));
+      HIPCHECK(hipStreamSynchronize(launchStream_));
+      double first = HipTest::secondsSince(start);
+
+      start = std::chrono::steady_clock::now();
+      for (unsigned int i = 0; i < subsequentLaunches; i++) {
+        HIPCHECK(hipGraphLaunch(exec, launchStream_));
+        HIPCHECK(hipStreamSynchronize(launchStream_));
+      }
+      double subsequent = HipTest::secondsSince(start) / subsequentLaunches;
+
+      HIPCHECK(hipGraphExecDestroy(exec));
+      if (r >= p_warmup) {
+        uploadSec.push_back(upload);
+        firstSec.push_back(first);
+        subsequentSec.push_back(subsequent);
+      }
+    }
+    HIPCHECK(hipGraphDestroy(graph));
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%5u nodes %s", size, uploadModeStr[mode]);
+    std::string prefix(desc);
+    if (mode != uploadNone) {
+      report(test, prefix + " hipGraphUpload", 0, size, "us",
+             HipPerf::toMicroseconds(uploadSec, 1));
+    }
+    report(test, prefix + " first launch", 0, size, "us", HipPerf::toMicroseconds(firstSec, 1));
+    report(test, prefix + " subsequent launch", 0, size, "us",
+           HipPerf::toMicroseconds(subsequentSec, 1));
+  }
+
+ private:
+  hipGraph_t buildChain(unsigned int size) {
+    kernelArgs_[0] = &buffer_;
+    kernelArgs_[1] = &value_;
+    hipKernelNodeParams params = {};
+    params.func = reinterpret_cast<void*>(_uploadKernel);
+    params.gridDim = dim3(1);
+    params.blockDim = dim3(1);
+    params.sharedMemBytes = 0;
+    params.kernelParams = kernelArgs_;
+    params.extra = nullptr;
+
+    hipGraph_t graph;
+    HIPCHECK(hipGraphCreate(&graph, 0));
+    std::vector<hipGraphNode_t> nodes(size);
+    for (unsigned int i = 0; i < size; i++) {
+      HIPCHECK(hipGraphAddKernelNode(&nodes[i], graph, i > 0 ? &nodes[i - 1] : nullptr,
+                                     i > 0 ? 1 : 0, &params));
+    }
+    return graph;
+  }
+
+  hipStream_t launchStream_;
+  hipStream_t uploadStream_;
+  int* buffer_;
+  int value_;
+  void* kernelArgs_[2];
+};
+
+HIP_PERF_BENCHMARK(hipPerfGraphUpload)
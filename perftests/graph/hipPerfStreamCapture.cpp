@@ -0,0 +1,188 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Host cost of capturing 10 to 10k operations into a graph, per capture mode
+// (global, thread local, relaxed) and per operation kind: kernel launches,
+// device to device hipMemcpyAsync, hipMemsetAsync, hipLaunchHostFunc, or all
+// four in turn. Every repetition captures the operations again and times the
+// enqueue calls of the capture (including hipStreamBeginCapture),
+// hipStreamEndCapture, hipGraphInstantiate of the new graph and
+// hipGraphExecUpdate of an executable graph captured before. The two totals
+// compare re-capture + instantiate with re-capture + update, the choice a
+// caller has when the work changes every iteration.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int captureSizes[] = {10, 100, 1000, 10000};
+static const unsigned int numCaptureSizes = sizeof(captureSizes) / sizeof(captureSizes[0]);
+
+enum CaptureOp { capKernel = 0, capMemcpy, capMemset, capHostFunc, capMixed, numCaptureOps };
+static const char* captureOpStr[numCaptureOps] = {"kernel", "memcpy", "memset", "host func",
+                                                  "mixed"};
+
+static const hipStreamCaptureMode captureModes[] = {
+    hipStreamCaptureModeGlobal, hipStreamCaptureModeThreadLocal, hipStreamCaptureModeRelaxed};
+static const unsigned int numCaptureModes = sizeof(captureModes) / sizeof(captureModes[0]);
+static const char* captureModeStr[numCaptureModes] = {"global", "thread local", "relaxed"};
+
+__global__ void _captureKernel(int* out, int value) {
+  if (threadIdx.x == 0) out[blockIdx.x] = value;
+}
+
+static void _captureHostFunc(void*) {}
+
+class hipPerfStreamCapture : public HipPerf::Benchmark {
+ public:
+  hipPerfStreamCapture() : HipPerf::Benchmark("hipPerfStreamCapture"), stream_(nullptr),
+      src_(nullptr), dst_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&src_, sizeof(int)));
+    HIPCHECK(hipMalloc(&dst_, sizeof(int)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(src_));
+    HIPCHECK(hipFree(dst_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numCaptureSizes * numCaptureModes * numCaptureOps; }
+
+  void run(unsigned int test) override {
+    CaptureOp op = static_cast<CaptureOp>(test % numCaptureOps);
+    unsigned int modeIndex = (test / numCaptureOps) % numCaptureModes;
+    unsigned int size = captureSizes[test / (numCaptureOps * numCaptureModes)];
+    hipStreamCaptureMode mode = captureModes[modeIndex];
+
+    // The executable graph every new capture is applied to with hipGraphExecUpdate
+    hipGraph_t baseGraph;
+    capture(op, mode, size, &baseGraph);
+    hipGraphExec_t baseExec;
+    HIPCHECK(hipGraphInstantiate(&baseExec, baseGraph, nullptr, nullptr, 0));
+    HIPCHECK(hipGraphDestroy(baseGraph));
+
+    std::vector<double> captureSec, endSec, instantiateSec, updateSec;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      hipGraph_t graph;
+      double end = 0;
+      double enqueue = capture(op, mode, size, &graph, &end);
+
+      auto start = std::chrono::steady_clock::now();
+      hipGraphExec_t exec;
+      HIPCHECK(hipGraphInstantiate(&exec, graph, nullptr, nullptr, 0));
+      double instantiate = HipTest::secondsSince(start);
+
+      hipGraphNode_t errorNode;
+      hipGraphExecUpdateResult result;
+      start = std::chrono::steady_clock::now();
+      HIPCHECK(hipGraphExecUpdate(baseExec, graph, &errorNode, &result));
+      double update = HipTest::secondsSince(start);
+      if (result != hipGraphExecUpdateSuccess) {
+        failed("hipGraphExecUpdate of a captured %s graph failed with %d", captureOpStr[op],
+               result);
+      }
+
+      HIPCHECK(hipGraphExecDestroy(exec));
+      HIPCHECK(hipGraphDestroy(graph));
+      if (r >= p_warmup) {
+        captureSec.push_back(enqueue);
+        endSec.push_back(end);
+        instantiateSec.push_back(instantiate);
+        updateSec.push_back(update);
+      }
+    }
+    HIPCHECK(hipGraphExecDestroy(baseExec));
+
+    std::vector<double> withInstantiate, withUpdate;
+    for (size_t i = 0; i < captureSec.size(); i++) {
+      withInstantiate.push_back(captureSec[i] + endSec[i] + instantiateSec[i]);
+      withUpdate.push_back(captureSec[i] + endSec[i] + updateSec[i]);
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%5u %s %s", size, captureOpStr[op], captureModeStr[modeIndex]);
+    std::string prefix(desc);
+    report(test, prefix + " capture per op", 0, size, "us",
+           HipPerf::toMicroseconds(captureSec, size));
+    report(test, prefix + " hipStreamEndCapture", 0, size, "us",
+           HipPerf::toMicroseconds(endSec, 1));
+    report(test, prefix + " hipGraphInstantiate", 0, size, "us",
+           HipPerf::toMicroseconds(instantiateSec, 1));
+    report(test, prefix + " hipGraphExecUpdate", 0, size, "us",
+           HipPerf::toMicroseconds(updateSec, 1));
+    report(test, prefix + " capture + instantiate", 0, size, "us",
+           HipPerf::toMicroseconds(withInstantiate, 1));
+    report(test, prefix + " capture + update", 0, size, "us",
+           HipPerf::toMicroseconds(withUpdate, 1));
+  }
+
+ private:
+  // Captures size operations into graph. Returns the seconds from hipStreamBeginCapture to the
+  // last enqueue and stores the seconds of hipStreamEndCapture in endSec when given.
+  double capture(CaptureOp op, hipStreamCaptureMode mode, unsigned int size, hipGraph_t* graph,
+                 double* endSec = nullptr) {
+    auto start = std::chrono::steady_clock::now();
+    HIPCHECK(hipStreamBeginCapture(stream_, mode));
+    for (unsigned int i = 0; i < size; i++) {
+      CaptureOp kind = op == capMixed ? static_cast<CaptureOp>(i % capMixed) : op;
+      switch (kind) {
+        case capKernel:
+          hipLaunchKernelGGL(_captureKernel, dim3(1), dim3(1), 0, stream_, dst_,
+                             static_cast<int>(i));
+          break;
+        case capMemcpy:
+          HIPCHECK(hipMemcpyAsync(dst_, src_, sizeof(int), hipMemcpyDeviceToDevice, stream_));
+          break;
+        case capMemset:
+          HIPCHECK(hipMemsetAsync(dst_, 0, sizeof(int), stream_));
+          break;
+        default:
+          HIPCHECK(hipLaunchHostFunc(stream_, _captureHostFunc, nullptr));
+          break;
+      }
+    }
+    double enqueue = HipTest::secondsSince(start);
+    start = std::chrono::steady_clock::now();
+    HIPCHECK(hipStreamEndCapture(stream_, graph));
+    if (endSec != nullptr) {
+      *endSec = HipTest::secondsSince(start);
+    }
+    return enqueue;
+  }
+
+  hipStream_t stream_;
+  int* src_;
+  int* dst_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfStreamCapture)
@@ -0,0 +1,197 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/*
+ * Mandelbrot kernels shared by the compute and stream perftests.
+ *
+ * float_mad_kernel computes one pixel per thread with one fma-based iteration
+ * per escape test. mandelbrot computes 4 pixels per thread on float4 with 16
+ * iterations between escape tests, so width must be divisible by 4.
+ */
+
+#pragma once
+
+#include <hip/hip_runtime.h>
+#include <hip/hip_vector_types.h>
+
+#ifdef __HIP_PLATFORM_NVIDIA__
+inline __device__ float4 operator*(float s, float4 a)
+{
+  return make_float4(a.x * s, a.y * s, a.z * s, a.w * s);
+}
+inline __device__ float4 operator*(float4 a, float4 b)
+{
+  return make_float4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
+}
+inline __device__ float4 operator+(float4 a, float4 b)
+{
+  return make_float4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+}
+inline __device__ float4 operator-(float4 a, float4 b)
+{
+  return make_float4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+}
+#endif
+
+template <typename T>
+__global__ void float_mad_kernel(uint *out, uint width, T xPos,  T yPos, T xStep, T yStep,
+                                  uint maxIter) {
+
+#pragma FP_CONTRACT ON
+  int tid = (blockIdx.x * blockDim.x + threadIdx.x);
+  int i = tid % width;
+  int j = tid / width;
+  float x0 = (float)(xPos + xStep*i);
+  float y0 = (float)(yPos + yStep*j);
+
+  float x = x0;
+  float y = y0;
+
+  uint iter = 0;
+  float tmp;
+  for (iter = 0; (x*x + y*y <= 4.0f) && (iter < maxIter); iter++) {
+    tmp = x;
+    x = fma(-y,y,fma(x,x,x0));
+    y = fma(2.0f*tmp,y,y0);
+  }
+
+  out[tid] = iter;
+};
+
+__global__ void mandelbrot(uint *out, uint width, float xPos, float yPos,
+         float xStep, float yStep, uint maxIter) {
+  int tid = (blockIdx.x * blockDim.x + threadIdx.x);
+  int i = tid % (width/4);
+  int j = tid / (width/4);
+  int4 veci = make_int4(4*i, 4*i+1, 4*i+2, 4*i+3);
+  int4 vecj = make_int4(j, j, j, j);
+  float4 x0;
+  x0.x = (float)(xPos + xStep*veci.x);
+  x0.y = (float)(xPos + xStep*veci.y);
+  x0.z = (float)(xPos + xStep*veci.z);
+  x0.w = (float)(xPos + xStep*veci.w);
+  float4 y0;
+  y0.x = (float)(yPos + yStep*vecj.x);
+  y0.y = (float)(yPos + yStep*vecj.y);
+  y0.z = (float)(yPos + yStep*vecj.z);
+  y0.w = (float)(yPos + yStep*vecj.w);
+  float4 x = x0;
+  float4 y = y0;
+  uint iter = 0;
+  float4 tmp;
+  int4 stay;
+  int4 ccount = make_int4(0, 0, 0, 0);
+  float4 savx = x;
+  float4 savy = y;
+  stay.x = (x.x*x.x+y.x*y.x) <= (float)(4.0f);
+  stay.y = (x.y*x.y+y.y*y.y) <= (float)(4.0f);
+  stay.z = (x.z*x.z+y.z*y.z) <= (float)(4.0f);
+  stay.w = (x.w*x.w+y.w*y.w) <= (float)(4.0f);
+  for (iter = 0; (stay.x | stay.y | stay.z | stay.w) && (iter < maxIter);
+  iter+=16) {
+    x = savx;
+    y = savy;
+    // Two iterations
+    tmp = x*x + x0 - y*y;
+    y = 2.0f * x * y + y0;
+    x = tmp*tmp + x0 - y*y;
+    y = 2.0f * tmp * y + y0;
+    // Two iterations
+    tmp = x*x + x0 - y*y;
+    y = 2.0f * x * y + y0;
+    x = tmp*tmp + x0 - y*y;
+    y = 2.0f * tmp * y + y0;
+    // Two iterations
+    tmp = x*x + x0 - y*y;
+    y = 2.0f * x * y + y0;
+    x = tmp*tmp + x0 - y*y;
+    y = 2.0f * tmp * y + y0;
+    // Two iterations
+    tmp = x*x + x0 - y*y;
+    y = 2.0f * x * y + y0;
+    x = tmp*tmp + x0 - y*y;
+    y = 2.0f * tmp * y + y0;
+    // Two iterations
+    tmp = x*x + x0 - y*y;
+    y = 2.0f * x * y + y0;
+    x = tmp*tmp + x0 - y*y;
+    y = 2.0f * tmp * y + y0;
+    // Two iterations
+    tmp = x*x + x0 - y*y;
+    y = 2.0f * x * y + y0;
+    x = tmp*tmp + x0 - y*y;
+    y = 2.0f * tmp * y + y0;
+    // Two iterations
+    tmp = x*x + x0 - y*y;
+    y = 2.0f * x * y + y0;
+    x = tmp*tmp + x0 - y*y;
+    y = 2.0f * tmp * y + y0;
+    stay.x = (x.x*x.x+y.x*y.x) <= (float)(4.0f);
+    stay.y = (x.y*x.y+y.y*y.y) <= (float)(4.0f);
+    stay.z = (x.z*x.z+y.z*y.z) <= (float)(4.0f);
+    stay.w = (x.w*x.w+y.w*y.w) <= (float)(4.0f);
+    savx.x = (bool)(stay.x ? x.x : savx.x);
+    savx.y = (bool)(stay.y ? x.y : savx.y);
+    savx.z = (bool)(stay.z ? x.z : savx.z);
+    savx.w = (bool)(stay.w ? x.w : savx.w);
+    savy.x = (bool)(stay.x ? y.x : savy.x);
+    savy.y = (bool)(stay.y ? y.y : savy.y);
+    savy.z = (bool)(stay.z ? y.z : savy.z);
+    savy.w = (bool)(stay.w ? y.w : savy.w);
+    ccount.x -= stay.x*16;
+    ccount.y -= stay.y*16;
+    ccount.z -= stay.z*16;
+    ccount.w -= stay.w*16;
+  }
+  // Handle remainder
+  if (!(stay.x & stay.y & stay.z & stay.w))
+  {
+    iter = 16;
+    do
+    {
+      x = savx;
+      y = savy;
+      stay.x = ((x.x*x.x+y.x*y.x) <= 4.0f) && (ccount.x <  maxIter);
+      stay.y = ((x.y*x.y+y.y*y.y) <= 4.0f) && (ccount.y <  maxIter);
+      stay.z = ((x.z*x.z+y.z*y.z) <= 4.0f) && (ccount.z <  maxIter);
+      stay.w = ((x.w*x.w+y.w*y.w) <= 4.0f) && (ccount.w <  maxIter);
+      tmp = x;
+      x = x*x + x0 - y*y;
+      y = 2.0f*tmp*y + y0;
+      ccount.x += stay.x;
+      ccount.y += stay.y;
+      ccount.z += stay.z;
+      ccount.w += stay.w;
+      iter--;
+      savx.x = (stay.x ? x.x : savx.x);
+      savx.y = (stay.y ? x.y : savx.y);
+      savx.z = (stay.z ? x.z : savx.z);
+      savx.w = (stay.w ? x.w : savx.w);
+      savy.x = (stay.x ? y.x : savy.x);
+      savy.y = (stay.y ? y.y : savy.y);
+      savy.z = (stay.z ? y.z : savy.z);
+      savy.w = (stay.w ? y.w : savy.w);
+    } while ((stay.x | stay.y | stay.z | stay.w) && iter);
+  }
+  uint4 *vecOut = (uint4 *)out;
+  vecOut[tid].x = (uint)(ccount.x);
+  vecOut[tid].y = (uint)(ccount.y);
+  vecOut[tid].z = (uint)(ccount.z);
+  vecOut[tid].w = (uint)(ccount.w);
+}
@@ -0,0 +1,326 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Sum all-reduce of a float buffer over all devices, as a baseline for the
+// peer fabric that does not depend on a collective library. Three algorithms:
+// ring (reduce-scatter then all-gather of 1/N chunks, each step a
+// hipMemcpyPeerAsync into the next device plus a reduction kernel there),
+// binary tree (reduce the whole buffer to device 0, then broadcast it back)
+// and direct (with peer access enabled, every device sums its chunk by
+// loading it from all peers and then gathers the other chunks from their
+// owners). Steps are ordered across devices with events, the host only waits
+// at the end. Algorithm bandwidth is the message size over the time of one
+// all-reduce. Each algorithm is checked once per size before it is timed.
+// Peer access is enabled between all devices when every pair supports it.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "perf_harness.h"
+
+enum AllReduceAlgo { algoRing, algoTree, algoDirect, numAllReduceAlgos };
+static const char* allReduceAlgoStr[] = {"ring", "tree", "direct peer load"};
+
+static const int maxDirectDevices = 16;
+
+struct PeerBuffers {
+  float* p[maxDirectDevices];
+};
+
+__global__ void fillKernel(float* data, size_t n, float value) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    data[i] = value;
+  }
+}
+
+__global__ void reduceKernel(float* dst, const float* src, size_t n) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    dst[i] += src[i];
+  }
+}
+
+// Sums chunk 'self' of every device's buffer into the own buffer
+__global__ void directReduceKernel(PeerBuffers buffers, int count, int self, size_t chunk) {
+  size_t offset = self * chunk;
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < chunk; i += gridDim.x * blockDim.x) {
+    float sum = 0;
+    for (int p = 0; p < count; p++) {
+      sum += buffers.p[p][offset + i];
+    }
+    buffers.p[self][offset + i] = sum;
+  }
+}
+
+// Loads every chunk but its own from the device owning it
+__global__ void directGatherKernel(PeerBuffers buffers, int count, int self, size_t chunk) {
+  size_t n = chunk * count;
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    int owner = static_cast<int>(i / chunk);
+    if (owner != self) {
+      buffers.p[self][i] = buffers.p[owner][i];
+    }
+  }
+}
+
+class hipPerfAllReduce : public HipPerf::Benchmark {
+ public:
+  hipPerfAllReduce() : HipPerf::Benchmark("hipPerfAllReduce"),
+      sizes_(HipPerf::sweepSizes({64 << 10, 1 << 20, 16 << 20, 128 << 20})),
+      numIter_(HipPerf::iterationCount(10)), numGpus_(0), allPeers_(false) {
+    HIPCHECK(hipGetDeviceCount(&numGpus_));
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    streams_.resize(numGpus_);
+    events_.resize(numGpus_);
+    for (int d = 0; d < numGpus_; d++) {
+      HIPCHECK(hipSetDevice(d));
+      HIPCHECK(hipStreamCreateWithFlags(&streams_[d], hipStreamNonBlocking));
+      HIPCHECK(hipEventCreateWithFlags(&events_[d], hipEventDisableTiming));
+    }
+    allPeers_ = numGpus_ > 1;
+    for (int a = 0; a < numGpus_; a++) {
+      for (int b = 0; b < numGpus_; b++) {
+        int canAccess = 0;
+        if (a != b) {
+          HIPCHECK(hipDeviceCanAccessPeer(&canAccess, a, b));
+          allPeers_ = allPeers_ && canAccess;
+        }
+      }
+    }
+    if (allPeers_) {
+      for (int a = 0; a < numGpus_; a++) {
+        HIPCHECK(hipSetDevice(a));
+        for (int b = 0; b < numGpus_; b++) {
+          if (a != b) {
+            HIPCHECK(hipDeviceEnablePeerAccess(b, 0));
+          }
+        }
+      }
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+  }
+
+  void close() override {
+    for (int d = 0; d < numGpus_; d++) {
+      HIPCHECK(hipSetDevice(d));
+      HIPCHECK(hipEventDestroy(events_[d]));
+      HIPCHECK(hipStreamDestroy(streams_[d]));
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+  }
+
+  unsigned int numTests() override { return sizes_.size() * numAllReduceAlgos; }
+
+  void run(unsigned int test) override {
+    AllReduceAlgo algo = static_cast<AllReduceAlgo>(test % numAllReduceAlgos);
+    size_t size = sizes_[test / numAllReduceAlgos];
+    if (numGpus_ < 2) {
+      printf("info: all-reduce needs at least 2 devices, skipping\n");
+      return;
+    }
+    if (algo == algoDirect && (!allPeers_ || numGpus_ > maxDirectDevices)) {
+      printf("info: not all of the %d devices can access each other, skipping %s\n", numGpus_,
+             allReduceAlgoStr[algo]);
+      return;
+    }
+
+    // Whole chunks per device
+    chunk_ = size / sizeof(float) / numGpus_;
+    n_ = chunk_ * numGpus_;
+    buffers_.resize(numGpus_);
+    scratch_.resize(numGpus_);
+    for (int d = 0; d < numGpus_; d++) {
+      HIPCHECK(hipSetDevice(d));
+      HIPCHECK(hipMalloc(&buffers_[d], n_ * sizeof(float)));
+      HIPCHECK(hipMalloc(&scratch_[d], n_ * sizeof(float)));
+    }
+
+    verify(algo);
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < numIter_; i++) {
+        allReduce(algo);
+      }
+      for (int d = 0; d < numGpus_; d++) {
+        HIPCHECK(hipStreamSynchronize(streams_[d]));
+      }
+    });
+
+    for (int d = 0; d < numGpus_; d++) {
+      HIPCHECK(hipSetDevice(d));
+      HIPCHECK(hipFree(buffers_[d]));
+      HIPCHECK(hipFree(scratch_[d]));
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+
+    size_t bytes = n_ * sizeof(float);
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-16s %d devices %10zu bytes", allReduceAlgoStr[algo],
+             numGpus_, bytes);
+    report(test, desc, bytes, numIter_, "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(bytes) * numIter_));
+    report(test, desc, bytes, numIter_, "us", HipPerf::toMicroseconds(sec, numIter_));
+  }
+
+ private:
+  // Orders the next work on the waiter's stream after the signaler's last step
+  void waitFor(int waiter, int signaler) {
+    HIPCHECK(hipStreamWaitEvent(streams_[waiter], events_[signaler], 0));
+  }
+
+  void signal(int d) { HIPCHECK(hipEventRecord(events_[d], streams_[d])); }
+
+  // Orders every stream after the current work of all streams
+  void barrier() {
+    for (int d = 0; d < numGpus_; d++) {
+      signal(d);
+    }
+    for (int d = 0; d < numGpus_; d++) {
+      for (int p = 0; p < numGpus_; p++) {
+        if (p != d) {
+          waitFor(d, p);
+        }
+      }
+    }
+  }
+
+  void reduce(int d, float* dst, const float* src, size_t n) {
+    HIPCHECK(hipSetDevice(d));
+    hipLaunchKernelGGL(reduceKernel, dim3(1024), dim3(256), 0, streams_[d], dst, src, n);
+  }
+
+  void copy(int dstDevice, float* dst, int srcDevice, const float* src, size_t n) {
+    HIPCHECK(hipMemcpyPeerAsync(dst, dstDevice, src, srcDevice, n * sizeof(float),
+                                streams_[dstDevice]));
+  }
+
+  void allReduce(AllReduceAlgo algo) {
+    int count = numGpus_;
+    // Nothing may still read a buffer from the previous run
+    barrier();
+
+    if (algo == algoRing) {
+      // Reduce-scatter, device r ends up with the sum of chunk r + 1
+      for (int s = 0; s < count - 1; s++) {
+        for (int r = 0; r < count; r++) {
+          waitFor(r, (r + count - 1) % count);
+        }
+        for (int r = 0; r < count; r++) {
+          int p = (r + count - 1) % count;
+          size_t c = (p - s + count) % count;
+          copy(r, scratch_[r], p, buffers_[p] + c * chunk_, chunk_);
+          reduce(r, buffers_[r] + c * chunk_, scratch_[r], chunk_);
+          signal(r);
+        }
+      }
+      // All-gather writes chunks that neighbours read during the reduce-scatter
+      barrier();
+      // All-gather, every step forwards the chunk received in the last one
+      for (int s = 0; s < count - 1; s++) {
+        for (int r = 0; r < count; r++) {
+          waitFor(r, (r + count - 1) % count);
+        }
+        for (int r = 0; r < count; r++) {
+          int p = (r + count - 1) % count;
+          size_t c = (p + 1 - s + count) % count;
+          copy(r, buffers_[r] + c * chunk_, p, buffers_[p] + c * chunk_, chunk_);
+          signal(r);
+        }
+      }
+    } else if (algo == algoTree) {
+      int top = 1;
+      for (int step = 1; step < count; step *= 2) {
+        for (int r = 0; r + step < count; r += 2 * step) {
+          waitFor(r, r + step);
+          copy(r, scratch_[r], r + step, buffers_[r + step], n_);
+          reduce(r, buffers_[r], scratch_[r], n_);
+          signal(r);
+        }
+        top = step;
+      }
+      for (int step = top; step >= 1; step /= 2) {
+        for (int r = 0; r + step < count; r += 2 * step) {
+          waitFor(r + step, r);
+          copy(r + step, buffers_[r + step], r, buffers_[r], n_);
+          signal(r + step);
+        }
+      }
+    } else {
+      PeerBuffers peers;
+      for (int d = 0; d < count; d++) {
+        peers.p[d] = buffers_[d];
+      }
+      for (int d = 0; d < count; d++) {
+        HIPCHECK(hipSetDevice(d));
+        hipLaunchKernelGGL(directReduceKernel, dim3(1024), dim3(256), 0, streams_[d], peers,
+                           count, d, chunk_);
+      }
+      barrier();
+      for (int d = 0; d < count; d++) {
+        HIPCHECK(hipSetDevice(d));
+        hipLaunchKernelGGL(directGatherKernel, dim3(1024), dim3(256), 0, streams_[d], peers,
+                           count, d, chunk_);
+      }
+    }
+    HIPCHECK(hipGetLastError());
+  }
+
+  // Device d starts with d + 1 everywhere, every element must end as the total
+  void verify(AllReduceAlgo algo) {
+    for (int d = 0; d < numGpus_; d++) {
+      HIPCHECK(hipSetDevice(d));
+      hipLaunchKernelGGL(fillKernel, dim3(1024), dim3(256), 0, streams_[d], buffers_[d], n_,
+                         static_cast<float>(d + 1));
+    }
+    allReduce(algo);
+    float expected = numGpus_ * (numGpus_ + 1) / 2.0f;
+    for (int d = 0; d < numGpus_; d++) {
+      HIPCHECK(hipStreamSynchronize(streams_[d]));
+      std::vector<float> host(n_);
+      HIPCHECK(hipMemcpy(host.data(), buffers_[d], n_ * sizeof(float), hipMemcpyDeviceToHost));
+      for (size_t i = 0; i < n_; i += chunk_ > 1 ? chunk_ - 1 : 1) {
+        if (host[i] != expected) {
+          failed("%s all-reduce: device %d element %zu is %f, expected %f",
+                 allReduceAlgoStr[algo], d, i, host[i], expected);
+        }
+      }
+    }
+  }
+
+  std::vector<size_t> sizes_;
+  unsigned int numIter_;
+  int numGpus_;
+  bool allPeers_;  // peer access enabled between all devices
+  std::vector<hipStream_t> streams_;
+  std::vector<hipEvent_t> events_;
+  std::vector<float*> buffers_;
+  std::vector<float*> scratch_;
+  size_t chunk_;  // elements per device
+  size_t n_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfAllReduce)
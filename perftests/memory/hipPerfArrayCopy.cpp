@@ -0,0 +1,202 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Copy bandwidth between linear memory and hipArrays for 1D, 2D and 3D
+// extents of uchar4, float and float4 elements: pinned host to array, array
+// to pinned host, device to array, array to device and array to array. 1D and
+// 2D arrays use hipMemcpy2DToArrayAsync/hipMemcpy2DFromArrayAsync, 3D arrays
+// and array to array copies hipMemcpy3DAsync. Every copy is repeated as a
+// plain hipMemcpyAsync of the same bytes in the same direction, with device
+// memory in place of the array; the ratio of the two times is the cost of the
+// conversion to the array layout.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "perf_harness.h"
+
+enum ArrayCopy { copyHtoA = 0, copyAtoH, copyDtoA, copyAtoD, copyAtoA, numArrayCopies };
+enum ArrayFormat { fmtUchar4 = 0, fmtFloat, fmtFloat4, numArrayFormats };
+
+static const char* arrayCopyStr[numArrayCopies] = {"host to array", "array to host",
+                                                    "device to array", "array to device",
+                                                    "array to array"};
+static const char* linearCopyStr[numArrayCopies] = {"host to device", "device to host",
+                                                     "device to device", "device to device",
+                                                     "device to device"};
+static const char* arrayFormatStr[numArrayFormats] = {"uchar4", "float", "float4"};
+static const size_t arrayFormatSize[numArrayFormats] = {sizeof(uchar4), sizeof(float),
+                                                        sizeof(float4)};
+
+struct ArrayExtent {
+  unsigned int dims;
+  size_t w;
+  size_t h;
+  size_t d;
+};
+
+static const ArrayExtent arrayExtents[] = {
+    {1, 16384, 1, 1},   {2, 256, 256, 1},   {2, 1024, 1024, 1}, {2, 4096, 4096, 1},
+    {3, 64, 64, 64},    {3, 128, 128, 128}, {3, 256, 256, 256}};
+static const unsigned int numArrayExtents = sizeof(arrayExtents) / sizeof(arrayExtents[0]);
+
+class hipPerfArrayCopy : public HipPerf::Benchmark {
+ public:
+  hipPerfArrayCopy() : HipPerf::Benchmark("hipPerfArrayCopy"),
+      copies_(HipPerf::iterationCount(10)), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override { HIPCHECK(hipStreamDestroy(stream_)); }
+
+  unsigned int numTests() override { return numArrayExtents * numArrayFormats * numArrayCopies; }
+
+  void run(unsigned int test) override {
+    ArrayCopy copy = static_cast<ArrayCopy>(test % numArrayCopies);
+    ArrayFormat format = static_cast<ArrayFormat>((test / numArrayCopies) % numArrayFormats);
+    const ArrayExtent& extent = arrayExtents[test / (numArrayCopies * numArrayFormats)];
+
+    size_t rowBytes = extent.w * arrayFormatSize[format];
+    size_t bytes = rowBytes * extent.h * extent.d;
+    hipArray_t array = allocateArray(extent, format);
+    hipArray_t otherArray = copy == copyAtoA ? allocateArray(extent, format) : nullptr;
+    void* host = nullptr;
+    void* device = nullptr;
+    void* otherDevice = nullptr;
+    HIPCHECK(hipHostMalloc(&host, bytes, hipHostMallocDefault));
+    HIPCHECK(hipMalloc(&device, bytes));
+    HIPCHECK(hipMalloc(&otherDevice, bytes));
+    memset(host, 0, bytes);
+    HIPCHECK(hipMemset(device, 0, bytes));
+
+    void* linear = copy == copyHtoA || copy == copyAtoH ? host : device;
+    hipMemcpyKind kind = copy == copyHtoA ? hipMemcpyHostToDevice
+        : copy == copyAtoH ? hipMemcpyDeviceToHost : hipMemcpyDeviceToDevice;
+
+    auto arraySec = measure([&]() {
+      for (unsigned int c = 0; c < copies_; c++) {
+        copyArray(copy, extent, rowBytes, array, otherArray, linear, kind);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    // Same bytes and direction between linear buffers
+    void* linearSrc = copy == copyAtoH ? device : copy == copyAtoD || copy == copyAtoA
+        ? otherDevice : linear;
+    void* linearDst = copy == copyAtoH ? host : copy == copyHtoA || copy == copyDtoA
+        ? otherDevice : device;
+    auto linearSec = measure([&]() {
+      for (unsigned int c = 0; c < copies_; c++) {
+        HIPCHECK(hipMemcpyAsync(linearDst, linearSrc, bytes, kind, stream_));
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    HIPCHECK(hipFreeArray(array));
+    if (otherArray != nullptr) {
+      HIPCHECK(hipFreeArray(otherArray));
+    }
+    HIPCHECK(hipHostFree(host));
+    HIPCHECK(hipFree(device));
+    HIPCHECK(hipFree(otherDevice));
+
+    char shape[64];
+    if (extent.dims == 1) {
+      snprintf(shape, sizeof(shape), "1D %zu", extent.w);
+    } else if (extent.dims == 2) {
+      snprintf(shape, sizeof(shape), "2D %zux%zu", extent.w, extent.h);
+    } else {
+      snprintf(shape, sizeof(shape), "3D %zux%zux%zu", extent.w, extent.h, extent.d);
+    }
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%-16s %-6s %-15s", shape, arrayFormatStr[format],
+             arrayCopyStr[copy]);
+    double total = static_cast<double>(bytes) * copies_;
+    report(test, desc, bytes, copies_, "GB/s", HipPerf::toBandwidth(arraySec, total));
+    snprintf(desc, sizeof(desc), "%-16s %-6s %-15s linear %s", shape, arrayFormatStr[format],
+             arrayCopyStr[copy], linearCopyStr[copy]);
+    report(test, desc, bytes, copies_, "GB/s", HipPerf::toBandwidth(linearSec, total));
+    std::vector<double> ratio;
+    for (size_t i = 0; i < arraySec.size() && i < linearSec.size(); i++) {
+      ratio.push_back(arraySec[i] / linearSec[i]);
+    }
+    snprintf(desc, sizeof(desc), "%-16s %-6s %-15s time vs linear", shape,
+             arrayFormatStr[format], arrayCopyStr[copy]);
+    report(test, desc, bytes, copies_, "x", ratio);
+  }
+
+ private:
+  hipArray_t allocateArray(const ArrayExtent& extent, ArrayFormat format) {
+    hipChannelFormatDesc desc = format == fmtUchar4 ? hipCreateChannelDesc<uchar4>()
+        : format == fmtFloat ? hipCreateChannelDesc<float>() : hipCreateChannelDesc<float4>();
+    hipArray_t array = nullptr;
+    if (extent.dims == 3) {
+      HIPCHECK(hipMalloc3DArray(&array, &desc, make_hipExtent(extent.w, extent.h, extent.d),
+                                hipArrayDefault));
+    } else {
+      HIPCHECK(hipMallocArray(&array, &desc, extent.w, extent.dims == 1 ? 0 : extent.h,
+                              hipArrayDefault));
+    }
+    return array;
+  }
+
+  // Enqueues one copy between 'array' and 'linear', or from 'array' to 'otherArray'
+  void copyArray(ArrayCopy copy, const ArrayExtent& extent, size_t rowBytes, hipArray_t array,
+                 hipArray_t otherArray, void* linear, hipMemcpyKind kind) {
+    if (extent.dims < 3 && copy != copyAtoA) {
+      if (copy == copyHtoA || copy == copyDtoA) {
+        HIPCHECK(hipMemcpy2DToArrayAsync(array, 0, 0, linear, rowBytes, rowBytes, extent.h, kind,
+                                         stream_));
+      } else {
+        HIPCHECK(hipMemcpy2DFromArrayAsync(linear, rowBytes, array, 0, 0, rowBytes, extent.h,
+                                           kind, stream_));
+      }
+      return;
+    }
+    hipMemcpy3DParms params;
+    memset(&params, 0, sizeof(params));
+    params.extent = make_hipExtent(extent.w, extent.h, extent.d);
+    params.kind = kind;
+    if (copy == copyAtoA) {
+      params.srcArray = array;
+      params.dstArray = otherArray;
+    } else if (copy == copyHtoA || copy == copyDtoA) {
+      params.srcPtr = make_hipPitchedPtr(linear, rowBytes, extent.w, extent.h);
+      params.dstArray = array;
+    } else {
+      params.srcArray = array;
+      params.dstPtr = make_hipPitchedPtr(linear, rowBytes, extent.w, extent.h);
+    }
+    HIPCHECK(hipMemcpy3DAsync(&params, stream_));
+  }
+
+  unsigned int copies_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfArrayCopy)
@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// H2D and D2H copies issued concurrently on separate streams, optionally
+// overlapped with a compute kernel on a third stream. Per-direction
+// throughput comes from events on each copy stream, the aggregate from the
+// longer of the two spans.
+
+#include <algorithm>
+
+#include "perf_harness.h"
+
+enum CopyMode { copyH2D = 0, copyD2H, copyBidirectional, copyBidirectionalCompute, numCopyModes };
+
+static const char* copyModeStr[numCopyModes] = {"H2D", "D2H", "bidir", "bidir+compute"};
+
+// Keeps the CUs busy while the copy engines work
+__global__ void computeKernel(float* buf, size_t n, unsigned int loops) {
+  size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i < n) {
+    float v = buf[i];
+    for (unsigned int l = 0; l < loops; l++) {
+      v = v * 0.999f + 0.5f;
+    }
+    buf[i] = v;
+  }
+}
+
+class hipPerfBidirectionalCopy : public HipPerf::Benchmark {
+ public:
+  hipPerfBidirectionalCopy() : HipPerf::Benchmark("hipPerfBidirectionalCopy"),
+      sizes_(HipPerf::sweepSizes({1 << 20, 4 << 20, 16 << 20, 64 << 20, 256 << 20})),
+      numIter_(HipPerf::iterationCount(20)) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    for (int i = 0; i < 3; i++) {
+      HIPCHECK(hipStreamCreateWithFlags(&streams_[i], hipStreamNonBlocking));
+    }
+    for (int i = 0; i < 4; i++) {
+      HIPCHECK(hipEventCreate(&events_[i]));
+    }
+    HIPCHECK(hipMalloc(&computeBuf_, computeElements_ * sizeof(float)));
+    HIPCHECK(hipMemset(computeBuf_, 0, computeElements_ * sizeof(float)));
+  }
+
+  void close() override {
+    for (int i = 0; i < 3; i++) {
+      HIPCHECK(hipStreamDestroy(streams_[i]));
+    }
+    for (int i = 0; i < 4; i++) {
+      HIPCHECK(hipEventDestroy(events_[i]));
+    }
+    HIPCHECK(hipFree(computeBuf_));
+  }
+
+  unsigned int numTests() override { return sizes_.size() * numCopyModes; }
+
+  void run(unsigned int test) override {
+    size_t size = sizes_[test % sizes_.size()];
+    CopyMode mode = static_cast<CopyMode>(test / sizes_.size());
+    bool h2d = mode != copyD2H;
+    bool d2h = mode != copyH2D;
+    bool compute = mode == copyBidirectionalCompute;
+
+    void *hostSrc, *hostDst, *devSrc, *devDst;
+    HIPCHECK(hipHostMalloc(&hostSrc, size, hipHostMallocDefault));
+    HIPCHECK(hipHostMalloc(&hostDst, size, hipHostMallocDefault));
+    HIPCHECK(hipMalloc(&devSrc, size));
+    HIPCHECK(hipMalloc(&devDst, size));
+    memset(hostSrc, 1, size);
+    HIPCHECK(hipMemset(devSrc, 2, size));
+
+    hipStream_t h2dStream = streams_[0], d2hStream = streams_[1], computeStream = streams_[2];
+    std::vector<double> h2dSec, d2hSec;
+    measure([&]() {
+      HIPCHECK(hipEventRecord(events_[0], h2dStream));
+      HIPCHECK(hipEventRecord(events_[2], d2hStream));
+      for (unsigned int i = 0; i < numIter_; i++) {
+        if (h2d) {
+          HIPCHECK(hipMemcpyAsync(devDst, hostSrc, size, hipMemcpyHostToDevice, h2dStream));
+        }
+        if (d2h) {
+          HIPCHECK(hipMemcpyAsync(hostDst, devSrc, size, hipMemcpyDeviceToHost, d2hStream));
+        }
+        if (compute) {
+          hipLaunchKernelGGL(computeKernel, dim3(computeElements_ / 256), dim3(256), 0,
+                             computeStream, computeBuf_, computeElements_, 1024);
+        }
+      }
+      HIPCHECK(hipEventRecord(events_[1], h2dStream));
+      HIPCHECK(hipEventRecord(events_[3], d2hStream));
+      for (int i = 0; i < 3; i++) {
+        HIPCHECK(hipStreamSynchronize(streams_[i]));
+      }
+
+      if (HipPerf::Counters::collecting()) {
+        return;
+      }
+      float ms = 0;
+      HIPCHECK(hipEventElapsedTime(&ms, events_[0], events_[1]));
+      h2dSec.push_back(ms * 1e-3);
+      HIPCHECK(hipEventElapsedTime(&ms, events_[2], events_[3]));
+      d2hSec.push_back(ms * 1e-3);
+    });
+
+    double bytes = static_cast<double>(size) * numIter_;
+    std::string desc = copyModeStr[mode];
+    if (h2d) {
+      report(test, desc + " H2D", size, numIter_, "GB/s",
+             HipPerf::toBandwidth(HipPerf::measuredSamples(h2dSec), bytes));
+    }
+    if (d2h) {
+      report(test, desc + " D2H", size, numIter_, "GB/s",
+             HipPerf::toBandwidth(HipPerf::measuredSamples(d2hSec), bytes));
+    }
+    if (h2d && d2h) {
+      // Paired per run, so built before the warm-up runs and outliers are dropped
+      std::vector<double> aggregate;
+      for (size_t i = 0; i < h2dSec.size(); i++) {
+        aggregate.push_back(2 * bytes * 1e-9 / std::max(h2dSec[i], d2hSec[i]));
+      }
+      report(test, desc + " aggregate", size, numIter_, "GB/s",
+             HipPerf::measuredSamples(aggregate));
+    }
+
+    HIPCHECK(hipHostFree(hostSrc));
+    HIPCHECK(hipHostFree(hostDst));
+    HIPCHECK(hipFree(devSrc));
+    HIPCHECK(hipFree(devDst));
+  }
+
+ private:
+  std::vector<size_t> sizes_;
+  unsigned int numIter_;
+  hipStream_t streams_[3];
+  hipEvent_t events_[4];  // h2d start/stop, d2h start/stop
+  float* computeBuf_;
+  const size_t computeElements_ = 1 << 22;
+};
+
+HIP_PERF_BENCHMARK(hipPerfBidirectionalCopy)
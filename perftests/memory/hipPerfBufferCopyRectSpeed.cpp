@@ -18,7 +18,7 @@ THE SOFTWARE.
 */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
  * TEST: %t
  * HIT_END
  */
@@ -28,15 +28,7 @@ THE SOFTWARE.
 #include <string.h>
 #include <complex>
 
-#include "timer.h"
-#include "test_common.h"
-
-// Quiet pesky warnings
-#ifdef WIN_OS
-#define SNPRINTF sprintf_s
-#else
-#define SNPRINTF snprintf
-#endif
+#include "perf_harness.h"
 
 #define NUM_SIZES 8
 //4KB, 8KB, 64KB, 256KB, 1 MB, 4MB, 16 MB, 16MB+10
@@ -80,6 +72,149 @@ void checkData(void *ptr, unsigned int size, char value)
 }
 
 
+// Shape sweep, run after the square tests: every shape copies 16MB between
+// device memory and prepinned host memory. Wide to tall aspect ratios,
+// unaligned sub-rectangle offsets, destination pitches that differ from the
+// source pitch and 3D hipMemcpy3DAsync extents of the same bytes.
+struct RectShape {
+    const char *kind;
+    size_t width;       // bytes per row
+    size_t height;
+    size_t depth;       // 1 copies with hipMemcpy2DAsync
+    size_t srcPitch;
+    size_t dstPitch;
+    size_t offsetX;     // bytes, in both src and dst
+    size_t offsetY;
+};
+
+static const RectShape Shapes[] = {
+    {"aspect", 16, 1048576, 1, 16, 16, 0, 0},
+    {"aspect", 64, 262144, 1, 64, 64, 0, 0},
+    {"aspect", 256, 65536, 1, 256, 256, 0, 0},
+    {"aspect", 4096, 4096, 1, 4096, 4096, 0, 0},
+    {"aspect", 65536, 256, 1, 65536, 65536, 0, 0},
+    {"aspect", 1048576, 16, 1, 1048576, 1048576, 0, 0},
+    {"aspect", 16777216, 1, 1, 16777216, 16777216, 0, 0},
+    {"offset", 4096, 4096, 1, 8192, 8192, 0, 16},
+    {"offset", 4096, 4096, 1, 8192, 8192, 1, 16},
+    {"offset", 4096, 4096, 1, 8192, 8192, 256, 16},
+    {"pitch", 4096, 4096, 1, 4096, 4100, 0, 0},
+    {"pitch", 4096, 4096, 1, 4096, 4160, 0, 0},
+    {"pitch", 4096, 4096, 1, 4096, 8192, 0, 0},
+    {"3D", 16, 1024, 1024, 16, 16, 0, 0},
+    {"3D", 256, 256, 256, 256, 256, 0, 0},
+    {"3D", 4096, 64, 64, 4096, 4096, 0, 0},
+    {"3D", 65536, 16, 16, 65536, 65536, 0, 0},
+};
+#define NUM_SHAPES (sizeof(Shapes) / sizeof(Shapes[0]))
+
+// hipMalloc to hipMalloc, hipHostMalloc to hipMalloc, hipMalloc to hipHostMalloc
+#define NUM_SHAPE_DIRS 3
+static const char *ShapeDirStr[NUM_SHAPE_DIRS] = {"s:hM d:hM", "s:hHM d:hM", "s:hM d:hHM"};
+static const unsigned int ShapeIterations = 10;
+
+#define NUM_SQUARE_TESTS (NUM_SIZES*NUM_SUBTESTS*2)
+#define NUM_SHAPE_TESTS (NUM_SHAPES*NUM_SHAPE_DIRS)
+
+static void runShapeTest(unsigned int test)
+{
+    unsigned int index = test - NUM_SQUARE_TESTS;
+    const RectShape &shape = Shapes[index / NUM_SHAPE_DIRS];
+    unsigned int dir = index % NUM_SHAPE_DIRS;
+    hipError_t err = hipSuccess;
+
+    size_t rows = (shape.offsetY + shape.height) * shape.depth;
+    size_t srcBytes = shape.srcPitch * rows + shape.offsetX;
+    size_t dstBytes = shape.dstPitch * rows + shape.offsetX;
+    void *srcBuffer = NULL;
+    void *dstBuffer = NULL;
+    if (dir == 1) {
+        err = hipHostMalloc(&srcBuffer, srcBytes, 0);
+        CHECK_RESULT(err != hipSuccess, "hipHostMalloc failed");
+        setData(srcBuffer, srcBytes, 0xd0);
+    } else {
+        err = hipMalloc(&srcBuffer, srcBytes);
+        CHECK_RESULT(err != hipSuccess, "hipMalloc failed");
+        err = hipMemset(srcBuffer, 0xd0, srcBytes);
+        CHECK_RESULT(err != hipSuccess, "hipMemset failed");
+    }
+    if (dir == 2) {
+        err = hipHostMalloc(&dstBuffer, dstBytes, 0);
+        CHECK_RESULT(err != hipSuccess, "hipHostMalloc failed");
+    } else {
+        err = hipMalloc(&dstBuffer, dstBytes);
+        CHECK_RESULT(err != hipSuccess, "hipMalloc failed");
+    }
+
+    hipMemcpy3DParms params;
+    memset(&params, 0, sizeof(params));
+    params.srcPtr = make_hipPitchedPtr(srcBuffer, shape.srcPitch, shape.width,
+                                       shape.offsetY + shape.height);
+    params.dstPtr = make_hipPitchedPtr(dstBuffer, shape.dstPitch, shape.width,
+                                       shape.offsetY + shape.height);
+    params.srcPos = make_hipPos(shape.offsetX, shape.offsetY, 0);
+    params.dstPos = params.srcPos;
+    params.extent = make_hipExtent(shape.width, shape.height, shape.depth);
+    params.kind = hipMemcpyDefault;
+
+    char *src = (char *)srcBuffer + shape.offsetY * shape.srcPitch + shape.offsetX;
+    char *dst = (char *)dstBuffer + shape.offsetY * shape.dstPitch + shape.offsetX;
+
+    CPerfCounter timer;
+    // i == 0 is the warm up
+    for (unsigned int i = 0; i <= ShapeIterations; i++)
+    {
+        if (i == 1)
+        {
+            err = hipDeviceSynchronize();
+            CHECK_RESULT(err, "hipDeviceSynchronize failed");
+            timer.Reset();
+            timer.Start();
+        }
+        if (shape.depth > 1)
+        {
+            err = hipMemcpy3DAsync(&params, NULL);
+            CHECK_RESULT(err, "hipMemcpy3DAsync failed");
+        }
+        else
+        {
+            err = hipMemcpy2DAsync(dst, shape.dstPitch, src, shape.srcPitch, shape.width,
+                                   shape.height, hipMemcpyDefault, NULL);
+            CHECK_RESULT(err, "hipMemcpy2DAsync failed");
+        }
+    }
+    err = hipDeviceSynchronize();
+    CHECK_RESULT(err, "hipDeviceSynchronize failed");
+    timer.Stop();
+    double sec = timer.GetElapsedTime();
+
+    double bytes = (double)shape.width * shape.height * shape.depth;
+    double perf = (bytes * ShapeIterations * (double)(1e-09)) / sec;
+    // Double results when src and dst are both on device, as for the square tests
+    if (dir == 0)
+        perf *= 2.0;
+
+    char desc[128];
+    if (shape.depth > 1)
+        snprintf(desc, sizeof(desc), "%s %zux%zux%zu %s", shape.kind, shape.width, shape.height,
+                 shape.depth, ShapeDirStr[dir]);
+    else
+        snprintf(desc, sizeof(desc), "%s %zux%zu pitch %zu/%zu offset %zu,%zu %s", shape.kind,
+                 shape.width, shape.height, shape.srcPitch, shape.dstPitch, shape.offsetX,
+                 shape.offsetY, ShapeDirStr[dir]);
+    HipPerf::writeResult("HIPPerfBufferCopyRectSpeed", test, desc, (size_t)bytes,
+                         ShapeIterations, "GB/s", perf);
+
+    if (dir == 1)
+        hipHostFree(srcBuffer);
+    else
+        hipFree(srcBuffer);
+    if (dir == 2)
+        hipHostFree(dstBuffer);
+    else
+        hipFree(dstBuffer);
+}
+
 int main(int argc, char* argv[]) {
     HipTest::parseStandardArguments(argc, argv, true);
 
@@ -103,11 +238,16 @@ int main(int argc, char* argv[]) {
     void* srcBuffer = NULL;
     void* dstBuffer = NULL;
 
-    int numTests = (p_tests == -1) ? (NUM_SIZES*NUM_SUBTESTS*2 - 1) : p_tests;
+    int numTests = (p_tests == -1) ? (NUM_SQUARE_TESTS + NUM_SHAPE_TESTS - 1) : p_tests;
     int test = (p_tests == -1) ? 0 : p_tests;
 
     for(;test <= numTests; test++)
     {
+        if (test >= NUM_SQUARE_TESTS)
+        {
+            runShapeTest(test);
+            continue;
+        }
         unsigned int srcTest = (test / NUM_SIZES) % BUF_TYPES;
         unsigned int dstTest = (test / (NUM_SIZES*BUF_TYPES)) % BUF_TYPES;
         bufSize_ = Sizes[test % NUM_SIZES];
@@ -252,10 +392,9 @@ int main(int argc, char* argv[]) {
             (hostMalloc[1] || hostRegister[1] || unpinnedMalloc[1]))
             perf *= 2.0;
 
-        char buf[256];
-        SNPRINTF(buf, sizeof(buf), "HIPPerfBufferCopyRectSpeed[%d]\t(%8d bytes)\ts:%s d:%s\ti:%4d\t(GB/s) perf\t%f",
-                test, bufSize_, strSrc, strDst, numIter, (float)perf);
-        printf("%s\n", buf);
+        HipPerf::writeResult("HIPPerfBufferCopyRectSpeed", test,
+                             std::string("s:") + strSrc + " d:" + strDst, bufSize_, numIter,
+                             "GB/s", perf);
 
         //Free src
         if (hostMalloc[0])
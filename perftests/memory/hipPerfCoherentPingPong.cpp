@@ -0,0 +1,296 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// One-way latency of a flag passed back and forth through fine-grained
+// memory, without the host runtime in the loop. One single-thread kernel on
+// device 0 pings, the peer answers: a single-thread kernel on device 1, or a
+// host thread. The flag lives in coherent host memory, fine-grained device
+// memory or uncached device memory of device 0 (the device memory types are
+// AMD only; the host answers only through host memory). With atomics the flag
+// is written with atomicExch_system and polled with atomicAdd_system(0);
+// with volatile the flag is a volatile store after __threadfence_system and
+// polled with volatile loads. The pinging kernel times the rounds after a
+// warm-up with wall_clock64(); one-way latency is half a round. Every poll
+// gives up after a few seconds so a memory type that is not coherent shows
+// up as a failure instead of a hang.
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include "perf_harness.h"
+#include "../catch/include/hip_test_topology.hh"
+
+enum PingPeer { peerDevice, peerHost, numPingPeers };
+static const char* pingPeerStr[] = {"gpu0<->gpu1", "gpu0<->cpu"};
+
+enum PingMemory { pingHostCoherent, pingDeviceFineGrained, pingDeviceUncached, numPingMemories };
+static const char* pingMemoryStr[] = {"host coherent", "device fine-grained",
+                                      "device uncached"};
+
+enum PingSync { syncAtomic, syncVolatile, numPingSyncs };
+static const char* pingSyncStr[] = {"system atomics", "volatile + fence"};
+
+static const unsigned int warmupRounds = 100;
+static const unsigned int timedRounds = 10000;
+// Seconds a poll waits for the other side
+static const unsigned int pollTimeout = 5;
+
+struct PingState {
+  unsigned long long start;  // wall_clock64() after the warm-up rounds
+  unsigned long long end;
+  unsigned int timedOut;
+};
+
+template <PingSync SYNC> __device__ void storeFlag(unsigned int* flag, unsigned int value) {
+  if (SYNC == syncAtomic) {
+    atomicExch_system(flag, value);
+  } else {
+    __threadfence_system();
+    *reinterpret_cast<volatile unsigned int*>(flag) = value;
+  }
+}
+
+template <PingSync SYNC> __device__ unsigned int loadFlag(unsigned int* flag) {
+  if (SYNC == syncAtomic) {
+    return atomicAdd_system(flag, 0u);
+  }
+  return *reinterpret_cast<volatile unsigned int*>(flag);
+}
+
+// Odd values are pings, even values are answers. Returns false on timeout.
+template <PingSync SYNC>
+__device__ bool waitFlag(unsigned int* flag, unsigned int value, unsigned long long deadline) {
+  while (loadFlag<SYNC>(flag) != value) {
+    if (wall_clock64() > deadline) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <PingSync SYNC>
+__global__ void pingKernel(unsigned int* flag, bool pinger, unsigned long long timeoutTicks,
+                           PingState* state) {
+  unsigned long long deadline = wall_clock64() + timeoutTicks;
+  state->timedOut = 0;
+  for (unsigned int i = 0; i < warmupRounds + timedRounds; i++) {
+    if (i == warmupRounds) {
+      state->start = wall_clock64();
+    }
+    if (pinger) {
+      storeFlag<SYNC>(flag, 2 * i + 1);
+      if (!waitFlag<SYNC>(flag, 2 * i + 2, deadline)) {
+        state->timedOut = 1;
+        return;
+      }
+    } else {
+      if (!waitFlag<SYNC>(flag, 2 * i + 1, deadline)) {
+        state->timedOut = 1;
+        return;
+      }
+      storeFlag<SYNC>(flag, 2 * i + 2);
+    }
+    // Restart the timeout for every round once the other side answered
+    deadline = wall_clock64() + timeoutTicks;
+  }
+  state->end = wall_clock64();
+}
+
+class hipPerfCoherentPingPong : public HipPerf::Benchmark {
+ public:
+  hipPerfCoherentPingPong() : HipPerf::Benchmark("hipPerfCoherentPingPong"), numGpus_(0),
+      peer_(-1), clockRateHz_(0) {
+    HIPCHECK(hipGetDeviceCount(&numGpus_));
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    int rateKHz = 0;
+    HIPCHECK(hipDeviceGetAttribute(&rateKHz, hipDeviceAttributeWallClockRate, deviceId_));
+    clockRateHz_ = rateKHz * 1000.0;
+    // Ping the best connected peer so the peer numbers reflect the fastest link
+    peer_ = hip::DeviceTopology().bestPeer(deviceId_);
+  }
+
+  unsigned int numTests() override { return numPingPeers * numPingMemories * numPingSyncs; }
+
+  void run(unsigned int test) override {
+    PingSync sync = static_cast<PingSync>(test % numPingSyncs);
+    PingMemory memory = static_cast<PingMemory>((test / numPingSyncs) % numPingMemories);
+    PingPeer peer = static_cast<PingPeer>(test / (numPingSyncs * numPingMemories));
+
+#ifndef __HIP_PLATFORM_AMD__
+    if (memory != pingHostCoherent) {
+      return;
+    }
+#endif
+    if (peer == peerHost && memory != pingHostCoherent) {
+      return;
+    }
+    if (clockRateHz_ == 0) {
+      printf("info: device %d has no wall clock, skipping\n", deviceId_);
+      return;
+    }
+    if (peer == peerDevice) {
+      if (peer_ < 0) {
+        printf("info: gpu to gpu ping-pong needs 2 devices, skipping\n");
+        return;
+      }
+      int canAccess = 0;
+      HIPCHECK(hipDeviceCanAccessPeer(&canAccess, peer_, deviceId_));
+      if (memory != pingHostCoherent && !canAccess) {
+        printf("info: device %d cannot access device %d, skipping %s\n", peer_, deviceId_,
+               pingMemoryStr[memory]);
+        return;
+      }
+      if (canAccess) {
+        HIPCHECK(hipSetDevice(peer_));
+        HIPCHECK(hipDeviceEnablePeerAccess(deviceId_, 0));
+        HIPCHECK(hipSetDevice(deviceId_));
+      }
+    }
+
+    unsigned int* host = nullptr;
+    unsigned int* flag = allocateFlag(memory, &host);
+    PingState* states = nullptr;
+    HIPCHECK(hipHostMalloc(&states, 2 * sizeof(PingState), hipHostMallocDefault));
+    hipStream_t stream;
+    hipStream_t peerStream = nullptr;
+    HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+    if (peer == peerDevice) {
+      HIPCHECK(hipSetDevice(peer_));
+      HIPCHECK(hipStreamCreateWithFlags(&peerStream, hipStreamNonBlocking));
+      HIPCHECK(hipSetDevice(deviceId_));
+    }
+    unsigned long long timeoutTicks =
+        static_cast<unsigned long long>(clockRateHz_ * pollTimeout);
+
+    std::vector<double> us;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      HIPCHECK(hipMemset(flag, 0, sizeof(unsigned int)));
+      HIPCHECK(hipDeviceSynchronize());
+      bool timedOut = false;
+      if (peer == peerDevice) {
+        // The answering kernel starts first so the pings never wait for its launch
+        HIPCHECK(hipSetDevice(peer_));
+        launch(sync, flag, false, timeoutTicks, &states[1], peerStream);
+        HIPCHECK(hipSetDevice(deviceId_));
+        launch(sync, flag, true, timeoutTicks, &states[0], stream);
+        HIPCHECK(hipStreamSynchronize(stream));
+        HIPCHECK(hipStreamSynchronize(peerStream));
+        timedOut = states[1].timedOut != 0;
+      } else {
+        launch(sync, flag, true, timeoutTicks, &states[0], stream);
+        timedOut = !answerFromHost(host);
+        HIPCHECK(hipStreamSynchronize(stream));
+      }
+      if (timedOut || states[0].timedOut) {
+        failed("%s ping-pong through %s with %s timed out", pingPeerStr[peer],
+               pingMemoryStr[memory], pingSyncStr[sync]);
+      }
+      if (r >= p_warmup) {
+        double sec = (states[0].end - states[0].start) / clockRateHz_;
+        us.push_back(sec * 1e6 / (2.0 * timedRounds));
+      }
+    }
+
+    if (peerStream != nullptr) {
+      HIPCHECK(hipStreamDestroy(peerStream));
+    }
+    HIPCHECK(hipStreamDestroy(stream));
+    HIPCHECK(hipHostFree(states));
+    freeFlag(memory, flag, host);
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %-19s %s one-way", pingPeerStr[peer], pingMemoryStr[memory],
+             pingSyncStr[sync]);
+    report(test, desc, sizeof(unsigned int), timedRounds, "us", us);
+  }
+
+ private:
+  void launch(PingSync sync, unsigned int* flag, bool pinger, unsigned long long timeoutTicks,
+              PingState* state, hipStream_t stream) {
+    if (sync == syncAtomic) {
+      hipLaunchKernelGGL(pingKernel<syncAtomic>, dim3(1), dim3(1), 0, stream, flag, pinger,
+                         timeoutTicks, state);
+    } else {
+      hipLaunchKernelGGL(pingKernel<syncVolatile>, dim3(1), dim3(1), 0, stream, flag, pinger,
+                         timeoutTicks, state);
+    }
+    HIPCHECK(hipGetLastError());
+  }
+
+  // Answers every ping of the kernel on device 0, false on timeout
+  bool answerFromHost(unsigned int* flag) {
+    for (unsigned int i = 0; i < warmupRounds + timedRounds; i++) {
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(pollTimeout);
+      while (__atomic_load_n(flag, __ATOMIC_ACQUIRE) != 2 * i + 1) {
+        if (std::chrono::steady_clock::now() > deadline) {
+          return false;
+        }
+      }
+      __atomic_store_n(flag, 2 * i + 2, __ATOMIC_RELEASE);
+    }
+    return true;
+  }
+
+  unsigned int* allocateFlag(PingMemory memory, unsigned int** host) {
+    void* ptr = nullptr;
+    switch (memory) {
+      case pingHostCoherent:
+        HIPCHECK(hipHostMalloc(reinterpret_cast<void**>(host), sizeof(unsigned int),
+                               hipHostMallocMapped | hipHostMallocCoherent |
+                                   hipHostMallocPortable));
+        HIPCHECK(hipHostGetDevicePointer(&ptr, *host, 0));
+        break;
+#ifdef __HIP_PLATFORM_AMD__
+      case pingDeviceFineGrained:
+        HIPCHECK(hipExtMallocWithFlags(&ptr, sizeof(unsigned int), hipDeviceMallocFinegrained));
+        break;
+      case pingDeviceUncached:
+        HIPCHECK(hipExtMallocWithFlags(&ptr, sizeof(unsigned int), hipDeviceMallocUncached));
+        break;
+#endif
+      default:
+        break;
+    }
+    return static_cast<unsigned int*>(ptr);
+  }
+
+  void freeFlag(PingMemory memory, unsigned int* flag, unsigned int* host) {
+    if (memory == pingHostCoherent) {
+      HIPCHECK(hipHostFree(host));
+    } else {
+      HIPCHECK(hipFree(flag));
+    }
+  }
+
+  int numGpus_;
+  int peer_;
+  double clockRateHz_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfCoherentPingPong)
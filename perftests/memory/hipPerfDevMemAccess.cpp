@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Device memory read and write bandwidth for 1, 2, 4, 8 and 16 byte elements
+// and four access patterns: linear (coalesced grid-stride), strided (256 bytes
+// between neighbouring threads), random gather/scatter (odd-multiplier hash of
+// the index) and streaming (linear with nontemporal loads/stores). Every
+// pattern touches each element exactly once per pass. Results are also given
+// as a percentage of the theoretical peak from memoryClockRate and
+// memoryBusWidth, assuming double data rate.
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+
+enum AccessPattern { patternLinear = 0, patternStrided, patternRandom, patternStreaming,
+                     numPatterns };
+enum AccessDir { dirRead = 0, dirWrite, numDirs };
+
+static const char* patternStr[numPatterns] = {"linear", "strided", "random", "streaming"};
+static const char* dirStr[numDirs] = {"read", "write"};
+
+static const unsigned int widths[] = {1, 2, 4, 8, 16};
+static const unsigned int numWidths = sizeof(widths) / sizeof(widths[0]);
+
+__device__ inline unsigned int sumOf(unsigned char v) { return v; }
+__device__ inline unsigned int sumOf(unsigned short v) { return v; }
+__device__ inline unsigned int sumOf(unsigned int v) { return v; }
+__device__ inline unsigned int sumOf(uint2 v) { return v.x + v.y; }
+__device__ inline unsigned int sumOf(uint4 v) { return v.x + v.y + v.z + v.w; }
+
+template <typename T> __device__ inline T valueOf(unsigned int v) { return static_cast<T>(v); }
+template <> __device__ inline uint2 valueOf<uint2>(unsigned int v) { return make_uint2(v, v); }
+template <> __device__ inline uint4 valueOf<uint4>(unsigned int v) {
+  return make_uint4(v, v, v, v);
+}
+
+#ifdef __HIP_PLATFORM_NVIDIA__
+template <typename T> __device__ inline T loadNT(const T* p) { return __ldcs(p); }
+template <typename T> __device__ inline void storeNT(T* p, T v) { __stcs(p, v); }
+#else
+template <typename T> __device__ inline T loadNT(const T* p) {
+  return __builtin_nontemporal_load(p);
+}
+template <typename T> __device__ inline void storeNT(T* p, T v) {
+  __builtin_nontemporal_store(v, p);
+}
+template <> __device__ inline uint2 loadNT<uint2>(const uint2* p) {
+  return make_uint2(loadNT(&p->x), loadNT(&p->y));
+}
+template <> __device__ inline uint4 loadNT<uint4>(const uint4* p) {
+  return make_uint4(loadNT(&p->x), loadNT(&p->y), loadNT(&p->z), loadNT(&p->w));
+}
+template <> __device__ inline void storeNT<uint2>(uint2* p, uint2 v) {
+  storeNT(&p->x, v.x);
+  storeNT(&p->y, v.y);
+}
+template <> __device__ inline void storeNT<uint4>(uint4* p, uint4 v) {
+  storeNT(&p->x, v.x);
+  storeNT(&p->y, v.y);
+  storeNT(&p->z, v.z);
+  storeNT(&p->w, v.w);
+}
+#endif
+
+// Maps the i-th access of a pass to an element; a permutation of [0, n) for
+// n a power of two and a multiple of the stride.
+template <typename T, AccessPattern P> __device__ inline size_t elementOf(size_t i, size_t n) {
+  if (P == patternStrided) {
+    const size_t stride = 256 / sizeof(T) > 0 ? 256 / sizeof(T) : 1;
+    size_t rows = n / stride;
+    return (i % rows) * stride + i / rows;
+  } else if (P == patternRandom) {
+    return (i * 2654435761ull) & (n - 1);
+  }
+  return i;
+}
+
+template <typename T, AccessPattern P>
+__global__ void readKernel(const T* src, size_t n, unsigned int* dst) {
+  unsigned int tmp = 0;
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    const T* p = src + elementOf<T, P>(i, n);
+    tmp += sumOf(P == patternStreaming ? loadNT(p) : *p);
+  }
+  atomicAdd(dst, tmp);
+}
+
+template <typename T, AccessPattern P>
+__global__ void writeKernel(T* dst, size_t n, unsigned int value) {
+  T v = valueOf<T>(value);
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    T* p = dst + elementOf<T, P>(i, n);
+    if (P == patternStreaming) {
+      storeNT(p, v);
+    } else {
+      *p = v;
+    }
+  }
+}
+
+typedef void (*AccessLaunch)(void* buf, size_t bytes, unsigned int* result, dim3 grid,
+                             hipStream_t stream);
+
+template <typename T, AccessPattern P, AccessDir D>
+static void launchAccess(void* buf, size_t bytes, unsigned int* result, dim3 grid,
+                         hipStream_t stream) {
+  size_t n = bytes / sizeof(T);
+  if (D == dirRead) {
+    hipLaunchKernelGGL((readKernel<T, P>), grid, dim3(256), 0, stream,
+                       static_cast<const T*>(buf), n, result);
+  } else {
+    hipLaunchKernelGGL((writeKernel<T, P>), grid, dim3(256), 0, stream, static_cast<T*>(buf), n,
+                       1u);
+  }
+}
+
+template <AccessPattern P, AccessDir D> static AccessLaunch launchFor(unsigned int width) {
+  switch (width) {
+    case 1: return launchAccess<unsigned char, P, D>;
+    case 2: return launchAccess<unsigned short, P, D>;
+    case 4: return launchAccess<unsigned int, P, D>;
+    case 8: return launchAccess<uint2, P, D>;
+    default: return launchAccess<uint4, P, D>;
+  }
+}
+
+template <AccessDir D> static AccessLaunch launchFor(AccessPattern pattern, unsigned int width) {
+  switch (pattern) {
+    case patternLinear: return launchFor<patternLinear, D>(width);
+    case patternStrided: return launchFor<patternStrided, D>(width);
+    case patternRandom: return launchFor<patternRandom, D>(width);
+    default: return launchFor<patternStreaming, D>(width);
+  }
+}
+
+class hipPerfDevMemAccess : public HipPerf::Benchmark {
+ public:
+  hipPerfDevMemAccess() : HipPerf::Benchmark("hipPerfDevMemAccess"),
+      sizes_(HipPerf::sweepSizes({256 << 20})), passes_(HipPerf::iterationCount(20)) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipMalloc(&result_, sizeof(unsigned int)));
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    // kHz, two transfers per clock
+    peakGBps_ = 2.0 * props_.memoryClockRate * 1e3 * (props_.memoryBusWidth / 8) * 1e-9;
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(result_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return sizes_.size() * numDirs * numPatterns * numWidths; }
+
+  void run(unsigned int test) override {
+    unsigned int width = widths[test % numWidths];
+    AccessPattern pattern = static_cast<AccessPattern>((test / numWidths) % numPatterns);
+    AccessDir dir = static_cast<AccessDir>((test / (numWidths * numPatterns)) % numDirs);
+    size_t size = powerOfTwoBelow(sizes_[test / (numWidths * numPatterns * numDirs)]);
+
+    void* buf = nullptr;
+    HIPCHECK(hipMalloc(&buf, size));
+    HIPCHECK(hipMemset(buf, dir == dirRead ? 1 : 0, size));
+    AccessLaunch launch = dir == dirRead ? launchFor<dirRead>(pattern, width)
+                                         : launchFor<dirWrite>(pattern, width);
+    dim3 grid(props_.multiProcessorCount * 8);
+
+    auto sec = measure([&]() {
+      for (unsigned int p = 0; p < passes_; p++) {
+        launch(buf, size, result_, grid, stream_);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    if (dir == dirWrite) {
+      checkWritten(buf, size, width);
+    }
+    HIPCHECK(hipFree(buf));
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%s %2uB %s", dirStr[dir], width, patternStr[pattern]);
+    auto gbps = HipPerf::toBandwidth(sec, static_cast<double>(size) * passes_);
+    report(test, desc, size, passes_, "GB/s", gbps);
+    if (peakGBps_ > 0) {
+      std::vector<double> percent;
+      for (double g : gbps) {
+        percent.push_back(100.0 * g / peakGBps_);
+      }
+      report(test, std::string(desc) + " of peak", size, passes_, "%", percent);
+    }
+  }
+
+ private:
+  static size_t powerOfTwoBelow(size_t size) {
+    size_t p = 4096;
+    while (p * 2 <= size) {
+      p *= 2;
+    }
+    return p;
+  }
+
+  // The write kernels store 1 into every lane of at most 32 bits, little endian.
+  void checkWritten(void* buf, size_t size, unsigned int width) {
+    std::vector<unsigned char> host(size);
+    HIPCHECK(hipMemcpy(host.data(), buf, size, hipMemcpyDeviceToHost));
+    unsigned int lane = width < 4 ? width : 4;
+    for (size_t i = 0; i < size; i++) {
+      unsigned char expected = i % lane == 0 ? 1 : 0;
+      if (host[i] != expected) {
+        failed("Write validation failed at byte %zu: got %u, expected %u", i, host[i], expected);
+      }
+    }
+  }
+
+  std::vector<size_t> sizes_;
+  unsigned int passes_;
+  unsigned int* result_;
+  hipStream_t stream_;
+  double peakGBps_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfDevMemAccess)
@@ -18,14 +18,14 @@ THE SOFTWARE.
 */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
  * TEST: %t
  * HIT_END
  */
 
 #include <iostream>
 #include <chrono>
-#include "test_common.h"
+#include "perf_harness.h"
 
 using namespace std;
 
@@ -51,6 +51,8 @@ __global__ void read_kernel(d_uint16 *src, ulong N, uint *dst) {
 }
 
 int main(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
+
   d_uint16 *dSrc;
   d_uint16 *hSrc;
   uint *dDst;
@@ -67,7 +69,7 @@ int main(int argc, char* argv[]) {
       return 0;
   }
 
-  static int device = 0;
+  int device = p_gpuDevice;
   HIPCHECK(hipSetDevice(device));
   hipDeviceProp_t props;
   HIPCHECK(hipGetDeviceProperties(&props, device));
@@ -123,8 +125,12 @@ int main(int argc, char* argv[]) {
   // read speed in GB/s
   double perf = ((double)nBytes * nIter * (double)(1e-09)) / all_kernel_time.count();
 
-  cout << "info: average read speed of " << perf << " GB/s " << "achieved for memory size of " <<
-      nBytes / (1024 * 1024) << " MB" << endl;
+  HipPerf::Counters::collect([&]() {
+    hipLaunchKernelGGL(read_kernel, dim3(blocks), dim3(threadsPerBlock), 0, stream, dSrc, N, dDst);
+    HIPCHECK(hipStreamSynchronize(stream));
+  });
+
+  HipPerf::writeResult("hipPerfDevMemReadSpeed", 0, "read_kernel", nBytes, nIter, "GB/s", perf);
 
   delete [] hSrc;
   delete hDst;
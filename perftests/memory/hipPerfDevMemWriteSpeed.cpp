@@ -18,14 +18,14 @@ THE SOFTWARE.
 */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
  * TEST: %t
  * HIT_END
  */
 
 #include <iostream>
 #include <chrono>
-#include "test_common.h"
+#include "perf_harness.h"
 
 using namespace std;
 
@@ -44,6 +44,8 @@ __global__ void write_kernel(d_uint16 *dst, ulong N, d_uint16 pval) {
 };
 
 int main(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
+
   d_uint16 *dDst;
   d_uint16 *hDst;
   hipStream_t stream;
@@ -63,7 +65,7 @@ int main(int argc, char* argv[]) {
       return 0;
   }
 
-  static int device = 0;
+  int device = p_gpuDevice;
   HIPCHECK(hipSetDevice(device));
   hipDeviceProp_t props;
   HIPCHECK(hipGetDeviceProperties(&props, device));
@@ -114,8 +116,7 @@ int main(int argc, char* argv[]) {
   // read speed in GB/s
   double perf = ((double)nBytes * nIter * (double)(1e-09)) / all_kernel_time.count();
 
-  cout << "info: average write speed of " << perf << " GB/s " << "achieved for memory size of " <<
-      nBytes / (1024 * 1024) << " MB" << endl;
+  HipPerf::writeResult("hipPerfDevMemWriteSpeed", 0, "write_kernel", nBytes, nIter, "GB/s", perf);
 
 
   delete [] hDst;
@@ -0,0 +1,246 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Device to device copies through the DMA engines against a copy kernel.
+// For 4 KB to 256 MB (--sizes or --sweep replace them) a buffer is copied
+// with hipMemcpyDtoD, with hipMemcpyDtoDAsync and with a grid-stride kernel,
+// for source and destination both 16 byte aligned, both 4 bytes past
+// alignment and 1 byte apart in alignment. The kernel moves 16 bytes per
+// access when both pointers share their alignment and single bytes
+// otherwise. Every case runs on an idle device and next to a compute kernel
+// on a second stream; reported are GB/s and us per copy, and under load the
+// compute kernel's time relative to running it alone, which shows how many
+// CUs the copy takes away.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const size_t defaultCopySizes[] = {4096, 65536, 1048576, 16777216, 268435456};
+
+enum CopyMethod { methodDtoD = 0, methodDtoDAsync, methodKernel, numCopyMethods };
+static const char* copyMethodStr[numCopyMethods] = {"hipMemcpyDtoD", "hipMemcpyDtoDAsync",
+                                                    "copy kernel"};
+
+struct Alignment {
+  size_t src;
+  size_t dst;
+  const char* name;
+};
+static const Alignment alignments[] = {
+    {0, 0, "aligned"}, {4, 4, "both +4 B"}, {1, 0, "src +1 B"}};
+static const unsigned int numAlignments = sizeof(alignments) / sizeof(alignments[0]);
+
+enum DeviceLoad { loadIdle = 0, loadCompute, numDeviceLoads };
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const size_t bytesPerRep = 1 << 30;
+static const size_t maxCopiesPerRep = 100;
+static const unsigned int computeIterations = 1 << 16;
+
+// dst and src are congruent modulo 16: bytes up to the first aligned address, then uint4
+__global__ void copyVector(unsigned char* dst, const unsigned char* src, size_t bytes) {
+  size_t tid = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+  head = head < bytes ? head : bytes;
+  for (size_t i = tid; i < head; i += stride) {
+    dst[i] = src[i];
+  }
+  size_t vectors = (bytes - head) / sizeof(uint4);
+  const uint4* s = reinterpret_cast<const uint4*>(src + head);
+  uint4* d = reinterpret_cast<uint4*>(dst + head);
+  for (size_t i = tid; i < vectors; i += stride) {
+    d[i] = s[i];
+  }
+  for (size_t i = head + vectors * sizeof(uint4) + tid; i < bytes; i += stride) {
+    dst[i] = src[i];
+  }
+}
+
+__global__ void copyBytes(unsigned char* dst, const unsigned char* src, size_t bytes) {
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < bytes;
+       i += stride) {
+    dst[i] = src[i];
+  }
+}
+
+__global__ void computeKernel(float* out, unsigned int iterations) {
+  unsigned int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  float a = static_cast<float>(tid), b = a + 1;
+  for (unsigned int i = 0; i < iterations; i++) {
+    a = fmaf(a, 0.999f, 0.5f);
+    b = fmaf(b, 0.999f, 0.5f);
+  }
+  out[tid] = a + b;
+}
+
+class hipPerfDeviceCopy : public HipPerf::Benchmark {
+ public:
+  hipPerfDeviceCopy() : HipPerf::Benchmark("hipPerfDeviceCopy"),
+      copySizes_(HipPerf::sweepSizes(std::vector<size_t>(
+          defaultCopySizes, defaultCopySizes + sizeof(defaultCopySizes) /
+                                                   sizeof(defaultCopySizes[0])))),
+      src_(nullptr), dst_(nullptr), computeOut_(nullptr), copyStream_(nullptr),
+      computeStream_(nullptr), computeStart_(nullptr), computeStop_(nullptr), computeAlone_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    size_t bufSize = *std::max_element(copySizes_.begin(), copySizes_.end()) + 64;
+    HIPCHECK(hipMalloc(&src_, bufSize));
+    HIPCHECK(hipMalloc(&dst_, bufSize));
+    HIPCHECK(hipMemset(src_, 1, bufSize));
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    HIPCHECK(hipMalloc(&computeOut_, static_cast<size_t>(grid_.x) * blockSize * sizeof(float)));
+    HIPCHECK(hipStreamCreateWithFlags(&copyStream_, hipStreamNonBlocking));
+    HIPCHECK(hipStreamCreateWithFlags(&computeStream_, hipStreamNonBlocking));
+    HIPCHECK(hipEventCreate(&computeStart_));
+    HIPCHECK(hipEventCreate(&computeStop_));
+
+    std::vector<double> alone;
+    for (int r = 0; r < 5; r++) {
+      alone.push_back(runCompute(true));
+    }
+    std::sort(alone.begin(), alone.end());
+    computeAlone_ = alone[alone.size() / 2];
+  }
+
+  void close() override {
+    HIPCHECK(hipEventDestroy(computeStart_));
+    HIPCHECK(hipEventDestroy(computeStop_));
+    HIPCHECK(hipStreamDestroy(copyStream_));
+    HIPCHECK(hipStreamDestroy(computeStream_));
+    HIPCHECK(hipFree(computeOut_));
+    HIPCHECK(hipFree(src_));
+    HIPCHECK(hipFree(dst_));
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(copySizes_.size()) * numAlignments * numCopyMethods *
+        numDeviceLoads;
+  }
+
+  void run(unsigned int test) override {
+    CopyMethod method = static_cast<CopyMethod>(test % numCopyMethods);
+    DeviceLoad load = static_cast<DeviceLoad>(test / numCopyMethods % numDeviceLoads);
+    const Alignment& align = alignments[test / (numCopyMethods * numDeviceLoads) % numAlignments];
+    size_t bytes = copySizes_[test / (numCopyMethods * numDeviceLoads * numAlignments)];
+
+    unsigned char* src = src_ + align.src;
+    unsigned char* dst = dst_ + align.dst;
+    bool vector =
+        (reinterpret_cast<uintptr_t>(src) & 15) == (reinterpret_cast<uintptr_t>(dst) & 15);
+    size_t copies = std::max<size_t>(1, std::min(maxCopiesPerRep, bytesPerRep / bytes));
+    std::vector<double> computeRatio;
+
+    HIPCHECK(hipDeviceSynchronize());
+    auto sec = measure([&]() {
+      if (load == loadCompute) {
+        runCompute(false);
+      }
+      for (size_t c = 0; c < copies; c++) {
+        switch (method) {
+          case methodDtoD:
+            HIPCHECK(hipMemcpyDtoD(reinterpret_cast<hipDeviceptr_t>(dst),
+                                   reinterpret_cast<hipDeviceptr_t>(src), bytes));
+            break;
+          case methodDtoDAsync:
+            HIPCHECK(hipMemcpyDtoDAsync(reinterpret_cast<hipDeviceptr_t>(dst),
+                                        reinterpret_cast<hipDeviceptr_t>(src), bytes,
+                                        copyStream_));
+            break;
+          default:
+            if (vector) {
+              hipLaunchKernelGGL(copyVector, grid_, dim3(blockSize), 0, copyStream_, dst, src,
+                                 bytes);
+            } else {
+              hipLaunchKernelGGL(copyBytes, grid_, dim3(blockSize), 0, copyStream_, dst, src,
+                                 bytes);
+            }
+            break;
+        }
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipStreamSynchronize(copyStream_));
+      if (load == loadCompute) {
+        HIPCHECK(hipEventSynchronize(computeStop_));
+        float ms = 0;
+        HIPCHECK(hipEventElapsedTime(&ms, computeStart_, computeStop_));
+        computeRatio.push_back(ms * 1e-3 / computeAlone_);
+      }
+    });
+    // Warm-up runs recorded ratios as well, keep the timed repetitions
+    if (computeRatio.size() > sec.size()) {
+      computeRatio.erase(computeRatio.begin(), computeRatio.end() - sec.size());
+    }
+
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%-18s%s %-9s %10zu B%s", copyMethodStr[method],
+             method == methodKernel ? (vector ? " uint4" : " bytes") : "", align.name, bytes,
+             load == loadCompute ? " with compute" : "");
+    report(test, desc, bytes, static_cast<unsigned int>(copies), "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(bytes) * copies));
+    report(test, std::string(desc) + " per copy", bytes, static_cast<unsigned int>(copies), "us",
+           HipPerf::toMicroseconds(sec, static_cast<double>(copies)));
+    if (load == loadCompute && computeAlone_ > 0) {
+      report(test, std::string(desc) + " compute time vs alone", bytes, 1, "x", computeRatio);
+    }
+  }
+
+ private:
+  // Enqueues the compute kernel between events; with wait returns its seconds.
+  double runCompute(bool wait) {
+    HIPCHECK(hipEventRecord(computeStart_, computeStream_));
+    hipLaunchKernelGGL(computeKernel, grid_, dim3(blockSize), 0, computeStream_, computeOut_,
+                       computeIterations);
+    HIPCHECK(hipEventRecord(computeStop_, computeStream_));
+    if (!wait) {
+      return 0;
+    }
+    HIPCHECK(hipEventSynchronize(computeStop_));
+    float ms = 0;
+    HIPCHECK(hipEventElapsedTime(&ms, computeStart_, computeStop_));
+    return ms * 1e-3;
+  }
+
+  std::vector<size_t> copySizes_;
+  unsigned char* src_;
+  unsigned char* dst_;
+  float* computeOut_;
+  dim3 grid_;
+  hipStream_t copyStream_;
+  hipStream_t computeStream_;
+  hipEvent_t computeStart_;
+  hipEvent_t computeStop_;
+  double computeAlone_;  // median seconds of the compute kernel on an idle device
+};
+
+HIP_PERF_BENCHMARK(hipPerfDeviceCopy)
@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Device side malloc()/free() throughput against a per-block bump allocator,
+// and device heap fragmentation under churn.
+//
+// The throughput tests let every thread allocate, touch and free 'rounds'
+// blocks of a fixed size or of a mixed 16 B - 4 KB distribution, on one
+// block, one block per CU and four blocks per CU. The bump allocator carves
+// the allocations out of a per-block slice of a hipMalloc pool with a shared
+// memory atomic and releases a whole round at once. Reports allocations per
+// second and the percentage of failed allocations.
+//
+// The fragmentation test keeps slotsPerThread live allocations per thread and
+// in every phase replaces random ones with new mixed size allocations. After
+// each phase every block probes for one probeSize allocation. Reports per
+// phase the time per replacement, failed replacements and successful probes.
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+
+enum Allocator { allocDeviceMalloc = 0, allocBump, numAllocators };
+enum SizeMode { size16 = 0, size256, size4K, sizeMixed, numSizeModes };
+enum GridMode { gridOneBlock = 0, gridPerCu, gridFourPerCu, numGridModes };
+
+static const char* allocatorStr[numAllocators] = {"device malloc", "bump allocator"};
+static const char* sizeModeStr[numSizeModes] = {"16 B", "256 B", "4 KB", "mixed 16 B - 4 KB"};
+static const char* gridModeStr[numGridModes] = {"1 block", "1 block/CU", "4 blocks/CU"};
+
+static const unsigned int blockSize = 256;
+static const unsigned int rounds = 16;
+static const size_t maxAllocSize = 4096;
+// A bump allocator round holds one allocation per thread of the block
+static const size_t bumpSlice = blockSize * maxAllocSize;
+
+static const unsigned int slotsPerThread = 4;
+static const unsigned int churnSteps = 64;
+static const unsigned int numPhases = 8;
+static const size_t probeSize = 64 * 1024;
+
+__device__ inline unsigned int hashOf(unsigned int x) {
+  x ^= x >> 16;
+  x *= 0x7feb352dU;
+  x ^= x >> 15;
+  x *= 0x846ca68bU;
+  x ^= x >> 16;
+  return x;
+}
+
+// Mixed sizes favour small blocks: 16 B << e with e uniform in [0, 8]
+__device__ inline size_t allocSize(SizeMode mode, unsigned int key) {
+  switch (mode) {
+    case size16: return 16;
+    case size256: return 256;
+    case size4K: return 4096;
+    default: return static_cast<size_t>(16) << (hashOf(key) % 9);
+  }
+}
+
+__device__ inline void touch(char* ptr, size_t size) {
+  ptr[0] = 1;
+  ptr[size - 1] = 1;
+}
+
+__global__ void deviceMallocKernel(SizeMode mode, unsigned long long* failures) {
+  unsigned int thread = blockIdx.x * blockDim.x + threadIdx.x;
+  unsigned int failed = 0;
+  for (unsigned int r = 0; r < rounds; r++) {
+    size_t size = allocSize(mode, thread * rounds + r);
+    char* ptr = static_cast<char*>(malloc(size));
+    if (ptr == nullptr) {
+      failed++;
+      continue;
+    }
+    touch(ptr, size);
+    free(ptr);
+  }
+  if (failed != 0) {
+    atomicAdd(failures, static_cast<unsigned long long>(failed));
+  }
+}
+
+__global__ void bumpKernel(SizeMode mode, char* pool, unsigned long long* failures) {
+  __shared__ unsigned int offset;
+  unsigned int thread = blockIdx.x * blockDim.x + threadIdx.x;
+  char* slice = pool + blockIdx.x * bumpSlice;
+  for (unsigned int r = 0; r < rounds; r++) {
+    if (threadIdx.x == 0) {
+      offset = 0;
+    }
+    __syncthreads();
+    size_t size = allocSize(mode, thread * rounds + r);
+    // 16 byte aligned like malloc()
+    unsigned int start = atomicAdd(&offset, static_cast<unsigned int>((size + 15) & ~15));
+    touch(slice + start, size);
+    // Releasing the round is resetting the offset once everybody is done
+    __syncthreads();
+  }
+}
+
+__global__ void churnKernel(void** slots, unsigned int phase, unsigned long long* failures) {
+  unsigned int thread = blockIdx.x * blockDim.x + threadIdx.x;
+  void** mine = slots + static_cast<size_t>(thread) * slotsPerThread;
+  unsigned int failed = 0;
+  for (unsigned int s = 0; s < churnSteps; s++) {
+    unsigned int key = hashOf((phase * churnSteps + s) * 0x9e3779b9U + thread);
+    unsigned int slot = key % slotsPerThread;
+    if (mine[slot] != nullptr) {
+      free(mine[slot]);
+    }
+    size_t size = allocSize(sizeMixed, key >> 8);
+    char* ptr = static_cast<char*>(malloc(size));
+    if (ptr == nullptr) {
+      failed++;
+    } else {
+      touch(ptr, size);
+    }
+    mine[slot] = ptr;
+  }
+  if (failed != 0) {
+    atomicAdd(failures, static_cast<unsigned long long>(failed));
+  }
+}
+
+__global__ void probeKernel(unsigned long long* successes) {
+  if (threadIdx.x == 0) {
+    void* ptr = malloc(probeSize);
+    if (ptr != nullptr) {
+      atomicAdd(successes, 1ull);
+      free(ptr);
+    }
+  }
+}
+
+__global__ void freeSlotsKernel(void** slots) {
+  unsigned int thread = blockIdx.x * blockDim.x + threadIdx.x;
+  for (unsigned int i = 0; i < slotsPerThread; i++) {
+    void*& slot = slots[static_cast<size_t>(thread) * slotsPerThread + i];
+    if (slot != nullptr) {
+      free(slot);
+      slot = nullptr;
+    }
+  }
+}
+
+class hipPerfDeviceMalloc : public HipPerf::Benchmark {
+ public:
+  hipPerfDeviceMalloc() : HipPerf::Benchmark("hipPerfDeviceMalloc"), counter_(nullptr),
+      stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&counter_, sizeof(*counter_)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(counter_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  // One extra test index for the fragmentation run
+  unsigned int numTests() override { return numAllocators * numSizeModes * numGridModes + 1; }
+
+  void run(unsigned int test) override {
+    if (test == numAllocators * numSizeModes * numGridModes) {
+      runFragmentation(test);
+      return;
+    }
+    GridMode gridMode = static_cast<GridMode>(test % numGridModes);
+    SizeMode sizeMode = static_cast<SizeMode>((test / numGridModes) % numSizeModes);
+    Allocator allocator = static_cast<Allocator>(test / (numGridModes * numSizeModes));
+
+    unsigned int blocks = gridMode == gridOneBlock ? 1 : gridMode == gridPerCu
+        ? props_.multiProcessorCount : props_.multiProcessorCount * 4;
+    char* pool = nullptr;
+    if (allocator == allocBump) {
+      HIPCHECK(hipMalloc(&pool, blocks * bumpSlice));
+    }
+    HIPCHECK(hipMemset(counter_, 0, sizeof(*counter_)));
+
+    auto sec = measure([&]() {
+      if (allocator == allocDeviceMalloc) {
+        hipLaunchKernelGGL(deviceMallocKernel, dim3(blocks), dim3(blockSize), 0, stream_,
+                           sizeMode, counter_);
+      } else {
+        hipLaunchKernelGGL(bumpKernel, dim3(blocks), dim3(blockSize), 0, stream_, sizeMode, pool,
+                           counter_);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    unsigned long long failures = 0;
+    HIPCHECK(hipMemcpy(&failures, counter_, sizeof(failures), hipMemcpyDeviceToHost));
+    if (pool != nullptr) {
+      HIPCHECK(hipFree(pool));
+    }
+
+    double allocs = static_cast<double>(blocks) * blockSize * rounds;
+    std::vector<double> rates;
+    for (double s : sec) {
+      rates.push_back(allocs / s / 1e6);
+    }
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%-14s %-17s %-11s", allocatorStr[allocator],
+             sizeModeStr[sizeMode], gridModeStr[gridMode]);
+    report(test, desc, 0, rounds, "Mallocs/s", rates);
+    report(test, std::string(desc) + " failed", 0, rounds, "%",
+           {100.0 * failures / (allocs * (p_warmup + p_repetitions))});
+  }
+
+ private:
+  void runFragmentation(unsigned int test) {
+    unsigned int blocks = props_.multiProcessorCount;
+    size_t threads = static_cast<size_t>(blocks) * blockSize;
+    size_t slotBytes = threads * slotsPerThread * sizeof(void*);
+    void** slots = nullptr;
+    HIPCHECK(hipMalloc(&slots, slotBytes));
+    HIPCHECK(hipMemset(slots, 0, slotBytes));
+
+    unsigned int launch = 0;
+    for (unsigned int phase = 0; phase < numPhases; phase++) {
+      HIPCHECK(hipMemset(counter_, 0, sizeof(*counter_)));
+      // Every launch continues the churn, warm-up launches included
+      auto sec = measure([&]() {
+        hipLaunchKernelGGL(churnKernel, dim3(blocks), dim3(blockSize), 0, stream_, slots,
+                           launch++, counter_);
+        HIPCHECK(hipStreamSynchronize(stream_));
+      }, 0);
+      unsigned long long failures = 0;
+      HIPCHECK(hipMemcpy(&failures, counter_, sizeof(failures), hipMemcpyDeviceToHost));
+
+      HIPCHECK(hipMemset(counter_, 0, sizeof(*counter_)));
+      hipLaunchKernelGGL(probeKernel, dim3(blocks), dim3(blockSize), 0, stream_, counter_);
+      HIPCHECK(hipStreamSynchronize(stream_));
+      unsigned long long probes = 0;
+      HIPCHECK(hipMemcpy(&probes, counter_, sizeof(probes), hipMemcpyDeviceToHost));
+
+      double ops = static_cast<double>(threads) * churnSteps;
+      char desc[96];
+      snprintf(desc, sizeof(desc), "fragmentation phase %u, %u live allocations per thread",
+               phase, slotsPerThread);
+      report(test, desc, 0, churnSteps, "us/op", HipPerf::toMicroseconds(sec, ops));
+      report(test, std::string(desc) + " failed", 0, churnSteps, "%",
+             {100.0 * failures / (ops * sec.size())});
+      report(test, std::string(desc) + " 64 KB probes succeeded", 0, 1, "%",
+             {100.0 * probes / blocks});
+    }
+
+    hipLaunchKernelGGL(freeSlotsKernel, dim3(blocks), dim3(blockSize), 0, stream_, slots);
+    HIPCHECK(hipStreamSynchronize(stream_));
+    HIPCHECK(hipFree(slots));
+  }
+
+  unsigned long long* counter_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfDeviceMalloc)
@@ -0,0 +1,210 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Embedding style row gather and scatter through an index buffer. The table
+// is 256 MB of rows 4 to 1024 bytes wide (--sizes replaces the widths, which
+// must be powers of two of at least 4 bytes); every pass looks up 64 MB worth
+// of rows. Indices are uniform, Zipfian (skew 1.05, hot rows spread over the
+// table by an odd multiplier) or uniform and sorted, as after deduplicating a
+// batch. Gather copies the indexed rows into a dense buffer, scatter writes a
+// dense buffer into the indexed rows (duplicates: last writer wins). Reports
+// the row bytes moved per second, excluding the index and dense buffer
+// traffic, and the share of distinct rows among the lookups, which is what
+// the caches get to work with.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const std::vector<size_t> Sizes = {4, 16, 64, 256, 1024};
+static const size_t tableBytes = 256 * 1024 * 1024;
+static const size_t lookupBytes = 64 * 1024 * 1024;
+static const double zipfSkew = 1.05;
+
+enum IndexDist { distUniform = 0, distZipf, distSorted, numIndexDists };
+static const char* indexDistStr[numIndexDists] = {"uniform", "zipf 1.05", "sorted"};
+
+enum GatherDir { dirGather = 0, dirScatter, numGatherDirs };
+static const char* gatherDirStr[numGatherDirs] = {"gather", "scatter"};
+
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 16;
+
+// One element per thread, elements of a row on neighbouring threads
+template <typename T>
+__global__ void gatherRows(T* dense, const T* table, const int* indices, size_t lookups,
+                           unsigned int shift) {
+  size_t mask = (static_cast<size_t>(1) << shift) - 1;
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < (lookups << shift);
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    dense[i] = table[(static_cast<size_t>(indices[i >> shift]) << shift) + (i & mask)];
+  }
+}
+
+template <typename T>
+__global__ void scatterRows(T* table, const T* dense, const int* indices, size_t lookups,
+                            unsigned int shift) {
+  size_t mask = (static_cast<size_t>(1) << shift) - 1;
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < (lookups << shift);
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    table[(static_cast<size_t>(indices[i >> shift]) << shift) + (i & mask)] = dense[i];
+  }
+}
+
+static unsigned int log2Of(size_t v) {
+  unsigned int shift = 0;
+  while ((static_cast<size_t>(1) << shift) < v) shift++;
+  return shift;
+}
+
+class hipPerfEmbeddingGather : public HipPerf::Benchmark {
+ public:
+  hipPerfEmbeddingGather() : HipPerf::Benchmark("hipPerfEmbeddingGather"),
+      widths_(HipPerf::sweepSizes(Sizes)), passes_(HipPerf::iterationCount(10)), table_(nullptr),
+      dense_(nullptr), indices_(nullptr), builtWidth_(0), builtDist_(numIndexDists),
+      distinct_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    if (tableBytes + 2 * lookupBytes > props_.totalGlobalMem / 2) {
+      return;
+    }
+    HIPCHECK(hipMalloc(&table_, tableBytes));
+    HIPCHECK(hipMalloc(&dense_, lookupBytes));
+    // Four byte rows need the most indices
+    HIPCHECK(hipMalloc(&indices_, lookupBytes / 4 * sizeof(int)));
+    HIPCHECK(hipMemset(table_, 1, tableBytes));
+    HIPCHECK(hipMemset(dense_, 2, lookupBytes));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(table_));
+    HIPCHECK(hipFree(dense_));
+    HIPCHECK(hipFree(indices_));
+  }
+
+  unsigned int numTests() override { return widths_.size() * numIndexDists * numGatherDirs; }
+
+  void run(unsigned int test) override {
+    GatherDir dir = static_cast<GatherDir>(test % numGatherDirs);
+    IndexDist dist = static_cast<IndexDist>((test / numGatherDirs) % numIndexDists);
+    size_t width = widths_[test / (numGatherDirs * numIndexDists)];
+    if (table_ == nullptr) {
+      printf("info: device memory too small for a %zu MB table, skipping\n", tableBytes >> 20);
+      return;
+    }
+    if (width < 4 || width > lookupBytes || (width & (width - 1)) != 0) {
+      printf("info: row width %zu is not a power of two of at least 4 bytes, skipping\n", width);
+      return;
+    }
+
+    size_t lookups = lookupBytes / width;
+    // Gather and scatter of a width and distribution share the indices
+    if (width != builtWidth_ || dist != builtDist_) {
+      buildIndices(width, dist, lookups);
+    }
+
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < passes_; i++) {
+        if (width >= sizeof(uint4)) {
+          launch<uint4>(dir, lookups, log2Of(width / sizeof(uint4)));
+        } else {
+          launch<unsigned int>(dir, lookups, log2Of(width / sizeof(unsigned int)));
+        }
+      }
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%-7s %-9s", gatherDirStr[dir], indexDistStr[dist]);
+    report(test, desc, width, passes_, "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(lookupBytes) * passes_));
+    if (dir == dirGather) {
+      report(test, desc, width, passes_, "% distinct rows", {100.0 * distinct_ / lookups});
+    }
+  }
+
+ private:
+  template <typename T> void launch(GatherDir dir, size_t lookups, unsigned int shift) {
+    if (dir == dirGather) {
+      hipLaunchKernelGGL(gatherRows<T>, grid_, dim3(blockSize), 0, 0, static_cast<T*>(dense_),
+                         static_cast<const T*>(table_), indices_, lookups, shift);
+    } else {
+      hipLaunchKernelGGL(scatterRows<T>, grid_, dim3(blockSize), 0, 0, static_cast<T*>(table_),
+                         static_cast<const T*>(dense_), indices_, lookups, shift);
+    }
+  }
+
+  // Fixed seed, so every run and device looks up the same rows
+  void buildIndices(size_t width, IndexDist dist, size_t lookups) {
+    size_t rows = tableBytes / width;
+    std::vector<int> indices(lookups);
+    std::mt19937_64 rng(0x5eed + width);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    if (dist == distZipf) {
+      // Inverse of the continuous power law on [1, rows + 1), then rank to row through an
+      // odd multiplier, a permutation since rows is a power of two
+      double exponent = 1.0 - zipfSkew;
+      double span = std::pow(static_cast<double>(rows) + 1, exponent) - 1;
+      for (auto& index : indices) {
+        size_t rank = static_cast<size_t>(std::pow(1 + unit(rng) * span, 1 / exponent)) - 1;
+        rank = std::min(rank, rows - 1);
+        index = static_cast<int>((rank * 2654435761ull) & (rows - 1));
+      }
+    } else {
+      std::uniform_int_distribution<int> uniform(0, static_cast<int>(rows - 1));
+      for (auto& index : indices) {
+        index = uniform(rng);
+      }
+      if (dist == distSorted) {
+        std::sort(indices.begin(), indices.end());
+      }
+    }
+    HIPCHECK(hipMemcpy(indices_, indices.data(), lookups * sizeof(int), hipMemcpyHostToDevice));
+
+    std::sort(indices.begin(), indices.end());
+    distinct_ = std::unique(indices.begin(), indices.end()) - indices.begin();
+    builtWidth_ = width;
+    builtDist_ = dist;
+  }
+
+  std::vector<size_t> widths_;
+  unsigned int passes_;  // per repetition
+  dim3 grid_;
+  void* table_;
+  void* dense_;
+  int* indices_;
+  size_t builtWidth_;
+  IndexDist builtDist_;
+  size_t distinct_;  // rows among the current indices
+};
+
+HIP_PERF_BENCHMARK(hipPerfEmbeddingGather)
@@ -0,0 +1,353 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lvulkan
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of bringing Vulkan memory into HIP and of using it afterwards. For
+// every size a device local Vulkan buffer is exported as an opaque fd; the
+// import test times hipImportExternalMemory, hipExternalMemoryGetMappedBuffer
+// and hipDestroyExternalMemory of a fresh fd per repetition, next to
+// hipMalloc/hipFree of the same size as the native alternative. Export of the
+// fd is not timed. The bandwidth test runs a read-modify-write kernel over the
+// mapped buffer and over hipMalloc memory and reports both in GB/s. Together
+// they show what re-importing on every resize costs against caching the
+// import. Skipped when no Vulkan device with external memory fd support is
+// found.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "perf_harness.h"
+
+#define VKCHECK(result)                                                                         \
+  {                                                                                             \
+    VkResult localResult = result;                                                              \
+    if (localResult != VK_SUCCESS) {                                                            \
+      failed("Vulkan error %d from %s at %s:%d\n", localResult, #result, __FILE__, __LINE__);    \
+    }                                                                                           \
+  }
+
+enum ExternalOp { opImport, opBandwidth, numExternalOps };
+
+static const size_t defaultSizes[] = {64 * 1024, 1024 * 1024, 16 * 1024 * 1024,
+                                      256 * 1024 * 1024};
+
+static const unsigned int kernelIterations = 20;
+
+// Each element read and written once
+__global__ void scaleKernel(float* data, size_t n) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    data[i] = data[i] * 0.5f + 1.0f;
+  }
+}
+
+class hipPerfExternalMemory : public HipPerf::Benchmark {
+ public:
+  hipPerfExternalMemory() : HipPerf::Benchmark("hipPerfExternalMemory"), available_(false),
+      instance_(VK_NULL_HANDLE), physical_(VK_NULL_HANDLE), device_(VK_NULL_HANDLE),
+      getMemoryFd_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    sizes_ = HipPerf::sweepSizes(std::vector<size_t>(std::begin(defaultSizes),
+                                                     std::end(defaultSizes)));
+    available_ = createDevice();
+    if (!available_) {
+      printf("info: no Vulkan device with external memory fds, skipping\n");
+    }
+  }
+
+  void close() override {
+    if (device_ != VK_NULL_HANDLE) {
+      vkDestroyDevice(device_, nullptr);
+    }
+    if (instance_ != VK_NULL_HANDLE) {
+      vkDestroyInstance(instance_, nullptr);
+    }
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(sizes_.size()) * numExternalOps;
+  }
+
+  void run(unsigned int test) override {
+    if (!available_) {
+      return;
+    }
+    ExternalOp op = static_cast<ExternalOp>(test % numExternalOps);
+    size_t bytes = sizes_[test / numExternalOps];
+
+    VkBuffer buffer;
+    VkDeviceMemory memory;
+    VkDeviceSize allocationSize = createExportedBuffer(bytes, &buffer, &memory);
+
+    if (op == opImport) {
+      runImport(test, bytes, memory, allocationSize);
+    } else {
+      runBandwidth(test, bytes, memory, allocationSize);
+    }
+
+    vkDestroyBuffer(device_, buffer, nullptr);
+    vkFreeMemory(device_, memory, nullptr);
+  }
+
+ private:
+  // Import, map and destroy of a new fd every repetition; hipMalloc/hipFree as reference
+  void runImport(unsigned int test, size_t bytes, VkDeviceMemory memory,
+                 VkDeviceSize allocationSize) {
+    std::vector<double> importUs, mapUs, destroyUs, mallocUs, freeUs;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      hipExternalMemoryHandleDesc memoryDesc = {};
+      memoryDesc.type = hipExternalMemoryHandleTypeOpaqueFd;
+      memoryDesc.handle.fd = memoryFd(memory);
+      memoryDesc.size = allocationSize;
+      hipExternalMemoryBufferDesc bufferDesc = {};
+      bufferDesc.offset = 0;
+      bufferDesc.size = bytes;
+
+      hipExternalMemory_t externalMemory;
+      void* mapped = nullptr;
+      auto start = std::chrono::steady_clock::now();
+      HIPCHECK(hipImportExternalMemory(&externalMemory, &memoryDesc));
+      double importSec = HipTest::secondsSince(start);
+      start = std::chrono::steady_clock::now();
+      HIPCHECK(hipExternalMemoryGetMappedBuffer(&mapped, externalMemory, &bufferDesc));
+      double mapSec = HipTest::secondsSince(start);
+      start = std::chrono::steady_clock::now();
+      HIPCHECK(hipDestroyExternalMemory(externalMemory));
+      double destroySec = HipTest::secondsSince(start);
+
+      void* native = nullptr;
+      start = std::chrono::steady_clock::now();
+      HIPCHECK(hipMalloc(&native, bytes));
+      double mallocSec = HipTest::secondsSince(start);
+      start = std::chrono::steady_clock::now();
+      HIPCHECK(hipFree(native));
+      double freeSec = HipTest::secondsSince(start);
+
+      if (r >= p_warmup) {
+        importUs.push_back(importSec * 1e6);
+        mapUs.push_back(mapSec * 1e6);
+        destroyUs.push_back(destroySec * 1e6);
+        mallocUs.push_back(mallocSec * 1e6);
+        freeUs.push_back(freeSec * 1e6);
+      }
+    }
+    report(test, "hipImportExternalMemory", bytes, 1, "us", importUs);
+    report(test, "hipExternalMemoryGetMappedBuffer", bytes, 1, "us", mapUs);
+    report(test, "hipDestroyExternalMemory", bytes, 1, "us", destroyUs);
+    report(test, "hipMalloc", bytes, 1, "us", mallocUs);
+    report(test, "hipFree", bytes, 1, "us", freeUs);
+  }
+
+  // Same kernel over the imported buffer and over hipMalloc memory
+  void runBandwidth(unsigned int test, size_t bytes, VkDeviceMemory memory,
+                    VkDeviceSize allocationSize) {
+    hipExternalMemoryHandleDesc memoryDesc = {};
+    memoryDesc.type = hipExternalMemoryHandleTypeOpaqueFd;
+    memoryDesc.handle.fd = memoryFd(memory);
+    memoryDesc.size = allocationSize;
+    hipExternalMemory_t externalMemory;
+    HIPCHECK(hipImportExternalMemory(&externalMemory, &memoryDesc));
+    hipExternalMemoryBufferDesc bufferDesc = {};
+    bufferDesc.offset = 0;
+    bufferDesc.size = bytes;
+    void* imported = nullptr;
+    HIPCHECK(hipExternalMemoryGetMappedBuffer(&imported, externalMemory, &bufferDesc));
+    void* native = nullptr;
+    HIPCHECK(hipMalloc(&native, bytes));
+    HIPCHECK(hipMemset(imported, 0, bytes));
+    HIPCHECK(hipMemset(native, 0, bytes));
+    HIPCHECK(hipDeviceSynchronize());
+
+    size_t n = bytes / sizeof(float);
+    unsigned int blocks = static_cast<unsigned int>(
+        std::min<size_t>((n + 255) / 256, props_.multiProcessorCount * 16));
+    double moved = 2.0 * bytes * kernelIterations;
+    void* targets[] = {imported, native};
+    const char* targetStr[] = {"imported", "hipMalloc"};
+    for (int t = 0; t < 2; t++) {
+      float* data = static_cast<float*>(targets[t]);
+      auto seconds = measure([&]() {
+        for (unsigned int i = 0; i < kernelIterations; i++) {
+          hipLaunchKernelGGL(scaleKernel, dim3(blocks), dim3(256), 0, 0, data, n);
+        }
+        HIPCHECK(hipGetLastError());
+        HIPCHECK(hipDeviceSynchronize());
+      });
+      report(test, std::string(targetStr[t]) + " read-write", bytes, kernelIterations, "GB/s",
+             HipPerf::toBandwidth(seconds, moved));
+    }
+
+    HIPCHECK(hipFree(native));
+    HIPCHECK(hipDestroyExternalMemory(externalMemory));
+  }
+
+  static bool hasExtensions(const std::vector<VkExtensionProperties>& supported,
+                            const std::vector<const char*>& required) {
+    for (const char* name : required) {
+      bool found = false;
+      for (const auto& properties : supported) {
+        found = found || strcmp(properties.extensionName, name) == 0;
+      }
+      if (!found) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Instance and device with external memory fd support, false when unsupported
+  bool createDevice() {
+    std::vector<const char*> instanceExtensions = {
+        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
+        VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME};
+    uint32_t count = 0;
+    if (vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr) != VK_SUCCESS) {
+      return false;
+    }
+    std::vector<VkExtensionProperties> supported(count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &count, supported.data());
+    if (!hasExtensions(supported, instanceExtensions)) {
+      return false;
+    }
+
+    VkApplicationInfo appInfo = {};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.apiVersion = VK_API_VERSION_1_1;
+    VkInstanceCreateInfo instanceInfo = {};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &appInfo;
+    instanceInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
+    instanceInfo.ppEnabledExtensionNames = instanceExtensions.data();
+    if (vkCreateInstance(&instanceInfo, nullptr, &instance_) != VK_SUCCESS) {
+      instance_ = VK_NULL_HANDLE;
+      return false;
+    }
+
+    count = 0;
+    vkEnumeratePhysicalDevices(instance_, &count, nullptr);
+    if (count == 0) {
+      return false;
+    }
+    std::vector<VkPhysicalDevice> physicals(count);
+    vkEnumeratePhysicalDevices(instance_, &count, physicals.data());
+    physical_ = physicals[0];
+
+    std::vector<const char*> deviceExtensions = {VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
+                                                 VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME};
+    count = 0;
+    vkEnumerateDeviceExtensionProperties(physical_, nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> deviceSupported(count);
+    vkEnumerateDeviceExtensionProperties(physical_, nullptr, &count, deviceSupported.data());
+    if (!hasExtensions(deviceSupported, deviceExtensions)) {
+      return false;
+    }
+
+    // No work is submitted, any queue family will do
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = 0;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    deviceInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    VKCHECK(vkCreateDevice(physical_, &deviceInfo, nullptr, &device_));
+
+    getMemoryFd_ =
+        reinterpret_cast<PFN_vkGetMemoryFdKHR>(vkGetDeviceProcAddr(device_, "vkGetMemoryFdKHR"));
+    return getMemoryFd_ != nullptr;
+  }
+
+  // Device local buffer with exportable memory bound to it, returns the allocation size
+  VkDeviceSize createExportedBuffer(VkDeviceSize bytes, VkBuffer* buffer, VkDeviceMemory* memory) {
+    VkExternalMemoryBufferCreateInfo externalInfo = {};
+    externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+    externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.pNext = &externalInfo;
+    bufferInfo.size = bytes;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VKCHECK(vkCreateBuffer(device_, &bufferInfo, nullptr, buffer));
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device_, *buffer, &requirements);
+    VkPhysicalDeviceMemoryProperties properties;
+    vkGetPhysicalDeviceMemoryProperties(physical_, &properties);
+    uint32_t type = VK_MAX_MEMORY_TYPES;
+    for (uint32_t i = 0; i < properties.memoryTypeCount && type == VK_MAX_MEMORY_TYPES; i++) {
+      if ((requirements.memoryTypeBits & (1u << i)) &&
+          (properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+        type = i;
+      }
+    }
+    if (type == VK_MAX_MEMORY_TYPES) {
+      failed("no device local Vulkan memory type for %zu bytes", static_cast<size_t>(bytes));
+    }
+
+    VkExportMemoryAllocateInfo exportInfo = {};
+    exportInfo.sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO;
+    exportInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.pNext = &exportInfo;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = type;
+    VKCHECK(vkAllocateMemory(device_, &allocateInfo, nullptr, memory));
+    VKCHECK(vkBindBufferMemory(device_, *buffer, *memory, 0));
+    return requirements.size;
+  }
+
+  // A new fd for memory; the import takes ownership of it
+  int memoryFd(VkDeviceMemory memory) {
+    VkMemoryGetFdInfoKHR fdInfo = {};
+    fdInfo.sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR;
+    fdInfo.memory = memory;
+    fdInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+    int fd = -1;
+    VKCHECK(getMemoryFd_(device_, &fdInfo, &fd));
+    return fd;
+  }
+
+  std::vector<size_t> sizes_;
+  bool available_;
+  VkInstance instance_;
+  VkPhysicalDevice physical_;
+  VkDevice device_;
+  PFN_vkGetMemoryFdKHR getMemoryFd_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfExternalMemory)
@@ -0,0 +1,184 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Implicit synchronization in frees. A cleanup thread frees an 8 MB block
+// with hipFree (from hipMalloc), hipHostFree (from hipHostMalloc) or
+// hipFreeAsync on its own stream (from hipMallocAsync), either on an idle
+// device or while a 20 ms kernel runs on an unrelated stream; the kernel has
+// started when the free is issued. Meanwhile the main thread launches empty
+// kernels on a third stream and synchronizes each. Reports the latency of
+// the free call, the free against the running kernel's duration ("x kernel",
+// near 1 when the free waited for it) and the longest round trip of the
+// probe kernels during the free, the stall seen by unrelated stream work.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum FreeOp { opFree = 0, opHostFree, opFreeAsync, numFreeOps };
+static const char* freeOpStr[numFreeOps] = {"hipFree", "hipHostFree", "hipFreeAsync"};
+
+enum DeviceState { stateIdle = 0, stateBusy, numDeviceStates };
+static const char* deviceStateStr[numDeviceStates] = {"idle device", "20 ms kernel running"};
+
+static const size_t blockBytes = 8 << 20;
+static const double busyKernelSec = 0.02;
+
+__global__ void _busyKernel(volatile int* started, unsigned long long ticks) {
+  unsigned long long start = wall_clock64();
+  if (threadIdx.x == 0) {
+    *started = 1;
+    __threadfence_system();
+  }
+  while (wall_clock64() - start < ticks) {
+  }
+}
+
+__global__ void _probeKernel() {}
+
+class hipPerfFreeSync : public HipPerf::Benchmark {
+ public:
+  hipPerfFreeSync() : HipPerf::Benchmark("hipPerfFreeSync"), busyStream_(nullptr),
+      freeStream_(nullptr), probeStream_(nullptr), started_(nullptr), wallRateKHz_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&wallRateKHz_, hipDeviceAttributeWallClockRate, deviceId));
+    HIPCHECK(hipStreamCreateWithFlags(&busyStream_, hipStreamNonBlocking));
+    HIPCHECK(hipStreamCreateWithFlags(&freeStream_, hipStreamNonBlocking));
+    HIPCHECK(hipStreamCreateWithFlags(&probeStream_, hipStreamNonBlocking));
+    HIPCHECK(hipHostMalloc(&started_, sizeof(int), hipHostMallocMapped));
+  }
+
+  void close() override {
+    HIPCHECK(hipHostFree(started_));
+    HIPCHECK(hipStreamDestroy(probeStream_));
+    HIPCHECK(hipStreamDestroy(freeStream_));
+    HIPCHECK(hipStreamDestroy(busyStream_));
+  }
+
+  unsigned int numTests() override { return numFreeOps * numDeviceStates; }
+
+  void run(unsigned int test) override {
+    FreeOp op = static_cast<FreeOp>(test % numFreeOps);
+    DeviceState state = static_cast<DeviceState>(test / numFreeOps);
+    if (state == stateBusy && wallRateKHz_ <= 0) {
+      printf("info: no wall clock rate, skipping %s with a kernel running\n", freeOpStr[op]);
+      return;
+    }
+    unsigned long long ticks =
+        static_cast<unsigned long long>(busyKernelSec * wallRateKHz_ * 1e3);
+
+    std::vector<double> freeSec, stallSec;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      void* block = nullptr;
+      switch (op) {
+        case opFree:
+          HIPCHECK(hipMalloc(&block, blockBytes));
+          break;
+        case opHostFree:
+          HIPCHECK(hipHostMalloc(&block, blockBytes));
+          break;
+        default:
+          HIPCHECK(hipMallocAsync(&block, blockBytes, freeStream_));
+          break;
+      }
+      HIPCHECK(hipDeviceSynchronize());
+
+      if (state == stateBusy) {
+        volatile int* started = started_;
+        *started = 0;
+        hipLaunchKernelGGL(_busyKernel, dim3(1), dim3(64), 0, busyStream_, started_, ticks);
+        HIPCHECK(hipGetLastError());
+        while (*started == 0) {
+        }
+      }
+
+      std::atomic<bool> done(false);
+      double freeTime = 0;
+      std::thread cleanup([&]() {
+        auto start = std::chrono::steady_clock::now();
+        switch (op) {
+          case opFree:
+            HIPCHECK(hipFree(block));
+            break;
+          case opHostFree:
+            HIPCHECK(hipHostFree(block));
+            break;
+          default:
+            HIPCHECK(hipFreeAsync(block, freeStream_));
+            break;
+        }
+        freeTime = HipTest::secondsSince(start);
+        done.store(true);
+      });
+      // At least one probe, so an idle free that returns at once still gets a round trip
+      double stall = 0;
+      do {
+        auto start = std::chrono::steady_clock::now();
+        hipLaunchKernelGGL(_probeKernel, dim3(1), dim3(1), 0, probeStream_);
+        HIPCHECK(hipStreamSynchronize(probeStream_));
+        stall = std::max(stall, HipTest::secondsSince(start));
+      } while (!done.load());
+      cleanup.join();
+      HIPCHECK(hipDeviceSynchronize());
+
+      if (r >= p_warmup) {
+        freeSec.push_back(freeTime);
+        stallSec.push_back(stall);
+      }
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-12s %-20s", freeOpStr[op], deviceStateStr[state]);
+    std::string prefix(desc);
+    report(test, prefix + " free", blockBytes, 1, "us", HipPerf::toMicroseconds(freeSec, 1));
+    if (state == stateBusy) {
+      std::vector<double> ratio;
+      for (double s : freeSec) {
+        ratio.push_back(s / busyKernelSec);
+      }
+      report(test, prefix + " free", blockBytes, 1, "x kernel", ratio);
+    }
+    report(test, prefix + " probe max", blockBytes, 1, "us",
+           HipPerf::toMicroseconds(stallSec, 1));
+  }
+
+ private:
+  hipStream_t busyStream_;
+  hipStream_t freeStream_;
+  hipStream_t probeStream_;
+  int* started_;  // mapped, set by the busy kernel once it runs
+  int wallRateKHz_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfFreeSync)
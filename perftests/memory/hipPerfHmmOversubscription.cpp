@@ -0,0 +1,121 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Kernel bandwidth over a hipMallocManaged working set swept from 50% to 300%
+// of device memory. Each run makes --iterations read-modify-write passes over
+// the whole set. Beyond 100% every pass must evict and migrate back at least
+// the part that does not fit, reported as the implied migration rate (a lower
+// bound, the runtime may move more). Working sets that exceed 80% of host
+// memory are skipped. On AMD this needs an xnack+ target, like the HMM
+// oversubscription stress test.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "perf_harness.h"
+
+static const unsigned int workingSetPercent[] = {50, 75, 90, 100, 110, 125, 150, 200, 300};
+static const unsigned int numWorkingSets = sizeof(workingSetPercent) / sizeof(workingSetPercent[0]);
+
+__global__ void _scaleKernel(float* ptr, size_t n) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    ptr[i] *= 2;
+  }
+}
+
+class hipPerfHmmOversubscription : public HipPerf::Benchmark {
+ public:
+  hipPerfHmmOversubscription() : HipPerf::Benchmark("hipPerfHmmOversubscription"),
+      passes_(HipPerf::iterationCount(3)), deviceMem_(0), hostMem_(0), supported_(false) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    size_t freeMem = 0;
+    HIPCHECK(hipMemGetInfo(&freeMem, &deviceMem_));
+    hostMem_ = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGE_SIZE);
+#ifdef __HIP_PLATFORM_AMD__
+    supported_ = props_.managedMemory != 0 &&
+                 std::string(props_.gcnArchName).find("xnack+") != std::string::npos;
+#else
+    supported_ = props_.managedMemory != 0;
+#endif
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override { HIPCHECK(hipStreamDestroy(stream_)); }
+
+  unsigned int numTests() override { return numWorkingSets; }
+
+  void run(unsigned int test) override {
+    unsigned int percent = workingSetPercent[test];
+    size_t size = deviceMem_ / 100 * percent;
+    if (!supported_) {
+      printf("info: device %d cannot oversubscribe managed memory, skipping\n", deviceId_);
+      return;
+    }
+    if (size > hostMem_ / 10 * 8) {
+      printf("info: %u%% working set (%zu MB) exceeds host memory, skipping\n", percent,
+             size >> 20);
+      return;
+    }
+
+    float* buf = nullptr;
+    HIPCHECK(hipMallocManaged(&buf, size));
+    memset(buf, 0, size);
+    size_t n = size / sizeof(float);
+
+    auto sec = measure([&]() {
+      for (unsigned int p = 0; p < passes_; p++) {
+        hipLaunchKernelGGL(_scaleKernel, dim3(props_.multiProcessorCount * 8), dim3(256), 0,
+                           stream_, buf, n);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    HIPCHECK(hipFree(buf));
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%3u%% of device memory", percent);
+    report(test, std::string(desc) + " kernel", size, passes_, "GB/s",
+           HipPerf::toBandwidth(sec, 2.0 * size * passes_));
+    if (size > deviceMem_) {
+      // Out to the host and back in, every pass
+      double migrated = 2.0 * (size - deviceMem_) * passes_;
+      report(test, std::string(desc) + " implied migration", size, passes_, "GB/s",
+             HipPerf::toBandwidth(sec, migrated));
+    }
+  }
+
+ private:
+  unsigned int passes_;
+  size_t deviceMem_;
+  size_t hostMem_;
+  bool supported_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfHmmOversubscription)
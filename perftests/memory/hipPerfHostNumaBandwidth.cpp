@@ -0,0 +1,198 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD_CMD: hipPerfHostNumaBandwidth %hc -I%S/../../src %S/%s %S/../../src/test_common.cpp %S/../../src/timer.cpp %S/../../src/perf_harness.cpp %S/../../src/perf_main.cpp -lnuma -o %T/%t EXCLUDE_HIP_PLATFORM nvidia
+ * TEST: %t
+ * HIT_END
+ */
+
+// Host <-> device bandwidth for every CPU NUMA node x GPU pair and every kind
+// of host allocation. The copying thread runs on the node and host pages are
+// bound to it while they are allocated and first touched, so the matrix shows
+// what a misplaced process or buffer costs on multi-socket systems.
+
+#include <errno.h>
+#include <numa.h>
+#include <numaif.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "perf_harness.h"
+
+enum HostKind {
+  hostPageable = 0,
+  hostRegistered,
+  hostMallocDefault,
+  hostMallocCoherent,
+  hostMallocNonCoherent,
+  hostMallocWriteCombined,
+  hostMallocNumaUser,
+  numHostKinds
+};
+
+static const char* hostKindStr[numHostKinds] = {
+  "pageable", "hipHostRegister", "hipHostMalloc", "hipHostMallocCoherent",
+  "hipHostMallocNonCoherent", "hipHostMallocWriteCombined", "hipHostMallocNumaUser"
+};
+
+static const unsigned int hostMallocFlags[numHostKinds] = {
+  0, 0, hipHostMallocDefault, hipHostMallocCoherent, hipHostMallocNonCoherent,
+  hipHostMallocWriteCombined, hipHostMallocNumaUser
+};
+
+class hipPerfHostNumaBandwidth : public HipPerf::Benchmark {
+ public:
+  hipPerfHostNumaBandwidth() : HipPerf::Benchmark("hipPerfHostNumaBandwidth"),
+                               numNodes_(0), numGpus_(0),
+                               sizes_(HipPerf::sweepSizes({64 * 1024 * 1024})),
+                               numIter_(HipPerf::iterationCount(20)) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    if (numa_available() < 0) {
+      failed("NUMA is not available on this system\n");
+    }
+    numNodes_ = numa_max_node() + 1;
+    HIPCHECK(hipGetDeviceCount(&numGpus_));
+    pageSize_ = getpagesize();
+  }
+
+  void close() override {
+    numa_run_on_node(-1);
+    HIPCHECK(hipSetDevice(deviceId_));
+  }
+
+  // size x direction x host kind x GPU x NUMA node
+  unsigned int numTests() override {
+    return sizes_.size() * 2 * numHostKinds * numGpus_ * numNodes_;
+  }
+
+  void run(unsigned int test) override {
+    unsigned int index = test;
+    size_t size = sizes_[index % sizes_.size()];
+    index /= sizes_.size();
+    bool toDevice = (index % 2) == 0;
+    index /= 2;
+    HostKind kind = static_cast<HostKind>(index % numHostKinds);
+    index /= numHostKinds;
+    int gpu = index % numGpus_;
+    int node = index / numGpus_;
+
+    if (numa_bitmask_isbitset(numa_all_nodes_ptr, node) == 0) {
+      return;  // Hole in the node numbering
+    }
+    if (numa_run_on_node(node) != 0) {
+      failed("numa_run_on_node(%d) failed with err %d\n", node, errno);
+    }
+    HIPCHECK(hipSetDevice(gpu));
+
+    void* mem = nullptr;
+    void* host = allocHost(kind, node, size, &mem);
+    int pageNode = nodeOf(host);
+    void* device = nullptr;
+    HIPCHECK(hipMalloc(&device, size));
+    HIPCHECK(hipMemset(device, 0, size));
+
+    hipStream_t stream;
+    HIPCHECK(hipStreamCreate(&stream));
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < numIter_; i++) {
+        if (toDevice) {
+          HIPCHECK(hipMemcpyAsync(device, host, size, hipMemcpyHostToDevice, stream));
+        } else {
+          HIPCHECK(hipMemcpyAsync(host, device, size, hipMemcpyDeviceToHost, stream));
+        }
+      }
+      HIPCHECK(hipStreamSynchronize(stream));
+    });
+
+    std::string desc = std::string(toDevice ? "H2D " : "D2H ") + hostKindStr[kind] +
+                       " node " + std::to_string(node) + " gpu " + std::to_string(gpu);
+    if (pageNode >= 0 && pageNode != node) {
+      // The allocator did not honor the binding, say where the pages are
+      desc += " (pages on node " + std::to_string(pageNode) + ")";
+    }
+    report(gpu, test, desc, size, numIter_, "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(size) * numIter_));
+
+    HIPCHECK(hipStreamDestroy(stream));
+    HIPCHECK(hipFree(device));
+    freeHost(kind, host, mem);
+  }
+
+ private:
+  // Allocates with the memory policy bound to node and touches every page
+  // before the policy is reset, so first touch places the pages.
+  void* allocHost(HostKind kind, int node, size_t size, void** mem) {
+    unsigned long nodeMask[16] = {0};
+    nodeMask[node / (8 * sizeof(unsigned long))] = 1ul << (node % (8 * sizeof(unsigned long)));
+    if (set_mempolicy(MPOL_BIND, nodeMask, sizeof(nodeMask) * 8) == -1) {
+      failed("set_mempolicy() failed with err %d\n", errno);
+    }
+
+    void* host = nullptr;
+    if (kind == hostPageable || kind == hostRegistered) {
+      if (posix_memalign(mem, pageSize_, size) != 0) {
+        failed("posix_memalign of %zu bytes failed\n", size);
+      }
+      host = *mem;
+      memset(host, 1, size);
+      if (kind == hostRegistered) {
+        HIPCHECK(hipHostRegister(host, size, hipHostRegisterDefault));
+      }
+    } else {
+      HIPCHECK(hipHostMalloc(&host, size, hostMallocFlags[kind]));
+      memset(host, 1, size);
+    }
+
+    if (set_mempolicy(MPOL_DEFAULT, NULL, 0) == -1) {
+      failed("set_mempolicy() failed with err %d\n", errno);
+    }
+    return host;
+  }
+
+  void freeHost(HostKind kind, void* host, void* mem) {
+    if (kind == hostRegistered) {
+      HIPCHECK(hipHostUnregister(host));
+    }
+    if (kind == hostPageable || kind == hostRegistered) {
+      free(mem);
+    } else {
+      HIPCHECK(hipHostFree(host));
+    }
+  }
+
+  // NUMA node of the first page of ptr, -1 if unknown
+  static int nodeOf(void* ptr) {
+    int status = -1;
+    if (move_pages(0, 1, &ptr, NULL, &status, 0) != 0) {
+      return -1;
+    }
+    return status;
+  }
+
+  int numNodes_;
+  int numGpus_;
+  long pageSize_;
+  std::vector<size_t> sizes_;
+  unsigned int numIter_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfHostNumaBandwidth)
@@ -0,0 +1,187 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of zero-copy for a user provided pageable buffer. Per size it reports
+// the hipHostRegister and hipHostUnregister latency and the end to end time of
+// moving the buffer to the device in four ways: register, copy and unregister
+// it; a plain hipMemcpy from pageable memory; memcpy through two pinned bounce
+// chunks overlapped with their async copies; and the copy from a buffer that
+// stays registered, the best case of reusing registrations. Registering pays
+// off from the size where "register+copy" beats the pageable and staged copies.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "perf_harness.h"
+
+static const std::vector<size_t> Sizes = {4096,     65536,     1048576,
+                                          16777216, 67108864, 268435456};
+// Chunk of the staged copy, two of those are double buffered
+static const size_t stagingChunk = 4 * 1024 * 1024;
+
+enum RegisterOp {
+  opRegister = 0,
+  opUnregister,
+  opRegisterCopy,
+  opPageableCopy,
+  opStagedCopy,
+  opRegisteredCopy,
+  numRegisterOps
+};
+
+static const char* registerOpStr[numRegisterOps] = {
+    "hipHostRegister",     "hipHostUnregister", "register+copy+unregister",
+    "pageable hipMemcpy",  "staged copy",       "copy from registered"};
+
+class hipPerfHostRegister : public HipPerf::Benchmark {
+ public:
+  hipPerfHostRegister() : HipPerf::Benchmark("hipPerfHostRegister"),
+      sizes_(HipPerf::sweepSizes(Sizes)), stream_(nullptr), device_(nullptr), host_(nullptr) {
+    bounce_[0] = bounce_[1] = nullptr;
+    copied_[0] = copied_[1] = nullptr;
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    size_t maxSize = *std::max_element(sizes_.begin(), sizes_.end());
+    if (posix_memalign(&host_, 4096, maxSize) != 0) {
+      failed("posix_memalign of %zu bytes failed\n", maxSize);
+    }
+    // Registration of untouched pages would include the page faults
+    memset(host_, 1, maxSize);
+    HIPCHECK(hipMalloc(&device_, maxSize));
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    for (int b = 0; b < 2; b++) {
+      HIPCHECK(hipHostMalloc(&bounce_[b], stagingChunk));
+      HIPCHECK(hipEventCreateWithFlags(&copied_[b], hipEventDisableTiming));
+    }
+  }
+
+  void close() override {
+    for (int b = 0; b < 2; b++) {
+      HIPCHECK(hipEventDestroy(copied_[b]));
+      HIPCHECK(hipHostFree(bounce_[b]));
+    }
+    HIPCHECK(hipStreamDestroy(stream_));
+    HIPCHECK(hipFree(device_));
+    free(host_);
+  }
+
+  unsigned int numTests() override { return numRegisterOps * sizes_.size(); }
+
+  void run(unsigned int test) override {
+    RegisterOp op = static_cast<RegisterOp>(test / sizes_.size());
+    size_t size = sizes_[test % sizes_.size()];
+
+    std::vector<double> sec;
+    switch (op) {
+      case opRegister:
+      case opUnregister: {
+        // Both calls of every pair are timed, the other op's samples are dropped
+        std::vector<double> reg, unreg;
+        measure([&]() {
+          auto start = std::chrono::steady_clock::now();
+          HIPCHECK(hipHostRegister(host_, size, hipHostRegisterDefault));
+          auto registered = std::chrono::steady_clock::now();
+          HIPCHECK(hipHostUnregister(host_));
+          std::chrono::duration<double> regSec = registered - start;
+          std::chrono::duration<double> unregSec = std::chrono::steady_clock::now() - registered;
+          if (!HipPerf::Counters::collecting()) {
+            reg.push_back(regSec.count());
+            unreg.push_back(unregSec.count());
+          }
+        });
+        sec = HipPerf::measuredSamples(op == opRegister ? reg : unreg);
+        report(test, description(op, size), size, 1, "us", HipPerf::toMicroseconds(sec, 1));
+        return;
+      }
+      case opRegisterCopy:
+        sec = measure([&]() {
+          HIPCHECK(hipHostRegister(host_, size, hipHostRegisterDefault));
+          HIPCHECK(hipMemcpyAsync(device_, host_, size, hipMemcpyHostToDevice, stream_));
+          HIPCHECK(hipStreamSynchronize(stream_));
+          HIPCHECK(hipHostUnregister(host_));
+        });
+        break;
+      case opPageableCopy:
+        sec = measure([&]() {
+          HIPCHECK(hipMemcpy(device_, host_, size, hipMemcpyHostToDevice));
+        });
+        break;
+      case opStagedCopy:
+        sec = measure([&]() { stagedCopy(size); });
+        break;
+      default:
+        HIPCHECK(hipHostRegister(host_, size, hipHostRegisterDefault));
+        sec = measure([&]() {
+          HIPCHECK(hipMemcpyAsync(device_, host_, size, hipMemcpyHostToDevice, stream_));
+          HIPCHECK(hipStreamSynchronize(stream_));
+        });
+        HIPCHECK(hipHostUnregister(host_));
+        break;
+    }
+    report(test, description(op, size), size, 1, "us", HipPerf::toMicroseconds(sec, 1));
+    report(test, description(op, size), size, 1, "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(size)));
+  }
+
+ private:
+  static std::string description(RegisterOp op, size_t size) {
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-26s %10zu bytes", registerOpStr[op], size);
+    return desc;
+  }
+
+  // memcpy of each chunk into a bounce buffer while the previous one is copied
+  // to the device; a bounce buffer is refilled only once its copy completed.
+  void stagedCopy(size_t size) {
+    const char* src = static_cast<const char*>(host_);
+    char* dst = static_cast<char*>(device_);
+    for (size_t offset = 0, chunk = 0; offset < size; offset += stagingChunk, chunk++) {
+      size_t bytes = std::min(stagingChunk, size - offset);
+      int b = chunk % 2;
+      if (chunk >= 2) {
+        HIPCHECK(hipEventSynchronize(copied_[b]));
+      }
+      memcpy(bounce_[b], src + offset, bytes);
+      HIPCHECK(hipMemcpyAsync(dst + offset, bounce_[b], bytes, hipMemcpyHostToDevice, stream_));
+      HIPCHECK(hipEventRecord(copied_[b], stream_));
+    }
+    HIPCHECK(hipStreamSynchronize(stream_));
+  }
+
+  std::vector<size_t> sizes_;
+  hipStream_t stream_;
+  void* device_;
+  void* host_;            // pageable source, page aligned
+  void* bounce_[2];       // pinned staging chunks
+  hipEvent_t copied_[2];  // last copy out of bounce_[b] done
+};
+
+HIP_PERF_BENCHMARK(hipPerfHostRegister)
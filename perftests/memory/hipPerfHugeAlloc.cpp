@@ -0,0 +1,230 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Where the time of loading a large model goes. Device allocations from 1 MB
+// up to 90% of the free memory hipMemGetInfo reports at open (--sizes or
+// --sweep replace the default table, the 90% size is always added): the
+// hipMalloc and hipFree latency, and the first kernel that writes one byte
+// per 4 KB of a fresh allocation against the same kernel run again, the
+// difference per 4 KB being the first touch cost. Host allocations of 1 to
+// 64 GB, skipped beyond 40% of physical memory: hipHostMalloc and
+// hipHostFree latency with the pinning rate in GB/s, and hipHostRegister and
+// hipHostUnregister of a touched pageable buffer of the same size. Sizes of
+// 1 GB and more run without warm-up, a repetition there can take seconds.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const size_t MB = 1024 * 1024;
+static const size_t GB = 1024 * MB;
+
+static const std::vector<size_t> deviceSizes = {1 * MB, 16 * MB, 256 * MB, 1 * GB,
+                                                4 * GB, 16 * GB, 64 * GB};
+static const std::vector<size_t> hostSizes = {1 * GB, 4 * GB, 16 * GB, 32 * GB, 64 * GB};
+
+enum HugeOp { opMallocFree = 0, opFirstTouch, opHostMallocFree, opHostRegister, numHugeOps };
+
+static const size_t touchStride = 4096;
+static const double deviceFreeFraction = 0.9;
+static const double hostMemFraction = 0.4;
+
+__global__ void _touchKernel(char* ptr, size_t pages) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < pages; i += gridDim.x * blockDim.x) {
+    ptr[i * touchStride] = 1;
+  }
+}
+
+class hipPerfHugeAlloc : public HipPerf::Benchmark {
+ public:
+  hipPerfHugeAlloc() : HipPerf::Benchmark("hipPerfHugeAlloc"),
+      deviceSizes_(HipPerf::sweepSizes(deviceSizes)), hostSizes_(HipPerf::sweepSizes(hostSizes)),
+      stream_(nullptr), hostMem_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    size_t freeMem = 0, totalMem = 0;
+    HIPCHECK(hipMemGetInfo(&freeMem, &totalMem));
+    // Rounded down to 2 MB, the granularity of large device allocations
+    size_t nearFree = static_cast<size_t>(freeMem * deviceFreeFraction) / (2 * MB) * (2 * MB);
+    deviceSizes_.erase(std::remove_if(deviceSizes_.begin(), deviceSizes_.end(),
+                                      [&](size_t s) { return s >= nearFree; }),
+                       deviceSizes_.end());
+    deviceSizes_.push_back(nearFree);
+    hostMem_ = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGE_SIZE);
+  }
+
+  void close() override { HIPCHECK(hipStreamDestroy(stream_)); }
+
+  unsigned int numTests() override {
+    return numHugeOps * static_cast<unsigned int>(std::max(deviceSizes_.size(), hostSizes_.size()));
+  }
+
+  void run(unsigned int test) override {
+    HugeOp op = static_cast<HugeOp>(test % numHugeOps);
+    size_t index = test / numHugeOps;
+    bool host = op == opHostMallocFree || op == opHostRegister;
+    const std::vector<size_t>& sizes = host ? hostSizes_ : deviceSizes_;
+    if (index >= sizes.size()) {
+      return;
+    }
+    size_t size = sizes[index];
+    if (host && size > hostMem_ * hostMemFraction) {
+      printf("info: %zu MB exceeds %.0f%% of host memory, skipping\n", size / MB,
+             hostMemFraction * 100);
+      return;
+    }
+    unsigned int warmup = size >= GB ? 0 : p_warmup;
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%8zu MB ", size / MB);
+    std::string prefix(desc);
+    std::vector<double> first, second;
+    switch (op) {
+      case opMallocFree:
+        timePair(size, warmup, first, second, [](void** p, size_t s) { HIPCHECK(hipMalloc(p, s)); },
+                 [](void* p) { HIPCHECK(hipFree(p)); });
+        report(test, prefix + "hipMalloc", size, 1, "us", HipPerf::toMicroseconds(first, 1));
+        report(test, prefix + "hipFree", size, 1, "us", HipPerf::toMicroseconds(second, 1));
+        break;
+      case opFirstTouch: {
+        firstTouch(size, warmup, first, second);
+        report(test, prefix + "first touch", size, 1, "us", HipPerf::toMicroseconds(first, 1));
+        report(test, prefix + "second touch", size, 1, "us", HipPerf::toMicroseconds(second, 1));
+        std::vector<double> perPage;
+        for (size_t i = 0; i < first.size(); i++) {
+          perPage.push_back((first[i] - second[i]) * 1e9 / (size / touchStride));
+        }
+        report(test, prefix + "first touch cost per 4 KB", size, 1, "ns", perPage);
+        break;
+      }
+      case opHostMallocFree:
+        timePair(size, warmup, first, second,
+                 [](void** p, size_t s) { HIPCHECK(hipHostMalloc(p, s)); },
+                 [](void* p) { HIPCHECK(hipHostFree(p)); });
+        report(test, prefix + "hipHostMalloc", size, 1, "us", HipPerf::toMicroseconds(first, 1));
+        report(test, prefix + "hipHostMalloc", size, 1, "GB/s",
+               HipPerf::toBandwidth(first, static_cast<double>(size)));
+        report(test, prefix + "hipHostFree", size, 1, "us", HipPerf::toMicroseconds(second, 1));
+        break;
+      default:
+        if (!hostRegister(size, warmup, first, second)) {
+          return;
+        }
+        report(test, prefix + "hipHostRegister", size, 1, "us",
+               HipPerf::toMicroseconds(first, 1));
+        report(test, prefix + "hipHostRegister", size, 1, "GB/s",
+               HipPerf::toBandwidth(first, static_cast<double>(size)));
+        report(test, prefix + "hipHostUnregister", size, 1, "us",
+               HipPerf::toMicroseconds(second, 1));
+        break;
+    }
+  }
+
+ private:
+  // Times an allocation and its release in every repetition
+  template <typename Alloc, typename Release>
+  void timePair(size_t size, unsigned int warmup, std::vector<double>& allocSec,
+                std::vector<double>& releaseSec, Alloc alloc, Release release) {
+    for (unsigned int r = 0; r < warmup + p_repetitions; r++) {
+      void* ptr = nullptr;
+      auto start = std::chrono::steady_clock::now();
+      alloc(&ptr, size);
+      double allocated = HipTest::secondsSince(start);
+      start = std::chrono::steady_clock::now();
+      release(ptr);
+      double released = HipTest::secondsSince(start);
+      if (r >= warmup) {
+        allocSec.push_back(allocated);
+        releaseSec.push_back(released);
+      }
+    }
+  }
+
+  // Every repetition touches a fresh allocation twice
+  void firstTouch(size_t size, unsigned int warmup, std::vector<double>& firstSec,
+                  std::vector<double>& secondSec) {
+    size_t pages = size / touchStride;
+    dim3 grid(props_.multiProcessorCount * 8);
+    for (unsigned int r = 0; r < warmup + p_repetitions; r++) {
+      char* ptr = nullptr;
+      HIPCHECK(hipMalloc(&ptr, size));
+      double touch[2];
+      for (int t = 0; t < 2; t++) {
+        auto start = std::chrono::steady_clock::now();
+        hipLaunchKernelGGL(_touchKernel, grid, dim3(256), 0, stream_, ptr, pages);
+        HIPCHECK(hipGetLastError());
+        HIPCHECK(hipStreamSynchronize(stream_));
+        touch[t] = HipTest::secondsSince(start);
+      }
+      HIPCHECK(hipFree(ptr));
+      if (r >= warmup) {
+        firstSec.push_back(touch[0]);
+        secondSec.push_back(touch[1]);
+      }
+    }
+  }
+
+  // Pages are touched before the registration, which would otherwise include the faults
+  bool hostRegister(size_t size, unsigned int warmup, std::vector<double>& registerSec,
+                    std::vector<double>& unregisterSec) {
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, 4096, size) != 0) {
+      printf("info: posix_memalign of %zu MB failed, skipping\n", size / MB);
+      return false;
+    }
+    memset(buffer, 1, size);
+    for (unsigned int r = 0; r < warmup + p_repetitions; r++) {
+      auto start = std::chrono::steady_clock::now();
+      HIPCHECK(hipHostRegister(buffer, size, hipHostRegisterDefault));
+      double registered = HipTest::secondsSince(start);
+      start = std::chrono::steady_clock::now();
+      HIPCHECK(hipHostUnregister(buffer));
+      double unregistered = HipTest::secondsSince(start);
+      if (r >= warmup) {
+        registerSec.push_back(registered);
+        unregisterSec.push_back(unregistered);
+      }
+    }
+    free(buffer);
+    return true;
+  }
+
+  std::vector<size_t> deviceSizes_;
+  std::vector<size_t> hostSizes_;
+  hipStream_t stream_;
+  size_t hostMem_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfHugeAlloc)
@@ -0,0 +1,324 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of sharing device memory and events between processes. The process
+// forks before HIP is initialized; the parent is the producer, allocating
+// buffers and exporting IPC handles, the child is the consumer. For each
+// buffer size, on the producer's device and on a peer device, the consumer
+// opens the handle, copies the whole buffer into local memory once (the copy
+// includes the mapping work deferred to first use), then copies it again in
+// steady state and closes the handle, for several open/close cycles. The
+// event test bounces two hipEventInterprocess events between the processes:
+// the producer records its event, the consumer waits for it on a stream and
+// records its own, which the producer waits for in turn. Each round trip is
+// reported next to the same handshake over the semaphores alone. The parent
+// collects everything the child measured through shared memory and writes
+// the results.
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum IpcCommand { cmdMemory, cmdEvent, cmdQuit };
+
+enum MemSample { sampleOpen, sampleFirstCopy, sampleSteadyCopy, sampleClose, numMemSamples };
+
+static const size_t ipcSizes[] = {1 << 20, 64 << 20, 256 << 20};
+static const unsigned int numIpcSizes = sizeof(ipcSizes) / sizeof(ipcSizes[0]);
+// Open/close cycles per size, steady state copies per cycle
+static const unsigned int openCycles = 10;
+static const unsigned int steadyCopies = 10;
+static const unsigned int eventRoundTrips = 1000;
+// Seconds the producer waits for the consumer before giving up
+static const int consumerTimeout = 120;
+
+struct IpcShared {
+  sem_t toConsumer;
+  sem_t toProducer;
+  IpcCommand command;
+  int device;  // device the consumer runs on
+  size_t bytes;
+  hipIpcMemHandle_t memHandle;
+  hipIpcEventHandle_t producerEvent;
+  hipIpcEventHandle_t consumerEvent;
+  bool useEvents;  // event round trips or semaphores alone
+  double samples[numMemSamples][openCycles];
+};
+
+static double elapsedUs(std::chrono::steady_clock::time_point start,
+                        std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Waits for the consumer, which aborts on any HIP error
+static void waitConsumer(IpcShared* shared) {
+  timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += consumerTimeout;
+  while (sem_timedwait(&shared->toProducer, &deadline) != 0) {
+    if (errno != EINTR) {
+      failed("consumer process did not respond");
+    }
+  }
+}
+
+static void consumeMemory(IpcShared* shared) {
+  HIPCHECK(hipSetDevice(shared->device));
+  hipStream_t stream;
+  HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+  void* local = nullptr;
+  HIPCHECK(hipMalloc(&local, shared->bytes));
+
+  for (unsigned int c = 0; c < openCycles; c++) {
+    void* remote = nullptr;
+    auto start = std::chrono::steady_clock::now();
+    HIPCHECK(hipIpcOpenMemHandle(&remote, shared->memHandle, hipIpcMemLazyEnablePeerAccess));
+    auto opened = std::chrono::steady_clock::now();
+    HIPCHECK(hipMemcpyAsync(local, remote, shared->bytes, hipMemcpyDeviceToDevice, stream));
+    HIPCHECK(hipStreamSynchronize(stream));
+    auto firstCopy = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < steadyCopies; i++) {
+      HIPCHECK(hipMemcpyAsync(local, remote, shared->bytes, hipMemcpyDeviceToDevice, stream));
+    }
+    HIPCHECK(hipStreamSynchronize(stream));
+    auto steady = std::chrono::steady_clock::now();
+    HIPCHECK(hipIpcCloseMemHandle(remote));
+    auto closed = std::chrono::steady_clock::now();
+
+    shared->samples[sampleOpen][c] = elapsedUs(start, opened);
+    shared->samples[sampleFirstCopy][c] = elapsedUs(opened, firstCopy) / 1000;
+    shared->samples[sampleSteadyCopy][c] =
+        static_cast<double>(shared->bytes) * steadyCopies / (elapsedUs(firstCopy, steady) * 1000);
+    shared->samples[sampleClose][c] = elapsedUs(steady, closed);
+  }
+
+  HIPCHECK(hipFree(local));
+  HIPCHECK(hipStreamDestroy(stream));
+}
+
+static void consumeEvents(IpcShared* shared) {
+  HIPCHECK(hipSetDevice(shared->device));
+  hipStream_t stream;
+  HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+  hipEvent_t producerEvent = nullptr;
+  hipEvent_t consumerEvent = nullptr;
+  if (shared->useEvents) {
+    HIPCHECK(hipIpcOpenEventHandle(&producerEvent, shared->producerEvent));
+    HIPCHECK(hipEventCreateWithFlags(&consumerEvent,
+                                     hipEventInterprocess | hipEventDisableTiming));
+    HIPCHECK(hipIpcGetEventHandle(&shared->consumerEvent, consumerEvent));
+  }
+  sem_post(&shared->toProducer);
+
+  for (unsigned int i = 0; i < eventRoundTrips; i++) {
+    sem_wait(&shared->toConsumer);
+    if (shared->useEvents) {
+      HIPCHECK(hipStreamWaitEvent(stream, producerEvent, 0));
+      HIPCHECK(hipEventRecord(consumerEvent, stream));
+    }
+    sem_post(&shared->toProducer);
+  }
+
+  if (shared->useEvents) {
+    HIPCHECK(hipStreamSynchronize(stream));
+    HIPCHECK(hipEventDestroy(producerEvent));
+    HIPCHECK(hipEventDestroy(consumerEvent));
+  }
+  HIPCHECK(hipStreamDestroy(stream));
+}
+
+static void runConsumer(IpcShared* shared) {
+  for (;;) {
+    sem_wait(&shared->toConsumer);
+    switch (shared->command) {
+      case cmdMemory:
+        consumeMemory(shared);
+        break;
+      case cmdEvent:
+        consumeEvents(shared);
+        break;
+      default:
+        return;
+    }
+    sem_post(&shared->toProducer);
+  }
+}
+
+static void produceMemory(IpcShared* shared, unsigned int test, int device, size_t bytes) {
+  void* buffer = nullptr;
+  HIPCHECK(hipSetDevice(p_gpuDevice));
+  HIPCHECK(hipMalloc(&buffer, bytes));
+  HIPCHECK(hipMemset(buffer, 0x5a, bytes));
+  HIPCHECK(hipDeviceSynchronize());
+  HIPCHECK(hipIpcGetMemHandle(&shared->memHandle, buffer));
+  shared->command = cmdMemory;
+  shared->device = device;
+  shared->bytes = bytes;
+  sem_post(&shared->toConsumer);
+  waitConsumer(shared);
+  HIPCHECK(hipFree(buffer));
+
+  static const char* sampleStr[] = {"open", "first copy", "steady copy", "close"};
+  static const char* sampleUnit[] = {"us", "ms", "GB/s", "us"};
+  for (unsigned int s = 0; s < numMemSamples; s++) {
+    HipPerf::Result result;
+    result.benchmark = "hipPerfIpcMemory";
+    result.test = test;
+    result.desc = std::to_string(bytes >> 20) + " MB " +
+                  (device == p_gpuDevice ? "same device " : "peer device ") + sampleStr[s];
+    result.device = device;
+    result.bytes = bytes;
+    result.iterations = s == sampleSteadyCopy ? steadyCopies : 1;
+    result.unit = sampleUnit[s];
+    result.values.assign(shared->samples[s], shared->samples[s] + openCycles);
+    HipPerf::writeResult(result);
+  }
+}
+
+static void produceEvents(IpcShared* shared, unsigned int test, bool useEvents) {
+  HIPCHECK(hipSetDevice(p_gpuDevice));
+  hipStream_t stream;
+  HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+  hipEvent_t producerEvent = nullptr;
+  hipEvent_t consumerEvent = nullptr;
+  if (useEvents) {
+    HIPCHECK(hipEventCreateWithFlags(&producerEvent,
+                                     hipEventInterprocess | hipEventDisableTiming));
+    HIPCHECK(hipIpcGetEventHandle(&shared->producerEvent, producerEvent));
+  }
+  shared->command = cmdEvent;
+  shared->device = p_gpuDevice;
+  shared->useEvents = useEvents;
+  sem_post(&shared->toConsumer);
+  waitConsumer(shared);
+  if (useEvents) {
+    HIPCHECK(hipIpcOpenEventHandle(&consumerEvent, shared->consumerEvent));
+  }
+
+  std::vector<double> us;
+  for (unsigned int i = 0; i < eventRoundTrips; i++) {
+    auto start = std::chrono::steady_clock::now();
+    if (useEvents) {
+      HIPCHECK(hipEventRecord(producerEvent, stream));
+    }
+    sem_post(&shared->toConsumer);
+    waitConsumer(shared);
+    if (useEvents) {
+      HIPCHECK(hipStreamWaitEvent(stream, consumerEvent, 0));
+      HIPCHECK(hipStreamSynchronize(stream));
+    }
+    us.push_back(elapsedUs(start, std::chrono::steady_clock::now()));
+  }
+  // Completion of the consumer's command
+  waitConsumer(shared);
+
+  if (useEvents) {
+    HIPCHECK(hipEventDestroy(producerEvent));
+    HIPCHECK(hipEventDestroy(consumerEvent));
+  }
+  HIPCHECK(hipStreamDestroy(stream));
+
+  HipPerf::Result result;
+  result.benchmark = "hipPerfIpcMemory";
+  result.test = test;
+  result.desc = useEvents ? "event round trip" : "semaphore round trip";
+  result.device = p_gpuDevice;
+  result.bytes = 0;
+  result.iterations = eventRoundTrips;
+  result.unit = "us";
+  result.values = us;
+  HipPerf::writeResult(result);
+}
+
+int main(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
+
+  IpcShared* shared = reinterpret_cast<IpcShared*>(mmap(
+      nullptr, sizeof(IpcShared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+  if (shared == MAP_FAILED) {
+    failed("mmap of the shared control block failed");
+  }
+  if (sem_init(&shared->toConsumer, 1, 0) != 0 || sem_init(&shared->toProducer, 1, 0) != 0) {
+    failed("sem_init failed");
+  }
+
+  // HIP must not be initialized before the fork
+  pid_t pid = fork();
+  if (pid < 0) {
+    failed("fork failed");
+  }
+  if (pid == 0) {
+    runConsumer(shared);
+    exit(0);
+  }
+
+  int numDevices = 0;
+  HIPCHECK(hipGetDeviceCount(&numDevices));
+  int peer = -1;
+  if (numDevices > 1) {
+    int candidate = (p_gpuDevice + 1) % numDevices;
+    int canAccess = 0;
+    HIPCHECK(hipDeviceCanAccessPeer(&canAccess, candidate, p_gpuDevice));
+    if (canAccess) {
+      peer = candidate;
+    }
+  }
+  if (peer < 0) {
+    printf("info: no peer device of device %d, skipping the peer tests\n", p_gpuDevice);
+  }
+
+  unsigned int test = 0;
+  for (unsigned int s = 0; s < numIpcSizes; s++) {
+    produceMemory(shared, test++, p_gpuDevice, ipcSizes[s]);
+    if (peer >= 0) {
+      produceMemory(shared, test, peer, ipcSizes[s]);
+    }
+    test++;
+  }
+  produceEvents(shared, test++, false);
+  produceEvents(shared, test++, true);
+
+  shared->command = cmdQuit;
+  sem_post(&shared->toConsumer);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  sem_destroy(&shared->toConsumer);
+  sem_destroy(&shared->toProducer);
+  munmap(shared, sizeof(IpcShared));
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    failed("consumer process failed");
+  }
+  passed();
+}
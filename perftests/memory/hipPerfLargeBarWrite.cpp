@@ -0,0 +1,229 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Host threads storing directly into device memory through a large BAR,
+// against hipMemcpy from pinned memory. Per update size the CPU writes with
+// scalar 8 byte stores, 16 byte SSE2 stores and 16 byte non-temporal stores
+// (followed by sfence), from 1..hardware_concurrency threads that split the
+// update. Reports us per update and GB/s; the size where hipMemcpy overtakes
+// direct stores is the crossover for small parameter and control block
+// updates. Splits smaller than 4 KB per thread are not measured. Without a
+// large BAR, or on non-x86 hosts for the SIMD variants, the CPU tests are
+// skipped.
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define HAVE_SSE2_STORES 1
+#else
+#define HAVE_SSE2_STORES 0
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "perf_harness.h"
+
+static const std::vector<size_t> Sizes = {64,      256,      4096,     65536,
+                                          1048576, 16777216, 67108864};
+// Updates per repetition move at least this many bytes, at most maxUpdates
+static const size_t bytesPerRepetition = 64 * 1024 * 1024;
+static const size_t maxUpdates = 10000;
+static const size_t minBytesPerThread = 4096;
+static const uint64_t pattern = 0x0123456789abcdefull;
+
+enum WriteMethod { methodScalar = 0, methodSimd, methodNonTemporal, methodMemcpy, numMethods };
+
+static const char* methodStr[numMethods] = {"scalar stores", "SSE2 stores",
+                                            "non-temporal stores", "hipMemcpy pinned H2D"};
+
+// Writes [begin, end) of dst, 8 byte words. simd and non-temporal need 16 byte alignment.
+static void storeWords(WriteMethod method, uint64_t* dst, size_t begin, size_t end) {
+#if HAVE_SSE2_STORES
+  if (method != methodScalar) {
+    __m128i value = _mm_set1_epi64x(static_cast<long long>(pattern));
+    for (size_t i = begin; i < end; i += 2) {
+      __m128i* p = reinterpret_cast<__m128i*>(dst + i);
+      if (method == methodNonTemporal) {
+        _mm_stream_si128(p, value);
+      } else {
+        _mm_store_si128(p, value);
+      }
+    }
+    _mm_sfence();
+    return;
+  }
+#endif
+  volatile uint64_t* p = dst;
+  for (size_t i = begin; i < end; i++) {
+    p[i] = pattern;
+  }
+}
+
+class hipPerfLargeBarWrite : public HipPerf::Benchmark {
+ public:
+  hipPerfLargeBarWrite() : HipPerf::Benchmark("hipPerfLargeBarWrite"),
+      sizes_(HipPerf::sweepSizes(Sizes)), device_(nullptr), pinned_(nullptr), stream_(nullptr) {
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int t = 1; t < maxThreads; t *= 2) {
+      threadCounts_.push_back(t);
+    }
+    threadCounts_.push_back(maxThreads);
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    // 16 byte multiples keep the SIMD loops free of tails
+    for (auto& size : sizes_) {
+      size = std::max<size_t>(16, size & ~static_cast<size_t>(15));
+    }
+    size_t maxSize = *std::max_element(sizes_.begin(), sizes_.end());
+    HIPCHECK(hipMalloc(&device_, maxSize));
+    HIPCHECK(hipHostMalloc(&pinned_, maxSize));
+    for (size_t i = 0; i < maxSize / sizeof(uint64_t); i++) {
+      static_cast<uint64_t*>(pinned_)[i] = pattern;
+    }
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    if (!props_.isLargeBar) {
+      printf("info: device %d has no large BAR, only hipMemcpy is measured\n", deviceId);
+    }
+  }
+
+  void close() override {
+    HIPCHECK(hipStreamDestroy(stream_));
+    HIPCHECK(hipHostFree(pinned_));
+    HIPCHECK(hipFree(device_));
+  }
+
+  unsigned int numTests() override { return sizes_.size() * numMethods * threadCounts_.size(); }
+
+  void run(unsigned int test) override {
+    unsigned int numThreads = threadCounts_[test % threadCounts_.size()];
+    WriteMethod method = static_cast<WriteMethod>((test / threadCounts_.size()) % numMethods);
+    size_t size = sizes_[test / (threadCounts_.size() * numMethods)];
+    if (method == methodMemcpy ? numThreads != 1
+                               : !props_.isLargeBar ||
+                                     (numThreads > 1 && size / numThreads < minBytesPerThread)) {
+      return;
+    }
+    if (!HAVE_SSE2_STORES && (method == methodSimd || method == methodNonTemporal)) {
+      return;
+    }
+    size_t updates = std::min(maxUpdates, std::max<size_t>(1, bytesPerRepetition / size));
+
+    HIPCHECK(hipMemset(device_, 0, size));
+    std::vector<double> sec;
+    if (method == methodMemcpy) {
+      sec = measure([&]() {
+        for (size_t u = 0; u < updates; u++) {
+          HIPCHECK(hipMemcpyAsync(device_, pinned_, size, hipMemcpyHostToDevice, stream_));
+          HIPCHECK(hipStreamSynchronize(stream_));
+        }
+      });
+    } else if (numThreads == 1) {
+      uint64_t* dst = static_cast<uint64_t*>(device_);
+      sec = measure([&]() {
+        for (size_t u = 0; u < updates; u++) {
+          storeWords(method, dst, 0, size / sizeof(uint64_t));
+        }
+      });
+    } else {
+      sec = threadedStores(method, numThreads, size, updates);
+    }
+    checkWritten(size);
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-20s %3u threads %9zu bytes", methodStr[method], numThreads,
+             size);
+    report(test, desc, size, updates, "us", HipPerf::toMicroseconds(sec, updates));
+    report(test, desc, size, updates, "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(size) * updates));
+  }
+
+ private:
+  // Every thread writes its 16 byte aligned slice of each update, the threads
+  // start together and the time runs until the last one finished.
+  std::vector<double> threadedStores(WriteMethod method, unsigned int numThreads, size_t size,
+                                     size_t updates) {
+    uint64_t* dst = static_cast<uint64_t*>(device_);
+    size_t words = size / sizeof(uint64_t);
+    size_t slice = (words / numThreads) & ~static_cast<size_t>(1);
+    std::vector<double> sec;
+    measure([&]() {
+      std::atomic<unsigned int> ready(0);
+      std::atomic<bool> go(false);
+      std::vector<std::thread> threads;
+      for (unsigned int t = 0; t < numThreads; t++) {
+        size_t begin = t * slice;
+        size_t end = t + 1 == numThreads ? words : begin + slice;
+        threads.emplace_back([&, begin, end]() {
+          ready++;
+          while (!go.load(std::memory_order_acquire)) {
+          }
+          for (size_t u = 0; u < updates; u++) {
+            storeWords(method, dst, begin, end);
+          }
+        });
+      }
+      // Thread creation is not part of the store time
+      while (ready.load() != numThreads) {
+      }
+      auto start = std::chrono::steady_clock::now();
+      go.store(true, std::memory_order_release);
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      if (!HipPerf::Counters::collecting()) {
+        sec.push_back(elapsed.count());
+      }
+    });
+    return HipPerf::measuredSamples(sec);
+  }
+
+  void checkWritten(size_t size) {
+    std::vector<uint64_t> host(size / sizeof(uint64_t));
+    HIPCHECK(hipMemcpy(host.data(), device_, size, hipMemcpyDeviceToHost));
+    for (size_t i = 0; i < host.size(); i++) {
+      if (host[i] != pattern) {
+        failed("Validation failed at word %zu: got 0x%016llx", i,
+               static_cast<unsigned long long>(host[i]));
+      }
+    }
+  }
+
+  std::vector<size_t> sizes_;
+  std::vector<unsigned int> threadCounts_;
+  void* device_;
+  void* pinned_;  // source of the hipMemcpy updates
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfLargeBarWrite)
@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Allocation churn: --iterations allocate/free pairs per thread through
+// hipMalloc/hipFree, hipMallocAsync/hipFreeAsync from the device default pool,
+// hipMallocFromPoolAsync from a pool whose hipMemPoolAttrReleaseThreshold
+// keeps freed memory cached, and a graph holding one alloc and one free node.
+// Threads use their own stream. Reports microseconds per pair and aggregate
+// pairs per second.
+
+#include <stdio.h>
+
+#include <cstdint>
+#include <thread>
+
+#include "perf_harness.h"
+
+static const std::vector<size_t> Sizes = {4096, 65536, 1048576, 16777216, 67108864};
+static const unsigned int threadCounts[] = {1, 4, 8};
+static const unsigned int numThreadCounts = sizeof(threadCounts) / sizeof(threadCounts[0]);
+
+enum Allocator { allocSync = 0, allocAsyncDefault, allocAsyncPool, allocGraph, numAllocators };
+
+static const char* allocatorStr[numAllocators] = {"hipMalloc", "hipMallocAsync default pool",
+                                                  "hipMallocFromPoolAsync cached pool",
+                                                  "graph mem nodes"};
+
+class hipPerfMallocAsync : public HipPerf::Benchmark {
+ public:
+  hipPerfMallocAsync() : HipPerf::Benchmark("hipPerfMallocAsync"),
+      sizes_(HipPerf::sweepSizes(Sizes)), pairs_(HipPerf::iterationCount(1000)),
+      supported_(0), pool_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&supported_, hipDeviceAttributeMemoryPoolsSupported,
+                                   deviceId));
+    streams_.resize(threadCounts[numThreadCounts - 1]);
+    for (auto& stream : streams_) {
+      HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+    }
+    if (supported_) {
+      hipMemPoolProps props = {};
+      props.allocType = hipMemAllocationTypePinned;
+      props.location.type = hipMemLocationTypeDevice;
+      props.location.id = deviceId;
+      HIPCHECK(hipMemPoolCreate(&pool_, &props));
+      uint64_t threshold = UINT64_MAX;
+      HIPCHECK(hipMemPoolSetAttribute(pool_, hipMemPoolAttrReleaseThreshold, &threshold));
+    }
+  }
+
+  void close() override {
+    for (auto& stream : streams_) {
+      HIPCHECK(hipStreamDestroy(stream));
+    }
+    if (pool_ != nullptr) {
+      HIPCHECK(hipMemPoolDestroy(pool_));
+    }
+  }
+
+  unsigned int numTests() override { return sizes_.size() * numAllocators * numThreadCounts; }
+
+  void run(unsigned int test) override {
+    size_t size = sizes_[test % sizes_.size()];
+    Allocator allocator = static_cast<Allocator>((test / sizes_.size()) % numAllocators);
+    unsigned int numThreads = threadCounts[test / (sizes_.size() * numAllocators)];
+    if (allocator != allocSync && !supported_) {
+      printf("info: device %d has no memory pool support, skipping %s\n", deviceId_,
+             allocatorStr[allocator]);
+      return;
+    }
+
+    // One alloc/free graph per thread, built outside the timed region
+    std::vector<hipGraph_t> graphs(numThreads, nullptr);
+    std::vector<hipGraphExec_t> execs(numThreads, nullptr);
+    if (allocator == allocGraph) {
+      for (unsigned int t = 0; t < numThreads; t++) {
+        buildGraph(size, &graphs[t], &execs[t]);
+      }
+    }
+
+    auto sec = measure([&]() {
+      if (numThreads == 1) {
+        churn(allocator, size, streams_[0], execs[0]);
+        return;
+      }
+      std::vector<std::thread> threads;
+      for (unsigned int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&, t]() {
+          HIPCHECK(hipSetDevice(deviceId_));
+          churn(allocator, size, streams_[t], execs[t]);
+        });
+      }
+      for (auto& thread : threads) {
+        thread.join();
+      }
+    });
+
+    for (unsigned int t = 0; t < numThreads; t++) {
+      if (execs[t] != nullptr) {
+        HIPCHECK(hipGraphExecDestroy(execs[t]));
+        HIPCHECK(hipGraphDestroy(graphs[t]));
+      }
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %u threads", allocatorStr[allocator], numThreads);
+    report(test, desc, size, pairs_, "us/pair", HipPerf::toMicroseconds(sec, pairs_));
+    std::vector<double> rate;
+    for (double s : sec) {
+      rate.push_back(static_cast<double>(pairs_) * numThreads / s);
+    }
+    report(test, desc, size, pairs_, "pairs/s", rate);
+  }
+
+ private:
+  // pairs_ allocate/free pairs, synchronized at the end for the async paths.
+  void churn(Allocator allocator, size_t size, hipStream_t stream, hipGraphExec_t exec) {
+    for (unsigned int i = 0; i < pairs_; i++) {
+      void* ptr = nullptr;
+      switch (allocator) {
+        case allocSync:
+          HIPCHECK(hipMalloc(&ptr, size));
+          HIPCHECK(hipFree(ptr));
+          break;
+        case allocAsyncDefault:
+          HIPCHECK(hipMallocAsync(&ptr, size, stream));
+          HIPCHECK(hipFreeAsync(ptr, stream));
+          break;
+        case allocAsyncPool:
+          HIPCHECK(hipMallocFromPoolAsync(&ptr, size, pool_, stream));
+          HIPCHECK(hipFreeAsync(ptr, stream));
+          break;
+        default:
+          HIPCHECK(hipGraphLaunch(exec, stream));
+          break;
+      }
+    }
+    HIPCHECK(hipStreamSynchronize(stream));
+  }
+
+  void buildGraph(size_t size, hipGraph_t* graph, hipGraphExec_t* exec) {
+    HIPCHECK(hipGraphCreate(graph, 0));
+    hipMemAllocNodeParams params = {};
+    params.poolProps.allocType = hipMemAllocationTypePinned;
+    params.poolProps.location.type = hipMemLocationTypeDevice;
+    params.poolProps.location.id = deviceId_;
+    params.bytesize = size;
+    hipGraphNode_t allocNode, freeNode;
+    HIPCHECK(hipGraphAddMemAllocNode(&allocNode, *graph, nullptr, 0, &params));
+    HIPCHECK(hipGraphAddMemFreeNode(&freeNode, *graph, &allocNode, 1, params.dptr));
+    HIPCHECK(hipGraphInstantiate(exec, *graph, nullptr, nullptr, 0));
+  }
+
+  std::vector<size_t> sizes_;
+  unsigned int pairs_;  // per thread and repetition
+  int supported_;
+  hipMemPool_t pool_;   // cached: release threshold UINT64_MAX
+  std::vector<hipStream_t> streams_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfMallocAsync)
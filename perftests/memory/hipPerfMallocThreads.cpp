@@ -0,0 +1,184 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Allocation throughput and latency with 1 to N host threads allocating at
+// the same time. Every thread keeps a window of live allocations of mixed
+// sizes (256 bytes to 4 MB, each thread starting at a different size); each
+// step frees the oldest and allocates a new one, with hipMalloc/hipFree,
+// hipHostMalloc/hipHostFree or hipMallocManaged/hipFree. All threads are
+// released together; reported are the calls per second of all threads
+// together and the latency of every single allocate and free call, whose
+// percentiles show when the runtime serializes the callers. Thread counts
+// double up to the number of host cores (at most 64).
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum Allocator { allocDevice, allocHost, allocManaged, numAllocators };
+static const char* allocatorStr[] = {"hipMalloc", "hipHostMalloc", "hipMallocManaged"};
+static const char* freeStr[] = {"hipFree", "hipHostFree", "hipFree"};
+
+static const size_t mixedSizes[] = {256, 4 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024,
+                                    4 * 1024 * 1024};
+static const unsigned int numMixedSizes = sizeof(mixedSizes) / sizeof(mixedSizes[0]);
+
+static const unsigned int liveAllocations = 4;
+static const unsigned int stepsPerThread = 200;
+static const unsigned int maxThreads = 64;
+
+static void allocate(Allocator allocator, void** ptr, size_t size) {
+  switch (allocator) {
+    case allocDevice:
+      HIPCHECK(hipMalloc(ptr, size));
+      break;
+    case allocHost:
+      HIPCHECK(hipHostMalloc(ptr, size));
+      break;
+    default:
+      HIPCHECK(hipMallocManaged(ptr, size));
+      break;
+  }
+}
+
+static void release(Allocator allocator, void* ptr) {
+  if (allocator == allocHost) {
+    HIPCHECK(hipHostFree(ptr));
+  } else {
+    HIPCHECK(hipFree(ptr));
+  }
+}
+
+class hipPerfMallocThreads : public HipPerf::Benchmark {
+ public:
+  hipPerfMallocThreads() : HipPerf::Benchmark("hipPerfMallocThreads"),
+      steps_(HipPerf::iterationCount(stepsPerThread)), managed_(false) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    unsigned int cores = std::max(1u, std::min(std::thread::hardware_concurrency(), maxThreads));
+    for (unsigned int t = 1; t <= cores; t *= 2) {
+      threadCounts_.push_back(t);
+    }
+    if (threadCounts_.back() != cores) {
+      threadCounts_.push_back(cores);
+    }
+    int managed = 0;
+    HIPCHECK(hipDeviceGetAttribute(&managed, hipDeviceAttributeManagedMemory, deviceId_));
+    managed_ = managed != 0;
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(threadCounts_.size()) * numAllocators;
+  }
+
+  void run(unsigned int test) override {
+    Allocator allocator = static_cast<Allocator>(test % numAllocators);
+    unsigned int threads = threadCounts_[test / numAllocators];
+    if (allocator == allocManaged && !managed_) {
+      printf("info: managed memory not supported, skipping %s\n", allocatorStr[allocator]);
+      return;
+    }
+
+    std::vector<double> callsPerSec;
+    std::vector<double> allocUs;
+    std::vector<double> freeUs;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      std::vector<std::vector<double>> threadAllocUs(threads);
+      std::vector<std::vector<double>> threadFreeUs(threads);
+      std::atomic<unsigned int> ready(0);
+      std::atomic<bool> go(false);
+      std::vector<std::thread> workers;
+      for (unsigned int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+          HIPCHECK(hipSetDevice(deviceId_));
+          threadAllocUs[t].reserve(steps_);
+          threadFreeUs[t].reserve(steps_);
+          void* live[liveAllocations] = {};
+          unsigned int next = t;
+          for (unsigned int i = 0; i < liveAllocations; i++) {
+            allocate(allocator, &live[i], mixedSizes[next++ % numMixedSizes]);
+          }
+          ready++;
+          while (!go.load()) {
+          }
+          for (unsigned int s = 0; s < steps_; s++) {
+            unsigned int slot = s % liveAllocations;
+            auto start = std::chrono::steady_clock::now();
+            release(allocator, live[slot]);
+            auto mid = std::chrono::steady_clock::now();
+            allocate(allocator, &live[slot], mixedSizes[next++ % numMixedSizes]);
+            auto end = std::chrono::steady_clock::now();
+            threadFreeUs[t].push_back(std::chrono::duration<double, std::micro>(mid - start)
+                                          .count());
+            threadAllocUs[t].push_back(std::chrono::duration<double, std::micro>(end - mid)
+                                           .count());
+          }
+          for (unsigned int i = 0; i < liveAllocations; i++) {
+            release(allocator, live[i]);
+          }
+        });
+      }
+      while (ready.load() < threads) {
+      }
+      // The initial window is not timed, the clock stops when the last thread is done
+      auto start = std::chrono::steady_clock::now();
+      go = true;
+      for (auto& worker : workers) {
+        worker.join();
+      }
+      double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                       .count();
+      if (r >= p_warmup) {
+        callsPerSec.push_back(2.0 * threads * steps_ / sec);
+        for (unsigned int t = 0; t < threads; t++) {
+          allocUs.insert(allocUs.end(), threadAllocUs[t].begin(), threadAllocUs[t].end());
+          freeUs.insert(freeUs.end(), threadFreeUs[t].begin(), threadFreeUs[t].end());
+        }
+      }
+    }
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%2u threads ", threads);
+    unsigned int calls = threads * steps_;
+    report(test, std::string(desc) + allocatorStr[allocator] + " + " + freeStr[allocator],
+           0, 2 * calls, "calls/s", callsPerSec);
+    report(test, std::string(desc) + allocatorStr[allocator] + " latency", 0, calls, "us", allocUs);
+    report(test, std::string(desc) + freeStr[allocator] + " latency", 0, calls, "us", freeUs);
+  }
+
+ private:
+  unsigned int steps_;
+  std::vector<unsigned int> threadCounts_;
+  bool managed_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfMallocThreads)
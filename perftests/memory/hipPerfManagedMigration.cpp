@@ -0,0 +1,127 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Migration bandwidth of hipMallocManaged buffers whose pages start on the
+// host. Before every run the host writes the whole buffer; the timed part is
+// the device getting to the data plus one read pass of a kernel, either
+// sequential or in a scattered (odd-multiplier hash) order. Strategies:
+// page-fault driven, hipMemPrefetchAsync to the device before the kernel,
+// hipMemAdviseSetReadMostly and hipMemAdviseSetPreferredLocation(device).
+// Without hipDeviceAttributeConcurrentManagedAccess the runtime migrates
+// instead of faulting and the "fault" rows show that path.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "perf_harness.h"
+
+enum MigrationStrategy { migrateFault = 0, migratePrefetch, migrateReadMostly,
+                         migratePreferredLocation, numStrategies };
+enum AccessPattern { accessSequential = 0, accessRandom, numAccessPatterns };
+
+static const char* strategyStr[numStrategies] = {"fault", "prefetch", "readMostly",
+                                                 "preferredLocation"};
+static const char* accessStr[numAccessPatterns] = {"sequential", "random"};
+
+__global__ void _readKernel(const float* buf, size_t n, bool scatter, float* out) {
+  float sum = 0.0f;
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    // An odd multiplier permutes indices when n is a power of two
+    size_t idx = scatter ? (i * 2654435761ull) % n : i;
+    sum += buf[idx];
+  }
+  if (sum == -1.0f) out[0] = sum;
+}
+
+class hipPerfManagedMigration : public HipPerf::Benchmark {
+ public:
+  hipPerfManagedMigration() : HipPerf::Benchmark("hipPerfManagedMigration"),
+      sizes_(HipPerf::sweepSizes({16 << 20, 64 << 20, 256 << 20})), out_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipMalloc(&out_, sizeof(float)));
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return sizes_.size() * numStrategies * numAccessPatterns; }
+
+  void run(unsigned int test) override {
+    size_t size = sizes_[test % sizes_.size()];
+    MigrationStrategy strategy =
+        static_cast<MigrationStrategy>((test / sizes_.size()) % numStrategies);
+    AccessPattern access = static_cast<AccessPattern>(test / (sizes_.size() * numStrategies));
+    if (props_.managedMemory == 0) {
+      printf("info: device %d has no managed memory support, skipping\n", deviceId_);
+      return;
+    }
+
+    float* buf = nullptr;
+    HIPCHECK(hipMallocManaged(&buf, size));
+    if (strategy == migrateReadMostly) {
+      HIPCHECK(hipMemAdvise(buf, size, hipMemAdviseSetReadMostly, deviceId_));
+    } else if (strategy == migratePreferredLocation) {
+      HIPCHECK(hipMemAdvise(buf, size, hipMemAdviseSetPreferredLocation, deviceId_));
+    }
+    size_t n = size / sizeof(float);
+
+    std::vector<double> sec;
+    CPerfCounter timer;
+    measure([&]() {
+      // Brings the pages back to the host, untimed
+      memset(buf, 0, size);
+      timer.Reset();
+      timer.Start();
+      if (strategy == migratePrefetch) {
+        HIPCHECK(hipMemPrefetchAsync(buf, size, deviceId_, stream_));
+      }
+      hipLaunchKernelGGL(_readKernel, dim3(props_.multiProcessorCount * 8), dim3(256), 0, stream_,
+                         buf, n, access == accessRandom, out_);
+      HIPCHECK(hipStreamSynchronize(stream_));
+      timer.Stop();
+      if (!HipPerf::Counters::collecting()) {
+        sec.push_back(timer.GetElapsedTime());
+      }
+    });
+    sec = HipPerf::measuredSamples(sec);
+    HIPCHECK(hipFree(buf));
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%s %s", strategyStr[strategy], accessStr[access]);
+    report(test, desc, size, 1, "GB/s", HipPerf::toBandwidth(sec, size));
+  }
+
+ private:
+  std::vector<size_t> sizes_;
+  float* out_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfManagedMigration)
@@ -0,0 +1,215 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of __managed__ variables against __device__ variables copied
+// explicitly. A statistics counter is bumped with atomicAdd by every thread
+// of a small grid and then read by the host, either directly as __managed__
+// or through hipMemcpyFromSymbol from a __device__ counter; the managed
+// counter is also timed without host reads, so the difference is the
+// migration. The same is done for a 16 MB array: device reads while it stays
+// on the device, host writes followed by a device read (migration to the
+// device, or hipMemcpyToSymbol for the __device__ array) and device writes
+// followed by a host read (migration back, or hipMemcpyFromSymbol). Counters
+// report us per round trip, arrays GB/s of the array per round trip.
+// Skipped on devices without managed memory.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const size_t arrayFloats = 4 * 1024 * 1024;
+
+__managed__ unsigned int managedCounter;
+__device__ unsigned int deviceCounter;
+__managed__ float managedArray[arrayFloats];
+__device__ float deviceArray[arrayFloats];
+
+enum CounterMode { counterManagedDevice = 0, counterManaged, counterSymbol, numCounterModes };
+static const char* counterModeStr[numCounterModes] = {
+    "__managed__ counter, device only", "__managed__ counter, host read",
+    "__device__ counter + hipMemcpyFromSymbol"};
+
+enum ArrayMode {
+  arrayDeviceManaged = 0,
+  arrayDeviceSymbol,
+  arrayToDeviceManaged,
+  arrayToDeviceSymbol,
+  arrayToHostManaged,
+  arrayToHostSymbol,
+  numArrayModes
+};
+static const char* arrayModeStr[numArrayModes] = {
+    "device read __managed__",
+    "device read __device__",
+    "host write, device read __managed__",
+    "host write, hipMemcpyToSymbol, device read __device__",
+    "device write, host read __managed__",
+    "device write, hipMemcpyFromSymbol, host read __device__"};
+
+static const unsigned int blockSize = 256;
+static const unsigned int counterBlocks = 4;
+static const unsigned int blocksPerCu = 8;
+static const unsigned int roundTrips = 100;
+
+template <bool Managed> __global__ void bumpCounter() {
+  atomicAdd(Managed ? &managedCounter : &deviceCounter, 1u);
+}
+
+template <bool Managed> __global__ void readArray(float* out) {
+  const float* array = Managed ? managedArray : deviceArray;
+  float sum = 0;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < arrayFloats;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    sum += array[i];
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = sum;
+}
+
+template <bool Managed> __global__ void writeArray(float value) {
+  float* array = Managed ? managedArray : deviceArray;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < arrayFloats;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    array[i] = value;
+  }
+}
+
+class hipPerfManagedVariable : public HipPerf::Benchmark {
+ public:
+  hipPerfManagedVariable() : HipPerf::Benchmark("hipPerfManagedVariable"), host_(nullptr),
+      out_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    HIPCHECK(hipHostMalloc(&host_, sizeof(deviceArray)));
+    HIPCHECK(hipMalloc(&out_, static_cast<size_t>(grid_.x) * blockSize * sizeof(float)));
+    if (props_.managedMemory == 0) {
+      printf("info: device %d has no managed memory support, skipping\n", deviceId);
+    }
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipHostFree(host_));
+  }
+
+  unsigned int numTests() override { return numCounterModes + numArrayModes; }
+
+  void run(unsigned int test) override {
+    if (props_.managedMemory == 0) {
+      return;
+    }
+    if (test < numCounterModes) {
+      runCounter(test, static_cast<CounterMode>(test));
+    } else {
+      runArray(test, static_cast<ArrayMode>(test - numCounterModes));
+    }
+  }
+
+ private:
+  void runCounter(unsigned int test, CounterMode mode) {
+    volatile unsigned int seen = 0;
+    auto latency = measureEach([&]() {
+      unsigned int value = 0;
+      if (mode == counterSymbol) {
+        hipLaunchKernelGGL(bumpCounter<false>, dim3(counterBlocks), dim3(blockSize), 0, 0);
+        HIPCHECK(hipMemcpyFromSymbol(&value, HIP_SYMBOL(deviceCounter), sizeof(value)));
+      } else {
+        hipLaunchKernelGGL(bumpCounter<true>, dim3(counterBlocks), dim3(blockSize), 0, 0);
+        HIPCHECK(hipDeviceSynchronize());
+        if (mode == counterManaged) {
+          value = managedCounter;
+        }
+      }
+      seen = value;
+    }, roundTrips);
+    static_cast<void>(seen);
+
+    report(test, counterModeStr[mode], sizeof(unsigned int), 1, "us",
+           HipPerf::toMicroseconds(latency, 1));
+  }
+
+  void runArray(unsigned int test, ArrayMode mode) {
+    volatile float seen = 0;
+    auto sec = measure([&]() {
+      switch (mode) {
+        case arrayDeviceManaged:
+          hipLaunchKernelGGL(readArray<true>, grid_, dim3(blockSize), 0, 0, out_);
+          break;
+        case arrayDeviceSymbol:
+          hipLaunchKernelGGL(readArray<false>, grid_, dim3(blockSize), 0, 0, out_);
+          break;
+        case arrayToDeviceManaged:
+          for (size_t i = 0; i < arrayFloats; i++) {
+            managedArray[i] = static_cast<float>(i);
+          }
+          hipLaunchKernelGGL(readArray<true>, grid_, dim3(blockSize), 0, 0, out_);
+          break;
+        case arrayToDeviceSymbol:
+          for (size_t i = 0; i < arrayFloats; i++) {
+            host_[i] = static_cast<float>(i);
+          }
+          HIPCHECK(hipMemcpyToSymbol(HIP_SYMBOL(deviceArray), host_, sizeof(deviceArray)));
+          hipLaunchKernelGGL(readArray<false>, grid_, dim3(blockSize), 0, 0, out_);
+          break;
+        case arrayToHostManaged: {
+          hipLaunchKernelGGL(writeArray<true>, grid_, dim3(blockSize), 0, 0, 1.0f);
+          HIPCHECK(hipDeviceSynchronize());
+          float sum = 0;
+          for (size_t i = 0; i < arrayFloats; i++) {
+            sum += managedArray[i];
+          }
+          seen = sum;
+          break;
+        }
+        default: {
+          hipLaunchKernelGGL(writeArray<false>, grid_, dim3(blockSize), 0, 0, 1.0f);
+          HIPCHECK(hipMemcpyFromSymbol(host_, HIP_SYMBOL(deviceArray), sizeof(deviceArray)));
+          float sum = 0;
+          for (size_t i = 0; i < arrayFloats; i++) {
+            sum += host_[i];
+          }
+          seen = sum;
+          break;
+        }
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+    static_cast<void>(seen);
+
+    report(test, arrayModeStr[mode], sizeof(deviceArray), 1, "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(sizeof(deviceArray))));
+  }
+
+  float* host_;  // staging for the __device__ array
+  float* out_;
+  dim3 grid_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfManagedVariable)
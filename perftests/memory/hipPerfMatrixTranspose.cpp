@@ -0,0 +1,255 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Out-of-place transpose of row-major matrices with 2, 4 and 8 byte elements
+// over square, wide, tall and odd shapes, in four variants: naive (coalesced
+// reads, strided writes), tiled through a 32x32 LDS tile, the same tile padded
+// by one element per row so the transposed reads hit distinct banks, and the
+// padded tile with 4-element vector loads and stores (only for shapes whose
+// dimensions are multiples of 4). Every thread block moves one tile. The
+// result is checked against the host once per test; bandwidth counts one
+// read and one write of the matrix and is also given as a percentage of the
+// theoretical peak from memoryClockRate and memoryBusWidth.
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "perf_harness.h"
+
+enum TransposeVariant { variantNaive = 0, variantTiled, variantPadded, variantVector,
+                        numVariants };
+static const char* variantStr[numVariants] = {"naive", "LDS tiled", "LDS padded",
+                                              "LDS padded vector"};
+
+static const unsigned int elementSizes[] = {2, 4, 8};
+static const unsigned int numElementSizes = sizeof(elementSizes) / sizeof(elementSizes[0]);
+
+struct MatrixShape {
+  unsigned int rows;
+  unsigned int cols;
+};
+
+static const MatrixShape shapes[] = {{1024, 1024}, {4096, 4096}, {1024, 8192}, {8192, 1024},
+                                     {4095, 4097}};
+static const unsigned int numShapes = sizeof(shapes) / sizeof(shapes[0]);
+
+#define TILE_DIM 32
+#define BLOCK_ROWS 8
+#define VECTOR_WIDTH 4
+
+template <typename T> struct alignas(VECTOR_WIDTH * sizeof(T)) Vector {
+  T v[VECTOR_WIDTH];
+};
+
+// in is rows x cols, out is cols x rows; a 32x8 block covers a 32x32 tile
+template <typename T>
+__global__ void transposeNaive(T* out, const T* in, unsigned int rows, unsigned int cols) {
+  unsigned int x = blockIdx.x * TILE_DIM + threadIdx.x;
+  unsigned int y = blockIdx.y * TILE_DIM + threadIdx.y;
+  for (unsigned int j = 0; j < TILE_DIM; j += BLOCK_ROWS) {
+    if (x < cols && y + j < rows) {
+      out[static_cast<size_t>(x) * rows + y + j] = in[static_cast<size_t>(y + j) * cols + x];
+    }
+  }
+}
+
+template <typename T, unsigned int PAD>
+__global__ void transposeTiled(T* out, const T* in, unsigned int rows, unsigned int cols) {
+  __shared__ T tile[TILE_DIM][TILE_DIM + PAD];
+  unsigned int x = blockIdx.x * TILE_DIM + threadIdx.x;
+  unsigned int y = blockIdx.y * TILE_DIM + threadIdx.y;
+  for (unsigned int j = 0; j < TILE_DIM; j += BLOCK_ROWS) {
+    if (x < cols && y + j < rows) {
+      tile[threadIdx.y + j][threadIdx.x] = in[static_cast<size_t>(y + j) * cols + x];
+    }
+  }
+  __syncthreads();
+  x = blockIdx.y * TILE_DIM + threadIdx.x;
+  y = blockIdx.x * TILE_DIM + threadIdx.y;
+  for (unsigned int j = 0; j < TILE_DIM; j += BLOCK_ROWS) {
+    if (x < rows && y + j < cols) {
+      out[static_cast<size_t>(y + j) * rows + x] = tile[threadIdx.x][threadIdx.y + j];
+    }
+  }
+}
+
+// An 8x32 block, every thread moves 4 consecutive elements of one row; rows and cols % 4 == 0
+template <typename T>
+__global__ void transposeVector(T* out, const T* in, unsigned int rows, unsigned int cols) {
+  __shared__ T tile[TILE_DIM][TILE_DIM + 1];
+  unsigned int x = blockIdx.x * TILE_DIM + threadIdx.x * VECTOR_WIDTH;
+  unsigned int y = blockIdx.y * TILE_DIM + threadIdx.y;
+  if (x < cols && y < rows) {
+    Vector<T> v = *reinterpret_cast<const Vector<T>*>(&in[static_cast<size_t>(y) * cols + x]);
+    for (unsigned int k = 0; k < VECTOR_WIDTH; k++) {
+      tile[threadIdx.y][threadIdx.x * VECTOR_WIDTH + k] = v.v[k];
+    }
+  }
+  __syncthreads();
+  x = blockIdx.y * TILE_DIM + threadIdx.x * VECTOR_WIDTH;
+  y = blockIdx.x * TILE_DIM + threadIdx.y;
+  if (x < rows && y < cols) {
+    Vector<T> v;
+    for (unsigned int k = 0; k < VECTOR_WIDTH; k++) {
+      v.v[k] = tile[threadIdx.x * VECTOR_WIDTH + k][threadIdx.y];
+    }
+    *reinterpret_cast<Vector<T>*>(&out[static_cast<size_t>(y) * rows + x]) = v;
+  }
+}
+
+template <typename T>
+static void launchTranspose(TransposeVariant variant, void* out, const void* in,
+                            unsigned int rows, unsigned int cols, hipStream_t stream) {
+  dim3 grid((cols + TILE_DIM - 1) / TILE_DIM, (rows + TILE_DIM - 1) / TILE_DIM);
+  T* o = static_cast<T*>(out);
+  const T* i = static_cast<const T*>(in);
+  switch (variant) {
+    case variantNaive:
+      hipLaunchKernelGGL(transposeNaive<T>, grid, dim3(TILE_DIM, BLOCK_ROWS), 0, stream, o, i,
+                         rows, cols);
+      break;
+    case variantTiled:
+      hipLaunchKernelGGL((transposeTiled<T, 0>), grid, dim3(TILE_DIM, BLOCK_ROWS), 0, stream, o,
+                         i, rows, cols);
+      break;
+    case variantPadded:
+      hipLaunchKernelGGL((transposeTiled<T, 1>), grid, dim3(TILE_DIM, BLOCK_ROWS), 0, stream, o,
+                         i, rows, cols);
+      break;
+    default:
+      hipLaunchKernelGGL(transposeVector<T>, grid, dim3(TILE_DIM / VECTOR_WIDTH, TILE_DIM), 0,
+                         stream, o, i, rows, cols);
+      break;
+  }
+}
+
+template <typename T> static bool checkTransposed(const void* dev, const std::vector<T>& in,
+                                                  unsigned int rows, unsigned int cols) {
+  std::vector<T> out(in.size());
+  HIPCHECK(hipMemcpy(out.data(), dev, in.size() * sizeof(T), hipMemcpyDeviceToHost));
+  for (size_t r = 0; r < rows; r++) {
+    for (size_t c = 0; c < cols; c++) {
+      if (out[c * rows + r] != in[r * cols + c]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+class hipPerfMatrixTranspose : public HipPerf::Benchmark {
+ public:
+  hipPerfMatrixTranspose() : HipPerf::Benchmark("hipPerfMatrixTranspose"),
+      passes_(HipPerf::iterationCount(20)), stream_(nullptr), peakGBps_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    // kHz, two transfers per clock
+    peakGBps_ = 2.0 * props_.memoryClockRate * 1e3 * (props_.memoryBusWidth / 8) * 1e-9;
+  }
+
+  void close() override { HIPCHECK(hipStreamDestroy(stream_)); }
+
+  unsigned int numTests() override { return numShapes * numElementSizes * numVariants; }
+
+  void run(unsigned int test) override {
+    TransposeVariant variant = static_cast<TransposeVariant>(test % numVariants);
+    unsigned int elementSize = elementSizes[(test / numVariants) % numElementSizes];
+    const MatrixShape& shape = shapes[test / (numVariants * numElementSizes)];
+    if (variant == variantVector &&
+        (shape.rows % VECTOR_WIDTH != 0 || shape.cols % VECTOR_WIDTH != 0)) {
+      printf("info: %ux%u is not a multiple of %u, skipping %s\n", shape.rows, shape.cols,
+             VECTOR_WIDTH, variantStr[variant]);
+      return;
+    }
+
+    switch (elementSize) {
+      case 2:
+        runTyped<unsigned short>(test, variant, shape);
+        break;
+      case 4:
+        runTyped<float>(test, variant, shape);
+        break;
+      default:
+        runTyped<double>(test, variant, shape);
+        break;
+    }
+  }
+
+ private:
+  template <typename T>
+  void runTyped(unsigned int test, TransposeVariant variant, const MatrixShape& shape) {
+    size_t count = static_cast<size_t>(shape.rows) * shape.cols;
+    size_t bytes = count * sizeof(T);
+    std::vector<T> host(count);
+    for (size_t i = 0; i < count; i++) {
+      host[i] = static_cast<T>(i % 65521);
+    }
+    void* in = nullptr;
+    void* out = nullptr;
+    HIPCHECK(hipMalloc(&in, bytes));
+    HIPCHECK(hipMalloc(&out, bytes));
+    HIPCHECK(hipMemcpy(in, host.data(), bytes, hipMemcpyHostToDevice));
+    HIPCHECK(hipMemset(out, 0, bytes));
+
+    launchTranspose<T>(variant, out, in, shape.rows, shape.cols, stream_);
+    HIPCHECK(hipGetLastError());
+    HIPCHECK(hipStreamSynchronize(stream_));
+    if (!checkTransposed(out, host, shape.rows, shape.cols)) {
+      failed("%s transpose of %ux%u %zuB elements is wrong", variantStr[variant], shape.rows,
+             shape.cols, sizeof(T));
+    }
+
+    auto sec = measure([&]() {
+      for (unsigned int p = 0; p < passes_; p++) {
+        launchTranspose<T>(variant, out, in, shape.rows, shape.cols, stream_);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    HIPCHECK(hipFree(in));
+    HIPCHECK(hipFree(out));
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%5ux%-5u %zuB %s", shape.rows, shape.cols, sizeof(T),
+             variantStr[variant]);
+    auto gbps = HipPerf::toBandwidth(sec, 2.0 * bytes * passes_);
+    report(test, desc, bytes, passes_, "GB/s", gbps);
+    if (peakGBps_ > 0) {
+      std::vector<double> percent;
+      for (double g : gbps) {
+        percent.push_back(100.0 * g / peakGBps_);
+      }
+      report(test, std::string(desc) + " of peak", bytes, passes_, "%", percent);
+    }
+  }
+
+  unsigned int passes_;
+  hipStream_t stream_;
+  double peakGBps_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfMatrixTranspose)
@@ -18,68 +18,85 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
  * TEST: %t
  * HIT_END
  */
 
-#include "test_common.h"
+#include "perf_harness.h"
 #include <printf/printf_common.h>
 #include <iostream>
+#include <algorithm>
 #include <chrono>
+#include <thread>
+#include <vector>
 #include <sys/time.h>
+#include <unistd.h>
 
 #define SIMPLY_ASSIGN 0
 #define USE_HIPTEST_SETNUMBLOCKS 0
 
 using namespace std;
 
+// Value of element i, identical on host and device for every element count
 template<class T>
-__global__ void vec_fill(T *x, T coef, int N) {
-  const int istart = threadIdx.x + blockIdx.x * blockDim.x;
-  const int ishift = blockDim.x * gridDim.x;
-  for (int i = istart; i < N; i += ishift) {
+__host__ __device__ inline T fillValue(T coef, size_t i) {
 #if SIMPLY_ASSIGN
-    x[i] = coef;
+  return coef;
 #else
-    x[i] = coef * i;
+  return coef * static_cast<T>(i);
 #endif
+}
+
+// Wraps around in unsigned arithmetic where coef * i would overflow int
+template<>
+__host__ __device__ inline int fillValue<int>(int coef, size_t i) {
+#if SIMPLY_ASSIGN
+  return coef;
+#else
+  return static_cast<int>(static_cast<unsigned int>(coef) * static_cast<unsigned int>(i));
+#endif
+}
+
+// Kernels index with size_t and stride over the grid, so any element count fits any grid
+template<class T>
+__global__ void vec_fill(T *x, T coef, size_t N) {
+  const size_t istart = threadIdx.x + static_cast<size_t>(blockIdx.x) * blockDim.x;
+  const size_t ishift = static_cast<size_t>(blockDim.x) * gridDim.x;
+  for (size_t i = istart; i < N; i += ishift) {
+    x[i] = fillValue(coef, i);
   }
 }
 
-__device__ void print_log(int i, double value, double expected) {
-  printf("failed at %d: val=%g, expected=%g\n", i, value, expected);
+__device__ void print_log(size_t i, double value, double expected) {
+  printf("failed at %llu: val=%g, expected=%g\n", static_cast<unsigned long long>(i), value,
+         expected);
 }
 
-__device__ void print_log(int i, int value, int expected) {
-  printf("failed at %d: val=%d, expected=%d\n", i, value, expected);
+__device__ void print_log(size_t i, int value, int expected) {
+  printf("failed at %llu: val=%d, expected=%d\n", static_cast<unsigned long long>(i), value,
+         expected);
 }
 
 template<class T>
-__global__ void vec_verify(T *x, T coef, int N) {
-  const int istart = threadIdx.x + blockIdx.x * blockDim.x;
-  const int ishift = blockDim.x * gridDim.x;
-  for (int i = istart; i < N; i += ishift) {
-#if SIMPLY_ASSIGN
-    if(x[i] != coef) {
-      print_log(i, x[i], coef);
-    }
-#else
-    if(x[i] != coef * i) {
-      print_log(i, x[i], coef * i);
+__global__ void vec_verify(T *x, T coef, size_t N) {
+  const size_t istart = threadIdx.x + static_cast<size_t>(blockIdx.x) * blockDim.x;
+  const size_t ishift = static_cast<size_t>(blockDim.x) * gridDim.x;
+  for (size_t i = istart; i < N; i += ishift) {
+    if(x[i] != fillValue(coef, i)) {
+      print_log(i, x[i], fillValue(coef, i));
     }
-#endif
   }
 }
 
 template<class T>
 __global__ void daxpy(T *__restrict__ x, T *__restrict__ y,
-    const T coef, int Niter, int N) {
-  const int istart = threadIdx.x + blockIdx.x * blockDim.x;
-  const int ishift = blockDim.x * gridDim.x;
+    const T coef, int Niter, size_t N) {
+  const size_t istart = threadIdx.x + static_cast<size_t>(blockIdx.x) * blockDim.x;
+  const size_t ishift = static_cast<size_t>(blockDim.x) * gridDim.x;
   for (int iter = 0; iter < Niter; ++iter) {
     T iv = coef * iter;
-    for (int i = istart; i < N; i += ishift)
+    for (size_t i = istart; i < N; i += ishift)
     y[i] = iv * x[i] + y[i];
   }
 }
@@ -88,19 +105,28 @@ template<class T>
 class hipPerfMemFill {
  private:
   static constexpr int NUM_START = 27;
-  static constexpr int NUM_SIZE = 5;
+  static constexpr int NUM_SIZE = 10;
   static constexpr int NUM_ITER = 10;
+  // Elements the host threads fill or check between two tests for a mismatch
+  static constexpr size_t HOST_CHUNK = 4096;
+  // Share of free device memory or physical host memory a test may take
+  static constexpr double MAX_MEMORY_FRACTION = 0.4;
   size_t totalSizes_[NUM_SIZE];
   hipDeviceProp_t props_;
   const T coef_ = getCoefficient(3.14159);
   const unsigned int blocksPerCU_;
   const unsigned int threadsPerBlock_;
+  const unsigned int hostThreads_;
+  size_t deviceMem_ = 0;  // free at open
+  size_t hostMem_ = 0;
+  unsigned int test_ = 0;
 
  public:
   hipPerfMemFill(unsigned int blocksPerCU, unsigned int threadsPerBlock) :
-    blocksPerCU_(blocksPerCU), threadsPerBlock_(threadsPerBlock) {
+    blocksPerCU_(blocksPerCU), threadsPerBlock_(threadsPerBlock),
+    hostThreads_(std::max(1u, std::thread::hardware_concurrency())) {
     for (int i = 0; i < NUM_SIZE; i++) {
-      totalSizes_[i] = 1ull << (i + NUM_START); // 128M, 256M, 512M, 1024M, 2048M
+      totalSizes_[i] = 1ull << (i + NUM_START); // 128M, 256M, ..., 64G
     }
   }
 
@@ -121,11 +147,37 @@ class hipPerfMemFill {
 
   void setHostBuffer(T *A, T val, size_t size) {
     size_t len = size / sizeof(T);
-    for (int i = 0; i < len; i++) {
+    for (size_t i = 0; i < len; i++) {
       A[i] = val;
     }
   }
 
+  // Sizes beyond the share of the memory they come from are skipped, not failed
+  bool fits(size_t size, bool host) {
+    size_t limit = static_cast<size_t>((host ? hostMem_ : deviceMem_) * MAX_MEMORY_FRACTION);
+    if (size <= limit) {
+      return true;
+    }
+    cout << "Info: " << (size >> 20) << " MB exceeds " << MAX_MEMORY_FRACTION * 100 << "% of "
+         << (host ? "host" : "free device") << " memory, skipping" << endl;
+    return false;
+  }
+
+  // Runs body(thread, begin, end) on up to hostThreads_ threads, each over a contiguous
+  // range of the num elements
+  template<class F>
+  void parallelFor(size_t num, F body) {
+    size_t per = (num + hostThreads_ - 1) / hostThreads_;
+    per = (per + HOST_CHUNK - 1) / HOST_CHUNK * HOST_CHUNK;
+    std::vector<std::thread> threads;
+    for (size_t begin = 0; begin < num; begin += per) {
+      threads.emplace_back(body, threads.size(), begin, std::min(num, begin + per));
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
+
   void open(int deviceId) {
     int nGpu = 0;
     HIPCHECK(hipGetDeviceCount(&nGpu));
@@ -138,37 +190,43 @@ class hipPerfMemFill {
     HIPCHECK(hipSetDevice(deviceId));
     memset(&props_, 0, sizeof(props_));
     HIPCHECK(hipGetDeviceProperties(&props_, deviceId));
+    size_t totalMem = 0;
+    HIPCHECK(hipMemGetInfo(&deviceMem_, &totalMem));
+    hostMem_ = static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGE_SIZE);
     std::cout << "Info: running on device: id: " << deviceId << ", bus: 0x"
         << props_.pciBusID << " " << props_.name << " with "
         << props_.multiProcessorCount << " CUs, large bar: "
         << supportLargeBar() << ", managed memory: " << supportManagedMemory()
         << ", DeviceMallocFinegrained: " << supportDeviceMallocFinegrained()
-        << std::endl;
+        << ", host threads: " << hostThreads_ << std::endl;
   }
 
+  // GBytes are GiB here, results are reported in GiB/s
   void log_host(const char* title, double GBytes, double sec) {
-    cout << title << " [" << setw(7) << GBytes << " GB]: cost " << setw(10) << sec
-        << " s in bandwidth " << setw(10) << GBytes / sec << " [GB/s]" << endl;
+    HipPerf::writeResult("hipPerfMemFill", test_++, std::string(title) + " sizeof " +
+                         std::to_string(sizeof(T)), GBytes * 1024 * 1024 * 1024, 1, "GiB/s",
+                         GBytes / sec);
   }
 
   void log_kernel(const char* title, double GBytes, double sec, double sec_hv, double sec_kv) {
-    cout << title << " [" << setw(7) << GBytes << " GB]: cost " << setw(10) << sec
-        << " s in bandwidth " << setw(10) << GBytes / sec << " [GB/s]" << ", hostVerify cost "
-        << setw(10) << sec_hv << " s in bandwidth " << setw(10) << GBytes / sec_hv << " [GB/s]"
-        << ", kernelVerify cost "<< setw(10) << sec_kv << " s in bandwidth " << setw(10)
-        << GBytes / sec_kv << " [GB/s]" << endl;
+    std::string desc = std::string(title) + " sizeof " + std::to_string(sizeof(T));
+    size_t bytes = GBytes * 1024 * 1024 * 1024;
+    HipPerf::writeResult("hipPerfMemFill", test_, desc, bytes, 1, "GiB/s", GBytes / sec);
+    HipPerf::writeResult("hipPerfMemFill", test_, desc + " hostVerify", bytes, 1, "GiB/s",
+                         GBytes / sec_hv);
+    HipPerf::writeResult("hipPerfMemFill", test_++, desc + " kernelVerify", bytes, 1, "GiB/s",
+                         GBytes / sec_kv);
   }
 
+  // The inner loops have no early exit, so the compiler vectorizes them
   void hostFill(size_t size, T *data, T coef, double &sec) {
     size_t num = size / sizeof(T);  // Size of elements
     auto start = chrono::steady_clock::now();
-    for (int i = 0; i < num; ++i) {
-#if SIMPLY_ASSIGN
-      data[i] = coef;
-#else
-      data[i] = coef * i;
-#endif
-    }
+    parallelFor(num, [=](size_t, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        data[i] = fillValue(coef, i);
+      }
+    });
     auto end = chrono::steady_clock::now();
     chrono::duration<double> diff = end - start;  // in second
     sec = diff.count();
@@ -195,25 +253,37 @@ class hipPerfMemFill {
     sec = diff.count() / NUM_ITER;  // in second
   }
 
+  // Every thread checks HOST_CHUNK elements at a time without branching and only
+  // searches a chunk for the first mismatch when it has one
   void hostVerify(size_t size, T *data, T coef, double &sec) {
     size_t num = size / sizeof(T);  // Size of elements
+    std::vector<size_t> firstBad(hostThreads_, num);
     auto start = chrono::steady_clock::now();
-    for (int i = 0; i < num; ++i) {
-#if SIMPLY_ASSIGN
-      if(data[i] != coef) {
-        cout << "hostVerify failed: i=" << i << ", data[i]=" << data[i] << ", expected=" << coef << endl;
-        failed("failed\n");
-      }
-#else
-      if(data[i] != coef * i) {
-        cout << "hostVerify failed: i=" << i << ", data[i]=" << data[i] << ", expected=" << coef * i << endl;
-        failed("failed\n");
+    parallelFor(num, [&firstBad, num, data, coef](size_t thread, size_t begin, size_t end) {
+      size_t& bad = firstBad[thread];
+      for (size_t chunk = begin; chunk < end && bad == num; chunk += HOST_CHUNK) {
+        size_t chunkEnd = std::min(end, chunk + HOST_CHUNK);
+        bool mismatch = false;
+        for (size_t i = chunk; i < chunkEnd; ++i) {
+          mismatch |= data[i] != fillValue(coef, i);
+        }
+        for (size_t i = chunk; mismatch && i < chunkEnd; ++i) {
+          if (data[i] != fillValue(coef, i)) {
+            bad = i;
+            break;
+          }
+        }
       }
-#endif
-    }
+    });
     auto end = chrono::steady_clock::now();
     chrono::duration<double> diff = end - start;  // in second
     sec = diff.count();
+    size_t i = *std::min_element(firstBad.begin(), firstBad.end());
+    if (i != num) {
+      cout << "hostVerify failed: i=" << i << ", data[i]=" << data[i] << ", expected="
+           << fillValue(coef, i) << endl;
+      failed("failed\n");
+    }
   }
 
   void kernelVerify(size_t size, T *data, T coef, double &sec) {
@@ -253,6 +323,9 @@ class hipPerfMemFill {
     if (!supportLargeBar()) {
       return false;
     }
+    if (!fits(size, false)) {
+      return true;
+    }
 
     double GBytes = (double) size / (1024.0 * 1024.0 * 1024.0);
 
@@ -285,6 +358,9 @@ class hipPerfMemFill {
     if (!supportManagedMemory()) {
       return false;
     }
+    if (!fits(size, true)) {
+      return true;
+    }
     double GBytes = (double) size / (1024.0 * 1024.0 * 1024.0);
 
     T *A;
@@ -301,6 +377,9 @@ class hipPerfMemFill {
     if (!supportManagedMemory()) {
       return false;
     }
+    if (!fits(size, true)) {
+      return true;
+    }
     double GBytes = (double) size / (1024.0 * 1024.0 * 1024.0);
 
     T *A;
@@ -340,6 +419,9 @@ class hipPerfMemFill {
   }
 
   bool testHostMemoryHostFill(size_t size, unsigned int flags) {
+    if (!fits(size, true)) {
+      return true;
+    }
     double GBytes = (double) size / (1024.0 * 1024.0 * 1024.0);
     T *A;
     HIPCHECK(hipHostMalloc(&A, size, flags));
@@ -352,6 +434,9 @@ class hipPerfMemFill {
   }
 
   bool testHostMemoryKernelFill(size_t size, unsigned int flags) {
+    if (!fits(size, true)) {
+      return true;
+    }
     double GBytes = (double) size / (1024.0 * 1024.0 * 1024.0);
 
     T *A;
@@ -413,19 +498,24 @@ class hipPerfMemFill {
 #endif
   }
 
-  unsigned int setNumBlocks(size_t size) {
-    size_t num = size/sizeof(T);
-
+  // Takes the element count. One thread per element up to 2^31 threads, the grid-stride
+  // kernels cover larger counts.
+  unsigned int setNumBlocks(size_t num) {
 #if USE_HIPTEST_SETNUMBLOCKS
     return HipTest::setNumBlocks(blocksPerCU_, threadsPerBlock_,
                                  num);
 #else
-    return (num + threadsPerBlock_ - 1) / threadsPerBlock_;
+    size_t maxBlocks = (1ull << 31) / threadsPerBlock_;
+    return static_cast<unsigned int>(
+        std::min(maxBlocks, (num + threadsPerBlock_ - 1) / threadsPerBlock_));
 #endif
   }
 
 #ifdef __HIP_PLATFORM_AMD__
   bool testExtDeviceMemoryHostFill(size_t size, unsigned int flags) {
+    if (!fits(size, false)) {
+      return true;
+    }
     double GBytes = (double) size / (1024.0 * 1024.0 * 1024.0);
 
     T *A = nullptr;
@@ -445,6 +535,9 @@ class hipPerfMemFill {
   }
 
   bool testExtDeviceMemoryKernelFill(size_t size, unsigned int flags) {
+    if (!fits(size, false)) {
+      return true;
+    }
     double GBytes = (double) size / (1024.0 * 1024.0 * 1024.0);
 
     T *A = nullptr;
@@ -0,0 +1,151 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Dependent-load latency from a single thread chasing a random cyclic chain
+// through working sets from 1KB up to half of device memory (at most 4GB).
+// Nodes are 64 bytes apart so every load touches a new line; the latency
+// steps show where the working set leaves L1, L2, the last level cache and
+// finally HBM. Reports clock64() cycles and, from wall_clock64(), ns per load.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <random>
+
+#include "perf_harness.h"
+
+#define NODE_STRIDE (64 / sizeof(unsigned int))
+
+struct ChaseResult {
+  long long cycles;
+  long long wallTicks;
+  unsigned int last;
+};
+
+// buf[order[i] * stride] = order[i + 1] * stride, closing the cycle at the end.
+__global__ void _linkKernel(unsigned int* buf, const unsigned int* order, size_t nodes) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < nodes; i += gridDim.x * blockDim.x) {
+    buf[order[i] * NODE_STRIDE] = order[(i + 1) % nodes] * NODE_STRIDE;
+  }
+}
+
+__global__ void _chaseKernel(const unsigned int* buf, unsigned int warmup, unsigned int steps,
+                             ChaseResult* result) {
+  unsigned int j = 0;
+  for (unsigned int i = 0; i < warmup; i++) {
+    j = buf[j];
+  }
+  long long start = clock64();
+  long long wallStart = wall_clock64();
+  for (unsigned int i = 0; i < steps; i++) {
+    j = buf[j];
+  }
+  // The final index depends on every load, so none of them can be skipped
+  result->cycles = clock64() - start;
+  result->wallTicks = wall_clock64() - wallStart;
+  result->last = j;
+}
+
+class hipPerfMemLatency : public HipPerf::Benchmark {
+ public:
+  hipPerfMemLatency() : HipPerf::Benchmark("hipPerfMemLatency"),
+      steps_(HipPerf::iterationCount(100000)), wallRateHz_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    size_t maxSize = std::min<size_t>(props_.totalGlobalMem / 2, size_t(4) << 30);
+    std::vector<size_t> defaults;
+    for (size_t size = 1024; size <= maxSize; size *= 2) {
+      defaults.push_back(size);
+    }
+    sizes_ = HipPerf::sweepSizes(defaults);
+    int rateKHz = 0;
+    HIPCHECK(hipDeviceGetAttribute(&rateKHz, hipDeviceAttributeWallClockRate, deviceId));
+    wallRateHz_ = rateKHz * 1000.0;
+    HIPCHECK(hipMalloc(&result_, sizeof(ChaseResult)));
+  }
+
+  void close() override { HIPCHECK(hipFree(result_)); }
+
+  unsigned int numTests() override { return sizes_.size(); }
+
+  void run(unsigned int test) override {
+    size_t size = sizes_[test];
+    size_t nodes = std::max<size_t>(size / (NODE_STRIDE * sizeof(unsigned int)), 2);
+
+    // Sattolo's algorithm: a random permutation that is a single cycle
+    std::vector<unsigned int> order(nodes);
+    for (size_t i = 0; i < nodes; i++) {
+      order[i] = static_cast<unsigned int>(i);
+    }
+    std::mt19937_64 rng(nodes);
+    for (size_t i = nodes - 1; i > 0; i--) {
+      std::swap(order[i], order[std::uniform_int_distribution<size_t>(0, i - 1)(rng)]);
+    }
+
+    unsigned int* buf = nullptr;
+    unsigned int* devOrder = nullptr;
+    HIPCHECK(hipMalloc(&buf, nodes * NODE_STRIDE * sizeof(unsigned int)));
+    HIPCHECK(hipMalloc(&devOrder, nodes * sizeof(unsigned int)));
+    HIPCHECK(hipMemcpy(devOrder, order.data(), nodes * sizeof(unsigned int),
+                       hipMemcpyHostToDevice));
+    hipLaunchKernelGGL(_linkKernel, dim3(props_.multiProcessorCount * 8), dim3(256), 0, 0, buf,
+                       devOrder, nodes);
+    HIPCHECK(hipDeviceSynchronize());
+    HIPCHECK(hipFree(devOrder));
+
+    // One lap of the chain to warm the caches, capped to keep huge sets affordable
+    unsigned int warmup = static_cast<unsigned int>(std::min<size_t>(nodes, steps_));
+    std::vector<double> cycles, ns;
+    measure([&]() {
+      hipLaunchKernelGGL(_chaseKernel, dim3(1), dim3(1), 0, 0, buf, warmup, steps_, result_);
+      ChaseResult result;
+      HIPCHECK(hipMemcpy(&result, result_, sizeof(result), hipMemcpyDeviceToHost));
+      if (HipPerf::Counters::collecting()) {
+        return;
+      }
+      cycles.push_back(static_cast<double>(result.cycles) / steps_);
+      if (wallRateHz_ > 0) {
+        ns.push_back(result.wallTicks * 1e9 / wallRateHz_ / steps_);
+      }
+    });
+    HIPCHECK(hipFree(buf));
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "working set %zu KB", size >> 10);
+    report(test, desc, size, steps_, "cycles/load", HipPerf::measuredSamples(cycles));
+    if (!ns.empty()) {
+      report(test, desc, size, steps_, "ns/load", HipPerf::measuredSamples(ns));
+    }
+  }
+
+ private:
+  std::vector<size_t> sizes_;
+  unsigned int steps_;
+  double wallRateHz_;
+  ChaseResult* result_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfMemLatency)
@@ -17,17 +17,17 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 */
 
-#include "test_common.h"
+#include "perf_harness.h"
 #include <iostream>
-#include <time.h>
+#include <algorithm>
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
  * TEST: %t
  * HIT_END
  */
 
-#define NUM_SIZE 19  //size up to 16M
+#define NUM_SIZE 19  //default sizes up to 16M
 #define NUM_ITER 500 //Total GPU memory up to 16M*500=8G
 
 void valSet(int* A, int val, size_t size) {
@@ -37,88 +37,131 @@ void valSet(int* A, int val, size_t size) {
     }
 }
 
-void setup(size_t *size, int &num, int **pA, const size_t totalGlobalMem) {
+// Test 0 times the first hipMalloc/hipMemcpy/hipFree of the process, the
+// following tests time NUM_ITER back to back calls per size.
+class hipPerfMemMallocCpyFree : public HipPerf::Benchmark {
+  public:
+    hipPerfMemMallocCpyFree() : HipPerf::Benchmark("hipPerfMemMallocCpyFree"),
+        numIter_(HipPerf::iterationCount(NUM_ITER)), A_(nullptr) {}
+    ~hipPerfMemMallocCpyFree() {}
 
-    std::cout << "size: ";
-    for (int i = 0; i < num; i++) {
-        size[i] = 1 << (i + 6);
-        if((NUM_ITER + 1) * size[i] > totalGlobalMem) {
-          num = i;
+    void open(int deviceId) override;
+    void close() override { free(A_); }
+    unsigned int numTests() override { return size_.size() + 1; }
+    void run(unsigned int test) override;
+
+  private:
+    void testInit(size_t size);
+
+    std::vector<size_t> size_;
+    unsigned int numIter_;
+    int* A_;
+};
+
+void hipPerfMemMallocCpyFree::open(int deviceId) {
+    HipPerf::Benchmark::open(deviceId);
+
+    std::vector<size_t> defaults;
+    for (int i = 0; i < NUM_SIZE; i++) {
+        defaults.push_back(1 << (i + 6));
+    }
+    // Drop sizes whose numIter_ allocations would not fit on the device
+    for (size_t size : HipPerf::sweepSizes(defaults)) {
+        if ((numIter_ + 1) * size > props_.totalGlobalMem) {
           break;
         }
-        std::cout << size[i] << " ";
+        size_.push_back(size);
+    }
+    if (size_.empty()) {
+        failed("No size fits %u allocations in device memory\n", numIter_);
     }
-    std::cout << std::endl;
-    *pA = (int*)malloc(size[num - 1]);
-    valSet(*pA, 1, size[num - 1]);
+    size_t maxSize = *std::max_element(size_.begin(), size_.end());
+    A_ = (int*)malloc(maxSize);
+    valSet(A_, 1, maxSize);
 }
 
-void testInit(size_t size, int *A) {
-    int *Ad;
-    clock_t start = clock();
-    hipMalloc(&Ad, size); //hip::init() will be called
-    clock_t end = clock();
-    double uS = (end - start) * 1000000. / CLOCKS_PER_SEC;
-    std::cout << "Initial" << std::endl;
-    std::cout << "hipMalloc(" << size << ") cost " << uS << "us" << std::endl;
-
-    start = clock();
-    hipMemcpy(Ad, A, size, hipMemcpyHostToDevice);
-    hipDeviceSynchronize();
-    end = clock();
-    uS = (end - start) * 1000000. / CLOCKS_PER_SEC;
-    std::cout << "hipMemcpy(" << size << ") cost " << uS << "us" << std::endl;
-
-    start = clock();
-    hipFree(Ad);
-    end = clock();
-    uS = (end - start) * 1000000. / CLOCKS_PER_SEC;
-    std::cout << "hipFree(" << size << ") cost " << uS << "us" << std::endl;
+void hipPerfMemMallocCpyFree::testInit(size_t size) {
+    int* Ad;
+    // Only the very first call is of interest, so there is no warm-up
+    auto sec = measure([&]() { HIPCHECK(hipMalloc(&Ad, size)); }, 0);
+    report(0, "Initial hipMalloc", size, 1, "us", HipPerf::toMicroseconds(sec, 1));
+    HIPCHECK(hipFree(Ad));
+
+    HIPCHECK(hipMalloc(&Ad, size));
+    sec = measure([&]() {
+        HIPCHECK(hipMemcpy(Ad, A_, size, hipMemcpyHostToDevice));
+        HIPCHECK(hipDeviceSynchronize());
+    }, 0);
+    report(0, "Initial hipMemcpy", size, 1, "us", HipPerf::toMicroseconds(sec, 1));
+
+    sec = measure([&]() {
+        HIPCHECK(hipFree(Ad));
+        HIPCHECK(hipMalloc(&Ad, size));
+    }, 0);
+    report(0, "Initial hipFree + hipMalloc", size, 1, "us", HipPerf::toMicroseconds(sec, 1));
+    HIPCHECK(hipFree(Ad));
 }
 
-int main() {
-    double uS;
-    clock_t start, end;
-    size_t size[NUM_SIZE] = { 0 };
-    int *Ad[NUM_ITER] = { nullptr };
-    int *A;
-    hipDeviceProp_t props;
-    memset(&props, 0, sizeof(props));
-    HIPCHECK(hipGetDeviceProperties(&props, 0));
-    std::cout << "totalGlobalMem: " << props.totalGlobalMem << std::endl;
-
-    int num = NUM_SIZE;
-    setup(size, num, &A, props.totalGlobalMem);
-    testInit(size[0], A);
-
-    for (int i = 0; i < num; i++) {
-        std::cout << size[i] << std::endl;
-        start = clock();
-        for (int j = 0; j < NUM_ITER; j++) {
-            HIPCHECK(hipMalloc(&Ad[j], size[i]));
-        }
-        end = clock();
-        uS = (end - start) * 1000000. / (NUM_ITER * CLOCKS_PER_SEC);
-        std::cout << "hipMalloc(" << size[i] << ") cost " << uS << "us" << std::endl;
+void hipPerfMemMallocCpyFree::run(unsigned int test) {
+    if (test == 0) {
+        testInit(size_[0]);
+        return;
+    }
 
-        start = clock();
-        for (int j = 0; j < NUM_ITER; j++) {
-            HIPCHECK(hipMemcpy(Ad[j], A, size[i], hipMemcpyHostToDevice));
-        }
-        hipDeviceSynchronize();
-        end = clock();
-        uS = (end - start) * 1000000. / (NUM_ITER * CLOCKS_PER_SEC);
-        std::cout << "hipMemcpy(" << size[i] << ") cost " << uS << "us" << std::endl;
+    size_t size = size_[test - 1];
+    std::vector<int*> Ad(numIter_, nullptr);
 
-        start = clock();
-        for (int j = 0; j < NUM_ITER; j++) {
+    auto freeAll = [&]() {
+        for (unsigned int j = 0; j < numIter_; j++) {
             HIPCHECK(hipFree(Ad[j]));
             Ad[j] = nullptr;
         }
-        end = clock();
-        double uS = (end - start) * 1000000. / (NUM_ITER * CLOCKS_PER_SEC);
-        std::cout << "hipFree(" << size[i] << ") cost " << uS << "us" << std::endl;
+    };
+    auto mallocAll = [&]() {
+        for (unsigned int j = 0; j < numIter_; j++) {
+            HIPCHECK(hipMalloc(&Ad[j], size));
+        }
+    };
+
+    // Every timed hipMalloc run needs its buffers released outside the timing
+    std::vector<double> mallocSec;
+    for (unsigned int w = 0; w < p_warmup; w++) {
+        mallocAll();
+        freeAll();
+    }
+    CPerfCounter timer;
+    for (unsigned int r = 0; r < p_repetitions; r++) {
+        timer.Reset();
+        timer.Start();
+        mallocAll();
+        timer.Stop();
+        mallocSec.push_back(timer.GetElapsedTime());
+        if (r + 1 < p_repetitions) {
+            freeAll();
+        }
+    }
+    report(test, "hipMalloc", size, numIter_, "us", HipPerf::toMicroseconds(mallocSec, numIter_));
+
+    auto sec = measure([&]() {
+        for (unsigned int j = 0; j < numIter_; j++) {
+            HIPCHECK(hipMemcpy(Ad[j], A_, size, hipMemcpyHostToDevice));
+        }
+        HIPCHECK(hipDeviceSynchronize());
+    });
+    report(test, "hipMemcpy", size, numIter_, "us", HipPerf::toMicroseconds(sec, numIter_));
+
+    std::vector<double> freeSec;
+    for (unsigned int r = 0; r < p_repetitions; r++) {
+        if (r > 0) {
+            mallocAll();
+        }
+        timer.Reset();
+        timer.Start();
+        freeAll();
+        timer.Stop();
+        freeSec.push_back(timer.GetElapsedTime());
     }
-    free(A);
-    passed();
+    report(test, "hipFree", size, numIter_, "us", HipPerf::toMicroseconds(freeSec, numIter_));
 }
+
+HIP_PERF_BENCHMARK(hipPerfMemMallocCpyFree)
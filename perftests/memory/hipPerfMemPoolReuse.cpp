@@ -0,0 +1,227 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Memory pool reuse across streams and the cost of trimming.
+// Cross-stream tests: every iteration allocates and memsets a block on stream
+// A and frees it there, then allocates, memsets and frees a block of the same
+// size on stream B, either after B waited for an event recorded on A or
+// without any ordering. The pool is created per test with one combination of
+// hipMemPoolReuseFollowEventDependencies, hipMemPoolReuseAllowOpportunistic and
+// hipMemPoolReuseAllowInternalDependencies enabled. Reports us per iteration,
+// the share of B allocations that got A's block back and the pool's
+// hipMemPoolAttrReservedMemHigh in MB, i.e. what the policy makes the pool hold.
+// Trim tests: 64 blocks are allocated and freed so the pool caches them, then
+// hipMemPoolTrimTo(0) is timed, followed by allocating the 64 blocks again
+// after the trim and from the warm cache.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "perf_harness.h"
+
+static const std::vector<size_t> Sizes = {65536, 4194304, 67108864};
+static const unsigned int trimBlocks = 64;
+
+struct ReusePolicy {
+  const char* name;
+  int followEvents;
+  int opportunistic;
+  int internalDeps;
+};
+
+static const ReusePolicy reusePolicies[] = {
+    {"no reuse", 0, 0, 0},
+    {"follow events", 1, 0, 0},
+    {"opportunistic", 0, 1, 0},
+    {"internal deps", 0, 0, 1},
+    {"all", 1, 1, 1},
+};
+static const unsigned int numReusePolicies = sizeof(reusePolicies) / sizeof(reusePolicies[0]);
+
+enum Ordering { orderEvent = 0, orderNone, numOrderings };
+static const char* orderingStr[numOrderings] = {"B waits on A", "unordered"};
+
+class hipPerfMemPoolReuse : public HipPerf::Benchmark {
+ public:
+  hipPerfMemPoolReuse() : HipPerf::Benchmark("hipPerfMemPoolReuse"),
+      sizes_(HipPerf::sweepSizes(Sizes)), pairs_(HipPerf::iterationCount(200)), supported_(0),
+      streamA_(nullptr), streamB_(nullptr), event_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&supported_, hipDeviceAttributeMemoryPoolsSupported,
+                                   deviceId));
+    HIPCHECK(hipStreamCreateWithFlags(&streamA_, hipStreamNonBlocking));
+    HIPCHECK(hipStreamCreateWithFlags(&streamB_, hipStreamNonBlocking));
+    HIPCHECK(hipEventCreateWithFlags(&event_, hipEventDisableTiming));
+  }
+
+  void close() override {
+    HIPCHECK(hipEventDestroy(event_));
+    HIPCHECK(hipStreamDestroy(streamB_));
+    HIPCHECK(hipStreamDestroy(streamA_));
+  }
+
+  unsigned int numTests() override {
+    return sizes_.size() * (numReusePolicies * numOrderings + 1);
+  }
+
+  void run(unsigned int test) override {
+    size_t size = sizes_[test % sizes_.size()];
+    unsigned int kind = test / sizes_.size();
+    if (!supported_) {
+      printf("info: device %d has no memory pool support, skipping\n", deviceId_);
+      return;
+    }
+    if (kind == numReusePolicies * numOrderings) {
+      runTrim(test, size);
+    } else {
+      runReuse(test, size, reusePolicies[kind / numOrderings],
+               static_cast<Ordering>(kind % numOrderings));
+    }
+  }
+
+ private:
+  // Caches everything freed, so only the reuse policy decides what is reused
+  hipMemPool_t createPool(const ReusePolicy& policy) {
+    hipMemPoolProps props = {};
+    props.allocType = hipMemAllocationTypePinned;
+    props.location.type = hipMemLocationTypeDevice;
+    props.location.id = deviceId_;
+    hipMemPool_t pool;
+    HIPCHECK(hipMemPoolCreate(&pool, &props));
+    uint64_t threshold = UINT64_MAX;
+    HIPCHECK(hipMemPoolSetAttribute(pool, hipMemPoolAttrReleaseThreshold, &threshold));
+    int value = policy.followEvents;
+    HIPCHECK(hipMemPoolSetAttribute(pool, hipMemPoolReuseFollowEventDependencies, &value));
+    value = policy.opportunistic;
+    HIPCHECK(hipMemPoolSetAttribute(pool, hipMemPoolReuseAllowOpportunistic, &value));
+    value = policy.internalDeps;
+    HIPCHECK(hipMemPoolSetAttribute(pool, hipMemPoolReuseAllowInternalDependencies, &value));
+    return pool;
+  }
+
+  void runReuse(unsigned int test, size_t size, const ReusePolicy& policy, Ordering ordering) {
+    hipMemPool_t pool = createPool(policy);
+    unsigned long long reused = 0, total = 0;
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < pairs_; i++) {
+        void* a = nullptr;
+        void* b = nullptr;
+        HIPCHECK(hipMallocFromPoolAsync(&a, size, pool, streamA_));
+        HIPCHECK(hipMemsetAsync(a, 1, size, streamA_));
+        HIPCHECK(hipFreeAsync(a, streamA_));
+        if (ordering == orderEvent) {
+          HIPCHECK(hipEventRecord(event_, streamA_));
+          HIPCHECK(hipStreamWaitEvent(streamB_, event_, 0));
+        }
+        HIPCHECK(hipMallocFromPoolAsync(&b, size, pool, streamB_));
+        HIPCHECK(hipMemsetAsync(b, 2, size, streamB_));
+        HIPCHECK(hipFreeAsync(b, streamB_));
+        reused += a == b;
+        total++;
+      }
+      HIPCHECK(hipStreamSynchronize(streamA_));
+      HIPCHECK(hipStreamSynchronize(streamB_));
+    });
+    uint64_t reservedHigh = 0;
+    HIPCHECK(hipMemPoolGetAttribute(pool, hipMemPoolAttrReservedMemHigh, &reservedHigh));
+    HIPCHECK(hipMemPoolDestroy(pool));
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-13s %s", policy.name, orderingStr[ordering]);
+    report(test, desc, size, pairs_, "us", HipPerf::toMicroseconds(sec, pairs_));
+    report(test, desc, size, pairs_, "% reused", {100.0 * reused / total});
+    report(test, desc, size, pairs_, "MB reserved", {reservedHigh / 1048576.0});
+  }
+
+  void runTrim(unsigned int test, size_t size) {
+    if (size * trimBlocks > props_.totalGlobalMem / 4) {
+      printf("info: %u blocks of %zu bytes exceed a quarter of device memory, skipping trim\n",
+             trimBlocks, size);
+      return;
+    }
+    hipMemPool_t pool = createPool(reusePolicies[numReusePolicies - 1]);
+    std::vector<void*> blocks(trimBlocks);
+    auto allocateAll = [&]() {
+      for (auto& block : blocks) {
+        HIPCHECK(hipMallocFromPoolAsync(&block, size, pool, streamA_));
+      }
+      HIPCHECK(hipStreamSynchronize(streamA_));
+    };
+    auto freeAll = [&]() {
+      for (auto block : blocks) {
+        HIPCHECK(hipFreeAsync(block, streamA_));
+      }
+      HIPCHECK(hipStreamSynchronize(streamA_));
+    };
+    auto elapsed = [](const std::chrono::steady_clock::time_point& start) {
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // Trimming is destructive, so every sample sets the cache up again untimed
+    std::vector<double> trim, afterTrim, warm;
+    for (unsigned int i = 0; i < p_warmup + p_repetitions; i++) {
+      allocateAll();
+      freeAll();
+      auto start = std::chrono::steady_clock::now();
+      HIPCHECK(hipMemPoolTrimTo(pool, 0));
+      double trimSec = elapsed(start);
+      start = std::chrono::steady_clock::now();
+      allocateAll();
+      double afterTrimSec = elapsed(start);
+      freeAll();
+      start = std::chrono::steady_clock::now();
+      allocateAll();
+      double warmSec = elapsed(start);
+      freeAll();
+      if (i >= p_warmup) {
+        trim.push_back(trimSec);
+        afterTrim.push_back(afterTrimSec);
+        warm.push_back(warmSec);
+      }
+    }
+    HIPCHECK(hipMemPoolDestroy(pool));
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "hipMemPoolTrimTo(0) of %u blocks", trimBlocks);
+    report(test, desc, size, 1, "us", HipPerf::toMicroseconds(trim, 1));
+    snprintf(desc, sizeof(desc), "alloc %u blocks after trim", trimBlocks);
+    report(test, desc, size, trimBlocks, "us", HipPerf::toMicroseconds(afterTrim, trimBlocks));
+    snprintf(desc, sizeof(desc), "alloc %u blocks from cache", trimBlocks);
+    report(test, desc, size, trimBlocks, "us", HipPerf::toMicroseconds(warm, trimBlocks));
+  }
+
+  std::vector<size_t> sizes_;
+  unsigned int pairs_;  // per repetition
+  int supported_;
+  hipStream_t streamA_;
+  hipStream_t streamB_;
+  hipEvent_t event_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfMemPoolReuse)
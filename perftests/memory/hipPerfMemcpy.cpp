@@ -18,14 +18,13 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
  * TEST: %t
  * HIT_END
  */
 
-#include "test_common.h"
+#include "perf_harness.h"
 #include <iostream>
-#include <chrono>
 
 #define NUM_SIZE 8
 #define NUM_ITER 0x40000
@@ -33,7 +32,7 @@
 
 using namespace std;
 
-class hipPerfMemcpy {
+class hipPerfMemcpy : public HipPerf::Benchmark {
   private:
     unsigned int numBuffers_;
     size_t totalSizes_[NUM_SIZE];
@@ -41,11 +40,11 @@ class hipPerfMemcpy {
   public:
     hipPerfMemcpy();
     ~hipPerfMemcpy() {};
-    void open(int deviceID);
-    void run(unsigned int testNumber);
+    unsigned int numTests() override { return NUM_SIZE; }
+    void run(unsigned int testNumber) override;
 };
 
-hipPerfMemcpy::hipPerfMemcpy() : numBuffers_(0) {
+hipPerfMemcpy::hipPerfMemcpy() : HipPerf::Benchmark("hipPerfMemcpy"), numBuffers_(0) {
   for (int i = 0; i < NUM_SIZE; i++) {
     totalSizes_[i] = 1 << (i + 6);
   }
@@ -58,57 +57,23 @@ void hipPerfMemcpy::setHostBuffer(int *A, int val, size_t size) {
   }
 }
 
-void hipPerfMemcpy::open(int deviceId) {
-  int nGpu = 0;
-  HIPCHECK(hipGetDeviceCount(&nGpu));
-  if (nGpu < 1) {
-    failed("No GPU!");
-  }
-
-  HIPCHECK(hipSetDevice(deviceId));
-  hipDeviceProp_t props = {0};
-  HIPCHECK(hipGetDeviceProperties(&props, deviceId));
-  std::cout << "info: running on bus " << "0x" << props.pciBusID << " " << props.name
-    << " with " << props.multiProcessorCount << " CUs" << " and device id: " << deviceId  << std::endl;
-}
-
 void hipPerfMemcpy::run(unsigned int testNumber) {
   int *A, *Ad;
   A = new int[totalSizes_[testNumber]];
   setHostBuffer(A, 1, totalSizes_[testNumber]);
-  hipMalloc(&Ad, totalSizes_[testNumber]);
-
-  auto start = chrono::steady_clock::now();
-
-  for (int j = 0; j < NUM_ITER; j++) {
-    hipMemcpy(Ad, A, totalSizes_[testNumber], hipMemcpyHostToDevice);
-  }
-
-  hipDeviceSynchronize();
+  HIPCHECK(hipMalloc(&Ad, totalSizes_[testNumber]));
 
-  auto end = chrono::steady_clock::now();
-  chrono::duration<double, micro> diff = end - start;
+  // Small copies are latency bound, so every copy is a sample of its own
+  auto sec = measureEach([&]() {
+    HIPCHECK(hipMemcpy(Ad, A, totalSizes_[testNumber], hipMemcpyHostToDevice));
+  }, NUM_ITER);
 
-  cout << "hipPerfMemcpy[" << testNumber << "] " << "Host to Device copy took "
-      << diff.count() / NUM_ITER << " us for memory size of " << totalSizes_[testNumber]
-      << " Bytes" << endl;
+  report(testNumber, "Host to Device hipMemcpy", totalSizes_[testNumber], NUM_ITER, "us",
+         HipPerf::toMicroseconds(sec, 1));
 
   delete [] A;
   HIPCHECK(hipFree(Ad));
 
 }
 
-
-int main() {
-  hipPerfMemcpy hipPerfMemcpy;
-
-  int deviceId = 0;
-  hipPerfMemcpy.open(deviceId);
-
-  for (auto testCase = 0; testCase < NUM_SIZE; testCase++) {
-    hipPerfMemcpy.run(testCase);
-  }
-
-  passed();
-
-}
+HIP_PERF_BENCHMARK(hipPerfMemcpy)
@@ -0,0 +1,167 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Concurrent host to device and device to host copies from 1 to N host
+// threads, the way many request threads each move a small buffer. Every
+// thread owns a pinned host buffer and a device buffer and issues
+// hipMemcpyAsync followed by a stream synchronize, back to back, on its own
+// stream, on the shared null stream or on hipStreamPerThread. Reported are
+// the bandwidth of all threads together and the latency of every single copy,
+// whose percentiles show how much the threads wait for each other. Thread
+// counts double up to the number of host cores (at most 64).
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum StreamMode { streamOwn, streamNull, streamPerThread, numStreamModes };
+static const char* streamModeStr[] = {"own stream", "null stream", "hipStreamPerThread"};
+
+enum Direction { dirH2D, dirD2H, numDirections };
+static const char* directionStr[] = {"H2D", "D2H"};
+
+static const size_t defaultSizes[] = {4 * 1024, 64 * 1024, 1024 * 1024};
+
+static const unsigned int copiesPerThread = 500;
+static const unsigned int maxThreads = 64;
+
+class hipPerfMemcpyThreads : public HipPerf::Benchmark {
+ public:
+  hipPerfMemcpyThreads() : HipPerf::Benchmark("hipPerfMemcpyThreads"),
+      copies_(HipPerf::iterationCount(copiesPerThread)) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    sizes_ = HipPerf::sweepSizes(std::vector<size_t>(std::begin(defaultSizes),
+                                                     std::end(defaultSizes)));
+    unsigned int cores = std::max(1u, std::min(std::thread::hardware_concurrency(), maxThreads));
+    for (unsigned int t = 1; t <= cores; t *= 2) {
+      threadCounts_.push_back(t);
+    }
+    if (threadCounts_.back() != cores) {
+      threadCounts_.push_back(cores);
+    }
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(sizes_.size() * threadCounts_.size()) * numStreamModes *
+        numDirections;
+  }
+
+  void run(unsigned int test) override {
+    Direction dir = static_cast<Direction>(test % numDirections);
+    StreamMode mode = static_cast<StreamMode>(test / numDirections % numStreamModes);
+    unsigned int rest = test / numDirections / numStreamModes;
+    unsigned int threads = threadCounts_[rest % threadCounts_.size()];
+    size_t size = sizes_[rest / threadCounts_.size()];
+
+    std::vector<void*> host(threads);
+    std::vector<void*> device(threads);
+    std::vector<hipStream_t> streams(threads, nullptr);
+    for (unsigned int t = 0; t < threads; t++) {
+      HIPCHECK(hipHostMalloc(&host[t], size));
+      HIPCHECK(hipMalloc(&device[t], size));
+      HIPCHECK(hipMemset(device[t], 0, size));
+      memset(host[t], 1, size);
+      if (mode == streamOwn) {
+        HIPCHECK(hipStreamCreateWithFlags(&streams[t], hipStreamNonBlocking));
+      } else if (mode == streamPerThread) {
+        streams[t] = hipStreamPerThread;
+      }
+    }
+    HIPCHECK(hipDeviceSynchronize());
+
+    std::vector<double> gbPerSec;
+    std::vector<double> copyUs;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      std::vector<std::vector<double>> threadUs(threads);
+      std::atomic<unsigned int> ready(0);
+      std::atomic<bool> go(false);
+      std::vector<std::thread> workers;
+      for (unsigned int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+          HIPCHECK(hipSetDevice(deviceId_));
+          threadUs[t].reserve(copies_);
+          void* dst = dir == dirH2D ? device[t] : host[t];
+          void* src = dir == dirH2D ? host[t] : device[t];
+          hipMemcpyKind kind = dir == dirH2D ? hipMemcpyHostToDevice : hipMemcpyDeviceToHost;
+          ready++;
+          while (!go.load()) {
+          }
+          for (unsigned int c = 0; c < copies_; c++) {
+            auto start = std::chrono::steady_clock::now();
+            HIPCHECK(hipMemcpyAsync(dst, src, size, kind, streams[t]));
+            HIPCHECK(hipStreamSynchronize(streams[t]));
+            threadUs[t].push_back(std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count());
+          }
+        });
+      }
+      while (ready.load() < threads) {
+      }
+      auto start = std::chrono::steady_clock::now();
+      go = true;
+      for (auto& worker : workers) {
+        worker.join();
+      }
+      double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                       .count();
+      if (r >= p_warmup) {
+        gbPerSec.push_back(static_cast<double>(size) * threads * copies_ / sec / 1e9);
+        for (unsigned int t = 0; t < threads; t++) {
+          copyUs.insert(copyUs.end(), threadUs[t].begin(), threadUs[t].end());
+        }
+      }
+    }
+
+    for (unsigned int t = 0; t < threads; t++) {
+      if (mode == streamOwn) {
+        HIPCHECK(hipStreamDestroy(streams[t]));
+      }
+      HIPCHECK(hipHostFree(host[t]));
+      HIPCHECK(hipFree(device[t]));
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %2u threads %s", directionStr[dir], threads,
+             streamModeStr[mode]);
+    report(test, desc, size, threads * copies_, "GB/s", gbPerSec);
+    report(test, std::string(desc) + " copy latency", size, threads * copies_, "us", copyUs);
+  }
+
+ private:
+  unsigned int copies_;
+  std::vector<size_t> sizes_;
+  std::vector<unsigned int> threadCounts_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfMemcpyThreads)
@@ -0,0 +1,205 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD_CMD: hipPerfMemoryGrain %hc -I%S/../../src %S/%s %S/../../src/test_common.cpp %S/../../src/timer.cpp %S/../../src/perf_harness.cpp %S/../../src/perf_main.cpp -o %T/%t EXCLUDE_HIP_PLATFORM nvidia
+ * TEST: %t
+ * HIT_END
+ */
+
+// Bulk throughput of fine-grained and uncached device memory against default
+// (coarse-grained) hipMalloc memory. For each allocation kind a device filling
+// grid-stride kernel reads a 256 MB buffer with 16 byte loads, writes it with
+// 16 byte stores and does one atomicAdd per 4 byte word; through the large
+// BAR the host reads and writes a 16 MB buffer with 8 byte loads and stores.
+// Reported are GB/s (Gatomics/s for atomics) and the ratio to the default
+// allocation for the same access. Host access is skipped without a large BAR.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum GrainKind { grainDefault = 0, grainFine, grainUncached, numGrainKinds };
+static const char* grainKindStr[numGrainKinds] = {"hipMalloc", "fine-grained", "uncached"};
+static const unsigned int grainFlags[numGrainKinds] = {hipDeviceMallocDefault,
+                                                       hipDeviceMallocFinegrained,
+                                                       hipDeviceMallocUncached};
+
+enum GrainAccess {
+  accessKernelRead = 0,
+  accessKernelWrite,
+  accessKernelAtomic,
+  accessHostRead,
+  accessHostWrite,
+  numGrainAccesses
+};
+static const char* grainAccessStr[numGrainAccesses] = {
+    "kernel read", "kernel write", "kernel atomicAdd", "host read", "host write"};
+
+static const size_t kernelBytes = 256 * 1024 * 1024;
+static const size_t hostBytes = 16 * 1024 * 1024;
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+
+__global__ void grainRead(const uint4* in, size_t count, unsigned int* out) {
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  unsigned int sum = 0;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < count;
+       i += stride) {
+    uint4 v = in[i];
+    sum += v.x ^ v.y ^ v.z ^ v.w;
+  }
+  out[blockIdx.x * blockDim.x + threadIdx.x] = sum;
+}
+
+__global__ void grainWrite(uint4* out, size_t count, unsigned int value) {
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < count;
+       i += stride) {
+    out[i] = make_uint4(value, value, value, value);
+  }
+}
+
+__global__ void grainAtomic(unsigned int* data, size_t count) {
+  size_t stride = static_cast<size_t>(gridDim.x) * blockDim.x;
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < count;
+       i += stride) {
+    atomicAdd(&data[i], 1u);
+  }
+}
+
+class hipPerfMemoryGrain : public HipPerf::Benchmark {
+ public:
+  hipPerfMemoryGrain() : HipPerf::Benchmark("hipPerfMemoryGrain"), host_(nullptr),
+      sums_(nullptr) {
+    for (auto& buffer : buffers_) {
+      buffer = nullptr;
+    }
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    for (int k = 0; k < numGrainKinds; k++) {
+      HIPCHECK(hipExtMallocWithFlags(&buffers_[k], kernelBytes, grainFlags[k]));
+      HIPCHECK(hipMemset(buffers_[k], 0, kernelBytes));
+    }
+    HIPCHECK(hipMalloc(&sums_, static_cast<size_t>(grid_.x) * blockSize * sizeof(unsigned int)));
+    host_ = new uint64_t[hostBytes / sizeof(uint64_t)]();
+    reference_.assign(numGrainAccesses, 0);
+    if (!props_.isLargeBar) {
+      printf("info: device %d has no large BAR, host access is not measured\n", deviceId);
+    }
+  }
+
+  void close() override {
+    for (auto& buffer : buffers_) {
+      HIPCHECK(hipFree(buffer));
+    }
+    HIPCHECK(hipFree(sums_));
+    delete[] host_;
+  }
+
+  unsigned int numTests() override { return numGrainKinds * numGrainAccesses; }
+
+  void run(unsigned int test) override {
+    GrainKind kind = static_cast<GrainKind>(test % numGrainKinds);
+    GrainAccess access = static_cast<GrainAccess>(test / numGrainKinds);
+    bool host = access == accessHostRead || access == accessHostWrite;
+    if (host && !props_.isLargeBar) {
+      return;
+    }
+
+    void* buffer = buffers_[kind];
+    size_t bytes = host ? hostBytes : kernelBytes;
+    size_t vectors = bytes / sizeof(uint4);
+    size_t words = bytes / sizeof(uint64_t);
+    HIPCHECK(hipDeviceSynchronize());
+    auto sec = measure([&]() {
+      switch (access) {
+        case accessKernelRead:
+          hipLaunchKernelGGL(grainRead, grid_, dim3(blockSize), 0, 0,
+                             static_cast<const uint4*>(buffer), vectors, sums_);
+          break;
+        case accessKernelWrite:
+          hipLaunchKernelGGL(grainWrite, grid_, dim3(blockSize), 0, 0,
+                             static_cast<uint4*>(buffer), vectors, 1u);
+          break;
+        case accessKernelAtomic:
+          hipLaunchKernelGGL(grainAtomic, grid_, dim3(blockSize), 0, 0,
+                             static_cast<unsigned int*>(buffer), bytes / sizeof(unsigned int));
+          break;
+        case accessHostRead: {
+          const volatile uint64_t* src = static_cast<const volatile uint64_t*>(buffer);
+          for (size_t i = 0; i < words; i++) {
+            host_[i] = src[i];
+          }
+          break;
+        }
+        default: {
+          volatile uint64_t* dst = static_cast<volatile uint64_t*>(buffer);
+          for (size_t i = 0; i < words; i++) {
+            dst[i] = i;
+          }
+          break;
+        }
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    std::string desc = std::string(grainAccessStr[access]) + " " + grainKindStr[kind];
+    std::vector<double> rate;
+    const char* unit = "GB/s";
+    if (access == accessKernelAtomic) {
+      rate = HipPerf::toBandwidth(sec, static_cast<double>(bytes / sizeof(unsigned int)));
+      unit = "Gatomics/s";
+    } else {
+      rate = HipPerf::toBandwidth(sec, static_cast<double>(bytes));
+    }
+    report(test, desc, bytes, 1, unit, rate);
+
+    // Default allocations run first for every access and are the reference
+    std::vector<double> sorted(rate);
+    std::sort(sorted.begin(), sorted.end());
+    if (kind == grainDefault) {
+      reference_[access] = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    } else if (reference_[access] > 0) {
+      std::vector<double> ratio;
+      for (double r : rate) {
+        ratio.push_back(r / reference_[access]);
+      }
+      report(test, desc + " vs hipMalloc", bytes, 1, "x", ratio);
+    }
+  }
+
+ private:
+  void* buffers_[numGrainKinds];
+  uint64_t* host_;  // destination of host reads
+  unsigned int* sums_;
+  dim3 grid_;
+  std::vector<double> reference_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfMemoryGrain)
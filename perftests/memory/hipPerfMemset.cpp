@@ -18,14 +18,14 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
  * TEST: %t
  * HIT_END
  */
 
-#include "test_common.h"
+#include "perf_harness.h"
 #include <iostream>
-#include <chrono>
+#include <string.h>
 
 static size_t typeSizeList[] = {
   1, 2, 4, 8, 16, 32, 64, 128,
@@ -46,8 +46,41 @@ int16_t memsetD16val = 0xDEAD;
 int memsetD32val = 0xDEADBEEF;
 }dataType;
 
+// Start offsets in bytes for the alignment sweep; D16/D32 and the 32-bit
+// fill kernel only run at offsets that are a multiple of their element size.
+static size_t offsetList[] = {
+  0, 1, 2, 4, 16, 64, 256, 4096,
+};
+
+// Row widths in bytes for the pitched sweep, deliberately not a multiple of 4.
+static size_t oddWidthList[] = {
+  255, 1023, 4097, 8191,
+};
+
+#define ALIGN_BUF_SIZE (64 * 1024 * 1024)
+#define ODD_HEIGHT 1024
+
 #define NUM_ITER 100
 
+// Same fill as vec_fill in hipPerfMemFill.cpp, with a constant value.
+template<typename T>
+__global__ void vec_fill(T *x, T coef, size_t N) {
+  const size_t istart = threadIdx.x + blockIdx.x * blockDim.x;
+  const size_t ishift = blockDim.x * gridDim.x;
+  for (size_t i = istart; i < N; i += ishift) {
+    x[i] = coef;
+  }
+}
+
+__global__ void vec_fill2D(char *x, size_t pitch, char coef, size_t width, size_t height) {
+  for (size_t row = blockIdx.x; row < height; row += gridDim.x) {
+    char *line = x + row * pitch;
+    for (size_t i = threadIdx.x; i < width; i += blockDim.x) {
+      line[i] = coef;
+    }
+  }
+}
+
 enum MemsetType {
   hipMemsetTypeDefault,
   hipMemsetTypeD8,
@@ -55,9 +88,16 @@ enum MemsetType {
   hipMemsetTypeD32
 };
 
+// Fill paths compared by the alignment and odd width sweeps
+enum FillMethod { fillMemset = 0, fillD16, fillD32, fillKernel8, fillKernel32, NUM_FILL_METHODS };
+static const char* fillMethodStr[NUM_FILL_METHODS] = {"hipMemsetAsync", "hipMemsetD16Async",
+                                                      "hipMemsetD32Async", "vec_fill<char>",
+                                                      "vec_fill<uint>"};
+static const size_t fillElementSize[NUM_FILL_METHODS] = {1, 2, 4, 1, 4};
+
 using namespace std;
 
-class hipPerfMemset {
+class hipPerfMemset : public HipPerf::Benchmark {
   private:
     unsigned int bufSize_;
     unsigned int num_typeSize_;
@@ -69,8 +109,33 @@ class hipPerfMemset {
     unsigned int _numSubTests3D = 0;
     unsigned int num_sizes_ =0;
 
+    unsigned int num_offsets_ = 0;
+    unsigned int num_widths_ = 0;
+
+    struct AlignTest {
+      FillMethod method;
+      size_t offset;
+    };
+    std::vector<AlignTest> alignTests_;  // valid (method, offset) pairs in test order
+
+    dataType pattern_;
+    unsigned int test_ = 0;  // harness test index, run1D/2D/3D get the index within their group
+
+    static const char* apiName(enum MemsetType type, bool async) {
+      switch (type) {
+        case hipMemsetTypeD8:
+          return async ? "hipMemsetD8Async" : "hipMemsetD8";
+        case hipMemsetTypeD16:
+          return async ? "hipMemsetD16Async" : "hipMemsetD16";
+        case hipMemsetTypeD32:
+          return async ? "hipMemsetD32Async" : "hipMemsetD32";
+        default:
+          return async ? "hipMemsetAsync" : "hipMemset";
+      }
+    }
+
   public:
-    hipPerfMemset() {
+    hipPerfMemset() : HipPerf::Benchmark("hipPerfMemset") {
     num_typeSize_ = sizeof(typeSizeList) / sizeof(size_t);
     num_elements_ = sizeof(eleNumList) / sizeof(unsigned int);
     _numSubTests = num_elements_ * num_typeSize_;
@@ -78,11 +143,28 @@ class hipPerfMemset {
     num_sizes_ = sizeof(sizeList) / sizeof(unsigned int);
     _numSubTests2D = num_sizes_;
     _numSubTests3D = _numSubTests2D;
+
+    num_offsets_ = sizeof(offsetList) / sizeof(size_t);
+    num_widths_ = sizeof(oddWidthList) / sizeof(size_t);
+    for (unsigned int m = 0; m < NUM_FILL_METHODS; m++) {
+      for (unsigned int i = 0; i < num_offsets_; i++) {
+        if (offsetList[i] % fillElementSize[m] == 0) {
+          alignTests_.push_back({static_cast<FillMethod>(m), offsetList[i]});
+        }
+      }
+    }
     };
 
     ~hipPerfMemset() {};
 
-    void open(int deviceID);
+    // 1D, 2D and 3D tests, each first synchronous then async, followed by the
+    // alignment sweep and the odd width 2D sweep (hipMemset2DAsync, then kernel)
+    unsigned int numTests() override {
+      return 2 * (_numSubTests + _numSubTests2D + _numSubTests3D) + alignTests_.size() +
+             2 * num_widths_;
+    }
+
+    void run(unsigned int test) override;
 
     template<typename T>
     void run1D(unsigned int test, T memsetval, enum MemsetType type, bool async);
@@ -93,6 +175,14 @@ class hipPerfMemset {
     template<typename T>
     void run3D(unsigned int test, T memsetval, enum MemsetType type, bool async);
 
+    void runAlign(const AlignTest& alignTest);
+
+    void runOddWidth(unsigned int test, bool kernel);
+
+    unsigned int fillBlocks() const {
+      return props_.multiProcessorCount * 8;
+    }
+
     uint getNumTests() {
       return _numSubTests;
     }
@@ -106,21 +196,6 @@ class hipPerfMemset {
 };
 
 
-void hipPerfMemset::open(int deviceId) {
-  int nGpu = 0;
-  HIPCHECK(hipGetDeviceCount(&nGpu));
-  if (nGpu < 1) {
-    failed("No GPU!");
-  }
-
-  HIPCHECK(hipSetDevice(deviceId));
-  hipDeviceProp_t props = {0};
-  HIPCHECK(hipGetDeviceProperties(&props, deviceId));
-  std::cout << "info: running on bus " << "0x" << props.pciBusID << " " << props.name
-            << " with " << props.multiProcessorCount << " CUs" << " and device id: " << deviceId
-            << std::endl;
-}
-
 template<typename T>
 void hipPerfMemset::run1D(unsigned int test, T memsetval, enum MemsetType type, bool async) {
 
@@ -139,11 +214,7 @@ void hipPerfMemset::run1D(unsigned int test, T memsetval, enum MemsetType type,
   hipStream_t stream;
   HIPCHECK(hipStreamCreate(&stream));
 
-  // Warm-up
-  HIPCHECK(hipMemset((void *)A_d, memsetval, bufSize_));
-
-  auto start = chrono::steady_clock::now();
-
+  auto sec = measure([&]() {
   for (uint i = 0; i < NUM_ITER; i++) {
     if (type == hipMemsetTypeDefault && !async) {
       HIPCHECK(hipMemset((void *)A_d, memsetval, bufSize_));
@@ -155,25 +226,24 @@ void hipPerfMemset::run1D(unsigned int test, T memsetval, enum MemsetType type,
       HIPCHECK(hipMemsetD8((hipDeviceptr_t)A_d, memsetval, bufSize_));
     }
     else if (type == hipMemsetTypeD8 && async) {
-      HIPCHECK(hipMemsetD8Async((hipDeviceptr_t)A_d, memsetval, bufSize_));
+      HIPCHECK(hipMemsetD8Async((hipDeviceptr_t)A_d, memsetval, bufSize_, stream));
     }
     else if (type == hipMemsetTypeD16 && !async) {
       HIPCHECK(hipMemsetD16((hipDeviceptr_t)A_d, memsetval, bufSize_/sizeof(T)));
     }
     else if (type == hipMemsetTypeD16 && async) {
-      HIPCHECK(hipMemsetD16Async((hipDeviceptr_t)A_d, memsetval, bufSize_/sizeof(T)));
+      HIPCHECK(hipMemsetD16Async((hipDeviceptr_t)A_d, memsetval, bufSize_/sizeof(T), stream));
     }
     else if (type == hipMemsetTypeD32 && !async) {
       HIPCHECK(hipMemsetD32((hipDeviceptr_t)A_d, memsetval, bufSize_/sizeof(T)));
     }
     else if (type == hipMemsetTypeD32 && async) {
-      HIPCHECK(hipMemsetD32Async((hipDeviceptr_t)A_d, memsetval, bufSize_/sizeof(T)));
+      HIPCHECK(hipMemsetD32Async((hipDeviceptr_t)A_d, memsetval, bufSize_/sizeof(T), stream));
     }
   }
 
   HIPCHECK(hipDeviceSynchronize());
-
-  auto end = chrono::steady_clock::now();
+  });
 
   HIPCHECK(hipMemcpy(A_h, A_d, bufSize_, hipMemcpyDeviceToHost) );
 
@@ -185,17 +255,13 @@ void hipPerfMemset::run1D(unsigned int test, T memsetval, enum MemsetType type,
     }
   }
 
+  HIPCHECK(hipStreamDestroy(stream));
   HIPCHECK(hipFree(A_d));
   free(A_h);
 
-  chrono::duration<double> diff = end - start;
-
-  auto sec = diff.count();
-
-  auto perf = static_cast<double>((bufSize_ * NUM_ITER * (double)(1e-09)) / sec);
-
-  cout <<  " hipPerf1DMemset[" << test << "] " << (int)bufSize_/1024 << " Kb " << setw(4)
-       << " typeSize " << (int) testTypeSize_ << ":" << setw(5) << perf <<  " GB/s " <<endl;
+  report(test_, std::string("1D ") + apiName(type, async) + " typeSize " +
+         std::to_string(sizeof(T)), bufSize_, NUM_ITER, "GB/s",
+         HipPerf::toBandwidth(sec, (double)bufSize_ * NUM_ITER));
 }
 
 template<typename T>
@@ -224,12 +290,7 @@ void hipPerfMemset::run2D(unsigned int test, T memsetval, enum MemsetType type,
   hipStream_t stream;
   HIPCHECK(hipStreamCreate(&stream));
 
-  // Warm-up
-  HIPCHECK(hipMemset2D(A_d, pitch_A, memsetval, numW, numH));
-
-
-  auto start = chrono::steady_clock::now();
-
+  auto sec = measure([&]() {
   for (uint i = 0; i < NUM_ITER; i++) {
     if (type == hipMemsetTypeDefault && !async) {
     HIPCHECK(hipMemset2D(A_d, pitch_A, memsetval, numW, numH));
@@ -240,8 +301,7 @@ void hipPerfMemset::run2D(unsigned int test, T memsetval, enum MemsetType type,
   }
 
   HIPCHECK(hipStreamSynchronize(stream));
-
-  auto end = chrono::steady_clock::now();
+  });
 
   HIPCHECK(hipMemcpy2D(A_h, width, A_d, pitch_A, numW, numH,
                        hipMemcpyDeviceToHost));
@@ -254,14 +314,9 @@ void hipPerfMemset::run2D(unsigned int test, T memsetval, enum MemsetType type,
     }
   }
 
-  chrono::duration<double> diff = end - start;
-
-  auto sec = diff.count();
-
-  auto perf = static_cast<double>((sizeElements* NUM_ITER * (double)(1e-09)) / sec);
-
-  cout << " hipPerf2DMemset[" << test << "] " <<"  " << "(GB/s) for " << (int)bufSize_
-       << " x " << bufSize_ << " bytes : " << setw(5)<< perf <<  endl;
+  report(test_, std::string("2D ") + (async ? "hipMemset2DAsync " : "hipMemset2D ") +
+         std::to_string(bufSize_) + " x " + std::to_string(bufSize_), sizeElements, NUM_ITER,
+         "GB/s", HipPerf::toBandwidth(sec, (double)sizeElements * NUM_ITER));
 
   HIPCHECK(hipStreamDestroy(stream));
   HIPCHECK(hipFree(A_d));
@@ -296,11 +351,7 @@ void hipPerfMemset::run3D(unsigned int test, T memsetval, enum MemsetType type,
         A_h[i] = 1;
     }
 
-   // Warm up
-   HIPCHECK(hipMemset3D( devPitchedPtr, memsetval, extent));
-
-   auto start = chrono::steady_clock::now();
-
+   auto sec = measure([&]() {
    for (uint i = 0; i < NUM_ITER; i++) {
      if (type == hipMemsetTypeDefault && !async) {
        HIPCHECK(hipMemset3D( devPitchedPtr, memsetval, extent));
@@ -311,8 +362,7 @@ void hipPerfMemset::run3D(unsigned int test, T memsetval, enum MemsetType type,
    }
 
   HIPCHECK(hipStreamSynchronize(stream));
-
-  auto end = chrono::steady_clock::now();
+  });
 
   hipMemcpy3DParms myparms = {0};
   myparms.srcPos = make_hipPos(0,0,0);
@@ -333,97 +383,162 @@ void hipPerfMemset::run3D(unsigned int test, T memsetval, enum MemsetType type,
       }
   }
 
-  chrono::duration<double> diff = end - start;
-
-  auto sec = diff.count();
-
-  auto perf = static_cast<double>((sizeElements * NUM_ITER * (double)(1e-09)) / sec);
-
-  cout << " hipPerf3DMemset[" << test << "] " <<"  " << "(GB/s) for " << (int)bufSize_
-       << " x " << bufSize_  << " x " <<depth << " bytes : " << setw(5) << perf <<  endl;
+  report(test_, std::string("3D ") + (async ? "hipMemset3DAsync " : "hipMemset3D ") +
+         std::to_string(bufSize_) + " x " + std::to_string(bufSize_) + " x " +
+         std::to_string(depth), sizeElements, NUM_ITER, "GB/s",
+         HipPerf::toBandwidth(sec, (double)sizeElements * NUM_ITER));
+  HIPCHECK(hipStreamDestroy(stream));
   HIPCHECK(hipFree(devPitchedPtr.ptr));
   free(A_h);
 }
 
-int main() {
-  hipPerfMemset hipPerfMemset;
+void hipPerfMemset::runAlign(const AlignTest& alignTest) {
+  FillMethod method = alignTest.method;
+  size_t offset = alignTest.offset;
+  size_t elementSize = fillElementSize[method];
+  // Same byte count at every offset so the results line up
+  size_t bytes = ALIGN_BUF_SIZE;
+  size_t count = bytes / elementSize;
 
-  dataType pattern;
-  int deviceId = 0;
-  hipPerfMemset.open(deviceId);
-  MemsetType type;
+  char *base;
+  HIPCHECK(hipMalloc(&base, bytes + offsetList[num_offsets_ - 1]));
+  HIPCHECK(hipMemset(base, 0, bytes + offsetList[num_offsets_ - 1]));
+  char *dst = base + offset;
 
-  int numTests = hipPerfMemset.getNumTests();
-  int numTests2D = hipPerfMemset.getNumTests2D();
-  int numTests3D = hipPerfMemset.getNumTests3D();
+  // Every path writes the same little-endian byte pattern of its element size
+  uint32_t value = (elementSize == 1) ? 0x42 : (elementSize == 2) ? 0xDEAD : 0xDEADBEEF;
 
-  bool async= false;
+  hipStream_t stream;
+  HIPCHECK(hipStreamCreate(&stream));
 
-  for (uint i = 0; i < 2 ; i++) {
-    cout << endl;
-    if (async) {
-      cout << "Perf of hipMemsetAsync for 1D arrays" << endl;;
+  auto sec = measure([&]() {
+    for (uint i = 0; i < NUM_ITER; i++) {
+      switch (method) {
+        case fillMemset:
+          HIPCHECK(hipMemsetAsync(dst, value, bytes, stream));
+          break;
+        case fillD16:
+          HIPCHECK(hipMemsetD16Async((hipDeviceptr_t)dst, value, count, stream));
+          break;
+        case fillD32:
+          HIPCHECK(hipMemsetD32Async((hipDeviceptr_t)dst, value, count, stream));
+          break;
+        case fillKernel8:
+          hipLaunchKernelGGL(HIP_KERNEL_NAME(vec_fill<char>), dim3(fillBlocks()), dim3(256), 0,
+                             stream, dst, static_cast<char>(value), count);
+          break;
+        default:
+          hipLaunchKernelGGL(HIP_KERNEL_NAME(vec_fill<uint32_t>), dim3(fillBlocks()), dim3(256),
+                             0, stream, reinterpret_cast<uint32_t*>(dst), value, count);
+          break;
+      }
     }
-    else {
-      cout << "Perf of hipMemset for 1D arrays" << endl;
+    HIPCHECK(hipStreamSynchronize(stream));
+  });
+
+  char *A_h = reinterpret_cast<char*>(malloc(bytes));
+  HIPASSERT(A_h != NULL);
+  HIPCHECK(hipMemcpy(A_h, dst, bytes, hipMemcpyDeviceToHost));
+  for (size_t i = 0; i < count; i++) {
+    if (memcmp(A_h + i * elementSize, &value, elementSize) != 0) {
+      failed("%s mismatch at offset %zu element %zu", fillMethodStr[method], offset, i);
     }
+  }
+  free(A_h);
 
-    for (auto testCase = 0; testCase < numTests; testCase++) {
-      if (testCase < 5) {
-        cout << "API: hipMemset ";
-        hipPerfMemset.run1D(testCase,pattern.memsetval, hipMemsetTypeDefault, async);
-      }
+  HIPCHECK(hipStreamDestroy(stream));
+  HIPCHECK(hipFree(base));
 
-      else if (testCase < 10) {
-        cout << "API: hipMemsetD16 ";
-        hipPerfMemset.run1D(testCase,pattern.memsetD16val, hipMemsetTypeD16, async);
-      }
+  report(test_, std::string("align ") + fillMethodStr[method] + " offset " +
+         std::to_string(offset), bytes, NUM_ITER, "GB/s",
+         HipPerf::toBandwidth(sec, (double)bytes * NUM_ITER));
+}
 
-      else if (testCase < 15) {
-        cout << "API: hipMemsetD32 ";
-        hipPerfMemset.run1D(testCase,pattern.memsetD32val, hipMemsetTypeD32, async);
-      }
+void hipPerfMemset::runOddWidth(unsigned int test, bool kernel) {
+  size_t width = oddWidthList[test % num_widths_];
+  size_t height = ODD_HEIGHT;
+  size_t pitch;
+  char memsetval = pattern_.memsetval;
+
+  char *A_d;
+  HIPCHECK(hipMallocPitch(reinterpret_cast<void**>(&A_d), &pitch, width, height));
+  HIPCHECK(hipMemset(A_d, 0, pitch * height));
+
+  hipStream_t stream;
+  HIPCHECK(hipStreamCreate(&stream));
 
-      else {
-        cout << "API: hipMemset ";
-        hipPerfMemset.run1D(testCase,pattern.memsetval, hipMemsetTypeDefault, async);
+  auto sec = measure([&]() {
+    for (uint i = 0; i < NUM_ITER; i++) {
+      if (kernel) {
+        hipLaunchKernelGGL(vec_fill2D, dim3(fillBlocks()), dim3(256), 0, stream, A_d, pitch,
+                           memsetval, width, height);
+      } else {
+        HIPCHECK(hipMemset2DAsync(A_d, pitch, memsetval, width, height, stream));
       }
     }
-    async = true;
+    HIPCHECK(hipStreamSynchronize(stream));
+  });
+
+  char *A_h = reinterpret_cast<char*>(malloc(width * height));
+  HIPASSERT(A_h != NULL);
+  HIPCHECK(hipMemcpy2D(A_h, width, A_d, pitch, width, height, hipMemcpyDeviceToHost));
+  for (size_t i = 0; i < width * height; i++) {
+    if (A_h[i] != memsetval) {
+      failed("odd width %zu mismatch at index %zu", width, i);
+    }
   }
+  free(A_h);
 
-  cout << endl;
+  HIPCHECK(hipStreamDestroy(stream));
+  HIPCHECK(hipFree(A_d));
 
-  for (uint i = 0; i < 2; i++) {
-    cout << endl;
-    if (async) {
-      cout << "Perf of hipMemset2DAsync for 2D arrays" << endl;;
-    }
-    else {
-      cout << "Perf of hipMemset2D for 2D arrays" << endl;
-    }
+  // Only the width * height bytes inside the pitch are written
+  size_t bytes = width * height;
+  report(test_, std::string("2D odd width ") + (kernel ? "vec_fill2D " : "hipMemset2DAsync ") +
+         std::to_string(width) + " x " + std::to_string(height) + " pitch " +
+         std::to_string(pitch), bytes, NUM_ITER, "GB/s",
+         HipPerf::toBandwidth(sec, (double)bytes * NUM_ITER));
+}
 
-    for (uint test = 0; test < numTests2D; test++) {
-      hipPerfMemset.run2D(test, pattern.memsetval, hipMemsetTypeDefault, async);
+void hipPerfMemset::run(unsigned int test) {
+  unsigned int numTests1D = getNumTests();
+  unsigned int numTests2D = getNumTests2D();
+  unsigned int numTests3D = getNumTests3D();
+  test_ = test;
+
+  if (test < 2 * numTests1D) {
+    bool async = test >= numTests1D;
+    unsigned int testCase = test % numTests1D;
+    if (testCase < 5 || testCase >= 15) {
+      run1D(testCase, pattern_.memsetval, hipMemsetTypeDefault, async);
+    } else if (testCase < 10) {
+      run1D(testCase, pattern_.memsetD16val, hipMemsetTypeD16, async);
+    } else {
+      run1D(testCase, pattern_.memsetD32val, hipMemsetTypeD32, async);
     }
-  async = false;
+    return;
   }
+  test -= 2 * numTests1D;
 
-  cout << endl;
+  if (test < 2 * numTests2D) {
+    run2D(test % numTests2D, pattern_.memsetval, hipMemsetTypeDefault, test >= numTests2D);
+    return;
+  }
+  test -= 2 * numTests2D;
 
-  for (uint i = 0; i < 2; i++) {
-    cout << endl;
-    if (async) {
-      cout << "Perf of hipMemset3DAsync for 3D arrays" << endl;;
-    }
-    else {
-      cout << "Perf of hipMemset3D for 3D arrays" << endl;
-    }
+  if (test < 2 * numTests3D) {
+    run3D(test % numTests3D, pattern_.memsetval, hipMemsetTypeDefault, test >= numTests3D);
+    return;
+  }
+  test -= 2 * numTests3D;
 
-    for (uint test =0; test < numTests3D; test++) {
-      hipPerfMemset.run3D(test, pattern.memsetval, hipMemsetTypeDefault, async);
-    }
+  if (test < alignTests_.size()) {
+    runAlign(alignTests_[test]);
+    return;
   }
+  test -= alignTests_.size();
 
-  passed();
+  runOddWidth(test, test >= num_widths_);
 }
+
+HIP_PERF_BENCHMARK(hipPerfMemset)
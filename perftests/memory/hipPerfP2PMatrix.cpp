@@ -0,0 +1,214 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// hipMemcpyPeerAsync bandwidth and latency for every ordered device pair,
+// with and without peer access enabled, unidirectional and bidirectional.
+// Every pair is reported individually; in text mode close() also prints the
+// NxN matrices for the smallest (latency) and largest (bandwidth) size.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "perf_harness.h"
+#include "../catch/include/hip_test_topology.hh"
+
+enum P2PMode { p2pUni = 0, p2pBidir, p2pUniPeer, p2pBidirPeer, numP2PModes };
+
+static const char* p2pModeStr[numP2PModes] = {"uni", "bidir", "uni peer", "bidir peer"};
+
+class hipPerfP2PMatrix : public HipPerf::Benchmark {
+ public:
+  hipPerfP2PMatrix() : HipPerf::Benchmark("hipPerfP2PMatrix"),
+      sizes_(HipPerf::sweepSizes({4, 4096, 1 << 20, 64 << 20})),
+      numIter_(HipPerf::iterationCount(100)), numGpus_(0) {
+    HIPCHECK(hipGetDeviceCount(&numGpus_));
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    streams_.resize(numGpus_);
+    for (int i = 0; i < numGpus_; i++) {
+      HIPCHECK(hipSetDevice(i));
+      HIPCHECK(hipStreamCreateWithFlags(&streams_[i], hipStreamNonBlocking));
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+    for (int m = 0; m < numP2PModes; m++) {
+      latency_[m].assign(numGpus_ * numGpus_, 0.0);
+      bandwidth_[m].assign(numGpus_ * numGpus_, 0.0);
+    }
+    printTopology();
+  }
+
+  void close() override {
+    for (int i = 0; i < numGpus_; i++) {
+      HIPCHECK(hipSetDevice(i));
+      HIPCHECK(hipStreamDestroy(streams_[i]));
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+    if (strcmp(p_format, "text") == 0) {
+      for (int m = 0; m < numP2PModes; m++) {
+        printMatrix(p2pModeStr[m], sizes_.front(), "us", latency_[m]);
+        if (sizes_.size() > 1) {
+          printMatrix(p2pModeStr[m], sizes_.back(), "GB/s", bandwidth_[m]);
+        }
+      }
+    }
+  }
+
+  unsigned int numTests() override {
+    return sizes_.size() * numP2PModes * numGpus_ * numGpus_;
+  }
+
+  void run(unsigned int test) override {
+    unsigned int pairs = numGpus_ * numGpus_;
+    int dst = test % numGpus_;
+    int src = (test / numGpus_) % numGpus_;
+    P2PMode mode = static_cast<P2PMode>((test / pairs) % numP2PModes);
+    size_t size = sizes_[test / (pairs * numP2PModes)];
+    bool bidir = mode == p2pBidir || mode == p2pBidirPeer;
+    bool peer = mode == p2pUniPeer || mode == p2pBidirPeer;
+
+    if (src == dst && (bidir || peer)) {
+      return;
+    }
+    if (peer && !enablePeers(src, dst)) {
+      printf("info: device %d and %d cannot access each other, skipping %s\n", src, dst,
+             p2pModeStr[mode]);
+      return;
+    }
+
+    void *srcBuf, *dstBuf;
+    HIPCHECK(hipSetDevice(src));
+    HIPCHECK(hipMalloc(&srcBuf, size));
+    HIPCHECK(hipMemset(srcBuf, 1, size));
+    HIPCHECK(hipSetDevice(dst));
+    HIPCHECK(hipMalloc(&dstBuf, size));
+    HIPCHECK(hipMemset(dstBuf, 2, size));
+    HIPCHECK(hipDeviceSynchronize());
+
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < numIter_; i++) {
+        HIPCHECK(hipMemcpyPeerAsync(dstBuf, dst, srcBuf, src, size, streams_[src]));
+        if (bidir) {
+          HIPCHECK(hipMemcpyPeerAsync(srcBuf, src, dstBuf, dst, size, streams_[dst]));
+        }
+      }
+      HIPCHECK(hipStreamSynchronize(streams_[src]));
+      HIPCHECK(hipStreamSynchronize(streams_[dst]));
+    });
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%d->%d %s", src, dst, p2pModeStr[mode]);
+    double bytes = static_cast<double>(size) * numIter_ * (bidir ? 2 : 1);
+    auto gbps = HipPerf::toBandwidth(sec, bytes);
+    auto us = HipPerf::toMicroseconds(sec, numIter_);
+    report(src, test, desc, size, numIter_, "GB/s", gbps);
+    report(src, test, desc, size, numIter_, "us", us);
+
+    if (size == sizes_.front()) {
+      latency_[mode][src * numGpus_ + dst] = ComputePerfStats(us).median;
+    }
+    if (size == sizes_.back()) {
+      bandwidth_[mode][src * numGpus_ + dst] = ComputePerfStats(gbps).median;
+    }
+
+    HIPCHECK(hipFree(dstBuf));
+    HIPCHECK(hipSetDevice(src));
+    HIPCHECK(hipFree(srcBuf));
+    if (peer) {
+      disablePeers(src, dst);
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+  }
+
+ private:
+  // Enables access in both directions, false when the pair has no P2P path.
+  bool enablePeers(int a, int b) {
+    int ab = 0, ba = 0;
+    HIPCHECK(hipDeviceCanAccessPeer(&ab, a, b));
+    HIPCHECK(hipDeviceCanAccessPeer(&ba, b, a));
+    if (!ab || !ba) {
+      return false;
+    }
+    HIPCHECK(hipSetDevice(a));
+    HIPCHECK(hipDeviceEnablePeerAccess(b, 0));
+    HIPCHECK(hipSetDevice(b));
+    HIPCHECK(hipDeviceEnablePeerAccess(a, 0));
+    return true;
+  }
+
+  void disablePeers(int a, int b) {
+    HIPCHECK(hipSetDevice(a));
+    HIPCHECK(hipDeviceDisablePeerAccess(b));
+    HIPCHECK(hipSetDevice(b));
+    HIPCHECK(hipDeviceDisablePeerAccess(a));
+  }
+
+  // Link of every pair, to tell the matrix entries apart by how the devices are connected
+  void printTopology() {
+    hip::DeviceTopology topology;
+    for (const auto& link : topology.rankedLinks()) {
+      printf("info: device %d->%d peer %s link type %s hops %s rank %s\n", link.src, link.dst,
+             link.peerAccess ? "yes" : "no", attrStr(link.linkType).c_str(),
+             attrStr(link.hopCount).c_str(), attrStr(link.performanceRank).c_str());
+    }
+  }
+
+  static std::string attrStr(uint32_t value) {
+    return value == hip::DeviceTopology::kUnknown ? "-" : std::to_string(value);
+  }
+
+  void printMatrix(const char* mode, size_t size, const char* unit,
+                   const std::vector<double>& values) {
+    printf("\n%s %zu bytes (%s), rows src, columns dst\n     ", mode, size, unit);
+    for (int d = 0; d < numGpus_; d++) {
+      printf("%9d", d);
+    }
+    printf("\n");
+    for (int s = 0; s < numGpus_; s++) {
+      printf("%4d ", s);
+      for (int d = 0; d < numGpus_; d++) {
+        double v = values[s * numGpus_ + d];
+        if (v > 0) {
+          printf("%9.2f", v);
+        } else {
+          printf("%9s", "-");
+        }
+      }
+      printf("\n");
+    }
+  }
+
+  std::vector<size_t> sizes_;
+  unsigned int numIter_;
+  int numGpus_;
+  std::vector<hipStream_t> streams_;
+  std::vector<double> latency_[numP2PModes];    // median us at the smallest size
+  std::vector<double> bandwidth_[numP2PModes];  // median GB/s at the largest size
+};
+
+HIP_PERF_BENCHMARK(hipPerfP2PMatrix)
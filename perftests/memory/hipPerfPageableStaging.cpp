@@ -0,0 +1,225 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// What staging pageable memory costs. For 4 KB to 256 MB (--sizes or --sweep
+// replace them) and both directions hipMemcpy runs from pageable memory,
+// from pinned memory and from pageable memory copied through a pinned buffer
+// by the application (memcpy plus hipMemcpy). Reported are GB/s, the process
+// CPU time per copy and that time as a share of the wall time, which shows
+// the runtime's own staging threads. The second group checks overlap: a
+// hipMemcpyAsync from pageable or pinned memory is issued next to a kernel
+// spinning for as long as the copy takes alone, and the host time until
+// hipMemcpyAsync returns and the overlap of copy and kernel (1 is full
+// overlap, 0 is serialized) are reported. Where the pageable overlap is near
+// zero or the call returns only after the copy, staging through a pinned
+// pool is worth it.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const size_t defaultCopySizes[] = {4096, 65536, 1048576, 16777216, 268435456};
+
+enum HostMemory { memoryPageable = 0, memoryPinned, memoryStaged, numHostMemories };
+static const char* hostMemoryStr[numHostMemories] = {"pageable", "pinned",
+                                                     "pageable via pinned memcpy"};
+static const unsigned int numOverlapMemories = 2;  // pageable and pinned
+
+static const size_t bytesPerRep = 256 * 1024 * 1024;
+static const size_t maxCopiesPerRep = 100;
+
+__global__ void spinKernel(unsigned long long spinTicks, int* out) {
+  unsigned long long start = wall_clock64();
+  while (wall_clock64() - start < spinTicks) {
+  }
+  out[0] = 1;
+}
+
+static double processCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+class hipPerfPageableStaging : public HipPerf::Benchmark {
+ public:
+  hipPerfPageableStaging() : HipPerf::Benchmark("hipPerfPageableStaging"),
+      copySizes_(HipPerf::sweepSizes(std::vector<size_t>(
+          defaultCopySizes, defaultCopySizes + sizeof(defaultCopySizes) /
+                                                   sizeof(defaultCopySizes[0])))),
+      pinned_(nullptr), device_(nullptr), flag_(nullptr), copyStream_(nullptr),
+      kernelStream_(nullptr), wallRateKHz_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    size_t bufSize = *std::max_element(copySizes_.begin(), copySizes_.end());
+    // Touched once so first use page faults are not part of the copies
+    pageable_.assign(bufSize, 1);
+    HIPCHECK(hipHostMalloc(&pinned_, bufSize));
+    HIPCHECK(hipMalloc(&device_, bufSize));
+    HIPCHECK(hipMalloc(&flag_, sizeof(int)));
+    HIPCHECK(hipStreamCreateWithFlags(&copyStream_, hipStreamNonBlocking));
+    HIPCHECK(hipStreamCreateWithFlags(&kernelStream_, hipStreamNonBlocking));
+    HIPCHECK(hipDeviceGetAttribute(&wallRateKHz_, hipDeviceAttributeWallClockRate, deviceId));
+  }
+
+  void close() override {
+    HIPCHECK(hipStreamDestroy(copyStream_));
+    HIPCHECK(hipStreamDestroy(kernelStream_));
+    HIPCHECK(hipFree(flag_));
+    HIPCHECK(hipFree(device_));
+    HIPCHECK(hipHostFree(pinned_));
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(copySizes_.size()) * 2 * (numHostMemories +
+                                                               numOverlapMemories);
+  }
+
+  void run(unsigned int test) override {
+    unsigned int perSize = 2 * (numHostMemories + numOverlapMemories);
+    size_t bytes = copySizes_[test / perSize];
+    unsigned int index = test % perSize;
+    bool toHost = index % 2 != 0;
+    if (index / 2 < numHostMemories) {
+      runBandwidth(test, static_cast<HostMemory>(index / 2), toHost, bytes);
+    } else {
+      runOverlap(test, static_cast<HostMemory>(index / 2 - numHostMemories), toHost, bytes);
+    }
+  }
+
+ private:
+  void copy(HostMemory memory, bool toHost, size_t bytes) {
+    void* host = memory == memoryPinned ? pinned_ : pageable_.data();
+    if (memory == memoryStaged) {
+      if (toHost) {
+        HIPCHECK(hipMemcpy(pinned_, device_, bytes, hipMemcpyDeviceToHost));
+        memcpy(pageable_.data(), pinned_, bytes);
+      } else {
+        memcpy(pinned_, pageable_.data(), bytes);
+        HIPCHECK(hipMemcpy(device_, pinned_, bytes, hipMemcpyHostToDevice));
+      }
+    } else if (toHost) {
+      HIPCHECK(hipMemcpy(host, device_, bytes, hipMemcpyDeviceToHost));
+    } else {
+      HIPCHECK(hipMemcpy(device_, host, bytes, hipMemcpyHostToDevice));
+    }
+  }
+
+  void copyAsync(HostMemory memory, bool toHost, size_t bytes) {
+    void* host = memory == memoryPinned ? pinned_ : pageable_.data();
+    if (toHost) {
+      HIPCHECK(hipMemcpyAsync(host, device_, bytes, hipMemcpyDeviceToHost, copyStream_));
+    } else {
+      HIPCHECK(hipMemcpyAsync(device_, host, bytes, hipMemcpyHostToDevice, copyStream_));
+    }
+  }
+
+  void runBandwidth(unsigned int test, HostMemory memory, bool toHost, size_t bytes) {
+    size_t copies = std::max<size_t>(1, std::min(maxCopiesPerRep, bytesPerRep / bytes));
+    std::vector<double> cpu;
+    auto sec = measure([&]() {
+      double cpuStart = processCpuSeconds();
+      for (size_t c = 0; c < copies; c++) {
+        copy(memory, toHost, bytes);
+      }
+      cpu.push_back(processCpuSeconds() - cpuStart);
+    });
+    // Warm-up runs recorded CPU time as well, keep the timed repetitions
+    cpu.erase(cpu.begin(), cpu.end() - std::min(cpu.size(), sec.size()));
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %-26s %10zu B", toHost ? "D2H" : "H2D",
+             hostMemoryStr[memory], bytes);
+    report(test, desc, bytes, static_cast<unsigned int>(copies), "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(bytes) * copies));
+    report(test, std::string(desc) + " CPU time", bytes, static_cast<unsigned int>(copies), "us",
+           HipPerf::toMicroseconds(cpu, static_cast<double>(copies)));
+    std::vector<double> share;
+    for (size_t r = 0; r < cpu.size() && r < sec.size(); r++) {
+      share.push_back(100.0 * cpu[r] / sec[r]);
+    }
+    report(test, std::string(desc) + " CPU share", bytes, static_cast<unsigned int>(copies), "%",
+           share, HipPerf::betterLower);
+  }
+
+  void runOverlap(unsigned int test, HostMemory memory, bool toHost, size_t bytes) {
+    double copyAlone = ComputePerfStats(measure([&]() {
+      copyAsync(memory, toHost, bytes);
+      HIPCHECK(hipStreamSynchronize(copyStream_));
+    })).median;
+    // wallRateKHz_ is ticks per millisecond
+    unsigned long long spinTicks =
+        static_cast<unsigned long long>(copyAlone * 1e3 * wallRateKHz_);
+    double kernelAlone = ComputePerfStats(measure([&]() {
+      hipLaunchKernelGGL(spinKernel, dim3(1), dim3(1), 0, kernelStream_, spinTicks, flag_);
+      HIPCHECK(hipStreamSynchronize(kernelStream_));
+    })).median;
+
+    std::vector<double> callReturn;
+    auto sec = measure([&]() {
+      hipLaunchKernelGGL(spinKernel, dim3(1), dim3(1), 0, kernelStream_, spinTicks, flag_);
+      auto start = std::chrono::steady_clock::now();
+      copyAsync(memory, toHost, bytes);
+      std::chrono::duration<double> call = std::chrono::steady_clock::now() - start;
+      callReturn.push_back(call.count());
+      HIPCHECK(hipStreamSynchronize(copyStream_));
+      HIPCHECK(hipStreamSynchronize(kernelStream_));
+    });
+    callReturn.erase(callReturn.begin(),
+                     callReturn.end() - std::min(callReturn.size(), sec.size()));
+
+    // Time saved against running both back to back, relative to the shorter one
+    std::vector<double> overlap;
+    double shorter = std::min(copyAlone, kernelAlone);
+    for (double s : sec) {
+      overlap.push_back(shorter > 0 ? (copyAlone + kernelAlone - s) / shorter : 0);
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s async %-8s %10zu B next to kernel", toHost ? "D2H" : "H2D",
+             hostMemoryStr[memory], bytes);
+    report(test, std::string(desc) + " call return", bytes, 1, "us",
+           HipPerf::toMicroseconds(callReturn, 1));
+    report(test, std::string(desc) + " overlap", bytes, 1, "fraction", overlap);
+  }
+
+  std::vector<size_t> copySizes_;
+  std::vector<char> pageable_;
+  void* pinned_;
+  void* device_;
+  int* flag_;
+  hipStream_t copyStream_;
+  hipStream_t kernelStream_;
+  int wallRateKHz_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfPageableStaging)
@@ -0,0 +1,215 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Kernel bandwidth on images of float pixels stored tightly packed in
+// hipMalloc buffers (row pitch = width), with the pitch hipMallocPitch
+// returns, and as 16 slices of a hipMalloc3D volume. Widths are powers of
+// two, common image widths and odd widths off the pitch alignment; every
+// image holds about 64 MB. A kernel scales one image into another of the same
+// layout, walking rows (the lanes of a wave on consecutive pixels of a row)
+// or columns (the lanes on consecutive rows of a column, each thread walking
+// along its row), where the row pitch decides which channels the lanes hit.
+// Reports GB/s of pixels read and written, the bandwidth against the packed
+// layout ("x packed") and the memory the pitch adds over packed rows.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int imageWidths[] = {1000, 1023, 1024, 1920, 1921, 4093, 4096};
+static const unsigned int numImageWidths = sizeof(imageWidths) / sizeof(imageWidths[0]);
+
+enum PitchLayout { layoutPacked = 0, layoutPitch, layout3D, numPitchLayouts };
+static const char* pitchLayoutStr[numPitchLayouts] = {"packed hipMalloc", "hipMallocPitch",
+                                                      "hipMalloc3D"};
+
+enum PitchAccess { accessRows = 0, accessColumns, numPitchAccesses };
+static const char* pitchAccessStr[numPitchAccesses] = {"row walk", "column walk"};
+
+static const size_t imageBytes = 64 * 1024 * 1024;
+static const unsigned int volumeDepth = 16;
+static const unsigned int blockSize = 256;
+// Bands of columns per image in the column walk, each thread walks one band of its row
+static const unsigned int columnBands = 16;
+
+__global__ void _rowWalkScale(const char* in, char* out, size_t pitch, unsigned int width,
+                              unsigned int rows) {
+  for (unsigned int y = blockIdx.y; y < rows; y += gridDim.y) {
+    const float* src = reinterpret_cast<const float*>(in + y * pitch);
+    float* dst = reinterpret_cast<float*>(out + y * pitch);
+    for (unsigned int x = blockIdx.x * blockDim.x + threadIdx.x; x < width;
+         x += gridDim.x * blockDim.x) {
+      dst[x] = src[x] * 2.0f;
+    }
+  }
+}
+
+__global__ void _columnWalkScale(const char* in, char* out, size_t pitch, unsigned int width,
+                                 unsigned int rows) {
+  unsigned int y = blockIdx.x * blockDim.x + threadIdx.x;
+  if (y >= rows) return;
+  const float* src = reinterpret_cast<const float*>(in + y * pitch);
+  float* dst = reinterpret_cast<float*>(out + y * pitch);
+  unsigned int band = (width + gridDim.y - 1) / gridDim.y;
+  unsigned int end = (blockIdx.y + 1) * band < width ? (blockIdx.y + 1) * band : width;
+  for (unsigned int x = blockIdx.y * band; x < end; x++) {
+    dst[x] = src[x] * 2.0f;
+  }
+}
+
+__global__ void _fillImage(char* data, size_t pitch, unsigned int width, unsigned int rows) {
+  for (unsigned int y = blockIdx.y; y < rows; y += gridDim.y) {
+    float* row = reinterpret_cast<float*>(data + y * pitch);
+    for (unsigned int x = blockIdx.x * blockDim.x + threadIdx.x; x < width;
+         x += gridDim.x * blockDim.x) {
+      row[x] = static_cast<float>((x + 7 * y) % 4093);
+    }
+  }
+}
+
+class hipPerfPitchedAccess : public HipPerf::Benchmark {
+ public:
+  hipPerfPitchedAccess() : HipPerf::Benchmark("hipPerfPitchedAccess"), stream_(nullptr) {
+    for (unsigned int a = 0; a < numPitchAccesses; a++) {
+      packedGBps_[a] = 0;
+    }
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override { HIPCHECK(hipStreamDestroy(stream_)); }
+
+  // Layouts are the inner index, so the packed layout runs first for every width and access
+  unsigned int numTests() override {
+    return numImageWidths * numPitchAccesses * numPitchLayouts;
+  }
+
+  void run(unsigned int test) override {
+    PitchLayout layout = static_cast<PitchLayout>(test % numPitchLayouts);
+    PitchAccess access = static_cast<PitchAccess>((test / numPitchLayouts) % numPitchAccesses);
+    unsigned int width = imageWidths[test / (numPitchLayouts * numPitchAccesses)];
+    size_t rowBytes = sizeof(float) * width;
+    // A multiple of the volume depth, so all layouts have the same rows
+    unsigned int rows =
+        static_cast<unsigned int>(imageBytes / rowBytes / volumeDepth * volumeDepth);
+
+    void* buffers[2] = {nullptr, nullptr};
+    size_t pitch = rowBytes;
+    for (int b = 0; b < 2; b++) {
+      pitch = allocate(layout, &buffers[b], rowBytes, rows);
+    }
+    char* in = static_cast<char*>(buffers[0]);
+    char* out = static_cast<char*>(buffers[1]);
+
+    dim3 rowGrid((width + blockSize - 1) / blockSize, std::min(rows, 4096u));
+    hipLaunchKernelGGL(_fillImage, rowGrid, dim3(blockSize), 0, stream_, in, pitch, width, rows);
+    HIPCHECK(hipGetLastError());
+    auto sec = measure([&]() {
+      if (access == accessRows) {
+        hipLaunchKernelGGL(_rowWalkScale, rowGrid, dim3(blockSize), 0, stream_, in, out, pitch,
+                           width, rows);
+      } else {
+        dim3 grid((rows + blockSize - 1) / blockSize, columnBands);
+        hipLaunchKernelGGL(_columnWalkScale, grid, dim3(blockSize), 0, stream_, in, out, pitch,
+                           width, rows);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    verify(out, pitch, width, rows, layout, access);
+    for (auto buffer : buffers) {
+      HIPCHECK(hipFree(buffer));
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "width %4u pitch %5zu %-16s %s", width, pitch,
+             pitchLayoutStr[layout], pitchAccessStr[access]);
+    size_t bytes = 2 * rowBytes * rows;
+    auto gbps = HipPerf::toBandwidth(sec, static_cast<double>(bytes));
+    report(test, desc, bytes, 1, "GB/s", gbps);
+    double median = ComputePerfStats(gbps).median;
+    if (layout == layoutPacked) {
+      packedGBps_[access] = median;
+    } else {
+      if (packedGBps_[access] > 0) {
+        report(test, desc, bytes, 1, "x packed", {median / packedGBps_[access]});
+      }
+      report(test, desc + std::string(" memory overhead"), bytes, 1, "%",
+             {100.0 * (pitch - rowBytes) / rowBytes}, HipPerf::betterLower);
+    }
+  }
+
+ private:
+  // Returns the row pitch of the allocation
+  size_t allocate(PitchLayout layout, void** ptr, size_t rowBytes, unsigned int rows) {
+    size_t pitch = rowBytes;
+    switch (layout) {
+      case layoutPacked:
+        HIPCHECK(hipMalloc(ptr, rowBytes * rows));
+        break;
+      case layoutPitch:
+        HIPCHECK(hipMallocPitch(ptr, &pitch, rowBytes, rows));
+        break;
+      default: {
+        // Slices of a hipMalloc3D volume follow each other, so it is walked as one image
+        hipPitchedPtr pitched;
+        HIPCHECK(hipMalloc3D(&pitched, make_hipExtent(rowBytes, rows / volumeDepth, volumeDepth)));
+        *ptr = pitched.ptr;
+        pitch = pitched.pitch;
+        break;
+      }
+    }
+    return pitch;
+  }
+
+  // Checks the first and last pixel of every row, where a wrong pitch shows first
+  void verify(const char* out, size_t pitch, unsigned int width, unsigned int rows,
+              PitchLayout layout, PitchAccess access) {
+    std::vector<float> image(static_cast<size_t>(width) * rows);
+    HIPCHECK(hipMemcpy2D(image.data(), sizeof(float) * width, out, pitch, sizeof(float) * width,
+                         rows, hipMemcpyDeviceToHost));
+    for (unsigned int y = 0; y < rows; y++) {
+      for (unsigned int x : {0u, width - 1}) {
+        float expected = 2.0f * static_cast<float>((x + 7 * y) % 4093);
+        float value = image[static_cast<size_t>(y) * width + x];
+        if (value != expected) {
+          failed("%s %s width %u: pixel (%u, %u) is %f, expected %f", pitchLayoutStr[layout],
+                 pitchAccessStr[access], width, x, y, value, expected);
+        }
+      }
+    }
+  }
+
+  hipStream_t stream_;
+  double packedGBps_[numPitchAccesses];  // median of the packed layout for the current width
+};
+
+HIP_PERF_BENCHMARK(hipPerfPitchedAccess)
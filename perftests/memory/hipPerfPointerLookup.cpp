@@ -0,0 +1,176 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// hipPointerGetAttributes latency against the number of live allocations of
+// one kind: device, pinned host, registered host and managed memory, from 1k
+// to 1M allocations (--sizes replaces the counts). Lookups go to random live
+// allocations, half of them to an address inside the allocation, so neither
+// a last-hit cache nor base address matching hides the cost of the pointer
+// tracking. ns per lookup that grow with the count faster than log(n) mean
+// the runtime searches its allocations linearly.
+// Allocations are kept between the tests of one kind and only grown. When the
+// device or host runs out of memory the kind is measured up to the count it
+// reached.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <random>
+
+#include "perf_harness.h"
+
+static const std::vector<size_t> Counts = {1024, 16384, 131072, 1048576};
+static const size_t allocSize = 4096;
+// Registration pins the pages, 64k registered pages are 256 MB of locked memory
+static const size_t maxRegistered = 65536;
+
+enum AllocKind { kindDevice = 0, kindPinned, kindRegistered, kindManaged, numAllocKinds };
+
+static const char* allocKindStr[numAllocKinds] = {"device", "pinned host", "registered host",
+                                                  "managed"};
+
+class hipPerfPointerLookup : public HipPerf::Benchmark {
+ public:
+  hipPerfPointerLookup() : HipPerf::Benchmark("hipPerfPointerLookup"),
+      counts_(HipPerf::sweepSizes(Counts)), lookups_(HipPerf::iterationCount(100000)),
+      kind_(numAllocKinds), exhausted_(false), hostBuffer_(nullptr) {}
+
+  void close() override { freeAll(); }
+
+  unsigned int numTests() override { return numAllocKinds * counts_.size(); }
+
+  void run(unsigned int test) override {
+    AllocKind kind = static_cast<AllocKind>(test / counts_.size());
+    size_t count = counts_[test % counts_.size()];
+    if (kind != kind_) {
+      freeAll();
+      kind_ = kind;
+    }
+    if (kind == kindRegistered && count > maxRegistered) {
+      printf("info: %zu registered allocations exceed the limit of %zu, skipping\n", count,
+             maxRegistered);
+      return;
+    }
+    if (exhausted_) {
+      return;
+    }
+    grow(count);
+
+    // Fixed random targets, so every repetition does the same lookups
+    std::mt19937 gen(test);
+    std::uniform_int_distribution<size_t> pick(0, ptrs_.size() - 1);
+    std::vector<void*> targets(lookups_);
+    for (unsigned int i = 0; i < lookups_; i++) {
+      targets[i] = static_cast<char*>(ptrs_[pick(gen)]) + (i % 2 ? allocSize / 2 : 0);
+    }
+
+    hipPointerAttribute_t attributes;
+    HIPCHECK(hipPointerGetAttributes(&attributes, targets[0]));
+    auto sec = measure([&]() {
+      for (auto target : targets) {
+        (void)hipPointerGetAttributes(&attributes, target);
+      }
+    });
+    std::vector<double> ns;
+    for (double s : sec) {
+      ns.push_back(s * 1e9 / lookups_);
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-16s %8zu live allocations", allocKindStr[kind],
+             ptrs_.size());
+    report(test, desc, allocSize, lookups_, "ns", ns);
+  }
+
+ private:
+  // Allocates until count allocations of kind_ are live, or memory runs out.
+  void grow(size_t count) {
+    if (kind_ == kindRegistered && hostBuffer_ == nullptr) {
+      hostBuffer_ = aligned_alloc(allocSize, maxRegistered * allocSize);
+      if (hostBuffer_ == nullptr) {
+        failed("Failed to allocate the host buffer for registration");
+      }
+    }
+    ptrs_.reserve(count);
+    while (ptrs_.size() < count) {
+      void* ptr = nullptr;
+      hipError_t result = hipSuccess;
+      switch (kind_) {
+        case kindDevice:
+          result = hipMalloc(&ptr, allocSize);
+          break;
+        case kindPinned:
+          result = hipHostMalloc(&ptr, allocSize);
+          break;
+        case kindRegistered:
+          ptr = static_cast<char*>(hostBuffer_) + ptrs_.size() * allocSize;
+          result = hipHostRegister(ptr, allocSize, hipHostRegisterDefault);
+          break;
+        default:
+          result = hipMallocManaged(&ptr, allocSize);
+          break;
+      }
+      if (result == hipErrorOutOfMemory) {
+        printf("info: out of memory after %zu %s allocations\n", ptrs_.size(),
+               allocKindStr[kind_]);
+        (void)hipGetLastError();
+        exhausted_ = true;
+        break;
+      }
+      HIPCHECK(result);
+      ptrs_.push_back(ptr);
+    }
+  }
+
+  void freeAll() {
+    for (auto ptr : ptrs_) {
+      switch (kind_) {
+        case kindPinned:
+          HIPCHECK(hipHostFree(ptr));
+          break;
+        case kindRegistered:
+          HIPCHECK(hipHostUnregister(ptr));
+          break;
+        default:
+          HIPCHECK(hipFree(ptr));
+          break;
+      }
+    }
+    ptrs_.clear();
+    free(hostBuffer_);
+    hostBuffer_ = nullptr;
+    exhausted_ = false;
+  }
+
+  std::vector<size_t> counts_;
+  unsigned int lookups_;
+  AllocKind kind_;         // kind of the live allocations in ptrs_
+  bool exhausted_;         // no more allocations of kind_ possible
+  std::vector<void*> ptrs_;
+  void* hostBuffer_;       // pages registered by kindRegistered
+};
+
+HIP_PERF_BENCHMARK(hipPerfPointerLookup)
@@ -0,0 +1,180 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Whether the read-only load path pays off. The same kernel reads a 256 MB
+// float table through a plain pointer, through a const __restrict__ pointer
+// and with __ldg, in three access patterns: broadcast (every thread walks
+// the same 16 KB window, as for coefficient tables), gather (each thread
+// reads pseudo random elements of a 16 MB window, as for lookups through an
+// index) and streaming (coalesced reads of the whole table). Reported are
+// GB/s of loaded data and the ratio to the plain pointer for the pattern.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum ReadPattern { patternBroadcast = 0, patternGather, patternStream, numReadPatterns };
+static const char* readPatternStr[numReadPatterns] = {"broadcast 16 KB", "gather 16 MB",
+                                                      "stream 256 MB"};
+
+// Plain loads run first for every pattern and are the reference
+enum LoadKind { loadPlain = 0, loadRestrict, loadLdg, numLoadKinds };
+static const char* loadKindStr[numLoadKinds] = {"plain pointer", "const __restrict__",
+                                                "__ldg"};
+
+static const size_t tableFloats = 64 * 1024 * 1024;
+static const size_t broadcastFloats = 4 * 1024;
+static const size_t gatherFloats = 4 * 1024 * 1024;
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const unsigned int readsPerThread = 256;
+
+template <ReadPattern pattern>
+__device__ inline size_t readIndex(unsigned int tid, unsigned int r, unsigned int threads) {
+  switch (pattern) {
+    case patternBroadcast:
+      return (r * 31) & (broadcastFloats - 1);
+    case patternGather:
+      return ((tid + r * threads) * 2654435761u) & (gatherFloats - 1);
+    default:
+      return (static_cast<size_t>(r) * threads + tid) & (tableFloats - 1);
+  }
+}
+
+/*
+READ_KERNEL(Name, qualifier, load) defines kernel Name reading the table through pointers
+with the given qualifier, load(p) returns the float at p.
+*/
+#define READ_KERNEL(NAME, QUALIFIER, LOAD)                                                        \
+  template <ReadPattern pattern>                                                                  \
+  __global__ void NAME(const float* QUALIFIER table, float* QUALIFIER out, unsigned int reads) { \
+    unsigned int tid = blockIdx.x * blockDim.x + threadIdx.x;                                     \
+    unsigned int threads = gridDim.x * blockDim.x;                                                \
+    float sum = 0;                                                                                \
+    for (unsigned int r = 0; r < reads; r++) {                                                    \
+      const float* p = &table[readIndex<pattern>(tid, r, threads)];                               \
+      sum += LOAD;                                                                                \
+    }                                                                                             \
+    out[tid] = sum;                                                                               \
+  }
+
+READ_KERNEL(readPlain, , *p)
+READ_KERNEL(readRestrict, __restrict__, *p)
+READ_KERNEL(readLdg, , __ldg(p))
+
+#undef READ_KERNEL
+
+template <ReadPattern pattern>
+static void launchRead(LoadKind kind, dim3 grid, const float* table, float* out) {
+  switch (kind) {
+    case loadPlain:
+      hipLaunchKernelGGL(readPlain<pattern>, grid, dim3(blockSize), 0, 0, table, out,
+                         readsPerThread);
+      break;
+    case loadRestrict:
+      hipLaunchKernelGGL(readRestrict<pattern>, grid, dim3(blockSize), 0, 0, table, out,
+                         readsPerThread);
+      break;
+    default:
+      hipLaunchKernelGGL(readLdg<pattern>, grid, dim3(blockSize), 0, 0, table, out,
+                         readsPerThread);
+      break;
+  }
+}
+
+class hipPerfReadOnlyLoad : public HipPerf::Benchmark {
+ public:
+  hipPerfReadOnlyLoad() : HipPerf::Benchmark("hipPerfReadOnlyLoad"), table_(nullptr),
+      out_(nullptr), plainMedian_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    std::vector<float> table(tableFloats);
+    for (size_t i = 0; i < tableFloats; i++) {
+      table[i] = static_cast<float>(i & 1023);
+    }
+    HIPCHECK(hipMalloc(&table_, tableFloats * sizeof(float)));
+    HIPCHECK(hipMemcpy(table_, table.data(), tableFloats * sizeof(float),
+                       hipMemcpyHostToDevice));
+    HIPCHECK(hipMalloc(&out_, static_cast<size_t>(grid_.x) * blockSize * sizeof(float)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(table_));
+    HIPCHECK(hipFree(out_));
+  }
+
+  unsigned int numTests() override { return numReadPatterns * numLoadKinds; }
+
+  void run(unsigned int test) override {
+    ReadPattern pattern = static_cast<ReadPattern>(test / numLoadKinds);
+    LoadKind kind = static_cast<LoadKind>(test % numLoadKinds);
+
+    auto sec = measure([&]() {
+      switch (pattern) {
+        case patternBroadcast:
+          launchRead<patternBroadcast>(kind, grid_, table_, out_);
+          break;
+        case patternGather:
+          launchRead<patternGather>(kind, grid_, table_, out_);
+          break;
+        default:
+          launchRead<patternStream>(kind, grid_, table_, out_);
+          break;
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    size_t bytes = static_cast<size_t>(grid_.x) * blockSize * readsPerThread * sizeof(float);
+    std::string desc = std::string(readPatternStr[pattern]) + " " + loadKindStr[kind];
+    auto bandwidth = HipPerf::toBandwidth(sec, static_cast<double>(bytes));
+    report(test, desc, bytes, 1, "GB/s", bandwidth);
+
+    std::vector<double> sorted(bandwidth);
+    std::sort(sorted.begin(), sorted.end());
+    if (kind == loadPlain) {
+      plainMedian_ = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+    } else if (plainMedian_ > 0) {
+      std::vector<double> ratio;
+      for (double b : bandwidth) {
+        ratio.push_back(b / plainMedian_);
+      }
+      report(test, desc + " vs plain pointer", bytes, 1, "x", ratio);
+    }
+  }
+
+ private:
+  float* table_;
+  float* out_;
+  dim3 grid_;
+  double plainMedian_;  // plain pointer median of the pattern being run
+};
+
+HIP_PERF_BENCHMARK(hipPerfReadOnlyLoad)
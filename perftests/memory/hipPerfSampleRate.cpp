@@ -18,14 +18,14 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
  * TEST: %t
  * HIT_END
  */
 
 #include <iostream>
 #include <chrono>
-#include "test_common.h"
+#include "perf_harness.h"
 #include <hip/hip_vector_types.h>
 #include <vector>
 
@@ -269,9 +269,11 @@ void hipPerfSampleRate::run(unsigned int test) {
   double perf = ((double)outBufSize_ * numBufs_ * (double)maxIter * (double)(1e-09)) /
                           all_kernel_time.count();
 
-  cout << "Domain " << sizes[NUM_SIZES - 1] << "x"<< sizes[NUM_SIZES - 1] << " bufs "
-       << numBufs_ << " " << types[typeIdx_] << " " << width_<<"x"<<width_<< " (GB/s) "
-       << perf << endl;
+  HipPerf::writeResult("hipPerfSampleRate", test, "Domain " + std::to_string(sizes[NUM_SIZES - 1]) +
+                       "x" + std::to_string(sizes[NUM_SIZES - 1]) + " bufs " +
+                       std::to_string(numBufs_) + " " + types[typeIdx_] + " " +
+                       std::to_string(width_) + "x" + std::to_string(width_),
+                       outBufSize_ * numBufs_, maxIter, "GB/s", perf);
 
    HIPCHECK(hipFree(dOutPtr));
 
@@ -306,6 +308,7 @@ void hipPerfSampleRate::checkData(uint *ptr) {
 
 
 int main(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
   hipPerfSampleRate sampleTypes;
 
   sampleTypes.open();
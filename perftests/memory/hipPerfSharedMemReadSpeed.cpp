@@ -18,14 +18,14 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
  * TEST: %t
  * HIT_END
  */
 
 #include <iostream>
 #include <chrono>
-#include "test_common.h"
+#include "perf_harness.h"
 
 using namespace std;
 
@@ -118,17 +118,74 @@ __global__ void sharedMemReadSpeed2(float *outBuf, ulong N) {
   }
 };
 
+// Parameterized LDS read: each thread reads T elements at lid * stride, shifted
+// by one element per read so nothing can be hoisted while the bank pattern of
+// the wavefront stays the same. sizeof(T) 4/8/16 maps to ds_read_b32/b64/b128.
+#define ldsBytes 16384
+#define ldsReads 256
+
+__device__ inline uint ldsSum(uint v) { return v; }
+__device__ inline uint ldsSum(uint2 v) { return v.x + v.y; }
+__device__ inline uint ldsSum(uint4 v) { return v.x + v.y + v.z + v.w; }
+
+template <typename T>
+__global__ void sharedMemStrideRead(uint *outBuf, uint stride) {
+  const uint n = ldsBytes / sizeof(T);
+  __shared__ T local[ldsBytes / sizeof(T)];
+  uint lid = threadIdx.x;
+  uint *words = reinterpret_cast<uint *>(local);
+
+  for (uint i = lid; i < ldsBytes / sizeof(uint); i += blockDim.x) {
+    words[i] = i;
+  }
+  __syncthreads();
+
+  uint val = 0;
+  uint base = lid * stride;
+  for (uint i = 0; i < ldsReads; i++) {
+    val += ldsSum(local[(base + i) & (n - 1)]);
+  }
+  outBuf[blockIdx.x * blockDim.x + lid] = val;
+}
+
+template <typename T>
+static double runStrideRead(hipStream_t stream, uint *dDst, uint blocks, uint threads,
+                            uint stride, int nIter) {
+  hipLaunchKernelGGL(sharedMemStrideRead<T>, dim3(blocks), dim3(threads), 0, stream, dDst,
+                     stride);
+  HIPCHECK(hipStreamSynchronize(stream));
+
+  auto all_start = chrono::steady_clock::now();
+  for (int i = 0; i < nIter; i++) {
+    hipLaunchKernelGGL(sharedMemStrideRead<T>, dim3(blocks), dim3(threads), 0, stream, dDst,
+                       stride);
+  }
+  HIPCHECK(hipStreamSynchronize(stream));
+  chrono::duration<double> all_kernel_time = chrono::steady_clock::now() - all_start;
+
+  HipPerf::Counters::collect([&]() {
+    hipLaunchKernelGGL(sharedMemStrideRead<T>, dim3(blocks), dim3(threads), 0, stream, dDst,
+                       stride);
+    HIPCHECK(hipStreamSynchronize(stream));
+  });
+
+  // LDS bytes read in GB/s
+  return ((double) blocks * threads * ldsReads * sizeof(T) * nIter * (double) (1e-09)) /
+      all_kernel_time.count();
+}
+
 int main(int argc, char *argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
   float *dDst;
   float *hDst;
   hipStream_t stream;
-  constexpr uint numSizes = 4;
-  constexpr uint Sizes[numSizes] = {262144, 1048576, 4194304, 16777216};
+  const std::vector<size_t> Sizes = HipPerf::sweepSizes({262144, 1048576, 4194304, 16777216});
+  const uint numSizes = Sizes.size();
   uint numReads1 = 32;
   uint numReads2 = 256;
   uint sharedMemSizeBytes1 = sharedMemSize1 * sizeof(float);
   uint sharedMemSizeBytes2 = sharedMemSize2 * sizeof(float);
-  int nIter = 1000;
+  int nIter = HipPerf::iterationCount(1000);
   const unsigned threadsPerBlock = 64;
 
   int nGpu = 0;
@@ -139,7 +196,7 @@ int main(int argc, char *argv[]) {
     return 0;
   }
 
-  static int device = 0;
+  int device = p_gpuDevice;
   HIPCHECK(hipSetDevice(device));
   hipDeviceProp_t props;
   HIPCHECK(hipGetDeviceProperties(&props, device));
@@ -151,7 +208,11 @@ int main(int argc, char *argv[]) {
   for (int nTest = 0; nTest < numSizes; nTest++) {
     uint nBytes = Sizes[nTest % numSizes];
     ulong N = nBytes / sizeof(float);
-    const unsigned blocks = N / threadsPerBlock;
+    // Round up, the kernels guard the tail of swept sizes
+    const unsigned blocks = (N + threadsPerBlock - 1) / threadsPerBlock;
+    if (N == 0) {
+      continue;
+    }
 
     hDst = new float[nBytes];
     HIPCHECK(hDst == 0 ? hipErrorOutOfMemory : hipSuccess);
@@ -188,15 +249,20 @@ int main(int argc, char *argv[]) {
     auto all_end = chrono::steady_clock::now();
     chrono::duration<double> all_kernel_time = all_end - all_start;
 
+    HipPerf::Counters::collect([&]() {
+      hipLaunchKernelGGL(sharedMemReadSpeed1, dim3(blocks), dim3(threadsPerBlock), 0, stream,
+                         dDst, N);
+      HIPCHECK(hipStreamSynchronize(stream));
+    });
+
     // read speed in GB/s
     double perf = ((double) blocks * threadsPerBlock
         * (numReads1 * sizeof(float) + sharedMemSizeBytes1 / 64) * nIter
         * (double) (1e-09)) / all_kernel_time.count();
 
-    cout << "info: read speed = " << setw(8) << perf << " GB/s for "
-        << sharedMemSizeBytes1 / 1024 << " KB shared memory"
-            " with " << setw(8) << blocks * threadsPerBlock << " threads, "
-        << setw(4) << numReads1 << " reads in sharedMemReadSpeed1 kernel" << endl;
+    HipPerf::writeResult("hipPerfSharedMemReadSpeed", 0 + nTest, "sharedMemReadSpeed1 " +
+                         std::to_string(sharedMemSizeBytes1 / 1024) + " KB shared " +
+                         std::to_string(numReads1) + " reads", nBytes, nIter, "GB/s", perf);
 
     delete[] hDst;
     hipFree(dDst);
@@ -206,7 +272,11 @@ int main(int argc, char *argv[]) {
   for (int nTest = 0; nTest < numSizes; nTest++) {
     uint nBytes = Sizes[nTest % numSizes];
     ulong N = nBytes / sizeof(float);
-    const unsigned blocks = N / threadsPerBlock;
+    // Round up, the kernels guard the tail of swept sizes
+    const unsigned blocks = (N + threadsPerBlock - 1) / threadsPerBlock;
+    if (N == 0) {
+      continue;
+    }
 
     hDst = new float[nBytes];
     HIPCHECK(hDst == 0 ? hipErrorOutOfMemory : hipSuccess);
@@ -230,20 +300,58 @@ int main(int argc, char *argv[]) {
     auto all_end = chrono::steady_clock::now();
     chrono::duration<double> all_kernel_time = all_end - all_start;
 
+    HipPerf::Counters::collect([&]() {
+      hipLaunchKernelGGL(sharedMemReadSpeed2, dim3(blocks), dim3(threadsPerBlock), 0, stream,
+                         dDst, N);
+      HIPCHECK(hipStreamSynchronize(stream));
+    });
+
     // read speed in GB/s
     double perf = ((double) blocks * threadsPerBlock
         * (numReads2 * sizeof(float) + sharedMemSizeBytes2 / 64) * nIter
         * (double) (1e-09)) / all_kernel_time.count();
 
-    cout << "info: read speed = " << setw(8) << perf << " GB/s for "
-        << sharedMemSizeBytes2 / 1024 << " KB shared memory"
-            " with " << setw(8) << blocks * threadsPerBlock << " threads, "
-        << setw(4) << numReads2 << " reads in sharedMemReadSpeed2 kernel" << endl;
+    HipPerf::writeResult("hipPerfSharedMemReadSpeed", numSizes + nTest, "sharedMemReadSpeed2 " +
+                         std::to_string(sharedMemSizeBytes2 / 1024) + " KB shared " +
+                         std::to_string(numReads2) + " reads", nBytes, nIter, "GB/s", perf);
 
     delete[] hDst;
     hipFree(dDst);
   }
 
+  // Stride, element width and occupancy sweep, bandwidth per CU
+  {
+    const uint strides[] = {1, 2, 4, 8, 16, 32, 33};
+    const uint blocksPerCU[] = {1, 4, 8};
+    const uint widths[] = {4, 8, 16};
+    const uint ldsThreads = 256;
+    const uint maxBlocks = props.multiProcessorCount * 8;
+
+    uint *dLds;
+    HIPCHECK(hipMalloc(&dLds, maxBlocks * ldsThreads * sizeof(uint)));
+    uint nTest = 2 * numSizes;
+    for (uint w : widths) {
+      for (uint occupancy : blocksPerCU) {
+        for (uint stride : strides) {
+          uint blocks = props.multiProcessorCount * occupancy;
+          double perf = 0;
+          if (w == 4) {
+            perf = runStrideRead<uint>(stream, dLds, blocks, ldsThreads, stride, nIter);
+          } else if (w == 8) {
+            perf = runStrideRead<uint2>(stream, dLds, blocks, ldsThreads, stride, nIter);
+          } else {
+            perf = runStrideRead<uint4>(stream, dLds, blocks, ldsThreads, stride, nIter);
+          }
+          HipPerf::writeResult("hipPerfSharedMemReadSpeed", nTest++, "ds_read_b" +
+                               std::to_string(w * 8) + " stride " + std::to_string(stride) +
+                               " " + std::to_string(occupancy) + " blocks/CU per CU", 0,
+                               nIter, "GB/s", perf / props.multiProcessorCount);
+        }
+      }
+    }
+    hipFree(dLds);
+  }
+
   HIPCHECK(hipStreamDestroy(stream));
 
   passed();
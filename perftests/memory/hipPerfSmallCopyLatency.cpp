@@ -0,0 +1,166 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Latency floor of small host <-> device transfers. For 1 B to 64 KB (--sizes
+// or --sweep replace them) and both directions every copy is timed on its
+// own, between pinned host memory and device memory, through hipMemcpy,
+// hipMemcpyAsync followed by hipStreamSynchronize, hipMemcpyWithStream, the
+// driver style hipMemcpyHtoD/DtoH and, with a large BAR, the CPU storing to or
+// loading from the device memory directly (8 byte accesses, then a full
+// fence). Every copy is one sample, so the reported percentiles are those of
+// single transfers.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const size_t defaultCopySizes[] = {1, 8, 64, 512, 4096, 65536};
+
+enum CopyMethod {
+  methodMemcpy = 0,
+  methodMemcpyAsync,
+  methodMemcpyWithStream,
+  methodDriver,
+  methodCpuAccess,
+  numCopyMethods
+};
+static const char* copyMethodStr[2][numCopyMethods] = {
+    {"hipMemcpy H2D", "hipMemcpyAsync H2D + sync", "hipMemcpyWithStream H2D", "hipMemcpyHtoD",
+     "CPU stores to device memory"},
+    {"hipMemcpy D2H", "hipMemcpyAsync D2H + sync", "hipMemcpyWithStream D2H", "hipMemcpyDtoH",
+     "CPU loads from device memory"}};
+
+static const unsigned int copiesPerTest = 1000;
+static const size_t maxCopySize = 64 * 1024 * 1024;
+
+// Byte granular copy through volatile 8 byte accesses, the tail byte by byte
+static void cpuCopy(void* dst, const void* src, size_t bytes) {
+  volatile uint64_t* d = static_cast<volatile uint64_t*>(dst);
+  const volatile uint64_t* s = static_cast<const volatile uint64_t*>(src);
+  size_t words = bytes / sizeof(uint64_t);
+  for (size_t i = 0; i < words; i++) {
+    d[i] = s[i];
+  }
+  volatile uint8_t* db = static_cast<volatile uint8_t*>(dst);
+  const volatile uint8_t* sb = static_cast<const volatile uint8_t*>(src);
+  for (size_t i = words * sizeof(uint64_t); i < bytes; i++) {
+    db[i] = sb[i];
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+class hipPerfSmallCopyLatency : public HipPerf::Benchmark {
+ public:
+  hipPerfSmallCopyLatency() : HipPerf::Benchmark("hipPerfSmallCopyLatency"),
+      copySizes_(HipPerf::sweepSizes(std::vector<size_t>(
+          defaultCopySizes, defaultCopySizes + sizeof(defaultCopySizes) /
+                                                   sizeof(defaultCopySizes[0])))),
+      host_(nullptr), device_(nullptr), stream_(nullptr), bufSize_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    for (size_t size : copySizes_) {
+      bufSize_ = std::max(bufSize_, std::min(size, maxCopySize));
+    }
+    HIPCHECK(hipHostMalloc(&host_, bufSize_));
+    HIPCHECK(hipMalloc(&device_, bufSize_));
+    memset(host_, 1, bufSize_);
+    HIPCHECK(hipMemset(device_, 0, bufSize_));
+    HIPCHECK(hipStreamCreate(&stream_));
+    if (!props_.isLargeBar) {
+      printf("info: device %d has no large BAR, CPU access is not measured\n", deviceId);
+    }
+  }
+
+  void close() override {
+    HIPCHECK(hipStreamDestroy(stream_));
+    HIPCHECK(hipFree(device_));
+    HIPCHECK(hipHostFree(host_));
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(copySizes_.size()) * 2 * numCopyMethods;
+  }
+
+  void run(unsigned int test) override {
+    CopyMethod method = static_cast<CopyMethod>(test % numCopyMethods);
+    bool toHost = (test / numCopyMethods) % 2 != 0;
+    size_t bytes = copySizes_[test / (2 * numCopyMethods)];
+    if (bytes == 0 || bytes > maxCopySize) {
+      printf("info: copy size %zu not supported, skipping\n", bytes);
+      return;
+    }
+    if (method == methodCpuAccess && !props_.isLargeBar) {
+      return;
+    }
+
+    void* dst = toHost ? host_ : device_;
+    const void* src = toHost ? device_ : host_;
+    hipMemcpyKind kind = toHost ? hipMemcpyDeviceToHost : hipMemcpyHostToDevice;
+    auto latency = measureEach([&]() {
+      switch (method) {
+        case methodMemcpy:
+          HIPCHECK(hipMemcpy(dst, src, bytes, kind));
+          break;
+        case methodMemcpyAsync:
+          HIPCHECK(hipMemcpyAsync(dst, src, bytes, kind, stream_));
+          HIPCHECK(hipStreamSynchronize(stream_));
+          break;
+        case methodMemcpyWithStream:
+          HIPCHECK(hipMemcpyWithStream(dst, src, bytes, kind, stream_));
+          break;
+        case methodDriver:
+          if (toHost) {
+            HIPCHECK(hipMemcpyDtoH(host_, reinterpret_cast<hipDeviceptr_t>(device_), bytes));
+          } else {
+            HIPCHECK(hipMemcpyHtoD(reinterpret_cast<hipDeviceptr_t>(device_), host_, bytes));
+          }
+          break;
+        default:
+          cpuCopy(dst, src, bytes);
+          break;
+      }
+    }, copiesPerTest);
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-28s %6zu B", copyMethodStr[toHost][method], bytes);
+    report(test, desc, bytes, 1, "us", HipPerf::toMicroseconds(latency, 1));
+  }
+
+ private:
+  std::vector<size_t> copySizes_;
+  void* host_;
+  void* device_;
+  hipStream_t stream_;
+  size_t bufSize_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfSmallCopyLatency)
@@ -0,0 +1,426 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Double precision sparse matrix-vector product y = A * x with three
+// kernels: CSR scalar (a thread per row), CSR vector (a wave per row, lanes
+// striding over the row and a shuffle reduction) and ELL (column major rows
+// padded to the longest one, a thread per row). --input <file.mtx> runs a
+// Matrix Market coordinate matrix (real, integer or pattern; general,
+// symmetric or skew-symmetric), read in two streaming passes over the file
+// that count and then place the entries straight into CSR. Without it two
+// built-in matrices run: the 5 point Laplacian of a 2048 x 2048 grid and a
+// 1M x 1M matrix with Pareto distributed row lengths (up to 4096) and random
+// columns. Every kernel is checked against a host product before it is
+// timed. Reports GFLOPS (2 per nonzero) and GB/s of the minimum traffic
+// (values, column indices, row pointers, x and y once), the same for all
+// formats, and how much ELL pads the matrix.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum SpmvKernel { kernelCsrScalar = 0, kernelCsrVector, kernelEll, numSpmvKernels };
+static const char* spmvKernelStr[numSpmvKernels] = {"CSR scalar", "CSR vector", "ELL"};
+
+enum BuiltinMatrix { matrixLaplacian = 0, matrixPowerLaw, numBuiltinMatrices };
+static const char* builtinMatrixStr[numBuiltinMatrices] = {"laplacian 2048^2", "power law 1M"};
+
+static const int laplacianEdge = 2048;
+static const int powerLawRows = 1 << 20;
+static const int powerLawMaxRow = 4096;
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 64;
+
+struct CsrMatrix {
+  std::string name;
+  int rows = 0;
+  int cols = 0;
+  std::vector<int> rowPtr;
+  std::vector<int> col;
+  std::vector<double> val;
+};
+
+__global__ void csrScalar(int rows, const int* rowPtr, const int* col, const double* val,
+                          const double* x, double* y) {
+  for (int r = blockIdx.x * blockDim.x + threadIdx.x; r < rows; r += gridDim.x * blockDim.x) {
+    double sum = 0;
+    for (int j = rowPtr[r]; j < rowPtr[r + 1]; j++) {
+      sum += val[j] * x[col[j]];
+    }
+    y[r] = sum;
+  }
+}
+
+__global__ void csrVector(int rows, const int* rowPtr, const int* col, const double* val,
+                          const double* x, double* y) {
+  int lane = threadIdx.x % warpSize;
+  int waves = gridDim.x * blockDim.x / warpSize;
+  for (int r = (blockIdx.x * blockDim.x + threadIdx.x) / warpSize; r < rows; r += waves) {
+    double sum = 0;
+    for (int j = rowPtr[r] + lane; j < rowPtr[r + 1]; j += warpSize) {
+      sum += val[j] * x[col[j]];
+    }
+    for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+      sum += __shfl_down(sum, offset);
+    }
+    if (lane == 0) y[r] = sum;
+  }
+}
+
+// Padding entries have column -1 and only follow a row's own entries
+__global__ void ellKernel(int rows, int width, const int* col, const double* val,
+                          const double* x, double* y) {
+  for (int r = blockIdx.x * blockDim.x + threadIdx.x; r < rows; r += gridDim.x * blockDim.x) {
+    double sum = 0;
+    for (int k = 0; k < width; k++) {
+      size_t i = static_cast<size_t>(k) * rows + r;
+      int c = col[i];
+      if (c < 0) break;
+      sum += val[i] * x[c];
+    }
+    y[r] = sum;
+  }
+}
+
+// Two passes over the file, so the entries are never held twice
+static void loadMatrixMarket(const char* path, CsrMatrix& m) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) {
+    failed("cannot open matrix file %s", path);
+  }
+  char line[1024];
+  char object[64] = "", format[64] = "", field[64] = "", symmetry[64] = "";
+  if (fgets(line, sizeof(line), f) == nullptr ||
+      sscanf(line, "%%%%MatrixMarket %63s %63s %63s %63s", object, format, field, symmetry) != 4 ||
+      strcmp(object, "matrix") || strcmp(format, "coordinate")) {
+    failed("%s is not a Matrix Market coordinate matrix", path);
+  }
+  bool pattern = !strcmp(field, "pattern");
+  if (!pattern && strcmp(field, "real") && strcmp(field, "integer") && strcmp(field, "double")) {
+    failed("%s: %s matrices are not supported", path, field);
+  }
+  bool symmetric = !strcmp(symmetry, "symmetric");
+  bool skew = !strcmp(symmetry, "skew-symmetric");
+  if (!symmetric && !skew && strcmp(symmetry, "general")) {
+    failed("%s: %s matrices are not supported", path, symmetry);
+  }
+  long long entries = 0;
+  do {
+    if (fgets(line, sizeof(line), f) == nullptr) {
+      failed("%s has no size line", path);
+    }
+  } while (line[0] == '%');
+  if (sscanf(line, "%d %d %lld", &m.rows, &m.cols, &entries) != 3 || m.rows <= 0 ||
+      m.cols <= 0 || entries < 0) {
+    failed("%s: bad size line '%s'", path, line);
+  }
+  fpos_t data;
+  fgetpos(f, &data);
+
+  auto readEntry = [&](int& r, int& c, double& v) {
+    v = 1.0;
+    if (fscanf(f, "%d %d", &r, &c) != 2 || (!pattern && fscanf(f, "%lf", &v) != 1) || r < 1 ||
+        r > m.rows || c < 1 || c > m.cols) {
+      failed("%s: bad entry", path);
+    }
+    r--;
+    c--;
+  };
+
+  std::vector<long long> counts(m.rows + 1, 0);
+  for (long long e = 0; e < entries; e++) {
+    int r, c;
+    double v;
+    readEntry(r, c, v);
+    counts[r + 1]++;
+    if ((symmetric || skew) && r != c) counts[c + 1]++;
+  }
+  for (int r = 0; r < m.rows; r++) {
+    counts[r + 1] += counts[r];
+  }
+  if (counts[m.rows] > 0x7fffffff) {
+    failed("%s: %lld nonzeros do not fit 32 bit indices", path, counts[m.rows]);
+  }
+  m.rowPtr.assign(counts.begin(), counts.end());
+  m.col.resize(counts[m.rows]);
+  m.val.resize(counts[m.rows]);
+
+  fsetpos(f, &data);
+  for (long long e = 0; e < entries; e++) {
+    int r, c;
+    double v;
+    readEntry(r, c, v);
+    m.col[counts[r]] = c;
+    m.val[counts[r]++] = v;
+    if ((symmetric || skew) && r != c) {
+      m.col[counts[c]] = r;
+      m.val[counts[c]++] = skew ? -v : v;
+    }
+  }
+  fclose(f);
+
+  // Entries need not be ordered in the file
+  std::vector<std::pair<int, double>> row;
+  for (int r = 0; r < m.rows; r++) {
+    row.clear();
+    for (int j = m.rowPtr[r]; j < m.rowPtr[r + 1]; j++) {
+      row.emplace_back(m.col[j], m.val[j]);
+    }
+    std::sort(row.begin(), row.end());
+    for (size_t k = 0; k < row.size(); k++) {
+      m.col[m.rowPtr[r] + k] = row[k].first;
+      m.val[m.rowPtr[r] + k] = row[k].second;
+    }
+  }
+  const char* slash = strrchr(path, '/');
+  m.name = slash != nullptr ? slash + 1 : path;
+}
+
+static void buildLaplacian(CsrMatrix& m) {
+  const int n = laplacianEdge;
+  m.rows = m.cols = n * n;
+  m.rowPtr.assign(1, 0);
+  for (int y = 0; y < n; y++) {
+    for (int x = 0; x < n; x++) {
+      int r = y * n + x;
+      const int neighbours[] = {r - n, r - 1, r, r + 1, r + n};
+      const bool inside[] = {y > 0, x > 0, true, x < n - 1, y < n - 1};
+      for (int k = 0; k < 5; k++) {
+        if (inside[k]) {
+          m.col.push_back(neighbours[k]);
+          m.val.push_back(k == 2 ? 4.0 : -1.0);
+        }
+      }
+      m.rowPtr.push_back(static_cast<int>(m.col.size()));
+    }
+  }
+}
+
+// Fixed seed, so every device runs the same matrix
+static void buildPowerLaw(CsrMatrix& m) {
+  m.rows = m.cols = powerLawRows;
+  m.rowPtr.assign(1, 0);
+  std::mt19937 rng(0x5a4b);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::uniform_int_distribution<int> column(0, m.cols - 1);
+  std::vector<int> row;
+  for (int r = 0; r < m.rows; r++) {
+    // Pareto with shape 1.2 and minimum 2
+    double length = 2.0 * std::pow(1.0 - unit(rng), -1.0 / 1.2);
+    row.resize(static_cast<size_t>(std::min<double>(length, powerLawMaxRow)));
+    for (auto& c : row) {
+      c = column(rng);
+    }
+    std::sort(row.begin(), row.end());
+    row.erase(std::unique(row.begin(), row.end()), row.end());
+    for (int c : row) {
+      m.col.push_back(c);
+      m.val.push_back(1.0 / (1 + (c % 7)));
+    }
+    m.rowPtr.push_back(static_cast<int>(m.col.size()));
+  }
+}
+
+class hipPerfSpMV : public HipPerf::Benchmark {
+ public:
+  hipPerfSpMV() : HipPerf::Benchmark("hipPerfSpMV"), products_(HipPerf::iterationCount(20)),
+      loaded_(-1), rowPtr_(nullptr), col_(nullptr), val_(nullptr), ellCol_(nullptr),
+      ellVal_(nullptr), ellWidth_(0), x_(nullptr), y_(nullptr) {}
+
+  void close() override { release(); }
+
+  unsigned int numTests() override {
+    return (p_input != nullptr ? 1 : numBuiltinMatrices) * numSpmvKernels;
+  }
+
+  void run(unsigned int test) override {
+    SpmvKernel kernel = static_cast<SpmvKernel>(test % numSpmvKernels);
+    int matrix = test / numSpmvKernels;
+    if (matrix != loaded_) {
+      load(matrix);
+    }
+    const CsrMatrix& m = matrix_;
+    size_t nnz = m.col.size();
+    if (kernel == kernelEll && ellCol_ == nullptr) {
+      printf("info: ELL of %s pads to %d entries per row, more than a quarter of device "
+             "memory, skipping\n", m.name.c_str(), ellWidth_);
+      return;
+    }
+
+    unsigned int blocks = std::min<unsigned int>(
+        props_.multiProcessorCount * blocksPerCu,
+        (static_cast<size_t>(m.rows) * (kernel == kernelCsrVector ? props_.warpSize : 1) +
+         blockSize - 1) / blockSize);
+    auto spmv = [&]() {
+      switch (kernel) {
+        case kernelCsrScalar:
+          hipLaunchKernelGGL(csrScalar, dim3(blocks), dim3(blockSize), 0, 0, m.rows, rowPtr_,
+                             col_, val_, x_, y_);
+          break;
+        case kernelCsrVector:
+          hipLaunchKernelGGL(csrVector, dim3(blocks), dim3(blockSize), 0, 0, m.rows, rowPtr_,
+                             col_, val_, x_, y_);
+          break;
+        default:
+          hipLaunchKernelGGL(ellKernel, dim3(blocks), dim3(blockSize), 0, 0, m.rows, ellWidth_,
+                             ellCol_, ellVal_, x_, y_);
+          break;
+      }
+    };
+
+    HIPCHECK(hipMemset(y_, 0, m.rows * sizeof(double)));
+    spmv();
+    std::vector<double> y(m.rows);
+    HIPCHECK(hipMemcpy(y.data(), y_, m.rows * sizeof(double), hipMemcpyDeviceToHost));
+    for (int r = 0; r < m.rows; r++) {
+      // Summation order differs between the kernels
+      if (std::fabs(y[r] - reference_[r]) > 1e-12 * magnitude_[r]) {
+        failed("%s %s: row %d is %.17g, expected %.17g", m.name.c_str(), spmvKernelStr[kernel], r,
+               y[r], reference_[r]);
+      }
+    }
+
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < products_; i++) {
+        spmv();
+      }
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    double bytes = nnz * (sizeof(double) + sizeof(int)) + (m.rows + 1.0) * sizeof(int) +
+                   (static_cast<double>(m.rows) + m.cols) * sizeof(double);
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-20s %-10s", m.name.c_str(), spmvKernelStr[kernel]);
+    report(test, desc, static_cast<size_t>(bytes), products_, "GFLOPS",
+           HipPerf::toBandwidth(sec, 2.0 * nnz * products_));
+    report(test, desc, static_cast<size_t>(bytes), products_, "GB/s",
+           HipPerf::toBandwidth(sec, bytes * products_));
+    if (kernel == kernelEll) {
+      report(test, desc, static_cast<size_t>(bytes), products_, "x padded",
+             {static_cast<double>(ellWidth_) * m.rows / std::max<size_t>(nnz, 1)});
+    }
+  }
+
+ private:
+  void load(int matrix) {
+    release();
+    matrix_ = CsrMatrix();
+    if (p_input != nullptr) {
+      loadMatrixMarket(p_input, matrix_);
+    } else if (matrix == matrixLaplacian) {
+      buildLaplacian(matrix_);
+      matrix_.name = builtinMatrixStr[matrix];
+    } else {
+      buildPowerLaw(matrix_);
+      matrix_.name = builtinMatrixStr[matrix];
+    }
+    const CsrMatrix& m = matrix_;
+    size_t nnz = m.col.size();
+    printf("info: %s: %d x %d, %zu nonzeros\n", m.name.c_str(), m.rows, m.cols, nnz);
+
+    std::vector<double> x(m.cols);
+    for (int c = 0; c < m.cols; c++) {
+      x[c] = 1.0 + (c % 13) * 0.125;
+    }
+    reference_.assign(m.rows, 0);
+    magnitude_.assign(m.rows, 0);
+    ellWidth_ = 0;
+    for (int r = 0; r < m.rows; r++) {
+      for (int j = m.rowPtr[r]; j < m.rowPtr[r + 1]; j++) {
+        reference_[r] += m.val[j] * x[m.col[j]];
+        magnitude_[r] += std::fabs(m.val[j] * x[m.col[j]]);
+      }
+      ellWidth_ = std::max(ellWidth_, m.rowPtr[r + 1] - m.rowPtr[r]);
+    }
+
+    HIPCHECK(hipMalloc(&rowPtr_, (m.rows + 1) * sizeof(int)));
+    HIPCHECK(hipMalloc(&col_, std::max<size_t>(nnz, 1) * sizeof(int)));
+    HIPCHECK(hipMalloc(&val_, std::max<size_t>(nnz, 1) * sizeof(double)));
+    HIPCHECK(hipMalloc(&x_, m.cols * sizeof(double)));
+    HIPCHECK(hipMalloc(&y_, m.rows * sizeof(double)));
+    HIPCHECK(hipMemcpy(rowPtr_, m.rowPtr.data(), (m.rows + 1) * sizeof(int),
+                       hipMemcpyHostToDevice));
+    HIPCHECK(hipMemcpy(col_, m.col.data(), nnz * sizeof(int), hipMemcpyHostToDevice));
+    HIPCHECK(hipMemcpy(val_, m.val.data(), nnz * sizeof(double), hipMemcpyHostToDevice));
+    HIPCHECK(hipMemcpy(x_, x.data(), m.cols * sizeof(double), hipMemcpyHostToDevice));
+
+    size_t ellEntries = static_cast<size_t>(ellWidth_) * m.rows;
+    if (ellEntries * (sizeof(int) + sizeof(double)) <= props_.totalGlobalMem / 4) {
+      std::vector<int> ellCol(ellEntries, -1);
+      std::vector<double> ellVal(ellEntries, 0);
+      for (int r = 0; r < m.rows; r++) {
+        for (int j = m.rowPtr[r]; j < m.rowPtr[r + 1]; j++) {
+          size_t i = static_cast<size_t>(j - m.rowPtr[r]) * m.rows + r;
+          ellCol[i] = m.col[j];
+          ellVal[i] = m.val[j];
+        }
+      }
+      HIPCHECK(hipMalloc(&ellCol_, std::max<size_t>(ellEntries, 1) * sizeof(int)));
+      HIPCHECK(hipMalloc(&ellVal_, std::max<size_t>(ellEntries, 1) * sizeof(double)));
+      HIPCHECK(hipMemcpy(ellCol_, ellCol.data(), ellEntries * sizeof(int),
+                         hipMemcpyHostToDevice));
+      HIPCHECK(hipMemcpy(ellVal_, ellVal.data(), ellEntries * sizeof(double),
+                         hipMemcpyHostToDevice));
+    }
+    loaded_ = matrix;
+  }
+
+  void release() {
+    HIPCHECK(hipFree(rowPtr_));
+    HIPCHECK(hipFree(col_));
+    HIPCHECK(hipFree(val_));
+    HIPCHECK(hipFree(ellCol_));
+    HIPCHECK(hipFree(ellVal_));
+    HIPCHECK(hipFree(x_));
+    HIPCHECK(hipFree(y_));
+    rowPtr_ = col_ = ellCol_ = nullptr;
+    val_ = ellVal_ = x_ = y_ = nullptr;
+    loaded_ = -1;
+  }
+
+  unsigned int products_;  // per repetition
+  int loaded_;             // matrix index on the device, -1 for none
+  CsrMatrix matrix_;
+  std::vector<double> reference_;  // host y
+  std::vector<double> magnitude_;  // sum of |a * x| per row, scales the tolerance
+  int* rowPtr_;
+  int* col_;
+  double* val_;
+  int* ellCol_;
+  double* ellVal_;
+  int ellWidth_;
+  double* x_;
+  double* y_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfSpMV)
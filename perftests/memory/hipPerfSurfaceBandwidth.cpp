@@ -0,0 +1,350 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Read, write and copy bandwidth of hipArray backed surfaces against pitched
+// linear memory (hipMalloc for 1D, hipMallocPitch for 2D, hipMalloc3D for
+// 3D) holding the same uchar4, float or float4 elements. Threads walk the
+// elements in row order, in 16x16 tiles or down the columns; 1D only runs in
+// row order. The 1D extent is bound by the surface width limit and mostly
+// measures launch overhead. Reports GB/s, a copy counts read and write bytes.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "perf_harness.h"
+
+enum SurfDim { dim1D = 0, dim2D, dim3D, numSurfDims };
+enum SurfFormat { fmtUchar4 = 0, fmtFloat, fmtFloat4, numSurfFormats };
+enum SurfOp { opRead = 0, opWrite, opCopy, numSurfOps };
+enum AccessOrder { orderRows = 0, orderTiles, orderColumns, numAccessOrders };
+enum Storage { storageSurface = 0, storagePitched, numStorages };
+
+static const char* surfDimStr[numSurfDims] = {"1D", "2D", "3D"};
+static const char* surfFormatStr[numSurfFormats] = {"uchar4", "float", "float4"};
+static const char* surfOpStr[numSurfOps] = {"read", "write", "copy"};
+static const char* accessOrderStr[numAccessOrders] = {"rows", "16x16 tiles", "columns"};
+static const char* storageStr[numStorages] = {"surface", "pitched"};
+
+static const size_t surfFormatSize[numSurfFormats] = {sizeof(uchar4), sizeof(float),
+                                                      sizeof(float4)};
+
+struct Extent {
+  int w;
+  int h;
+  int d;
+  size_t pitch;  // bytes per row of pitched memory
+};
+
+static const Extent surfExtents[numSurfDims] = {{16384, 1, 1}, {4096, 4096, 1}, {256, 256, 256}};
+
+static const unsigned int blockSize = 256;
+static const int tileSize = 16;
+
+template <typename T> __device__ inline T makeValue(unsigned int i);
+template <> __device__ inline uchar4 makeValue<uchar4>(unsigned int i) {
+  return make_uchar4(i, i >> 8, i >> 16, i >> 24);
+}
+template <> __device__ inline float makeValue<float>(unsigned int i) { return i; }
+template <> __device__ inline float4 makeValue<float4>(unsigned int i) {
+  return make_float4(i, i + 1, i + 2, i + 3);
+}
+
+__device__ inline float sumOf(uchar4 v) { return v.x + v.y + v.z + v.w; }
+__device__ inline float sumOf(float v) { return v; }
+__device__ inline float sumOf(float4 v) { return v.x + v.y + v.z + v.w; }
+
+// Element of thread idx in the given order. Tiles and columns walk the x/y
+// plane of one z slice after the other; extents are multiples of the tile size.
+__device__ inline void elementOf(size_t idx, const Extent& e, AccessOrder order, int* x, int* y,
+                                 int* z) {
+  size_t plane = static_cast<size_t>(e.w) * e.h;
+  *z = idx / plane;
+  size_t i = idx % plane;
+  if (order == orderTiles && e.h > 1) {
+    size_t tile = i / (tileSize * tileSize);
+    unsigned int within = i % (tileSize * tileSize);
+    int tilesPerRow = e.w / tileSize;
+    *x = (tile % tilesPerRow) * tileSize + within % tileSize;
+    *y = (tile / tilesPerRow) * tileSize + within / tileSize;
+  } else if (order == orderColumns && e.h > 1) {
+    *x = i / e.h;
+    *y = i % e.h;
+  } else {
+    *x = i % e.w;
+    *y = i / e.w;
+  }
+}
+
+template <SurfDim D, typename T>
+__global__ void surfaceKernel(hipSurfaceObject_t src, hipSurfaceObject_t dst, float* sink,
+                              Extent e, AccessOrder order, SurfOp op) {
+#if !defined(__HIP_NO_IMAGE_SUPPORT) || !__HIP_NO_IMAGE_SUPPORT
+  size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+  int x, y, z;
+  elementOf(idx, e, order, &x, &y, &z);
+  int bytesX = x * sizeof(T);
+  T value;
+  if (op == opWrite) {
+    value = makeValue<T>(idx);
+  } else if (D == dim1D) {
+    surf1Dread(&value, src, bytesX);
+  } else if (D == dim2D) {
+    surf2Dread(&value, src, bytesX, y);
+  } else {
+    surf3Dread(&value, src, bytesX, y, z);
+  }
+  if (op == opRead) {
+    // Never true for the zero filled source, keeps the loads alive
+    if (sumOf(value) == -1.0f) {
+      sink[0] = x;
+    }
+    return;
+  }
+  if (D == dim1D) {
+    surf1Dwrite(value, dst, bytesX);
+  } else if (D == dim2D) {
+    surf2Dwrite(value, dst, bytesX, y);
+  } else {
+    surf3Dwrite(value, dst, bytesX, y, z);
+  }
+#endif
+}
+
+template <typename T>
+__global__ void pitchedKernel(const char* src, char* dst, float* sink, Extent e,
+                              AccessOrder order, SurfOp op) {
+  size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+  int x, y, z;
+  elementOf(idx, e, order, &x, &y, &z);
+  size_t offset = (static_cast<size_t>(z) * e.h + y) * e.pitch + x * sizeof(T);
+  T value = op == opWrite ? makeValue<T>(idx) : *reinterpret_cast<const T*>(src + offset);
+  if (op == opRead) {
+    if (sumOf(value) == -1.0f) {
+      sink[0] = x;
+    }
+    return;
+  }
+  *reinterpret_cast<T*>(dst + offset) = value;
+}
+
+template <typename T> static void launchSurface(SurfDim dim, hipSurfaceObject_t src,
+                                                hipSurfaceObject_t dst, float* sink, Extent e,
+                                                AccessOrder order, SurfOp op, dim3 grid,
+                                                hipStream_t stream) {
+  switch (dim) {
+    case dim1D:
+      hipLaunchKernelGGL((surfaceKernel<dim1D, T>), grid, dim3(blockSize), 0, stream, src, dst,
+                         sink, e, order, op);
+      break;
+    case dim2D:
+      hipLaunchKernelGGL((surfaceKernel<dim2D, T>), grid, dim3(blockSize), 0, stream, src, dst,
+                         sink, e, order, op);
+      break;
+    default:
+      hipLaunchKernelGGL((surfaceKernel<dim3D, T>), grid, dim3(blockSize), 0, stream, src, dst,
+                         sink, e, order, op);
+      break;
+  }
+}
+
+template <typename T> static void launchPitched(const void* src, void* dst, float* sink, Extent e,
+                                                AccessOrder order, SurfOp op, dim3 grid,
+                                                hipStream_t stream) {
+  hipLaunchKernelGGL(pitchedKernel<T>, grid, dim3(blockSize), 0, stream,
+                     static_cast<const char*>(src), static_cast<char*>(dst), sink, e, order, op);
+}
+
+class hipPerfSurfaceBandwidth : public HipPerf::Benchmark {
+ public:
+  hipPerfSurfaceBandwidth() : HipPerf::Benchmark("hipPerfSurfaceBandwidth"),
+      launches_(HipPerf::iterationCount(10)), sink_(nullptr), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&sink_, sizeof(float)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(sink_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override {
+    return numSurfDims * numSurfFormats * numSurfOps * numAccessOrders * numStorages;
+  }
+
+  void run(unsigned int test) override {
+    unsigned int index = test;
+    Storage storage = static_cast<Storage>(index % numStorages);
+    index /= numStorages;
+    AccessOrder order = static_cast<AccessOrder>(index % numAccessOrders);
+    index /= numAccessOrders;
+    SurfOp op = static_cast<SurfOp>(index % numSurfOps);
+    index /= numSurfOps;
+    SurfFormat format = static_cast<SurfFormat>(index % numSurfFormats);
+    SurfDim dim = static_cast<SurfDim>(index / numSurfFormats);
+
+    if (dim == dim1D && order != orderRows) {
+      return;
+    }
+    if (storage == storageSurface && !HipTest::isImageSupported()) {
+      printf("info: surfaces are not supported on the device, skipping\n");
+      return;
+    }
+
+    Extent extent = surfExtents[dim];
+    size_t elements = static_cast<size_t>(extent.w) * extent.h * extent.d;
+    size_t size = surfFormatSize[format];
+    dim3 grid(elements / blockSize);
+    Buffer src = allocate(dim, format, storage, &extent);
+    Buffer dst = allocate(dim, format, storage, &extent);
+
+    auto sec = measure([&]() {
+      for (unsigned int l = 0; l < launches_; l++) {
+        if (storage == storageSurface) {
+          switch (format) {
+            case fmtUchar4:
+              launchSurface<uchar4>(dim, src.surface, dst.surface, sink_, extent, order, op, grid,
+                                    stream_);
+              break;
+            case fmtFloat:
+              launchSurface<float>(dim, src.surface, dst.surface, sink_, extent, order, op, grid,
+                                   stream_);
+              break;
+            default:
+              launchSurface<float4>(dim, src.surface, dst.surface, sink_, extent, order, op, grid,
+                                    stream_);
+              break;
+          }
+        } else {
+          switch (format) {
+            case fmtUchar4:
+              launchPitched<uchar4>(src.ptr, dst.ptr, sink_, extent, order, op, grid, stream_);
+              break;
+            case fmtFloat:
+              launchPitched<float>(src.ptr, dst.ptr, sink_, extent, order, op, grid, stream_);
+              break;
+            default:
+              launchPitched<float4>(src.ptr, dst.ptr, sink_, extent, order, op, grid, stream_);
+              break;
+          }
+        }
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    release(src);
+    release(dst);
+
+    double bytes = static_cast<double>(elements) * size * (op == opCopy ? 2 : 1) * launches_;
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%-2s %-6s %-5s %-11s %s", surfDimStr[dim],
+             surfFormatStr[format], surfOpStr[op], accessOrderStr[order], storageStr[storage]);
+    report(test, desc, elements * size, launches_, "GB/s", HipPerf::toBandwidth(sec, bytes));
+  }
+
+ private:
+  struct Buffer {
+    hipArray_t array;
+    hipSurfaceObject_t surface;
+    void* ptr;
+  };
+
+  // Allocates zero filled storage; sets extent->pitch for pitched memory.
+  Buffer allocate(SurfDim dim, SurfFormat format, Storage storage, Extent* extent) {
+    Buffer buffer = {nullptr, 0, nullptr};
+    size_t rowBytes = extent->w * surfFormatSize[format];
+    if (storage == storagePitched) {
+      if (dim == dim1D) {
+        HIPCHECK(hipMalloc(&buffer.ptr, rowBytes));
+        extent->pitch = rowBytes;
+        HIPCHECK(hipMemset(buffer.ptr, 0, rowBytes));
+      } else if (dim == dim2D) {
+        HIPCHECK(hipMallocPitch(&buffer.ptr, &extent->pitch, rowBytes, extent->h));
+        HIPCHECK(hipMemset2D(buffer.ptr, extent->pitch, 0, rowBytes, extent->h));
+      } else {
+        hipPitchedPtr pitched;
+        hipExtent bytes = make_hipExtent(rowBytes, extent->h, extent->d);
+        HIPCHECK(hipMalloc3D(&pitched, bytes));
+        HIPCHECK(hipMemset3D(pitched, 0, bytes));
+        buffer.ptr = pitched.ptr;
+        extent->pitch = pitched.pitch;
+      }
+      return buffer;
+    }
+
+    hipChannelFormatDesc desc = format == fmtUchar4 ? hipCreateChannelDesc<uchar4>()
+        : format == fmtFloat ? hipCreateChannelDesc<float>() : hipCreateChannelDesc<float4>();
+    if (dim == dim3D) {
+      HIPCHECK(hipMalloc3DArray(&buffer.array, &desc,
+                                make_hipExtent(extent->w, extent->h, extent->d),
+                                hipArraySurfaceLoadStore));
+    } else {
+      HIPCHECK(hipMallocArray(&buffer.array, &desc, extent->w, dim == dim1D ? 0 : extent->h,
+                              hipArraySurfaceLoadStore));
+    }
+    clearArray(dim, format, buffer.array, *extent);
+    hipResourceDesc resDesc;
+    memset(&resDesc, 0, sizeof(resDesc));
+    resDesc.resType = hipResourceTypeArray;
+    resDesc.res.array.array = buffer.array;
+    HIPCHECK(hipCreateSurfaceObject(&buffer.surface, &resDesc));
+    return buffer;
+  }
+
+  // Copies zeros into the array, array allocations are not zero filled
+  void clearArray(SurfDim dim, SurfFormat format, hipArray_t array, const Extent& extent) {
+    size_t rowBytes = extent.w * surfFormatSize[format];
+    std::vector<char> zeros(rowBytes * extent.h * extent.d, 0);
+    if (dim == dim3D) {
+      hipMemcpy3DParms params;
+      memset(&params, 0, sizeof(params));
+      params.srcPtr = make_hipPitchedPtr(zeros.data(), rowBytes, extent.w, extent.h);
+      params.dstArray = array;
+      params.extent = make_hipExtent(extent.w, extent.h, extent.d);
+      params.kind = hipMemcpyHostToDevice;
+      HIPCHECK(hipMemcpy3D(&params));
+    } else {
+      HIPCHECK(hipMemcpy2DToArray(array, 0, 0, zeros.data(), rowBytes, rowBytes, extent.h,
+                                  hipMemcpyHostToDevice));
+    }
+  }
+
+  void release(const Buffer& buffer) {
+    if (buffer.array != nullptr) {
+      HIPCHECK(hipDestroySurfaceObject(buffer.surface));
+      HIPCHECK(hipFreeArray(buffer.array));
+    } else {
+      HIPCHECK(hipFree(buffer.ptr));
+    }
+  }
+
+  unsigned int launches_;
+  float* sink_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfSurfaceBandwidth)
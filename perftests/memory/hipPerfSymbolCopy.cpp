@@ -0,0 +1,287 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Overhead of the symbol copy path for __constant__ data. For copy sizes of
+// 4 B to 64 KB (--sizes or --sweep replace them) hipMemcpyToSymbol,
+// hipMemcpyFromSymbol and their Async forms (followed by a stream synchronize)
+// are timed one copy at a time against the same copy with hipMemcpy(Async) to
+// the pointer hipGetSymbolAddress returns, and the ratio to the pointer copy
+// is reported. A second group times a 256 B parameter block update plus a
+// small kernel launch per iteration, updated through the symbol, through the
+// symbol address or passed as kernel argument. The last group reads the 64 KB
+// table from kernels with one index for all threads of a wave and with a
+// different index per thread, the latter serializes constant cache accesses.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const size_t constFloats = 16384;
+__constant__ float constTable[constFloats];
+
+static const size_t defaultCopySizes[] = {4, 64, 256, 1024, 4096, 65536};
+
+// Pointer copies come first in every pair, the symbol copy is compared against them
+enum CopyMethod {
+  copyToAddress = 0,
+  copyToSymbol,
+  copyToAddressAsync,
+  copyToSymbolAsync,
+  copyFromAddress,
+  copyFromSymbol,
+  copyFromAddressAsync,
+  copyFromSymbolAsync,
+  numCopyMethods
+};
+static const char* copyMethodStr[numCopyMethods] = {
+    "hipMemcpy H2D to symbol address", "hipMemcpyToSymbol",
+    "hipMemcpyAsync H2D to symbol address", "hipMemcpyToSymbolAsync",
+    "hipMemcpy D2H from symbol address", "hipMemcpyFromSymbol",
+    "hipMemcpyAsync D2H from symbol address", "hipMemcpyFromSymbolAsync"};
+
+enum UpdateMethod { updateSymbol = 0, updateAddress, updateArgument, numUpdateMethods };
+static const char* updateMethodStr[numUpdateMethods] = {
+    "hipMemcpyToSymbolAsync + launch", "hipMemcpyAsync to symbol address + launch",
+    "kernel argument + launch"};
+
+enum ReadPattern { readUniform = 0, readDivergent, numReadPatterns };
+static const char* readPatternStr[numReadPatterns] = {"uniform index", "divergent index"};
+
+static const unsigned int copiesPerTest = 100;
+static const unsigned int updatesPerRep = 100;
+static const unsigned int paramFloats = 64;
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 8;
+static const unsigned int readsPerThread = 1024;
+
+struct ParamBlock {
+  float values[paramFloats];
+};
+
+__global__ void paramsFromConstant(float* out) {
+  out[threadIdx.x] = constTable[threadIdx.x % paramFloats];
+}
+
+__global__ void paramsFromArgument(float* out, ParamBlock params) {
+  out[threadIdx.x] = params.values[threadIdx.x % paramFloats];
+}
+
+template <ReadPattern pattern>
+__global__ void constantRead(float* out, unsigned int reads) {
+  unsigned int tid = blockIdx.x * blockDim.x + threadIdx.x;
+  unsigned int lane = pattern == readUniform ? 0 : threadIdx.x * 97;
+  float sum = 0;
+  for (unsigned int r = 0; r < reads; r++) {
+    sum += constTable[(lane + r * 13) & (constFloats - 1)];
+  }
+  out[tid] = sum;
+}
+
+class hipPerfSymbolCopy : public HipPerf::Benchmark {
+ public:
+  hipPerfSymbolCopy() : HipPerf::Benchmark("hipPerfSymbolCopy"),
+      copySizes_(HipPerf::sweepSizes(std::vector<size_t>(
+          defaultCopySizes, defaultCopySizes + sizeof(defaultCopySizes) /
+                                                   sizeof(defaultCopySizes[0])))),
+      symbolAddress_(nullptr), host_(nullptr), out_(nullptr), stream_(nullptr),
+      pointerMedian_(0), uniformMedian_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    size_t symbolSize = 0;
+    HIPCHECK(hipGetSymbolAddress(&symbolAddress_, HIP_SYMBOL(constTable)));
+    HIPCHECK(hipGetSymbolSize(&symbolSize, HIP_SYMBOL(constTable)));
+    if (symbolSize != sizeof(constTable)) {
+      failed("hipGetSymbolSize returned %zu, expected %zu\n", symbolSize, sizeof(constTable));
+    }
+    HIPCHECK(hipHostMalloc(&host_, sizeof(constTable)));
+    for (size_t i = 0; i < constFloats; i++) {
+      host_[i] = static_cast<float>(i);
+    }
+    HIPCHECK(hipMemcpyToSymbol(HIP_SYMBOL(constTable), host_, sizeof(constTable)));
+    grid_ = dim3(props_.multiProcessorCount * blocksPerCu);
+    HIPCHECK(hipMalloc(&out_, static_cast<size_t>(grid_.x) * blockSize * sizeof(float)));
+    HIPCHECK(hipStreamCreate(&stream_));
+  }
+
+  void close() override {
+    HIPCHECK(hipStreamDestroy(stream_));
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipHostFree(host_));
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(copySizes_.size()) * numCopyMethods + numUpdateMethods +
+        numReadPatterns;
+  }
+
+  void run(unsigned int test) override {
+    unsigned int copyTests = static_cast<unsigned int>(copySizes_.size()) * numCopyMethods;
+    if (test < copyTests) {
+      runCopy(test, static_cast<CopyMethod>(test % numCopyMethods),
+              copySizes_[test / numCopyMethods]);
+    } else if (test < copyTests + numUpdateMethods) {
+      runUpdate(test, static_cast<UpdateMethod>(test - copyTests));
+    } else {
+      runRead(test, static_cast<ReadPattern>(test - copyTests - numUpdateMethods));
+    }
+  }
+
+ private:
+  void runCopy(unsigned int test, CopyMethod method, size_t bytes) {
+    if (bytes > sizeof(constTable)) {
+      printf("info: %zu B exceeds the %zu B symbol, skipping\n", bytes, sizeof(constTable));
+      return;
+    }
+    auto latency = measureEach([&]() {
+      switch (method) {
+        case copyToAddress:
+          HIPCHECK(hipMemcpy(symbolAddress_, host_, bytes, hipMemcpyHostToDevice));
+          break;
+        case copyToSymbol:
+          HIPCHECK(hipMemcpyToSymbol(HIP_SYMBOL(constTable), host_, bytes));
+          break;
+        case copyToAddressAsync:
+          HIPCHECK(hipMemcpyAsync(symbolAddress_, host_, bytes, hipMemcpyHostToDevice, stream_));
+          HIPCHECK(hipStreamSynchronize(stream_));
+          break;
+        case copyToSymbolAsync:
+          HIPCHECK(hipMemcpyToSymbolAsync(HIP_SYMBOL(constTable), host_, bytes, 0,
+                                          hipMemcpyHostToDevice, stream_));
+          HIPCHECK(hipStreamSynchronize(stream_));
+          break;
+        case copyFromAddress:
+          HIPCHECK(hipMemcpy(host_, symbolAddress_, bytes, hipMemcpyDeviceToHost));
+          break;
+        case copyFromSymbol:
+          HIPCHECK(hipMemcpyFromSymbol(host_, HIP_SYMBOL(constTable), bytes));
+          break;
+        case copyFromAddressAsync:
+          HIPCHECK(hipMemcpyAsync(host_, symbolAddress_, bytes, hipMemcpyDeviceToHost, stream_));
+          HIPCHECK(hipStreamSynchronize(stream_));
+          break;
+        default:
+          HIPCHECK(hipMemcpyFromSymbolAsync(host_, HIP_SYMBOL(constTable), bytes, 0,
+                                            hipMemcpyDeviceToHost, stream_));
+          HIPCHECK(hipStreamSynchronize(stream_));
+          break;
+      }
+    }, copiesPerTest);
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-38s %6zu B", copyMethodStr[method], bytes);
+    auto us = HipPerf::toMicroseconds(latency, 1);
+    report(test, desc, bytes, 1, "us", us);
+    if (method % 2 == 0) {
+      pointerMedian_ = median(us);
+    } else if (pointerMedian_ > 0) {
+      std::vector<double> ratio;
+      for (double u : us) {
+        ratio.push_back(u / pointerMedian_);
+      }
+      report(test, std::string(desc) + " vs symbol address", bytes, 1, "x", ratio);
+    }
+  }
+
+  void runUpdate(unsigned int test, UpdateMethod method) {
+    ParamBlock params;
+    for (unsigned int i = 0; i < paramFloats; i++) {
+      params.values[i] = static_cast<float>(i);
+    }
+    auto sec = measure([&]() {
+      for (unsigned int u = 0; u < updatesPerRep; u++) {
+        params.values[0] = static_cast<float>(u);
+        switch (method) {
+          case updateSymbol:
+            HIPCHECK(hipMemcpyToSymbolAsync(HIP_SYMBOL(constTable), &params, sizeof(params), 0,
+                                            hipMemcpyHostToDevice, stream_));
+            hipLaunchKernelGGL(paramsFromConstant, dim3(1), dim3(blockSize), 0, stream_, out_);
+            break;
+          case updateAddress:
+            HIPCHECK(hipMemcpyAsync(symbolAddress_, &params, sizeof(params),
+                                    hipMemcpyHostToDevice, stream_));
+            hipLaunchKernelGGL(paramsFromConstant, dim3(1), dim3(blockSize), 0, stream_, out_);
+            break;
+          default:
+            hipLaunchKernelGGL(paramsFromArgument, dim3(1), dim3(blockSize), 0, stream_, out_,
+                               params);
+            break;
+        }
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    report(test, updateMethodStr[method], sizeof(ParamBlock), updatesPerRep, "us",
+           HipPerf::toMicroseconds(sec, updatesPerRep));
+  }
+
+  void runRead(unsigned int test, ReadPattern pattern) {
+    auto sec = measure([&]() {
+      if (pattern == readUniform) {
+        hipLaunchKernelGGL(constantRead<readUniform>, grid_, dim3(blockSize), 0, 0, out_,
+                           readsPerThread);
+      } else {
+        hipLaunchKernelGGL(constantRead<readDivergent>, grid_, dim3(blockSize), 0, 0, out_,
+                           readsPerThread);
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipDeviceSynchronize());
+    });
+
+    size_t bytes = static_cast<size_t>(grid_.x) * blockSize * readsPerThread * sizeof(float);
+    std::string desc = std::string("__constant__ read ") + readPatternStr[pattern];
+    auto bandwidth = HipPerf::toBandwidth(sec, static_cast<double>(bytes));
+    report(test, desc, bytes, 1, "GB/s", bandwidth);
+    if (pattern == readUniform) {
+      uniformMedian_ = median(bandwidth);
+    } else if (uniformMedian_ > 0) {
+      std::vector<double> ratio;
+      for (double b : bandwidth) {
+        ratio.push_back(b / uniformMedian_);
+      }
+      report(test, desc + " vs uniform", bytes, 1, "x", ratio);
+    }
+  }
+
+  static double median(std::vector<double> values) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+  }
+
+  std::vector<size_t> copySizes_;
+  void* symbolAddress_;
+  float* host_;
+  float* out_;
+  hipStream_t stream_;
+  dim3 grid_;
+  double pointerMedian_;  // last pointer copy, reference for the symbol copy after it
+  double uniformMedian_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfSymbolCopy)
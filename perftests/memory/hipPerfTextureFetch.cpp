@@ -0,0 +1,385 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Texture sampling rate against equivalent global memory loads. 1D, 2D, 3D
+// and 2D layered textures of uchar4 (read as normalized float), float and
+// float4 texels are sampled with point and linear filtering, with pixel
+// coordinates and clamping and with normalized coordinates and wrapping.
+// The global memory version of every shape and format loads the nearest
+// texel, or the 2, 4 or 8 neighbours blended in the kernel for linear
+// filtering. A 2D mipmapped float texture is sampled at levels 0 to 3 where
+// mipmaps are supported. Every thread takes samplesPerThread samples,
+// neighbouring threads read neighbouring texels. Reports Gtexels/s.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "perf_harness.h"
+
+enum TexDim { dim1D = 0, dim2D, dim3D, dim2DLayered, numTexDims };
+enum TexFormat { fmtUchar4 = 0, fmtFloat, fmtFloat4, numTexFormats };
+enum TexFilter { filterPoint = 0, filterLinear, numTexFilters };
+enum TexSource { srcTexturePixelClamp = 0, srcTextureNormalizedWrap, srcGlobal, numTexSources };
+
+static const char* texDimStr[numTexDims] = {"1D", "2D", "3D", "2D layered"};
+static const char* texFormatStr[numTexFormats] = {"uchar4", "float", "float4"};
+static const char* texFilterStr[numTexFilters] = {"point", "linear"};
+static const char* texSourceStr[numTexSources] = {"texture pixel coords clamp",
+                                                  "texture normalized coords wrap",
+                                                  "global memory"};
+
+static const size_t texFormatSize[numTexFormats] = {sizeof(uchar4), sizeof(float),
+                                                    sizeof(float4)};
+
+struct Shape {
+  int w;
+  int h;
+  int d;       // depth or layers
+  float sx;    // coordinate scale, 1 for pixel coordinates, 1 / extent when normalized
+  float sy;
+  float sz;
+  float lod;
+};
+
+static const Shape texShapes[numTexDims] = {{16384, 1, 1},
+                                            {2048, 2048, 1},
+                                            {128, 128, 128},
+                                            {1024, 1024, 8}};
+
+static const unsigned int mipLevels = 4;
+static const int mipExtent = 2048;
+
+static const unsigned int blockSize = 256;
+static const size_t threadCount = 4 * 1024 * 1024;
+static const unsigned int samplesPerThread = 4;
+
+__device__ inline float4 toValue(uchar4 v) {
+  return make_float4(v.x / 255.0f, v.y / 255.0f, v.z / 255.0f, v.w / 255.0f);
+}
+__device__ inline float toValue(float v) { return v; }
+__device__ inline float4 toValue(float4 v) { return v; }
+
+__device__ inline float sumOf(float v) { return v; }
+__device__ inline float sumOf(float4 v) { return v.x + v.y + v.z + v.w; }
+
+// Texel of thread idx, neighbouring threads take neighbouring texels
+__device__ inline void texelOf(size_t idx, const Shape& s, int* x, int* y, int* z) {
+  size_t t = idx % (static_cast<size_t>(s.w) * s.h * s.d);
+  *x = t % s.w;
+  *y = (t / s.w) % s.h;
+  *z = t / (static_cast<size_t>(s.w) * s.h);
+}
+
+// R is the value type returned by the texture fetch; 'mip' samples level s.lod of a 2D mipmap
+template <TexDim D, typename R, bool mip>
+__global__ void textureKernel(hipTextureObject_t tex, float* out, Shape s) {
+#if !defined(__HIP_NO_IMAGE_SUPPORT) || !__HIP_NO_IMAGE_SUPPORT
+  size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+  int x, y, z;
+  texelOf(idx, s, &x, &y, &z);
+  R acc{};
+  for (unsigned int k = 0; k < samplesPerThread; k++) {
+    // A quarter texel off the centre, so linear filtering blends
+    float fx = (x + k * blockSize + 0.75f) * s.sx;
+    float fy = (y + 0.75f) * s.sy;
+    float fz = (z + 0.75f) * s.sz;
+    if (mip) {
+      acc += tex2DLod<R>(tex, fx, fy, s.lod);
+    } else if (D == dim1D) {
+      acc += tex1D<R>(tex, fx);
+    } else if (D == dim2D) {
+      acc += tex2D<R>(tex, fx, fy);
+    } else if (D == dim3D) {
+      acc += tex3D<R>(tex, fx, fy, fz);
+    } else {
+      acc += tex2DLayered<R>(tex, fx, fy, z);
+    }
+  }
+  out[idx] = sumOf(acc);
+#endif
+}
+
+template <typename T>
+__device__ inline decltype(toValue(T())) loadTexel(const T* data, const Shape& s, int x, int y,
+                                                   int z) {
+  x = min(max(x, 0), s.w - 1);
+  y = min(max(y, 0), s.h - 1);
+  return toValue(data[(static_cast<size_t>(z) * s.h + y) * s.w + x]);
+}
+
+// Same sample positions as textureKernel with pixel coordinates and clamping
+template <TexDim D, typename T, TexFilter F>
+__global__ void globalKernel(const T* data, float* out, Shape s) {
+  size_t idx = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+  int x, y, z;
+  texelOf(idx, s, &x, &y, &z);
+  decltype(toValue(T())) acc{};
+  for (unsigned int k = 0; k < samplesPerThread; k++) {
+    int px = x + k * blockSize;
+    if (F == filterPoint) {
+      acc += loadTexel(data, s, px, y, z);
+      continue;
+    }
+    // Weights 0.75 / 0.25 between the texel and its successor along every filtered axis
+    unsigned int corners = D == dim1D ? 2 : D == dim3D ? 8 : 4;
+    for (unsigned int c = 0; c < corners; c++) {
+      float weight = (c & 1 ? 0.25f : 0.75f);
+      if (D != dim1D) {
+        weight *= (c & 2 ? 0.25f : 0.75f);
+      }
+      if (D == dim3D) {
+        weight *= (c & 4 ? 0.25f : 0.75f);
+      }
+      int pz = D == dim3D ? min(z + ((c >> 2) & 1), s.d - 1) : z;
+      acc += loadTexel(data, s, px + (c & 1), y + ((c >> 1) & 1), pz) * weight;
+    }
+  }
+  out[idx] = sumOf(acc);
+}
+
+typedef void (*TextureLaunch)(hipTextureObject_t tex, float* out, Shape s, hipStream_t stream);
+typedef void (*GlobalLaunch)(const void* data, float* out, Shape s, hipStream_t stream);
+
+template <TexDim D, typename R, bool mip>
+static void launchTexture(hipTextureObject_t tex, float* out, Shape s, hipStream_t stream) {
+  hipLaunchKernelGGL((textureKernel<D, R, mip>), dim3(threadCount / blockSize), dim3(blockSize), 0,
+                     stream, tex, out, s);
+}
+
+template <TexDim D, typename T, TexFilter F>
+static void launchGlobal(const void* data, float* out, Shape s, hipStream_t stream) {
+  hipLaunchKernelGGL((globalKernel<D, T, F>), dim3(threadCount / blockSize), dim3(blockSize), 0,
+                     stream, static_cast<const T*>(data), out, s);
+}
+
+template <typename R> static TextureLaunch textureLaunchFor(TexDim dim) {
+  switch (dim) {
+    case dim1D: return launchTexture<dim1D, R, false>;
+    case dim2D: return launchTexture<dim2D, R, false>;
+    case dim3D: return launchTexture<dim3D, R, false>;
+    default: return launchTexture<dim2DLayered, R, false>;
+  }
+}
+
+template <typename T, TexFilter F> static GlobalLaunch globalLaunchFor(TexDim dim) {
+  switch (dim) {
+    case dim1D: return launchGlobal<dim1D, T, F>;
+    case dim2D: return launchGlobal<dim2D, T, F>;
+    case dim3D: return launchGlobal<dim3D, T, F>;
+    default: return launchGlobal<dim2DLayered, T, F>;
+  }
+}
+
+template <typename T> static GlobalLaunch globalLaunchFor(TexDim dim, TexFilter filter) {
+  return filter == filterPoint ? globalLaunchFor<T, filterPoint>(dim)
+                               : globalLaunchFor<T, filterLinear>(dim);
+}
+
+static hipChannelFormatDesc channelDescOf(TexFormat format) {
+  switch (format) {
+    case fmtUchar4: return hipCreateChannelDesc<uchar4>();
+    case fmtFloat: return hipCreateChannelDesc<float>();
+    default: return hipCreateChannelDesc<float4>();
+  }
+}
+
+class hipPerfTextureFetch : public HipPerf::Benchmark {
+ public:
+  hipPerfTextureFetch() : HipPerf::Benchmark("hipPerfTextureFetch"),
+      launches_(HipPerf::iterationCount(10)), out_(nullptr), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&out_, threadCount * sizeof(float)));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  // Mipmap levels follow the plain shapes, one test per level and filter
+  unsigned int numTests() override {
+    return numTexDims * numTexFormats * numTexFilters * numTexSources +
+        mipLevels * numTexFilters;
+  }
+
+  void run(unsigned int test) override {
+    if (!HipTest::isImageSupported()) {
+      printf("info: texture is not supported on the device, skipping\n");
+      return;
+    }
+    unsigned int plainTests = numTexDims * numTexFormats * numTexFilters * numTexSources;
+    if (test >= plainTests) {
+      runMipmap(test, (test - plainTests) / numTexFilters,
+                static_cast<TexFilter>((test - plainTests) % numTexFilters));
+      return;
+    }
+    unsigned int index = test;
+    TexSource source = static_cast<TexSource>(index % numTexSources);
+    index /= numTexSources;
+    TexFilter filter = static_cast<TexFilter>(index % numTexFilters);
+    index /= numTexFilters;
+    TexFormat format = static_cast<TexFormat>(index % numTexFormats);
+    TexDim dim = static_cast<TexDim>(index / numTexFormats);
+
+    Shape shape = texShapes[dim];
+    shape.sx = shape.sy = shape.sz = 1.0f;
+    size_t texels = static_cast<size_t>(shape.w) * shape.h * shape.d;
+    std::function<void()> launch;
+    void* data = nullptr;
+    hipArray_t array = nullptr;
+    hipTextureObject_t tex = 0;
+
+    if (source == srcGlobal) {
+      HIPCHECK(hipMalloc(&data, texels * texFormatSize[format]));
+      HIPCHECK(hipMemset(data, 0, texels * texFormatSize[format]));
+      GlobalLaunch global = format == fmtUchar4 ? globalLaunchFor<uchar4>(dim, filter)
+          : format == fmtFloat ? globalLaunchFor<float>(dim, filter)
+                               : globalLaunchFor<float4>(dim, filter);
+      launch = [&]() { global(data, out_, shape, stream_); };
+    } else {
+      bool normalized = source == srcTextureNormalizedWrap;
+      if (normalized) {
+        shape.sx = 1.0f / shape.w;
+        shape.sy = 1.0f / shape.h;
+        shape.sz = 1.0f / shape.d;
+      }
+      hipChannelFormatDesc channelDesc = channelDescOf(format);
+      switch (dim) {
+        case dim1D:
+          HIPCHECK(hipMallocArray(&array, &channelDesc, shape.w, 0, hipArrayDefault));
+          break;
+        case dim2D:
+          HIPCHECK(hipMallocArray(&array, &channelDesc, shape.w, shape.h, hipArrayDefault));
+          break;
+        case dim3D:
+          HIPCHECK(hipMalloc3DArray(&array, &channelDesc, make_hipExtent(shape.w, shape.h, shape.d),
+                                    hipArrayDefault));
+          break;
+        default:
+          HIPCHECK(hipMalloc3DArray(&array, &channelDesc, make_hipExtent(shape.w, shape.h, shape.d),
+                                    hipArrayLayered));
+          break;
+      }
+      hipResourceDesc resDesc;
+      memset(&resDesc, 0, sizeof(resDesc));
+      resDesc.resType = hipResourceTypeArray;
+      resDesc.res.array.array = array;
+      tex = createTexture(resDesc, format, filter, normalized);
+      TextureLaunch texture = format == fmtFloat ? textureLaunchFor<float>(dim)
+                                                 : textureLaunchFor<float4>(dim);
+      launch = [&]() { texture(tex, out_, shape, stream_); };
+    }
+
+    auto sec = measure([&]() {
+      for (unsigned int l = 0; l < launches_; l++) {
+        launch();
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    if (tex != 0) {
+      HIPCHECK(hipDestroyTextureObject(tex));
+      HIPCHECK(hipFreeArray(array));
+    }
+    if (data != nullptr) {
+      HIPCHECK(hipFree(data));
+    }
+
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%-10s %-6s %-6s %s", texDimStr[dim], texFormatStr[format],
+             texFilterStr[filter], texSourceStr[source]);
+    report(test, desc, texels * texFormatSize[format], launches_, "Gtexels/s",
+           toTexelRate(sec));
+  }
+
+ private:
+  hipTextureObject_t createTexture(const hipResourceDesc& resDesc, TexFormat format,
+                                   TexFilter filter, bool normalized) {
+    hipTextureDesc texDesc;
+    memset(&texDesc, 0, sizeof(texDesc));
+    for (int i = 0; i < 3; i++) {
+      texDesc.addressMode[i] = normalized ? hipAddressModeWrap : hipAddressModeClamp;
+    }
+    texDesc.filterMode = filter == filterPoint ? hipFilterModePoint : hipFilterModeLinear;
+    texDesc.mipmapFilterMode = texDesc.filterMode;
+    texDesc.maxMipmapLevelClamp = static_cast<float>(mipLevels - 1);
+    texDesc.readMode = format == fmtUchar4 ? hipReadModeNormalizedFloat : hipReadModeElementType;
+    texDesc.normalizedCoords = normalized;
+    hipTextureObject_t tex = 0;
+    HIPCHECK(hipCreateTextureObject(&tex, &resDesc, &texDesc, nullptr));
+    return tex;
+  }
+
+  void runMipmap(unsigned int test, unsigned int level, TexFilter filter) {
+    hipChannelFormatDesc channelDesc = channelDescOf(fmtFloat);
+    hipMipmappedArray_t mipmap = nullptr;
+    if (hipMallocMipmappedArray(&mipmap, &channelDesc, make_hipExtent(mipExtent, mipExtent, 0),
+                                mipLevels, 0) != hipSuccess) {
+      printf("info: mipmapped arrays are not supported, skipping\n");
+      return;
+    }
+    hipResourceDesc resDesc;
+    memset(&resDesc, 0, sizeof(resDesc));
+    resDesc.resType = hipResourceTypeMipmappedArray;
+    resDesc.res.mipmap.mipmap = mipmap;
+    hipTextureObject_t tex = createTexture(resDesc, fmtFloat, filter, true);
+
+    // Threads cover the selected level, coordinates are normalized
+    int extent = mipExtent >> level;
+    Shape shape = {extent, extent, 1, 1.0f / extent, 1.0f / extent, 1.0f,
+                   static_cast<float>(level)};
+    auto sec = measure([&]() {
+      for (unsigned int l = 0; l < launches_; l++) {
+        launchTexture<dim2D, float, true>(tex, out_, shape, stream_);
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    HIPCHECK(hipDestroyTextureObject(tex));
+    HIPCHECK(hipFreeMipmappedArray(mipmap));
+
+    char desc[128];
+    snprintf(desc, sizeof(desc), "2D mipmap  float  %-6s level %u of %d", texFilterStr[filter],
+             level, mipExtent);
+    report(test, desc, static_cast<size_t>(extent) * extent * sizeof(float), launches_,
+           "Gtexels/s", toTexelRate(sec));
+  }
+
+  std::vector<double> toTexelRate(const std::vector<double>& sec) {
+    std::vector<double> rates;
+    for (double s : sec) {
+      rates.push_back(static_cast<double>(threadCount) * samplesPerThread * launches_ / s / 1e9);
+    }
+    return rates;
+  }
+
+  unsigned int launches_;
+  float* out_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfTextureFetch)
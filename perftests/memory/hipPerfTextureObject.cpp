@@ -0,0 +1,231 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Host cost of texture object lifetime management. For a 2D array, a linear
+// buffer and a pitched 2D allocation of 1024x1024 floats, with a point
+// sampled, clamped, unnormalized descriptor and (except for linear memory) a
+// linear filtered, wrapped, normalized one, it reports the latency of single
+// hipCreateTextureObject and hipDestroyTextureObject calls, and the time per
+// request of a small fetch kernel plus stream synchronize when the object is
+// created and destroyed for every request against one cached object. The
+// difference of the last two is what per request creation costs.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum TexResource { resourceArray = 0, resourceLinear, resourcePitch2D, numTexResources };
+static const char* texResourceStr[numTexResources] = {"array 2D", "linear", "pitch 2D"};
+
+enum TexDescriptor { descriptorPoint = 0, descriptorLinear, numTexDescriptors };
+static const char* texDescriptorStr[numTexDescriptors] = {"point clamp",
+                                                          "linear wrap normalized"};
+
+enum TexMeasure { measureCreate = 0, measureDestroy, measurePerRequest, measureCached,
+                  numTexMeasures };
+static const char* texMeasureStr[numTexMeasures] = {
+    "hipCreateTextureObject", "hipDestroyTextureObject", "create + fetch + destroy per request",
+    "fetch with cached object"};
+
+static const size_t texWidth = 1024;
+static const size_t texHeight = 1024;
+static const unsigned int callsPerTest = 100;
+static const unsigned int blockSize = 256;
+
+__global__ void fetchLinear(hipTextureObject_t tex, float* out) {
+  out[threadIdx.x] = tex1Dfetch<float>(tex, threadIdx.x);
+}
+
+__global__ void fetch2D(hipTextureObject_t tex, float* out) {
+  out[threadIdx.x] = tex2D<float>(tex, threadIdx.x + 0.5f, 0.5f);
+}
+
+class hipPerfTextureObject : public HipPerf::Benchmark {
+ public:
+  hipPerfTextureObject() : HipPerf::Benchmark("hipPerfTextureObject"), array_(nullptr),
+      linear_(nullptr), pitched_(nullptr), pitch_(0), out_(nullptr), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    if (!HipTest::isImageSupported()) {
+      printf("info: texture is not supported on the device, skipping\n");
+      return;
+    }
+    hipChannelFormatDesc channelDesc = hipCreateChannelDesc<float>();
+    HIPCHECK(hipMallocArray(&array_, &channelDesc, texWidth, texHeight, hipArrayDefault));
+    HIPCHECK(hipMalloc(&linear_, texWidth * texHeight * sizeof(float)));
+    HIPCHECK(hipMallocPitch(&pitched_, &pitch_, texWidth * sizeof(float), texHeight));
+    HIPCHECK(hipMalloc(&out_, blockSize * sizeof(float)));
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override {
+    if (out_ == nullptr) {
+      return;
+    }
+    HIPCHECK(hipStreamDestroy(stream_));
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipFree(pitched_));
+    HIPCHECK(hipFree(linear_));
+    HIPCHECK(hipFreeArray(array_));
+  }
+
+  unsigned int numTests() override {
+    return numTexResources * numTexDescriptors * numTexMeasures;
+  }
+
+  void run(unsigned int test) override {
+    TexMeasure what = static_cast<TexMeasure>(test % numTexMeasures);
+    TexDescriptor descriptor = static_cast<TexDescriptor>(test / numTexMeasures %
+                                                          numTexDescriptors);
+    TexResource resource = static_cast<TexResource>(test / (numTexMeasures * numTexDescriptors));
+    if (out_ == nullptr) {
+      return;
+    }
+    // Linear memory allows neither filtering nor normalized coordinates
+    if (resource == resourceLinear && descriptor != descriptorPoint) {
+      return;
+    }
+
+    hipResourceDesc resDesc = resourceDesc(resource);
+    hipTextureDesc texDesc = textureDesc(descriptor);
+    auto create = [&]() {
+      hipTextureObject_t tex = 0;
+      HIPCHECK(hipCreateTextureObject(&tex, &resDesc, &texDesc, nullptr));
+      return tex;
+    };
+    auto fetch = [&](hipTextureObject_t tex) {
+      if (resource == resourceLinear) {
+        hipLaunchKernelGGL(fetchLinear, dim3(1), dim3(blockSize), 0, stream_, tex, out_);
+      } else {
+        hipLaunchKernelGGL(fetch2D, dim3(1), dim3(blockSize), 0, stream_, tex, out_);
+      }
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipStreamSynchronize(stream_));
+    };
+
+    std::vector<hipTextureObject_t> objects;
+    std::vector<double> sec;
+    switch (what) {
+      case measureCreate:
+        sec = measureEach([&]() { objects.push_back(create()); }, callsPerTest);
+        break;
+      case measureDestroy: {
+        // One object for every warm-up and timed call, destroyed in a loop of its own as
+        // --target-ci and --counters change the number of measureEach() calls
+        for (unsigned int i = 0; i < p_warmup + callsPerTest * p_repetitions; i++) {
+          objects.push_back(create());
+        }
+        CPerfSampler destroy;
+        for (size_t i = 0; i < objects.size(); i++) {
+          bool timed = i >= p_warmup;
+          if (timed) destroy.Start();
+          HIPCHECK(hipDestroyTextureObject(objects[objects.size() - 1 - i]));
+          if (timed) destroy.Stop();
+        }
+        objects.clear();
+        if (p_rejectOutliers != 0) {
+          destroy.RejectOutliers(p_rejectOutliers);
+        }
+        sec = destroy.GetSamples();
+        break;
+      }
+      case measurePerRequest:
+        sec = measureEach([&]() {
+          hipTextureObject_t tex = create();
+          fetch(tex);
+          HIPCHECK(hipDestroyTextureObject(tex));
+        }, callsPerTest);
+        break;
+      default: {
+        hipTextureObject_t tex = create();
+        sec = measureEach([&]() { fetch(tex); }, callsPerTest);
+        HIPCHECK(hipDestroyTextureObject(tex));
+        break;
+      }
+    }
+    for (hipTextureObject_t tex : objects) {
+      HIPCHECK(hipDestroyTextureObject(tex));
+    }
+
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%-8s %-22s %s", texResourceStr[resource],
+             texDescriptorStr[descriptor], texMeasureStr[what]);
+    report(test, desc, texWidth * texHeight * sizeof(float), 1, "us",
+           HipPerf::toMicroseconds(sec, 1));
+  }
+
+ private:
+  hipResourceDesc resourceDesc(TexResource resource) const {
+    hipResourceDesc resDesc;
+    memset(&resDesc, 0, sizeof(resDesc));
+    switch (resource) {
+      case resourceArray:
+        resDesc.resType = hipResourceTypeArray;
+        resDesc.res.array.array = array_;
+        break;
+      case resourceLinear:
+        resDesc.resType = hipResourceTypeLinear;
+        resDesc.res.linear.devPtr = linear_;
+        resDesc.res.linear.desc = hipCreateChannelDesc<float>();
+        resDesc.res.linear.sizeInBytes = texWidth * texHeight * sizeof(float);
+        break;
+      default:
+        resDesc.resType = hipResourceTypePitch2D;
+        resDesc.res.pitch2D.devPtr = pitched_;
+        resDesc.res.pitch2D.desc = hipCreateChannelDesc<float>();
+        resDesc.res.pitch2D.width = texWidth;
+        resDesc.res.pitch2D.height = texHeight;
+        resDesc.res.pitch2D.pitchInBytes = pitch_;
+        break;
+    }
+    return resDesc;
+  }
+
+  static hipTextureDesc textureDesc(TexDescriptor descriptor) {
+    hipTextureDesc texDesc;
+    memset(&texDesc, 0, sizeof(texDesc));
+    bool linear = descriptor == descriptorLinear;
+    for (int i = 0; i < 3; i++) {
+      texDesc.addressMode[i] = linear ? hipAddressModeWrap : hipAddressModeClamp;
+    }
+    texDesc.filterMode = linear ? hipFilterModeLinear : hipFilterModePoint;
+    texDesc.readMode = hipReadModeElementType;
+    texDesc.normalizedCoords = linear;
+    return texDesc;
+  }
+
+  hipArray_t array_;
+  float* linear_;
+  void* pitched_;
+  size_t pitch_;
+  float* out_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfTextureObject)
@@ -0,0 +1,233 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Growing a device buffer from 1MB to a quarter of device memory (at most
+// 4GB), doubling each step. realloc-by-copy allocates the new size with
+// hipMalloc, copies the old contents and frees the old buffer. VMM reserves
+// the whole range once with hipMemAddressReserve and maps physical chunks with
+// hipMemCreate/hipMemMap/hipMemSetAccess as the buffer grows. Reports the
+// time of a full growth and per mapped chunk, then the bandwidth of a
+// read-modify-write kernel over the grown buffer for both.
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "perf_harness.h"
+
+// VMM chunk sizes, rounded up to the allocation granularity
+static const size_t chunkSizes[] = {0, 16 << 20, 256 << 20};
+static const unsigned int numChunkSizes = sizeof(chunkSizes) / sizeof(chunkSizes[0]);
+
+static const size_t startSize = 1 << 20;
+
+__global__ void _touchKernel(float4* buf, size_t n) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    float4 v = buf[i];
+    v.x += 1.0f;
+    buf[i] = v;
+  }
+}
+
+class hipPerfVmmGrowth : public HipPerf::Benchmark {
+ public:
+  hipPerfVmmGrowth() : HipPerf::Benchmark("hipPerfVmmGrowth"), supported_(0), granularity_(0),
+      maxSize_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&supported_, hipDeviceAttributeVirtualMemoryManagementSupported,
+                                   deviceId));
+    prop_ = {};
+    prop_.type = hipMemAllocationTypePinned;
+    prop_.location.type = hipMemLocationTypeDevice;
+    prop_.location.id = deviceId;
+    access_ = {};
+    access_.location = prop_.location;
+    access_.flags = hipMemAccessFlagsProtReadWrite;
+    if (supported_) {
+      HIPCHECK(hipMemGetAllocationGranularity(&granularity_, &prop_,
+                                              hipMemAllocationGranularityRecommended));
+    }
+    maxSize_ = startSize;
+    while (maxSize_ * 2 <= std::min<size_t>(props_.totalGlobalMem / 4, size_t(4) << 30)) {
+      maxSize_ *= 2;
+    }
+  }
+
+  // realloc growth, VMM growth per chunk size, then access of both
+  unsigned int numTests() override { return 1 + numChunkSizes + 2; }
+
+  void run(unsigned int test) override {
+    bool vmmTest = test != 0 && test != numChunkSizes + 1;
+    if (vmmTest && !supported_) {
+      printf("info: device %d has no virtual memory management support, skipping\n", deviceId_);
+      return;
+    }
+
+    if (test == 0) {
+      std::vector<double> sec = timeGrowth([&]() { growByCopy(); });
+      report(test, "realloc-by-copy growth", maxSize_, 1, "ms", toMilliseconds(sec, 1));
+    } else if (test <= numChunkSizes) {
+      size_t chunk = roundUp(std::max(chunkSizes[test - 1], granularity_));
+      size_t numChunks = 0;
+      std::vector<double> sec = timeGrowth([&]() { numChunks = growByMapping(chunk); });
+      char desc[64];
+      snprintf(desc, sizeof(desc), "VMM growth %zu KB chunks", chunk >> 10);
+      report(test, desc, maxSize_, numChunks, "ms", toMilliseconds(sec, 1));
+      report(test, std::string(desc) + " per chunk", chunk, numChunks, "us",
+             HipPerf::toMicroseconds(sec, numChunks));
+    } else {
+      bool vmm = test == numChunkSizes + 2;
+      void* buf = nullptr;
+      if (vmm) {
+        buf = mapRange(granularity_);
+      } else {
+        HIPCHECK(hipMalloc(&buf, maxSize_));
+      }
+      size_t n = maxSize_ / sizeof(float4);
+      auto sec = measure([&]() {
+        hipLaunchKernelGGL(_touchKernel, dim3(props_.multiProcessorCount * 8), dim3(256), 0, 0,
+                           static_cast<float4*>(buf), n);
+        HIPCHECK(hipDeviceSynchronize());
+      });
+      // Read and write of every byte
+      report(test, vmm ? "access VMM mapped (granularity chunks)" : "access hipMalloc", maxSize_,
+             1, "GB/s", HipPerf::toBandwidth(sec, 2.0 * maxSize_));
+      if (vmm) {
+        unmapRange();
+      } else {
+        HIPCHECK(hipFree(buf));
+      }
+    }
+  }
+
+ private:
+  size_t roundUp(size_t size) const {
+    return (size + granularity_ - 1) / granularity_ * granularity_;
+  }
+
+  // Reserves maxSize_ rounded up to whole chunks.
+  void reserve(size_t chunk) {
+    reserved_ = (maxSize_ + chunk - 1) / chunk * chunk;
+    HIPCHECK(hipMemAddressReserve(&base_, reserved_, 0, nullptr, 0));
+  }
+
+  static std::vector<double> toMilliseconds(const std::vector<double>& sec, double ops) {
+    std::vector<double> ms;
+    for (double s : sec) {
+      ms.push_back(s * 1e3 / ops);
+    }
+    return ms;
+  }
+
+  // Seconds of the growth part of grow(), which releases the buffer untimed.
+  std::vector<double> timeGrowth(const std::function<void()>& grow) {
+    std::vector<double> sec;
+    measure([&]() {
+      growTimer_.Reset();
+      grow();
+      if (!HipPerf::Counters::collecting()) {
+        sec.push_back(growTimer_.GetElapsedTime());
+      }
+    });
+    return HipPerf::measuredSamples(sec);
+  }
+
+  void growByCopy() {
+    void* buf = nullptr;
+    growTimer_.Start();
+    HIPCHECK(hipMalloc(&buf, startSize));
+    HIPCHECK(hipMemset(buf, 0, startSize));
+    for (size_t size = startSize; size < maxSize_; size *= 2) {
+      void* bigger = nullptr;
+      HIPCHECK(hipMalloc(&bigger, size * 2));
+      HIPCHECK(hipMemcpy(bigger, buf, size, hipMemcpyDeviceToDevice));
+      HIPCHECK(hipFree(buf));
+      buf = bigger;
+    }
+    HIPCHECK(hipDeviceSynchronize());
+    growTimer_.Stop();
+    HIPCHECK(hipFree(buf));
+  }
+
+  // Returns the number of chunks mapped.
+  size_t growByMapping(size_t chunk) {
+    growTimer_.Start();
+    reserve(chunk);
+    for (size_t size = startSize; size <= maxSize_; size *= 2) {
+      while (mapped_ < size) {
+        mapChunk(chunk);
+      }
+    }
+    growTimer_.Stop();
+    size_t numChunks = handles_.size();
+    unmapRange();
+    return numChunks;
+  }
+
+  void* mapRange(size_t chunk) {
+    reserve(chunk);
+    while (mapped_ < maxSize_) {
+      mapChunk(chunk);
+    }
+    return base_;
+  }
+
+  void mapChunk(size_t chunk) {
+    hipMemGenericAllocationHandle_t handle;
+    void* addr = static_cast<char*>(base_) + mapped_;
+    HIPCHECK(hipMemCreate(&handle, chunk, &prop_, 0));
+    HIPCHECK(hipMemMap(addr, chunk, 0, handle, 0));
+    HIPCHECK(hipMemSetAccess(addr, chunk, &access_, 1));
+    handles_.push_back(handle);
+    mapped_ += chunk;
+  }
+
+  void unmapRange() {
+    size_t chunk = handles_.empty() ? 0 : mapped_ / handles_.size();
+    for (size_t i = 0; i < handles_.size(); i++) {
+      HIPCHECK(hipMemUnmap(static_cast<char*>(base_) + i * chunk, chunk));
+      HIPCHECK(hipMemRelease(handles_[i]));
+    }
+    HIPCHECK(hipMemAddressFree(base_, reserved_));
+    handles_.clear();
+    mapped_ = 0;
+    base_ = nullptr;
+  }
+
+  int supported_;
+  size_t granularity_;
+  size_t maxSize_;
+  hipMemAllocationProp prop_;
+  hipMemAccessDesc access_;
+  CPerfCounter growTimer_;
+  void* base_ = nullptr;
+  size_t reserved_ = 0;
+  size_t mapped_ = 0;
+  std::vector<hipMemGenericAllocationHandle_t> handles_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfVmmGrowth)
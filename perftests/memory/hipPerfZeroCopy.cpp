@@ -0,0 +1,272 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Bandwidth of kernels reading and writing host memory directly over the
+// host link: hipHostMallocMapped (coherent and non-coherent), mapped
+// hipHostRegister and managed memory that is advised to stay on the host.
+// Device memory is the upper bound and "copy+compute" the alternative of an
+// explicit pinned copy to (or from) device memory around the same kernel.
+// Accesses are coalesced (grid-stride) or scattered (odd-multiplier hash of
+// the index) and launched with 1, 1 per CU and 8 per CU blocks, since few
+// waves in flight can not hide the link latency. Small tables whose kernels
+// reach close to "copy+compute" without the copy can stay on the host.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "perf_harness.h"
+
+enum ZeroCopyKind {
+  kindMappedCoherent = 0,
+  kindMappedNonCoherent,
+  kindRegistered,
+  kindManagedHost,
+  kindDevice,
+  kindCopyCompute,
+  numZeroCopyKinds
+};
+
+static const char* zeroCopyKindStr[numZeroCopyKinds] = {
+    "hipHostMallocMapped coherent", "hipHostMallocMapped non-coherent",
+    "hipHostRegisterMapped",        "managed preferred on host",
+    "device",                       "copy+compute"};
+
+enum ZeroCopyPattern { patternCoalesced = 0, patternScattered, numZeroCopyPatterns };
+enum ZeroCopyDir { dirRead = 0, dirWrite, numZeroCopyDirs };
+
+static const char* zeroCopyPatternStr[numZeroCopyPatterns] = {"coalesced", "scattered"};
+static const char* zeroCopyDirStr[numZeroCopyDirs] = {"read", "write"};
+
+// Blocks per CU, 0 for a single block
+static const unsigned int occupancies[] = {0, 1, 8};
+static const unsigned int numOccupancies = sizeof(occupancies) / sizeof(occupancies[0]);
+
+// A permutation of [0, n) for n a power of two
+template <ZeroCopyPattern P> __device__ inline size_t elementOf(size_t i, size_t n) {
+  return P == patternScattered ? (i * 2654435761ull) & (n - 1) : i;
+}
+
+template <ZeroCopyPattern P>
+__global__ void zeroCopyRead(const unsigned int* src, size_t n, unsigned int* dst) {
+  unsigned int tmp = 0;
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    tmp += src[elementOf<P>(i, n)];
+  }
+  atomicAdd(dst, tmp);
+}
+
+template <ZeroCopyPattern P>
+__global__ void zeroCopyWrite(unsigned int* dst, size_t n, unsigned int value) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    dst[elementOf<P>(i, n)] = value;
+  }
+}
+
+class hipPerfZeroCopy : public HipPerf::Benchmark {
+ public:
+  hipPerfZeroCopy() : HipPerf::Benchmark("hipPerfZeroCopy"),
+      sizes_(HipPerf::sweepSizes({1 << 20, 64 << 20})), passes_(HipPerf::iterationCount(10)),
+      managed_(0), result_(nullptr), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&managed_, hipDeviceAttributeManagedMemory, deviceId));
+    HIPCHECK(hipMalloc(&result_, sizeof(unsigned int)));
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+  }
+
+  void close() override {
+    HIPCHECK(hipFree(result_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override {
+    return sizes_.size() * numZeroCopyKinds * numZeroCopyDirs * numZeroCopyPatterns *
+        numOccupancies;
+  }
+
+  void run(unsigned int test) override {
+    unsigned int index = test;
+    unsigned int occupancy = occupancies[index % numOccupancies];
+    index /= numOccupancies;
+    ZeroCopyPattern pattern = static_cast<ZeroCopyPattern>(index % numZeroCopyPatterns);
+    index /= numZeroCopyPatterns;
+    ZeroCopyDir dir = static_cast<ZeroCopyDir>(index % numZeroCopyDirs);
+    index /= numZeroCopyDirs;
+    ZeroCopyKind kind = static_cast<ZeroCopyKind>(index % numZeroCopyKinds);
+    size_t size = powerOfTwoBelow(sizes_[index / numZeroCopyKinds]);
+
+    if (kind == kindManagedHost && !managed_) {
+      printf("info: managed memory is not supported, skipping\n");
+      return;
+    }
+
+    Buffer buf = allocate(kind, size);
+    size_t n = size / sizeof(unsigned int);
+    dim3 grid(occupancy == 0 ? 1 : props_.multiProcessorCount * occupancy);
+
+    auto sec = measure([&]() {
+      for (unsigned int p = 0; p < passes_; p++) {
+        if (kind == kindCopyCompute && dir == dirRead) {
+          HIPCHECK(hipMemcpyAsync(buf.device, buf.host, size, hipMemcpyHostToDevice, stream_));
+        }
+        launch(pattern, dir, buf.device, n, grid);
+        if (kind == kindCopyCompute && dir == dirWrite) {
+          HIPCHECK(hipMemcpyAsync(buf.host, buf.device, size, hipMemcpyDeviceToHost, stream_));
+        }
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+
+    if (dir == dirWrite) {
+      checkWritten(kind == kindCopyCompute ? buf.host : buf.device, n);
+    }
+    release(kind, buf);
+
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%-33s %s %-9s %4u blocks %9zu bytes", zeroCopyKindStr[kind],
+             zeroCopyDirStr[dir], zeroCopyPatternStr[pattern], grid.x, size);
+    report(test, desc, size, passes_, "GB/s",
+           HipPerf::toBandwidth(sec, static_cast<double>(size) * passes_));
+  }
+
+ private:
+  // device is what the kernel accesses; host the pinned side of copy+compute
+  // or the allocation behind the device alias of registered memory.
+  struct Buffer {
+    void* device;
+    void* host;
+  };
+
+  static size_t powerOfTwoBelow(size_t size) {
+    size_t p = 4096;
+    while (p * 2 <= size) {
+      p *= 2;
+    }
+    return p;
+  }
+
+  Buffer allocate(ZeroCopyKind kind, size_t size) {
+    Buffer buf = {nullptr, nullptr};
+    switch (kind) {
+      case kindMappedCoherent:
+      case kindMappedNonCoherent: {
+        unsigned int flags = hipHostMallocMapped |
+            (kind == kindMappedCoherent ? hipHostMallocCoherent : hipHostMallocNonCoherent);
+        HIPCHECK(hipHostMalloc(&buf.host, size, flags));
+        HIPCHECK(hipHostGetDevicePointer(&buf.device, buf.host, 0));
+        memset(buf.host, 1, size);
+        break;
+      }
+      case kindRegistered:
+        if (posix_memalign(&buf.host, 4096, size) != 0) {
+          failed("posix_memalign of %zu bytes failed\n", size);
+        }
+        memset(buf.host, 1, size);
+        HIPCHECK(hipHostRegister(buf.host, size, hipHostRegisterMapped));
+        HIPCHECK(hipHostGetDevicePointer(&buf.device, buf.host, 0));
+        break;
+      case kindManagedHost:
+        HIPCHECK(hipMallocManaged(&buf.device, size));
+        memset(buf.device, 1, size);
+        HIPCHECK(hipMemAdvise(buf.device, size, hipMemAdviseSetPreferredLocation,
+                              hipCpuDeviceId));
+        HIPCHECK(hipMemAdvise(buf.device, size, hipMemAdviseSetAccessedBy, deviceId_));
+        break;
+      case kindDevice:
+        HIPCHECK(hipMalloc(&buf.device, size));
+        HIPCHECK(hipMemset(buf.device, 1, size));
+        break;
+      default:
+        HIPCHECK(hipMalloc(&buf.device, size));
+        HIPCHECK(hipHostMalloc(&buf.host, size));
+        memset(buf.host, 1, size);
+        break;
+    }
+    return buf;
+  }
+
+  void release(ZeroCopyKind kind, Buffer& buf) {
+    switch (kind) {
+      case kindMappedCoherent:
+      case kindMappedNonCoherent:
+        HIPCHECK(hipHostFree(buf.host));
+        break;
+      case kindRegistered:
+        HIPCHECK(hipHostUnregister(buf.host));
+        free(buf.host);
+        break;
+      case kindManagedHost:
+      case kindDevice:
+        HIPCHECK(hipFree(buf.device));
+        break;
+      default:
+        HIPCHECK(hipFree(buf.device));
+        HIPCHECK(hipHostFree(buf.host));
+        break;
+    }
+  }
+
+  void launch(ZeroCopyPattern pattern, ZeroCopyDir dir, void* ptr, size_t n, dim3 grid) {
+    unsigned int* data = static_cast<unsigned int*>(ptr);
+    if (dir == dirRead) {
+      if (pattern == patternCoalesced) {
+        hipLaunchKernelGGL(zeroCopyRead<patternCoalesced>, grid, dim3(256), 0, stream_, data, n,
+                           result_);
+      } else {
+        hipLaunchKernelGGL(zeroCopyRead<patternScattered>, grid, dim3(256), 0, stream_, data, n,
+                           result_);
+      }
+    } else {
+      if (pattern == patternCoalesced) {
+        hipLaunchKernelGGL(zeroCopyWrite<patternCoalesced>, grid, dim3(256), 0, stream_, data, n,
+                           2u);
+      } else {
+        hipLaunchKernelGGL(zeroCopyWrite<patternScattered>, grid, dim3(256), 0, stream_, data, n,
+                           2u);
+      }
+    }
+  }
+
+  // The write kernels store 2 into every element.
+  void checkWritten(const void* ptr, size_t n) {
+    std::vector<unsigned int> host(n);
+    HIPCHECK(hipMemcpy(host.data(), ptr, n * sizeof(unsigned int), hipMemcpyDefault));
+    for (size_t i = 0; i < n; i++) {
+      if (host[i] != 2) {
+        failed("Write validation failed at element %zu: got %u, expected 2", i, host[i]);
+      }
+    }
+  }
+
+  std::vector<size_t> sizes_;
+  unsigned int passes_;
+  int managed_;
+  unsigned int* result_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfZeroCopy)
@@ -0,0 +1,322 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cold start latency of a fresh process, broken down by phase. The parent
+// never initializes HIP; every sample execs a new copy of a binary that
+// records, on the monotonic clock shared by all processes: reaching main()
+// (exec, loading the HIP runtime and registering the embedded code objects),
+// hipInit, the first hipGetDeviceCount, the first hipMalloc and the first
+// kernel launch until it completed. Each phase is reported from the end of the
+// previous one, plus the total from fork to the finished launch and the
+// resident set size after the launch. Runs with all devices visible and with
+// HIP_VISIBLE_DEVICES (CUDA_VISIBLE_DEVICES on NVIDIA) restricted to --device,
+// each with lazy and with eager code object loading (HIP_ENABLE_DEFERRED_LOADING,
+// CUDA_MODULE_LOADING on NVIDIA).
+// Besides this binary every <name>_* sibling is run: CMake builds copies with
+// many offload architectures (_fat) and with thousands of extra kernels
+// (_k<count>), to show what growing the fat binary costs at startup and in
+// memory, and how much of that lazy loading avoids.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perf_harness.h"
+
+#ifndef COLD_START_ARCHS
+#define COLD_START_ARCHS "default"  // offload architectures embedded in this binary
+#endif
+#ifndef COLD_START_KERNELS
+#define COLD_START_KERNELS 0  // extra kernels embedded to grow the code objects
+#endif
+
+enum ColdPhase {
+  phaseMain = 0,
+  phaseInit,
+  phaseDeviceCount,
+  phaseMalloc,
+  phaseLaunch,
+  numColdPhases
+};
+static const char* coldPhaseStr[numColdPhases] = {
+    "exec to main", "hipInit", "first hipGetDeviceCount", "first hipMalloc",
+    "first kernel launch"};
+
+static const char* childArg = "--cold-start-child";
+#ifdef __HIP_PLATFORM_NVIDIA__
+static const char* visibleDevicesVar = "CUDA_VISIBLE_DEVICES";
+#else
+static const char* visibleDevicesVar = "HIP_VISIBLE_DEVICES";
+#endif
+
+__global__ void firstKernel(int* data) { data[threadIdx.x] = threadIdx.x; }
+
+#if COLD_START_KERNELS > 0
+template <int K> __global__ void paddingKernel(int* data) { data[threadIdx.x] += K; }
+
+template <int... K> static const void* const* paddingTable(std::integer_sequence<int, K...>) {
+  static const void* const table[] = {reinterpret_cast<const void*>(paddingKernel<K>)...};
+  return table;
+}
+
+// Taking their addresses keeps every padding kernel in the code objects
+static const void* const* paddingKernels =
+    paddingTable(std::make_integer_sequence<int, COLD_START_KERNELS>());
+#endif
+
+static const char* lazyLoadingVar =
+#ifdef __HIP_PLATFORM_NVIDIA__
+    "CUDA_MODULE_LOADING";
+static const char* loadingValue[2] = {"EAGER", "LAZY"};
+#else
+    "HIP_ENABLE_DEFERRED_LOADING";
+static const char* loadingValue[2] = {"0", "1"};
+#endif
+
+// Child side: prints the time every phase ended, nothing else may go to stdout
+static int runChild(int device) {
+  double stamps[numColdPhases];
+  stamps[phaseMain] = HipTest::nowSec();
+#if COLD_START_KERNELS > 0
+  static_cast<void>(paddingKernels);
+#endif
+  HIPCHECK(hipInit(0));
+  stamps[phaseInit] = HipTest::nowSec();
+  int devices = 0;
+  HIPCHECK(hipGetDeviceCount(&devices));
+  stamps[phaseDeviceCount] = HipTest::nowSec();
+  int* data = nullptr;
+  HIPCHECK(hipSetDevice(device));
+  HIPCHECK(hipMalloc(&data, 64 * sizeof(int)));
+  stamps[phaseMalloc] = HipTest::nowSec();
+  hipLaunchKernelGGL(firstKernel, dim3(1), dim3(64), 0, 0, data);
+  HIPCHECK(hipGetLastError());
+  HIPCHECK(hipDeviceSynchronize());
+  stamps[phaseLaunch] = HipTest::nowSec();
+  HIPCHECK(hipFree(data));
+
+  long pages = 0, resident = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr || fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+    resident = 0;
+  }
+  if (statm != nullptr) {
+    fclose(statm);
+  }
+  double rssMb = resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+
+  for (double stamp : stamps) {
+    printf("%.9f ", stamp);
+  }
+  printf("%.3f %d %d %s\n", rssMb, devices, COLD_START_KERNELS + 1, COLD_START_ARCHS);
+  return 0;
+}
+
+struct ColdSample {
+  double phases[numColdPhases];  // seconds, each from the end of the previous phase
+  double total;
+  double rssMb;
+  int devices;
+  int kernels;
+  std::string archs;
+};
+
+typedef std::vector<std::pair<const char*, const char*>> Environment;
+
+// Forks and execs binary as a child with env added to the environment. Returns false if the
+// child fails, e.g. without a code object for the device.
+static bool runSample(const std::string& binary, const Environment& env, int device,
+                      ColdSample* sample) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    failed("pipe failed");
+  }
+  double forkTime = HipTest::nowSec();
+  pid_t pid = fork();
+  if (pid < 0) {
+    failed("fork failed");
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    dup2(fds[1], STDOUT_FILENO);
+    for (const auto& var : env) {
+      setenv(var.first, var.second, 1);
+    }
+    std::string deviceArg = std::to_string(device);
+    execl(binary.c_str(), binary.c_str(), childArg, deviceArg.c_str(), (char*)nullptr);
+    _exit(127);
+  }
+  close(fds[1]);
+  std::string output;
+  char buffer[256];
+  ssize_t count;
+  while ((count = read(fds[0], buffer, sizeof(buffer))) > 0) {
+    output.append(buffer, count);
+  }
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return false;
+  }
+
+  double stamps[numColdPhases];
+  char archs[128] = {0};
+  if (sscanf(output.c_str(), "%lf %lf %lf %lf %lf %lf %d %d %127s", &stamps[0], &stamps[1],
+             &stamps[2], &stamps[3], &stamps[4], &sample->rssMb, &sample->devices,
+             &sample->kernels, archs) != 9) {
+    failed("unexpected output of %s: %s", binary.c_str(), output.c_str());
+  }
+  double previous = forkTime;
+  for (int p = 0; p < numColdPhases; p++) {
+    sample->phases[p] = stamps[p] - previous;
+    previous = stamps[p];
+  }
+  sample->total = stamps[phaseLaunch] - forkTime;
+  sample->archs = archs;
+  return true;
+}
+
+static std::string selfPath() {
+  char path[4096];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length <= 0) {
+    failed("cannot read /proc/self/exe");
+  }
+  path[length] = '\0';
+  return path;
+}
+
+// This binary first, then its <name>_* siblings sorted by name
+static std::vector<std::string> findBinaries() {
+  std::string self = selfPath();
+  size_t slash = self.rfind('/');
+  std::string dir = self.substr(0, slash);
+  std::string prefix = self.substr(slash + 1) + "_";
+
+  std::vector<std::string> siblings;
+  DIR* handle = opendir(dir.c_str());
+  if (handle != nullptr) {
+    while (struct dirent* entry = readdir(handle)) {
+      std::string path = dir + "/" + entry->d_name;
+      if (!strncmp(entry->d_name, prefix.c_str(), prefix.size()) &&
+          access(path.c_str(), X_OK) == 0) {
+        siblings.push_back(path);
+      }
+    }
+    closedir(handle);
+  }
+  std::sort(siblings.begin(), siblings.end());
+  if (siblings.empty()) {
+    printf("info: no %s* variants found, running %s only\n", prefix.c_str(), self.c_str());
+  }
+  siblings.insert(siblings.begin(), self);
+  return siblings;
+}
+
+static void writeColdResult(unsigned int test, const std::string& desc, size_t bytes,
+                            const char* unit, const std::vector<double>& values) {
+  HipPerf::Result result;
+  result.benchmark = "hipPerfColdStart";
+  result.test = test;
+  result.desc = desc;
+  result.device = p_gpuDevice;
+  result.bytes = bytes;
+  result.iterations = 1;
+  result.unit = unit;
+  result.values = values;
+  HipPerf::writeResult(result);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc == 3 && !strcmp(argv[1], childArg)) {
+    return runChild(atoi(argv[2]));
+  }
+  HipTest::parseStandardArguments(argc, argv, true);
+
+  // Results per configuration: every phase, the total and the RSS
+  const unsigned int resultsPerConfig = numColdPhases + 2;
+  std::string only = std::to_string(p_gpuDevice);
+  unsigned int test = 0;
+  for (const std::string& binary : findBinaries()) {
+    struct stat info;
+    size_t fileSize = stat(binary.c_str(), &info) == 0 ? info.st_size : 0;
+    std::string name = binary.substr(binary.rfind('/') + 1);
+
+    for (int restricted = 0; restricted < 2; restricted++) {
+      for (int lazy = 1; lazy >= 0; lazy--) {
+        Environment env;
+        env.push_back(std::make_pair(lazyLoadingVar, loadingValue[lazy]));
+        if (restricted) {
+          env.push_back(std::make_pair(visibleDevicesVar, only.c_str()));
+        }
+        int device = restricted ? 0 : p_gpuDevice;
+
+        std::vector<std::vector<double>> values(resultsPerConfig);
+        ColdSample sample;
+        bool ok = true;
+        for (unsigned int r = 0; r < p_warmup + p_repetitions && ok; r++) {
+          ok = runSample(binary, env, device, &sample);
+          if (ok && r >= p_warmup) {
+            for (int p = 0; p < numColdPhases; p++) {
+              values[p].push_back(sample.phases[p] * 1000);
+            }
+            values[numColdPhases].push_back(sample.total * 1000);
+            values[numColdPhases + 1].push_back(sample.rssMb);
+          }
+        }
+        if (!ok) {
+          printf("info: %s failed on device %d, skipping it\n", name.c_str(), p_gpuDevice);
+          test += resultsPerConfig;
+          continue;
+        }
+
+        std::string config = name + " " + std::to_string(sample.kernels) + " kernels, archs " +
+                             sample.archs + ", " + (lazy ? "lazy" : "eager") + ", " +
+                             (restricted ? std::string(visibleDevicesVar) + "=" + only
+                                         : std::string("all devices")) +
+                             " (" + std::to_string(sample.devices) + " visible)";
+        for (int p = 0; p <= numColdPhases; p++) {
+          writeColdResult(test++,
+                          config + ": " + (p < numColdPhases ? coldPhaseStr[p] : "total"),
+                          fileSize, "ms", values[p]);
+        }
+        writeColdResult(test++, config + ": RSS after first launch", fileSize, "MB",
+                        values[numColdPhases + 1]);
+      }
+    }
+  }
+  passed();
+}
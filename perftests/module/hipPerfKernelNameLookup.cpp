@@ -0,0 +1,266 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD_CMD: hipPerfKernelNameLookup %hc -I%S/../../src %S/%s %S/../../src/test_common.cpp %S/../../src/timer.cpp %S/../../src/perf_harness.cpp %S/../../src/perf_main.cpp -lhiprtc -lpthread -o %T/%t EXCLUDE_HIP_PLATFORM nvidia
+ * TEST: %t
+ * HIT_END
+ */
+
+// Latency of the kernel name lookups profilers make on every launch, as the
+// number of kernels in loaded modules grows. A hiprtc code object with 1024
+// kernels is loaded as often as needed for each kernel count (--sizes or
+// --sweep replace the default 1024, 8192 and 65536); modules stay loaded
+// between tests of increasing counts. hipKernelNameRef looks up random
+// hipFunction_ts of all loaded modules, hipKernelNameRefByPtr random host
+// pointers of 256 kernels compiled into this binary, and the baseline looks
+// the hipFunction_t up in an unordered_map of names a profiler would keep
+// itself. Every lookup kind runs on one thread and on hardware_concurrency
+// threads at once; reports ns per lookup on each thread, lookups per second
+// over all threads and the lookup against the map ("x cached").
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <hip/hiprtc.h>
+
+#include "perf_harness.h"
+
+enum LookupKind { lookupCached = 0, lookupNameRef, lookupNameRefByPtr, numLookupKinds };
+static const char* lookupKindStr[numLookupKinds] = {"cached map", "hipKernelNameRef",
+                                                    "hipKernelNameRefByPtr"};
+
+enum ThreadMode { threadsSingle = 0, threadsAll, numThreadModes };
+
+static const size_t kernelsPerModule = 1024;
+static const size_t staticKernels = 256;
+// Offset between the lookup sequences of the threads
+static const size_t threadStride = 4099;
+static const size_t defaultKernelCounts[] = {1024, 8192, 65536};
+
+template <size_t N> __global__ void nameKernel(float* p) { p[threadIdx.x] += N; }
+
+template <size_t... I>
+static std::vector<const void*> staticKernelPtrs(std::index_sequence<I...>) {
+  return {reinterpret_cast<const void*>(&nameKernel<I>)...};
+}
+
+class hipPerfKernelNameLookup : public HipPerf::Benchmark {
+ public:
+  hipPerfKernelNameLookup() : HipPerf::Benchmark("hipPerfKernelNameLookup"),
+      kernelCounts_(HipPerf::sweepSizes(std::vector<size_t>(
+          defaultKernelCounts, defaultKernelCounts + sizeof(defaultKernelCounts) /
+                                                         sizeof(defaultKernelCounts[0])))),
+      lookups_(HipPerf::iterationCount(100000)),
+      hwThreads_(std::max(1u, std::thread::hardware_concurrency())), stream_(nullptr),
+      cachedNs_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    staticPtrs_ = staticKernelPtrs(std::make_index_sequence<staticKernels>());
+    // Per thread offsets into one shared random sequence
+    std::mt19937 rng(1234);
+    order_.resize(lookups_ + hwThreads_ * threadStride);
+    sinks_.assign(hwThreads_, 0);
+    for (auto& index : order_) {
+      index = static_cast<uint32_t>(rng());
+    }
+  }
+
+  void close() override {
+    for (auto module : modules_) {
+      HIPCHECK(hipModuleUnload(module));
+    }
+    modules_.clear();
+    functions_.clear();
+    names_.clear();
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(kernelCounts_.size()) * numThreadModes * numLookupKinds;
+  }
+
+  void run(unsigned int test) override {
+    LookupKind kind = static_cast<LookupKind>(test % numLookupKinds);
+    ThreadMode mode = static_cast<ThreadMode>((test / numLookupKinds) % numThreadModes);
+    size_t kernels = kernelCounts_[test / (numLookupKinds * numThreadModes)];
+    if (kernels == 0) {
+      return;
+    }
+    unsigned int threads = mode == threadsSingle ? 1 : hwThreads_;
+    if (mode == threadsAll && hwThreads_ < 2) {
+      printf("info: one hardware thread only, skipping the multi threaded lookups\n");
+      return;
+    }
+    if (kind == lookupCached) {
+      cachedNs_ = 0;
+    }
+    loadKernels(kernels);
+    size_t loaded = functions_.size();
+
+    std::vector<double> sec;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      std::atomic<bool> go(false);
+      std::atomic<unsigned int> ready(0);
+      std::vector<std::thread> pool;
+      for (unsigned int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t]() {
+          const uint32_t* order = &order_[t * threadStride];
+          ready++;
+          while (!go.load()) {
+          }
+          uintptr_t sink = 0;
+          for (unsigned int i = 0; i < lookups_; i++) {
+            const char* name = nullptr;
+            switch (kind) {
+              case lookupCached:
+                name = names_.find(functions_[order[i] % loaded])->second;
+                break;
+              case lookupNameRef:
+                name = hipKernelNameRef(functions_[order[i] % loaded]);
+                break;
+              default:
+                name = hipKernelNameRefByPtr(staticPtrs_[order[i] % staticKernels], stream_);
+                break;
+            }
+            sink ^= reinterpret_cast<uintptr_t>(name);
+          }
+          sinks_[t] = sink;
+        });
+      }
+      while (ready.load() != threads) {
+      }
+      auto start = std::chrono::steady_clock::now();
+      go.store(true);
+      for (auto& thread : pool) {
+        thread.join();
+      }
+      auto stop = std::chrono::steady_clock::now();
+      if (r >= p_warmup) {
+        sec.push_back(std::chrono::duration<double>(stop - start).count());
+      }
+    }
+
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%6zu kernels %3u threads %s", loaded, threads,
+             lookupKindStr[kind]);
+    std::vector<double> ns;
+    for (double s : sec) {
+      ns.push_back(s * 1e9 / lookups_);
+    }
+    report(test, desc, 0, lookups_, "ns", ns);
+    report(test, desc, 0, lookups_, "Mlookups/s",
+           HipPerf::toBandwidth(sec, 1e3 * lookups_ * threads));
+    double median = ComputePerfStats(ns).median;
+    if (kind == lookupCached) {
+      cachedNs_ = median;
+    } else if (cachedNs_ > 0) {
+      report(test, desc, 0, lookups_, "x cached", {median / cachedNs_}, HipPerf::betterLower);
+    }
+  }
+
+ private:
+  static std::string kernelName(size_t index) { return "lookup_kernel_" + std::to_string(index); }
+
+  // Loads or unloads copies of the code object until at least 'kernels' are loaded
+  void loadKernels(size_t kernels) {
+    size_t modules = std::max<size_t>(1, (kernels + kernelsPerModule - 1) / kernelsPerModule);
+    if (modules == modules_.size()) {
+      return;
+    }
+    if (code_.empty()) {
+      compile();
+    }
+    while (modules_.size() > modules) {
+      HIPCHECK(hipModuleUnload(modules_.back()));
+      modules_.pop_back();
+    }
+    while (modules_.size() < modules) {
+      hipModule_t module = nullptr;
+      HIPCHECK(hipModuleLoadData(&module, code_.data()));
+      modules_.push_back(module);
+    }
+
+    functions_.clear();
+    names_.clear();
+    for (auto module : modules_) {
+      for (size_t k = 0; k < kernelsPerModule; k++) {
+        std::string expected = kernelName(k);
+        hipFunction_t function = nullptr;
+        HIPCHECK(hipModuleGetFunction(&function, module, expected.c_str()));
+        const char* name = hipKernelNameRef(function);
+        if (name == nullptr || expected != name) {
+          failed("hipKernelNameRef returned %s for %s", name != nullptr ? name : "nullptr",
+                 expected.c_str());
+        }
+        functions_.push_back(function);
+        names_.emplace(function, name);
+      }
+    }
+    for (auto ptr : staticPtrs_) {
+      const char* name = hipKernelNameRefByPtr(ptr, stream_);
+      if (name == nullptr || strstr(name, "nameKernel") == nullptr) {
+        failed("hipKernelNameRefByPtr returned %s", name != nullptr ? name : "nullptr");
+      }
+    }
+  }
+
+  void compile() {
+    std::string source;
+    for (size_t k = 0; k < kernelsPerModule; k++) {
+      source += "extern \"C\" __global__ void " + kernelName(k) +
+                "(float* p) { p[threadIdx.x] += " + std::to_string(k) + ".0f; }\n";
+    }
+    hiprtcProgram prog;
+    HIPRTCCHECK(hiprtcCreateProgram(&prog, source.c_str(), "lookup.cu", 0, nullptr, nullptr));
+    HipTest::compileRtcProgram(prog, 0, nullptr);
+    size_t codeSize = 0;
+    HIPRTCCHECK(hiprtcGetCodeSize(prog, &codeSize));
+    code_.resize(codeSize);
+    HIPRTCCHECK(hiprtcGetCode(prog, code_.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+  }
+
+  std::vector<size_t> kernelCounts_;
+  unsigned int lookups_;  // per thread and repetition
+  unsigned int hwThreads_;
+  hipStream_t stream_;
+  double cachedNs_;  // median of the cached lookup with the same kernels and threads
+  std::vector<char> code_;
+  std::vector<hipModule_t> modules_;
+  std::vector<hipFunction_t> functions_;  // all kernels of modules_
+  std::unordered_map<hipFunction_t, const char*> names_;
+  std::vector<const void*> staticPtrs_;
+  std::vector<uint32_t> order_;  // random lookup indices
+  std::vector<uintptr_t> sinks_;  // keeps the lookups from being optimized away
+};
+
+HIP_PERF_BENCHMARK(hipPerfKernelNameLookup)
@@ -18,227 +18,234 @@ THE SOFTWARE.
 */
 
 /* HIT_START
- * BUILD_CMD: hipPerfModuleLoad %hc -I%S/../../src %S/%s %S/../../src/test_common.cpp -o %T/%t EXCLUDE_HIP_PLATFORM nvidia
+ * BUILD_CMD: hipPerfModuleLoad %hc -I%S/../../src %S/%s %S/../../src/test_common.cpp %S/../../src/timer.cpp %S/../../src/perf_harness.cpp %S/../../src/perf_main.cpp -lhiprtc -o %T/%t EXCLUDE_HIP_PLATFORM nvidia
  * TEST: %t
  * HIT_END
  */
 
-#include "test_common.h"
+// Module startup cost on code objects generated with hiprtc, so the test needs
+// no files or downloads. Every code object has a given number of kernels
+// (--sizes or --sweep replace the default counts) with a short or a long
+// unrolled body. Per code object it times hipModuleLoad from a temporary file,
+// hipModuleLoadData, hipModuleLoadDataEx, loading plus eager lookup of every
+// kernel, the first hipModuleGetFunction after a load (lazy lookup), a
+// repeated lookup, the first launch after load and lookup, and loading on
+// every visible device. Only the timed call is inside the sample, the unload
+// is not. Compilation is not timed, code objects are built once per shape.
 
-#include <vector>
-#include <unordered_map>
-#include <fstream>
-#include <unistd.h>
-#include <chrono>
-
-#ifdef __unix__
-
-#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
 
-//List of Download files
-std::unordered_map<std::string, bool> TL_contents {
-  {"Kernels.so", true},
-  {"TensileLibrary.yaml", true},
-  {"TensileLibrary_gfx803.co", true},
-  {"TensileLibrary_gfx900.co", true},
-  {"TensileLibrary_gfx906.co", true},
-  {"TensileLibrary_gfx908.co", true},
-  {"kernel_names.txt", true}
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+
+#include <hip/hiprtc.h>
+
+#include "perf_harness.h"
+
+enum LoadOp {
+  opLoadFile = 0,
+  opLoadData,
+  opLoadDataEx,
+  opLoadEagerLookup,
+  opFirstLookup,
+  opRepeatedLookup,
+  opFirstLaunch,
+  opLoadAllDevices,
+  numLoadOps
 };
 
-bool GetDirectoryContents(std::unordered_map<std::string, bool>& dir_contents) {
-  DIR* dir = nullptr;
-  struct dirent* ent = nullptr;
+static const char* loadOpStr[numLoadOps] = {
+    "hipModuleLoad",        "hipModuleLoadData",          "hipModuleLoadDataEx",
+    "load + lookup all",    "first hipModuleGetFunction", "repeated hipModuleGetFunction",
+    "first launch",         "hipModuleLoadData all devices"};
 
-  //Open Current Directory
-  if ((dir = opendir(".")) == 0) {
-    std::cout<<"Failed to open current working directory, check permissions"<<std::endl;
-    return false;
-  }
+// FMAs per kernel body, unrolled
+static const unsigned int bodySizes[] = {4, 256};
+static const unsigned int numBodySizes = sizeof(bodySizes) / sizeof(bodySizes[0]);
 
-  // Read the contents of the directory
-  while ((ent = readdir(dir)) != nullptr) {
-    dir_contents.insert({ent->d_name, true});
-  }
+static const size_t defaultKernelCounts[] = {1, 100, 1000, 10000};
 
-  closedir(dir);
-  return true;
-}
+typedef std::chrono::duration<double, std::milli> Milliseconds;
 
-bool ContentsAvailable() {
-  std::unordered_map<std::string, bool> dir_contents;
+class hipPerfModuleLoad : public HipPerf::Benchmark {
+ public:
+  hipPerfModuleLoad() : HipPerf::Benchmark("hipPerfModuleLoad"),
+      kernelCounts_(HipPerf::sweepSizes(std::vector<size_t>(
+          defaultKernelCounts, defaultKernelCounts + sizeof(defaultKernelCounts) /
+                                                         sizeof(defaultKernelCounts[0])))),
+      buffer_(nullptr) {}
 
-  //Get recent directory contents
-  if(!GetDirectoryContents(dir_contents)) {
-    std::cout<<"Failed to get directory Contents"<<std::endl;
-    return false;
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipMalloc(&buffer_, 64 * sizeof(float)));
   }
 
-  //If the Tensile Library content is not present, then fail
-  for (auto& TL_elem : TL_contents) {
-    if (dir_contents.end() == dir_contents.find(TL_elem.first)) {
-      std::cout<<"Failed to find the Tensile Library file: "<<TL_elem.first<<std::endl;
-      return false;
+  void close() override {
+    HIPCHECK(hipFree(buffer_));
+    for (auto& entry : codeObjects_) {
+      remove(entry.second.path.c_str());
     }
-  }
-  return true;
-}
-
-bool DownloadContents() {
-  //Download the contents from TC repo
-  std::cout<<"Downloading conents .... "<<std::endl;
-  std::string wget_str = "wget -nH -q -N -r -np -R \" index.html* \" --cut-dirs=3 ";
-  wget_str += "http://ocltc-backup.amd.com/hiptest/TensileLibrary/";
-  system(wget_str.c_str());
-
-  return true;
-}
-
-bool PreProcessContents() {
-  // If Contents already available no other action needed
-  if (ContentsAvailable()) {
-    std::cout<<"Contents already available"<<std::endl;
-    return true;
-  }
-
-  // Download the TL(Tensile Library) contents from TC
-  if (!DownloadContents()) {
-    std::cout<<"Failed to download contents"<<std::endl;
-    return false;
-  }
-
-  //Check if downloaded contents are available
-  if (!ContentsAvailable()) {
-    std::cout<<"Failed to find TL contents even after download in CWD"<<std::endl;
-    return false;
+    codeObjects_.clear();
   }
 
-  return true;
-}
-
-//Get Tensile Library File name, changes wrt target
-bool getTLFileName(int device_id, std::string& tlf_name) {
-  hipDeviceProp_t props;
-  HIPCHECK(hipGetDeviceProperties(&props, device_id));
-  std::string archName = props.gcnArchName;
-  if (archName.size() <= 3) {
-    std::cout<<"ArchName too small, Exiting"<<std::endl;
-    HIPASSERT(false);
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(kernelCounts_.size()) * numBodySizes * numLoadOps;
   }
-  archName = archName.substr(3, (archName.size()-1));
-
-  tlf_name = "TensileLibrary_gfx" + archName;
-  tlf_name += ".co";
-  return true;
-}
-
-bool RunTest(int device_id) {
-
-  std::cout<<"For Device: "<<device_id<<std::endl;
 
-  //Get Tensile Library File name, changes wrt target
-  std::string tlf_name;
-  if (!getTLFileName(device_id, tlf_name)) {
-    return false;
-  }
+  void run(unsigned int test) override {
+    LoadOp op = static_cast<LoadOp>(test % numLoadOps);
+    unsigned int body = bodySizes[(test / numLoadOps) % numBodySizes];
+    size_t kernels = kernelCounts_[test / (numLoadOps * numBodySizes)];
+    if (kernels == 0) {
+      return;
+    }
 
-  //Measure Time taken for hipModuleLoad
-  hipModule_t Module;
-  auto mload_clock_start = std::chrono::steady_clock::now();
-  HIPCHECK(hipModuleLoad(&Module, tlf_name.c_str()));
-  auto mload_clock_stop = std::chrono::steady_clock::now();
-  std::chrono::duration<double, std::nano> mload_duration = (mload_clock_stop - mload_clock_start);
-  std::cout<<"Time taken for hipModuleLoad : " <<std::chrono::duration_cast<std::chrono::nanoseconds>
-    (mload_duration).count()<<" nanoseconds "<<std::endl;
-
-  //Read kernels from a pre-populated text file
-  std::string kernel_file_name = "kernel_names.txt";
-  std::ifstream kernel_file(kernel_file_name);
-  if (!kernel_file.is_open()) {
-     std::cout<<"Failed to open Kernel File: "<<kernel_file_name<<std::endl;
-     return false;
-  }
+    int devices = 0;
+    HIPCHECK(hipGetDeviceCount(&devices));
+    if (op == opLoadAllDevices && devices < 2) {
+      printf("info: one device only, skipping %s\n", loadOpStr[op]);
+      return;
+    }
 
-  std::string kernel_line;
-  std::vector<std::string> kernel_vec;
-  while (std::getline(kernel_file, kernel_line)) {
-    kernel_line.erase(std::remove(kernel_line.begin(), kernel_line.end(), '\r'),
-                      kernel_line.end());
-    kernel_vec.push_back(kernel_line);
-  }
+    const CodeObject& code = codeObject(kernels, body);
+    const void* image = code.data.data();
+    std::string first = kernelName(0);
+    std::string last = kernelName(kernels - 1);
+    std::vector<double> ms;
+
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      hipModule_t module = nullptr;
+      std::vector<hipModule_t> modules(devices, nullptr);
+      hipFunction_t function = nullptr;
+      Milliseconds elapsed(0);
+      auto start = std::chrono::steady_clock::now();
+      switch (op) {
+        case opLoadFile:
+          HIPCHECK(hipModuleLoad(&module, code.path.c_str()));
+          elapsed = std::chrono::steady_clock::now() - start;
+          break;
+        case opLoadData:
+          HIPCHECK(hipModuleLoadData(&module, image));
+          elapsed = std::chrono::steady_clock::now() - start;
+          break;
+        case opLoadDataEx:
+          HIPCHECK(hipModuleLoadDataEx(&module, image, 0, nullptr, nullptr));
+          elapsed = std::chrono::steady_clock::now() - start;
+          break;
+        case opLoadEagerLookup:
+          HIPCHECK(hipModuleLoadData(&module, image));
+          for (size_t k = 0; k < kernels; k++) {
+            HIPCHECK(hipModuleGetFunction(&function, module, kernelName(k).c_str()));
+          }
+          elapsed = std::chrono::steady_clock::now() - start;
+          break;
+        case opFirstLookup:
+        case opRepeatedLookup:
+          HIPCHECK(hipModuleLoadData(&module, image));
+          if (op == opRepeatedLookup) {
+            HIPCHECK(hipModuleGetFunction(&function, module, last.c_str()));
+          }
+          start = std::chrono::steady_clock::now();
+          HIPCHECK(hipModuleGetFunction(&function, module, last.c_str()));
+          elapsed = std::chrono::steady_clock::now() - start;
+          break;
+        case opFirstLaunch: {
+          HIPCHECK(hipModuleLoadData(&module, image));
+          HIPCHECK(hipModuleGetFunction(&function, module, first.c_str()));
+          void* params[] = {&buffer_};
+          start = std::chrono::steady_clock::now();
+          HIPCHECK(hipModuleLaunchKernel(function, 1, 1, 1, 64, 1, 1, 0, nullptr, params,
+                                         nullptr));
+          HIPCHECK(hipDeviceSynchronize());
+          elapsed = std::chrono::steady_clock::now() - start;
+          break;
+        }
+        default:
+          for (int d = 0; d < devices; d++) {
+            HIPCHECK(hipSetDevice(d));
+            HIPCHECK(hipModuleLoadData(&modules[d], image));
+          }
+          elapsed = std::chrono::steady_clock::now() - start;
+          break;
+      }
 
-  //Measure the first hipModuleGetFunction
-  hipFunction_t hfunc = nullptr;
-  auto mgetf_clock_start = std::chrono::steady_clock::now();
-  HIPCHECK(hipModuleGetFunction(&hfunc, Module, kernel_vec[0].c_str()));
-  auto mgetf_clock_stop = std::chrono::steady_clock::now();
-  std::chrono::duration<double, std::nano> mgetf_duration = (mgetf_clock_stop - mgetf_clock_start);
-  std::cout<<"Time taken to fetch a function via hipModuleGetFunction : "
-    <<std::chrono::duration_cast<std::chrono::nanoseconds>
-    (mgetf_duration).count()<<" nanoseconds "<<std::endl;
-
-  //Measure the second hipModuleGetFunction
-  hfunc = nullptr;
-  mgetf_clock_start = std::chrono::steady_clock::now();
-  HIPCHECK(hipModuleGetFunction(&hfunc, Module, kernel_vec[0].c_str()));
-  mgetf_clock_stop = std::chrono::steady_clock::now();
-  mgetf_duration = (mgetf_clock_stop - mgetf_clock_start);
-  std::cout<<"Time taken fetch the same function via hipModuleGetFunction : "
-    <<std::chrono::duration_cast<std::chrono::nanoseconds>
-    (mgetf_duration).count()<<" nanoseconds "<<std::endl;
-
-  double all_duration = 0;
-  for (auto& kernel : kernel_vec) {
-    hfunc = nullptr;
-    mgetf_clock_start = std::chrono::steady_clock::now();
-    HIPCHECK(hipModuleGetFunction(&hfunc, Module, kernel.c_str()));
-    mgetf_clock_stop = std::chrono::steady_clock::now();
-    mgetf_duration = (mgetf_clock_stop - mgetf_clock_start);
-    all_duration += mgetf_duration.count();
-  }
+      if (module != nullptr) {
+        HIPCHECK(hipModuleUnload(module));
+      }
+      for (int d = 0; d < devices; d++) {
+        if (modules[d] != nullptr) {
+          HIPCHECK(hipSetDevice(d));
+          HIPCHECK(hipModuleUnload(modules[d]));
+        }
+      }
+      HIPCHECK(hipSetDevice(deviceId_));
+      if (r >= p_warmup) {
+        ms.push_back(elapsed.count());
+      }
+    }
 
-  if (kernel_vec.size() > 0) {
-    std::cout << "Time taken for Average hipModuleGetFunction : "
-      << (static_cast<double>(all_duration) / static_cast<double>(kernel_vec.size()))<<" nanoseconds "<<std::endl;
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%5zu kernels %3u FMAs %8zu B %s", kernels, body,
+             code.data.size(), loadOpStr[op]);
+    report(test, desc, code.data.size(), 1, "ms", ms);
   }
 
-  std::cout<<std::endl<<std::endl;
-
-  HIPCHECK(hipModuleUnload(Module));
-  return true;
-}
-#endif //__unix__
+ private:
+  struct CodeObject {
+    std::vector<char> data;
+    std::string path;  // temporary copy for hipModuleLoad
+  };
 
-int main() {
-  bool test_passed = true;
+  static std::string kernelName(size_t index) { return "module_kernel_" + std::to_string(index); }
 
-  do {
-#ifdef __unix__
-    //Preprocess contents for the test
-    if (!PreProcessContents()) {
-      std::cout<<"Failed in PreProcessContents step"<<std::endl;
-      test_passed = false;
-      break;
+  const CodeObject& codeObject(size_t kernels, unsigned int body) {
+    auto key = std::make_pair(kernels, body);
+    auto found = codeObjects_.find(key);
+    if (found != codeObjects_.end()) {
+      return found->second;
     }
 
-    //Run the test for all devices
-    int num_devices = 0;
-    HIPCHECK(hipGetDeviceCount(&num_devices));
-    for (int dev_idx = 0; dev_idx < num_devices; ++dev_idx) {
-      if (!RunTest(dev_idx)) {
-        test_passed = false;
-        break;
-      }
+    // A distinct constant per kernel keeps the compiler from merging them
+    std::string source = "#define BODY " + std::to_string(body) + "\n";
+    for (size_t k = 0; k < kernels; k++) {
+      source += "extern \"C\" __global__ void " + kernelName(k) + "(float* p) {\n"
+                "  float v = p[threadIdx.x];\n"
+                "#pragma unroll\n"
+                "  for (int i = 0; i < BODY; i++) v = fmaf(v, 1.0001f, " +
+                std::to_string(k) + ".0f);\n"
+                "  p[threadIdx.x] = v;\n"
+                "}\n";
     }
-#else
-    std::cout<<"Detected non-linux Os. Skipping the test"<<std::endl;
-#endif // __unix__
-  } while(0);
 
-  if (test_passed) {
-    passed();
+    hiprtcProgram prog;
+    HIPRTCCHECK(hiprtcCreateProgram(&prog, source.c_str(), "module.cu", 0, nullptr, nullptr));
+    HipTest::compileRtcProgram(prog, 0, nullptr);
+    CodeObject code;
+    size_t codeSize = 0;
+    HIPRTCCHECK(hiprtcGetCodeSize(prog, &codeSize));
+    code.data.resize(codeSize);
+    HIPRTCCHECK(hiprtcGetCode(prog, code.data.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+
+    const char* tmp = getenv("TMPDIR");
+    code.path = std::string(tmp != nullptr ? tmp : "/tmp") + "/hipPerfModuleLoad_" +
+        std::to_string(kernels) + "_" + std::to_string(body) + ".co";
+    std::ofstream file(code.path, std::ios::binary);
+    file.write(code.data.data(), code.data.size());
+    file.close();
+    if (!file) {
+      failed("Failed to write %s\n", code.path.c_str());
+    }
+    return codeObjects_.emplace(key, std::move(code)).first->second;
   }
 
-  return 0;
-}
+  std::vector<size_t> kernelCounts_;
+  std::map<std::pair<size_t, unsigned int>, CodeObject> codeObjects_;
+  float* buffer_;
+};
 
+HIP_PERF_BENCHMARK(hipPerfModuleLoad)
@@ -0,0 +1,323 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD_CMD: hipPerfRdcCost %hc -I%S/../../src %S/%s %S/../../src/test_common.cpp %S/../../src/timer.cpp %S/../../src/perf_harness.cpp %S/../../src/perf_main.cpp -lhiprtc -o %T/%t EXCLUDE_HIP_PLATFORM nvidia
+ * TEST: %t
+ * HIT_END
+ */
+
+// Runtime cost of relocatable device code. The same three kernels, which
+// call small device functions in their inner loops, are built with hiprtc
+// as one whole program, as two -fgpu-rdc inputs (the device functions and
+// the kernels, as in samples/2_Cookbook/15_static_library) and as one
+// -fgpu-rdc input per device function plus the kernels, the way a static
+// library of one object per function reaches the device link; the rdc
+// builds are linked with hiprtcLinkCreate/AddData/Complete. Per build it
+// reports the kernel times, their ratio to the whole program ("x whole
+// program"), registers and private segment bytes per kernel (a call that
+// was not inlined shows up as stack), the code object size and the time of
+// hipModuleLoadData plus unload. The device link sees bitcode and may
+// inline across inputs again, so this measures what is left after it.
+// Every build must produce the outputs of the whole program.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <hip/hiprtc.h>
+
+#include "perf_harness.h"
+
+enum RdcBuild { buildWhole = 0, buildRdcSplit, buildRdcLibrary, numRdcBuilds };
+static const char* rdcBuildStr[numRdcBuilds] = {"whole program", "rdc, 2 inputs",
+                                                "rdc, input per function"};
+
+// The last "workload" is the code object itself: size and load time
+enum RdcWorkload { workCompute = 0, workStream, workPrivate, numRdcWorkloads };
+static const char* rdcWorkloadStr[numRdcWorkloads] = {"rdc_compute", "rdc_stream",
+                                                      "rdc_private"};
+
+static const char* deviceFunctions[] = {
+    "__device__ float rdc_poly(float x) {\n"
+    "  return ((x * 0.5f + 0.25f) * x + 0.125f) * x + 1.0f;\n"
+    "}\n",
+    "__device__ float rdc_load(const float* p, int i) {\n"
+    "  return p[i] * 0.75f + p[i ^ 1] * 0.25f;\n"
+    "}\n",
+    "__device__ void rdc_accumulate(float* acc, float v) {\n"
+    "  acc[0] += v;\n"
+    "  acc[1] = fmaxf(acc[1], v);\n"
+    "}\n",
+};
+static const unsigned int numDeviceFunctions =
+    sizeof(deviceFunctions) / sizeof(deviceFunctions[0]);
+
+static const char* deviceDeclarations =
+    "extern __device__ float rdc_poly(float x);\n"
+    "extern __device__ float rdc_load(const float* p, int i);\n"
+    "extern __device__ void rdc_accumulate(float* acc, float v);\n";
+
+// rdc_private passes a pointer to a private array, which costs scratch unless inlined
+static const char* kernelSource = R"(
+extern "C" __global__ void rdc_compute(const float* in, float* out, int n, int steps) {
+  int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= n) return;
+  float x = in[i];
+  for (int s = 0; s < steps; s++) {
+    x = rdc_poly(x) * 0.5f;
+  }
+  out[i] = x;
+}
+extern "C" __global__ void rdc_stream(const float* in, float* out, int n, int steps) {
+  for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    out[i] = rdc_load(in, i) + 1.0f;
+  }
+}
+extern "C" __global__ void rdc_private(const float* in, float* out, int n, int steps) {
+  int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= n) return;
+  float acc[2] = {0.0f, 0.0f};
+  for (int s = 0; s < steps; s++) {
+    rdc_accumulate(acc, in[(i + s * 64) % n]);
+  }
+  out[i] = acc[0] + acc[1];
+}
+)";
+
+static const int elements = 16 * 1024 * 1024;  // even, rdc_load pairs neighbours
+static const unsigned int blockSize = 256;
+static const int computeSteps = 4096;
+static const int privateSteps = 256;
+static const unsigned int launchesPerRepetition = 10;
+static const size_t checkedElements = 4096;
+
+struct RdcModule {
+  std::vector<char> code;
+  hipModule_t module;
+  hipFunction_t functions[numRdcWorkloads];
+};
+
+class hipPerfRdcCost : public HipPerf::Benchmark {
+ public:
+  hipPerfRdcCost() : HipPerf::Benchmark("hipPerfRdcCost"), stream_(nullptr), in_(nullptr),
+      out_(nullptr) {
+    for (unsigned int w = 0; w < numRdcWorkloads; w++) {
+      wholeUs_[w] = 0;
+    }
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&in_, sizeof(float) * elements));
+    HIPCHECK(hipMalloc(&out_, sizeof(float) * elements));
+    std::vector<float> host(elements);
+    for (int i = 0; i < elements; i++) {
+      host[i] = static_cast<float>(i % 1024) / 1024;
+    }
+    HIPCHECK(hipMemcpy(in_, host.data(), sizeof(float) * elements, hipMemcpyHostToDevice));
+
+    // Compiling and linking is not timed, hipPerfRtcLink covers it
+    for (unsigned int b = 0; b < numRdcBuilds; b++) {
+      RdcModule& built = modules_[b];
+      built.code = build(static_cast<RdcBuild>(b));
+      HIPCHECK(hipModuleLoadData(&built.module, built.code.data()));
+      for (unsigned int w = 0; w < numRdcWorkloads; w++) {
+        HIPCHECK(hipModuleGetFunction(&built.functions[w], built.module, rdcWorkloadStr[w]));
+      }
+    }
+  }
+
+  void close() override {
+    for (auto& built : modules_) {
+      HIPCHECK(hipModuleUnload(built.module));
+    }
+    HIPCHECK(hipFree(out_));
+    HIPCHECK(hipFree(in_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  // Builds are the inner index, so the whole program runs first for every workload
+  unsigned int numTests() override { return (numRdcWorkloads + 1) * numRdcBuilds; }
+
+  void run(unsigned int test) override {
+    RdcBuild b = static_cast<RdcBuild>(test % numRdcBuilds);
+    unsigned int w = test / numRdcBuilds;
+    if (w == numRdcWorkloads) {
+      runLoad(test, b);
+    } else {
+      runKernel(test, b, static_cast<RdcWorkload>(w));
+    }
+  }
+
+ private:
+  void runKernel(unsigned int test, RdcBuild b, RdcWorkload w) {
+    hipFunction_t function = modules_[b].functions[w];
+    int n = elements;
+    int steps = w == workCompute ? computeSteps : privateSteps;
+    void* args[] = {&in_, &out_, &n, &steps};
+    unsigned int blocks = (elements + blockSize - 1) / blockSize;
+    if (w == workStream) {
+      blocks = std::min(blocks, static_cast<unsigned int>(props_.multiProcessorCount) * 16);
+    }
+
+    HIPCHECK(hipMemsetAsync(out_, 0, sizeof(float) * elements, stream_));
+    auto sec = measure([&]() {
+      for (unsigned int i = 0; i < launchesPerRepetition; i++) {
+        HIPCHECK(hipModuleLaunchKernel(function, blocks, 1, 1, blockSize, 1, 1, 0, stream_, args,
+                                       nullptr));
+      }
+      HIPCHECK(hipStreamSynchronize(stream_));
+    });
+    verify(b, w);
+
+    int registers = 0;
+    int privateBytes = 0;
+    HIPCHECK(hipFuncGetAttribute(&registers, HIP_FUNC_ATTRIBUTE_NUM_REGS, function));
+    HIPCHECK(hipFuncGetAttribute(&privateBytes, HIP_FUNC_ATTRIBUTE_LOCAL_SIZE_BYTES, function));
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%-12s %s", rdcWorkloadStr[w], rdcBuildStr[b]);
+    auto us = HipPerf::toMicroseconds(sec, launchesPerRepetition);
+    report(test, desc, sizeof(float) * elements * 2, launchesPerRepetition, "us", us);
+    double median = ComputePerfStats(us).median;
+    if (b == buildWhole) {
+      wholeUs_[w] = median;
+    } else if (wholeUs_[w] > 0) {
+      report(test, desc, 0, launchesPerRepetition, "x whole program", {median / wholeUs_[w]},
+             HipPerf::betterLower);
+    }
+    report(test, desc, 0, 1, "registers", {static_cast<double>(registers)});
+    report(test, desc, 0, 1, "private bytes", {static_cast<double>(privateBytes)});
+  }
+
+  void runLoad(unsigned int test, RdcBuild b) {
+    const std::vector<char>& code = modules_[b].code;
+    auto sec = measure([&]() {
+      hipModule_t module;
+      HIPCHECK(hipModuleLoadData(&module, code.data()));
+      HIPCHECK(hipModuleUnload(module));
+    });
+    std::string desc = std::string("code object  ") + rdcBuildStr[b];
+    report(test, desc + " size", code.size(), 1, "KB", {code.size() / 1024.0});
+    report(test, desc + " load + unload", code.size(), 1, "us", HipPerf::toMicroseconds(sec, 1));
+  }
+
+  // The whole program output is the reference of the other builds
+  void verify(RdcBuild b, RdcWorkload w) {
+    std::vector<float> out(checkedElements);
+    HIPCHECK(hipMemcpy(out.data(), out_, sizeof(float) * checkedElements,
+                       hipMemcpyDeviceToHost));
+    if (b == buildWhole) {
+      reference_[w] = out;
+      return;
+    }
+    for (size_t i = 0; i < checkedElements; i++) {
+      float expected = reference_[w][i];
+      if (std::fabs(out[i] - expected) > 1e-5f * std::fabs(expected) + 1e-6f) {
+        failed("%s %s: element %zu is %f, whole program %f", rdcWorkloadStr[w], rdcBuildStr[b], i,
+               out[i], expected);
+      }
+    }
+  }
+
+  std::vector<char> build(RdcBuild b) {
+    if (b == buildWhole) {
+      std::string source;
+      for (auto function : deviceFunctions) {
+        source += function;
+      }
+      return compileCode(source + kernelSource);
+    }
+    std::vector<std::vector<char>> inputs;
+    if (b == buildRdcSplit) {
+      std::string functions;
+      for (auto function : deviceFunctions) {
+        functions += function;
+      }
+      inputs.push_back(compileBitcode(functions));
+    } else {
+      for (unsigned int f = 0; f < numDeviceFunctions; f++) {
+        inputs.push_back(compileBitcode(deviceFunctions[f]));
+      }
+    }
+    inputs.push_back(compileBitcode(std::string(deviceDeclarations) + kernelSource));
+    return link(inputs);
+  }
+
+  static hiprtcProgram compileProgram(const std::string& source, int numOptions,
+                                      const char** options) {
+    hiprtcProgram prog;
+    HIPRTCCHECK(hiprtcCreateProgram(&prog, source.c_str(), "rdc.cu", 0, nullptr, nullptr));
+    HipTest::compileRtcProgram(prog, numOptions, options);
+    return prog;
+  }
+
+  static std::vector<char> compileBitcode(const std::string& source) {
+    const char* options[] = {"-fgpu-rdc", "-O3"};
+    hiprtcProgram prog = compileProgram(source, 2, options);
+    size_t size = 0;
+    HIPRTCCHECK(hiprtcGetBitcodeSize(prog, &size));
+    std::vector<char> bitcode(size);
+    HIPRTCCHECK(hiprtcGetBitcode(prog, bitcode.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+    return bitcode;
+  }
+
+  static std::vector<char> compileCode(const std::string& source) {
+    const char* options[] = {"-O3"};
+    hiprtcProgram prog = compileProgram(source, 1, options);
+    size_t size = 0;
+    HIPRTCCHECK(hiprtcGetCodeSize(prog, &size));
+    std::vector<char> code(size);
+    HIPRTCCHECK(hiprtcGetCode(prog, code.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+    return code;
+  }
+
+  // The linked code object belongs to the link state, it is copied out before the destroy
+  static std::vector<char> link(std::vector<std::vector<char>>& inputs) {
+    hiprtcLinkState state;
+    HIPRTCCHECK(hiprtcLinkCreate(0, nullptr, nullptr, &state));
+    for (size_t i = 0; i < inputs.size(); i++) {
+      std::string name = "input_" + std::to_string(i);
+      HIPRTCCHECK(hiprtcLinkAddData(state, HIPRTC_JIT_INPUT_LLVM_BITCODE, inputs[i].data(),
+                                    inputs[i].size(), name.c_str(), 0, nullptr, nullptr));
+    }
+    void* code = nullptr;
+    size_t size = 0;
+    HIPRTCCHECK(hiprtcLinkComplete(state, &code, &size));
+    std::vector<char> copy(static_cast<char*>(code), static_cast<char*>(code) + size);
+    HIPRTCCHECK(hiprtcLinkDestroy(state));
+    return copy;
+  }
+
+  hipStream_t stream_;
+  float* in_;
+  float* out_;
+  RdcModule modules_[numRdcBuilds];
+  double wholeUs_[numRdcWorkloads];  // median of the whole program build per workload
+  std::vector<float> reference_[numRdcWorkloads];
+};
+
+HIP_PERF_BENCHMARK(hipPerfRdcCost)
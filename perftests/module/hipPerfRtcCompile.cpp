@@ -0,0 +1,214 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lhiprtc -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// hiprtc compile latency and parallel compile throughput. The latency cases
+// vary one property of a 16 kernel -O3 program at a time: the kernel count,
+// the number of template instantiations requested with
+// hiprtcAddNameExpression, the -O level and the included headers (the
+// builtin hip_fp16.h or in-memory headers passed to hiprtcCreateProgram).
+// One sample is create, compile, lowered name lookup, code retrieval and
+// destroy. The parallel cases compile the base program from 1 to
+// hardware_concurrency threads at once and report programs per second over
+// all threads. Every compiled source carries a unique constant so no compile
+// cache can serve it.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <hip/hiprtc.h>
+
+#include "perf_harness.h"
+
+struct CompileCase {
+  const char* group;
+  unsigned int kernels;
+  unsigned int names;    // template instantiations through hiprtcAddNameExpression
+  const char* opt;
+  bool fp16;             // includes the builtin hip/hip_fp16.h
+  unsigned int headers;  // in-memory headers
+};
+
+static const CompileCase compileCases[] = {
+    {"kernels", 1, 0, "-O3", false, 0},     {"kernels", 16, 0, "-O3", false, 0},
+    {"kernels", 128, 0, "-O3", false, 0},   {"kernels", 1024, 0, "-O3", false, 0},
+    {"names", 16, 8, "-O3", false, 0},      {"names", 16, 64, "-O3", false, 0},
+    {"names", 16, 512, "-O3", false, 0},    {"opt", 16, 0, "-O0", false, 0},
+    {"opt", 16, 0, "-O1", false, 0},        {"opt", 16, 0, "-O2", false, 0},
+    {"headers", 16, 0, "-O3", true, 0},     {"headers", 16, 0, "-O3", false, 8},
+    {"headers", 16, 0, "-O3", false, 64}};
+static const unsigned int numCompileCases = sizeof(compileCases) / sizeof(compileCases[0]);
+
+// Program compiled by the parallel cases
+static const CompileCase& baseCase = compileCases[1];
+static const unsigned int programsPerThread = 4;
+// Device functions per in-memory header
+static const unsigned int functionsPerHeader = 32;
+
+class hipPerfRtcCompile : public HipPerf::Benchmark {
+ public:
+  hipPerfRtcCompile() : HipPerf::Benchmark("hipPerfRtcCompile"), salt_(0) {
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int t = 1; t < maxThreads; t *= 2) {
+      threadCounts_.push_back(t);
+    }
+    threadCounts_.push_back(maxThreads);
+  }
+
+  unsigned int numTests() override { return numCompileCases + threadCounts_.size(); }
+
+  void run(unsigned int test) override {
+    if (test < numCompileCases) {
+      const CompileCase& c = compileCases[test];
+      std::vector<double> ms;
+      for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        compile(c);
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (r >= p_warmup) {
+          ms.push_back(elapsed.count());
+        }
+      }
+      char desc[128];
+      snprintf(desc, sizeof(desc), "%-7s %4u kernels %3u names %s%s %2u headers", c.group,
+               c.kernels, c.names, c.opt, c.fp16 ? " hip_fp16.h" : "", c.headers);
+      report(test, desc, 0, 1, "ms", ms);
+      return;
+    }
+
+    unsigned int numThreads = threadCounts_[test - numCompileCases];
+    std::vector<double> rates;
+    measure([&]() {
+      std::atomic<unsigned int> ready(0);
+      std::atomic<bool> go(false);
+      std::vector<std::thread> threads;
+      for (unsigned int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&]() {
+          ready++;
+          while (!go.load(std::memory_order_acquire)) {
+          }
+          for (unsigned int p = 0; p < programsPerThread; p++) {
+            compile(baseCase);
+          }
+        });
+      }
+      // Thread creation is not part of the compile time
+      while (ready.load() != numThreads) {
+      }
+      auto start = std::chrono::steady_clock::now();
+      go.store(true, std::memory_order_release);
+      for (auto& thread : threads) {
+        thread.join();
+      }
+      std::chrono::duration<double> sec = std::chrono::steady_clock::now() - start;
+      if (!HipPerf::Counters::collecting()) {
+        rates.push_back(numThreads * programsPerThread / sec.count());
+      }
+    });
+    rates = HipPerf::measuredSamples(rates);
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "parallel %3u threads, %u programs each", numThreads,
+             programsPerThread);
+    report(test, desc, 0, programsPerThread, "programs/s", rates);
+  }
+
+ private:
+  static std::string headerName(unsigned int h) { return "header_" + std::to_string(h) + ".h"; }
+
+  std::string headerSource(unsigned int h) {
+    std::string source = "#pragma once\n";
+    for (unsigned int f = 0; f < functionsPerHeader; f++) {
+      std::string name = "h" + std::to_string(h) + "_f" + std::to_string(f);
+      source += "__device__ inline float " + name + "(float v) { return v * " +
+                std::to_string(f + 1) + ".5f + " + std::to_string(h) + ".0f; }\n";
+    }
+    return source;
+  }
+
+  // Builds one program of the given shape and returns once its code is retrieved
+  void compile(const CompileCase& c) {
+    std::string source = "#define SALT " + std::to_string(salt_++) + "\n";
+    if (c.fp16) {
+      source += "#include <hip/hip_fp16.h>\n";
+    }
+    std::vector<std::string> headers;
+    std::vector<std::string> headerNames;
+    for (unsigned int h = 0; h < c.headers; h++) {
+      headers.push_back(headerSource(h));
+      headerNames.push_back(headerName(h));
+      source += "#include \"" + headerNames.back() + "\"\n";
+    }
+    for (unsigned int k = 0; k < c.kernels; k++) {
+      source += "extern \"C\" __global__ void kernel_" + std::to_string(k) +
+                "(float* p, int n) {\n"
+                "  int i = blockIdx.x * blockDim.x + threadIdx.x;\n"
+                "  if (i < n) p[i] = p[i] * " + std::to_string(k + 2) + ".0f + SALT;\n"
+                "}\n";
+    }
+    if (c.names > 0) {
+      source += "template <int N> __global__ void scaled(float* p) {\n"
+                "  p[threadIdx.x] *= N + SALT;\n"
+                "}\n";
+    }
+
+    std::vector<const char*> headerSources;
+    std::vector<const char*> headerIncludes;
+    for (unsigned int h = 0; h < c.headers; h++) {
+      headerSources.push_back(headers[h].c_str());
+      headerIncludes.push_back(headerNames[h].c_str());
+    }
+    hiprtcProgram prog;
+    HIPRTCCHECK(hiprtcCreateProgram(&prog, source.c_str(), "compile.cu", c.headers,
+                                    c.headers > 0 ? headerSources.data() : nullptr,
+                                    c.headers > 0 ? headerIncludes.data() : nullptr));
+    std::vector<std::string> expressions;
+    for (unsigned int n = 0; n < c.names; n++) {
+      expressions.push_back("scaled<" + std::to_string(n) + ">");
+      HIPRTCCHECK(hiprtcAddNameExpression(prog, expressions.back().c_str()));
+    }
+    const char* options[] = {c.opt};
+    HipTest::compileRtcProgram(prog, 1, options);
+    for (const auto& expression : expressions) {
+      const char* lowered = nullptr;
+      HIPRTCCHECK(hiprtcGetLoweredName(prog, expression.c_str(), &lowered));
+    }
+    size_t codeSize = 0;
+    HIPRTCCHECK(hiprtcGetCodeSize(prog, &codeSize));
+    std::vector<char> code(codeSize);
+    HIPRTCCHECK(hiprtcGetCode(prog, code.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+  }
+
+  std::atomic<unsigned int> salt_;
+  std::vector<unsigned int> threadCounts_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfRtcCompile)
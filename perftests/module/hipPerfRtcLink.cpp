@@ -0,0 +1,203 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lhiprtc
+ * TEST: %t
+ * HIT_END
+ */
+
+// hiprtc bitcode linker pipeline. A program of N inputs with K kernels each
+// is built two ways: as one program compiled straight to a code object, and
+// as N -fgpu-rdc programs whose bitcode is linked with hiprtcLinkCreate,
+// hiprtcLinkAddData and hiprtcLinkComplete. Every input calls a device
+// function defined in the first one, so the link has to resolve symbols
+// across inputs. Three times are reported per shape: the link alone from
+// cached bitcode, separate compiles plus link plus module load, and the
+// single program compile plus module load. Splitting a program only pays
+// off when the link alone is well below the single program time. Compiled
+// sources carry a unique constant so no compile cache can serve them.
+
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+
+#include <hip/hiprtc.h>
+
+#include "perf_harness.h"
+
+enum LinkOp { LINK_ONLY, LINK_SEPARATE, LINK_SINGLE, NUM_LINK_OPS };
+static const char* linkOpStr[] = {"link cached bitcode", "separate compile + link + load",
+                                  "single program compile + load"};
+
+static const unsigned int inputCounts[] = {1, 4, 16, 64};
+static const unsigned int numInputCounts = sizeof(inputCounts) / sizeof(inputCounts[0]);
+// Kernels per input, small and large inputs
+static const unsigned int kernelCounts[] = {4, 64};
+static const unsigned int numKernelCounts = sizeof(kernelCounts) / sizeof(kernelCounts[0]);
+
+class hipPerfRtcLink : public HipPerf::Benchmark {
+ public:
+  hipPerfRtcLink() : HipPerf::Benchmark("hipPerfRtcLink"), salt_(0) {}
+
+  unsigned int numTests() override { return numInputCounts * numKernelCounts * NUM_LINK_OPS; }
+
+  void run(unsigned int test) override {
+    LinkOp op = static_cast<LinkOp>(test % NUM_LINK_OPS);
+    unsigned int kernels = kernelCounts[(test / NUM_LINK_OPS) % numKernelCounts];
+    unsigned int inputs = inputCounts[test / (NUM_LINK_OPS * numKernelCounts)];
+
+    // The link only case reuses one set of inputs, compiled outside the timing
+    std::vector<std::vector<char>> cached;
+    if (op == LINK_ONLY) {
+      unsigned int salt = salt_++;
+      for (unsigned int i = 0; i < inputs; i++) {
+        cached.push_back(compileBitcode(inputSource(salt, i, kernels)));
+      }
+    }
+
+    std::vector<double> ms;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      auto start = std::chrono::steady_clock::now();
+      switch (op) {
+        case LINK_ONLY:
+          link(cached, nullptr);
+          break;
+        case LINK_SEPARATE: {
+          unsigned int salt = salt_++;
+          std::vector<std::vector<char>> bitcode;
+          for (unsigned int i = 0; i < inputs; i++) {
+            bitcode.push_back(compileBitcode(inputSource(salt, i, kernels)));
+          }
+          hipModule_t module;
+          link(bitcode, &module);
+          HIPCHECK(hipModuleUnload(module));
+          break;
+        }
+        case LINK_SINGLE: {
+          std::vector<char> code = compileCode(singleSource(salt_++, inputs, kernels));
+          hipModule_t module;
+          HIPCHECK(hipModuleLoadData(&module, code.data()));
+          HIPCHECK(hipModuleUnload(module));
+          break;
+        }
+        default:
+          break;
+      }
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (r >= p_warmup) {
+        ms.push_back(elapsed.count());
+      }
+    }
+
+    char desc[128];
+    snprintf(desc, sizeof(desc), "%2u inputs x %2u kernels, %s", inputs, kernels,
+             linkOpStr[op]);
+    report(test, desc, 0, 1, "ms", ms);
+  }
+
+ private:
+  static std::string kernelSource(unsigned int input, unsigned int kernels) {
+    std::string source;
+    for (unsigned int k = 0; k < kernels; k++) {
+      source += "extern \"C\" __global__ void kernel_" + std::to_string(input) + "_" +
+                std::to_string(k) +
+                "(float* p, int n) {\n"
+                "  int i = blockIdx.x * blockDim.x + threadIdx.x;\n"
+                "  if (i < n) p[i] = link_scale(p[i]) * " + std::to_string(k + 2) + ".0f + SALT;\n"
+                "}\n";
+    }
+    return source;
+  }
+
+  static std::string scaleSource(unsigned int salt) {
+    return "__device__ float link_scale(float v) { return v * 1.5f + " + std::to_string(salt) +
+           ".0f; }\n";
+  }
+
+  // One rdc input; input 0 defines the shared device function, the others reference it
+  static std::string inputSource(unsigned int salt, unsigned int input, unsigned int kernels) {
+    std::string source = "#define SALT " + std::to_string(salt) + "\n";
+    source += input == 0 ? scaleSource(salt) : "extern __device__ float link_scale(float v);\n";
+    return source + kernelSource(input, kernels);
+  }
+
+  static std::string singleSource(unsigned int salt, unsigned int inputs, unsigned int kernels) {
+    std::string source = "#define SALT " + std::to_string(salt) + "\n" + scaleSource(salt);
+    for (unsigned int i = 0; i < inputs; i++) {
+      source += kernelSource(i, kernels);
+    }
+    return source;
+  }
+
+  static hiprtcProgram compileProgram(const std::string& source, int numOptions,
+                                      const char** options) {
+    hiprtcProgram prog;
+    HIPRTCCHECK(hiprtcCreateProgram(&prog, source.c_str(), "link.cu", 0, nullptr, nullptr));
+    HipTest::compileRtcProgram(prog, numOptions, options);
+    return prog;
+  }
+
+  static std::vector<char> compileBitcode(const std::string& source) {
+    const char* options[] = {"-fgpu-rdc", "-O3"};
+    hiprtcProgram prog = compileProgram(source, 2, options);
+    size_t size = 0;
+    HIPRTCCHECK(hiprtcGetBitcodeSize(prog, &size));
+    std::vector<char> bitcode(size);
+    HIPRTCCHECK(hiprtcGetBitcode(prog, bitcode.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+    return bitcode;
+  }
+
+  static std::vector<char> compileCode(const std::string& source) {
+    const char* options[] = {"-O3"};
+    hiprtcProgram prog = compileProgram(source, 1, options);
+    size_t size = 0;
+    HIPRTCCHECK(hiprtcGetCodeSize(prog, &size));
+    std::vector<char> code(size);
+    HIPRTCCHECK(hiprtcGetCode(prog, code.data()));
+    HIPRTCCHECK(hiprtcDestroyProgram(&prog));
+    return code;
+  }
+
+  // Links the inputs into a code object and loads it into module when given. The
+  // linked code object belongs to the link state, so it is loaded before the destroy.
+  static void link(std::vector<std::vector<char>>& inputs, hipModule_t* module) {
+    hiprtcLinkState state;
+    HIPRTCCHECK(hiprtcLinkCreate(0, nullptr, nullptr, &state));
+    for (size_t i = 0; i < inputs.size(); i++) {
+      std::string name = "input_" + std::to_string(i);
+      HIPRTCCHECK(hiprtcLinkAddData(state, HIPRTC_JIT_INPUT_LLVM_BITCODE, inputs[i].data(),
+                                    inputs[i].size(), name.c_str(), 0, nullptr, nullptr));
+    }
+    void* code = nullptr;
+    size_t size = 0;
+    HIPRTCCHECK(hiprtcLinkComplete(state, &code, &size));
+    if (module != nullptr) {
+      HIPCHECK(hipModuleLoadData(module, code));
+    }
+    HIPRTCCHECK(hiprtcLinkDestroy(state));
+  }
+
+  unsigned int salt_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfRtcLink)
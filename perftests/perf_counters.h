@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/*
+ * Plugin interface for hardware counter collection in the perftests.
+ *
+ * --counters <plugin.so>[:<counter list>] loads a shared library exporting the
+ * functions below with C linkage. The harness runs every measured operation
+ * once more, untimed, between hipPerfCountersStart() and hipPerfCountersStop()
+ * and reports the returned values with the timing of that measurement, so the
+ * collection overhead never shows up in the timings.
+ *
+ * A plugin wraps whatever profiling library is installed (rocprofiler,
+ * CUPTI, ...); the harness itself links none of them. The counter list after
+ * ':' is passed through unchanged, for example
+ * --counters libmycounters.so:TCC_HIT_sum,TCC_MISS_sum,SQ_INSTS_VALU
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Called before the first collection on a device, again when the device
+// changes. Returns 0 on success, anything else disables counter collection.
+int hipPerfCountersInit(int device, const char* counters);
+// Starts counting, the counted operation is enqueued right after.
+int hipPerfCountersStart(void);
+// Stops counting once the operation has completed. Writes up to 'max' counter
+// names and values, names must stay valid until the next call. Returns the
+// number of counters written, negative on error.
+int hipPerfCountersStop(const char** names, double* values, int max);
+// Called once at exit.
+void hipPerfCountersShutdown(void);
+
+typedef int (*hipPerfCountersInitFn)(int device, const char* counters);
+typedef int (*hipPerfCountersStartFn)(void);
+typedef int (*hipPerfCountersStopFn)(const char** names, double* values, int max);
+typedef void (*hipPerfCountersShutdownFn)(void);
+
+#ifdef __cplusplus
+}
+#endif
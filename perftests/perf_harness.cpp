@@ -0,0 +1,1289 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "perf_harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__HIP_PLATFORM_AMD__) && defined(__linux__)
+#include "../catch/include/hip_test_smi.hh"
+#define HIP_PERF_TELEMETRY 1
+#endif
+
+namespace HipPerf {
+
+static std::vector<BenchmarkFactory>& registry() {
+  static std::vector<BenchmarkFactory> factories;
+  return factories;
+}
+
+bool registerBenchmark(BenchmarkFactory factory) {
+  registry().push_back(factory);
+  return true;
+}
+
+namespace {
+
+struct DeviceInfo {
+  std::string name;
+  std::string arch;
+  std::string uuid;
+  int driverVersion;
+  int runtimeVersion;
+};
+
+const std::string& hostName() {
+  static std::string host;
+  if (host.empty()) {
+#ifdef __linux__
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) == 0) {
+      host = name;
+    }
+#else
+    const char* name = getenv("COMPUTERNAME");
+    if (name != nullptr) {
+      host = name;
+    }
+#endif
+    if (host.empty()) {
+      host = "unknown";
+    }
+  }
+  return host;
+}
+
+// GPU-xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx like rocm-smi and nvidia-smi, empty when unsupported
+std::string deviceUuid(int device) {
+  hipUUID uuid;
+  if (hipDeviceGetUuid(&uuid, device) != hipSuccess) {
+    return "";
+  }
+  std::string out = "GPU-";
+  char hex[3];
+  for (int i = 0; i < 16; i++) {
+    if (i == 4 || i == 6 || i == 8 || i == 10) {
+      out += '-';
+    }
+    snprintf(hex, sizeof(hex), "%02x", static_cast<unsigned char>(uuid.bytes[i]));
+    out += hex;
+  }
+  return out;
+}
+
+const DeviceInfo& deviceInfo(int device) {
+  static std::map<int, DeviceInfo> cache;
+  auto it = cache.find(device);
+  if (it != cache.end()) {
+    return it->second;
+  }
+
+  hipDeviceProp_t props;
+  memset(&props, 0, sizeof(props));
+  HIPCHECK(hipGetDeviceProperties(&props, device));
+  DeviceInfo info;
+  info.name = props.name;
+  info.arch = props.gcnArchName;
+  info.uuid = deviceUuid(device);
+  HIPCHECK(hipDriverGetVersion(&info.driverVersion));
+  HIPCHECK(hipRuntimeGetVersion(&info.runtimeVersion));
+  return cache[device] = info;
+}
+
+// Expands %h to the host name and %d to the device, so every process of a fleet run started
+// with the same command line writes its own result file
+std::string outputPath(const char* pattern) {
+  std::string path;
+  for (const char* c = pattern; *c != '\0'; c++) {
+    if (c[0] == '%' && c[1] == 'h') {
+      path += hostName();
+      c++;
+    } else if (c[0] == '%' && c[1] == 'd') {
+      path += std::to_string(p_gpuDevice);
+      c++;
+    } else {
+      path += *c;
+    }
+  }
+  return path;
+}
+
+std::ostream& resultStream() {
+  if (p_output == nullptr) {
+    return std::cout;
+  }
+  static std::ofstream file(outputPath(p_output), std::ios::out | std::ios::trunc);
+  if (!file.is_open()) {
+    failed("Unable to open output file %s\n", outputPath(p_output).c_str());
+  }
+  return file;
+}
+
+std::string jsonEscape(const std::string& str) {
+  std::string out;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out += ' ';
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+std::string csvEscape(const std::string& str) {
+  std::string out = "\"";
+  for (char c : str) {
+    if (c == '"') out += '"';
+    out += c;
+  }
+  return out + "\"";
+}
+
+void writeText(std::ostream& os, const Result& result, const CPerfStats& stats) {
+  os << result.benchmark << "[" << std::setw(3) << result.test << "] " << std::left
+     << std::setw(40) << result.desc << std::right;
+  if (result.bytes != 0) {
+    os << " size " << std::setw(10) << result.bytes;
+  }
+  os << " iters " << std::setw(6) << result.iterations << " : " << std::setw(12) << stats.mean
+     << " " << result.unit;
+  if (stats.count > 1) {
+    os << " (min " << stats.min << " median " << stats.median << " p90 " << stats.p90 << " p99 "
+       << stats.p99 << " max " << stats.max << " stddev " << stats.stddev;
+    if (stats.medianCi >= 0) {
+      os << " median ci " << stats.medianCi * 100 << "%";
+    }
+    os << " over " << stats.count << " samples)";
+  }
+  os << std::endl;
+
+  if (!result.counters.empty()) {
+    os << "  counters:";
+    for (const auto& counter : result.counters) {
+      os << " " << counter.first << " " << counter.second;
+    }
+    os << std::endl;
+  }
+
+  const TelemetrySummary& t = result.telemetry;
+  if (t.samples == 0) {
+    return;
+  }
+  os << "  telemetry:";
+  if (t.sclkMean >= 0) os << " sclk " << t.sclkMean << " MHz (min " << t.sclkMin << ")";
+  if (t.mclkMean >= 0) os << " mclk " << t.mclkMean << " MHz (min " << t.mclkMin << ")";
+  if (t.powerMean >= 0) os << " power " << t.powerMean << " W (max " << t.powerMax << ")";
+  if (t.tempMean >= 0) os << " temp " << t.tempMean << " C (max " << t.tempMax << ")";
+  if (t.throttled >= 0) os << " throttled " << t.throttled << "/" << t.samples;
+  os << " over " << t.samples << " samples" << std::endl;
+}
+
+// Empty for values the device did not report, so csv columns stay aligned.
+std::string csvValue(double value) {
+  if (value < 0) {
+    return "";
+  }
+  std::ostringstream os;
+  os << value;
+  return os.str();
+}
+
+void writeJsonTelemetry(std::ostream& os, const TelemetrySummary& t) {
+  os << ",\"telemetry\":{\"samples\":" << t.samples;
+  if (t.sclkMean >= 0) {
+    os << ",\"sclk_mean_mhz\":" << t.sclkMean << ",\"sclk_min_mhz\":" << t.sclkMin;
+  }
+  if (t.mclkMean >= 0) {
+    os << ",\"mclk_mean_mhz\":" << t.mclkMean << ",\"mclk_min_mhz\":" << t.mclkMin;
+  }
+  if (t.powerMean >= 0) {
+    os << ",\"power_mean_w\":" << t.powerMean << ",\"power_max_w\":" << t.powerMax;
+  }
+  if (t.tempMean >= 0) {
+    os << ",\"temp_mean_c\":" << t.tempMean << ",\"temp_max_c\":" << t.tempMax;
+  }
+  if (t.throttled >= 0) {
+    os << ",\"throttled_samples\":" << t.throttled;
+  }
+  os << "}";
+}
+
+}  // namespace
+
+void writeResult(const Result& result) {
+  if (result.values.empty()) {
+    return;
+  }
+
+  CPerfStats stats = ComputePerfStats(result.values);
+
+  std::ostream& os = resultStream();
+  if (!strcmp(p_format, "text")) {
+    writeText(os, result, stats);
+    return;
+  }
+
+  const DeviceInfo& info = deviceInfo(result.device);
+  if (!strcmp(p_format, "json")) {
+    os << "{\"benchmark\":\"" << jsonEscape(result.benchmark) << "\",\"test\":" << result.test
+       << ",\"desc\":\"" << jsonEscape(result.desc) << "\",\"device\":" << result.device
+       << ",\"device_name\":\"" << jsonEscape(info.name) << "\",\"arch\":\""
+       << jsonEscape(info.arch) << "\",\"driver_version\":" << info.driverVersion
+       << ",\"runtime_version\":" << info.runtimeVersion << ",\"host\":\""
+       << jsonEscape(hostName()) << "\",\"gpu_uuid\":\"" << jsonEscape(info.uuid)
+       << "\",\"size\":" << result.bytes
+       << ",\"iterations\":" << result.iterations << ",\"unit\":\"" << jsonEscape(result.unit)
+       << "\"";
+    if (result.better != betterByUnit) {
+      os << ",\"better\":\"" << (result.better == betterHigher ? "higher" : "lower") << "\"";
+    }
+    os << ",\"samples\":" << stats.count << ",\"min\":" << stats.min
+       << ",\"median\":" << stats.median << ",\"p90\":" << stats.p90 << ",\"p99\":" << stats.p99
+       << ",\"max\":" << stats.max << ",\"mean\":" << stats.mean << ",\"stddev\":" << stats.stddev;
+    if (stats.medianCi >= 0) {
+      os << ",\"median_ci\":" << stats.medianCi;
+    }
+    if (result.telemetry.samples != 0) {
+      writeJsonTelemetry(os, result.telemetry);
+    }
+    if (!result.counters.empty()) {
+      const char* separator = "";
+      os << ",\"counters\":{";
+      for (const auto& counter : result.counters) {
+        os << separator << "\"" << jsonEscape(counter.first) << "\":" << counter.second;
+        separator = ",";
+      }
+      os << "}";
+    }
+    os << "}" << std::endl;
+  } else {
+    static bool header = false;
+    if (!header) {
+      os << "benchmark,test,desc,device,device_name,arch,driver_version,runtime_version,host,"
+            "gpu_uuid,size,iterations,unit,samples,min,median,p90,p99,max,mean,stddev,median_ci";
+      if (p_telemetry != 0) {
+        os << ",telemetry_samples,sclk_mean_mhz,sclk_min_mhz,mclk_mean_mhz,mclk_min_mhz,"
+              "power_mean_w,power_max_w,temp_mean_c,temp_max_c,throttled_samples";
+      }
+      if (p_counters != nullptr) {
+        os << ",counters";
+      }
+      os << std::endl;
+      header = true;
+    }
+    os << result.benchmark << "," << result.test << "," << csvEscape(result.desc) << ","
+       << result.device << "," << csvEscape(info.name) << "," << csvEscape(info.arch) << ","
+       << info.driverVersion << "," << info.runtimeVersion << "," << csvEscape(hostName()) << ","
+       << csvEscape(info.uuid) << "," << result.bytes << ","
+       << result.iterations << "," << csvEscape(result.unit) << "," << stats.count << ","
+       << stats.min << "," << stats.median << "," << stats.p90 << "," << stats.p99 << ","
+       << stats.max << "," << stats.mean << "," << stats.stddev << "," << csvValue(stats.medianCi);
+    if (p_telemetry != 0) {
+      const TelemetrySummary& t = result.telemetry;
+      os << "," << t.samples << "," << csvValue(t.sclkMean) << "," << csvValue(t.sclkMin) << ","
+         << csvValue(t.mclkMean) << "," << csvValue(t.mclkMin) << "," << csvValue(t.powerMean)
+         << "," << csvValue(t.powerMax) << "," << csvValue(t.tempMean) << ","
+         << csvValue(t.tempMax) << "," << csvValue(t.throttled);
+    }
+    if (p_counters != nullptr) {
+      // One column of name=value pairs, the counter set depends on the plugin
+      std::string counters;
+      for (const auto& counter : result.counters) {
+        std::ostringstream value;
+        value << counter.second;
+        counters += (counters.empty() ? "" : ";") + counter.first + "=" + value.str();
+      }
+      os << "," << csvEscape(counters);
+    }
+    os << std::endl;
+  }
+}
+
+TimerBackend timerBackend() {
+  if (!strcmp(p_timer, "event")) {
+    return timerEvent;
+  } else if (!strcmp(p_timer, "kernel")) {
+    return timerKernel;
+  }
+  return timerHost;
+}
+
+const char* timerBackendName() { return p_timer; }
+
+DeviceClock::~DeviceClock() {
+  if (stamps_ != nullptr) {
+    HIPCHECK(hipFree(stamps_));
+  }
+}
+
+void DeviceClock::open(int deviceId) {
+  int rateKHz = 0;
+  HIPCHECK(hipDeviceGetAttribute(&rateKHz, hipDeviceAttributeWallClockRate, deviceId));
+  if (rateKHz <= 0) {
+    failed("Device %d reports no wall clock rate, --timer kernel is not supported\n", deviceId);
+  }
+  rateHz_ = rateKHz * 1000.0;
+  if (stamps_ == nullptr) {
+    HIPCHECK(hipMalloc(&stamps_, sizeof(KernelStamps)));
+  }
+  reset();
+}
+
+void DeviceClock::reset() {
+  KernelStamps initial = {~0ull, 0ull};
+  HIPCHECK(hipMemcpy(stamps_, &initial, sizeof(initial), hipMemcpyHostToDevice));
+}
+
+double DeviceClock::elapsed() const {
+  KernelStamps stamps;
+  HIPCHECK(hipMemcpy(&stamps, stamps_, sizeof(stamps), hipMemcpyDeviceToHost));
+  if (stamps.end < stamps.start) {
+    return -1.0;
+  }
+  return (stamps.end - stamps.start) / rateHz_;
+}
+
+#ifdef HIP_PERF_TELEMETRY
+namespace {
+
+// rocm_smi entry points resolved from librocm_smi64. The optional ones only
+// exist in newer releases and are null otherwise.
+struct SmiLibrary {
+  bool loaded;
+  rsmi_status_t (*numDevices)(uint32_t*);
+  rsmi_status_t (*pciId)(uint32_t, uint64_t*);
+  rsmi_status_t (*clockFrequency)(uint32_t, rsmi_clk_type_t, rsmi_frequencies_t*);
+  rsmi_status_t (*powerAverage)(uint32_t, uint32_t, uint64_t*);
+  rsmi_status_t (*socketPower)(uint32_t, uint64_t*);  // optional
+  rsmi_status_t (*temperature)(uint32_t, uint32_t, rsmi_temperature_metric_t, int64_t*);
+  rsmi_status_t (*throttleStatus)(uint32_t, uint32_t*);  // optional
+};
+
+template <typename T> bool resolve(void* handle, const char* symbol, T* function) {
+  *function = reinterpret_cast<T>(dlsym(handle, symbol));
+  return *function != nullptr;
+}
+
+SmiLibrary loadSmiLibrary() {
+  SmiLibrary smi;
+  memset(&smi, 0, sizeof(smi));
+
+  static const char* names[] = {"librocm_smi64.so", "librocm_smi64.so.7", "librocm_smi64.so.6",
+                                "librocm_smi64.so.5", "/opt/rocm/lib/librocm_smi64.so"};
+  void* handle = nullptr;
+  for (const char* name : names) {
+    if ((handle = dlopen(name, RTLD_NOW | RTLD_LOCAL)) != nullptr) {
+      break;
+    }
+  }
+  if (handle == nullptr) {
+    return smi;
+  }
+
+  rsmi_status_t (*init)(uint64_t) = nullptr;
+  if (!resolve(handle, "rsmi_init", &init) ||
+      !resolve(handle, "rsmi_num_monitor_devices", &smi.numDevices) ||
+      !resolve(handle, "rsmi_dev_pci_id_get", &smi.pciId) ||
+      !resolve(handle, "rsmi_dev_gpu_clk_freq_get", &smi.clockFrequency) ||
+      !resolve(handle, "rsmi_dev_power_ave_get", &smi.powerAverage) ||
+      !resolve(handle, "rsmi_dev_temp_metric_get", &smi.temperature) ||
+      init(0) != RSMI_STATUS_SUCCESS) {
+    return smi;
+  }
+  resolve(handle, "rsmi_dev_current_socket_power_get", &smi.socketPower);
+  resolve(handle, "rsmi_dev_metrics_throttle_status_get", &smi.throttleStatus);
+  smi.loaded = true;
+  return smi;
+}
+
+const SmiLibrary& smiLibrary() {
+  static SmiLibrary smi = loadSmiLibrary();
+  return smi;
+}
+
+// Current level of one clock domain in MHz, negative when not reported.
+double clockMHz(const SmiLibrary& smi, uint32_t index, rsmi_clk_type_t type) {
+  rsmi_frequencies_t freq;
+  memset(&freq, 0, sizeof(freq));
+  if (smi.clockFrequency(index, type, &freq) != RSMI_STATUS_SUCCESS ||
+      freq.current >= freq.num_supported || freq.current >= RSMI_MAX_NUM_FREQUENCIES) {
+    return -1;
+  }
+  return freq.frequency[freq.current] * 1e-6;
+}
+
+}  // namespace
+#endif
+
+bool TelemetrySampler::start(int deviceId, unsigned int periodMs) {
+  stop();
+#ifdef HIP_PERF_TELEMETRY
+  const SmiLibrary& smi = smiLibrary();
+  if (!smi.loaded) {
+    std::cerr << "info: rocm_smi not available, --telemetry disabled" << std::endl;
+    return false;
+  }
+
+  // rocm_smi enumerates devices independently of HIP, match them by PCI location
+  hipDeviceProp_t props;
+  HIPCHECK(hipGetDeviceProperties(&props, deviceId));
+  uint32_t count = 0;
+  bool found = false;
+  if (smi.numDevices(&count) == RSMI_STATUS_SUCCESS) {
+    for (uint32_t i = 0; i < count && !found; i++) {
+      uint64_t bdf = 0;
+      if (smi.pciId(i, &bdf) != RSMI_STATUS_SUCCESS) {
+        continue;
+      }
+      found = ((bdf >> 32) & 0xffff) == static_cast<uint64_t>(props.pciDomainID) &&
+              ((bdf >> 8) & 0xff) == static_cast<uint64_t>(props.pciBusID) &&
+              ((bdf >> 3) & 0x1f) == static_cast<uint64_t>(props.pciDeviceID);
+      if (found) {
+        smiIndex_ = i;
+      }
+    }
+  }
+  if (!found) {
+    std::cerr << "info: device " << deviceId << " not found by rocm_smi, --telemetry disabled"
+              << std::endl;
+    return false;
+  }
+
+  periodMs_ = std::max(periodMs, 1u);
+  samples_.clear();
+  running_ = true;
+  thread_ = std::thread(&TelemetrySampler::loop, this);
+  return true;
+#else
+  (void)deviceId;
+  (void)periodMs;
+  std::cerr << "info: --telemetry needs rocm_smi and is only supported on AMD under Linux"
+            << std::endl;
+  return false;
+#endif
+}
+
+void TelemetrySampler::stop() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  wake_.notify_all();
+  thread_.join();
+}
+
+void TelemetrySampler::mark() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  samples_.clear();
+}
+
+TelemetrySampler::Sample TelemetrySampler::poll() const {
+  Sample sample = {-1, -1, -1, -1, -1};
+#ifdef HIP_PERF_TELEMETRY
+  const SmiLibrary& smi = smiLibrary();
+  sample.sclk = clockMHz(smi, smiIndex_, RSMI_CLK_TYPE_SYS);
+  sample.mclk = clockMHz(smi, smiIndex_, RSMI_CLK_TYPE_MEM);
+
+  // Socket power covers the devices where the average power sensor is gone
+  uint64_t microWatts = 0;
+  if ((smi.socketPower != nullptr &&
+       smi.socketPower(smiIndex_, &microWatts) == RSMI_STATUS_SUCCESS && microWatts != 0) ||
+      smi.powerAverage(smiIndex_, 0, &microWatts) == RSMI_STATUS_SUCCESS) {
+    sample.power = microWatts * 1e-6;
+  }
+
+  int64_t milliCelsius = 0;
+  if (smi.temperature(smiIndex_, RSMI_TEMP_TYPE_JUNCTION, RSMI_TEMP_CURRENT, &milliCelsius) ==
+          RSMI_STATUS_SUCCESS ||
+      smi.temperature(smiIndex_, RSMI_TEMP_TYPE_EDGE, RSMI_TEMP_CURRENT, &milliCelsius) ==
+          RSMI_STATUS_SUCCESS) {
+    sample.temp = milliCelsius * 1e-3;
+  }
+
+  uint32_t throttle = 0;
+  if (smi.throttleStatus != nullptr &&
+      smi.throttleStatus(smiIndex_, &throttle) == RSMI_STATUS_SUCCESS) {
+    sample.throttle = throttle != 0 ? 1 : 0;
+  }
+#endif
+  return sample;
+}
+
+void TelemetrySampler::loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    // Query without the lock, rocm_smi reads sysfs and may take a while
+    lock.unlock();
+    Sample sample = poll();
+    lock.lock();
+    samples_.push_back(sample);
+    wake_.wait_for(lock, std::chrono::milliseconds(periodMs_), [this] { return !running_; });
+  }
+}
+
+TelemetrySummary TelemetrySampler::summary() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TelemetrySummary summary;
+  summary.samples = static_cast<unsigned int>(samples_.size());
+
+  // Mean and minimum (or maximum) of one field over the samples that report it
+  auto aggregate = [this](double Sample::*field, bool lowest, double* mean, double* extreme) {
+    unsigned int count = 0;
+    double sum = 0;
+    for (const Sample& sample : samples_) {
+      double value = sample.*field;
+      if (value < 0) {
+        continue;
+      }
+      if (count == 0 || (lowest ? value < *extreme : value > *extreme)) {
+        *extreme = value;
+      }
+      sum += value;
+      count++;
+    }
+    if (count != 0) {
+      *mean = sum / count;
+    }
+  };
+  aggregate(&Sample::sclk, true, &summary.sclkMean, &summary.sclkMin);
+  aggregate(&Sample::mclk, true, &summary.mclkMean, &summary.mclkMin);
+  aggregate(&Sample::power, false, &summary.powerMean, &summary.powerMax);
+  aggregate(&Sample::temp, false, &summary.tempMean, &summary.tempMax);
+
+  for (const Sample& sample : samples_) {
+    if (sample.throttle >= 0) {
+      summary.throttled = std::max(summary.throttled, 0) + sample.throttle;
+    }
+  }
+  return summary;
+}
+
+namespace {
+
+struct TimelineSpan {
+  std::string name;
+  int device;
+  unsigned int track;  // stream index in order of first use on the device
+  double submitUs;     // host time of begin()
+  hipEvent_t start;
+  hipEvent_t stop;
+};
+
+struct TimelineDevice {
+  hipEvent_t reference;  // recorded and synchronized on the null stream at referenceUs
+  double referenceUs;
+  std::vector<hipStream_t> streams;
+};
+
+struct TimelineState {
+  std::mutex mutex;
+  std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+  std::map<int, TimelineDevice> devices;
+  std::vector<TimelineSpan> spans;
+  std::map<hipStream_t, size_t> open;  // index into spans of the span begun on the stream
+};
+
+TimelineState& timeline() {
+  static TimelineState state;
+  return state;
+}
+
+double timelineUs(const TimelineState& state) {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                   state.origin)
+      .count();
+}
+
+}  // namespace
+
+void Timeline::begin(hipStream_t stream, const std::string& name) {
+  if (!enabled()) {
+    return;
+  }
+  TimelineState& state = timeline();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  int device = 0;
+  HIPCHECK(hipGetDevice(&device));
+
+  auto it = state.devices.find(device);
+  if (it == state.devices.end()) {
+    // Device times are placed on the host clock relative to this event
+    TimelineDevice info;
+    HIPCHECK(hipEventCreate(&info.reference));
+    HIPCHECK(hipEventRecord(info.reference, nullptr));
+    HIPCHECK(hipEventSynchronize(info.reference));
+    info.referenceUs = timelineUs(state);
+    it = state.devices.insert(std::make_pair(device, info)).first;
+  }
+  std::vector<hipStream_t>& streams = it->second.streams;
+  size_t track = std::find(streams.begin(), streams.end(), stream) - streams.begin();
+  if (track == streams.size()) {
+    streams.push_back(stream);
+  }
+
+  TimelineSpan span;
+  span.name = name;
+  span.device = device;
+  span.track = static_cast<unsigned int>(track);
+  span.stop = nullptr;
+  HIPCHECK(hipEventCreate(&span.start));
+  span.submitUs = timelineUs(state);
+  HIPCHECK(hipEventRecord(span.start, stream));
+  state.open[stream] = state.spans.size();
+  state.spans.push_back(span);
+}
+
+void Timeline::end(hipStream_t stream) {
+  if (!enabled()) {
+    return;
+  }
+  TimelineState& state = timeline();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  auto it = state.open.find(stream);
+  if (it == state.open.end()) {
+    failed("Timeline::end() without Timeline::begin() on stream %p\n", stream);
+  }
+  TimelineSpan& span = state.spans[it->second];
+  HIPCHECK(hipEventCreate(&span.stop));
+  HIPCHECK(hipEventRecord(span.stop, stream));
+  state.open.erase(it);
+}
+
+void Timeline::write() {
+  if (!enabled()) {
+    return;
+  }
+  TimelineState& state = timeline();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  std::ofstream out(p_timeline, std::ios::out | std::ios::trunc);
+  if (!out.is_open()) {
+    failed("Unable to open timeline file %s\n", p_timeline);
+  }
+  out.setf(std::ios::fixed);
+  out.precision(3);
+
+  // Host submissions on pid 0, every device is its own process with a track per stream
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+      << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"host\"}}";
+  for (const auto& device : state.devices) {
+    int pid = device.first + 1;
+    out << ",\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+        << ",\"args\":{\"name\":\"device " << device.first << "\"}}";
+    for (size_t track = 0; track < device.second.streams.size(); track++) {
+      out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << track
+          << ",\"args\":{\"name\":\"stream " << track << "\"}}";
+    }
+  }
+
+  for (const TimelineSpan& span : state.spans) {
+    const TimelineDevice& device = state.devices[span.device];
+    std::string name = jsonEscape(span.name);
+    out << ",\n{\"name\":\"" << name << "\",\"cat\":\"submit\",\"ph\":\"i\",\"s\":\"t\","
+        << "\"pid\":0,\"tid\":0,\"ts\":" << span.submitUs << ",\"args\":{\"device\":"
+        << span.device << ",\"stream\":" << span.track << "}}";
+    if (span.stop == nullptr) {
+      continue;
+    }
+    HIPCHECK(hipSetDevice(span.device));
+    HIPCHECK(hipEventSynchronize(span.stop));
+    float startMs = 0, stopMs = 0;
+    HIPCHECK(hipEventElapsedTime(&startMs, device.reference, span.start));
+    HIPCHECK(hipEventElapsedTime(&stopMs, device.reference, span.stop));
+    out << ",\n{\"name\":\"" << name << "\",\"cat\":\"device\",\"ph\":\"X\",\"pid\":"
+        << span.device + 1 << ",\"tid\":" << span.track
+        << ",\"ts\":" << device.referenceUs + startMs * 1e3
+        << ",\"dur\":" << (stopMs - startMs) * 1e3 << ",\"args\":{\"queued_us\":"
+        << device.referenceUs + startMs * 1e3 - span.submitUs << "}}";
+  }
+  out << "\n]}\n";
+
+  for (const TimelineSpan& span : state.spans) {
+    HIPCHECK(hipEventDestroy(span.start));
+    if (span.stop != nullptr) {
+      HIPCHECK(hipEventDestroy(span.stop));
+    }
+  }
+  for (const auto& device : state.devices) {
+    HIPCHECK(hipEventDestroy(device.second.reference));
+  }
+  state.spans.clear();
+  state.devices.clear();
+  state.open.clear();
+}
+
+namespace {
+
+struct CounterPlugin {
+  bool usable;
+  int device;  // device the plugin was initialized for, -1 before the first collection
+  std::string counters;
+  hipPerfCountersInitFn init;
+  hipPerfCountersStartFn start;
+  hipPerfCountersStopFn stop;
+  hipPerfCountersShutdownFn shutdown;
+};
+
+CounterPlugin& counterPlugin() {
+  static CounterPlugin plugin = [] {
+    CounterPlugin loaded = {false, -1, "", nullptr, nullptr, nullptr, nullptr};
+    std::string arg = p_counters;
+    size_t colon = arg.find(':');
+    std::string library = arg.substr(0, colon);
+    if (colon != std::string::npos) {
+      loaded.counters = arg.substr(colon + 1);
+    }
+#ifdef __linux__
+    void* handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+      std::cerr << "info: unable to load counter plugin " << library << ": " << dlerror()
+                << std::endl;
+      return loaded;
+    }
+    loaded.init = reinterpret_cast<hipPerfCountersInitFn>(dlsym(handle, "hipPerfCountersInit"));
+    loaded.start = reinterpret_cast<hipPerfCountersStartFn>(dlsym(handle, "hipPerfCountersStart"));
+    loaded.stop = reinterpret_cast<hipPerfCountersStopFn>(dlsym(handle, "hipPerfCountersStop"));
+    loaded.shutdown =
+        reinterpret_cast<hipPerfCountersShutdownFn>(dlsym(handle, "hipPerfCountersShutdown"));
+    loaded.usable = loaded.init != nullptr && loaded.start != nullptr && loaded.stop != nullptr &&
+                    loaded.shutdown != nullptr;
+    if (!loaded.usable) {
+      std::cerr << "info: " << library << " does not export the perf_counters.h interface"
+                << std::endl;
+    }
+#else
+    std::cerr << "info: --counters is only supported on Linux" << std::endl;
+#endif
+    return loaded;
+  }();
+  return plugin;
+}
+
+std::vector<std::pair<std::string, double>>& pendingCounters() {
+  static std::vector<std::pair<std::string, double>> counters;
+  return counters;
+}
+
+bool& counterPassRunning() {
+  static bool running = false;
+  return running;
+}
+
+void shutdownCounterPlugin() {
+  CounterPlugin& plugin = counterPlugin();
+  if (plugin.device >= 0) {
+    plugin.shutdown();
+  }
+}
+
+}  // namespace
+
+void Counters::collect(const std::function<void()>& op) {
+  if (!enabled()) {
+    return;
+  }
+  pendingCounters().clear();
+  CounterPlugin& plugin = counterPlugin();
+  if (!plugin.usable) {
+    return;
+  }
+
+  int device = 0;
+  HIPCHECK(hipGetDevice(&device));
+  if (plugin.device != device) {
+    if (plugin.device >= 0) {
+      plugin.shutdown();
+    } else {
+      std::atexit(shutdownCounterPlugin);
+    }
+    plugin.device = device;
+    if (plugin.init(device, plugin.counters.c_str()) != 0) {
+      std::cerr << "info: counter plugin failed to initialize on device " << device
+                << ", --counters disabled" << std::endl;
+      plugin.usable = false;
+      return;
+    }
+  }
+
+  const int maxCounters = 256;
+  const char* names[maxCounters] = {};
+  double values[maxCounters] = {};
+  if (plugin.start() != 0) {
+    std::cerr << "info: counter plugin failed to start" << std::endl;
+    return;
+  }
+  counterPassRunning() = true;
+  op();
+  counterPassRunning() = false;
+  int count = plugin.stop(names, values, maxCounters);
+  for (int i = 0; i < std::min(count, maxCounters); i++) {
+    pendingCounters().push_back(std::make_pair(std::string(names[i] ? names[i] : ""), values[i]));
+  }
+}
+
+bool Counters::collecting() { return counterPassRunning(); }
+
+void Counters::clear() { pendingCounters().clear(); }
+
+void writeResult(const char* benchmark, unsigned int test, const std::string& desc, size_t bytes,
+                 unsigned int iterations, const char* unit, double value) {
+  Result result;
+  result.benchmark = benchmark;
+  result.test = test;
+  result.desc = desc;
+  result.device = p_gpuDevice;
+  result.bytes = bytes;
+  result.iterations = iterations;
+  result.unit = unit;
+  result.values.push_back(value);
+  result.counters = pendingCounters();
+  writeResult(result);
+}
+
+Benchmark::Benchmark(const char* name) : deviceId_(0), name_(name), test_(0) {
+  memset(&props_, 0, sizeof(props_));
+}
+
+void Benchmark::open(int deviceId) {
+  int nGpu = 0;
+  HIPCHECK(hipGetDeviceCount(&nGpu));
+  if (nGpu < 1) {
+    failed("No GPU!");
+  } else if (deviceId >= nGpu) {
+    failed("Info: wrong GPU Id %d\n", deviceId);
+  }
+
+  deviceId_ = deviceId;
+  HIPCHECK(hipSetDevice(deviceId));
+  HIPCHECK(hipGetDeviceProperties(&props_, deviceId));
+  if (timerBackend() == timerKernel) {
+    clock_.open(deviceId);
+  }
+  if (p_telemetry != 0) {
+    telemetry_.start(deviceId, p_telemetry);
+  }
+  if (strcmp(p_format, "text") && p_output == nullptr) {
+    // Keep stdout parseable, every json/csv record carries the device already
+    return;
+  }
+  std::cout << "info: running on bus " << "0x" << props_.pciBusID << " " << props_.name
+            << " with " << props_.multiProcessorCount << " CUs" << " and device id: " << deviceId
+            << std::endl;
+}
+
+namespace {
+
+// Sample cap of an adaptive measurement, whatever the time budget
+const size_t maxAdaptiveSamples = 100000;
+
+// Decides when a measurement has taken enough samples: after 'minimum' of them
+// without --target-ci, otherwise once the median's confidence interval is
+// narrow enough, the --max-time budget is spent or the sample cap is reached.
+class SampleBudget {
+ public:
+  explicit SampleBudget(size_t minimum)
+      : minimum_(minimum), nextCheck_(minimum), start_(std::chrono::steady_clock::now()) {}
+
+  bool more(const std::vector<double>& samples) {
+    size_t n = samples.size();
+    if (n < minimum_) {
+      return true;
+    }
+    if (p_targetCi <= 0 || n >= maxAdaptiveSamples) {
+      return false;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_;
+    if (elapsed.count() >= p_maxTime) {
+      return false;
+    }
+    if (n < nextCheck_) {
+      return true;
+    }
+    // The statistics sort all samples, so they are only recomputed every 10% more
+    nextCheck_ = n + std::max<size_t>(1, n / 10);
+    double ci = ComputePerfStats(samples).medianCi;
+    return ci < 0 || ci * 100 > p_targetCi;
+  }
+
+ private:
+  size_t minimum_;
+  size_t nextCheck_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace
+
+std::vector<double> Benchmark::measure(const std::function<void()>& op) {
+  return measure(op, p_warmup);
+}
+
+std::vector<double> Benchmark::measure(const std::function<void()>& op, unsigned int warmup) {
+  telemetry_.mark();
+  for (unsigned int i = 0; i < warmup; i++) {
+    op();
+  }
+
+  CPerfSampler sampler;
+  SampleBudget budget(p_repetitions);
+  while (budget.more(sampler.GetSamples())) {
+    sampler.Start();
+    op();
+    sampler.Stop();
+  }
+  Counters::collect(op);
+  if (p_rejectOutliers != 0) {
+    sampler.RejectOutliers(p_rejectOutliers);
+  }
+  return sampler.GetSamples();
+}
+
+std::vector<double> Benchmark::measureEach(const std::function<void()>& op, unsigned int count) {
+  telemetry_.mark();
+  for (unsigned int i = 0; i < p_warmup; i++) {
+    op();
+  }
+
+  // With --target-ci the count is no floor, the interval or the time budget decides
+  CPerfSampler sampler;
+  SampleBudget budget(p_targetCi > 0 ? p_repetitions : static_cast<size_t>(count) * p_repetitions);
+  while (budget.more(sampler.GetSamples())) {
+    sampler.Start();
+    op();
+    sampler.Stop();
+  }
+  Counters::collect(op);
+  if (p_rejectOutliers != 0) {
+    sampler.RejectOutliers(p_rejectOutliers);
+  }
+  return sampler.GetSamples();
+}
+
+SplitTiming Benchmark::measureSplit(const std::function<void()>& enqueue, hipStream_t stream) {
+  return measureSplit(enqueue, stream, p_warmup);
+}
+
+SplitTiming Benchmark::measureSplit(const std::function<void()>& enqueue, hipStream_t stream,
+                                    unsigned int warmup) {
+  telemetry_.mark();
+  for (unsigned int i = 0; i < warmup; i++) {
+    enqueue();
+    HIPCHECK(hipStreamSynchronize(stream));
+  }
+
+  TimerBackend backend = timerBackend();
+  hipEvent_t start, stop;
+  HIPCHECK(hipEventCreate(&start));
+  HIPCHECK(hipEventCreate(&stop));
+
+  CPerfSampler submit, device;
+  CPerfCounter timer;
+  SampleBudget budget(p_repetitions);
+  while (budget.more(device.GetSamples())) {
+    if (backend == timerKernel) {
+      clock_.reset();
+    }
+    HIPCHECK(hipEventRecord(start, stream));
+
+    Timeline::begin(stream, std::string(name_) + "[" + std::to_string(test_) + "]");
+    timer.Reset();
+    timer.Start();
+    enqueue();
+    timer.Stop();
+    Timeline::end(stream);
+    submit.AddSample(timer.GetElapsedTime());
+
+    // Keep counting on the host until the stream is idle for --timer host
+    timer.Start();
+    HIPCHECK(hipEventRecord(stop, stream));
+    HIPCHECK(hipStreamSynchronize(stream));
+    timer.Stop();
+
+    float ms = 0;
+    HIPCHECK(hipEventElapsedTime(&ms, start, stop));
+    double kernelSec = (backend == timerKernel) ? clock_.elapsed() : -1.0;
+    if (backend == timerHost) {
+      device.AddSample(timer.GetElapsedTime());
+    } else if (kernelSec >= 0) {
+      device.AddSample(kernelSec);
+    } else {
+      device.AddSample(ms * 1e-3);
+    }
+  }
+
+  HIPCHECK(hipEventDestroy(start));
+  HIPCHECK(hipEventDestroy(stop));
+
+  Counters::collect([&]() {
+    enqueue();
+    HIPCHECK(hipStreamSynchronize(stream));
+  });
+  if (p_rejectOutliers != 0) {
+    submit.RejectOutliers(p_rejectOutliers);
+    device.RejectOutliers(p_rejectOutliers);
+  }
+  SplitTiming timing;
+  timing.submit = submit.GetSamples();
+  timing.device = device.GetSamples();
+  return timing;
+}
+
+KernelStamps* Benchmark::kernelStamps() const {
+  return timerBackend() == timerKernel ? clock_.stamps() : nullptr;
+}
+
+void Benchmark::report(unsigned int test, const std::string& desc, size_t bytes,
+                       unsigned int iterations, const char* unit,
+                       const std::vector<double>& values, Better better) {
+  report(deviceId_, test, desc, bytes, iterations, unit, values, better);
+}
+
+void Benchmark::report(int device, unsigned int test, const std::string& desc, size_t bytes,
+                       unsigned int iterations, const char* unit,
+                       const std::vector<double>& values, Better better) {
+  Result result;
+  result.benchmark = name_;
+  result.test = test;
+  result.desc = desc;
+  result.device = device;
+  result.bytes = bytes;
+  result.iterations = iterations;
+  result.unit = unit;
+  result.values = values;
+  result.better = better;
+  if (device == deviceId_) {
+    result.telemetry = telemetry_.summary();
+    result.counters = pendingCounters();
+  }
+  writeResult(result);
+}
+
+std::vector<double> toBandwidth(const std::vector<double>& seconds, double bytes) {
+  std::vector<double> gbps;
+  for (double sec : seconds) {
+    gbps.push_back(bytes * 1e-09 / sec);
+  }
+  return gbps;
+}
+
+std::vector<double> toMicroseconds(const std::vector<double>& seconds, double ops) {
+  std::vector<double> us;
+  for (double sec : seconds) {
+    us.push_back(sec * 1e6 / ops);
+  }
+  return us;
+}
+
+std::vector<double> measuredSamples(const std::vector<double>& samples) {
+  CPerfSampler sampler;
+  for (size_t i = p_warmup; i < samples.size(); i++) {
+    sampler.AddSample(samples[i]);
+  }
+  if (p_rejectOutliers != 0) {
+    sampler.RejectOutliers(p_rejectOutliers);
+  }
+  return sampler.GetSamples();
+}
+
+std::vector<size_t> sweepSizes(const std::vector<size_t>& defaults) {
+  return p_sizes.empty() ? defaults : p_sizes;
+}
+
+unsigned int iterationCount(unsigned int defaultCount) {
+  return iterations > 0 ? iterations : defaultCount;
+}
+
+#ifdef __linux__
+namespace {
+
+// First line of a sysfs attribute, empty when it does not exist.
+std::string readSysfs(const std::string& path) {
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+// Parses the kernel's cpu/node list format, e.g. "0-7,16-23".
+bool parseCpuList(const std::string& list, std::vector<int>* cpus) {
+  std::istringstream is(list);
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    int first = 0, last = 0;
+    int fields = sscanf(range.c_str(), "%d-%d", &first, &last);
+    if (fields < 1 || first < 0) {
+      return false;
+    }
+    if (fields == 1) {
+      last = first;
+    }
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus->push_back(cpu);
+    }
+  }
+  return !cpus->empty();
+}
+
+// NUMA nodes owning any of cpus.
+std::vector<int> nodesOfCpus(const std::vector<int>& cpus) {
+  std::vector<int> nodes;
+  for (int node = 0; node < 1024; node++) {
+    std::vector<int> nodeCpus;
+    if (!parseCpuList(readSysfs("/sys/devices/system/node/node" + std::to_string(node) +
+                                "/cpulist"),
+                      &nodeCpus)) {
+      continue;
+    }
+    for (int cpu : cpus) {
+      if (std::find(nodeCpus.begin(), nodeCpus.end(), cpu) != nodeCpus.end()) {
+        nodes.push_back(node);
+        break;
+      }
+    }
+  }
+  return nodes;
+}
+
+}  // namespace
+#endif
+
+bool pinHost(int deviceId) {
+  if (p_affinity == nullptr) {
+    return false;
+  }
+#ifdef __linux__
+  std::string cpuList = p_affinity;
+  std::vector<int> nodes;
+  if (cpuList == "gpu") {
+    char busId[64];
+    HIPCHECK(hipDeviceGetPCIBusId(busId, sizeof(busId), deviceId));
+    // sysfs uses "dddd:bb:dd.f" in lower case, some runtimes print a wider domain
+    std::string pci = busId;
+    std::transform(pci.begin(), pci.end(), pci.begin(), ::tolower);
+    if (pci.size() > 12) {
+      pci = pci.substr(pci.size() - 12);
+    }
+    std::string sysfs = "/sys/bus/pci/devices/" + pci;
+    cpuList = readSysfs(sysfs + "/local_cpulist");
+    std::string node = readSysfs(sysfs + "/numa_node");
+    if (!node.empty() && atoi(node.c_str()) >= 0) {
+      nodes.push_back(atoi(node.c_str()));
+    }
+  }
+
+  std::vector<int> cpus;
+  if (!parseCpuList(cpuList, &cpus)) {
+    std::cerr << "info: no cpus found for --affinity " << p_affinity << " on device "
+              << deviceId << ", running unpinned" << std::endl;
+    return false;
+  }
+  if (nodes.empty()) {
+    nodes = nodesOfCpus(cpus);
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    failed("sched_setaffinity(%s) for --affinity failed with errno %d\n", cpuList.c_str(),
+           errno);
+  }
+
+  // Called directly so the perftests need not link libnuma
+  std::string nodeList;
+  unsigned long nodeMask[1024 / (8 * sizeof(unsigned long))] = {};
+  for (int node : nodes) {
+    if (node < 1024) {
+      nodeMask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+      nodeList += (nodeList.empty() ? "" : ",") + std::to_string(node);
+    }
+  }
+  if (!nodeList.empty() &&
+      syscall(SYS_set_mempolicy, MPOL_BIND, nodeMask, sizeof(nodeMask) * 8) != 0) {
+    std::cerr << "info: set_mempolicy failed with errno " << errno
+              << ", host memory is not bound" << std::endl;
+    nodeList.clear();
+  }
+
+  std::cerr << "info: pinned to cpus " << cpuList << " and NUMA node "
+            << (nodeList.empty() ? "any" : nodeList) << " for device " << deviceId << std::endl;
+  return true;
+#else
+  std::cerr << "info: --affinity is only supported on Linux" << std::endl;
+  return false;
+#endif
+}
+
+int runBenchmarks(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
+  pinHost(p_gpuDevice);
+
+  for (BenchmarkFactory factory : registry()) {
+    Benchmark* benchmark = factory();
+    benchmark->open(p_gpuDevice);
+
+    unsigned int numTests = benchmark->numTests();
+    unsigned int first = 0;
+    unsigned int last = numTests;
+    if (p_tests >= 0) {
+      // With several benchmarks in one binary the index may only exist in some of them
+      first = std::min(static_cast<unsigned int>(p_tests), numTests);
+      last = std::min(first + 1, numTests);
+    }
+
+    for (unsigned int test = first; test < last; test++) {
+      benchmark->telemetry_.mark();
+      benchmark->test_ = test;
+      Counters::clear();
+      benchmark->run(test);
+    }
+
+    benchmark->close();
+    benchmark->telemetry_.stop();
+    delete benchmark;
+  }
+  Timeline::write();
+
+  return 0;
+}
+
+}  // namespace HipPerf
@@ -0,0 +1,339 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/*
+ * Shared harness for the perftests.
+ *
+ * A perftest derives from HipPerf::Benchmark, implements numTests() and run(),
+ * and registers itself with HIP_PERF_BENCHMARK(). perf_main.cpp provides main():
+ * it parses the standard arguments, opens every registered benchmark on
+ * p_gpuDevice, runs all test indices (or only -t <n>) and routes every result
+ * through Benchmark::report().
+ *
+ * Inside run(), measure() executes the timed operation --warmup times untimed
+ * and then --repetitions times under CPerfSampler, returning one elapsed time
+ * per repetition. measureEach() times every single operation instead, for
+ * latency tests where the tail matters more than the mean. With
+ * --reject-outliers <k> samples further than k * MAD from the median are
+ * dropped before reporting.
+ *
+ * --target-ci <percent> makes the three measure*() calls adaptive: after
+ * --repetitions samples (measureEach() drops its count, so stable latencies
+ * stop early) they keep sampling until the 95% confidence interval of the
+ * median (from order statistics, no distribution assumed) is within <percent>
+ * of the median, or until the --max-time <ms> budget of the measurement
+ * (default 5000) is spent. Benchmarks that time their own loops keep their
+ * fixed counts. Every record carries the relative interval of its samples as
+ * median_ci once there are 6 or more.
+ *
+ * Benchmarks with a size table take it through sweepSizes() and their loop
+ * count through iterationCount(), so --sizes, --sweep and --iterations can
+ * replace them from the command line.
+ *
+ * measureSplit() separates the host cost of enqueueing work from its device
+ * execution time. --timer selects where the device time comes from: host
+ * (wall time until the stream is idle), event (hipEventElapsedTime) or kernel
+ * (wall_clock64() stamps written by kernels that pass kernelStamps() to
+ * stampKernelBegin/stampKernelEnd; falls back to events when nothing stamped).
+ *
+ * Results are written in the --format given on the command line (text, json
+ * or csv) to --output <file>, or to stdout. json emits one object per line.
+ * Every record carries min/median/p90/p99/max/mean/stddev of the samples.
+ * Perftests that keep their own main() can call writeResult() directly after
+ * HipTest::parseStandardArguments().
+ *
+ * --telemetry <ms> polls SCLK/MCLK, power, temperature and throttle status of
+ * the opened device from a background thread every <ms> milliseconds and
+ * attaches their summary to each result, covering the samples taken since the
+ * last measure*() call (or since the start of the test for benchmarks that
+ * time their own loops). The values come from rocm_smi, loaded at runtime, so
+ * this is only available on AMD under Linux.
+ *
+ * --affinity pins the host side before any benchmark runs: "gpu" binds the
+ * process to the cores and NUMA node local to the selected GPU (from its PCI
+ * bus ID in sysfs), a cpu list like 0-7,16 binds it to those cores and the
+ * nodes they belong to. Threads started later and host buffers they allocate
+ * inherit the binding. Linux only.
+ *
+ * --timeline <file> records the host submit time and the device begin/end of
+ * operations as a Chrome trace / Perfetto JSON timeline with one track per
+ * stream, so overlap between streams and gaps between submission and
+ * execution become visible. Every measureSplit() repetition is recorded as one
+ * span; benchmarks wrap their own launches in Timeline::begin()/end(). Device
+ * times come from events recorded around each span, which adds a little
+ * enqueue overhead while recording.
+ *
+ * --counters <plugin.so>[:<counter list>] collects hardware counters through
+ * the plugin interface of perf_counters.h. measure*() run the operation once
+ * more between the plugin's start and stop after the timed repetitions;
+ * benchmarks with their own loops call Counters::collect() the same way. The
+ * values are attached to every result reported until the next measurement.
+ * Benchmarks that record their own samples inside a measured operation skip
+ * that run through Counters::collecting() and pass the lists to
+ * measuredSamples(), which also applies --reject-outliers to them.
+ *
+ * --input <file> hands a data file to benchmarks that take one (hipPerfSpMV:
+ * a Matrix Market matrix, hipPerfApiReplay: a HIP_API_RECORD recording); they
+ * fall back to built-in inputs without it.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "test_common.h"
+#include "timer.h"
+
+namespace HipPerf {
+
+// Device telemetry over the window of one result. Negative values were not
+// reported by the device.
+struct TelemetrySummary {
+  unsigned int samples = 0;  // 0 when --telemetry is off or not supported
+  double sclkMean = -1, sclkMin = -1;    // MHz
+  double mclkMean = -1, mclkMin = -1;    // MHz
+  double powerMean = -1, powerMax = -1;  // W
+  double tempMean = -1, tempMax = -1;    // C, junction or else edge sensor
+  int throttled = -1;                    // samples with any throttle reason set
+};
+
+// Which way a result improves, written to json as "better" unless betterByUnit.
+// The comparison tools take ratios ("x") and shares ("%") as better when
+// higher; results where those fall as things get faster say betterLower.
+enum Better { betterByUnit = 0, betterHigher, betterLower };
+
+// One reported measurement as handed to the output sink.
+struct Result {
+  std::string benchmark;
+  unsigned int test;
+  std::string desc;
+  int device;
+  size_t bytes;              // bytes per iteration, 0 when not meaningful
+  unsigned int iterations;
+  std::string unit;
+  std::vector<double> values;  // per-repetition samples in 'unit'
+  Better better = betterByUnit;
+  TelemetrySummary telemetry;
+  std::vector<std::pair<std::string, double>> counters;  // --counters values, name order kept
+};
+
+// Writes result in the selected --format to --output, or stdout.
+void writeResult(const Result& result);
+// Shorthand for a single sample measured on p_gpuDevice.
+void writeResult(const char* benchmark, unsigned int test, const std::string& desc, size_t bytes,
+                 unsigned int iterations, const char* unit, double value);
+
+enum TimerBackend { timerHost, timerEvent, timerKernel };
+
+// Backend selected with --timer.
+TimerBackend timerBackend();
+const char* timerBackendName();
+
+// Per-repetition seconds of one measureSplit() call.
+struct SplitTiming {
+  std::vector<double> submit;  // host time spent enqueueing
+  std::vector<double> device;  // execution time from the selected backend
+};
+
+// Earliest kernel start and latest kernel end in wall_clock64() ticks.
+struct KernelStamps {
+  unsigned long long start;
+  unsigned long long end;
+};
+
+// Both are no-ops for a null pointer, so kernels can take the stamps
+// unconditionally. stampKernelEnd() uses __syncthreads() and must be reached
+// by every thread of the block.
+__device__ inline void stampKernelBegin(KernelStamps* stamps) {
+  if (stamps != nullptr && threadIdx.x == 0) {
+    atomicMin(&stamps->start, static_cast<unsigned long long>(wall_clock64()));
+  }
+}
+
+__device__ inline void stampKernelEnd(KernelStamps* stamps) {
+  if (stamps != nullptr) {
+    __syncthreads();
+    if (threadIdx.x == 0) {
+      atomicMax(&stamps->end, static_cast<unsigned long long>(wall_clock64()));
+    }
+  }
+}
+
+// Device buffer for KernelStamps and conversion of ticks to seconds.
+class DeviceClock {
+ public:
+  DeviceClock() : stamps_(nullptr), rateHz_(0) {}
+  ~DeviceClock();
+
+  void open(int deviceId);
+  // Must be called while no stamping kernel is in flight.
+  void reset();
+  KernelStamps* stamps() const { return stamps_; }
+  // Seconds between earliest start and latest end, negative when no kernel stamped.
+  double elapsed() const;
+
+ private:
+  KernelStamps* stamps_;
+  double rateHz_;
+};
+
+// Background thread for --telemetry, see above.
+class TelemetrySampler {
+ public:
+  TelemetrySampler() : running_(false), smiIndex_(0), periodMs_(0) {}
+  ~TelemetrySampler() { stop(); }
+
+  // Starts polling deviceId, prints an info: line and returns false when the
+  // device cannot be sampled.
+  bool start(int deviceId, unsigned int periodMs);
+  void stop();
+  // Drops the samples collected so far, starting a new window.
+  void mark();
+  TelemetrySummary summary();
+
+ private:
+  struct Sample {
+    double sclk, mclk, power, temp;  // negative when not reported
+    int throttle;                    // -1 when not reported
+  };
+
+  Sample poll() const;
+  void loop();
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::atomic<bool> running_;
+  std::vector<Sample> samples_;
+  unsigned int smiIndex_;
+  unsigned int periodMs_;
+};
+
+class Benchmark {
+ public:
+  explicit Benchmark(const char* name);
+  virtual ~Benchmark() {}
+
+  const char* name() const { return name_; }
+
+  // Selects the device and caches its properties. Overrides must call the base.
+  virtual void open(int deviceId);
+  // Number of test indices accepted by run().
+  virtual unsigned int numTests() = 0;
+  virtual void run(unsigned int test) = 0;
+  virtual void close() {}
+
+ protected:
+  // Runs op untimed p_warmup times (or 'warmup' times), then p_repetitions
+  // timed times, or more with --target-ci. op must synchronize before
+  // returning. Returns seconds per run.
+  std::vector<double> measure(const std::function<void()>& op);
+  std::vector<double> measure(const std::function<void()>& op, unsigned int warmup);
+  // Runs op p_warmup times untimed, then times each of 'count' * p_repetitions
+  // individual runs, or as many as --target-ci needs. Returns seconds per run.
+  std::vector<double> measureEach(const std::function<void()>& op, unsigned int count);
+  // enqueue must only enqueue work on stream, the harness synchronizes it.
+  // Warm-up and repetitions as for measure().
+  SplitTiming measureSplit(const std::function<void()>& enqueue, hipStream_t stream);
+  SplitTiming measureSplit(const std::function<void()>& enqueue, hipStream_t stream,
+                           unsigned int warmup);
+  // Stamps buffer for kernels with --timer kernel, nullptr otherwise.
+  KernelStamps* kernelStamps() const;
+
+  // Reports one result; values are per-repetition samples already in 'unit'.
+  void report(unsigned int test, const std::string& desc, size_t bytes,
+              unsigned int iterations, const char* unit, const std::vector<double>& values,
+              Better better = betterByUnit);
+  // Same for benchmarks that measure on devices other than the opened one.
+  void report(int device, unsigned int test, const std::string& desc, size_t bytes,
+              unsigned int iterations, const char* unit, const std::vector<double>& values,
+              Better better = betterByUnit);
+
+  int deviceId_;
+  hipDeviceProp_t props_;
+
+ private:
+  friend int runBenchmarks(int argc, char* argv[]);
+
+  const char* name_;
+  unsigned int test_;  // test index being run, names measureSplit() spans
+  DeviceClock clock_;
+  TelemetrySampler telemetry_;
+};
+
+// Converts per-repetition seconds into GB/s, given the bytes moved per repetition.
+std::vector<double> toBandwidth(const std::vector<double>& seconds, double bytes);
+// Converts per-repetition seconds into microseconds per operation.
+std::vector<double> toMicroseconds(const std::vector<double>& seconds, double ops);
+
+// Samples a benchmark recorded itself inside measure(): drops the p_warmup
+// leading ones of the untimed runs and applies --reject-outliers.
+std::vector<double> measuredSamples(const std::vector<double>& samples);
+
+// Sizes from --sizes/--sweep, or 'defaults' when neither was given.
+std::vector<size_t> sweepSizes(const std::vector<size_t>& defaults);
+// --iterations when given, otherwise 'defaultCount'.
+unsigned int iterationCount(unsigned int defaultCount);
+
+// Device timeline for --timeline, see above. All calls are no-ops when it is off.
+class Timeline {
+ public:
+  static bool enabled() { return p_timeline != nullptr; }
+  // Takes the host submit time and records a start event on stream, call it
+  // right before enqueueing the work of the span
+  static void begin(hipStream_t stream, const std::string& name);
+  // Records the stop event of the open span on stream, after enqueueing
+  static void end(hipStream_t stream);
+  // Waits for all recorded spans and writes the timeline file
+  static void write();
+};
+
+// Hardware counters for --counters, see above.
+class Counters {
+ public:
+  static bool enabled() { return p_counters != nullptr; }
+  // Runs op once, untimed, while the plugin counts on the current device. op
+  // must synchronize before returning. No-op when --counters is off.
+  static void collect(const std::function<void()>& op);
+  // True while collect() runs op, which must not record samples of its own then.
+  static bool collecting();
+  // Drops counters collected for an earlier measurement.
+  static void clear();
+};
+
+// Applies --affinity to the calling thread for deviceId. Returns false when
+// --affinity is not set or the binding could not be determined.
+bool pinHost(int deviceId);
+
+typedef Benchmark* (*BenchmarkFactory)();
+bool registerBenchmark(BenchmarkFactory factory);
+int runBenchmarks(int argc, char* argv[]);
+
+}  // namespace HipPerf
+
+#define HIP_PERF_BENCHMARK(CLASS)                                                                  \
+  static HipPerf::Benchmark* CLASS##Factory() { return new CLASS(); }                              \
+  static const bool CLASS##Registered = HipPerf::registerBenchmark(CLASS##Factory);
@@ -0,0 +1,192 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD_CMD: hipPerfCUMaskPartition %hc -I%S/../../src %S/%s %S/../../src/test_common.cpp %S/../../src/timer.cpp %S/../../src/perf_harness.cpp %S/../../src/perf_main.cpp -o %T/%t EXCLUDE_HIP_PLATFORM nvidia
+ * TEST: %t
+ * HIT_END
+ */
+
+// Carves the CUs into K disjoint slices with hipExtStreamCreateWithCUMask and
+// runs the mandelbrot kernel of mandelbrot_kernels.h on one stream per
+// slice, against K streams without a mask.
+//
+// For every K and masking the victim stream (slice 0) first runs alone, then
+// all K streams run at once. The busy run reports kernels/s per stream and in
+// total, and how much slower the victim got than when it ran alone.
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+#include "mandelbrot_kernels.h"
+
+static const unsigned int partitionCounts[] = {2, 4};
+static const unsigned int numPartitionCounts =
+    sizeof(partitionCounts) / sizeof(partitionCounts[0]);
+
+enum MaskMode { maskNone = 0, maskDisjoint, numMaskModes };
+enum Scenario { victimAlone = 0, allBusy, numScenarios };
+
+static const char* maskModeStr[numMaskModes] = {"unmasked", "CU masked"};
+
+class hipPerfCUMaskPartition : public HipPerf::Benchmark {
+ public:
+  hipPerfCUMaskPartition() : HipPerf::Benchmark("hipPerfCUMaskPartition"),
+      numKernels_(HipPerf::iterationCount(20)) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    unsigned int maxStreams = partitionCounts[numPartitionCounts - 1];
+    buffers_.resize(maxStreams);
+    for (auto& buf : buffers_) {
+      HIPCHECK(hipMalloc(&buf, width_ * height_ * sizeof(uint)));
+    }
+    events_.resize(2 * maxStreams);
+    for (auto& event : events_) {
+      HIPCHECK(hipEventCreate(&event));
+    }
+  }
+
+  void close() override {
+    for (auto& buf : buffers_) {
+      HIPCHECK(hipFree(buf));
+    }
+    for (auto& event : events_) {
+      HIPCHECK(hipEventDestroy(event));
+    }
+  }
+
+  unsigned int numTests() override { return numPartitionCounts * numMaskModes * numScenarios; }
+
+  void run(unsigned int test) override {
+    Scenario scenario = static_cast<Scenario>(test % numScenarios);
+    MaskMode mask = static_cast<MaskMode>((test / numScenarios) % numMaskModes);
+    unsigned int partIdx = test / (numScenarios * numMaskModes);
+    unsigned int numParts = partitionCounts[partIdx];
+    if (numParts > static_cast<unsigned int>(props_.multiProcessorCount)) {
+      printf("info: %d CUs cannot be split %u ways, skipping\n", props_.multiProcessorCount,
+             numParts);
+      return;
+    }
+
+    std::vector<hipStream_t> streams(numParts);
+    for (unsigned int p = 0; p < numParts; p++) {
+      if (mask == maskNone) {
+        HIPCHECK(hipStreamCreateWithFlags(&streams[p], hipStreamNonBlocking));
+      } else {
+        std::vector<uint32_t> cuMask = sliceMask(p, numParts);
+        HIPCHECK(hipExtStreamCreateWithCUMask(&streams[p], cuMask.size(), cuMask.data()));
+      }
+    }
+    unsigned int activeStreams = scenario == victimAlone ? 1 : numParts;
+
+    // Event spans per stream; the warm-up runs and outliers are dropped below
+    std::vector<std::vector<double>> streamSec(activeStreams);
+    auto sec = measure([&]() {
+      for (unsigned int s = 0; s < activeStreams; s++) {
+        HIPCHECK(hipEventRecord(events_[2 * s], streams[s]));
+      }
+      for (unsigned int k = 0; k < numKernels_; k++) {
+        for (unsigned int s = 0; s < activeStreams; s++) {
+          launch(streams[s], buffers_[s]);
+        }
+      }
+      for (unsigned int s = 0; s < activeStreams; s++) {
+        HIPCHECK(hipEventRecord(events_[2 * s + 1], streams[s]));
+      }
+      for (unsigned int s = 0; s < activeStreams; s++) {
+        HIPCHECK(hipStreamSynchronize(streams[s]));
+        if (HipPerf::Counters::collecting()) {
+          continue;
+        }
+        float ms = 0;
+        HIPCHECK(hipEventElapsedTime(&ms, events_[2 * s], events_[2 * s + 1]));
+        streamSec[s].push_back(ms * 1e-3);
+      }
+    });
+    for (auto& s : streamSec) {
+      s = HipPerf::measuredSamples(s);
+    }
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%u slices %s", numParts, maskModeStr[mask]);
+    std::vector<double> victimRate = kernelsPerSecond(streamSec[0], numKernels_);
+    if (scenario == victimAlone) {
+      report(test, std::string(desc) + " victim alone", 0, numKernels_, "kernels/s", victimRate);
+      aloneRate_[partIdx][mask] = ComputePerfStats(victimRate).median;
+    } else {
+      for (unsigned int s = 0; s < activeStreams; s++) {
+        report(test, std::string(desc) + " stream " + std::to_string(s), 0, numKernels_,
+               "kernels/s", kernelsPerSecond(streamSec[s], numKernels_));
+      }
+      report(test, std::string(desc) + " total", 0, numKernels_ * numParts, "kernels/s",
+             kernelsPerSecond(sec, numKernels_ * numParts));
+      if (aloneRate_[partIdx][mask] > 0) {
+        std::vector<double> slowdown;
+        for (double rate : victimRate) {
+          slowdown.push_back(100.0 * (1.0 - rate / aloneRate_[partIdx][mask]));
+        }
+        report(test, std::string(desc) + " victim slowdown", 0, numKernels_, "%", slowdown,
+               HipPerf::betterLower);
+      }
+    }
+
+    for (auto& stream : streams) {
+      HIPCHECK(hipStreamDestroy(stream));
+    }
+  }
+
+ private:
+  // CUs [part * n / parts, (part + 1) * n / parts) as 32 bit mask words.
+  std::vector<uint32_t> sliceMask(unsigned int part, unsigned int parts) const {
+    unsigned int numCUs = props_.multiProcessorCount;
+    std::vector<uint32_t> mask((numCUs + 31) / 32, 0);
+    for (unsigned int cu = part * numCUs / parts; cu < (part + 1) * numCUs / parts; cu++) {
+      mask[cu / 32] |= 1u << (cu % 32);
+    }
+    return mask;
+  }
+
+  // All black region, every pixel runs maxIter_ iterations
+  void launch(hipStream_t stream, uint* buf) {
+    const float width = 0.00001f;
+    unsigned int threads = width_ * height_ / 4;
+    hipLaunchKernelGGL(mandelbrot, dim3(threads / 64), dim3(64), 0, stream, buf, width_,
+                       -0.5f * width, 0.5f * width, width / width_, -width / width_, maxIter_);
+  }
+
+  static std::vector<double> kernelsPerSecond(const std::vector<double>& sec,
+                                              unsigned int kernels) {
+    std::vector<double> rate;
+    for (double s : sec) {
+      rate.push_back(kernels / s);
+    }
+    return rate;
+  }
+
+  unsigned int numKernels_;  // per stream
+  const unsigned int width_ = 1024;
+  const unsigned int height_ = 1024;
+  const unsigned int maxIter_ = 256;
+  std::vector<uint*> buffers_;
+  std::vector<hipEvent_t> events_;  // start/stop pair per stream
+  double aloneRate_[numPartitionCounts][numMaskModes] = {};
+};
+
+HIP_PERF_BENCHMARK(hipPerfCUMaskPartition)
@@ -0,0 +1,194 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Chunked three stage pipeline over 256 MB of pinned host data: copy a chunk
+// to the device, run a kernel over it, copy the result back. Chunk c goes to
+// stream c % K with its own device buffers, so up to K chunks are in flight
+// (K = 1 to 8); chunk sizes come from the size table (or --sizes) and the
+// kernel does 1, 16 or 64 FMAs per element. The non-overlapped baseline is
+// the sum of each stage run alone over all chunks. Reported are the pipeline
+// throughput, its speedup over the baseline and the overlap fraction: the
+// share of the time the baseline spends beyond its longest stage that the
+// pipeline saved (100% means the pipeline is as fast as its slowest stage).
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const size_t totalBytes = 256 * 1024 * 1024;
+static const size_t defaultChunks[] = {256 * 1024, 1024 * 1024, 4 * 1024 * 1024,
+                                       16 * 1024 * 1024};
+static const unsigned int inFlight[] = {1, 2, 3, 4, 8};
+static const unsigned int numInFlight = sizeof(inFlight) / sizeof(inFlight[0]);
+static const unsigned int intensities[] = {1, 16, 64};
+static const unsigned int numIntensities = sizeof(intensities) / sizeof(intensities[0]);
+static const unsigned int maxInFlight = 8;
+
+enum Stage { stageH2D = 0, stageCompute, stageD2H, numStages };
+
+__global__ void pipelineKernel(const float* in, float* out, size_t n, unsigned int fmas) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    float x = in[i];
+    for (unsigned int f = 0; f < fmas; f++) {
+      x = fmaf(x, 0.999f, 0.5f);
+    }
+    out[i] = x;
+  }
+}
+
+class hipPerfCopyComputePipeline : public HipPerf::Benchmark {
+ public:
+  hipPerfCopyComputePipeline() : HipPerf::Benchmark("hipPerfCopyComputePipeline"),
+      hostIn_(nullptr), hostOut_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    for (size_t chunk : HipPerf::sweepSizes(std::vector<size_t>(std::begin(defaultChunks),
+                                                                std::end(defaultChunks)))) {
+      // Whole floats that divide the total
+      if (chunk >= sizeof(float) && totalBytes % chunk == 0 && chunk % sizeof(float) == 0) {
+        chunks_.push_back(chunk);
+      } else {
+        printf("info: chunk of %zu bytes does not divide %zu bytes, skipping\n", chunk,
+               totalBytes);
+      }
+    }
+    HIPCHECK(hipHostMalloc(&hostIn_, totalBytes));
+    HIPCHECK(hipHostMalloc(&hostOut_, totalBytes));
+    memset(hostIn_, 0, totalBytes);
+    streams_.resize(maxInFlight);
+    for (hipStream_t& stream : streams_) {
+      HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+    }
+  }
+
+  void close() override {
+    for (hipStream_t stream : streams_) {
+      HIPCHECK(hipStreamDestroy(stream));
+    }
+    HIPCHECK(hipHostFree(hostIn_));
+    HIPCHECK(hipHostFree(hostOut_));
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(chunks_.size()) * numIntensities * numInFlight;
+  }
+
+  void run(unsigned int test) override {
+    unsigned int k = inFlight[test % numInFlight];
+    unsigned int fmas = intensities[(test / numInFlight) % numIntensities];
+    size_t chunk = chunks_[test / (numInFlight * numIntensities)];
+    size_t numChunks = totalBytes / chunk;
+    size_t n = chunk / sizeof(float);
+
+    std::vector<float*> devIn(k), devOut(k);
+    for (unsigned int s = 0; s < k; s++) {
+      HIPCHECK(hipMalloc(&devIn[s], chunk));
+      HIPCHECK(hipMalloc(&devOut[s], chunk));
+    }
+    dim3 grid(static_cast<unsigned int>(
+        std::min<size_t>((n + 255) / 256, props_.multiProcessorCount * 8)));
+    char* in = static_cast<char*>(hostIn_);
+    char* out = static_cast<char*>(hostOut_);
+
+    auto enqueue = [&](Stage stage, size_t c, unsigned int s) {
+      switch (stage) {
+        case stageH2D:
+          HIPCHECK(hipMemcpyAsync(devIn[s], in + c * chunk, chunk, hipMemcpyHostToDevice,
+                                  streams_[s]));
+          break;
+        case stageCompute:
+          hipLaunchKernelGGL(pipelineKernel, grid, dim3(256), 0, streams_[s], devIn[s],
+                             devOut[s], n, fmas);
+          break;
+        default:
+          HIPCHECK(hipMemcpyAsync(out + c * chunk, devOut[s], chunk, hipMemcpyDeviceToHost,
+                                  streams_[s]));
+          break;
+      }
+    };
+
+    // Every stage alone over all chunks, on one stream
+    double baseline = 0;
+    double longestStage = 0;
+    for (int stage = 0; stage < numStages; stage++) {
+      double sec = ComputePerfStats(measure([&]() {
+        for (size_t c = 0; c < numChunks; c++) {
+          enqueue(static_cast<Stage>(stage), c, 0);
+        }
+        HIPCHECK(hipStreamSynchronize(streams_[0]));
+      })).median;
+      baseline += sec;
+      longestStage = std::max(longestStage, sec);
+    }
+
+    auto sec = measure([&]() {
+      for (size_t c = 0; c < numChunks; c++) {
+        unsigned int s = c % k;
+        enqueue(stageH2D, c, s);
+        enqueue(stageCompute, c, s);
+        enqueue(stageD2H, c, s);
+      }
+      HIPCHECK(hipGetLastError());
+      for (unsigned int s = 0; s < k; s++) {
+        HIPCHECK(hipStreamSynchronize(streams_[s]));
+      }
+    });
+
+    for (unsigned int s = 0; s < k; s++) {
+      HIPCHECK(hipFree(devIn[s]));
+      HIPCHECK(hipFree(devOut[s]));
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%8zu B chunks %2u fma %u in flight", chunk, fmas, k);
+    std::string prefix(desc);
+    report(test, prefix + " pipeline", chunk, numChunks, "GB/s",
+           HipPerf::toBandwidth(sec, totalBytes));
+    report(test, prefix + " non-overlapped", chunk, numChunks, "GB/s",
+           {totalBytes / baseline * 1e-9});
+    std::vector<double> speedup, overlap;
+    for (double s : sec) {
+      speedup.push_back(baseline / s);
+      overlap.push_back(baseline > longestStage
+                            ? 100.0 * (baseline - s) / (baseline - longestStage)
+                            : 0);
+    }
+    report(test, prefix + " speedup", chunk, numChunks, "x", speedup);
+    report(test, prefix + " overlap", chunk, numChunks, "%", overlap);
+  }
+
+ private:
+  std::vector<size_t> chunks_;
+  void* hostIn_;
+  void* hostOut_;
+  std::vector<hipStream_t> streams_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfCopyComputePipeline)
@@ -18,14 +18,15 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
  * TEST: %t
  * HIT_END
  */
 
 #include <iostream>
 #include <chrono>
-#include "test_common.h"
+#include "perf_harness.h"
+#include "mandelbrot_kernels.h"
 
 typedef struct {
   double x;
@@ -39,29 +40,6 @@ static coordRec coords[] = {
 
 static unsigned int numCoords = sizeof(coords) / sizeof(coordRec);
 
-__global__ void mandelbrot(uint *out, uint width, float xPos,  float yPos, float xStep,
-                            float yStep, uint maxIter) {
-
-  int tid = (blockIdx.x * blockDim.x + threadIdx.x);
-  int i = tid % width;
-  int j = tid / width;
-  float x0 = (float)(xPos + xStep*i);
-  float y0 = (float)(yPos + yStep*j);
-
-  float x = x0;
-  float y = y0;
-
-  uint iter = 0;
-  float tmp;
-  for (iter = 0; (x*x + y*y <= 4.0f) && (iter < maxIter); iter++) {
-    tmp = x;
-    x = fma(-y,y,fma(x,x,x0));
-    y = fma(2.0f*tmp,y,y0);
-  }
-
-  out[tid] = iter;
-};
-
 class hipPerfDeviceConcurrency {
   public:
   hipPerfDeviceConcurrency();
@@ -189,7 +167,7 @@ void hipPerfDeviceConcurrency::run(unsigned int testCase, int numGpus) {
 
   HIPCHECK(hipSetDevice(deviceId));
 
-  hipLaunchKernelGGL(mandelbrot, dim3(blocks), dim3(threads_per_block), 0, streams[i],
+  hipLaunchKernelGGL(float_mad_kernel<float>, dim3(blocks), dim3(threads_per_block), 0, streams[i],
                       dPtr[i], width_, xPos, yPos, xStep, yStep, maxIter[i]);
 
   }
@@ -231,8 +209,9 @@ void hipPerfDeviceConcurrency::run(unsigned int testCase, int numGpus) {
   }
 
   if (testCase != 0) {
-  std::cout << '\n' << "Measured time for kernel computation on " << numGpus << " device (s): "
-            << all_kernel_time.count() << " (s) " << '\n' << std::endl;
+  HipPerf::writeResult("hipPerfDeviceConcurrency", testCase, "kernel computation on " +
+                       std::to_string(numGpus) + " devices", 0, numGpus, "s",
+                       all_kernel_time.count());
   }
 
   if(testCase == 0) {
@@ -260,6 +239,7 @@ void hipPerfDeviceConcurrency::checkData(uint *ptr) {
 
 
 int main(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
   hipPerfDeviceConcurrency deviceConcurrency;
 
   deviceConcurrency.open();
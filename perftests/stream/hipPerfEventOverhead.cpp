@@ -0,0 +1,177 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of the individual event APIs, each with timing-enabled events and with
+// hipEventDisableTiming: create, destroy, record, query of a completed event,
+// record + synchronize, hipStreamWaitEvent enqueue, and the round trip of a
+// dependency from one stream to another on the same device and on a second
+// device. Every call is timed separately.
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+
+enum EventOp {
+  opCreate = 0,
+  opDestroy,
+  opRecord,
+  opQuery,
+  opSynchronize,
+  opStreamWait,
+  opCrossStream,
+  opCrossDevice,
+  numEventOps
+};
+
+static const char* eventOpStr[numEventOps] = {
+    "hipEventCreateWithFlags", "hipEventDestroy",    "hipEventRecord",
+    "hipEventQuery",           "record+synchronize", "hipStreamWaitEvent",
+    "cross-stream wait",       "cross-device wait"};
+
+static const unsigned int eventFlags[] = {hipEventDefault, hipEventDisableTiming};
+static const char* eventFlagsStr[] = {"timing", "disableTiming"};
+
+class hipPerfEventOverhead : public HipPerf::Benchmark {
+ public:
+  hipPerfEventOverhead() : HipPerf::Benchmark("hipPerfEventOverhead"),
+      count_(HipPerf::iterationCount(10000)), numGpus_(0), peerStream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipGetDeviceCount(&numGpus_));
+    HIPCHECK(hipStreamCreateWithFlags(&streams_[0], hipStreamNonBlocking));
+    HIPCHECK(hipStreamCreateWithFlags(&streams_[1], hipStreamNonBlocking));
+    if (numGpus_ > 1) {
+      HIPCHECK(hipSetDevice(peerDevice()));
+      HIPCHECK(hipStreamCreateWithFlags(&peerStream_, hipStreamNonBlocking));
+      HIPCHECK(hipSetDevice(deviceId_));
+    }
+  }
+
+  void close() override {
+    HIPCHECK(hipStreamDestroy(streams_[0]));
+    HIPCHECK(hipStreamDestroy(streams_[1]));
+    if (peerStream_ != nullptr) {
+      HIPCHECK(hipStreamDestroy(peerStream_));
+    }
+  }
+
+  unsigned int numTests() override { return numEventOps * 2; }
+
+  void run(unsigned int test) override {
+    EventOp op = static_cast<EventOp>(test % numEventOps);
+    unsigned int flagIdx = test / numEventOps;
+    unsigned int flags = eventFlags[flagIdx];
+    if (op == opCrossDevice && numGpus_ < 2) {
+      printf("info: cross-device wait needs 2 GPUs, skipping\n");
+      return;
+    }
+
+    std::vector<double> sec;
+    switch (op) {
+      case opCreate:
+      case opDestroy: {
+        // Destroy consumes exactly what the create pass produced, whose count --target-ci
+        // decides, so it times its own loop; the first p_warmup destroys are untimed
+        std::vector<hipEvent_t> events;
+        auto create = measureEach([&]() {
+          hipEvent_t event;
+          HIPCHECK(hipEventCreateWithFlags(&event, flags));
+          events.push_back(event);
+        }, count_);
+        CPerfSampler destroy;
+        for (size_t i = 0; i < events.size(); i++) {
+          bool timed = i >= p_warmup;
+          if (timed) destroy.Start();
+          HIPCHECK(hipEventDestroy(events[events.size() - 1 - i]));
+          if (timed) destroy.Stop();
+        }
+        if (p_rejectOutliers != 0) {
+          destroy.RejectOutliers(p_rejectOutliers);
+        }
+        sec = op == opCreate ? create : destroy.GetSamples();
+        break;
+      }
+      case opCrossDevice: {
+        hipEvent_t event;
+        HIPCHECK(hipEventCreateWithFlags(&event, flags));
+        sec = measureEach([&]() {
+          HIPCHECK(hipEventRecord(event, streams_[0]));
+          HIPCHECK(hipStreamWaitEvent(peerStream_, event, 0));
+          HIPCHECK(hipStreamSynchronize(peerStream_));
+        }, count_);
+        HIPCHECK(hipEventDestroy(event));
+        break;
+      }
+      default: {
+        hipEvent_t event;
+        HIPCHECK(hipEventCreateWithFlags(&event, flags));
+        HIPCHECK(hipEventRecord(event, streams_[0]));
+        HIPCHECK(hipEventSynchronize(event));
+        sec = measureEach([&]() { timedOp(op, event); }, count_);
+        HIPCHECK(hipDeviceSynchronize());
+        HIPCHECK(hipEventDestroy(event));
+        break;
+      }
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %s", eventOpStr[op], eventFlagsStr[flagIdx]);
+    report(test, desc, 0, count_, "us", HipPerf::toMicroseconds(sec, 1));
+  }
+
+ private:
+  int peerDevice() const { return (deviceId_ + 1) % numGpus_; }
+
+  void timedOp(EventOp op, hipEvent_t event) {
+    switch (op) {
+      case opRecord:
+        HIPCHECK(hipEventRecord(event, streams_[0]));
+        break;
+      case opQuery:
+        HIPCHECK(hipEventQuery(event));
+        break;
+      case opSynchronize:
+        HIPCHECK(hipEventRecord(event, streams_[0]));
+        HIPCHECK(hipEventSynchronize(event));
+        break;
+      case opStreamWait:
+        HIPCHECK(hipStreamWaitEvent(streams_[1], event, 0));
+        break;
+      default:
+        HIPCHECK(hipEventRecord(event, streams_[0]));
+        HIPCHECK(hipStreamWaitEvent(streams_[1], event, 0));
+        HIPCHECK(hipStreamSynchronize(streams_[1]));
+        break;
+    }
+  }
+
+  unsigned int count_;
+  int numGpus_;
+  hipStream_t streams_[2];
+  hipStream_t peerStream_;  // on peerDevice()
+};
+
+HIP_PERF_BENCHMARK(hipPerfEventOverhead)
@@ -0,0 +1,138 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Throughput and dispatch latency of host functions enqueued with
+// hipLaunchHostFunc and hipStreamAddCallback, alone or interleaved with an
+// empty kernel before every callback.
+//
+// Throughput tests enqueue --iterations callbacks on each of 1..8 streams and
+// report callbacks/s until all streams are idle. Latency tests enqueue one
+// callback at a time on a single stream and time the round trip until the host
+// sees it has run.
+
+#include <stdio.h>
+
+#include <atomic>
+
+#include "perf_harness.h"
+
+static const unsigned int streamCounts[] = {1, 2, 4, 8};
+static const unsigned int numStreamCounts = sizeof(streamCounts) / sizeof(streamCounts[0]);
+
+enum HostFuncApi { apiLaunchHostFunc = 0, apiStreamAddCallback, numHostFuncApis };
+
+static const char* hostFuncApiStr[numHostFuncApis] = {"hipLaunchHostFunc",
+                                                      "hipStreamAddCallback"};
+
+__global__ void _hostFuncKernel() {}
+
+static void hostFunc(void* userData) {
+  static_cast<std::atomic<unsigned int>*>(userData)->fetch_add(1, std::memory_order_release);
+}
+
+static void streamCallback(hipStream_t stream, hipError_t status, void* userData) {
+  HIPCHECK(status);
+  hostFunc(userData);
+}
+
+class hipPerfHostFunc : public HipPerf::Benchmark {
+ public:
+  hipPerfHostFunc() : HipPerf::Benchmark("hipPerfHostFunc"),
+      callbacks_(HipPerf::iterationCount(10000)), counter_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    streams_.resize(streamCounts[numStreamCounts - 1]);
+    for (auto& stream : streams_) {
+      HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+    }
+  }
+
+  void close() override {
+    for (auto& stream : streams_) {
+      HIPCHECK(hipStreamDestroy(stream));
+    }
+  }
+
+  // Throughput for every stream count, then one latency test, per api and interleaving
+  unsigned int numTests() override { return numHostFuncApis * 2 * (numStreamCounts + 1); }
+
+  void run(unsigned int test) override {
+    unsigned int variant = test % (numStreamCounts + 1);
+    HostFuncApi api = static_cast<HostFuncApi>((test / (numStreamCounts + 1)) % numHostFuncApis);
+    bool interleave = test / ((numStreamCounts + 1) * numHostFuncApis) != 0;
+
+    char desc[96];
+    if (variant < numStreamCounts) {
+      unsigned int numStreams = streamCounts[variant];
+      auto sec = measure([&]() {
+        for (unsigned int i = 0; i < callbacks_; i++) {
+          for (unsigned int s = 0; s < numStreams; s++) {
+            enqueue(api, interleave, streams_[s]);
+          }
+        }
+        for (unsigned int s = 0; s < numStreams; s++) {
+          HIPCHECK(hipStreamSynchronize(streams_[s]));
+        }
+      });
+      snprintf(desc, sizeof(desc), "%s %u streams%s", hostFuncApiStr[api], numStreams,
+               interleave ? " +kernel" : "");
+      std::vector<double> rate;
+      for (double s : sec) {
+        rate.push_back(static_cast<double>(callbacks_) * numStreams / s);
+      }
+      report(test, desc, 0, callbacks_, "callbacks/s", rate);
+    } else {
+      auto sec = measureEach([&]() {
+        unsigned int expected = counter_.load(std::memory_order_acquire) + 1;
+        enqueue(api, interleave, streams_[0]);
+        while (counter_.load(std::memory_order_acquire) != expected) {
+        }
+      }, callbacks_);
+      HIPCHECK(hipStreamSynchronize(streams_[0]));
+      snprintf(desc, sizeof(desc), "%s latency%s", hostFuncApiStr[api],
+               interleave ? " +kernel" : "");
+      report(test, desc, 0, callbacks_, "us", HipPerf::toMicroseconds(sec, 1));
+    }
+  }
+
+ private:
+  void enqueue(HostFuncApi api, bool interleave, hipStream_t stream) {
+    if (interleave) {
+      hipLaunchKernelGGL(_hostFuncKernel, dim3(1), dim3(1), 0, stream);
+    }
+    if (api == apiLaunchHostFunc) {
+      HIPCHECK(hipLaunchHostFunc(stream, hostFunc, &counter_));
+    } else {
+      HIPCHECK(hipStreamAddCallback(stream, streamCallback, &counter_, 0));
+    }
+  }
+
+  unsigned int callbacks_;  // per stream and repetition
+  std::vector<hipStream_t> streams_;
+  std::atomic<unsigned int> counter_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfHostFunc)
@@ -0,0 +1,299 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Two process GPU pipeline over IPC memory and events. The parent (producer)
+// forks before HIP is initialized and talks to the child (consumer) over a
+// pair of pipes. The producer owns a buffer of 1, 2 or 4 slots; per message
+// it fills a slot with a kernel, records that slot's interprocess ready event
+// and sends the slot index. The consumer makes its stream wait for the ready
+// event through the opened handle, processes the slot into its own buffer,
+// records its done event and sends the index back; the producer makes its
+// stream wait for the done event before it writes the slot again. With one
+// slot the producer synchronizes after every message and the samples are
+// full round trips; with more slots messages overlap and only the sustained
+// messages/s is reported.
+
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <vector>
+
+#include "perf_harness.h"
+
+static const unsigned int maxSlots = 4;
+static const unsigned int pipelineSlots[] = {1, 2, 4};
+static const unsigned int numPipelineSlots = sizeof(pipelineSlots) / sizeof(pipelineSlots[0]);
+static const size_t pipelineSizes[] = {4 << 10, 1 << 20, 16 << 20};
+static const unsigned int numPipelineSizes = sizeof(pipelineSizes) / sizeof(pipelineSizes[0]);
+static const unsigned int warmupMessages = 16;
+static const unsigned int timedMessages = 256;
+
+enum PipelineCommand { cmdRun, cmdQuit };
+
+// Producer to consumer, once per configuration
+struct PipelineConfig {
+  PipelineCommand command;
+  size_t bytes;  // per slot
+  unsigned int slots;
+  unsigned int messages;
+  hipIpcMemHandle_t buffer;
+  hipIpcEventHandle_t ready[maxSlots];
+};
+
+// Consumer to producer, once per configuration
+struct ConsumerEvents {
+  hipIpcEventHandle_t done[maxSlots];
+};
+
+__global__ void produceKernel(float* slot, size_t n, float value) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    slot[i] = value;
+  }
+}
+
+__global__ void consumeKernel(float* out, const float* slot, size_t n) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    out[i] = slot[i] * 2.0f + 1.0f;
+  }
+}
+
+// A short read means the other process is gone
+static void readAll(int fd, void* data, size_t size) {
+  char* p = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t got = read(fd, p, size);
+    if (got <= 0) {
+      failed("pipe read failed, the other process exited");
+    }
+    p += got;
+    size -= got;
+  }
+}
+
+static void writeAll(int fd, const void* data, size_t size) {
+  const char* p = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t put = write(fd, p, size);
+    if (put <= 0) {
+      failed("pipe write failed, the other process exited");
+    }
+    p += put;
+    size -= put;
+  }
+}
+
+static dim3 pipelineGrid(size_t n) {
+  size_t blocks = (n + 255) / 256;
+  return dim3(static_cast<unsigned int>(blocks < 1024 ? blocks : 1024));
+}
+
+static void runConsumer(int fromProducer, int toProducer) {
+  HIPCHECK(hipSetDevice(p_gpuDevice));
+  hipStream_t stream;
+  HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+
+  for (;;) {
+    PipelineConfig config;
+    readAll(fromProducer, &config, sizeof(config));
+    if (config.command == cmdQuit) {
+      break;
+    }
+    size_t n = config.bytes / sizeof(float);
+
+    void* buffer = nullptr;
+    HIPCHECK(hipIpcOpenMemHandle(&buffer, config.buffer, hipIpcMemLazyEnablePeerAccess));
+    float* out = nullptr;
+    HIPCHECK(hipMalloc(&out, config.bytes));
+    hipEvent_t ready[maxSlots];
+    hipEvent_t done[maxSlots];
+    ConsumerEvents events;
+    for (unsigned int s = 0; s < config.slots; s++) {
+      HIPCHECK(hipIpcOpenEventHandle(&ready[s], config.ready[s]));
+      HIPCHECK(hipEventCreateWithFlags(&done[s], hipEventInterprocess | hipEventDisableTiming));
+      HIPCHECK(hipIpcGetEventHandle(&events.done[s], done[s]));
+    }
+    writeAll(toProducer, &events, sizeof(events));
+
+    for (unsigned int m = 0; m < config.messages; m++) {
+      unsigned int slot = 0;
+      readAll(fromProducer, &slot, sizeof(slot));
+      HIPCHECK(hipStreamWaitEvent(stream, ready[slot], 0));
+      hipLaunchKernelGGL(consumeKernel, pipelineGrid(n), dim3(256), 0, stream, out,
+                         static_cast<float*>(buffer) + slot * n, n);
+      HIPCHECK(hipGetLastError());
+      HIPCHECK(hipEventRecord(done[slot], stream));
+      writeAll(toProducer, &slot, sizeof(slot));
+    }
+
+    HIPCHECK(hipStreamSynchronize(stream));
+    for (unsigned int s = 0; s < config.slots; s++) {
+      HIPCHECK(hipEventDestroy(ready[s]));
+      HIPCHECK(hipEventDestroy(done[s]));
+    }
+    HIPCHECK(hipFree(out));
+    HIPCHECK(hipIpcCloseMemHandle(buffer));
+  }
+
+  HIPCHECK(hipStreamDestroy(stream));
+}
+
+static void runProducer(int toConsumer, int fromConsumer, unsigned int test, size_t bytes,
+                        unsigned int slots) {
+  size_t n = bytes / sizeof(float);
+  hipStream_t stream;
+  HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+  float* buffer = nullptr;
+  HIPCHECK(hipMalloc(&buffer, bytes * slots));
+
+  PipelineConfig config;
+  config.command = cmdRun;
+  config.bytes = bytes;
+  config.slots = slots;
+  config.messages = warmupMessages + timedMessages;
+  HIPCHECK(hipIpcGetMemHandle(&config.buffer, buffer));
+  hipEvent_t ready[maxSlots];
+  hipEvent_t done[maxSlots];
+  for (unsigned int s = 0; s < slots; s++) {
+    HIPCHECK(hipEventCreateWithFlags(&ready[s], hipEventInterprocess | hipEventDisableTiming));
+    HIPCHECK(hipIpcGetEventHandle(&config.ready[s], ready[s]));
+  }
+  writeAll(toConsumer, &config, sizeof(config));
+  ConsumerEvents events;
+  readAll(fromConsumer, &events, sizeof(events));
+  for (unsigned int s = 0; s < slots; s++) {
+    HIPCHECK(hipIpcOpenEventHandle(&done[s], events.done[s]));
+  }
+
+  // Returns the oldest message in flight and orders the next write of its slot after it
+  auto receive = [&]() {
+    unsigned int slot = 0;
+    readAll(fromConsumer, &slot, sizeof(slot));
+    HIPCHECK(hipStreamWaitEvent(stream, done[slot], 0));
+  };
+
+  std::vector<double> roundTripUs;
+  std::chrono::steady_clock::time_point start;
+  for (unsigned int m = 0; m < config.messages; m++) {
+    if (m == warmupMessages) {
+      start = std::chrono::steady_clock::now();
+    }
+    // All slots are in flight, wait for the oldest one
+    if (slots > 1 && m >= slots) {
+      receive();
+    }
+    auto sent = std::chrono::steady_clock::now();
+    unsigned int slot = m % slots;
+    hipLaunchKernelGGL(produceKernel, pipelineGrid(n), dim3(256), 0, stream, buffer + slot * n,
+                       n, static_cast<float>(m));
+    HIPCHECK(hipGetLastError());
+    HIPCHECK(hipEventRecord(ready[slot], stream));
+    writeAll(toConsumer, &slot, sizeof(slot));
+    if (slots == 1) {
+      receive();
+      HIPCHECK(hipStreamSynchronize(stream));
+      if (m >= warmupMessages) {
+        roundTripUs.push_back(std::chrono::duration<double, std::micro>(
+                                  std::chrono::steady_clock::now() - sent).count());
+      }
+    }
+  }
+  // Drain the messages still in flight
+  if (slots > 1) {
+    for (unsigned int s = 0; s < slots; s++) {
+      receive();
+    }
+  }
+  HIPCHECK(hipStreamSynchronize(stream));
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  for (unsigned int s = 0; s < slots; s++) {
+    HIPCHECK(hipEventDestroy(ready[s]));
+    HIPCHECK(hipEventDestroy(done[s]));
+  }
+  HIPCHECK(hipFree(buffer));
+  HIPCHECK(hipStreamDestroy(stream));
+
+  std::string desc = std::to_string(bytes >> 10) + " KB x " + std::to_string(slots) + " slots";
+  HipPerf::writeResult("hipPerfIpcPipeline", test, desc + " messages", bytes, timedMessages,
+                       "msgs/s", timedMessages / elapsed.count());
+  if (slots == 1) {
+    HipPerf::Result result;
+    result.benchmark = "hipPerfIpcPipeline";
+    result.test = test;
+    result.desc = desc + " round trip";
+    result.device = p_gpuDevice;
+    result.bytes = bytes;
+    result.iterations = timedMessages;
+    result.unit = "us";
+    result.values = roundTripUs;
+    HipPerf::writeResult(result);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
+
+  int toConsumer[2];
+  int toProducer[2];
+  if (pipe(toConsumer) == -1 || pipe(toProducer) == -1) {
+    failed("pipe failed");
+  }
+
+  // HIP must not be initialized before the fork
+  pid_t pid = fork();
+  if (pid < 0) {
+    failed("fork failed");
+  }
+  if (pid == 0) {
+    close(toConsumer[1]);
+    close(toProducer[0]);
+    runConsumer(toConsumer[0], toProducer[1]);
+    exit(0);
+  }
+  close(toConsumer[0]);
+  close(toProducer[1]);
+
+  HIPCHECK(hipSetDevice(p_gpuDevice));
+  unsigned int test = 0;
+  for (unsigned int b = 0; b < numPipelineSizes; b++) {
+    for (unsigned int s = 0; s < numPipelineSlots; s++) {
+      runProducer(toConsumer[1], toProducer[0], test++, pipelineSizes[b], pipelineSlots[s]);
+    }
+  }
+
+  PipelineConfig quit;
+  quit.command = cmdQuit;
+  writeAll(toConsumer[1], &quit, sizeof(quit));
+  close(toConsumer[1]);
+  close(toProducer[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    failed("consumer process failed");
+  }
+  passed();
+}
@@ -0,0 +1,255 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Data parallel scaling over 1 to N devices. A grid-stride FMA kernel covers a
+// workload split evenly across the devices, 64M elements in total (strong
+// scaling) or 16M per device (weak scaling). Each device's share is launched
+// as 16 chunks, either from one host thread that calls hipSetDevice before
+// every chunk, interleaving the devices, or from one thread per device. Every
+// test reports the wall time from the first launch until all devices are
+// done, the speedup (strong) or efficiency (weak) against one device with the
+// same host mode, the host time spent in hipSetDevice per run, and per device
+// the share of the wall time between its first and last event that the
+// device was busy. Low utilization with one thread but not with one thread per
+// device points at the host side.
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "perf_harness.h"
+
+enum Scaling { scalingStrong, scalingWeak, numScalings };
+static const char* scalingStr[] = {"strong", "weak"};
+
+enum HostMode { hostSingleThread, hostThreadPerDevice, numHostModes };
+static const char* hostModeStr[] = {"1 host thread", "thread per device"};
+
+static const size_t strongElements = 64 * 1024 * 1024;
+static const size_t weakElements = 16 * 1024 * 1024;
+static const unsigned int chunksPerDevice = 16;
+static const unsigned int fmaLoops = 64;
+
+__global__ void scalingKernel(float* data, size_t n, unsigned int loops) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    float v = data[i];
+    for (unsigned int l = 0; l < loops; l++) {
+      v = v * 0.999f + 0.5f;
+    }
+    data[i] = v;
+  }
+}
+
+struct ScalingTiming {
+  std::vector<double> wall;                    // seconds per run
+  std::vector<double> setDevice;               // seconds in hipSetDevice per run
+  std::vector<std::vector<double>> busy;       // per device, fraction of the wall time
+};
+
+class hipPerfMultiGpuScaling : public HipPerf::Benchmark {
+ public:
+  hipPerfMultiGpuScaling() : HipPerf::Benchmark("hipPerfMultiGpuScaling"), numGpus_(0) {
+    HIPCHECK(hipGetDeviceCount(&numGpus_));
+    for (int g = 1; g < numGpus_; g *= 2) {
+      deviceCounts_.push_back(g);
+    }
+    deviceCounts_.push_back(numGpus_);
+  }
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    size_t perDevice = std::max(strongElements, weakElements);
+    devices_.resize(numGpus_);
+    for (int d = 0; d < numGpus_; d++) {
+      DeviceState& state = devices_[d];
+      HIPCHECK(hipSetDevice(d));
+      HIPCHECK(hipStreamCreateWithFlags(&state.stream, hipStreamNonBlocking));
+      HIPCHECK(hipEventCreate(&state.start));
+      HIPCHECK(hipEventCreate(&state.end));
+      HIPCHECK(hipMalloc(&state.data, perDevice * sizeof(float)));
+      HIPCHECK(hipMemset(state.data, 0, perDevice * sizeof(float)));
+      HIPCHECK(hipDeviceSynchronize());
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+    for (int s = 0; s < numScalings; s++) {
+      for (int m = 0; m < numHostModes; m++) {
+        baseline_[s][m] = 0.0;
+      }
+    }
+  }
+
+  void close() override {
+    for (int d = 0; d < numGpus_; d++) {
+      DeviceState& state = devices_[d];
+      HIPCHECK(hipSetDevice(d));
+      HIPCHECK(hipFree(state.data));
+      HIPCHECK(hipEventDestroy(state.start));
+      HIPCHECK(hipEventDestroy(state.end));
+      HIPCHECK(hipStreamDestroy(state.stream));
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+  }
+
+  unsigned int numTests() override { return numScalings * numHostModes * deviceCounts_.size(); }
+
+  void run(unsigned int test) override {
+    HostMode mode = static_cast<HostMode>(test % numHostModes);
+    Scaling scaling = static_cast<Scaling>((test / numHostModes) % numScalings);
+    unsigned int gpus = deviceCounts_[test / (numHostModes * numScalings)];
+
+    // One device with the same host mode, measured once per mode
+    if (baseline_[scaling][mode] == 0.0) {
+      baseline_[scaling][mode] = ComputePerfStats(runScaling(scaling, mode, 1).wall).median;
+    }
+    ScalingTiming timing = runScaling(scaling, mode, gpus);
+
+    size_t elements = scaling == scalingStrong ? strongElements : weakElements * gpus;
+    size_t bytes = elements * sizeof(float);
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%s %u devices %s", scalingStr[scaling], gpus,
+             hostModeStr[mode]);
+    report(test, desc, bytes, chunksPerDevice, "ms",
+           HipPerf::toMicroseconds(timing.wall, 1000.0));
+    std::vector<double> speedup;
+    for (double sec : timing.wall) {
+      speedup.push_back(baseline_[scaling][mode] / sec);
+    }
+    report(test, std::string(desc) + (scaling == scalingStrong ? " speedup" : " efficiency"),
+           bytes, chunksPerDevice, "x", speedup);
+    report(test, std::string(desc) + " hipSetDevice", bytes, chunksPerDevice, "us",
+           HipPerf::toMicroseconds(timing.setDevice, 1.0));
+    for (unsigned int d = 0; d < gpus; d++) {
+      std::vector<double> percent;
+      for (double fraction : timing.busy[d]) {
+        percent.push_back(fraction * 100);
+      }
+      report(d, test, std::string(desc) + " busy", bytes / gpus, chunksPerDevice, "%", percent);
+    }
+  }
+
+ private:
+  struct DeviceState {
+    hipStream_t stream;
+    hipEvent_t start;
+    hipEvent_t end;
+    float* data;
+  };
+
+  void launchChunk(unsigned int d, size_t chunk, size_t chunkElements) {
+    hipLaunchKernelGGL(scalingKernel, dim3(1024), dim3(256), 0, devices_[d].stream,
+                       devices_[d].data + chunk * chunkElements, chunkElements, fmaLoops);
+  }
+
+  ScalingTiming runScaling(Scaling scaling, HostMode mode, unsigned int gpus) {
+    size_t perDevice = scaling == scalingStrong ? strongElements / gpus : weakElements;
+    size_t chunkElements = perDevice / chunksPerDevice;
+
+    ScalingTiming timing;
+    timing.busy.resize(gpus);
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      double wall = 0;
+      double setDevice = 0;
+      if (mode == hostSingleThread) {
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int c = 0; c < chunksPerDevice; c++) {
+          for (unsigned int d = 0; d < gpus; d++) {
+            auto before = std::chrono::steady_clock::now();
+            HIPCHECK(hipSetDevice(d));
+            setDevice += std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                       before).count();
+            if (c == 0) {
+              HIPCHECK(hipEventRecord(devices_[d].start, devices_[d].stream));
+            }
+            launchChunk(d, c, chunkElements);
+            if (c == chunksPerDevice - 1) {
+              HIPCHECK(hipEventRecord(devices_[d].end, devices_[d].stream));
+            }
+          }
+        }
+        for (unsigned int d = 0; d < gpus; d++) {
+          HIPCHECK(hipStreamSynchronize(devices_[d].stream));
+        }
+        wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      } else {
+        std::atomic<unsigned int> ready(0);
+        std::atomic<bool> go(false);
+        std::vector<double> threadSetDevice(gpus);
+        std::vector<std::thread> threads;
+        for (unsigned int d = 0; d < gpus; d++) {
+          threads.emplace_back([&, d]() {
+            auto before = std::chrono::steady_clock::now();
+            HIPCHECK(hipSetDevice(d));
+            threadSetDevice[d] = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - before).count();
+            ready++;
+            while (!go.load(std::memory_order_acquire)) {
+            }
+            HIPCHECK(hipEventRecord(devices_[d].start, devices_[d].stream));
+            for (unsigned int c = 0; c < chunksPerDevice; c++) {
+              launchChunk(d, c, chunkElements);
+            }
+            HIPCHECK(hipEventRecord(devices_[d].end, devices_[d].stream));
+            HIPCHECK(hipStreamSynchronize(devices_[d].stream));
+          });
+        }
+        // Thread creation is not part of the run
+        while (ready.load() != gpus) {
+        }
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& thread : threads) {
+          thread.join();
+        }
+        wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (double sec : threadSetDevice) {
+          setDevice += sec;
+        }
+      }
+
+      if (r < p_warmup) {
+        continue;
+      }
+      timing.wall.push_back(wall);
+      timing.setDevice.push_back(setDevice);
+      for (unsigned int d = 0; d < gpus; d++) {
+        float ms = 0;
+        HIPCHECK(hipEventElapsedTime(&ms, devices_[d].start, devices_[d].end));
+        timing.busy[d].push_back(ms / 1000 / wall);
+      }
+    }
+    HIPCHECK(hipSetDevice(deviceId_));
+    return timing;
+  }
+
+  int numGpus_;
+  std::vector<unsigned int> deviceCounts_;
+  std::vector<DeviceState> devices_;
+  double baseline_[numScalings][numHostModes];
+};
+
+HIP_PERF_BENCHMARK(hipPerfMultiGpuScaling)
@@ -0,0 +1,230 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Sharing one GPU between processes against sharing it between streams of
+// one process. Every configuration forks its workers from a parent that never
+// initializes HIP: either N processes with one stream each, or one process
+// with N streams. Each stream launches the same number of identical compute
+// kernels, the workers start together behind a barrier in shared memory and
+// report their start and end times. Aggregate throughput is all kernels over
+// the span from the first start to the last end, per process throughput is
+// each worker's kernels over its own time, and the ratio of the N stream to
+// the N process aggregate is the cost of switching between process contexts.
+// Kernels of a single workgroup and of four workgroups per CU separate the
+// launch bound case from the case where the kernels fill the device.
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum ShareMode { shareStreams, shareProcesses, numShareModes };
+static const char* shareModeStr[] = {"streams in 1 process", "processes"};
+
+static const unsigned int maxWorkers = 8;
+static const unsigned int kernelsPerStream = 256;
+static const unsigned int warmupKernels = 8;
+static const unsigned int fmaLoops = 4096;
+static const unsigned int blockThreads = 256;
+// Seconds the parent waits for all workers to reach the barrier
+static const int workerTimeout = 120;
+
+struct WorkerTimes {
+  double start;
+  double end;
+};
+
+struct SharedState {
+  int multiProcessorCount;
+  std::atomic<unsigned int> ready;
+  std::atomic<unsigned int> go;
+  WorkerTimes times[maxWorkers];
+};
+
+__global__ void steadyKernel(float* data, unsigned int loops) {
+  unsigned int i = blockIdx.x * blockDim.x + threadIdx.x;
+  float v = data[i];
+  for (unsigned int l = 0; l < loops; l++) {
+    v = v * 0.999f + 0.25f;
+  }
+  data[i] = v;
+}
+
+static void runWorker(SharedState* shared, unsigned int index, unsigned int numStreams,
+                      unsigned int blocks) {
+  HIPCHECK(hipSetDevice(p_gpuDevice));
+  std::vector<hipStream_t> streams(numStreams);
+  std::vector<float*> data(numStreams);
+  for (unsigned int s = 0; s < numStreams; s++) {
+    HIPCHECK(hipStreamCreateWithFlags(&streams[s], hipStreamNonBlocking));
+    HIPCHECK(hipMalloc(&data[s], blocks * blockThreads * sizeof(float)));
+    HIPCHECK(hipMemset(data[s], 0, blocks * blockThreads * sizeof(float)));
+  }
+  auto launchAll = [&](unsigned int kernels) {
+    for (unsigned int k = 0; k < kernels; k++) {
+      for (unsigned int s = 0; s < numStreams; s++) {
+        hipLaunchKernelGGL(steadyKernel, dim3(blocks), dim3(blockThreads), 0, streams[s],
+                           data[s], fmaLoops);
+      }
+    }
+    for (unsigned int s = 0; s < numStreams; s++) {
+      HIPCHECK(hipStreamSynchronize(streams[s]));
+    }
+  };
+  launchAll(warmupKernels);
+
+  shared->ready++;
+  while (shared->go.load() == 0) {
+  }
+  shared->times[index].start = HipTest::nowSec();
+  launchAll(kernelsPerStream);
+  shared->times[index].end = HipTest::nowSec();
+
+  for (unsigned int s = 0; s < numStreams; s++) {
+    HIPCHECK(hipFree(data[s]));
+    HIPCHECK(hipStreamDestroy(streams[s]));
+  }
+}
+
+// Runs one configuration and returns its aggregate kernels/s
+static double runShare(SharedState* shared, unsigned int test, ShareMode mode,
+                       unsigned int workers, unsigned int blocks) {
+  unsigned int processes = mode == shareProcesses ? workers : 1;
+  unsigned int streams = mode == shareProcesses ? 1 : workers;
+  shared->ready = 0;
+  shared->go = 0;
+
+  std::vector<pid_t> pids;
+  for (unsigned int p = 0; p < processes; p++) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      failed("fork failed");
+    }
+    if (pid == 0) {
+      runWorker(shared, p, streams, blocks);
+      exit(0);
+    }
+    pids.push_back(pid);
+  }
+
+  // A worker that fails aborts before the barrier
+  double deadline = HipTest::nowSec() + workerTimeout;
+  while (shared->ready.load() != processes) {
+    if (HipTest::nowSec() > deadline) {
+      failed("workers did not reach the barrier");
+    }
+    usleep(100);
+  }
+  shared->go = 1;
+  for (pid_t pid : pids) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      failed("worker process failed");
+    }
+  }
+
+  double first = shared->times[0].start;
+  double last = shared->times[0].end;
+  std::vector<double> perProcess;
+  for (unsigned int p = 0; p < processes; p++) {
+    first = std::min(first, shared->times[p].start);
+    last = std::max(last, shared->times[p].end);
+    perProcess.push_back(streams * kernelsPerStream /
+                         (shared->times[p].end - shared->times[p].start));
+  }
+  double aggregate = static_cast<double>(workers) * kernelsPerStream / (last - first);
+
+  std::string desc = std::to_string(workers) + " " + shareModeStr[mode] + ", " +
+                     std::to_string(blocks) + " workgroups";
+  HipPerf::writeResult("hipPerfMultiProcess", test, desc + " aggregate", 0,
+                       workers * kernelsPerStream, "kernels/s", aggregate);
+  if (mode == shareProcesses) {
+    HipPerf::Result result;
+    result.benchmark = "hipPerfMultiProcess";
+    result.test = test;
+    result.desc = desc + " per process";
+    result.device = p_gpuDevice;
+    result.bytes = 0;
+    result.iterations = kernelsPerStream;
+    result.unit = "kernels/s";
+    result.values = perProcess;
+    HipPerf::writeResult(result);
+  }
+  return aggregate;
+}
+
+int main(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
+
+  SharedState* shared = reinterpret_cast<SharedState*>(mmap(
+      nullptr, sizeof(SharedState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+  if (shared == MAP_FAILED) {
+    failed("mmap of the shared state failed");
+  }
+  new (shared) SharedState();
+
+  // The CU count comes from a child, the parent must stay free of HIP to fork
+  pid_t pid = fork();
+  if (pid < 0) {
+    failed("fork failed");
+  }
+  if (pid == 0) {
+    hipDeviceProp_t props;
+    HIPCHECK(hipGetDeviceProperties(&props, p_gpuDevice));
+    shared->multiProcessorCount = props.multiProcessorCount;
+    exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    failed("cannot query device %d", p_gpuDevice);
+  }
+  const unsigned int blockCounts[] = {
+      1, 4 * static_cast<unsigned int>(shared->multiProcessorCount)};
+
+  unsigned int test = 0;
+  for (unsigned int blocks : blockCounts) {
+    for (unsigned int workers = 1; workers <= maxWorkers; workers *= 2) {
+      double streamRate = runShare(shared, test, shareStreams, workers, blocks);
+      double processRate = runShare(shared, test, shareProcesses, workers, blocks);
+      HipPerf::writeResult("hipPerfMultiProcess", test,
+                           std::to_string(workers) + " streams vs processes, " +
+                               std::to_string(blocks) + " workgroups",
+                           0, workers * kernelsPerStream, "x", streamRate / processRate);
+      test++;
+    }
+  }
+
+  munmap(shared, sizeof(SharedState));
+  passed();
+}
@@ -0,0 +1,208 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Whether hipStreamAttachMemAsync gives managed memory the per stream
+// concurrency it promises. Four streams own one 16 MB hipMallocManaged
+// buffer each, left as allocated or attached with hipMemAttachGlobal,
+// hipMemAttachSingle (to its own stream) or hipMemAttachHost. Throughput
+// runs ten read-modify-write kernels per stream on its buffer concurrently
+// and reports the aggregate GB/s. Host access launches a 20 ms kernel on
+// three streams and a short one on the first, synchronizes the first stream
+// and writes its buffer from the host; the time until the write is done
+// should be near the short kernel with single stream attachment and near the
+// long kernels whenever host access waits for the whole device. Attaching to
+// the host needs concurrent managed access for the kernels and is skipped
+// without it, as are devices without managed memory.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum AttachMode { attachNone = 0, attachGlobal, attachSingle, attachHost, numAttachModes };
+static const char* attachModeStr[numAttachModes] = {"not attached", "hipMemAttachGlobal",
+                                                    "hipMemAttachSingle", "hipMemAttachHost"};
+static const unsigned int attachFlags[numAttachModes] = {0, hipMemAttachGlobal,
+                                                         hipMemAttachSingle, hipMemAttachHost};
+
+enum AttachWorkload { workloadThroughput = 0, workloadHostAccess, numAttachWorkloads };
+
+static const unsigned int numStreams = 4;
+static const size_t bufferFloats = 4 * 1024 * 1024;
+static const unsigned int kernelsPerStream = 10;
+static const unsigned int longKernelUs = 20000;
+static const unsigned int blockSize = 256;
+static const unsigned int blocksPerCu = 2;
+
+__global__ void scaleBuffer(float* buf, size_t n) {
+  for (size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x; i < n;
+       i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+    buf[i] = buf[i] * 0.5f + 1.0f;
+  }
+}
+
+__global__ void spinOnBuffer(float* buf, unsigned long long spinTicks) {
+  unsigned long long start = wall_clock64();
+  while (wall_clock64() - start < spinTicks) {
+  }
+  buf[threadIdx.x] = 1.0f;
+}
+
+class hipPerfStreamAttach : public HipPerf::Benchmark {
+ public:
+  hipPerfStreamAttach() : HipPerf::Benchmark("hipPerfStreamAttach"), wallRateKHz_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&wallRateKHz_, hipDeviceAttributeWallClockRate, deviceId));
+    for (unsigned int s = 0; s < numStreams; s++) {
+      HIPCHECK(hipStreamCreateWithFlags(&streams_[s], hipStreamNonBlocking));
+    }
+    if (props_.managedMemory == 0) {
+      printf("info: device %d has no managed memory support, skipping\n", deviceId);
+    }
+  }
+
+  void close() override {
+    for (unsigned int s = 0; s < numStreams; s++) {
+      HIPCHECK(hipStreamDestroy(streams_[s]));
+    }
+  }
+
+  unsigned int numTests() override { return numAttachModes * numAttachWorkloads; }
+
+  void run(unsigned int test) override {
+    AttachMode mode = static_cast<AttachMode>(test % numAttachModes);
+    AttachWorkload workload = static_cast<AttachWorkload>(test / numAttachModes);
+    if (props_.managedMemory == 0) {
+      return;
+    }
+    if (mode == attachHost && props_.concurrentManagedAccess == 0) {
+      printf("info: %s needs concurrent managed access, skipping\n", attachModeStr[mode]);
+      return;
+    }
+
+    float* buffers[numStreams];
+    for (unsigned int s = 0; s < numStreams; s++) {
+      HIPCHECK(hipMallocManaged(&buffers[s], bufferFloats * sizeof(float)));
+      memset(buffers[s], 0, bufferFloats * sizeof(float));
+    }
+    bool attached = true;
+    for (unsigned int s = 0; s < numStreams && mode != attachNone; s++) {
+      hipError_t err = hipStreamAttachMemAsync(streams_[s], buffers[s], 0, attachFlags[mode]);
+      if (err != hipSuccess) {
+        printf("info: %s returned %s, skipping\n", attachModeStr[mode], hipGetErrorString(err));
+        attached = false;
+        break;
+      }
+    }
+    for (unsigned int s = 0; s < numStreams; s++) {
+      HIPCHECK(hipStreamSynchronize(streams_[s]));
+    }
+
+    if (attached) {
+      if (workload == workloadThroughput) {
+        runThroughput(test, mode, buffers);
+      } else {
+        runHostAccess(test, mode, buffers);
+      }
+    }
+    for (unsigned int s = 0; s < numStreams; s++) {
+      HIPCHECK(hipFree(buffers[s]));
+    }
+  }
+
+ private:
+  void syncAll() {
+    for (unsigned int s = 0; s < numStreams; s++) {
+      HIPCHECK(hipStreamSynchronize(streams_[s]));
+    }
+  }
+
+  void runThroughput(unsigned int test, AttachMode mode, float* const* buffers) {
+    dim3 grid(props_.multiProcessorCount * blocksPerCu);
+    auto sec = measure([&]() {
+      for (unsigned int k = 0; k < kernelsPerStream; k++) {
+        for (unsigned int s = 0; s < numStreams; s++) {
+          hipLaunchKernelGGL(scaleBuffer, grid, dim3(blockSize), 0, streams_[s], buffers[s],
+                             bufferFloats);
+        }
+      }
+      HIPCHECK(hipGetLastError());
+      syncAll();
+    });
+
+    // Every kernel reads and writes its whole buffer
+    double bytes = 2.0 * bufferFloats * sizeof(float) * kernelsPerStream * numStreams;
+    report(test, std::string(attachModeStr[mode]) + " 4 streams throughput",
+           bufferFloats * sizeof(float), kernelsPerStream, "GB/s",
+           HipPerf::toBandwidth(sec, bytes));
+  }
+
+  void runHostAccess(unsigned int test, AttachMode mode, float* const* buffers) {
+    // wallRateKHz_ is ticks per millisecond
+    unsigned long long spinTicks =
+        static_cast<unsigned long long>(wallRateKHz_) * longKernelUs / 1000;
+    std::vector<double> wait;
+    measure([&]() {
+      for (unsigned int s = 1; s < numStreams; s++) {
+        hipLaunchKernelGGL(spinOnBuffer, dim3(1), dim3(blockSize), 0, streams_[s], buffers[s],
+                           spinTicks);
+      }
+      hipLaunchKernelGGL(spinOnBuffer, dim3(1), dim3(blockSize), 0, streams_[0], buffers[0],
+                         0ull);
+      HIPCHECK(hipGetLastError());
+      auto start = std::chrono::steady_clock::now();
+      HIPCHECK(hipStreamSynchronize(streams_[0]));
+      for (size_t i = 0; i < bufferFloats; i += 1024) {
+        buffers[0][i] = 2.0f;
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      if (!HipPerf::Counters::collecting()) {
+        wait.push_back(elapsed.count());
+      }
+      syncAll();
+    });
+    wait = HipPerf::measuredSamples(wait);
+
+    std::vector<double> share;
+    for (double w : wait) {
+      share.push_back(w * 1e6 / longKernelUs);
+    }
+    std::string desc = std::string(attachModeStr[mode]) + " host write next to 20 ms kernels";
+    report(test, desc, bufferFloats * sizeof(float), 1, "us",
+           HipPerf::toMicroseconds(wait, 1));
+    report(test, desc + " vs kernel length", bufferFloats * sizeof(float), 1, "x", share,
+           HipPerf::betterLower);
+  }
+
+  hipStream_t streams_[numStreams];
+  int wallRateKHz_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfStreamAttach)
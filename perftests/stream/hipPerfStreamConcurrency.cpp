@@ -18,34 +18,16 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp
  * TEST: %t
  * HIT_END
  */
 
 #include <iostream>
 #include <chrono>
-#include "test_common.h"
-#include <hip/hip_vector_types.h>
-
-#ifdef __HIP_PLATFORM_NVIDIA__
-inline __device__ float4 operator*(float s, float4 a)
-{
-  return make_float4(a.x * s, a.y * s, a.z * s, a.w * s);
-}
-inline __device__ float4 operator*(float4 a, float4 b)
-{
-  return make_float4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
-}
-inline __device__ float4 operator+(float4 a, float4 b)
-{
-  return make_float4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
-}
-inline __device__ float4 operator-(float4 a, float4 b)
-{
-  return make_float4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
-}
-#endif
+#include <vector>
+#include "perf_harness.h"
+#include "mandelbrot_kernels.h"
 
 typedef struct {
   double x;
@@ -59,128 +41,6 @@ static coordRec coords[] = {
 
 static unsigned int numCoords = sizeof(coords) / sizeof(coordRec);
 
-__global__ void mandelbrot(uint *out, uint width, float xPos, float yPos,
-         float xStep, float yStep, uint maxIter) {
-  int tid = (blockIdx.x * blockDim.x + threadIdx.x);
-  int i = tid % (width/4);
-  int j = tid / (width/4);
-  int4 veci = make_int4(4*i, 4*i+1, 4*i+2, 4*i+3);
-  int4 vecj = make_int4(j, j, j, j);
-  float4 x0;
-  x0.x = (float)(xPos + xStep*veci.x);
-  x0.y = (float)(xPos + xStep*veci.y);
-  x0.z = (float)(xPos + xStep*veci.z);
-  x0.w = (float)(xPos + xStep*veci.w);
-  float4 y0;
-  y0.x = (float)(yPos + yStep*vecj.x);
-  y0.y = (float)(yPos + yStep*vecj.y);
-  y0.z = (float)(yPos + yStep*vecj.z);
-  y0.w = (float)(yPos + yStep*vecj.w);
-  float4 x = x0;
-  float4 y = y0;
-  uint iter = 0;
-  float4 tmp;
-  int4 stay;
-  int4 ccount = make_int4(0, 0, 0, 0);
-  float4 savx = x;
-  float4 savy = y;
-  stay.x = (x.x*x.x+y.x*y.x) <= (float)(4.0f);
-  stay.y = (x.y*x.y+y.y*y.y) <= (float)(4.0f);
-  stay.z = (x.z*x.z+y.z*y.z) <= (float)(4.0f);
-  stay.w = (x.w*x.w+y.w*y.w) <= (float)(4.0f);
-  for (iter = 0; (stay.x | stay.y | stay.z | stay.w) && (iter < maxIter);
-  iter+=16) {
-    x = savx;
-    y = savy;
-    // Two iterations
-    tmp = x*x + x0 - y*y;
-    y = 2.0f * x * y + y0;
-    x = tmp*tmp + x0 - y*y;
-    y = 2.0f * tmp * y + y0;
-    // Two iterations
-    tmp = x*x + x0 - y*y;
-    y = 2.0f * x * y + y0;
-    x = tmp*tmp + x0 - y*y;
-    y = 2.0f * tmp * y + y0;
-    // Two iterations
-    tmp = x*x + x0 - y*y;
-    y = 2.0f * x * y + y0;
-    x = tmp*tmp + x0 - y*y;
-    y = 2.0f * tmp * y + y0;
-    // Two iterations
-    tmp = x*x + x0 - y*y;
-    y = 2.0f * x * y + y0;
-    x = tmp*tmp + x0 - y*y;
-    y = 2.0f * tmp * y + y0;
-    // Two iterations
-    tmp = x*x + x0 - y*y;
-    y = 2.0f * x * y + y0;
-    x = tmp*tmp + x0 - y*y;
-    y = 2.0f * tmp * y + y0;
-    // Two iterations
-    tmp = x*x + x0 - y*y;
-    y = 2.0f * x * y + y0;
-    x = tmp*tmp + x0 - y*y;
-    y = 2.0f * tmp * y + y0;
-    // Two iterations
-    tmp = x*x + x0 - y*y;
-    y = 2.0f * x * y + y0;
-    x = tmp*tmp + x0 - y*y;
-    y = 2.0f * tmp * y + y0;
-    stay.x = (x.x*x.x+y.x*y.x) <= (float)(4.0f);
-    stay.y = (x.y*x.y+y.y*y.y) <= (float)(4.0f);
-    stay.z = (x.z*x.z+y.z*y.z) <= (float)(4.0f);
-    stay.w = (x.w*x.w+y.w*y.w) <= (float)(4.0f);
-    savx.x = (bool)(stay.x ? x.x : savx.x);
-    savx.y = (bool)(stay.y ? x.y : savx.y);
-    savx.z = (bool)(stay.z ? x.z : savx.z);
-    savx.w = (bool)(stay.w ? x.w : savx.w);
-    savy.x = (bool)(stay.x ? y.x : savy.x);
-    savy.y = (bool)(stay.y ? y.y : savy.y);
-    savy.z = (bool)(stay.z ? y.z : savy.z);
-    savy.w = (bool)(stay.w ? y.w : savy.w);
-    ccount.x -= stay.x*16;
-    ccount.y -= stay.y*16;
-    ccount.z -= stay.z*16;
-    ccount.w -= stay.w*16;
-  }
-  // Handle remainder
-  if (!(stay.x & stay.y & stay.z & stay.w))
-  {
-    iter = 16;
-    do
-    {
-      x = savx;
-      y = savy;
-      stay.x = ((x.x*x.x+y.x*y.x) <= 4.0f) && (ccount.x <  maxIter);
-      stay.y = ((x.y*x.y+y.y*y.y) <= 4.0f) && (ccount.y <  maxIter);
-      stay.z = ((x.z*x.z+y.z*y.z) <= 4.0f) && (ccount.z <  maxIter);
-      stay.w = ((x.w*x.w+y.w*y.w) <= 4.0f) && (ccount.w <  maxIter);
-      tmp = x;
-      x = x*x + x0 - y*y;
-      y = 2.0f*tmp*y + y0;
-      ccount.x += stay.x;
-      ccount.y += stay.y;
-      ccount.z += stay.z;
-      ccount.w += stay.w;
-      iter--;
-      savx.x = (stay.x ? x.x : savx.x);
-      savx.y = (stay.y ? x.y : savx.y);
-      savx.z = (stay.z ? x.z : savx.z);
-      savx.w = (stay.w ? x.w : savx.w);
-      savy.x = (stay.x ? y.x : savy.x);
-      savy.y = (stay.y ? y.y : savy.y);
-      savy.z = (stay.z ? y.z : savy.z);
-      savy.w = (stay.w ? y.w : savy.w);
-    } while ((stay.x | stay.y | stay.z | stay.w) && iter);
-  }
-  uint4 *vecOut = (uint4 *)out;
-  vecOut[tid].x = (uint)(ccount.x);
-  vecOut[tid].y = (uint)(ccount.y);
-  vecOut[tid].z = (uint)(ccount.z);
-  vecOut[tid].w = (uint)(ccount.w);
-}
-
 class hipPerfStreamConcurrency {
   public:
   hipPerfStreamConcurrency();
@@ -202,6 +62,9 @@ class hipPerfStreamConcurrency {
 
   void open(int deviceID);
   void run(unsigned int testCase, unsigned int deviceId);
+  // One kernel of 'blocks' workgroups on each of numStreams streams, reported
+  // next to the effective concurrency against the same kernels run one by one
+  void runScaling(unsigned int testCase, unsigned int numStreams, unsigned int blocks);
   void close(void);
 
   private:
@@ -316,8 +179,11 @@ void hipPerfStreamConcurrency::run(unsigned int testCase,unsigned int deviceId)
   auto all_start = std::chrono::steady_clock::now();
 
   for (uint i = 0; i < numKernels; i++) {
+    HipPerf::Timeline::begin(streams[i % numStreams], "test " + std::to_string(testCase) +
+                             " kernel " + std::to_string(i));
     hipLaunchKernelGGL(mandelbrot, dim3(blocks), dim3(threads_per_block), 0, streams[i%numStreams],
                       dPtr[i], width_, xPos, yPos, xStep, yStep, maxIter);
+    HipPerf::Timeline::end(streams[i % numStreams]);
   }
 
 
@@ -337,8 +203,9 @@ void hipPerfStreamConcurrency::run(unsigned int testCase,unsigned int deviceId)
 
 
   if (testCase != 0) {
-  std::cout <<"Measured time for " << numKernels <<" kernels (s) on " << numStreams <<" stream (s): "
-    << all_kernel_time.count() << std::endl;
+  HipPerf::writeResult("hipPerfStreamConcurrency", testCase, std::to_string(numKernels) +
+                       " kernels on " + std::to_string(numStreams) + " streams", bufSize,
+                       numKernels, "s", all_kernel_time.count());
   }
 
 
@@ -360,6 +227,77 @@ void hipPerfStreamConcurrency::run(unsigned int testCase,unsigned int deviceId)
 }
 
 
+void hipPerfStreamConcurrency::runScaling(unsigned int testCase, unsigned int numStreams,
+                                          unsigned int blocks) {
+  const int threads_per_block = 64;
+  const unsigned int scalingIter = 16384;
+  const unsigned int reps = 5;
+
+  // Every thread computes 4 pixels of a single row
+  unsigned int width = blocks * threads_per_block * 4;
+  size_t size = width * sizeof(uint);
+  float xStep = (float)(coords[0].width / (double)width);
+  float yStep = (float)(-coords[0].width / (double)width);
+  float xPos = (float)(coords[0].x - 0.5 * coords[0].width);
+  float yPos = (float)(coords[0].y + 0.5 * coords[0].width);
+
+  std::vector<hipStream_t> streams(numStreams);
+  std::vector<uint*> dPtr(numStreams);
+  for (uint i = 0; i < numStreams; i++) {
+    HIPCHECK(hipStreamCreate(&streams[i]));
+    HIPCHECK(hipMalloc(&dPtr[i], size));
+  }
+
+  auto launch = [&](uint i) {
+    hipLaunchKernelGGL(mandelbrot, dim3(blocks), dim3(threads_per_block), 0, streams[i],
+                       dPtr[i], width, xPos, yPos, xStep, yStep, scalingIter);
+  };
+
+  // Isolated runtime of one kernel, warmed up first
+  launch(0);
+  HIPCHECK(hipStreamSynchronize(streams[0]));
+  auto start = std::chrono::steady_clock::now();
+  for (uint r = 0; r < reps; r++) {
+    launch(0);
+    HIPCHECK(hipStreamSynchronize(streams[0]));
+  }
+  std::chrono::duration<double> isolated = std::chrono::steady_clock::now() - start;
+  double isolatedSec = isolated.count() / reps;
+
+  for (uint i = 0; i < numStreams; i++) {
+    launch(i);
+  }
+  HIPCHECK(hipDeviceSynchronize());
+  start = std::chrono::steady_clock::now();
+  for (uint r = 0; r < reps; r++) {
+    for (uint i = 0; i < numStreams; i++) {
+      HipPerf::Timeline::begin(streams[i], "test " + std::to_string(testCase) + " rep " +
+                               std::to_string(r) + " stream " + std::to_string(i));
+      launch(i);
+      HipPerf::Timeline::end(streams[i]);
+    }
+    for (uint i = 0; i < numStreams; i++) {
+      HIPCHECK(hipStreamSynchronize(streams[i]));
+    }
+  }
+  std::chrono::duration<double> concurrent = std::chrono::steady_clock::now() - start;
+  double concurrentSec = concurrent.count() / reps;
+
+  std::string desc = std::to_string(numStreams) + " streams x " + std::to_string(blocks) +
+                     " workgroups";
+  HipPerf::writeResult("hipPerfStreamConcurrency", testCase, desc, size * numStreams,
+                       numStreams, "ms", concurrentSec * 1000);
+  HipPerf::writeResult("hipPerfStreamConcurrency", testCase, desc + " effective concurrency",
+                       size * numStreams, numStreams, "x",
+                       numStreams * isolatedSec / concurrentSec);
+
+  for (uint i = 0; i < numStreams; i++) {
+    HIPCHECK(hipStreamDestroy(streams[i]));
+    HIPCHECK(hipFree(dPtr[i]));
+  }
+}
+
+
 void hipPerfStreamConcurrency::setData(void *ptr, unsigned int value) {
   unsigned int *ptr2 = (unsigned int *)ptr;
   for (unsigned int i = 0; i < width_ ; i++) {
@@ -377,8 +315,9 @@ void hipPerfStreamConcurrency::checkData(uint *ptr) {
 
 
 int main(int argc, char* argv[]) {
+  HipTest::parseStandardArguments(argc, argv, true);
   hipPerfStreamConcurrency streamConcurrency;
-  int deviceId = 0;
+  int deviceId = p_gpuDevice;
 
   streamConcurrency.open(deviceId);
 
@@ -427,6 +366,21 @@ int main(int argc, char* argv[]) {
 
   }
 
+  // Scaling from a single workgroup to several waves of the whole device over
+  // 1 to 64 streams; concurrency flattening out as streams grow past the
+  // number of hardware queues shows where they get oversubscribed
+  hipDeviceProp_t props = {0};
+  HIPCHECK(hipGetDeviceProperties(&props, deviceId));
+  unsigned int cus = props.multiProcessorCount;
+  const unsigned int scalingBlocks[] = {1, cus / 8 > 0 ? cus / 8 : 1, cus, cus * 8};
+  unsigned int testCase = 5;
+  for (unsigned int blocks : scalingBlocks) {
+    for (unsigned int numStreams = 1; numStreams <= 64; numStreams *= 2) {
+      streamConcurrency.runScaling(testCase++, numStreams, blocks);
+    }
+  }
+  HipPerf::Timeline::write();
+
 
   passed();
 }
@@ -18,14 +18,22 @@
  */
 
 /* HIT_START
- * BUILD: %t %s ../../src/test_common.cpp
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
  * TEST: %t
  * HIT_END
  */
 
+// The first tests create streams, copy into a set of buffers on each and
+// destroy them again. The sweep tests create and destroy up to 512 streams at
+// once with hipStreamCreate, hipStreamCreateWithFlags(hipStreamNonBlocking)
+// and hipStreamCreateWithPriority and report the cost of each create and
+// destroy. The task tests run small copy tasks, W in flight at a time, either
+// on a stream created and destroyed per task or on streams taken from a pool
+// created up front, to show what a scheduler pays per task for either.
+
 #include <iostream>
 #include <chrono>
-#include "test_common.h"
+#include "perf_harness.h"
 
 using namespace std;
 
@@ -34,37 +42,157 @@ using namespace std;
 #define TotalStreams 4
 #define TotalBufs 4
 
+enum StreamKind { kindDefault, kindNonBlocking, kindPriority, numStreamKinds };
+static const char* streamKindStr[] = {"hipStreamCreate", "WithFlags(NonBlocking)",
+                                      "WithPriority(greatest)"};
+
+static const unsigned int sweepStreams[] = {1, 8, 32, 128, 512};
+static const unsigned int numSweepStreams = sizeof(sweepStreams) / sizeof(sweepStreams[0]);
+
+enum TaskMode { taskCreatePerTask, taskPool, numTaskModes };
+static const char* taskModeStr[] = {"create per task", "stream pool"};
 
-class hipPerfStreamCreateCopyDestroy {
+static const unsigned int tasksInFlight[] = {1, 8, 32, 128};
+static const unsigned int numTasksInFlight = sizeof(tasksInFlight) / sizeof(tasksInFlight[0]);
+// Tasks per repetition, each one BufSize float copy and a stream synchronize
+static const unsigned int TotalTasks = 512;
+
+
+class hipPerfStreamCreateCopyDestroy : public HipPerf::Benchmark {
   private:
     unsigned int numBuffers_;
     unsigned int numStreams_;
     const size_t totalStreams_[TotalStreams];
     const size_t totalBuffers_[TotalBufs];
   public:
-    hipPerfStreamCreateCopyDestroy() : numBuffers_(0), numStreams_(0),
+    hipPerfStreamCreateCopyDestroy() : HipPerf::Benchmark("hipPerfStreamCreateCopyDestroy"),
+                                       numBuffers_(0), numStreams_(0),
                                        totalStreams_{1, 2, 4, 8},
                                        totalBuffers_{1, 100, 1000, 5000} {};
     ~hipPerfStreamCreateCopyDestroy() {};
-    void open(int deviceID);
-    void run(unsigned int testNumber);
+    unsigned int numTests() override {
+      return TotalStreams * TotalBufs + numSweepStreams * numStreamKinds +
+             numTasksInFlight * numTaskModes;
+    }
+    void run(unsigned int testNumber) override;
+
+  private:
+    void runCopies(unsigned int testNumber);
+    void runSweep(unsigned int testNumber);
+    void runTasks(unsigned int testNumber);
+    void createStream(StreamKind kind, hipStream_t* stream);
 };
 
-void hipPerfStreamCreateCopyDestroy::open(int deviceId) {
-  int nGpu = 0;
-  HIPCHECK(hipGetDeviceCount(&nGpu));
-  if (nGpu < 1) {
-    failed("No GPU!");
+void hipPerfStreamCreateCopyDestroy::run(unsigned int testNumber) {
+  if (testNumber < TotalStreams * TotalBufs) {
+    runCopies(testNumber);
+  } else if (testNumber < TotalStreams * TotalBufs + numSweepStreams * numStreamKinds) {
+    runSweep(testNumber);
+  } else {
+    runTasks(testNumber);
+  }
+}
+
+void hipPerfStreamCreateCopyDestroy::createStream(StreamKind kind, hipStream_t* stream) {
+  switch (kind) {
+    case kindDefault:
+      HIPCHECK(hipStreamCreate(stream));
+      break;
+    case kindNonBlocking:
+      HIPCHECK(hipStreamCreateWithFlags(stream, hipStreamNonBlocking));
+      break;
+    default: {
+      int least = 0;
+      int greatest = 0;
+      HIPCHECK(hipDeviceGetStreamPriorityRange(&least, &greatest));
+      HIPCHECK(hipStreamCreateWithPriority(stream, hipStreamDefault, greatest));
+      break;
+    }
   }
+}
 
-  HIPCHECK(hipSetDevice(deviceId));
-  hipDeviceProp_t props = {0};
-  HIPCHECK(hipGetDeviceProperties(&props, deviceId));
-  std::cout << "info: running on bus " << "0x" << props.pciBusID << " " << props.name
-    << " with " << props.multiProcessorCount << " CUs" << " and device id: " << deviceId  << std::endl;
+void hipPerfStreamCreateCopyDestroy::runSweep(unsigned int testNumber) {
+  unsigned int index = testNumber - TotalStreams * TotalBufs;
+  StreamKind kind = static_cast<StreamKind>(index % numStreamKinds);
+  unsigned int count = sweepStreams[index / numStreamKinds];
+  std::vector<hipStream_t> streams(count);
+
+  std::vector<double> createUs;
+  std::vector<double> destroyUs;
+  measure([&]() {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int s = 0; s < count; ++s) {
+      createStream(kind, &streams[s]);
+    }
+    auto created = std::chrono::steady_clock::now();
+    for (unsigned int s = 0; s < count; ++s) {
+      HIPCHECK(hipStreamDestroy(streams[s]));
+    }
+    auto destroyed = std::chrono::steady_clock::now();
+    if (HipPerf::Counters::collecting()) {
+      return;
+    }
+    createUs.push_back(std::chrono::duration<double, std::micro>(created - start).count() / count);
+    destroyUs.push_back(
+        std::chrono::duration<double, std::micro>(destroyed - created).count() / count);
+  });
+
+  report(testNumber, "Create " + std::to_string(count) + " streams " + streamKindStr[kind], 0,
+         count, "us", HipPerf::measuredSamples(createUs));
+  report(testNumber, "Destroy " + std::to_string(count) + " streams " + streamKindStr[kind], 0,
+         count, "us", HipPerf::measuredSamples(destroyUs));
 }
 
-void hipPerfStreamCreateCopyDestroy::run(unsigned int testNumber) {
+void hipPerfStreamCreateCopyDestroy::runTasks(unsigned int testNumber) {
+  unsigned int index = testNumber - TotalStreams * TotalBufs - numSweepStreams * numStreamKinds;
+  TaskMode mode = static_cast<TaskMode>(index % numTaskModes);
+  unsigned int inFlight = tasksInFlight[index / numTaskModes];
+  size_t nBytes = BufSize * sizeof(float);
+
+  // One host and device buffer per task in flight
+  float* hSrc = nullptr;
+  float* dDst = nullptr;
+  HIPCHECK(hipHostMalloc(&hSrc, nBytes * inFlight, hipHostMallocDefault));
+  HIPCHECK(hipMalloc(&dDst, nBytes * inFlight));
+  std::vector<hipStream_t> streams(inFlight);
+  if (mode == taskPool) {
+    for (unsigned int s = 0; s < inFlight; ++s) {
+      HIPCHECK(hipStreamCreateWithFlags(&streams[s], hipStreamNonBlocking));
+    }
+  }
+
+  auto sec = measure([&]() {
+    for (unsigned int t = 0; t < TotalTasks; t += inFlight) {
+      for (unsigned int s = 0; s < inFlight; ++s) {
+        if (mode == taskCreatePerTask) {
+          HIPCHECK(hipStreamCreateWithFlags(&streams[s], hipStreamNonBlocking));
+        }
+        HIPCHECK(hipMemcpyAsync(dDst + s * BufSize, hSrc + s * BufSize, nBytes,
+                                hipMemcpyHostToDevice, streams[s]));
+      }
+      for (unsigned int s = 0; s < inFlight; ++s) {
+        HIPCHECK(hipStreamSynchronize(streams[s]));
+        if (mode == taskCreatePerTask) {
+          HIPCHECK(hipStreamDestroy(streams[s]));
+        }
+      }
+    }
+  });
+
+  if (mode == taskPool) {
+    for (unsigned int s = 0; s < inFlight; ++s) {
+      HIPCHECK(hipStreamDestroy(streams[s]));
+    }
+  }
+  HIPCHECK(hipHostFree(hSrc));
+  HIPCHECK(hipFree(dDst));
+
+  unsigned int tasks = (TotalTasks + inFlight - 1) / inFlight * inFlight;
+  report(testNumber, std::string("Tasks ") + taskModeStr[mode] + " " + std::to_string(inFlight) +
+         " in flight", nBytes, tasks, "us", HipPerf::toMicroseconds(sec, tasks));
+}
+
+void hipPerfStreamCreateCopyDestroy::runCopies(unsigned int testNumber) {
   numStreams_ = totalStreams_[testNumber % TotalStreams];
   size_t iter = Iterations / (numStreams_ * ((size_t)1 << (testNumber / TotalBufs + 1)));
   hipStream_t streams[numStreams_];
@@ -84,8 +212,7 @@ void hipPerfStreamCreateCopyDestroy::run(unsigned int testNumber) {
     hSrc[i] = 1.618f + i;
   }
 
-  auto start = std::chrono::steady_clock::now();
-
+  auto sec = measure([&]() {
   for (size_t i = 0; i < iter; ++i) {
     for (size_t s = 0; s < numStreams_; ++s) {
       HIPCHECK(hipStreamCreate(&streams[s]));
@@ -101,15 +228,15 @@ void hipPerfStreamCreateCopyDestroy::run(unsigned int testNumber) {
       HIPCHECK(hipStreamDestroy(streams[s]));
     }
   }
+  });
 
-  auto end = std::chrono::steady_clock::now();
-  std::chrono::duration<double> diff = end - start;
-
-  auto time = static_cast<float>(diff.count() * 1000 / (iter * numStreams_));
-
-  cout << "Create+Copy+Destroy time for " << numStreams_ << " streams and "
-       << setw(4) << numBuffers_ << " buffers " << " and " << setw(4)
-       << iter << " iterations " << time << " (ms) " << endl;
+  // Milliseconds per created stream
+  std::vector<double> ms;
+  for (double t : sec) {
+    ms.push_back(t * 1000 / (iter * numStreams_));
+  }
+  report(testNumber, "Create+Copy+Destroy " + std::to_string(numStreams_) + " streams " +
+         std::to_string(numBuffers_) + " buffers", nBytes, iter, "ms", ms);
 
   delete [] hSrc;
   for (size_t b = 0; b < numBuffers_; ++b) {
@@ -117,15 +244,4 @@ void hipPerfStreamCreateCopyDestroy::run(unsigned int testNumber) {
   }
 }
 
-int main(int argc, char* argv[]) {
-  hipPerfStreamCreateCopyDestroy streamCCD;
-
-  int deviceId = 0;
-  streamCCD.open(deviceId);
-
-  for (auto testCase = 0; testCase < TotalStreams * TotalBufs; testCase++) {
-    streamCCD.run(testCase);
-  }
-
-  passed();
-}
+HIP_PERF_BENCHMARK(hipPerfStreamCreateCopyDestroy)
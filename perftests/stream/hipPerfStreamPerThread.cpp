@@ -0,0 +1,183 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lpthread
+ * TEST: %t
+ * HIT_END
+ */
+
+// Launch and copy throughput of 1 to N host threads depending on the stream
+// each of them uses: the legacy null stream shared by all threads,
+// hipStreamPerThread, one non-blocking stream per thread, or one blocking
+// stream per thread while thread 0 stays on the null stream. Every thread
+// enqueues a short single workgroup kernel followed by a small pinned
+// hipMemcpyAsync, back to back, and synchronizes its stream at the end.
+// Reported are the kernel + copy pairs per second of all threads together and
+// their speedup over one thread in the same mode. Work on the null stream
+// serializes with every blocking stream, so the last mode shows what a single
+// legacy caller costs everyone else. The compiler option that maps the null
+// stream to the per thread stream is not exercised here; hipStreamPerThread
+// is what it resolves to.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "perf_harness.h"
+
+enum StreamMode { streamNull, streamPerThread, streamNonBlocking, streamBlockingWithNull,
+                  numStreamModes };
+static const char* streamModeStr[] = {"null stream", "hipStreamPerThread",
+                                      "non-blocking streams", "blocking streams + null stream"};
+
+static const unsigned int pairsPerThread = 200;
+static const unsigned int spinIterations = 2000;
+static const size_t copyBytes = 4 * 1024;
+static const unsigned int maxThreads = 64;
+
+// A few microseconds of work in one workgroup, so kernels of different streams can overlap
+__global__ void spinKernel(float* out, unsigned int iterations) {
+  float value = threadIdx.x;
+  for (unsigned int i = 0; i < iterations; i++) {
+    value = value * 0.999f + 0.5f;
+  }
+  out[threadIdx.x] = value;
+}
+
+class hipPerfStreamPerThread : public HipPerf::Benchmark {
+ public:
+  hipPerfStreamPerThread() : HipPerf::Benchmark("hipPerfStreamPerThread"),
+      pairs_(HipPerf::iterationCount(pairsPerThread)) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    unsigned int cores = std::max(1u, std::min(std::thread::hardware_concurrency(), maxThreads));
+    for (unsigned int t = 1; t <= cores; t *= 2) {
+      threadCounts_.push_back(t);
+    }
+    if (threadCounts_.back() != cores) {
+      threadCounts_.push_back(cores);
+    }
+    singleThreadRate_.assign(numStreamModes, 0);
+  }
+
+  unsigned int numTests() override {
+    return static_cast<unsigned int>(threadCounts_.size()) * numStreamModes;
+  }
+
+  void run(unsigned int test) override {
+    StreamMode mode = static_cast<StreamMode>(test % numStreamModes);
+    unsigned int threads = threadCounts_[test / numStreamModes];
+
+    std::vector<void*> host(threads);
+    std::vector<void*> device(threads);
+    std::vector<float*> out(threads);
+    std::vector<hipStream_t> streams(threads, nullptr);
+    for (unsigned int t = 0; t < threads; t++) {
+      HIPCHECK(hipHostMalloc(&host[t], copyBytes));
+      memset(host[t], 0, copyBytes);
+      HIPCHECK(hipMalloc(&device[t], copyBytes));
+      HIPCHECK(hipMalloc(&out[t], 64 * sizeof(float)));
+      if (mode == streamPerThread) {
+        streams[t] = hipStreamPerThread;
+      } else if (mode == streamNonBlocking) {
+        HIPCHECK(hipStreamCreateWithFlags(&streams[t], hipStreamNonBlocking));
+      } else if (mode == streamBlockingWithNull && t > 0) {
+        HIPCHECK(hipStreamCreate(&streams[t]));
+      }
+    }
+
+    std::vector<double> pairsPerSec;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      std::atomic<unsigned int> ready(0);
+      std::atomic<bool> go(false);
+      std::vector<std::thread> workers;
+      for (unsigned int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+          HIPCHECK(hipSetDevice(deviceId_));
+          ready++;
+          while (!go.load()) {
+          }
+          for (unsigned int p = 0; p < pairs_; p++) {
+            hipLaunchKernelGGL(spinKernel, dim3(1), dim3(64), 0, streams[t], out[t],
+                               spinIterations);
+            HIPCHECK(hipMemcpyAsync(device[t], host[t], copyBytes, hipMemcpyHostToDevice,
+                                    streams[t]));
+          }
+          HIPCHECK(hipGetLastError());
+          HIPCHECK(hipStreamSynchronize(streams[t]));
+        });
+      }
+      while (ready.load() < threads) {
+      }
+      auto start = std::chrono::steady_clock::now();
+      go = true;
+      for (auto& worker : workers) {
+        worker.join();
+      }
+      double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                       .count();
+      if (r >= p_warmup) {
+        pairsPerSec.push_back(static_cast<double>(threads) * pairs_ / sec);
+      }
+    }
+
+    for (unsigned int t = 0; t < threads; t++) {
+      if (streams[t] != nullptr && streams[t] != hipStreamPerThread) {
+        HIPCHECK(hipStreamDestroy(streams[t]));
+      }
+      HIPCHECK(hipHostFree(host[t]));
+      HIPCHECK(hipFree(device[t]));
+      HIPCHECK(hipFree(out[t]));
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%2u threads %s", threads, streamModeStr[mode]);
+    report(test, std::string(desc) + " kernel + copy", copyBytes, threads * pairs_, "pairs/s",
+           pairsPerSec);
+    // Thread counts run in increasing order, so one thread of this mode has been measured
+    std::vector<double> sorted(pairsPerSec);
+    std::sort(sorted.begin(), sorted.end());
+    double median = sorted[sorted.size() / 2];
+    if (threads == 1) {
+      singleThreadRate_[mode] = median;
+    }
+    if (singleThreadRate_[mode] > 0) {
+      std::vector<double> speedup;
+      for (double rate : pairsPerSec) {
+        speedup.push_back(rate / singleThreadRate_[mode]);
+      }
+      report(test, std::string(desc) + " speedup over 1 thread", copyBytes, threads * pairs_, "x",
+             speedup);
+    }
+  }
+
+ private:
+  unsigned int pairs_;
+  std::vector<unsigned int> threadCounts_;
+  std::vector<double> singleThreadRate_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfStreamPerThread)
@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Whether stream priorities help a latency-sensitive kernel on a busy GPU.
+// A low-priority stream is kept saturated with long kernels covering every CU
+// while short probe kernels are timed from launch to completion on a stream of
+// the same priority and on a stream of the greatest priority. An idle GPU
+// gives the floor.
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+
+enum ProbeMode { probeIdle = 0, probeEqualPriority, probeHighPriority, numProbeModes };
+
+static const char* probeModeStr[numProbeModes] = {"idle", "equal priority", "high priority"};
+
+__global__ void _floodKernel(float* buf, unsigned int loops) {
+  size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  float v = buf[i];
+  for (unsigned int l = 0; l < loops; l++) {
+    v = v * 0.999f + 0.5f;
+  }
+  buf[i] = v;
+}
+
+__global__ void _probeKernel(float* buf) {
+  if (threadIdx.x == 0) buf[0] += 1.0f;
+}
+
+class hipPerfStreamPriority : public HipPerf::Benchmark {
+ public:
+  hipPerfStreamPriority() : HipPerf::Benchmark("hipPerfStreamPriority"),
+      probes_(HipPerf::iterationCount(200)) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    int least = 0, greatest = 0;
+    HIPCHECK(hipDeviceGetStreamPriorityRange(&least, &greatest));
+    if (least == greatest) {
+      printf("info: device %d has a single stream priority, high priority equals low\n",
+             deviceId);
+    }
+    HIPCHECK(hipStreamCreateWithPriority(&floodStream_, hipStreamNonBlocking, least));
+    HIPCHECK(hipStreamCreateWithPriority(&probeStreams_[probeIdle], hipStreamNonBlocking, least));
+    HIPCHECK(hipStreamCreateWithPriority(&probeStreams_[probeEqualPriority], hipStreamNonBlocking,
+                                         least));
+    HIPCHECK(hipStreamCreateWithPriority(&probeStreams_[probeHighPriority], hipStreamNonBlocking,
+                                         greatest));
+
+    // Several waves of blocks on every CU
+    floodBlocks_ = props_.multiProcessorCount * 8;
+    HIPCHECK(hipMalloc(&floodBuf_, floodBlocks_ * floodThreads_ * sizeof(float)));
+    HIPCHECK(hipMemset(floodBuf_, 0, floodBlocks_ * floodThreads_ * sizeof(float)));
+    HIPCHECK(hipMalloc(&probeBuf_, sizeof(float)));
+  }
+
+  void close() override {
+    HIPCHECK(hipStreamDestroy(floodStream_));
+    for (int i = 0; i < numProbeModes; i++) {
+      HIPCHECK(hipStreamDestroy(probeStreams_[i]));
+    }
+    HIPCHECK(hipFree(floodBuf_));
+    HIPCHECK(hipFree(probeBuf_));
+  }
+
+  unsigned int numTests() override { return numProbeModes; }
+
+  void run(unsigned int test) override {
+    ProbeMode mode = static_cast<ProbeMode>(test);
+    hipStream_t probeStream = probeStreams_[mode];
+
+    auto sec = measureEach([&]() {
+      if (mode != probeIdle) {
+        // Keep the low-priority queue ahead of the probes
+        for (int i = 0; i < 2; i++) {
+          hipLaunchKernelGGL(_floodKernel, dim3(floodBlocks_), dim3(floodThreads_), 0,
+                             floodStream_, floodBuf_, floodLoops_);
+        }
+      }
+      hipLaunchKernelGGL(_probeKernel, dim3(1), dim3(64), 0, probeStream, probeBuf_);
+      HIPCHECK(hipStreamSynchronize(probeStream));
+    }, probes_);
+    HIPCHECK(hipStreamSynchronize(floodStream_));
+
+    report(test, std::string("probe latency ") + probeModeStr[mode], 0, probes_, "us",
+           HipPerf::toMicroseconds(sec, 1));
+  }
+
+ private:
+  unsigned int probes_;
+  unsigned int floodBlocks_;
+  const unsigned int floodThreads_ = 256;
+  const unsigned int floodLoops_ = 1 << 16;
+  hipStream_t floodStream_;
+  hipStream_t probeStreams_[numProbeModes];
+  float* floodBuf_;
+  float* probeBuf_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfStreamPriority)
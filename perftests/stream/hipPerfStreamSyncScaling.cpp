@@ -0,0 +1,217 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Cost of hipStreamQuery, hipStreamSynchronize and hipDeviceSynchronize
+// against the number of live streams, from 1 to 4096 (--sizes replaces the
+// counts). Every live stream is either idle, having completed one kernel, or
+// holds queued work: kernels behind a hipStreamWaitEvent on an event that
+// only completes once the host releases a hipStreamWaitValue32 gate.
+//   - hipStreamQuery on every live stream, the health-check pattern, in us
+//     per stream
+//   - an empty kernel and hipStreamSynchronize on a separate stream
+//   - hipDeviceSynchronize with nothing to wait for (idle), or from the
+//     gate release until all queued kernels drained (queued, us per kernel)
+// Times per stream that grow with the count mean the runtime scans its
+// streams. Streams are kept between tests and only grown; when creation fails
+// the remaining counts are skipped.
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include "perf_harness.h"
+
+static const std::vector<size_t> Counts = {1, 16, 256, 1024, 4096};
+// Kernels queued on every stream behind the gate
+static const unsigned int queueDepth = 4;
+
+enum StreamState { stateIdle = 0, stateQueued, numStreamStates };
+enum SyncOp { opQuery = 0, opStreamSync, opDeviceSync, numSyncOps };
+
+static const char* streamStateStr[numStreamStates] = {"idle", "queued"};
+static const char* syncOpStr[numSyncOps] = {"hipStreamQuery", "hipStreamSynchronize",
+                                            "hipDeviceSynchronize"};
+
+__global__ void _scalingKernel() {}
+
+class hipPerfStreamSyncScaling : public HipPerf::Benchmark {
+ public:
+  hipPerfStreamSyncScaling() : HipPerf::Benchmark("hipPerfStreamSyncScaling"),
+      counts_(HipPerf::sweepSizes(Counts)), count_(HipPerf::iterationCount(1000)),
+      exhausted_(false), waitValue_(0), gate_(nullptr), probe_(nullptr), gateEvent_(nullptr),
+      gateFlag_(nullptr), gateValue_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&waitValue_, hipDeviceAttributeCanUseStreamWaitValue,
+                                   deviceId));
+    HIPCHECK(hipStreamCreateWithFlags(&gate_, hipStreamNonBlocking));
+    HIPCHECK(hipStreamCreateWithFlags(&probe_, hipStreamNonBlocking));
+    HIPCHECK(hipEventCreateWithFlags(&gateEvent_, hipEventDisableTiming));
+    HIPCHECK(hipHostMalloc(&gateFlag_, sizeof(uint32_t), hipHostMallocCoherent));
+    *gateFlag_ = 0;
+  }
+
+  void close() override {
+    for (hipStream_t stream : streams_) {
+      HIPCHECK(hipStreamDestroy(stream));
+    }
+    streams_.clear();
+    HIPCHECK(hipHostFree(gateFlag_));
+    HIPCHECK(hipEventDestroy(gateEvent_));
+    HIPCHECK(hipStreamDestroy(probe_));
+    HIPCHECK(hipStreamDestroy(gate_));
+  }
+
+  unsigned int numTests() override { return counts_.size() * numStreamStates * numSyncOps; }
+
+  void run(unsigned int test) override {
+    // The count varies slowest, so the live streams only grow
+    size_t count = counts_[test / (numStreamStates * numSyncOps)];
+    StreamState state = static_cast<StreamState>((test / numSyncOps) % numStreamStates);
+    SyncOp op = static_cast<SyncOp>(test % numSyncOps);
+
+    if (state == stateQueued && !waitValue_) {
+      printf("info: device %d does not support stream wait value, skipping queued %s\n",
+             deviceId_, syncOpStr[op]);
+      return;
+    }
+    if (exhausted_ || !grow(count)) {
+      return;
+    }
+
+    char desc[96];
+    snprintf(desc, sizeof(desc), "%5zu streams %-6s %s", count, streamStateStr[state],
+             syncOpStr[op]);
+
+    if (op == opDeviceSync && state == stateQueued) {
+      // Arming is not timed, only the release and the drain
+      std::vector<double> us;
+      unsigned int samples = HipPerf::iterationCount(20);
+      for (unsigned int i = 0; i < samples + 1; i++) {
+        armGate();
+        auto start = std::chrono::steady_clock::now();
+        releaseGate();
+        HIPCHECK(hipDeviceSynchronize());
+        std::chrono::duration<double, std::micro> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (i > 0) {
+          us.push_back(elapsed.count() / (count * queueDepth));
+        }
+      }
+      report(test, std::string(desc) + " drain per kernel", 0, samples, "us", us);
+      return;
+    }
+
+    if (state == stateQueued) {
+      armGate();
+    } else {
+      for (hipStream_t stream : streams_) {
+        hipLaunchKernelGGL(_scalingKernel, dim3(1), dim3(1), 0, stream);
+      }
+      HIPCHECK(hipDeviceSynchronize());
+    }
+
+    switch (op) {
+      case opQuery: {
+        auto sec = measure([&]() {
+          for (hipStream_t stream : streams_) {
+            hipError_t err = hipStreamQuery(stream);
+            if (err != hipErrorNotReady) {
+              HIPCHECK(err);
+            }
+          }
+        });
+        report(test, std::string(desc) + " per stream", 0, streams_.size(), "us",
+               HipPerf::toMicroseconds(sec, streams_.size()));
+        break;
+      }
+      case opStreamSync: {
+        auto sec = measureEach([&]() {
+          hipLaunchKernelGGL(_scalingKernel, dim3(1), dim3(1), 0, probe_);
+          HIPCHECK(hipStreamSynchronize(probe_));
+        }, count_);
+        report(test, desc, 0, count_, "us", HipPerf::toMicroseconds(sec, 1));
+        break;
+      }
+      default: {
+        auto sec = measureEach([&]() { HIPCHECK(hipDeviceSynchronize()); }, count_);
+        report(test, desc, 0, count_, "us", HipPerf::toMicroseconds(sec, 1));
+        break;
+      }
+    }
+
+    if (state == stateQueued) {
+      releaseGate();
+      HIPCHECK(hipDeviceSynchronize());
+    }
+  }
+
+ private:
+  // Creates streams until count are live, false when the runtime runs out of them.
+  bool grow(size_t count) {
+    while (streams_.size() < count) {
+      hipStream_t stream;
+      hipError_t err = hipStreamCreateWithFlags(&stream, hipStreamNonBlocking);
+      if (err != hipSuccess) {
+        printf("info: stream creation failed with %s after %zu streams, skipping larger counts\n",
+               hipGetErrorString(err), streams_.size());
+        (void)hipGetLastError();
+        exhausted_ = true;
+        return false;
+      }
+      streams_.push_back(stream);
+    }
+    return true;
+  }
+
+  // Queues queueDepth kernels on every live stream that cannot start before releaseGate().
+  void armGate() {
+    gateValue_++;
+    HIPCHECK(hipStreamWaitValue32(gate_, gateFlag_, gateValue_, hipStreamWaitValueGte));
+    HIPCHECK(hipEventRecord(gateEvent_, gate_));
+    for (hipStream_t stream : streams_) {
+      HIPCHECK(hipStreamWaitEvent(stream, gateEvent_, 0));
+      for (unsigned int i = 0; i < queueDepth; i++) {
+        hipLaunchKernelGGL(_scalingKernel, dim3(1), dim3(1), 0, stream);
+      }
+    }
+  }
+
+  void releaseGate() { *static_cast<volatile uint32_t*>(gateFlag_) = gateValue_; }
+
+  std::vector<size_t> counts_;
+  unsigned int count_;
+  bool exhausted_;
+  int waitValue_;
+  std::vector<hipStream_t> streams_;
+  hipStream_t gate_;
+  hipStream_t probe_;
+  hipEvent_t gateEvent_;
+  uint32_t* gateFlag_;
+  uint32_t gateValue_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfStreamSyncScaling)
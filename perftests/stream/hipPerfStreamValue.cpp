@@ -0,0 +1,201 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp
+ * TEST: %t
+ * HIT_END
+ */
+
+// Signaling latency between host and GPU through stream memory operations.
+//
+// GPU to host: the stream writes a value with hipStreamWriteValue32/64 and the
+// host polls for it; an event recorded on the stream and polled with
+// hipEventQuery is the baseline. Host to GPU: the stream blocks in
+// hipStreamWaitValue32/64 until the host writes the flag, then answers through
+// a pinned flag the host polls, so the sample is a full ping-pong. The flag
+// lives in pinned host memory or in device memory; device memory is accessed
+// by the host with hipMemcpyAsync on a side stream.
+
+#include <stdio.h>
+
+#include "perf_harness.h"
+
+enum SignalKind { signalWrite32 = 0, signalWrite64, signalEvent, pingPong32, pingPong64 };
+enum FlagMemory { flagPinned = 0, flagDevice };
+
+struct SignalTest {
+  SignalKind kind;
+  FlagMemory memory;
+};
+
+static const SignalTest signalTests[] = {
+    {signalWrite32, flagPinned}, {signalWrite64, flagPinned}, {signalWrite32, flagDevice},
+    {signalWrite64, flagDevice}, {signalEvent, flagPinned},   {pingPong32, flagPinned},
+    {pingPong64, flagPinned},    {pingPong32, flagDevice},    {pingPong64, flagDevice},
+};
+static const unsigned int numSignalTests = sizeof(signalTests) / sizeof(signalTests[0]);
+
+static const char* signalKindStr[] = {"GPU->host hipStreamWriteValue32",
+                                      "GPU->host hipStreamWriteValue64",
+                                      "GPU->host hipEventQuery",
+                                      "host->GPU->host hipStreamWaitValue32",
+                                      "host->GPU->host hipStreamWaitValue64"};
+static const char* flagMemoryStr[] = {"pinned", "device"};
+
+class hipPerfStreamValue : public HipPerf::Benchmark {
+ public:
+  hipPerfStreamValue() : HipPerf::Benchmark("hipPerfStreamValue"),
+      count_(HipPerf::iterationCount(10000)), seq_(0), supported_(0) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipDeviceGetAttribute(&supported_, hipDeviceAttributeCanUseStreamWaitValue,
+                                   deviceId));
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    HIPCHECK(hipStreamCreateWithFlags(&sideStream_, hipStreamNonBlocking));
+    HIPCHECK(hipEventCreateWithFlags(&event_, hipEventDisableTiming));
+    HIPCHECK(hipHostMalloc(&pinnedFlag_, sizeof(uint64_t), hipHostMallocCoherent));
+    HIPCHECK(hipHostMalloc(&responseFlag_, sizeof(uint64_t), hipHostMallocCoherent));
+    HIPCHECK(hipMalloc(&deviceFlag_, sizeof(uint64_t)));
+    *pinnedFlag_ = *responseFlag_ = 0;
+    HIPCHECK(hipMemset(deviceFlag_, 0, sizeof(uint64_t)));
+  }
+
+  void close() override {
+    HIPCHECK(hipHostFree(pinnedFlag_));
+    HIPCHECK(hipHostFree(responseFlag_));
+    HIPCHECK(hipFree(deviceFlag_));
+    HIPCHECK(hipEventDestroy(event_));
+    HIPCHECK(hipStreamDestroy(sideStream_));
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numSignalTests; }
+
+  void run(unsigned int test) override {
+    const SignalTest& t = signalTests[test];
+    bool wide = t.kind == signalWrite64 || t.kind == pingPong64;
+    if (!supported_ && t.kind != signalEvent) {
+      printf("info: device %d does not support stream wait/write value, skipping %s\n",
+             deviceId_, signalKindStr[t.kind]);
+      return;
+    }
+    uint64_t* flag = t.memory == flagPinned ? pinnedFlag_ : deviceFlag_;
+
+    std::vector<double> sec;
+    switch (t.kind) {
+      case signalEvent:
+        sec = measureEach([&]() {
+          HIPCHECK(hipEventRecord(event_, stream_));
+          hipError_t err;
+          do {
+            err = hipEventQuery(event_);
+          } while (err == hipErrorNotReady);
+          HIPCHECK(err);
+        }, count_);
+        break;
+      case signalWrite32:
+      case signalWrite64:
+        sec = measureEach([&]() {
+          uint64_t value = nextValue(wide);
+          writeValue(stream_, flag, value, wide);
+          while (readFlag(flag, t.memory, wide) != value) {
+          }
+        }, count_);
+        break;
+      default:
+        sec = measureEach([&]() {
+          uint64_t value = nextValue(wide);
+          if (wide) {
+            HIPCHECK(hipStreamWaitValue64(stream_, flag, value, hipStreamWaitValueEq));
+          } else {
+            HIPCHECK(hipStreamWaitValue32(stream_, flag, static_cast<uint32_t>(value),
+                                          hipStreamWaitValueEq));
+          }
+          writeValue(stream_, responseFlag_, value, wide);
+          writeFlag(flag, t.memory, value);
+          while (readFlag(responseFlag_, flagPinned, wide) != value) {
+          }
+        }, count_);
+        break;
+    }
+    HIPCHECK(hipStreamSynchronize(stream_));
+
+    char desc[96];
+    if (t.kind == signalEvent) {
+      snprintf(desc, sizeof(desc), "%s", signalKindStr[t.kind]);
+    } else {
+      snprintf(desc, sizeof(desc), "%s %s", signalKindStr[t.kind], flagMemoryStr[t.memory]);
+    }
+    report(test, desc, 0, count_, "us", HipPerf::toMicroseconds(sec, 1));
+  }
+
+ private:
+  // Never zero, and for the 32 bit variants never wider than 32 bits.
+  uint64_t nextValue(bool wide) {
+    seq_++;
+    if (!wide) {
+      seq_ = static_cast<uint32_t>(seq_) == 0 ? 1 : static_cast<uint32_t>(seq_);
+    }
+    return seq_;
+  }
+
+  void writeValue(hipStream_t stream, uint64_t* ptr, uint64_t value, bool wide) {
+    if (wide) {
+      HIPCHECK(hipStreamWriteValue64(stream, ptr, value, 0));
+    } else {
+      HIPCHECK(hipStreamWriteValue32(stream, ptr, static_cast<uint32_t>(value), 0));
+    }
+  }
+
+  // 32 bit writes only touch the low half, the high half may be left over
+  // from a 64 bit test.
+  uint64_t readFlag(uint64_t* ptr, FlagMemory memory, bool wide) {
+    uint64_t value;
+    if (memory == flagPinned) {
+      value = *static_cast<volatile uint64_t*>(ptr);
+    } else {
+      HIPCHECK(hipMemcpyAsync(&value, ptr, sizeof(value), hipMemcpyDeviceToHost, sideStream_));
+      HIPCHECK(hipStreamSynchronize(sideStream_));
+    }
+    return wide ? value : static_cast<uint32_t>(value);
+  }
+
+  void writeFlag(uint64_t* ptr, FlagMemory memory, uint64_t value) {
+    if (memory == flagPinned) {
+      *static_cast<volatile uint64_t*>(ptr) = value;
+    } else {
+      HIPCHECK(hipMemcpyAsync(ptr, &value, sizeof(value), hipMemcpyHostToDevice, sideStream_));
+      HIPCHECK(hipStreamSynchronize(sideStream_));
+    }
+  }
+
+  unsigned int count_;
+  uint64_t seq_;
+  int supported_;
+  hipStream_t stream_;
+  hipStream_t sideStream_;
+  hipEvent_t event_;
+  uint64_t* pinnedFlag_;
+  uint64_t* responseFlag_;
+  uint64_t* deviceFlag_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfStreamValue)
@@ -0,0 +1,455 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* HIT_START
+ * BUILD: %t %s ../../src/test_common.cpp ../../src/timer.cpp ../../src/perf_harness.cpp ../../src/perf_main.cpp -lvulkan
+ * TEST: %t
+ * HIT_END
+ */
+
+// Headless compute-then-render handoff between HIP and Vulkan. A device local
+// Vulkan buffer of one RGBA8 frame (720p, 1080p, 4K) and two binary
+// semaphores are exported as opaque fds and imported with
+// hipImportExternalMemory and hipImportExternalSemaphore. Every frame HIP
+// waits for the Vulkan semaphore, post-processes the frame with a kernel and
+// signals the HIP semaphore; the Vulkan queue waits for it, copies the frame
+// into a buffer of its own as a stand-in for rendering and signals back. The
+// round trip test synchronizes the host after every frame, the pipelined test
+// only after all frames and reports frames/s together with the host time of
+// the hipWaitExternalSemaphoresAsync and hipSignalExternalSemaphoresAsync
+// calls. Skipped when no Vulkan device with external memory and semaphore fd
+// support is found.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "perf_harness.h"
+
+#define VKCHECK(result)                                                                         \
+  {                                                                                             \
+    VkResult localResult = result;                                                              \
+    if (localResult != VK_SUCCESS) {                                                            \
+      failed("Vulkan error %d from %s at %s:%d\n", localResult, #result, __FILE__, __LINE__);    \
+    }                                                                                           \
+  }
+
+enum FrameMode { frameRoundTrip, framePipelined, numFrameModes };
+static const char* frameModeStr[] = {"round trip", "pipelined"};
+
+struct FrameSize {
+  const char* name;
+  unsigned int width;
+  unsigned int height;
+};
+
+static const FrameSize frameSizes[] = {{"720p", 1280, 720}, {"1080p", 1920, 1080},
+                                       {"4K", 3840, 2160}};
+static const unsigned int numFrameSizes = sizeof(frameSizes) / sizeof(frameSizes[0]);
+
+static const unsigned int framesPerRun = 100;
+
+// Inverts the color channels, one pixel per thread
+__global__ void postProcessKernel(unsigned int* pixels, size_t n) {
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < n; i += gridDim.x * blockDim.x) {
+    pixels[i] ^= 0x00ffffffu;
+  }
+}
+
+class hipPerfVulkanInterop : public HipPerf::Benchmark {
+ public:
+  hipPerfVulkanInterop() : HipPerf::Benchmark("hipPerfVulkanInterop"), available_(false),
+      instance_(VK_NULL_HANDLE), physical_(VK_NULL_HANDLE), device_(VK_NULL_HANDLE),
+      queue_(VK_NULL_HANDLE), pool_(VK_NULL_HANDLE), queueFamily_(0), stream_(nullptr) {}
+
+  void open(int deviceId) override {
+    HipPerf::Benchmark::open(deviceId);
+    HIPCHECK(hipStreamCreateWithFlags(&stream_, hipStreamNonBlocking));
+    available_ = createDevice();
+    if (!available_) {
+      printf("info: no Vulkan device with external memory and semaphore fds, skipping\n");
+    }
+  }
+
+  void close() override {
+    if (device_ != VK_NULL_HANDLE) {
+      vkDestroyCommandPool(device_, pool_, nullptr);
+      vkDestroyDevice(device_, nullptr);
+    }
+    if (instance_ != VK_NULL_HANDLE) {
+      vkDestroyInstance(instance_, nullptr);
+    }
+    HIPCHECK(hipStreamDestroy(stream_));
+  }
+
+  unsigned int numTests() override { return numFrameSizes * numFrameModes; }
+
+  void run(unsigned int test) override {
+    if (!available_) {
+      return;
+    }
+    FrameMode mode = static_cast<FrameMode>(test % numFrameModes);
+    const FrameSize& frame = frameSizes[test / numFrameModes];
+    size_t pixels = static_cast<size_t>(frame.width) * frame.height;
+    VkDeviceSize bytes = pixels * sizeof(unsigned int);
+
+    // Shared frame, exported to HIP, and the Vulkan side copy target
+    VkBuffer shared = createBuffer(bytes, true);
+    VkDeviceMemory sharedMemory = allocate(shared, true);
+    VkBuffer target = createBuffer(bytes, false);
+    VkDeviceMemory targetMemory = allocate(target, false);
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device_, shared, &requirements);
+    hipExternalMemoryHandleDesc memoryDesc = {};
+    memoryDesc.type = hipExternalMemoryHandleTypeOpaqueFd;
+    memoryDesc.handle.fd = memoryFd(sharedMemory);
+    memoryDesc.size = requirements.size;
+    hipExternalMemory_t externalMemory;
+    HIPCHECK(hipImportExternalMemory(&externalMemory, &memoryDesc));
+    hipExternalMemoryBufferDesc bufferDesc = {};
+    bufferDesc.offset = 0;
+    bufferDesc.size = bytes;
+    void* frameData = nullptr;
+    HIPCHECK(hipExternalMemoryGetMappedBuffer(&frameData, externalMemory, &bufferDesc));
+
+    VkSemaphore hipDone = createSemaphore();
+    VkSemaphore vkDone = createSemaphore();
+    hipExternalSemaphore_t hipDoneExternal = importSemaphore(hipDone);
+    hipExternalSemaphore_t vkDoneExternal = importSemaphore(vkDone);
+
+    VkCommandBuffer commands = recordCopy(shared, target, bytes);
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkSubmitInfo submit = {};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.waitSemaphoreCount = 1;
+    submit.pWaitSemaphores = &hipDone;
+    submit.pWaitDstStageMask = &waitStage;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &commands;
+    submit.signalSemaphoreCount = 1;
+    submit.pSignalSemaphores = &vkDone;
+
+    hipExternalSemaphoreWaitParams waitParams = {};
+    hipExternalSemaphoreSignalParams signalParams = {};
+    unsigned int blocks = static_cast<unsigned int>(std::min<size_t>((pixels + 255) / 256, 4096));
+
+    std::vector<double> frameSec;
+    std::vector<double> waitUs;
+    std::vector<double> signalUs;
+    for (unsigned int r = 0; r < p_warmup + p_repetitions; r++) {
+      double waitSec = 0;
+      double signalSec = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (unsigned int f = 0; f < framesPerRun; f++) {
+        // The Vulkan semaphore is pending from the last frame, except for the first
+        if (f > 0 && mode == framePipelined) {
+          auto before = std::chrono::steady_clock::now();
+          HIPCHECK(hipWaitExternalSemaphoresAsync(&vkDoneExternal, &waitParams, 1, stream_));
+          waitSec += std::chrono::duration<double>(std::chrono::steady_clock::now() - before)
+                         .count();
+        }
+        hipLaunchKernelGGL(postProcessKernel, dim3(blocks), dim3(256), 0, stream_,
+                           static_cast<unsigned int*>(frameData), pixels);
+        HIPCHECK(hipGetLastError());
+        auto before = std::chrono::steady_clock::now();
+        HIPCHECK(hipSignalExternalSemaphoresAsync(&hipDoneExternal, &signalParams, 1, stream_));
+        signalSec += std::chrono::duration<double>(std::chrono::steady_clock::now() - before)
+                         .count();
+        VKCHECK(vkQueueSubmit(queue_, 1, &submit, VK_NULL_HANDLE));
+        if (mode == frameRoundTrip) {
+          before = std::chrono::steady_clock::now();
+          HIPCHECK(hipWaitExternalSemaphoresAsync(&vkDoneExternal, &waitParams, 1, stream_));
+          waitSec += std::chrono::duration<double>(std::chrono::steady_clock::now() - before)
+                         .count();
+          HIPCHECK(hipStreamSynchronize(stream_));
+        }
+      }
+      if (mode == framePipelined) {
+        HIPCHECK(hipWaitExternalSemaphoresAsync(&vkDoneExternal, &waitParams, 1, stream_));
+        HIPCHECK(hipStreamSynchronize(stream_));
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      if (r >= p_warmup) {
+        frameSec.push_back(elapsed.count());
+        waitUs.push_back(waitSec * 1e6 / (mode == framePipelined ? framesPerRun - 1
+                                                                  : framesPerRun));
+        signalUs.push_back(signalSec * 1e6 / framesPerRun);
+      }
+    }
+    VKCHECK(vkQueueWaitIdle(queue_));
+
+    HIPCHECK(hipDestroyExternalSemaphore(hipDoneExternal));
+    HIPCHECK(hipDestroyExternalSemaphore(vkDoneExternal));
+    HIPCHECK(hipDestroyExternalMemory(externalMemory));
+    vkFreeCommandBuffers(device_, pool_, 1, &commands);
+    vkDestroySemaphore(device_, hipDone, nullptr);
+    vkDestroySemaphore(device_, vkDone, nullptr);
+    vkDestroyBuffer(device_, shared, nullptr);
+    vkFreeMemory(device_, sharedMemory, nullptr);
+    vkDestroyBuffer(device_, target, nullptr);
+    vkFreeMemory(device_, targetMemory, nullptr);
+
+    char desc[64];
+    snprintf(desc, sizeof(desc), "%-5s %s", frame.name, frameModeStr[mode]);
+    if (mode == frameRoundTrip) {
+      report(test, std::string(desc) + " frame", bytes, framesPerRun, "us",
+             HipPerf::toMicroseconds(frameSec, framesPerRun));
+    } else {
+      std::vector<double> fps;
+      for (double sec : frameSec) {
+        fps.push_back(framesPerRun / sec);
+      }
+      report(test, desc, bytes, framesPerRun, "frames/s", fps);
+    }
+    report(test, std::string(desc) + " hipWaitExternalSemaphoresAsync", bytes, framesPerRun,
+           "us", waitUs);
+    report(test, std::string(desc) + " hipSignalExternalSemaphoresAsync", bytes, framesPerRun,
+           "us", signalUs);
+  }
+
+ private:
+  static bool hasExtensions(const std::vector<VkExtensionProperties>& supported,
+                            const std::vector<const char*>& required) {
+    for (const char* name : required) {
+      bool found = false;
+      for (const auto& properties : supported) {
+        found = found || strcmp(properties.extensionName, name) == 0;
+      }
+      if (!found) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Creates instance, device, queue and command pool, false when unsupported
+  bool createDevice() {
+    std::vector<const char*> instanceExtensions = {
+        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
+        VK_KHR_EXTERNAL_SEMAPHORE_CAPABILITIES_EXTENSION_NAME,
+        VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME};
+    uint32_t count = 0;
+    if (vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr) != VK_SUCCESS) {
+      return false;
+    }
+    std::vector<VkExtensionProperties> supported(count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &count, supported.data());
+    if (!hasExtensions(supported, instanceExtensions)) {
+      return false;
+    }
+
+    VkApplicationInfo appInfo = {};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.apiVersion = VK_API_VERSION_1_1;
+    VkInstanceCreateInfo instanceInfo = {};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &appInfo;
+    instanceInfo.enabledExtensionCount = static_cast<uint32_t>(instanceExtensions.size());
+    instanceInfo.ppEnabledExtensionNames = instanceExtensions.data();
+    if (vkCreateInstance(&instanceInfo, nullptr, &instance_) != VK_SUCCESS) {
+      instance_ = VK_NULL_HANDLE;
+      return false;
+    }
+
+    count = 0;
+    vkEnumeratePhysicalDevices(instance_, &count, nullptr);
+    if (count == 0) {
+      return false;
+    }
+    std::vector<VkPhysicalDevice> physicals(count);
+    vkEnumeratePhysicalDevices(instance_, &count, physicals.data());
+    physical_ = physicals[0];
+
+    std::vector<const char*> deviceExtensions = {
+        VK_KHR_EXTERNAL_SEMAPHORE_EXTENSION_NAME, VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME,
+        VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME, VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME};
+    count = 0;
+    vkEnumerateDeviceExtensionProperties(physical_, nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> deviceSupported(count);
+    vkEnumerateDeviceExtensionProperties(physical_, nullptr, &count, deviceSupported.data());
+    if (!hasExtensions(deviceSupported, deviceExtensions)) {
+      return false;
+    }
+
+    // Any queue that can copy, compute queues can
+    count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_, &count, families.data());
+    queueFamily_ = count;
+    for (uint32_t i = 0; i < count && queueFamily_ == count; i++) {
+      if (families[i].queueCount > 0 && (families[i].queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+        queueFamily_ = i;
+      }
+    }
+    if (queueFamily_ == count) {
+      return false;
+    }
+
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = queueFamily_;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+    VkDeviceCreateInfo deviceInfo = {};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    deviceInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+    deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    VKCHECK(vkCreateDevice(physical_, &deviceInfo, nullptr, &device_));
+    vkGetDeviceQueue(device_, queueFamily_, 0, &queue_);
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamily_;
+    VKCHECK(vkCreateCommandPool(device_, &poolInfo, nullptr, &pool_));
+    return true;
+  }
+
+  VkBuffer createBuffer(VkDeviceSize bytes, bool exported) {
+    VkExternalMemoryBufferCreateInfo externalInfo = {};
+    externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+    externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.pNext = exported ? &externalInfo : nullptr;
+    bufferInfo.size = bytes;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer buffer;
+    VKCHECK(vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer));
+    return buffer;
+  }
+
+  // Device local memory bound to buffer, exportable as an opaque fd when asked
+  VkDeviceMemory allocate(VkBuffer buffer, bool exported) {
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device_, buffer, &requirements);
+    VkPhysicalDeviceMemoryProperties properties;
+    vkGetPhysicalDeviceMemoryProperties(physical_, &properties);
+    uint32_t type = VK_MAX_MEMORY_TYPES;
+    for (uint32_t i = 0; i < properties.memoryTypeCount && type == VK_MAX_MEMORY_TYPES; i++) {
+      if ((requirements.memoryTypeBits & (1u << i)) &&
+          (properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+        type = i;
+      }
+    }
+    if (type == VK_MAX_MEMORY_TYPES) {
+      failed("no device local Vulkan memory type for the frame buffer");
+    }
+
+    VkExportMemoryAllocateInfo exportInfo = {};
+    exportInfo.sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO;
+    exportInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.pNext = exported ? &exportInfo : nullptr;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = type;
+    VkDeviceMemory memory;
+    VKCHECK(vkAllocateMemory(device_, &allocateInfo, nullptr, &memory));
+    VKCHECK(vkBindBufferMemory(device_, buffer, memory, 0));
+    return memory;
+  }
+
+  int memoryFd(VkDeviceMemory memory) {
+    auto getMemoryFd =
+        reinterpret_cast<PFN_vkGetMemoryFdKHR>(vkGetDeviceProcAddr(device_, "vkGetMemoryFdKHR"));
+    if (getMemoryFd == nullptr) {
+      failed("vkGetMemoryFdKHR is not available");
+    }
+    VkMemoryGetFdInfoKHR fdInfo = {};
+    fdInfo.sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR;
+    fdInfo.memory = memory;
+    fdInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
+    int fd = -1;
+    VKCHECK(getMemoryFd(device_, &fdInfo, &fd));
+    return fd;
+  }
+
+  VkSemaphore createSemaphore() {
+    VkExportSemaphoreCreateInfo exportInfo = {};
+    exportInfo.sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO;
+    exportInfo.handleTypes = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &exportInfo;
+    VkSemaphore semaphore;
+    VKCHECK(vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &semaphore));
+    return semaphore;
+  }
+
+  hipExternalSemaphore_t importSemaphore(VkSemaphore semaphore) {
+    auto getSemaphoreFd = reinterpret_cast<PFN_vkGetSemaphoreFdKHR>(
+        vkGetDeviceProcAddr(device_, "vkGetSemaphoreFdKHR"));
+    if (getSemaphoreFd == nullptr) {
+      failed("vkGetSemaphoreFdKHR is not available");
+    }
+    VkSemaphoreGetFdInfoKHR fdInfo = {};
+    fdInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR;
+    fdInfo.semaphore = semaphore;
+    fdInfo.handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+    hipExternalSemaphoreHandleDesc desc = {};
+    desc.type = hipExternalSemaphoreHandleTypeOpaqueFd;
+    VKCHECK(getSemaphoreFd(device_, &fdInfo, &desc.handle.fd));
+    hipExternalSemaphore_t external;
+    HIPCHECK(hipImportExternalSemaphore(&external, &desc));
+    return external;
+  }
+
+  // Copy of the whole frame, submitted once per frame
+  VkCommandBuffer recordCopy(VkBuffer src, VkBuffer dst, VkDeviceSize bytes) {
+    VkCommandBufferAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.commandPool = pool_;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = 1;
+    VkCommandBuffer commands;
+    VKCHECK(vkAllocateCommandBuffers(device_, &allocateInfo, &commands));
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    VKCHECK(vkBeginCommandBuffer(commands, &beginInfo));
+    VkBufferCopy region = {};
+    region.size = bytes;
+    vkCmdCopyBuffer(commands, src, dst, 1, &region);
+    VKCHECK(vkEndCommandBuffer(commands));
+    return commands;
+  }
+
+  bool available_;
+  VkInstance instance_;
+  VkPhysicalDevice physical_;
+  VkDevice device_;
+  VkQueue queue_;
+  VkCommandPool pool_;
+  uint32_t queueFamily_;
+  hipStream_t stream_;
+};
+
+HIP_PERF_BENCHMARK(hipPerfVulkanInterop)
@@ -21,6 +21,7 @@ THE SOFTWARE.
 */
 #include "test_common.h"
 
+#include <string>
 #include <thread>
 #ifdef __linux__
 #include <sys/sysinfo.h>
@@ -34,7 +35,21 @@ char memsetval = 0x42;
 int memsetD32val = 0xDEADBEEF;
 short memsetD16val = 0xDEAD;
 char memsetD8val = 0xDE;
-int iterations = 1;
+int iterations = 0;  // 0 keeps each perftest's own iteration count
+std::vector<size_t> p_sizes;  // perftest sizes from --sizes/--sweep, empty keeps the defaults
+unsigned p_warmup = 1;       // untimed runs before each perftest measurement
+unsigned p_repetitions = 1;  // timed samples per perftest measurement
+unsigned p_rejectOutliers = 0;  // drop samples beyond N * MAD of the median, 0 keeps all
+double p_targetCi = 0;  // sample until the median's 95% CI is within this %, 0 keeps --repetitions
+unsigned p_maxTime = 5000;  // time budget in ms of one adaptive measurement
+const char* p_timer = "host";  // perftest device time source: host, event or kernel
+const char* p_format = "text";  // perftest result format: text, json or csv
+const char* p_output = nullptr;  // perftest result file, stdout when not set
+unsigned p_telemetry = 0;  // perftest GPU telemetry sampling period in ms, 0 disables it
+const char* p_timeline = nullptr;  // perftest device timeline file, not recorded when not set
+const char* p_counters = nullptr;  // perftest counter plugin and counter list, off when not set
+const char* p_affinity = nullptr;  // perftest host pinning: gpu or a cpu list, nullptr keeps it
+const char* p_input = nullptr;  // perftest input file, built-in inputs when not set
 unsigned blocksPerCU = 6;  // to hide latency
 unsigned threadsPerBlock = 256;
 int textureFilterMode = 0; // 0: hipFilterModePoint; 1: hipFilterModeLinear
@@ -146,6 +161,52 @@ int parseSize(const char* str, size_t* output) {
 }
 
 
+int parseSizeList(const char* str, std::vector<size_t>* output) {
+    std::string list(str);
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) end = list.size();
+        std::string item = list.substr(start, end - start);
+        size_t size = 0;
+        if (item.empty() || !HipTest::parseSize(item.c_str(), &size) || size == 0) {
+            return 0;
+        }
+        output->push_back(size);
+        start = end + 1;
+    }
+    return 1;
+}
+
+
+int parseSizeSweep(const char* str, std::vector<size_t>* output) {
+    std::string sweep(str);
+    size_t first = sweep.find(':');
+    size_t second = (first == std::string::npos) ? first : sweep.find(':', first + 1);
+    if (second == std::string::npos || second + 2 > sweep.size()) {
+        return 0;
+    }
+
+    size_t begin = 0, end = 0, step = 0;
+    HipTest::parseSize(sweep.substr(0, first).c_str(), &begin);
+    HipTest::parseSize(sweep.substr(first + 1, second - first - 1).c_str(), &end);
+    char kind = sweep[second + 1];
+    HipTest::parseSize(sweep.substr(second + 2).c_str(), &step);
+    if (begin == 0 || end < begin || (kind != 'x' && kind != '+') ||
+        (kind == 'x' && step < 2) || (kind == '+' && step == 0)) {
+        return 0;
+    }
+
+    for (size_t size = begin; size <= end;) {
+        output->push_back(size);
+        size_t next = (kind == 'x') ? size * step : size + step;
+        if (next <= size) break;  // overflow
+        size = next;
+    }
+    return 1;
+}
+
+
 int parseUInt(const char* str, unsigned int* output) {
     char* next;
     *output = strtoul(str, &next, 0);
@@ -160,6 +221,31 @@ int parseInt(const char* str, int* output) {
 }
 
 
+int parseDouble(const char* str, double* output) {
+    char* next;
+    *output = strtod(str, &next);
+    return !strlen(next);
+}
+
+
+// Device of this process under a launcher that starts one process per GPU, from the node local
+// rank set by Open MPI, MPICH, Slurm or torchrun style launchers, device 0 when none is set
+int launcherLocalDevice() {
+    static const char* localRankVars[] = {"OMPI_COMM_WORLD_LOCAL_RANK", "MPI_LOCALRANKID",
+                                          "SLURM_LOCALID", "LOCAL_RANK"};
+    for (const char* var : localRankVars) {
+        const char* value = getenv(var);
+        int rank;
+        if (value != nullptr && parseInt(value, &rank) && rank >= 0) {
+            int devices = 0;
+            HIPCHECK(hipGetDeviceCount(&devices));
+            return devices > 0 ? rank % devices : 0;
+        }
+    }
+    return 0;
+}
+
+
 int parseStandardArguments(int argc, char* argv[], bool failOnUndefinedArg) {
     int extraArgs = 1;
     for (int i = 1; i < argc; i++) {
@@ -213,9 +299,84 @@ int parseStandardArguments(int argc, char* argv[], bool failOnUndefinedArg) {
             if (++i >= argc || !HipTest::parseInt(argv[i], &iterations)) {
                 failed("Bad iterations argument");
             }
+        } else if (!strcmp(arg, "--sizes")) {
+            if (++i >= argc || !HipTest::parseSizeList(argv[i], &p_sizes)) {
+                failed("Bad sizes argument, expected a list like 4K,64K,1M");
+            }
+        } else if (!strcmp(arg, "--sweep")) {
+            if (++i >= argc || !HipTest::parseSizeSweep(argv[i], &p_sizes)) {
+                failed("Bad sweep argument, expected start:end:xFactor or start:end:+step");
+            }
+        } else if (!strcmp(arg, "--warmup")) {
+            if (++i >= argc || !HipTest::parseUInt(argv[i], &p_warmup)) {
+                failed("Bad warmup argument");
+            }
+        } else if (!strcmp(arg, "--repetitions") || (!strcmp(arg, "-r"))) {
+            if (++i >= argc || !HipTest::parseUInt(argv[i], &p_repetitions) ||
+                p_repetitions == 0) {
+                failed("Bad repetitions argument");
+            }
+        } else if (!strcmp(arg, "--reject-outliers")) {
+            if (++i >= argc || !HipTest::parseUInt(argv[i], &p_rejectOutliers)) {
+                failed("Bad reject-outliers argument");
+            }
+        } else if (!strcmp(arg, "--target-ci")) {
+            if (++i >= argc || !HipTest::parseDouble(argv[i], &p_targetCi) || p_targetCi < 0) {
+                failed("Bad target-ci argument, expected a percentage of the median");
+            }
+        } else if (!strcmp(arg, "--max-time")) {
+            if (++i >= argc || !HipTest::parseUInt(argv[i], &p_maxTime) || p_maxTime == 0) {
+                failed("Bad max-time argument, expected a time budget in ms");
+            }
+        } else if (!strcmp(arg, "--timer")) {
+            if (++i >= argc || (strcmp(argv[i], "host") && strcmp(argv[i], "event") &&
+                                strcmp(argv[i], "kernel"))) {
+                failed("Bad timer argument, expected host, event or kernel");
+            }
+            p_timer = argv[i];
+        } else if (!strcmp(arg, "--format")) {
+            if (++i >= argc || (strcmp(argv[i], "text") && strcmp(argv[i], "json") &&
+                                strcmp(argv[i], "csv"))) {
+                failed("Bad format argument, expected text, json or csv");
+            }
+            p_format = argv[i];
+        } else if (!strcmp(arg, "--output") || (!strcmp(arg, "-o"))) {
+            if (++i >= argc) {
+                failed("Bad output argument");
+            }
+            p_output = argv[i];
+        } else if (!strcmp(arg, "--telemetry")) {
+            if (++i >= argc || !HipTest::parseUInt(argv[i], &p_telemetry)) {
+                failed("Bad telemetry argument, expected a sampling period in ms");
+            }
+        } else if (!strcmp(arg, "--timeline")) {
+            if (++i >= argc) {
+                failed("Bad timeline argument");
+            }
+            p_timeline = argv[i];
+        } else if (!strcmp(arg, "--counters")) {
+            if (++i >= argc || argv[i][0] == '\0' || argv[i][0] == ':') {
+                failed("Bad counters argument, expected <plugin.so>[:<counter list>]");
+            }
+            p_counters = argv[i];
+        } else if (!strcmp(arg, "--affinity")) {
+            if (++i >= argc || (strcmp(argv[i], "gpu") &&
+                                (argv[i][0] == '\0' ||
+                                 strspn(argv[i], "0123456789,-") != strlen(argv[i])))) {
+                failed("Bad affinity argument, expected gpu or a cpu list like 0-7,16");
+            }
+            p_affinity = argv[i];
+        } else if (!strcmp(arg, "--input")) {
+            if (++i >= argc || argv[i][0] == '\0') {
+                failed("Bad input argument");
+            }
+            p_input = argv[i];
         } else if (!strcmp(arg, "--gpu") || (!strcmp(arg, "-gpuDevice")) || (!strcmp(arg, "-g"))) {
-            if (++i >= argc || !HipTest::parseInt(argv[i], &p_gpuDevice)) {
-                failed("Bad gpuDevice argument");
+            if (i + 1 < argc && !strcmp(argv[i + 1], "local")) {
+                p_gpuDevice = launcherLocalDevice();
+                i++;
+            } else if (++i >= argc || !HipTest::parseInt(argv[i], &p_gpuDevice)) {
+                failed("Bad gpuDevice argument, expected a device index or local");
             }
 
         } else if (!strcmp(arg, "--verbose") || (!strcmp(arg, "-v"))) {
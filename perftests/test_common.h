@@ -27,18 +27,20 @@ THE SOFTWARE.
 #ifdef __cplusplus
     #include <iostream>
     #include <iomanip>
+    #include <string>
+    #include <chrono>
     #if __CUDACC__
         #include <sys/time.h>
-    #else
-        #include <chrono>
     #endif
 #endif
 
 // ************************ GCC section **************************
 #include <stddef.h>
+#include <vector>
 
 #include "hip/hip_runtime.h"
 #include "hip/hip_runtime_api.h"
+#include "hip/hiprtc.h"
 
 #define HC __attribute__((hc))
 
@@ -103,6 +105,15 @@ inline int hip_skip_retcode() {
         }                                                                                          \
     }
 
+#define HIPRTCCHECK(result)                                                                        \
+    {                                                                                              \
+        hiprtcResult localResult = result;                                                         \
+        if (localResult != HIPRTC_SUCCESS) {                                                       \
+            failed("hiprtc error: '%s'(%d) from %s at %s:%d\n", hiprtcGetErrorString(localResult), \
+                   localResult, #result, __FILE__, __LINE__);                                      \
+        }                                                                                          \
+    }
+
 #define HIPASSERT(condition)                                                                       \
     if (!(condition)) {                                                                            \
         failed("%sassertion %s at %s:%d%s \n", KRED, #condition, __FILE__, __LINE__, KNRM);        \
@@ -151,6 +162,20 @@ extern int memsetD32val;
 extern short memsetD16val;
 extern char memsetD8val;
 extern int iterations;
+extern std::vector<size_t> p_sizes;
+extern unsigned p_warmup;
+extern unsigned p_repetitions;
+extern unsigned p_rejectOutliers;
+extern double p_targetCi;
+extern unsigned p_maxTime;
+extern const char* p_timer;
+extern const char* p_format;
+extern const char* p_output;
+extern unsigned p_telemetry;
+extern const char* p_timeline;
+extern const char* p_counters;
+extern const char* p_affinity;
+extern const char* p_input;
 extern unsigned blocksPerCU;
 extern unsigned threadsPerBlock;
 extern int textureFilterMode;
@@ -195,13 +220,43 @@ inline long long get_time() {
 
 double elapsed_time(long long startTimeUs, long long stopTimeUs);
 
+// Returns the seconds of steady_clock elapsed since start
+inline double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Returns steady_clock in seconds. On Linux this is CLOCK_MONOTONIC, so stamps
+// taken in different processes can be compared.
+inline double nowSec() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
 int parseSize(const char* str, size_t* output);
+// "4K,64K,1M": appends every size of the list.
+int parseSizeList(const char* str, std::vector<size_t>* output);
+// "start:end:xF" (geometric, factor F) or "start:end:+S" (linear, step S).
+int parseSizeSweep(const char* str, std::vector<size_t>* output);
 int parseUInt(const char* str, unsigned int* output);
 int parseInt(const char* str, int* output);
+int parseDouble(const char* str, double* output);
 int parseStandardArguments(int argc, char* argv[], bool failOnUndefinedArg);
 
 unsigned setNumBlocks(unsigned blocksPerCU, unsigned threadsPerBlock, size_t N);
 
+// Compiles prog with hiprtc; on failure prints the program log and fails the test
+inline void compileRtcProgram(hiprtcProgram prog, int numOptions, const char** options) {
+    hiprtcResult compileResult = hiprtcCompileProgram(prog, numOptions, options);
+    if (compileResult != HIPRTC_SUCCESS) {
+        size_t logSize = 0;
+        HIPRTCCHECK(hiprtcGetProgramLogSize(prog, &logSize));
+        std::string log(logSize, '\0');
+        HIPRTCCHECK(hiprtcGetProgramLog(prog, &log[0]));
+        printf("%s\n", log.c_str());
+        HIPRTCCHECK(compileResult);
+    }
+}
+
 template<typename T> // pointer type
 void checkArray(T hData, T hOutputData, size_t width, size_t height,size_t depth) {
    for (int i = 0; i < depth; i++) {
@@ -1,6 +1,8 @@
 #include "timer.h"
 
 #include <stdlib.h>
+#include <math.h>
+#include <algorithm>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -114,3 +116,110 @@ CPerfCounter::GetElapsedTime(void)
     return (double)_clocks / (double)_freq;
 
 }
+
+// Nearest-rank percentile of sorted values
+static double
+Percentile(const std::vector<double>& sorted, double p)
+{
+    size_t rank = (size_t)(p / 100.0 * sorted.size() + 0.5);
+    rank = std::min(std::max(rank, (size_t)1), sorted.size());
+    return sorted[rank - 1];
+}
+
+CPerfStats
+ComputePerfStats(const std::vector<double>& values)
+{
+    CPerfStats stats = {0};
+    if (values.empty()) {
+        return stats;
+    }
+
+    std::vector<double> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0;
+    for (double v : sorted) {
+        sum += v;
+    }
+
+    stats.count = sorted.size();
+    stats.min = sorted.front();
+    stats.max = sorted.back();
+    stats.mean = sum / sorted.size();
+    stats.median = Percentile(sorted, 50);
+    stats.p90 = Percentile(sorted, 90);
+    stats.p99 = Percentile(sorted, 99);
+
+    double dev = 0;
+    for (double v : sorted) {
+        dev += (v - stats.mean) * (v - stats.mean);
+    }
+    stats.stddev = sqrt(dev / sorted.size());
+
+    // Order statistics around the median rank, 1.96 standard errors of a
+    // binomial(n, 0.5) on either side
+    stats.medianCi = -1;
+    size_t n = sorted.size();
+    if (n >= 6) {
+        double spread = 1.96 * sqrt((double)n) / 2;
+        size_t lo = (size_t)std::max(1.0, floor(n / 2.0 - spread + 0.5));
+        size_t hi = (size_t)std::min((double)n, floor(1 + n / 2.0 + spread + 0.5));
+        double halfWidth = (sorted[hi - 1] - sorted[lo - 1]) / 2;
+        if (stats.median != 0) {
+            stats.medianCi = halfWidth / fabs(stats.median);
+        } else if (halfWidth == 0) {
+            stats.medianCi = 0;
+        }
+    }
+    return stats;
+}
+
+void
+CPerfSampler::Start(void)
+{
+    _counter.Reset();
+    _counter.Start();
+}
+
+void
+CPerfSampler::Stop(void)
+{
+    _counter.Stop();
+    _samples.push_back(_counter.GetElapsedTime());
+}
+
+void
+CPerfSampler::AddSample(double seconds)
+{
+    _samples.push_back(seconds);
+}
+
+void
+CPerfSampler::Clear(void)
+{
+    _samples.clear();
+}
+
+size_t
+CPerfSampler::RejectOutliers(double k)
+{
+    if (_samples.size() < 3) {
+        return 0;
+    }
+
+    double median = ComputePerfStats(_samples).median;
+    std::vector<double> deviation;
+    for (double v : _samples) {
+        deviation.push_back(fabs(v - median));
+    }
+    double mad = ComputePerfStats(deviation).median;
+    if (mad == 0) {
+        return 0;
+    }
+
+    size_t before = _samples.size();
+    _samples.erase(std::remove_if(_samples.begin(), _samples.end(),
+                                  [&](double v) { return fabs(v - median) > k * mad; }),
+                   _samples.end());
+    return before - _samples.size();
+}
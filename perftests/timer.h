@@ -1,6 +1,9 @@
 #ifndef _TIMER_H_
 #define _TIMER_H_
 
+#include <stddef.h>
+#include <vector>
+
 #ifdef _WIN32
 typedef __int64 i64 ;
 #endif
@@ -25,4 +28,45 @@ private:
     i64 _start;
 };
 
+// Summary of a set of samples, all in the unit of the samples.
+struct CPerfStats {
+    size_t count;
+    double min;
+    double max;
+    double mean;
+    double median;
+    double p90;
+    double p99;
+    double stddev;
+    // Half width of the distribution free 95% confidence interval of the
+    // median, relative to the median; -1 below 6 samples.
+    double medianCi;
+};
+
+// Computes the summary of values; an empty set gives all zeros.
+CPerfStats ComputePerfStats(const std::vector<double>& values);
+
+// Records one elapsed time (in seconds) per Start/Stop pair so that jitter
+// and tail latency are visible instead of only the total.
+class CPerfSampler {
+
+public:
+    void Start(void);
+    void Stop(void);
+    void AddSample(double seconds);
+    void Clear(void);
+
+    // Drops samples further than k * MAD (median absolute deviation) from
+    // the median. Returns the number of samples dropped.
+    size_t RejectOutliers(double k);
+
+    const std::vector<double>& GetSamples(void) const { return _samples; }
+    CPerfStats GetStats(void) const { return ComputePerfStats(_samples); }
+
+private:
+
+    CPerfCounter _counter;
+    std::vector<double> _samples;
+};
+
 #endif // _TIMER_H_
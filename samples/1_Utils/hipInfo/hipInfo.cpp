@@ -20,8 +20,12 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 THE SOFTWARE.
 */
 
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <string>
+#include <vector>
 #include "hip/hip_runtime.h"
 
 #define KNRM "\x1B[0m"
@@ -64,6 +68,187 @@ double bytesToGB(size_t s) { return (double)s / (1024.0 * 1024.0 * 1024.0); }
     }
 
 
+// Results of the --measure probes, negative when a probe did not run
+struct Measurements {
+    double h2dGBps = -1;
+    double d2hGBps = -1;
+    double deviceMemGBps = -1;
+    double launchLatencyUs = -1;
+    std::vector<std::pair<int, double>> peerGBps;  // peer device, GB/s from deviceId to it
+};
+
+static const size_t probeBytes = 64 * 1024 * 1024;
+static const int probeRepeats = 5;
+static const int launchRepeats = 1000;
+
+__global__ void emptyKernel() {}
+
+// Best of probeRepeats runs of op on stream, in milliseconds
+template <typename Op> float bestTimeMs(hipStream_t stream, Op op) {
+    hipEvent_t start, stop;
+    HIPCHECK(hipEventCreate(&start));
+    HIPCHECK(hipEventCreate(&stop));
+    op();  // warm-up
+    HIPCHECK(hipStreamSynchronize(stream));
+    float best = 0;
+    for (int i = 0; i < probeRepeats; i++) {
+        HIPCHECK(hipEventRecord(start, stream));
+        op();
+        HIPCHECK(hipEventRecord(stop, stream));
+        HIPCHECK(hipEventSynchronize(stop));
+        float ms;
+        HIPCHECK(hipEventElapsedTime(&ms, start, stop));
+        if (i == 0 || ms < best) best = ms;
+    }
+    HIPCHECK(hipEventDestroy(start));
+    HIPCHECK(hipEventDestroy(stop));
+    return best;
+}
+
+double toGBps(double bytes, float ms) { return ms > 0 ? bytes / (ms * 1e-3) / 1e9 : 0; }
+
+// Quick probes of the current device: pinned copies, device memory, launch latency and peers
+Measurements measureDevice(int deviceId) {
+    Measurements m;
+    hipStream_t stream;
+    HIPCHECK(hipSetDevice(deviceId));
+    HIPCHECK(hipStreamCreateWithFlags(&stream, hipStreamNonBlocking));
+
+    void* host;
+    void* devA;
+    void* devB;
+    HIPCHECK(hipHostMalloc(&host, probeBytes));
+    HIPCHECK(hipMalloc(&devA, probeBytes));
+    HIPCHECK(hipMalloc(&devB, probeBytes));
+    memset(host, 0, probeBytes);
+    HIPCHECK(hipMemset(devA, 0, probeBytes));
+
+    m.h2dGBps = toGBps(probeBytes, bestTimeMs(stream, [&]() {
+        HIPCHECK(hipMemcpyAsync(devA, host, probeBytes, hipMemcpyHostToDevice, stream));
+    }));
+    m.d2hGBps = toGBps(probeBytes, bestTimeMs(stream, [&]() {
+        HIPCHECK(hipMemcpyAsync(host, devA, probeBytes, hipMemcpyDeviceToHost, stream));
+    }));
+    // A device to device copy reads and writes every byte
+    m.deviceMemGBps = toGBps(2.0 * probeBytes, bestTimeMs(stream, [&]() {
+        HIPCHECK(hipMemcpyAsync(devB, devA, probeBytes, hipMemcpyDeviceToDevice, stream));
+    }));
+
+    // Launch plus synchronize, one at a time
+    hipLaunchKernelGGL(emptyKernel, dim3(1), dim3(1), 0, stream);
+    HIPCHECK(hipStreamSynchronize(stream));
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < launchRepeats; i++) {
+        hipLaunchKernelGGL(emptyKernel, dim3(1), dim3(1), 0, stream);
+        HIPCHECK(hipStreamSynchronize(stream));
+    }
+    m.launchLatencyUs =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+            .count() / launchRepeats;
+
+    int deviceCnt;
+    HIPCHECK(hipGetDeviceCount(&deviceCnt));
+    for (int peer = 0; peer < deviceCnt; peer++) {
+        int isPeer = 0;
+        if (peer == deviceId) continue;
+        HIPCHECK(hipDeviceCanAccessPeer(&isPeer, deviceId, peer));
+        if (!isPeer) continue;
+        void* peerBuf;
+        HIPCHECK(hipSetDevice(peer));
+        HIPCHECK(hipMalloc(&peerBuf, probeBytes));
+        HIPCHECK(hipSetDevice(deviceId));
+        hipError_t err = hipDeviceEnablePeerAccess(peer, 0);
+        if (err != hipSuccess && err != hipErrorPeerAccessAlreadyEnabled) {
+            HIPCHECK(err);
+        }
+        (void)hipGetLastError();
+        double gbps = toGBps(probeBytes, bestTimeMs(stream, [&]() {
+            HIPCHECK(hipMemcpyPeerAsync(peerBuf, peer, devA, deviceId, probeBytes, stream));
+        }));
+        m.peerGBps.push_back(std::make_pair(peer, gbps));
+        if (err == hipSuccess) {
+            HIPCHECK(hipDeviceDisablePeerAccess(peer));
+        }
+        HIPCHECK(hipFree(peerBuf));
+    }
+
+    HIPCHECK(hipHostFree(host));
+    HIPCHECK(hipFree(devA));
+    HIPCHECK(hipFree(devB));
+    HIPCHECK(hipStreamDestroy(stream));
+    return m;
+}
+
+// Theoretical device memory bandwidth, memoryClockRate in kHz at two transfers per clock
+double peakMemGBps(const hipDeviceProp_t& props) {
+    return 2.0 * props.memoryClockRate * 1e3 * (props.memoryBusWidth / 8) * 1e-9;
+}
+
+void printMeasurements(const hipDeviceProp_t& props, const Measurements& m) {
+    using namespace std;
+    const int w1 = 34;
+
+    cout << endl << fixed << setprecision(2);
+    cout << setw(w1) << "measured.h2dBandwidth: " << m.h2dGBps << " GB/s" << endl;
+    cout << setw(w1) << "measured.d2hBandwidth: " << m.d2hGBps << " GB/s" << endl;
+    double peak = peakMemGBps(props);
+    cout << setw(w1) << "measured.deviceMemBandwidth: " << m.deviceMemGBps << " GB/s";
+    if (peak > 0) {
+        // memoryClockRate or memoryBusWidth may be reported as 0, then there is no peak
+        cout << " (" << setprecision(0) << 100.0 * m.deviceMemGBps / peak << "% of "
+             << setprecision(2) << peak << " GB/s peak)";
+    }
+    cout << endl;
+    cout << setw(w1) << "measured.launchLatency: " << m.launchLatencyUs << " us" << endl;
+    for (const auto& peer : m.peerGBps) {
+        string name = "measured.peerBandwidth[" + to_string(peer.first) + "]: ";
+        cout << setw(w1) << name << peer.second << " GB/s" << endl;
+    }
+}
+
+// Writes a JSON string value, escaping quotes and backslashes
+std::string jsonString(const char* s) {
+    std::string out = "\"";
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') out += '\\';
+        out += *s;
+    }
+    return out + "\"";
+}
+
+void printDeviceJson(int deviceId, bool measure, bool last) {
+    using namespace std;
+    hipDeviceProp_t props = {0};
+    HIPCHECK(hipGetDeviceProperties(&props, deviceId));
+    size_t free, total;
+    HIPCHECK(hipMemGetInfo(&free, &total));
+
+    cout << "  {\"device\": " << deviceId << ", \"name\": " << jsonString(props.name)
+#ifdef __HIP_PLATFORM_AMD__
+         << ", \"gcnArchName\": " << jsonString(props.gcnArchName)
+#endif
+         << ", \"pciDomainID\": " << props.pciDomainID << ", \"pciBusID\": " << props.pciBusID
+         << ", \"pciDeviceID\": " << props.pciDeviceID
+         << ", \"multiProcessorCount\": " << props.multiProcessorCount
+         << ", \"clockRateKHz\": " << props.clockRate
+         << ", \"memoryClockRateKHz\": " << props.memoryClockRate
+         << ", \"memoryBusWidth\": " << props.memoryBusWidth
+         << ", \"totalGlobalMem\": " << props.totalGlobalMem << ", \"memFree\": " << free
+         << ", \"peakMemBandwidthGBps\": " << fixed << setprecision(2) << peakMemGBps(props);
+    if (measure) {
+        Measurements m = measureDevice(deviceId);
+        cout << ", \"measured\": {\"h2dGBps\": " << m.h2dGBps << ", \"d2hGBps\": " << m.d2hGBps
+             << ", \"deviceMemGBps\": " << m.deviceMemGBps
+             << ", \"launchLatencyUs\": " << m.launchLatencyUs << ", \"peerGBps\": {";
+        for (size_t i = 0; i < m.peerGBps.size(); i++) {
+            cout << (i ? ", " : "") << "\"" << m.peerGBps[i].first << "\": "
+                 << m.peerGBps[i].second;
+        }
+        cout << "}}";
+    }
+    cout << "}" << (last ? "" : ",") << endl;
+}
+
 void printDeviceProp(int deviceId) {
     using namespace std;
     const int w1 = 34;
@@ -193,20 +378,55 @@ void printDeviceProp(int deviceId) {
          << (float)free / total * 100.0 << "%)" << endl;
 }
 
+void printUsage(const char* name) {
+    std::cout << "Usage: " << name << " [--measure] [--json]" << std::endl
+              << "  --measure  also run quick bandwidth and latency probes on every device"
+              << std::endl
+              << "  --json     print one JSON array with an object per device" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     using namespace std;
 
-    cout << endl;
-
-    printCompilerInfo();
+    bool measure = false;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--measure") == 0) {
+            measure = true;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else {
+            printUsage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : EXIT_FAILURE;
+        }
+    }
 
     int deviceCnt;
 
     HIPCHECK(hipGetDeviceCount(&deviceCnt));
 
+    if (json) {
+        cout << "[" << endl;
+        for (int i = 0; i < deviceCnt; i++) {
+            HIPCHECK(hipSetDevice(i));
+            printDeviceJson(i, measure, i == deviceCnt - 1);
+        }
+        cout << "]" << endl;
+        return 0;
+    }
+
+    cout << endl;
+
+    printCompilerInfo();
+
     for (int i = 0; i < deviceCnt; i++) {
         hipSetDevice(i);
         printDeviceProp(i);
+        if (measure) {
+            hipDeviceProp_t props = {0};
+            HIPCHECK(hipGetDeviceProperties(&props, i));
+            printMeasurements(props, measureDevice(i));
+        }
     }
 
     std::cout << std::endl;
@@ -68,9 +68,8 @@ bool HipAPI::isDeprecated() const
   return deprecated;
 }
 
-std::string HipAPI::getBasicStatsXML() const
+void HipAPI::writeBasicStatsXML(std::ostream& xml_node) const
 {
-  std::stringstream xml_node;
   xml_node << "\t\t<HIP-API>\n";
 
   if (!deprecated) {
@@ -89,11 +88,9 @@ std::string HipAPI::getBasicStatsXML() const
   }
 
   xml_node << "\t\t</HIP-API>\n";
-  return xml_node.str();
 }
 
-std::string HipAPI::createHTMLReport() const {
-  std::stringstream html_report;
+void HipAPI::writeHTMLReport(std::ostream& html_report) const {
   std::string one_tab{"\n\t"};
   std::string two_tabs{"\n\t\t"};
   std::string three_tabs{"\n\t\t\t"};
@@ -217,6 +214,4 @@ std::string HipAPI::createHTMLReport() const {
   html_report << one_tab << "</table>";
   html_report << one_tab << "<br>";
   html_report << "\n</body>\n</html>";
-
-  return html_report.str();
 }
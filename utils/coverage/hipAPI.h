@@ -63,8 +63,9 @@ class HipAPI {
   void addFileOccurrence(FileOccurrence file_occurence);
   void addTestCase(TestCaseOccurrence test_case);
   bool isDeprecated() const;
-  std::string getBasicStatsXML() const;
-  std::string createHTMLReport() const;
+  // Report writers stream into the passed output, nothing is built in memory.
+  void writeBasicStatsXML(std::ostream& xml_node) const;
+  void writeHTMLReport(std::ostream& html_report) const;
  private:
   std::string api_name;
   int number_of_calls;
@@ -21,45 +21,46 @@ THE SOFTWARE.
 */
 
 #include "hipAPICoverageUtils.h"
+#include <atomic>
+#include <cctype>
+#include <thread>
 
 /*
-Used to find all HIP API occurrences within the passed test .cc files.
-Occurrence is detected when the HIP API is called in several scenarios.
-    - API Call with assertion, e.g. REQUIRE(hipAPI());
-    - API call with assignment, e.g. result = hipAPI();
-    - API call with parameter, e.g. ASSERT_EQUAL(hipSuccess, hipGetDevice(&deviceId));
+Used to run task for every index in [0, count) on a pool of worker threads,
+one per hardware thread. Each index is handed to exactly one worker, the
+order in which they run is not defined.
 */
-void findAPICallInFile(HipAPI& hip_api, std::string test_module_file) {
-  std::fstream test_module_file_handler;
-  test_module_file_handler.open(test_module_file);
-
-  int line_number{0};
-  std::string line;
-  /*
-  Closed brackets might be in another line, if the API
-  call is multiline.
-  */
-  std::string api_call_with_assert{"(" + hip_api.getName() + "("};
-  std::string api_call_with_assignment{"= " + hip_api.getName() + "("};
-  std::string api_call_with_parameter{", " + hip_api.getName() + "("};
-
-  while (std::getline(test_module_file_handler, line)) {
-    ++line_number;
-    if ((line.find(api_call_with_assert) != std::string::npos) ||
-        (line.find(api_call_with_assignment) != std::string::npos) ||
-        (line.find(api_call_with_parameter) != std::string::npos)) {
-      hip_api.addFileOccurrence(FileOccurrence(test_module_file, line_number));
+void parallelFor(size_t count, const std::function<void(size_t)>& task) {
+  size_t number_of_workers{std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), count)};
+  std::atomic<size_t> next_index{0};
+  auto worker = [&]() {
+    for (size_t index = next_index++; index < count; index = next_index++) {
+      task(index);
     }
-  }
+  };
 
-  test_module_file_handler.close();
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < number_of_workers; ++i) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread: workers) {
+    thread.join();
+  }
 }
 
 /*
-Used to find all HIP API test cases within the passed test .cc files.
+Used to add all HIP API occurrences and HIP API test cases within the passed
+test .cc file to the index.
+Occurrence is detected when an identifier is called in several scenarios.
+    - API Call with assertion, e.g. REQUIRE(hipAPI());
+    - API call with assignment, e.g. result = hipAPI();
+    - API call with parameter, e.g. ASSERT_EQUAL(hipSuccess, hipGetDevice(&deviceId));
+Each identifier is recorded at most once per line. Every identifier is indexed,
+not only known HIP APIs, lookups for names that are not HIP APIs never happen.
 Matching test case is detected when the HIP API in defined within doxygen comment.
 */
-void findAPITestCaseInFile(HipAPI& hip_api, std::string test_module_file) {
+void indexTestModuleFile(TestModuleIndex& index, std::string test_module_file) {
   std::fstream test_module_file_handler;
   test_module_file_handler.open(test_module_file);
 
@@ -71,28 +72,62 @@ void findAPITestCaseInFile(HipAPI& hip_api, std::string test_module_file) {
   std::string test_case_definition{"TEST_CASE("};
   std::string current_api_name{"None"};
   std::string test_case{"None"};
+  std::vector<std::string> line_calls;
+
+  auto is_identifier = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
 
   while (std::getline(test_module_file_handler, line)) {
     ++line_number;
+
+    /*
+    Closed brackets might be in another line, if the API call is multiline, so
+    only the identifier followed by an open bracket is needed.
+    */
+    line_calls.clear();
+    for (size_t start = 0; start < line.size();) {
+      if (!is_identifier(line[start])) {
+        ++start;
+        continue;
+      }
+      size_t end = start;
+      while (end < line.size() && is_identifier(line[end])) {
+        ++end;
+      }
+      bool is_call = end < line.size() && line[end] == '(';
+      bool after_assert = start >= 1 && line[start - 1] == '(';
+      bool after_assignment = start >= 2 && line.compare(start - 2, 2, "= ") == 0;
+      bool after_parameter = start >= 2 && line.compare(start - 2, 2, ", ") == 0;
+      if (is_call && (after_assert || after_assignment || after_parameter)) {
+        std::string name{line.substr(start, end - start)};
+        if (std::find(line_calls.begin(), line_calls.end(), name) == line_calls.end()) {
+          line_calls.push_back(name);
+          index.api_calls[name].push_back(FileOccurrence(test_module_file, line_number));
+        }
+      }
+      start = end;
+    }
+
     if (line.find(add_group_definition) != std::string::npos) {
       current_api_name = line.substr(line.find(add_group_definition) + 1);
       current_api_name = current_api_name.substr(current_api_name.rfind(" ") + 1);
     }
 
-    if (hip_api.getName() != current_api_name) {
+    if (current_api_name == "None") {
       continue;
     }
 
     if (line.find(ref_test_case) != std::string::npos) {
       test_case = line.substr(line.rfind(" ") + 1);
-      hip_api.addTestCase(TestCaseOccurrence{test_case, test_module_file, line_number});
+      index.test_cases[current_api_name].push_back(
+          TestCaseOccurrence{test_case, test_module_file, line_number});
       continue;
     }
 
     if (line.find(test_case_definition) != std::string::npos) {
       test_case = line.substr(line.find("\"") + 1);
       test_case = test_case.substr(0, test_case.find("\""));
-      hip_api.addTestCase(TestCaseOccurrence{test_case, test_module_file, line_number});
+      index.test_cases[current_api_name].push_back(
+          TestCaseOccurrence{test_case, test_module_file, line_number});
     }
   }
 
@@ -100,14 +135,197 @@ void findAPITestCaseInFile(HipAPI& hip_api, std::string test_module_file) {
 }
 
 /*
-Used to iterate through all passed test .cc files and search for passed
-HIP API instance. This instance shall be used to update occurrences.
+Used to identify the state of a file, from its modification time and size.
+Returns an empty string if the file does not exist.
+*/
+std::string findFileStamp(const std::string& file_path) {
+  std::error_code error;
+  auto modification_time = std::filesystem::last_write_time(file_path, error);
+  if (error) {
+    return "";
+  }
+  auto file_size = std::filesystem::file_size(file_path, error);
+  if (error) {
+    return "";
+  }
+  return std::to_string(modification_time.time_since_epoch().count()) + "_" + std::to_string(file_size);
+}
+
+/*
+Used to read the index cache file written by a previous run. The file consists of tab
+separated lines:
+    headers <stamp of the HIP API header files>
+    file    <stamp> <test module file>
+    call    <API name> <line number>
+    case    <API name> <line number> <test case name>
+call and case lines belong to the preceding file line. Returns an empty cache if the file
+does not exist.
+*/
+TestModuleCache loadTestModuleCache(const std::string& cache_file) {
+  TestModuleCache cache;
+  std::fstream cache_file_handler;
+  cache_file_handler.open(cache_file, std::ios::in);
+
+  std::string line;
+  std::string test_module_file;
+  TestModuleIndex* index{nullptr};
+  while (std::getline(cache_file_handler, line)) {
+    std::vector<std::string> fields;
+    std::stringstream line_stream{line};
+    for (std::string field; std::getline(line_stream, field, '\t');) {
+      fields.push_back(field);
+    }
+
+    if (fields.size() == 2 && fields[0] == "headers") {
+      cache.header_stamp = fields[1];
+    } else if (fields.size() == 3 && fields[0] == "file") {
+      test_module_file = fields[2];
+      auto& entry = cache.test_modules[test_module_file];
+      entry.first = fields[1];
+      index = &entry.second;
+    } else if (index != nullptr && fields.size() == 3 && fields[0] == "call") {
+      index->api_calls[fields[1]].push_back(FileOccurrence(test_module_file, std::stoi(fields[2])));
+    } else if (index != nullptr && fields.size() == 4 && fields[0] == "case") {
+      index->test_cases[fields[1]].push_back(
+          TestCaseOccurrence{fields[3], test_module_file, std::stoi(fields[2])});
+    } else {
+      // Unknown or broken content, start from scratch.
+      std::cout << "Ignoring invalid index cache file " << cache_file << std::endl;
+      return TestModuleCache{};
+    }
+  }
+
+  cache_file_handler.close();
+  return cache;
+}
+
+/*
+Used to write the index cache file read by loadTestModuleCache(). The file is written
+next to the target and renamed, so an interrupted run leaves the previous cache intact.
+*/
+void storeTestModuleCache(const std::string& cache_file, const TestModuleCache& cache) {
+  std::string temporary_file{cache_file + ".tmp"};
+  std::fstream cache_file_handler;
+  cache_file_handler.open(temporary_file, std::ios::out);
+
+  cache_file_handler << "headers\t" << cache.header_stamp << "\n";
+  for (auto const& test_module: cache.test_modules) {
+    cache_file_handler << "file\t" << test_module.second.first << "\t" << test_module.first << "\n";
+    for (auto const& api_calls: test_module.second.second.api_calls) {
+      for (auto const& file_occurrence: api_calls.second) {
+        cache_file_handler << "call\t" << api_calls.first << "\t" << file_occurrence.line_number << "\n";
+      }
+    }
+    for (auto const& test_cases: test_module.second.second.test_cases) {
+      for (auto const& test_case: test_cases.second) {
+        cache_file_handler << "case\t" << test_cases.first << "\t" << test_case.line_number << "\t"
+            << test_case.test_case_name << "\n";
+      }
+    }
+  }
+
+  cache_file_handler.close();
+  std::filesystem::rename(temporary_file, cache_file);
+}
+
+/*
+Used to read all passed test .cc files once and index their API calls
+and API test cases. Files are indexed in parallel into partial indexes
+of their own, which are merged in file order so that occurrences keep
+the same order as in a sequential scan.
+*/
+TestModuleIndex indexTestModuleFiles(std::vector<std::string>& test_module_files) {
+  TestModuleCache cache;
+  std::set<std::string> changed_names;
+  return indexTestModuleFiles(test_module_files, cache, changed_names);
+}
+
+/*
+Same as above, but files whose stamp matches the passed cache are taken from
+it instead of being read again. The cache is updated to the current files, and
+the names of all APIs whose calls or test cases may differ from the cached run
+are added to changed_names.
+*/
+TestModuleIndex indexTestModuleFiles(std::vector<std::string>& test_module_files, TestModuleCache& cache,
+                                     std::set<std::string>& changed_names) {
+  auto add_changed_names = [&changed_names](const TestModuleIndex& index) {
+    for (auto const& api_calls: index.api_calls) {
+      changed_names.insert(api_calls.first);
+    }
+    for (auto const& test_cases: index.test_cases) {
+      changed_names.insert(test_cases.first);
+    }
+  };
+
+  std::vector<TestModuleIndex> file_indexes(test_module_files.size());
+  std::vector<std::string> file_stamps(test_module_files.size());
+  std::vector<char> rescanned(test_module_files.size(), false);
+  parallelFor(test_module_files.size(), [&](size_t i) {
+    file_stamps[i] = findFileStamp(test_module_files[i]);
+    auto cached = cache.test_modules.find(test_module_files[i]);
+    if (cached != cache.test_modules.end() && !file_stamps[i].empty() &&
+        cached->second.first == file_stamps[i]) {
+      file_indexes[i] = cached->second.second;
+    } else {
+      indexTestModuleFile(file_indexes[i], test_module_files[i]);
+      rescanned[i] = true;
+    }
+  });
+
+  // APIs referenced by removed files, or by the previous state of changed files, change as well.
+  std::map<std::string, std::pair<std::string, TestModuleIndex>> test_modules;
+  for (size_t i = 0; i < test_module_files.size(); ++i) {
+    auto cached = cache.test_modules.find(test_module_files[i]);
+    if (rescanned[i]) {
+      add_changed_names(file_indexes[i]);
+      if (cached != cache.test_modules.end()) {
+        add_changed_names(cached->second.second);
+      }
+    }
+    if (cached != cache.test_modules.end()) {
+      cache.test_modules.erase(cached);
+    }
+    test_modules[test_module_files[i]] = {file_stamps[i], file_indexes[i]};
+  }
+  for (auto const& removed: cache.test_modules) {
+    add_changed_names(removed.second.second);
+  }
+  cache.test_modules = std::move(test_modules);
+
+  std::cout << "Rescanned " << std::count(rescanned.begin(), rescanned.end(), char{true}) << " of "
+      << test_module_files.size() << " test module files." << std::endl;
+
+  TestModuleIndex index;
+  for (auto& file_index: file_indexes) {
+    for (auto& api_calls: file_index.api_calls) {
+      auto& merged = index.api_calls[api_calls.first];
+      merged.insert(merged.end(), api_calls.second.begin(), api_calls.second.end());
+    }
+    for (auto& test_cases: file_index.test_cases) {
+      auto& merged = index.test_cases[test_cases.first];
+      merged.insert(merged.end(), test_cases.second.begin(), test_cases.second.end());
+    }
+  }
+  return index;
+}
+
+/*
+Used to update occurrences of the passed HIP API instance from the
+index of all test module files.
 */
-void searchForAPI(HipAPI& hip_api, std::vector<std::string>& test_module_files) {
-  std::cout << "Searching for " << hip_api.getName() << " in test module files." << std::endl;
-  for (auto const& test_module_file: test_module_files) {
-    findAPICallInFile(hip_api, test_module_file);
-    findAPITestCaseInFile(hip_api, test_module_file);
+void searchForAPI(HipAPI& hip_api, TestModuleIndex& index) {
+  auto api_calls = index.api_calls.find(hip_api.getName());
+  if (api_calls != index.api_calls.end()) {
+    for (auto const& file_occurrence: api_calls->second) {
+      hip_api.addFileOccurrence(file_occurrence);
+    }
+  }
+
+  auto test_cases = index.test_cases.find(hip_api.getName());
+  if (test_cases != index.test_cases.end()) {
+    for (auto const& test_case: test_cases->second) {
+      hip_api.addTestCase(test_case);
+    }
   }
 }
 
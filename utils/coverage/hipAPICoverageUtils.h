@@ -24,9 +24,39 @@ THE SOFTWARE.
 #include <filesystem>
 #include "hipAPIGroup.h"
 
-void findAPICallInFile(HipAPI& hip_api, std::string test_module_file);
-void findAPITestCaseInFile(HipAPI& hip_api, std::string test_module_file);
-void searchForAPI(HipAPI& hip_api, std::vector<std::string>& test_module_files);
+#include <functional>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+/*
+API calls and API test cases of all test module files, keyed by API name.
+Built by reading every test module file once, so that all HIP APIs can be
+resolved against it without opening the files again.
+*/
+struct TestModuleIndex {
+  std::unordered_map<std::string, std::vector<FileOccurrence>> api_calls;
+  std::unordered_map<std::string, std::vector<TestCaseOccurrence>> test_cases;
+};
+
+/*
+Index of every test module file from a previous run, persisted in the index cache
+file together with the modification stamp of the file it was built from.
+*/
+struct TestModuleCache {
+  std::string header_stamp;
+  std::map<std::string, std::pair<std::string, TestModuleIndex>> test_modules;
+};
+
+void parallelFor(size_t count, const std::function<void(size_t)>& task);
+std::string findFileStamp(const std::string& file_path);
+TestModuleCache loadTestModuleCache(const std::string& cache_file);
+void storeTestModuleCache(const std::string& cache_file, const TestModuleCache& cache);
+void indexTestModuleFile(TestModuleIndex& index, std::string test_module_file);
+TestModuleIndex indexTestModuleFiles(std::vector<std::string>& test_module_files);
+TestModuleIndex indexTestModuleFiles(std::vector<std::string>& test_module_files, TestModuleCache& cache,
+                                     std::set<std::string>& changed_names);
+void searchForAPI(HipAPI& hip_api, TestModuleIndex& index);
 std::vector<HipAPI> extractHipAPIs(std::string& hip_api_header_file, std::vector<std::string>& api_group_names, bool start_groups);
 std::vector<std::string> extractTestModuleFiles(std::string& tests_root_directory);
 std::string findAbsolutePathOfFile(std::string file_path);
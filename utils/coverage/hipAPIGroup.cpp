@@ -26,7 +26,7 @@ bool operator==(const HipAPIGroup& l_hip_api_group, const HipAPIGroup& r_hip_api
   return l_hip_api_group.group_name == r_hip_api_group.group_name;
 }
 
-HipAPIGroup::HipAPIGroup(std::string group_name, std::vector<HipAPI>& hip_apis):
+HipAPIGroup::HipAPIGroup(std::string group_name, const std::vector<HipAPI>& hip_apis):
     group_name{group_name}, number_of_api_calls{0}, percentage_of_called_apis{0.f},
     total_number_of_apis{0}, number_of_test_cases{0}
 {
@@ -36,12 +36,12 @@ HipAPIGroup::HipAPIGroup(std::string group_name, std::vector<HipAPI>& hip_apis):
     }
 
     if (hip_api.isDeprecated()) {
-      deprecated_apis.push_back(hip_api);
+      deprecated_apis.push_back(&hip_api);
     } else {
       if (hip_api.getNumberOfCalls()) {
-        called_apis.push_back(hip_api);
+        called_apis.push_back(&hip_api);
       } else {
-        not_called_apis.push_back(hip_api);
+        not_called_apis.push_back(&hip_api);
       }
     }
 
@@ -89,8 +89,7 @@ float HipAPIGroup::getPercentageOfCalledAPIs() const {
   return percentage_of_called_apis;
 }
 
-std::string HipAPIGroup::getBasicStatsXML() const {
-  std::stringstream xml_node;
+void HipAPIGroup::writeBasicStatsXML(std::ostream& xml_node) const {
 
   std::string tag_name;
   std::transform(group_name.begin(), group_name.end(), std::back_inserter(tag_name), ::toupper);
@@ -109,35 +108,36 @@ std::string HipAPIGroup::getBasicStatsXML() const {
 
   if (!called_apis.empty()) {
     xml_node << "\n\t<LIST-OF-CALLED-APIs>\n";
-    for (auto const& hip_api: called_apis) {
-      xml_node << hip_api.getBasicStatsXML();
+    for (auto const* hip_api: called_apis) {
+      hip_api->writeBasicStatsXML(xml_node);
     }
     xml_node << "\t</LIST-OF-CALLED-APIs>";
   }
 
   if (!not_called_apis.empty()) {
     xml_node << "\n\t<LIST-OF-NOT-CALLED-APIs>\n";
-    for (auto const& hip_api: not_called_apis) {
-      xml_node << hip_api.getBasicStatsXML();
+    for (auto const* hip_api: not_called_apis) {
+      hip_api->writeBasicStatsXML(xml_node);
     }
     xml_node << "\t</LIST-OF-NOT-CALLED-APIs>";
   }
 
   if (!deprecated_apis.empty()) {
     xml_node << "\n\t<DEPRECATED-APIs>\n";
-    for (auto const& hip_api: deprecated_apis) {
-      xml_node << hip_api.getBasicStatsXML();
+    for (auto const* hip_api: deprecated_apis) {
+      hip_api->writeBasicStatsXML(xml_node);
     }
     xml_node << "\t</DEPRECATED-APIs>";
   }
 
   xml_node << "\n</" << tag_name << ">";
-  return xml_node.str();
 }
 
-std::string HipAPIGroup::getBasicStatsHTML() const
+void HipAPIGroup::writeBasicStatsHTML(std::ostream& html_object) const
 {
-  std::stringstream html_object;
+  // Percentages are written with fixed precision, the format of the output is restored at the end.
+  std::ios_base::fmtflags format_flags{html_object.flags()};
+  std::streamsize format_precision{html_object.precision()};
   std::string two_tabs{"\n\t\t"};
   std::string three_tabs{"\n\t\t\t"};
   std::string four_tabs{"\n\t\t\t\t"};
@@ -176,12 +176,12 @@ std::string HipAPIGroup::getBasicStatsHTML() const
   html_object << four_tabs << "</td>";
   html_object << three_tabs << "</tr>";
 
-  return html_object.str();
+  html_object.flags(format_flags);
+  html_object.precision(format_precision);
 }
 
-std::string HipAPIGroup::createHTMLReport() const
+void HipAPIGroup::writeHTMLReport(std::ostream& html_report) const
 {
-  std::stringstream html_report;
   std::string one_tab{"\n\t"};
   std::string two_tabs{"\n\t\t"};
   std::string three_tabs{"\n\t\t\t"};
@@ -279,9 +279,9 @@ std::string HipAPIGroup::createHTMLReport() const
   html_report << five_tabs << "<tr>";
   html_report << six_tabs << "<td class=\"tableHead\">Called APIs</td>";
   html_report << five_tabs << "</tr>";
-  for (auto const& hip_api: called_apis) {
+  for (auto const* hip_api: called_apis) {
     html_report << five_tabs << "<tr>";
-    html_report << six_tabs << "<td class=\"coverFile\"><a href=\"../testAPIs/" << hip_api.getName() << ".html\">" << hip_api.getName() << "</a></td>";
+    html_report << six_tabs << "<td class=\"coverFile\"><a href=\"../testAPIs/" << hip_api->getName() << ".html\">" << hip_api->getName() << "</a></td>";
     html_report << five_tabs << "</tr>";
   }
 
@@ -293,9 +293,9 @@ std::string HipAPIGroup::createHTMLReport() const
   html_report << five_tabs << "<tr>";
   html_report << six_tabs << "<td class=\"tableHead\">Not called APIs</td>";
   html_report << five_tabs << "</tr>";
-  for (auto const& hip_api: not_called_apis) {
+  for (auto const* hip_api: not_called_apis) {
     html_report << five_tabs << "<tr>";
-    html_report << six_tabs << "<td class=\"coverFile\"><a href=\"../testAPIs/" << hip_api.getName() << ".html\">" << hip_api.getName() << "</a></td>";
+    html_report << six_tabs << "<td class=\"coverFile\"><a href=\"../testAPIs/" << hip_api->getName() << ".html\">" << hip_api->getName() << "</a></td>";
     html_report << five_tabs << "</tr>";
   }
   html_report << four_tabs << "</table>";
@@ -306,9 +306,9 @@ std::string HipAPIGroup::createHTMLReport() const
   html_report << five_tabs << "<tr>";
   html_report << six_tabs << "<td class=\"tableHead\">Deprecated APIs</td>";
   html_report << five_tabs << "</tr>";
-  for (auto const& hip_api: deprecated_apis) {
+  for (auto const* hip_api: deprecated_apis) {
     html_report << five_tabs << "<tr>";
-    html_report << six_tabs << "<td class=\"coverFile\"><a href=\"../testAPIs/" << hip_api.getName() << ".html\">" << hip_api.getName() << "</a></td>";
+    html_report << six_tabs << "<td class=\"coverFile\"><a href=\"../testAPIs/" << hip_api->getName() << ".html\">" << hip_api->getName() << "</a></td>";
     html_report << five_tabs << "</tr>";
   }
   html_report << four_tabs << "</table>";
@@ -330,6 +330,4 @@ std::string HipAPIGroup::createHTMLReport() const
   html_report << one_tab << "</table>";
   html_report << one_tab << "<br>";
   html_report << "\n</body>\n</html>";
-
-  return html_report.str();
 }
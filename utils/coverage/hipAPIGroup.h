@@ -28,7 +28,8 @@ class HipAPIGroup{
   friend bool operator==(const HipAPIGroup& l_hip_api_group, const HipAPIGroup& r_hip_api_group);
 
  public:
-  HipAPIGroup(std::string group_name, std::vector<HipAPI>& hip_apis);
+  // The group refers to the APIs in hip_apis, which has to outlive it.
+  HipAPIGroup(std::string group_name, const std::vector<HipAPI>& hip_apis);
   std::string getName() const;
   int getTotalNumberOfAPIs() const;
   int getTotalNumberOfCalls() const;
@@ -37,9 +38,10 @@ class HipAPIGroup{
   int getNumberOfNotCalledAPIs() const;
   int getNumberOfDeprecatedAPIs() const;
   float getPercentageOfCalledAPIs() const;
-  std::string getBasicStatsXML() const;
-  std::string getBasicStatsHTML() const;
-  std::string createHTMLReport() const;
+  // Report writers stream into the passed output, nothing is built in memory.
+  void writeBasicStatsXML(std::ostream& xml_node) const;
+  void writeBasicStatsHTML(std::ostream& html_object) const;
+  void writeHTMLReport(std::ostream& html_report) const;
  private:
   std::string group_name;
   int total_number_of_apis;
@@ -47,7 +49,7 @@ class HipAPIGroup{
   float percentage_of_called_apis;
   int number_of_test_cases;
   std::string parent_group_name;
-  std::vector<HipAPI> called_apis;
-  std::vector<HipAPI> not_called_apis;
-  std::vector<HipAPI> deprecated_apis;
+  std::vector<const HipAPI*> called_apis;
+  std::vector<const HipAPI*> not_called_apis;
+  std::vector<const HipAPI*> deprecated_apis;
 };
@@ -24,9 +24,11 @@ THE SOFTWARE.
 
 int main(int argc, char** argv)
 {
-  if (argc != 2) {
+  bool full_rebuild{argc == 3 && std::string{argv[2]} == "--full"};
+  if (argc != 2 && !full_rebuild) {
     std::cout << "Please provide the path to the cloned HIP/include/ directory as an argument! Only one argument supported." << std::endl;
     std::cout << "\tExample: ./generateHipAPICoverage /workspace/user1/HIP/include/" << std::endl;
+    std::cout << "\tAdd --full to ignore the index of the previous run in CoverageIndex.txt." << std::endl;
     return -1;
   }
   std::string hip_include_path = argv[1];
@@ -51,9 +53,26 @@ int main(int argc, char** argv)
   std::cout << "Searching for HIP API calls in source files within " << tests_root_directory << "." <<  std::endl;
   std::vector<std::string> test_module_files{extractTestModuleFiles(tests_root_directory)};
 
-  // Search for each HIP API in the extracted test .cc files.
+  /*
+  Read the extracted test .cc files once and resolve each HIP API against their index.
+  Files that did not change since the previous run are taken from its index cache, and
+  only the HTML pages of APIs they affect are written again. A change of the header
+  files regenerates all pages.
+  */
+  std::string index_cache_file{"CoverageIndex.txt"};
+  TestModuleCache test_module_cache;
+  if (!full_rebuild) {
+    test_module_cache = loadTestModuleCache(index_cache_file);
+  }
+  std::string header_stamp{findFileStamp(hip_api_header_file) + "_" + findFileStamp(hip_rtc_header_file)};
+  bool headers_changed{test_module_cache.header_stamp != header_stamp};
+  test_module_cache.header_stamp = header_stamp;
+
+  std::set<std::string> changed_apis;
+  TestModuleIndex test_module_index{indexTestModuleFiles(test_module_files, test_module_cache, changed_apis)};
+  storeTestModuleCache(index_cache_file, test_module_cache);
   for(HipAPI& hip_api: hip_apis) {
-    searchForAPI(hip_api, test_module_files);
+    searchForAPI(hip_api, test_module_index);
   }
 
   std::vector<HipAPIGroup> hip_api_groups;
@@ -68,7 +87,8 @@ int main(int argc, char** argv)
   std::cout << "Generating XML report files." << std::endl;
   generateXMLReportFiles(hip_apis, hip_api_groups);
   std::cout << "Generating HTML report files." << std::endl;
-  generateHTMLReportFiles(hip_apis, hip_api_groups, tests_root_directory, hip_api_header_file, hip_rtc_header_file);
+  generateHTMLReportFiles(hip_apis, hip_api_groups, tests_root_directory, hip_api_header_file, hip_rtc_header_file,
+                          headers_changed ? nullptr : &changed_apis);
 
   return 0;
 }
@@ -92,7 +92,7 @@ void generateXMLReportFiles(std::vector<HipAPI>& hip_apis, std::vector<HipAPIGro
   coverage_report << "\n</COVERAGE-RESULTS>";
 
   for (auto const& hip_api_group: hip_api_groups) {
-      coverage_report << hip_api_group.getBasicStatsHTML();
+      hip_api_group.writeBasicStatsHTML(coverage_report);
   }
 
   coverage_report.close();
@@ -100,9 +100,23 @@ void generateXMLReportFiles(std::vector<HipAPI>& hip_apis, std::vector<HipAPIGro
 }
 
 void generateHTMLReportFiles(std::vector<HipAPI>& hip_apis, std::vector<HipAPIGroup>& hip_api_groups,
-                             std::string tests_root_directory, std::string hipApiHeaderFile, std::string hip_rtc_header_file) {
+                             std::string tests_root_directory, std::string hipApiHeaderFile, std::string hip_rtc_header_file,
+                             const std::set<std::string>* changed_apis) {
   BasicAPIStats basic_stats{hip_api_groups};
 
+  // Groups whose page has to be written again, because one of their APIs changed.
+  std::set<std::string> changed_groups;
+  if (changed_apis != nullptr) {
+    for (auto const& hip_api: hip_apis) {
+      if (changed_apis->count(hip_api.getName())) {
+        changed_groups.insert(hip_api.getGroupName());
+      }
+    }
+  }
+  auto is_outdated = [changed_apis](bool changed, const std::string& page) {
+    return changed_apis == nullptr || changed || !std::filesystem::exists(page);
+  };
+
   std::fstream coverage_report;
   // Main HTML report file.
   std::string report_file_name{"./coverageReportHTML/CoverageReport.html"};
@@ -252,17 +266,22 @@ void generateHTMLReportFiles(std::vector<HipAPI>& hip_apis, std::vector<HipAPIGr
   /*
   Get basic stats for each API Group in HTML format and append it to the main HTML.
   Create an HTML page for each API Group for more detailed information, as they are
-  used as hyperlinks from the main HTML page.
+  used as hyperlinks from the main HTML page. Group pages are independent files and
+  are written in parallel.
   */
   for (auto const& hip_api_group: hip_api_groups) {
-    coverage_report << hip_api_group.getBasicStatsHTML();
-
+    hip_api_group.writeBasicStatsHTML(coverage_report);
+  }
+  parallelFor(hip_api_groups.size(), [&](size_t i) {
     std::fstream coverage_module_report;
-    std::string report_module_file_name{test_modules_directory + "/" + hip_api_group.getName() + ".html"};
+    std::string report_module_file_name{test_modules_directory + "/" + hip_api_groups[i].getName() + ".html"};
+    if (!is_outdated(changed_groups.count(hip_api_groups[i].getName()) > 0, report_module_file_name)) {
+      return;
+    }
     coverage_module_report.open(report_module_file_name, std::ios::out);
-    coverage_module_report << hip_api_group.createHTMLReport();
+    hip_api_groups[i].writeHTMLReport(coverage_module_report);
     coverage_module_report.close();
-  }
+  });
 
   coverage_report << two_tabs << "<tr>";
   coverage_report << three_tabs << "<td></td>";
@@ -295,13 +314,17 @@ void generateHTMLReportFiles(std::vector<HipAPI>& hip_apis, std::vector<HipAPIGr
   coverage_report.close();
 
   // Create HTML report for each API, as they are used as hyperlinks from Groups HTML.
-  for (auto const& hip_api: hip_apis) {
+  parallelFor(hip_apis.size(), [&](size_t i) {
     std::fstream coverage_api_report;
-    std::string report_api_file_name{test_apis_directory + "/" + hip_api.getName() + ".html"};
+    std::string report_api_file_name{test_apis_directory + "/" + hip_apis[i].getName() + ".html"};
+    bool changed{changed_apis != nullptr && changed_apis->count(hip_apis[i].getName()) > 0};
+    if (!is_outdated(changed, report_api_file_name)) {
+      return;
+    }
     coverage_api_report.open(report_api_file_name, std::ios::out);
-    coverage_api_report << hip_api.createHTMLReport();
+    hip_apis[i].writeHTMLReport(coverage_api_report);
     coverage_api_report.close();
-  }
+  });
 
   std::cout << "Generated HTML report file " << findAbsolutePathOfFile(report_file_name) << std::endl;
 }
@@ -37,5 +37,10 @@ class BasicAPIStats {
 };
 
 void generateXMLReportFiles(std::vector<HipAPI>& hip_apis, std::vector<HipAPIGroup>& hip_api_groups);
+/*
+If changed_apis is passed, only the pages of these APIs, of the groups containing them and
+pages that do not exist yet are written. The main report is always written.
+*/
 void generateHTMLReportFiles(std::vector<HipAPI>& hip_apis, std::vector<HipAPIGroup>& hip_api_groups,
-  std::string tests_root_directory, std::string hipApiHeaderFile, std::string hip_rtc_header_file);
+  std::string tests_root_directory, std::string hipApiHeaderFile, std::string hip_rtc_header_file,
+  const std::set<std::string>* changed_apis = nullptr);
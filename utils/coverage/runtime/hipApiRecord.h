@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+/*
+Layout of the API call recordings written by libhipApiTrace.so with HIP_API_RECORD set and
+replayed by the hipPerfApiReplay perftest. Only fixed size integers, in the byte order of
+the recording host:
+
+  FileHeader
+  apiCount names, each a uint8_t length followed by the characters
+  records until the end of the file, each a RecordHeader and argCount uint64_t words
+
+Records reference the name table, so the API list of the recorder can change without
+breaking older recordings. They are sorted by sequence, the order in which the calls
+returned, over all threads of the process. Arguments are the call's parameters as 64 bit
+words in declaration order; output parameters (allocated pointers, created handles, pitch)
+hold the value after the call, dim3 takes two words (x | y << 32, z) and hipExtent three.
+*/
+
+#include <cstdint>
+
+namespace hipApiRecord {
+
+constexpr char kMagic[8] = {'H', 'I', 'P', 'A', 'P', 'I', 'R', 'C'};
+constexpr uint32_t kVersion = 1;
+constexpr uint8_t kMaxArgs = 16;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t apiCount;
+};
+
+struct RecordHeader {
+  uint64_t sequence;
+  uint64_t startNs;  // Steady clock, the replay only uses differences
+  uint64_t endNs;
+  uint32_t thread;   // Recording thread, numbered from 0 in order of their first call
+  uint16_t api;      // Index into the name table
+  uint8_t argCount;
+  uint8_t failed;    // The call did not return hipSuccess
+};
+
+static_assert(sizeof(FileHeader) == 16, "FileHeader must not be padded");
+static_assert(sizeof(RecordHeader) == 32, "RecordHeader must not be padded");
+
+}  // namespace hipApiRecord
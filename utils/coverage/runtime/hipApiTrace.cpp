@@ -0,0 +1,600 @@
+/*
+Copyright (c) 2022 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/*
+Runtime HIP API coverage. Built as libhipApiTrace.so (make trace) and preloaded into
+test executables, it intercepts the HIP APIs listed in HIP_TRACED_APIS, counts how often
+each one is called, how often it failed and which argument classes it saw: sizes in power
+of two buckets and the flags, kind or attribute argument. Unlike the source scan of
+generateHipAPICoverage this shows what the suite actually executes, and how hard.
+
+  HIP_API_TRACE=trace.csv LD_PRELOAD=/path/to/libhipApiTrace.so ctest
+
+Counting goes to a per thread table without locks. The tables of all threads are summed
+when the process exits and merged into HIP_API_TRACE (default hip_api_trace.csv in the
+working directory), so the processes of a ctest run accumulate into one report. Rows are
+"api,kind,value,count": kind is calls, errors, size or flags, value is the size range in
+bytes or the flags value; APIs are ordered by number of calls.
+
+With HIP_API_RECORD=<file> every intercepted call is also recorded with its arguments and
+start and end time, in the layout of hipApiRecord.h, for hipPerfApiReplay to replay:
+
+  HIP_API_RECORD=app.%p.hiprec LD_PRELOAD=/path/to/libhipApiTrace.so ./app
+
+Records are kept in per thread buffers and written when the process exits, %p in the name is
+replaced by the process id so the processes of a run do not overwrite each other. Without
+the variable no clock is read and nothing is kept.
+
+Only APIs exported by libamdhip64 can be intercepted, on the NVIDIA platform the HIP API is
+inlined into CUDA calls.
+*/
+
+#include <hip/hip_runtime_api.h>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "hipApiRecord.h"
+
+namespace {
+constexpr size_t kNoSize = SIZE_MAX;
+constexpr unsigned long long kNoFlags = ~0ull;
+}  // namespace
+
+/*
+X(name, parameters, arguments, size in bytes or kNoSize, flags or kNoFlags)
+The parameter names are visible to the size and flags expressions.
+*/
+#define HIP_TRACED_APIS(X)                                                                        \
+  X(hipMalloc, (void** ptr, size_t size), (ptr, size), size, kNoFlags)                            \
+  X(hipMallocManaged, (void** ptr, size_t size, unsigned int flags), (ptr, size, flags), size,    \
+    flags)                                                                                        \
+  X(hipHostMalloc, (void** ptr, size_t size, unsigned int flags), (ptr, size, flags), size,       \
+    flags)                                                                                        \
+  X(hipExtMallocWithFlags, (void** ptr, size_t size, unsigned int flags), (ptr, size, flags),     \
+    size, flags)                                                                                  \
+  X(hipMallocPitch, (void** ptr, size_t* pitch, size_t width, size_t height),                     \
+    (ptr, pitch, width, height), width * height, kNoFlags)                                        \
+  X(hipMalloc3D, (hipPitchedPtr * ptr, hipExtent extent), (ptr, extent),                          \
+    extent.width * extent.height * extent.depth, kNoFlags)                                        \
+  X(hipMallocAsync, (void** ptr, size_t size, hipStream_t stream), (ptr, size, stream), size,     \
+    kNoFlags)                                                                                     \
+  X(hipHostRegister, (void* ptr, size_t size, unsigned int flags), (ptr, size, flags), size,      \
+    flags)                                                                                        \
+  X(hipHostUnregister, (void* ptr), (ptr), kNoSize, kNoFlags)                                     \
+  X(hipFree, (void* ptr), (ptr), kNoSize, kNoFlags)                                               \
+  X(hipHostFree, (void* ptr), (ptr), kNoSize, kNoFlags)                                           \
+  X(hipFreeAsync, (void* ptr, hipStream_t stream), (ptr, stream), kNoSize, kNoFlags)              \
+  X(hipMemGetInfo, (size_t * free, size_t* total), (free, total), kNoSize, kNoFlags)              \
+  X(hipPointerGetAttributes, (hipPointerAttribute_t * attributes, const void* ptr),               \
+    (attributes, ptr), kNoSize, kNoFlags)                                                         \
+  X(hipMemcpy, (void* dst, const void* src, size_t size, hipMemcpyKind kind),                     \
+    (dst, src, size, kind), size, kind)                                                           \
+  X(hipMemcpyAsync,                                                                               \
+    (void* dst, const void* src, size_t size, hipMemcpyKind kind, hipStream_t stream),            \
+    (dst, src, size, kind, stream), size, kind)                                                   \
+  X(hipMemcpyWithStream,                                                                          \
+    (void* dst, const void* src, size_t size, hipMemcpyKind kind, hipStream_t stream),            \
+    (dst, src, size, kind, stream), size, kind)                                                   \
+  X(hipMemcpyHtoD, (hipDeviceptr_t dst, void* src, size_t size), (dst, src, size), size,          \
+    kNoFlags)                                                                                     \
+  X(hipMemcpyDtoH, (void* dst, hipDeviceptr_t src, size_t size), (dst, src, size), size,          \
+    kNoFlags)                                                                                     \
+  X(hipMemcpyDtoD, (hipDeviceptr_t dst, hipDeviceptr_t src, size_t size), (dst, src, size), size, \
+    kNoFlags)                                                                                     \
+  X(hipMemcpyHtoDAsync, (hipDeviceptr_t dst, void* src, size_t size, hipStream_t stream),         \
+    (dst, src, size, stream), size, kNoFlags)                                                     \
+  X(hipMemcpyDtoHAsync, (void* dst, hipDeviceptr_t src, size_t size, hipStream_t stream),         \
+    (dst, src, size, stream), size, kNoFlags)                                                     \
+  X(hipMemcpyDtoDAsync,                                                                           \
+    (hipDeviceptr_t dst, hipDeviceptr_t src, size_t size, hipStream_t stream),                    \
+    (dst, src, size, stream), size, kNoFlags)                                                     \
+  X(hipMemcpyPeer, (void* dst, int dst_device, const void* src, int src_device, size_t size),     \
+    (dst, dst_device, src, src_device, size), size, kNoFlags)                                     \
+  X(hipMemcpyPeerAsync,                                                                           \
+    (void* dst, int dst_device, const void* src, int src_device, size_t size,                     \
+     hipStream_t stream),                                                                         \
+    (dst, dst_device, src, src_device, size, stream), size, kNoFlags)                             \
+  X(hipMemcpy2D,                                                                                  \
+    (void* dst, size_t dpitch, const void* src, size_t spitch, size_t width, size_t height,       \
+     hipMemcpyKind kind),                                                                         \
+    (dst, dpitch, src, spitch, width, height, kind), width * height, kind)                        \
+  X(hipMemcpy2DAsync,                                                                             \
+    (void* dst, size_t dpitch, const void* src, size_t spitch, size_t width, size_t height,       \
+     hipMemcpyKind kind, hipStream_t stream),                                                     \
+    (dst, dpitch, src, spitch, width, height, kind, stream), width * height, kind)                \
+  X(hipMemset, (void* dst, int value, size_t size), (dst, value, size), size, kNoFlags)           \
+  X(hipMemsetAsync, (void* dst, int value, size_t size, hipStream_t stream),                      \
+    (dst, value, size, stream), size, kNoFlags)                                                   \
+  X(hipMemsetD8, (hipDeviceptr_t dst, unsigned char value, size_t count), (dst, value, count),    \
+    count, kNoFlags)                                                                              \
+  X(hipMemsetD16, (hipDeviceptr_t dst, unsigned short value, size_t count),                       \
+    (dst, value, count), count * 2, kNoFlags)                                                     \
+  X(hipMemsetD32, (hipDeviceptr_t dst, int value, size_t count), (dst, value, count), count * 4,  \
+    kNoFlags)                                                                                     \
+  X(hipMemsetD8Async,                                                                             \
+    (hipDeviceptr_t dst, unsigned char value, size_t count, hipStream_t stream),                  \
+    (dst, value, count, stream), count, kNoFlags)                                                 \
+  X(hipMemsetD16Async,                                                                            \
+    (hipDeviceptr_t dst, unsigned short value, size_t count, hipStream_t stream),                 \
+    (dst, value, count, stream), count * 2, kNoFlags)                                             \
+  X(hipMemsetD32Async, (hipDeviceptr_t dst, int value, size_t count, hipStream_t stream),         \
+    (dst, value, count, stream), count * 4, kNoFlags)                                             \
+  X(hipMemset2D, (void* dst, size_t pitch, int value, size_t width, size_t height),               \
+    (dst, pitch, value, width, height), width * height, kNoFlags)                                 \
+  X(hipMemset2DAsync,                                                                             \
+    (void* dst, size_t pitch, int value, size_t width, size_t height, hipStream_t stream),        \
+    (dst, pitch, value, width, height, stream), width * height, kNoFlags)                         \
+  X(hipMemPrefetchAsync, (const void* ptr, size_t size, int device, hipStream_t stream),          \
+    (ptr, size, device, stream), size, kNoFlags)                                                  \
+  X(hipMemAdvise, (const void* ptr, size_t size, hipMemoryAdvise advice, int device),             \
+    (ptr, size, advice, device), size, advice)                                                    \
+  X(hipStreamCreate, (hipStream_t * stream), (stream), kNoSize, kNoFlags)                         \
+  X(hipStreamCreateWithFlags, (hipStream_t * stream, unsigned int flags), (stream, flags),        \
+    kNoSize, flags)                                                                               \
+  X(hipStreamCreateWithPriority, (hipStream_t * stream, unsigned int flags, int priority),        \
+    (stream, flags, priority), kNoSize, flags)                                                    \
+  X(hipStreamDestroy, (hipStream_t stream), (stream), kNoSize, kNoFlags)                          \
+  X(hipStreamSynchronize, (hipStream_t stream), (stream), kNoSize, kNoFlags)                      \
+  X(hipStreamQuery, (hipStream_t stream), (stream), kNoSize, kNoFlags)                            \
+  X(hipStreamWaitEvent, (hipStream_t stream, hipEvent_t event, unsigned int flags),               \
+    (stream, event, flags), kNoSize, flags)                                                       \
+  X(hipEventCreate, (hipEvent_t * event), (event), kNoSize, kNoFlags)                             \
+  X(hipEventCreateWithFlags, (hipEvent_t * event, unsigned int flags), (event, flags), kNoSize,   \
+    flags)                                                                                        \
+  X(hipEventRecord, (hipEvent_t event, hipStream_t stream), (event, stream), kNoSize, kNoFlags)   \
+  X(hipEventSynchronize, (hipEvent_t event), (event), kNoSize, kNoFlags)                          \
+  X(hipEventQuery, (hipEvent_t event), (event), kNoSize, kNoFlags)                                \
+  X(hipEventElapsedTime, (float* ms, hipEvent_t start, hipEvent_t stop), (ms, start, stop),       \
+    kNoSize, kNoFlags)                                                                            \
+  X(hipEventDestroy, (hipEvent_t event), (event), kNoSize, kNoFlags)                              \
+  X(hipSetDevice, (int device), (device), kNoSize, kNoFlags)                                      \
+  X(hipGetDevice, (int* device), (device), kNoSize, kNoFlags)                                     \
+  X(hipGetDeviceCount, (int* count), (count), kNoSize, kNoFlags)                                  \
+  X(hipDeviceSynchronize, (void), (), kNoSize, kNoFlags)                                          \
+  X(hipDeviceReset, (void), (), kNoSize, kNoFlags)                                                \
+  X(hipDeviceGetAttribute, (int* value, hipDeviceAttribute_t attribute, int device),              \
+    (value, attribute, device), kNoSize, attribute)                                               \
+  X(hipDeviceCanAccessPeer, (int* can_access, int device, int peer_device),                       \
+    (can_access, device, peer_device), kNoSize, kNoFlags)                                         \
+  X(hipDeviceEnablePeerAccess, (int peer_device, unsigned int flags), (peer_device, flags),       \
+    kNoSize, flags)                                                                               \
+  X(hipGetLastError, (void), (), kNoSize, kNoFlags)                                               \
+  X(hipPeekAtLastError, (void), (), kNoSize, kNoFlags)                                            \
+  X(hipLaunchKernel,                                                                              \
+    (const void* function, dim3 blocks, dim3 threads, void** args, size_t shared_memory,          \
+     hipStream_t stream),                                                                         \
+    (function, blocks, threads, args, shared_memory, stream), shared_memory, kNoFlags)            \
+  X(hipModuleLoad, (hipModule_t * module, const char* file_name), (module, file_name), kNoSize,   \
+    kNoFlags)                                                                                     \
+  X(hipModuleLoadData, (hipModule_t * module, const void* image), (module, image), kNoSize,       \
+    kNoFlags)                                                                                     \
+  X(hipModuleGetFunction, (hipFunction_t * function, hipModule_t module, const char* name),       \
+    (function, module, name), kNoSize, kNoFlags)                                                  \
+  X(hipModuleUnload, (hipModule_t module), (module), kNoSize, kNoFlags)                           \
+  X(hipModuleLaunchKernel,                                                                        \
+    (hipFunction_t function, unsigned int grid_x, unsigned int grid_y, unsigned int grid_z,       \
+     unsigned int block_x, unsigned int block_y, unsigned int block_z,                            \
+     unsigned int shared_memory, hipStream_t stream, void** args, void** extra),                  \
+    (function, grid_x, grid_y, grid_z, block_x, block_y, block_z, shared_memory, stream, args,    \
+     extra),                                                                                      \
+    shared_memory, kNoFlags)                                                                      \
+  X(hipGraphCreate, (hipGraph_t * graph, unsigned int flags), (graph, flags), kNoSize, flags)     \
+  X(hipGraphInstantiate,                                                                          \
+    (hipGraphExec_t * graph_exec, hipGraph_t graph, hipGraphNode_t* error_node, char* log,        \
+     size_t log_size),                                                                            \
+    (graph_exec, graph, error_node, log, log_size), kNoSize, kNoFlags)                            \
+  X(hipGraphLaunch, (hipGraphExec_t graph_exec, hipStream_t stream), (graph_exec, stream),        \
+    kNoSize, kNoFlags)                                                                            \
+  X(hipGraphExecDestroy, (hipGraphExec_t graph_exec), (graph_exec), kNoSize, kNoFlags)            \
+  X(hipGraphDestroy, (hipGraph_t graph), (graph), kNoSize, kNoFlags)
+
+namespace {
+#define HIP_TRACE_ID(name, ...) name,
+enum ApiId { HIP_TRACED_APIS(HIP_TRACE_ID) kApiCount };
+#undef HIP_TRACE_ID
+
+#define HIP_TRACE_NAME(name, ...) #name,
+const char* kApiNames[] = {HIP_TRACED_APIS(HIP_TRACE_NAME)};
+#undef HIP_TRACE_NAME
+
+// Bucket 0 counts zero sizes, bucket k sizes in [2^(k-1), 2^k)
+constexpr size_t kSizeClasses = 65;
+// Distinct flag values kept per thread and API, the rest is counted as "other"
+constexpr size_t kFlagSlots = 8;
+
+/*
+Counters of one API in one thread. Only the owning thread writes, the atomics only make
+the final read at exit well defined.
+*/
+struct ApiStats {
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> errors{0};
+  std::array<std::atomic<uint64_t>, kSizeClasses> sizes{};
+  std::array<std::atomic<unsigned long long>, kFlagSlots> flag_values{};
+  std::array<std::atomic<uint64_t>, kFlagSlots> flag_counts{};
+  std::atomic<uint64_t> other_flags{0};
+};
+
+struct ThreadTable {
+  std::array<ApiStats, kApiCount> apis;
+};
+
+// Tables are never freed, threads that exited before the process still get reported.
+std::mutex& tablesMutex() {
+  static std::mutex* mutex = new std::mutex();
+  return *mutex;
+}
+
+std::vector<ThreadTable*>& tables() {
+  static std::vector<ThreadTable*>* tables = new std::vector<ThreadTable*>();
+  return *tables;
+}
+
+ThreadTable& threadTable() {
+  thread_local ThreadTable* table = [] {
+    auto table = new ThreadTable();
+    std::lock_guard<std::mutex> lock(tablesMutex());
+    tables().push_back(table);
+    return table;
+  }();
+  return *table;
+}
+
+size_t sizeClass(size_t size) {
+  return size == 0 ? 0 : 64 - __builtin_clzll(static_cast<unsigned long long>(size));
+}
+
+void record(ApiId api, hipError_t result, size_t size, unsigned long long flags) {
+  auto& stats = threadTable().apis[api];
+  stats.calls.fetch_add(1, std::memory_order_relaxed);
+  if (result != hipSuccess) stats.errors.fetch_add(1, std::memory_order_relaxed);
+  if (size != kNoSize) stats.sizes[sizeClass(size)].fetch_add(1, std::memory_order_relaxed);
+  if (flags == kNoFlags) return;
+
+  for (size_t i = 0; i < kFlagSlots; ++i) {
+    if (stats.flag_counts[i].load(std::memory_order_relaxed) == 0) {
+      stats.flag_values[i].store(flags, std::memory_order_relaxed);
+    } else if (stats.flag_values[i].load(std::memory_order_relaxed) != flags) {
+      continue;
+    }
+    stats.flag_counts[i].fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  stats.other_flags.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* realSymbol(const char* name) {
+  void* symbol = dlsym(RTLD_NEXT, name);
+  if (symbol == nullptr) {
+    fprintf(stderr, "hipApiTrace: %s not found in the HIP runtime\n", name);
+    abort();
+  }
+  return symbol;
+}
+
+std::string sizeRange(size_t size_class) {
+  if (size_class == 0) return "0";
+  unsigned long long low = 1ull << (size_class - 1);
+  unsigned long long high = size_class == 64 ? ~0ull : (1ull << size_class) - 1;
+  return std::to_string(low) + "-" + std::to_string(high);
+}
+
+// (api, kind, value) -> count
+using Report = std::map<std::tuple<std::string, std::string, std::string>, uint64_t>;
+
+void collect(Report& report) {
+  std::lock_guard<std::mutex> lock(tablesMutex());
+  for (auto table : tables()) {
+    for (size_t api = 0; api < kApiCount; ++api) {
+      const auto& stats = table->apis[api];
+      uint64_t calls = stats.calls.load(std::memory_order_relaxed);
+      if (calls == 0) continue;
+      std::string name = kApiNames[api];
+      report[{name, "calls", ""}] += calls;
+      report[{name, "errors", ""}] += stats.errors.load(std::memory_order_relaxed);
+      for (size_t i = 0; i < kSizeClasses; ++i) {
+        uint64_t count = stats.sizes[i].load(std::memory_order_relaxed);
+        if (count) report[{name, "size", sizeRange(i)}] += count;
+      }
+      for (size_t i = 0; i < kFlagSlots; ++i) {
+        uint64_t count = stats.flag_counts[i].load(std::memory_order_relaxed);
+        if (count) {
+          report[{name, "flags", std::to_string(stats.flag_values[i].load())}] += count;
+        }
+      }
+      uint64_t other = stats.other_flags.load(std::memory_order_relaxed);
+      if (other) report[{name, "flags", "other"}] += other;
+    }
+  }
+}
+
+void parse(const std::string& contents, Report& report) {
+  std::istringstream stream(contents);
+  std::string line;
+  std::getline(stream, line);  // header
+  while (std::getline(stream, line)) {
+    std::vector<std::string> fields;
+    std::istringstream line_stream(line);
+    for (std::string field; std::getline(line_stream, field, ',');) fields.push_back(field);
+    if (line.back() == ',') fields.push_back("");
+    if (fields.size() != 4) continue;
+    report[{fields[0], fields[1], fields[2]}] += std::strtoull(fields[3].c_str(), nullptr, 10);
+  }
+}
+
+std::string format(const Report& report) {
+  std::map<std::string, uint64_t> calls;
+  for (const auto& row : report) {
+    if (std::get<1>(row.first) == "calls") calls[std::get<0>(row.first)] = row.second;
+  }
+  // Most called APIs first, rows of one API in kind order and sizes ascending
+  std::vector<std::pair<std::tuple<std::string, std::string, std::string>, uint64_t>> rows(
+      report.begin(), report.end());
+  auto kind_order = [](const std::string& kind) {
+    return kind == "calls" ? 0 : kind == "errors" ? 1 : kind == "size" ? 2 : 3;
+  };
+  std::stable_sort(rows.begin(), rows.end(), [&](const auto& a, const auto& b) {
+    const auto& a_api = std::get<0>(a.first);
+    const auto& b_api = std::get<0>(b.first);
+    if (a_api != b_api) {
+      return calls[a_api] != calls[b_api] ? calls[a_api] > calls[b_api] : a_api < b_api;
+    }
+    int a_kind = kind_order(std::get<1>(a.first));
+    int b_kind = kind_order(std::get<1>(b.first));
+    if (a_kind != b_kind || a_kind != 2) return a_kind < b_kind;
+    return std::strtoull(std::get<2>(a.first).c_str(), nullptr, 10) <
+        std::strtoull(std::get<2>(b.first).c_str(), nullptr, 10);
+  });
+
+  std::string out = "api,kind,value,count\n";
+  for (const auto& row : rows) {
+    out += std::get<0>(row.first) + "," + std::get<1>(row.first) + "," +
+        std::get<2>(row.first) + "," + std::to_string(row.second) + "\n";
+  }
+  return out;
+}
+
+// Merges the counters of this process into the report file, serialized by an flock
+__attribute__((destructor)) void flushTrace() {
+  Report report;
+  collect(report);
+  if (report.empty()) return;
+
+  const char* env_path = getenv("HIP_API_TRACE");
+  std::string path = env_path != nullptr && env_path[0] != '\0' ? env_path : "hip_api_trace.csv";
+  int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0 || flock(fd, LOCK_EX) != 0) {
+    fprintf(stderr, "hipApiTrace: can not write %s\n", path.c_str());
+    if (fd >= 0) close(fd);
+    return;
+  }
+
+  std::string contents;
+  char buffer[4096];
+  for (ssize_t n; (n = read(fd, buffer, sizeof(buffer))) > 0;) contents.append(buffer, n);
+  parse(contents, report);
+
+  std::string out = format(report);
+  if (ftruncate(fd, 0) == 0 && lseek(fd, 0, SEEK_SET) == 0) {
+    for (size_t written = 0; written < out.size();) {
+      ssize_t n = write(fd, out.data() + written, out.size() - written);
+      if (n <= 0) break;
+      written += n;
+    }
+  }
+  flock(fd, LOCK_UN);
+  close(fd);
+}
+
+// Recording behind HIP_API_RECORD
+
+const char* recordPath() {
+  static const char* path = [] {
+    const char* env_path = getenv("HIP_API_RECORD");
+    return env_path != nullptr && env_path[0] != '\0' ? env_path : nullptr;
+  }();
+  return path;
+}
+
+uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Records of one thread. The mutex is only contended when the process exits while the thread
+// still makes calls.
+struct RecordBuffer {
+  std::mutex mutex;
+  std::vector<uint8_t> bytes;
+  uint32_t thread = 0;
+};
+
+std::vector<RecordBuffer*>& recordBuffers() {
+  static std::vector<RecordBuffer*>* buffers = new std::vector<RecordBuffer*>();
+  return *buffers;
+}
+
+std::atomic<uint64_t> recordSequence{0};
+
+RecordBuffer& recordBuffer() {
+  thread_local RecordBuffer* buffer = [] {
+    auto buffer = new RecordBuffer();
+    std::lock_guard<std::mutex> lock(tablesMutex());
+    buffer->thread = static_cast<uint32_t>(recordBuffers().size());
+    recordBuffers().push_back(buffer);
+    return buffer;
+  }();
+  return *buffer;
+}
+
+// Arguments of a call as the words of the record
+struct ArgWords {
+  uint64_t words[hipApiRecord::kMaxArgs];
+  uint8_t count = 0;
+  bool outputs = true;  // Whether pointers to pointers are output parameters
+  void push(uint64_t word) {
+    if (count < hipApiRecord::kMaxArgs) words[count++] = word;
+  }
+};
+
+template <typename T> void pack(ArgWords& out, T value) { out.push(static_cast<uint64_t>(value)); }
+template <typename T> void pack(ArgWords& out, T* ptr) {
+  out.push(reinterpret_cast<uintptr_t>(ptr));
+}
+// Pointers to pointers and handles are output parameters, keep the value the call stored.
+// Kernel argument arrays are not, they are not read.
+template <typename T> void pack(ArgWords& out, T** ptr) {
+  if (!out.outputs || ptr == nullptr) {
+    out.push(reinterpret_cast<uintptr_t>(ptr));
+  } else {
+    out.push(reinterpret_cast<uintptr_t>(*ptr));
+  }
+}
+void pack(ArgWords& out, size_t* pitch) { out.push(pitch != nullptr ? *pitch : 0); }
+void pack(ArgWords& out, dim3 dims) {
+  out.push(dims.x | static_cast<uint64_t>(dims.y) << 32);
+  out.push(dims.z);
+}
+void pack(ArgWords& out, hipExtent extent) {
+  out.push(extent.width);
+  out.push(extent.height);
+  out.push(extent.depth);
+}
+void pack(ArgWords& out, hipPitchedPtr* ptr) {
+  out.push(ptr != nullptr ? reinterpret_cast<uintptr_t>(ptr->ptr) : 0);
+  out.push(ptr != nullptr ? ptr->pitch : 0);
+}
+
+// Capture(api, result, start)(arguments...) appends the record of a call that just returned
+class Capture {
+ public:
+  Capture(ApiId api, hipError_t result, uint64_t start_ns)
+      : api_(api), result_(result), start_ns_(start_ns) {}
+
+  template <typename... Args> void operator()(Args... args) const {
+    ArgWords words;
+    words.outputs = api_ != ApiId::hipLaunchKernel && api_ != ApiId::hipModuleLaunchKernel;
+    (pack(words, args), ...);
+    hipApiRecord::RecordHeader header{};
+    header.startNs = start_ns_;
+    header.endNs = nowNs();
+    header.api = static_cast<uint16_t>(api_);
+    header.argCount = words.count;
+    header.failed = result_ != hipSuccess;
+
+    auto& buffer = recordBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    header.sequence = recordSequence.fetch_add(1, std::memory_order_relaxed);
+    header.thread = buffer.thread;
+    auto bytes = reinterpret_cast<const uint8_t*>(&header);
+    buffer.bytes.insert(buffer.bytes.end(), bytes, bytes + sizeof(header));
+    bytes = reinterpret_cast<const uint8_t*>(words.words);
+    buffer.bytes.insert(buffer.bytes.end(), bytes, bytes + words.count * sizeof(uint64_t));
+  }
+
+ private:
+  ApiId api_;
+  hipError_t result_;
+  uint64_t start_ns_;
+};
+
+// Writes the records of all threads in sequence order
+__attribute__((destructor)) void flushRecord() {
+  if (recordPath() == nullptr) return;
+  std::string path = recordPath();
+  for (size_t at; (at = path.find("%p")) != std::string::npos;) {
+    path.replace(at, 2, std::to_string(getpid()));
+  }
+
+  std::lock_guard<std::mutex> tables_lock(tablesMutex());
+  std::vector<std::unique_lock<std::mutex>> locks;
+  // (sequence, record start, record size)
+  std::vector<std::tuple<uint64_t, const uint8_t*, size_t>> records;
+  for (auto buffer : recordBuffers()) {
+    locks.emplace_back(buffer->mutex);
+    const uint8_t* at = buffer->bytes.data();
+    const uint8_t* end = at + buffer->bytes.size();
+    while (at < end) {
+      hipApiRecord::RecordHeader header;
+      memcpy(&header, at, sizeof(header));
+      size_t size = sizeof(header) + header.argCount * sizeof(uint64_t);
+      records.emplace_back(header.sequence, at, size);
+      at += size;
+    }
+  }
+  std::sort(records.begin(), records.end());
+
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    fprintf(stderr, "hipApiTrace: can not write %s\n", path.c_str());
+    return;
+  }
+  hipApiRecord::FileHeader header{};
+  memcpy(header.magic, hipApiRecord::kMagic, sizeof(header.magic));
+  header.version = hipApiRecord::kVersion;
+  header.apiCount = kApiCount;
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  for (auto name : kApiNames) {
+    uint8_t length = static_cast<uint8_t>(strlen(name));
+    ok = ok && fwrite(&length, 1, 1, file) == 1 && fwrite(name, 1, length, file) == length;
+  }
+  for (const auto& record : records) {
+    ok = ok && fwrite(std::get<1>(record), 1, std::get<2>(record), file) == std::get<2>(record);
+  }
+  if (fclose(file) != 0 || !ok) {
+    fprintf(stderr, "hipApiTrace: writing %s failed\n", path.c_str());
+  }
+}
+}  // namespace
+
+#define HIP_TRACE_WRAPPER(name, params, args, size, flags)                                        \
+  extern "C" hipError_t name params {                                                             \
+    using Function = hipError_t(*) params;                                                        \
+    static Function real = reinterpret_cast<Function>(realSymbol(#name));                         \
+    bool recording = recordPath() != nullptr;                                                     \
+    uint64_t start_ns = recording ? nowNs() : 0;                                                  \
+    hipError_t result = real args;                                                                \
+    record(ApiId::name, result, size, flags);                                                     \
+    if (recording) Capture(ApiId::name, result, start_ns) args;                                   \
+    return result;                                                                                \
+  }
+HIP_TRACED_APIS(HIP_TRACE_WRAPPER)
+#undef HIP_TRACE_WRAPPER
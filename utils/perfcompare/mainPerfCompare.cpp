@@ -0,0 +1,141 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "perfResult.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+/*
+Compares a perftest run (--format json output) against a stored baseline.
+A result regresses when its median is worse than the baseline median by more
+than --threshold percent and the difference is also larger than --noise
+times the larger of the two standard deviations, so jittery results need a
+clearer shift before they fail the gate.
+Exit code: 0 no regression, 1 regressions found, 2 usage or input error.
+*/
+
+static void printUsage() {
+  std::cout << "Usage: perfCompare --baseline <file> --current <file> [--threshold <percent>]"
+               " [--noise <k>] [--fail-on-missing]" << std::endl;
+  std::cout << "\tExample: ./perfCompare --baseline gfx90a.jsonl --current run.jsonl --threshold 5"
+            << std::endl;
+}
+
+static void printResult(const char* status, const PerfResult& baseline, const PerfResult& current,
+                        double change) {
+  std::cout << std::left << std::setw(12) << status << baseline.benchmark << " " << baseline.desc
+            << " size " << baseline.size << " on " << baseline.device_name << ": "
+            << baseline.median << " -> " << current.median << " " << baseline.unit << " ("
+            << std::showpos << std::fixed << std::setprecision(1) << change << "%)"
+            << std::noshowpos << std::defaultfloat << std::setprecision(6) << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::string baseline_file, current_file;
+  double threshold = 5.0;
+  double noise = 3.0;
+  bool fail_on_missing = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--baseline") && i + 1 < argc) {
+      baseline_file = argv[++i];
+    } else if (!strcmp(argv[i], "--current") && i + 1 < argc) {
+      current_file = argv[++i];
+    } else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+      threshold = std::atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--noise") && i + 1 < argc) {
+      noise = std::atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--fail-on-missing")) {
+      fail_on_missing = true;
+    } else {
+      printUsage();
+      return 2;
+    }
+  }
+  if (baseline_file.empty() || current_file.empty()) {
+    printUsage();
+    return 2;
+  }
+
+  std::map<std::string, PerfResult> baseline, current;
+  if (!loadPerfResults(baseline_file, baseline)) {
+    std::cout << "Unable to read baseline file " << baseline_file << std::endl;
+    return 2;
+  }
+  if (!loadPerfResults(current_file, current)) {
+    std::cout << "Unable to read current file " << current_file << std::endl;
+    return 2;
+  }
+
+  int regressions = 0, improvements = 0, unchanged = 0, missing = 0;
+  for (auto const& entry: baseline) {
+    const PerfResult& base = entry.second;
+    auto it = current.find(entry.first);
+    if (it == current.end()) {
+      std::cout << std::left << std::setw(12) << "MISSING" << base.benchmark << " " << base.desc
+                << " size " << base.size << " on " << base.device_name << std::endl;
+      missing++;
+      continue;
+    }
+    const PerfResult& cur = it->second;
+
+    double diff = cur.median - base.median;
+    double change = base.median != 0 ? diff / base.median * 100.0 : 0.0;
+    // Positive means worse, whichever direction is better for the unit
+    double worse = base.higherIsBetter() ? -change : change;
+    bool significant = std::fabs(diff) > noise * std::max(base.stddev, cur.stddev);
+
+    if (significant && worse > threshold) {
+      printResult("REGRESSION", base, cur, change);
+      regressions++;
+    } else if (significant && worse < -threshold) {
+      printResult("IMPROVED", base, cur, change);
+      improvements++;
+    } else {
+      unchanged++;
+    }
+  }
+
+  int added = 0;
+  for (auto const& entry: current) {
+    if (baseline.find(entry.first) == baseline.end()) {
+      added++;
+    }
+  }
+
+  std::cout << "Compared " << baseline.size() << " baseline results: " << regressions
+            << " regressed, " << improvements << " improved, " << unchanged << " unchanged, "
+            << missing << " missing, " << added << " new (threshold " << threshold
+            << "%, noise " << noise << " stddev)" << std::endl;
+
+  if (regressions > 0 || (fail_on_missing && missing > 0)) {
+    std::cout << "FAILED" << std::endl;
+    return 1;
+  }
+  std::cout << "PASSED" << std::endl;
+  return 0;
+}
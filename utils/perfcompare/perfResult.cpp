@@ -0,0 +1,197 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "perfResult.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+
+std::string PerfResult::key() const {
+  return device_name + "|" + benchmark + "|" + desc + "|" + std::to_string(size) + "|" + unit;
+}
+
+// Units other than rates per second that grow with performance
+static const std::set<std::string> higherUnits = {
+    "TFLOPS", "GFLOPS", "FMA/clk", "FMA/cycle/CU", "ops/cycle/CU", "wave ops/cycle/CU",
+    "blocks/CU", "workgroups", "fraction", "MHz"};
+
+// Matches unit itself and unit followed by a qualifier, "x" and "x one stream"
+static bool unitFamily(const std::string& unit, const char* base) {
+  size_t n = strlen(base);
+  return unit.compare(0, n, base) == 0 && (unit.size() == n || unit[n] == ' ');
+}
+
+bool PerfResult::higherIsBetter() const {
+  if (better == "higher" || better == "lower") {
+    return better == "higher";
+  }
+  if (unit.size() >= 2 && unit.compare(unit.size() - 2, 2, "/s") == 0) {
+    return true;
+  }
+  return higherUnits.count(unit) != 0 || unitFamily(unit, "x") || unitFamily(unit, "%");
+}
+
+// Reads a json string starting at the opening quote, pos ends after the closing quote.
+static bool parseString(const std::string& line, size_t& pos, std::string& value) {
+  if (pos >= line.size() || line[pos] != '"') {
+    return false;
+  }
+  value.clear();
+  for (++pos; pos < line.size(); ++pos) {
+    char c = line[pos];
+    if (c == '\\' && pos + 1 < line.size()) {
+      value += line[++pos];
+    } else if (c == '"') {
+      ++pos;
+      return true;
+    } else {
+      value += c;
+    }
+  }
+  return false;
+}
+
+// Skips a json object or array starting at pos, pos ends after its closing bracket.
+static bool skipNested(const std::string& line, size_t& pos) {
+  int depth = 0;
+  std::string ignored;
+  while (pos < line.size()) {
+    char c = line[pos];
+    if (c == '"') {
+      if (!parseString(line, pos, ignored)) {
+        return false;
+      }
+      continue;
+    }
+    ++pos;
+    if (c == '{' || c == '[') {
+      depth++;
+    } else if ((c == '}' || c == ']') && --depth == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parsePerfResult(const std::string& line, PerfResult& result) {
+  size_t pos = line.find_first_not_of(" \t");
+  if (pos == std::string::npos || line[pos] != '{') {
+    return false;
+  }
+  ++pos;
+
+  std::map<std::string, std::string> fields;
+  while (pos < line.size()) {
+    pos = line.find_first_not_of(" \t,", pos);
+    if (pos == std::string::npos) {
+      return false;
+    }
+    if (line[pos] == '}') {
+      break;
+    }
+
+    std::string name, value;
+    if (!parseString(line, pos, name)) {
+      return false;
+    }
+    pos = line.find_first_not_of(" \t", pos);
+    if (pos == std::string::npos || line[pos] != ':') {
+      return false;
+    }
+    pos = line.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string::npos) {
+      return false;
+    }
+    if (line[pos] == '"') {
+      if (!parseString(line, pos, value)) {
+        return false;
+      }
+    } else if (line[pos] == '{' || line[pos] == '[') {
+      // Nested telemetry/counters objects, kept unparsed
+      size_t start = pos;
+      if (!skipNested(line, pos)) {
+        return false;
+      }
+      value = line.substr(start, pos - start);
+    } else {
+      size_t end = line.find_first_of(",}", pos);
+      if (end == std::string::npos) {
+        return false;
+      }
+      value = line.substr(pos, end - pos);
+      pos = end;
+    }
+    fields[name] = value;
+  }
+
+  if (fields.find("benchmark") == fields.end() || fields.find("median") == fields.end()) {
+    return false;
+  }
+  result.benchmark = fields["benchmark"];
+  result.desc = fields["desc"];
+  result.device_name = fields["device_name"];
+  result.arch = fields["arch"];
+  result.host = fields["host"];
+  result.gpu_uuid = fields["gpu_uuid"];
+  result.device = std::atoi(fields["device"].c_str());
+  result.unit = fields["unit"];
+  result.better = fields["better"];
+  result.size = std::strtoull(fields["size"].c_str(), nullptr, 10);
+  result.samples = std::strtoull(fields["samples"].c_str(), nullptr, 10);
+  result.min = std::atof(fields["min"].c_str());
+  result.median = std::atof(fields["median"].c_str());
+  result.max = std::atof(fields["max"].c_str());
+  result.stddev = std::atof(fields["stddev"].c_str());
+  return true;
+}
+
+bool loadPerfResults(const std::string& file_name, std::map<std::string, PerfResult>& results) {
+  std::ifstream file(file_name);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    PerfResult result;
+    if (parsePerfResult(line, result)) {
+      results[result.key()] = result;
+    }
+  }
+  return true;
+}
+
+bool loadPerfResultList(const std::string& file_name, std::vector<PerfResult>& results) {
+  std::ifstream file(file_name);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    PerfResult result;
+    if (parsePerfResult(line, result)) {
+      results.push_back(result);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+One record of the perftest json output (--format json), reduced to the
+fields needed for comparing runs. Records are matched by key().
+*/
+class PerfResult {
+ public:
+  std::string benchmark;
+  std::string desc;
+  std::string device_name;
+  std::string arch;
+  std::string host;
+  std::string gpu_uuid;
+  std::string unit;
+  std::string better;  // "higher" or "lower" when the benchmark said so, else empty
+  int device = 0;
+  unsigned long long size = 0;
+  unsigned long long samples = 0;
+  double min = 0;
+  double median = 0;
+  double max = 0;
+  double stddev = 0;
+
+  // Identifies the same measurement across runs: device, benchmark, desc, size and unit.
+  std::string key() const;
+  // The record's "better" field when present, otherwise the unit's direction: rates,
+  // throughputs, ratios against a baseline ("x ...") and shares ("% ...") are better
+  // when higher, times, sizes and anything else when lower.
+  bool higherIsBetter() const;
+};
+
+/*
+Parses one flat json object as written by the perftests. Returns false for
+lines that are not such an object, e.g. the PASSED! line in stdout captures.
+*/
+bool parsePerfResult(const std::string& line, PerfResult& result);
+
+// Loads every record of a json-lines file, keyed by PerfResult::key().
+// Later duplicates replace earlier ones. Returns false if the file can't be read.
+bool loadPerfResults(const std::string& file_name, std::map<std::string, PerfResult>& results);
+
+// Loads every record of a json-lines file in file order, duplicates included.
+bool loadPerfResultList(const std::string& file_name, std::vector<PerfResult>& results);
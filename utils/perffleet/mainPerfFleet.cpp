@@ -0,0 +1,201 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "perfResult.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <set>
+
+/*
+Aggregates perftest runs of a GPU fleet (--format json output, typically one
+file per node written with --output results/%h.jsonl). Measurements are
+grouped per SKU by PerfResult::key(), so every group holds the same
+benchmark, desc, size and unit on the same device name, with one value per
+GPU (the median of its last record, GPUs told apart by gpu_uuid or else by
+host and device). For every group the distribution over the GPUs is printed
+and a GPU is flagged as an outlier when it is worse than the group median by
+more than --threshold percent and by more than --mad times the scaled median
+absolute deviation, so a single slow GPU stands out without tight groups
+flagging noise.
+Exit code: 0 no outliers, 1 outliers found, 2 usage or input error.
+*/
+
+struct FleetValue {
+  std::string gpu;
+  std::string host;
+  double median = 0;
+};
+
+static void printUsage() {
+  std::cout << "Usage: perfFleet [--threshold <percent>] [--mad <k>] [--min-gpus <n>]"
+               " [--outliers-only] <results.jsonl>..." << std::endl;
+  std::cout << "\tExample: ./perfFleet --threshold 10 results/*.jsonl" << std::endl;
+}
+
+static std::string gpuName(const PerfResult& result) {
+  if (!result.gpu_uuid.empty()) {
+    return result.gpu_uuid;
+  }
+  return (result.host.empty() ? "unknown" : result.host) + ":" + std::to_string(result.device);
+}
+
+// Linear interpolation between the closest ranks of sorted values
+static double percentile(const std::vector<double>& sorted, double p) {
+  double rank = p / 100.0 * (sorted.size() - 1);
+  size_t low = static_cast<size_t>(rank);
+  size_t high = std::min(low + 1, sorted.size() - 1);
+  return sorted[low] + (sorted[high] - sorted[low]) * (rank - low);
+}
+
+int main(int argc, char** argv)
+{
+  double threshold = 10.0;
+  double mad_factor = 3.5;
+  size_t min_gpus = 3;
+  bool outliers_only = false;
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+      threshold = std::atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--mad") && i + 1 < argc) {
+      mad_factor = std::atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--min-gpus") && i + 1 < argc) {
+      min_gpus = std::strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--outliers-only")) {
+      outliers_only = true;
+    } else if (argv[i][0] == '-') {
+      printUsage();
+      return 2;
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    printUsage();
+    return 2;
+  }
+
+  // Per SKU measurement, one value per GPU
+  std::map<std::string, PerfResult> groups;
+  std::map<std::string, std::map<std::string, FleetValue>> values;
+  std::set<std::string> hosts;
+  for (const auto& file : files) {
+    std::vector<PerfResult> results;
+    if (!loadPerfResultList(file, results)) {
+      std::cout << "Unable to read results file " << file << std::endl;
+      return 2;
+    }
+    for (const auto& result : results) {
+      std::string key = result.key();
+      groups.emplace(key, result);
+      FleetValue& value = values[key][gpuName(result)];
+      value.gpu = gpuName(result);
+      value.host = result.host;
+      value.median = result.median;
+      hosts.insert(result.host);
+    }
+  }
+
+  std::set<std::string> gpus, flagged_gpus;
+  std::map<std::string, int> flags_per_gpu;
+  int checked = 0, skipped = 0, outliers = 0;
+  for (const auto& entry : values) {
+    const PerfResult& group = groups[entry.first];
+    std::vector<double> sorted;
+    for (const auto& gpu : entry.second) {
+      sorted.push_back(gpu.second.median);
+      gpus.insert(gpu.first);
+    }
+    if (sorted.size() < min_gpus) {
+      skipped++;
+      continue;
+    }
+    checked++;
+    std::sort(sorted.begin(), sorted.end());
+    double median = percentile(sorted, 50);
+    std::vector<double> deviations;
+    for (double v : sorted) {
+      deviations.push_back(std::fabs(v - median));
+    }
+    std::sort(deviations.begin(), deviations.end());
+    // Scaled to estimate the standard deviation of normally distributed values
+    double mad = 1.4826 * percentile(deviations, 50);
+
+    if (!outliers_only) {
+      std::cout << std::left << std::setw(10) << "SKU" << group.device_name << " "
+                << group.benchmark << " " << group.desc << " size " << group.size << ": "
+                << sorted.size() << " GPUs, min " << sorted.front() << " p10 "
+                << percentile(sorted, 10) << " median " << median << " p90 "
+                << percentile(sorted, 90) << " max " << sorted.back() << " mad " << mad << " "
+                << group.unit << std::endl;
+    }
+
+    for (const auto& gpu : entry.second) {
+      const FleetValue& value = gpu.second;
+      double change = median != 0 ? (value.median - median) / median * 100.0 : 0.0;
+      // Positive means worse, whichever direction is better for the unit
+      double worse = group.higherIsBetter() ? -change : change;
+      if (worse <= threshold || std::fabs(value.median - median) <= mad_factor * mad) {
+        continue;
+      }
+      std::cout << std::left << std::setw(10) << "OUTLIER" << value.host << " " << value.gpu
+                << " " << group.benchmark << " " << group.desc << " size " << group.size << ": "
+                << value.median << " vs fleet median " << median << " " << group.unit << " ("
+                << std::showpos << std::fixed << std::setprecision(1) << change << "%)"
+                << std::noshowpos << std::defaultfloat << std::setprecision(6) << std::endl;
+      outliers++;
+      flagged_gpus.insert(value.gpu);
+      flags_per_gpu[value.host + " " + value.gpu]++;
+    }
+  }
+
+  // GPUs failing many measurements are the likely bad ones, list them first
+  std::vector<std::pair<int, std::string>> ranked;
+  for (const auto& entry : flags_per_gpu) {
+    ranked.emplace_back(entry.second, entry.first);
+  }
+  std::sort(ranked.begin(), ranked.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+  for (const auto& entry : ranked) {
+    std::cout << std::left << std::setw(10) << "GPU" << entry.second << ": " << entry.first
+              << " of " << checked << " measurements flagged" << std::endl;
+  }
+
+  std::cout << "Checked " << checked << " measurements of " << gpus.size() << " GPUs on "
+            << hosts.size() << " hosts: " << outliers << " outliers on " << flagged_gpus.size()
+            << " GPUs, " << skipped << " measurements with fewer than " << min_gpus
+            << " GPUs skipped (threshold " << threshold << "%, mad " << mad_factor << ")"
+            << std::endl;
+
+  if (outliers > 0) {
+    std::cout << "FAILED" << std::endl;
+    return 1;
+  }
+  std::cout << "PASSED" << std::endl;
+  return 0;
+}
@@ -0,0 +1,445 @@
+/*
+Copyright (c) 2023 Advanced Micro Devices, Inc. All rights reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#include "perfResult.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/*
+Builds a roofline model per device from perftest runs (--format json output).
+Memory roofs are the best measured bandwidth of the device memory and LDS
+read benchmarks, compute roofs the best FMA throughput per precision of
+hipPerfMandelbrotPeak. Every measurement reported both in GB/s and GFLOP/s
+(same benchmark, desc and size) becomes a kernel on the model, placed at its
+arithmetic intensity GFLOP/s / GB/s. For each device <name>.json and
+<name>.html are written to the output directory.
+Exit code: 0 written, 2 usage or input error.
+*/
+
+struct RoofSource {
+  std::string roof;
+  std::string benchmark;
+  std::string descPrefix;  // empty matches every desc
+};
+
+// Built in roofs, extended with --roof
+static std::vector<RoofSource> roofSources = {
+    {"HBM", "hipPerfDevMemReadSpeed", ""},
+    {"HBM", "hipPerfDevMemWriteSpeed", ""},
+    {"LDS", "hipPerfSharedMemReadSpeed", "sharedMemReadSpeed"},
+    {"FP32", "hipPerfMandelbrotPeak", "fma_only float"},
+    {"FP64", "hipPerfMandelbrotPeak", "fma_only double"},
+    {"FP16 packed", "hipPerfMandelbrotPeak", "fma_only half2"},
+};
+
+// Stands in for the FP32 roof of devices without hipPerfMandelbrotPeak results
+static const RoofSource fp32Fallback = {"FP32", "hipPerfMandelbrot", ""};
+
+struct Roof {
+  std::string name;
+  double value;  // GB/s for memory roofs, GFLOP/s for compute roofs
+  std::string source;
+};
+
+struct Kernel {
+  std::string name;
+  unsigned long long size;
+  double gbps;
+  double gflops;
+  double intensity;   // FLOP per byte
+  double attainable;  // GFLOP/s allowed by the first memory and compute roof
+  bool memoryBound;
+};
+
+struct DeviceModel {
+  std::string deviceName;
+  std::string arch;
+  std::vector<Roof> memory;
+  std::vector<Roof> compute;
+  std::vector<Kernel> kernels;
+};
+
+static bool isBandwidth(const std::string& unit) { return unit == "GB/s"; }
+
+static bool isFlops(const std::string& unit) { return unit == "GFLOP/s" || unit == "GFLOPS"; }
+
+static void printUsage() {
+  std::cout << "Usage: roofline [--output <dir>] [--roof <name>:<benchmark>[:<desc prefix>]]"
+               " <results.jsonl>..." << std::endl;
+  std::cout << "\tExample: ./roofline --output roofline memory.jsonl compute.jsonl" << std::endl;
+}
+
+// Keeps the best result per roof name, memory or compute by the result's unit
+static void addRoof(std::vector<Roof>& roofs, const std::string& name, const PerfResult& result) {
+  for (auto& roof : roofs) {
+    if (roof.name == name) {
+      if (result.median > roof.value) {
+        roof.value = result.median;
+        roof.source = result.benchmark + " " + result.desc;
+      }
+      return;
+    }
+  }
+  roofs.push_back({name, result.median, result.benchmark + " " + result.desc});
+}
+
+static std::map<std::string, DeviceModel> buildModels(
+    const std::map<std::string, PerfResult>& results) {
+  std::map<std::string, DeviceModel> models;
+  // Bandwidth and FLOP rate of the same measurement, keyed without the unit
+  std::map<std::string, std::pair<const PerfResult*, const PerfResult*>> pairs;
+
+  for (const auto& entry : results) {
+    const PerfResult& result = entry.second;
+    DeviceModel& model = models[result.device_name];
+    model.deviceName = result.device_name;
+    model.arch = result.arch;
+
+    for (const auto& source : roofSources) {
+      if (result.benchmark != source.benchmark ||
+          result.desc.compare(0, source.descPrefix.size(), source.descPrefix) != 0) {
+        continue;
+      }
+      if (isBandwidth(result.unit)) {
+        addRoof(model.memory, source.roof, result);
+      } else if (isFlops(result.unit)) {
+        addRoof(model.compute, source.roof, result);
+      }
+    }
+
+    std::string key = result.device_name + "|" + result.benchmark + "|" + result.desc + "|" +
+                      std::to_string(result.size);
+    if (isBandwidth(result.unit)) {
+      pairs[key].first = &result;
+    } else if (isFlops(result.unit)) {
+      pairs[key].second = &result;
+    }
+  }
+
+  for (auto& entry : models) {
+    std::vector<Roof>& compute = entry.second.compute;
+    if (std::any_of(compute.begin(), compute.end(),
+                    [](const Roof& roof) { return roof.name == fp32Fallback.roof; })) {
+      continue;
+    }
+    std::vector<Roof> fallback;
+    for (const auto& result : results) {
+      if (result.second.device_name == entry.first &&
+          result.second.benchmark == fp32Fallback.benchmark && isFlops(result.second.unit)) {
+        addRoof(fallback, fp32Fallback.roof, result.second);
+      }
+    }
+    compute.insert(compute.end(), fallback.begin(), fallback.end());
+  }
+
+  for (const auto& entry : pairs) {
+    const PerfResult* bandwidth = entry.second.first;
+    const PerfResult* flops = entry.second.second;
+    if (bandwidth == nullptr || flops == nullptr || bandwidth->median <= 0 ||
+        flops->median <= 0) {
+      continue;
+    }
+    DeviceModel& model = models[bandwidth->device_name];
+    Kernel kernel;
+    kernel.name = bandwidth->benchmark + " " + bandwidth->desc;
+    kernel.size = bandwidth->size;
+    kernel.gbps = bandwidth->median;
+    kernel.gflops = flops->median;
+    kernel.intensity = kernel.gflops / kernel.gbps;
+    kernel.attainable = 0;
+    kernel.memoryBound = false;
+    if (!model.memory.empty() && !model.compute.empty()) {
+      double memoryRoof = kernel.intensity * model.memory.front().value;
+      kernel.attainable = std::min(memoryRoof, model.compute.front().value);
+      kernel.memoryBound = memoryRoof < model.compute.front().value;
+    }
+    model.kernels.push_back(kernel);
+  }
+
+  // Sources are listed HBM and FP32 first, so front() is the primary roof
+  for (auto& entry : models) {
+    auto order = [](std::vector<Roof>& roofs) {
+      std::vector<Roof> sorted;
+      for (const auto& source : roofSources) {
+        for (const auto& roof : roofs) {
+          if (roof.name == source.roof &&
+              std::none_of(sorted.begin(), sorted.end(),
+                           [&](const Roof& r) { return r.name == roof.name; })) {
+            sorted.push_back(roof);
+          }
+        }
+      }
+      roofs = sorted;
+    };
+    order(entry.second.memory);
+    order(entry.second.compute);
+  }
+  return models;
+}
+
+static std::string escape(const std::string& str, bool html) {
+  std::string out;
+  for (char c : str) {
+    if (html && c == '<') {
+      out += "&lt;";
+    } else if (html && c == '>') {
+      out += "&gt;";
+    } else if (html && c == '&') {
+      out += "&amp;";
+    } else if (!html && (c == '"' || c == '\\')) {
+      out += '\\';
+      out += c;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+static std::string fileName(const DeviceModel& model) {
+  std::string name = model.deviceName.empty() ? model.arch : model.deviceName;
+  std::string out;
+  for (char c : name) {
+    out += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+  }
+  return out.empty() ? "device" : out;
+}
+
+static void writeRoofs(std::ostream& os, const char* name, const std::vector<Roof>& roofs,
+                       const char* unit) {
+  os << "  \"" << name << "\": [";
+  for (size_t i = 0; i < roofs.size(); i++) {
+    os << (i ? "," : "") << "\n    {\"name\": \"" << escape(roofs[i].name, false) << "\", \""
+       << unit << "\": " << roofs[i].value << ", \"source\": \""
+       << escape(roofs[i].source, false) << "\"}";
+  }
+  os << "\n  ],\n";
+}
+
+static void writeJson(std::ostream& os, const DeviceModel& model) {
+  os << "{\n  \"device_name\": \"" << escape(model.deviceName, false) << "\",\n  \"arch\": \""
+     << escape(model.arch, false) << "\",\n";
+  writeRoofs(os, "memory_roofs", model.memory, "gbps");
+  writeRoofs(os, "compute_roofs", model.compute, "gflops");
+  if (!model.memory.empty() && !model.compute.empty()) {
+    os << "  \"ridge_point\": " << model.compute.front().value / model.memory.front().value
+       << ",\n";
+  }
+  os << "  \"kernels\": [";
+  for (size_t i = 0; i < model.kernels.size(); i++) {
+    const Kernel& k = model.kernels[i];
+    os << (i ? "," : "") << "\n    {\"name\": \"" << escape(k.name, false)
+       << "\", \"size\": " << k.size << ", \"intensity\": " << k.intensity
+       << ", \"gbps\": " << k.gbps << ", \"gflops\": " << k.gflops;
+    if (k.attainable > 0) {
+      os << ", \"attainable_gflops\": " << k.attainable << ", \"bound\": \""
+         << (k.memoryBound ? "memory" : "compute") << "\", \"fraction_of_roof\": "
+         << k.gflops / k.attainable;
+    }
+    os << "}";
+  }
+  os << "\n  ]\n}\n";
+}
+
+// Log-log chart as inline SVG, intensity over x in powers of 2 and GFLOP/s over y in powers of 10
+static void writeSvg(std::ostream& os, const DeviceModel& model) {
+  const double left = 70, top = 20, width = 720, height = 420;
+  double xMin = 1.0 / 16, xMax = 256, yMin = 1, yMax = 10;
+  for (const auto& roof : model.compute) {
+    yMax = std::max(yMax, roof.value * 2);
+    for (const auto& memory : model.memory) {
+      xMax = std::max(xMax, roof.value / memory.value * 8);
+    }
+  }
+  for (const auto& k : model.kernels) {
+    xMin = std::min(xMin, k.intensity / 2);
+    xMax = std::max(xMax, k.intensity * 2);
+    yMin = std::min(yMin, k.gflops / 2);
+    yMax = std::max(yMax, k.gflops * 2);
+  }
+  xMin = std::pow(2, std::floor(std::log2(xMin)));
+  xMax = std::pow(2, std::ceil(std::log2(xMax)));
+  yMin = std::pow(10, std::floor(std::log10(yMin)));
+  yMax = std::pow(10, std::ceil(std::log10(yMax)));
+  auto px = [&](double x) {
+    return left + (std::log2(x) - std::log2(xMin)) / (std::log2(xMax) - std::log2(xMin)) * width;
+  };
+  auto py = [&](double y) {
+    return top + height -
+           (std::log10(y) - std::log10(yMin)) / (std::log10(yMax) - std::log10(yMin)) * height;
+  };
+  static const char* colors[] = {"#1f77b4", "#2ca02c", "#9467bd", "#8c564b", "#e377c2"};
+
+  os << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << left + width + 160
+     << "\" height=\"" << top + height + 50 << "\" font-family=\"sans-serif\" font-size=\"11\">\n";
+  for (double x = xMin; x <= xMax * 1.001; x *= 2) {
+    os << "<line x1=\"" << px(x) << "\" y1=\"" << top << "\" x2=\"" << px(x) << "\" y2=\""
+       << top + height << "\" stroke=\"#eee\"/><text x=\"" << px(x) << "\" y=\""
+       << top + height + 15 << "\" text-anchor=\"middle\">" << x << "</text>\n";
+  }
+  for (double y = yMin; y <= yMax * 1.001; y *= 10) {
+    os << "<line x1=\"" << left << "\" y1=\"" << py(y) << "\" x2=\"" << left + width
+       << "\" y2=\"" << py(y) << "\" stroke=\"#eee\"/><text x=\"" << left - 5 << "\" y=\""
+       << py(y) + 4 << "\" text-anchor=\"end\">" << y << "</text>\n";
+  }
+  os << "<text x=\"" << left + width / 2 << "\" y=\"" << top + height + 35
+     << "\" text-anchor=\"middle\">arithmetic intensity (FLOP/byte)</text>\n"
+     << "<text x=\"15\" y=\"" << top + height / 2 << "\" transform=\"rotate(-90 15 "
+     << top + height / 2 << ")\" text-anchor=\"middle\">GFLOP/s</text>\n";
+
+  double topCompute = 0;
+  for (const auto& roof : model.compute) {
+    topCompute = std::max(topCompute, roof.value);
+  }
+  double topMemory = model.memory.empty() ? 0 : model.memory.front().value;
+  for (size_t i = 0; i < model.memory.size(); i++) {
+    const Roof& roof = model.memory[i];
+    // Slanted up to the highest compute roof, or to the top of the chart without one
+    double xEnd = topCompute > 0 ? std::min(xMax, topCompute / roof.value) : xMax;
+    double xStart = std::max(xMin, yMin / roof.value);
+    os << "<line x1=\"" << px(xStart) << "\" y1=\"" << py(roof.value * xStart) << "\" x2=\""
+       << px(xEnd) << "\" y2=\"" << py(roof.value * xEnd) << "\" stroke=\""
+       << colors[i % 5] << "\" stroke-width=\"2\"/><text x=\"" << px(xStart) + 5 << "\" y=\""
+       << py(roof.value * xStart) - 5 << "\" fill=\"" << colors[i % 5] << "\">"
+       << escape(roof.name, true) << " " << roof.value << " GB/s</text>\n";
+  }
+  for (const auto& roof : model.compute) {
+    double xStart = topMemory > 0 ? std::max(xMin, roof.value / topMemory) : xMin;
+    os << "<line x1=\"" << px(xStart) << "\" y1=\"" << py(roof.value) << "\" x2=\"" << px(xMax)
+       << "\" y2=\"" << py(roof.value) << "\" stroke=\"#d62728\" stroke-width=\"2\"/><text x=\""
+       << px(xMax) + 5 << "\" y=\"" << py(roof.value) + 4 << "\" fill=\"#d62728\">"
+       << escape(roof.name, true) << " " << roof.value << " GFLOP/s</text>\n";
+  }
+  for (const auto& k : model.kernels) {
+    os << "<circle cx=\"" << px(k.intensity) << "\" cy=\"" << py(k.gflops)
+       << "\" r=\"4\" fill=\"#ff7f0e\"><title>" << escape(k.name, true) << " size " << k.size
+       << ": " << k.intensity << " FLOP/byte, " << k.gflops << " GFLOP/s</title></circle>\n";
+  }
+  os << "</svg>\n";
+}
+
+static void writeHtml(std::ostream& os, const DeviceModel& model) {
+  std::string title = escape(model.deviceName + " (" + model.arch + ")", true);
+  os << "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>Roofline " << title
+     << "</title>\n<style>body{font-family:sans-serif}table{border-collapse:collapse}"
+        "td,th{border:1px solid #ccc;padding:2px 6px;text-align:right}"
+        "td:first-child{text-align:left}</style></head><body>\n<h2>Roofline " << title
+     << "</h2>\n";
+  writeSvg(os, model);
+
+  os << "<h3>Roofs</h3>\n<table><tr><th>roof</th><th>measured</th><th>source</th></tr>\n";
+  for (const auto& roof : model.memory) {
+    os << "<tr><td>" << escape(roof.name, true) << "</td><td>" << roof.value << " GB/s</td><td>"
+       << escape(roof.source, true) << "</td></tr>\n";
+  }
+  for (const auto& roof : model.compute) {
+    os << "<tr><td>" << escape(roof.name, true) << "</td><td>" << roof.value
+       << " GFLOP/s</td><td>" << escape(roof.source, true) << "</td></tr>\n";
+  }
+  os << "</table>\n<h3>Kernels</h3>\n<table><tr><th>kernel</th><th>size</th>"
+        "<th>FLOP/byte</th><th>GB/s</th><th>GFLOP/s</th><th>bound</th><th>of roof</th></tr>\n";
+  for (const auto& k : model.kernels) {
+    os << "<tr><td>" << escape(k.name, true) << "</td><td>" << k.size << "</td><td>"
+       << k.intensity << "</td><td>" << k.gbps << "</td><td>" << k.gflops << "</td><td>";
+    if (k.attainable > 0) {
+      os << (k.memoryBound ? "memory" : "compute") << "</td><td>"
+         << static_cast<int>(100 * k.gflops / k.attainable + 0.5) << "%";
+    } else {
+      os << "</td><td>";
+    }
+    os << "</td></tr>\n";
+  }
+  os << "</table>\n</body></html>\n";
+}
+
+int main(int argc, char** argv)
+{
+  std::string output_dir = ".";
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+      output_dir = argv[++i];
+    } else if (!strcmp(argv[i], "--roof") && i + 1 < argc) {
+      std::string spec = argv[++i];
+      size_t first = spec.find(':');
+      if (first == std::string::npos || first == 0) {
+        printUsage();
+        return 2;
+      }
+      size_t second = spec.find(':', first + 1);
+      RoofSource source;
+      source.roof = spec.substr(0, first);
+      source.benchmark = spec.substr(first + 1, second == std::string::npos ? std::string::npos
+                                                                             : second - first - 1);
+      if (second != std::string::npos) {
+        source.descPrefix = spec.substr(second + 1);
+      }
+      roofSources.push_back(source);
+    } else if (argv[i][0] == '-') {
+      printUsage();
+      return 2;
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    printUsage();
+    return 2;
+  }
+
+  std::map<std::string, PerfResult> results;
+  for (const auto& file : files) {
+    if (!loadPerfResults(file, results)) {
+      std::cout << "Unable to read results file " << file << std::endl;
+      return 2;
+    }
+  }
+
+  auto models = buildModels(results);
+  for (const auto& entry : models) {
+    const DeviceModel& model = entry.second;
+    std::string base = output_dir + "/" + fileName(model);
+    std::ofstream json(base + ".json");
+    std::ofstream html(base + ".html");
+    if (!json.is_open() || !html.is_open()) {
+      std::cout << "Unable to write " << base << ".json/.html" << std::endl;
+      return 2;
+    }
+    writeJson(json, model);
+    writeHtml(html, model);
+    std::cout << model.deviceName << ": " << model.memory.size() << " memory roofs, "
+              << model.compute.size() << " compute roofs, " << model.kernels.size()
+              << " kernels -> " << base << ".html" << std::endl;
+    if (model.memory.empty() || model.compute.empty()) {
+      std::cout << "\tno " << (model.memory.empty() ? "memory" : "compute")
+                << " roof measured, run hipPerfDevMemReadSpeed and hipPerfMandelbrot" << std::endl;
+    }
+  }
+  return 0;
+}